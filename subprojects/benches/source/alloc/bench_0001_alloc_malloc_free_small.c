@@ -0,0 +1,24 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <switch.h>
+
+#include "../bench.h"
+
+#define ALLOC_SIZE 64
+
+/**
+* Thread function for Bench #0001
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        void *volatile ptr = malloc(ALLOC_SIZE);
+        free(ptr);
+    })
+}
+
+const BenchCase bench_0001_alloc_malloc_free_small = {
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = false,
+};
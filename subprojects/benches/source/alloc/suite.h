@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../bench.h"
+
+/**
+* Every thread allocates and frees a 64-byte block.
+*/
+extern const BenchCase bench_0001_alloc_malloc_free_small;
+
+/**
+* Every thread allocates and frees a 4 KiB block.
+*/
+extern const BenchCase bench_0002_alloc_malloc_free_page;
+
+/**
+ * Benchmark suite for the allocator.
+ */
+static void alloc_suite(void) {
+    BENCH_SUITE("alloc");
+
+    BENCH_CASE(
+        "Bench 0001: alloc_malloc_free_small",
+        bench_0001_alloc_malloc_free_small
+    )
+    BENCH_CASE(
+        "Bench 0002: alloc_malloc_free_page",
+        bench_0002_alloc_malloc_free_page
+    )
+}
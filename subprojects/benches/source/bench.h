@@ -0,0 +1,250 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+
+#include <switch.h>
+
+/**
+ * @brief Maximum number of benchmark threads, one per CPU core.
+ */
+#define BENCH_MAX_THREADS 4
+
+/**
+ * @brief Number of samples recorded by each benchmark thread.
+ */
+#define BENCH_SAMPLES 256
+
+/**
+ * @brief Number of operations timed by each sample.
+ *
+ * The system tick runs at 19.2 MHz (~52 ns), too coarse to time a single uncontended
+ * operation: a sample times a batch, and reports the mean time of its operations.
+ */
+#define BENCH_BATCH 64
+
+/**
+ * @brief Busy-loop iterations spent inside each critical section, per contention level.
+ */
+#define BENCH_HOLD_NONE 0
+#define BENCH_HOLD_LONG 256
+
+/**
+ * @brief Stack size of the benchmark threads.
+ */
+#define BENCH_STACK_SIZE 0x10000
+
+/**
+ * @brief Priority of the benchmark threads.
+ */
+#define BENCH_PRIORITY 0x2C
+
+/**
+ * @brief State of a benchmark run: one case, at one thread count and contention level.
+ */
+typedef struct {
+    uint32_t threads; ///< Number of benchmark threads, each pinned to its own core.
+    uint32_t hold; ///< Busy-loop iterations inside each critical section.
+    atomic_uint ready; ///< Number of threads waiting for the start signal.
+    atomic_bool go; ///< Start signal, so that all threads contend from the first sample.
+    uint32_t counts[BENCH_MAX_THREADS]; ///< Number of samples recorded by each thread.
+    uint64_t samples[BENCH_MAX_THREADS][BENCH_SAMPLES]; ///< Ticks per batch, per thread.
+} BenchRun;
+
+/**
+ * Benchmark thread function
+ *
+ * @param run The benchmark run.
+ * @param idx The index of the thread, in `0..run->threads`.
+ */
+typedef void (*BenchThreadFn)(BenchRun *run, uint32_t idx);
+
+/**
+ * Benchmark suite function
+ */
+typedef void (*BenchSuiteFn)(void);
+
+/**
+ * @brief A benchmark case.
+ */
+typedef struct {
+    void (*setup)(BenchRun *run); ///< Initializes the shared state, before the threads start. Optional.
+    BenchThreadFn thread; ///< Runs on each benchmark thread.
+    void (*teardown)(BenchRun *run); ///< Releases the shared state, after the threads exit. Optional.
+    uint32_t min_threads; ///< Minimum number of threads the case needs.
+    bool contended; ///< Whether the case runs at every contention level, or only without hold.
+} BenchCase;
+
+/**
+ * @brief Spins for `n` iterations, simulating work inside a critical section.
+ */
+static inline void bench_spin(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        __asm__ __volatile__("nop" ::: "memory");
+    }
+}
+
+/**
+ * Times `op`, `BENCH_BATCH` times per sample, recording `BENCH_SAMPLES` samples for the
+ * thread `idx`.
+ *
+ * @param run The benchmark run.
+ * @param idx The index of the recording thread.
+ * @param op The operation to time.
+ */
+#define BENCH_LOOP(run, idx, op) \
+    { \
+        for (uint32_t _s = 0; _s < BENCH_SAMPLES; _s++) { \
+            const uint64_t _t0 = armGetSystemTick(); \
+            for (uint32_t _b = 0; _b < BENCH_BATCH; _b++) { \
+                op; \
+            } \
+            (run)->samples[(idx)][_s] = armGetSystemTick() - _t0; \
+        } \
+        (run)->counts[(idx)] = BENCH_SAMPLES; \
+    }
+
+/**
+ * @brief Arguments for a benchmark thread.
+ */
+typedef struct {
+    BenchRun *run;
+    uint32_t idx;
+    BenchThreadFn func;
+} BenchThreadArgs;
+
+/**
+ * @brief The entry point for a benchmark thread.
+ * @param arg A pointer to the BenchThreadArgs struct.
+ */
+static inline void bench_thread_func(void *arg) {
+    BenchThreadArgs *args = (BenchThreadArgs *)arg;
+
+    atomic_fetch_add(&args->run->ready, 1);
+    while (!atomic_load_explicit(&args->run->go, memory_order_acquire)) {
+        __asm__ __volatile__("yield");
+    }
+
+    args->func(args->run, args->idx);
+}
+
+static inline int bench_cmp_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Prints the percentiles of the samples of `run`, in nanoseconds per operation.
+ */
+static inline void bench_report(BenchRun *run) {
+    static uint64_t sorted[BENCH_MAX_THREADS * BENCH_SAMPLES];
+
+    size_t n = 0;
+    for (uint32_t t = 0; t < run->threads; t++) {
+        for (uint32_t s = 0; s < run->counts[t]; s++) {
+            sorted[n++] = run->samples[t][s];
+        }
+    }
+    if (n == 0) {
+        printf(CONSOLE_RED "no samples" CONSOLE_RESET "\n");
+        return;
+    }
+    qsort(sorted, n, sizeof(uint64_t), bench_cmp_u64);
+
+    #define BENCH_PCT_NS(pct) (armTicksToNs(sorted[((n - 1) * (pct)) / 100]) / BENCH_BATCH)
+    printf("p50 %6" PRIu64 " p90 %6" PRIu64 " p99 %6" PRIu64 " max %7" PRIu64 " ns\n",
+        BENCH_PCT_NS(50), BENCH_PCT_NS(90), BENCH_PCT_NS(99), BENCH_PCT_NS(100));
+    #undef BENCH_PCT_NS
+}
+
+/**
+ * @brief Runs `bench` on `threads` threads, pinned to the cores `0..threads`, and prints
+ * the percentiles of its samples.
+ *
+ * Threads the kernel refuses to create (applications cannot use core 3) skip the run.
+ */
+static inline void bench_run(const BenchCase *bench, uint32_t threads, uint32_t hold) {
+    static BenchRun run;
+    Thread thread[BENCH_MAX_THREADS];
+    BenchThreadArgs args[BENCH_MAX_THREADS];
+
+    printf("  %uc hold %-4u ", threads, hold);
+    fflush(stdout);
+
+    run = (BenchRun){ .threads = threads, .hold = hold };
+    if (bench->setup) {
+        bench->setup(&run);
+    }
+
+    uint32_t created = 0;
+    Result rc = 0;
+    for (; created < threads; created++) {
+        args[created] = (BenchThreadArgs){ .run = &run, .idx = created, .func = bench->thread };
+        rc = threadCreate(&thread[created], bench_thread_func, &args[created], NULL,
+                          BENCH_STACK_SIZE, BENCH_PRIORITY, (int)created);
+        if (R_FAILED(rc)) {
+            break;
+        }
+    }
+
+    if (created == threads) {
+        for (uint32_t t = 0; t < threads; t++) {
+            threadStart(&thread[t]);
+        }
+        while (atomic_load(&run.ready) < threads) {
+            svcSleepThread(1000000);
+        }
+        atomic_store_explicit(&run.go, true, memory_order_release);
+    }
+
+    for (uint32_t t = 0; t < created; t++) {
+        if (created == threads) {
+            threadWaitForExit(&thread[t]);
+        }
+        threadClose(&thread[t]);
+    }
+
+    if (bench->teardown) {
+        bench->teardown(&run);
+    }
+
+    if (created == threads) {
+        bench_report(&run);
+    } else {
+        printf(CONSOLE_YELLOW "SKIPPED" CONSOLE_RESET " (core %u: 0x%X)\n", created, rc);
+    }
+}
+
+/**
+ * Benchmark suite declaration.
+ *
+ * @param suite_name The name of the benchmark suite.
+ */
+#define BENCH_SUITE(suite_name) \
+    printf("\n" CONSOLE_CYAN "BENCH SUITE:" CONSOLE_RESET " " suite_name "\n\n");
+
+/**
+ * Benchmark case declaration.
+ *
+ * Runs the case on 1 to `BENCH_MAX_THREADS` threads, and for contended cases, at every
+ * contention level.
+ *
+ * @param bench_title The title of the benchmark case.
+ * @param bench_case The `BenchCase` to run.
+ */
+#define BENCH_CASE(bench_title, bench_case) \
+    { \
+        printf(bench_title "\n"); \
+        for (uint32_t _t = (bench_case).min_threads; _t <= BENCH_MAX_THREADS; _t++) { \
+            bench_run(&(bench_case), _t, BENCH_HOLD_NONE); \
+            if ((bench_case).contended) { \
+                bench_run(&(bench_case), _t, BENCH_HOLD_LONG); \
+            } \
+            consoleUpdate(NULL); \
+        } \
+    }
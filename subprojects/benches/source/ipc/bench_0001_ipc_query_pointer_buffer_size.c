@@ -0,0 +1,45 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../bench.h"
+
+static bool g_initialized;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    g_initialized = R_SUCCEEDED(setInitialize());
+}
+
+static void teardown(BenchRun *run) {
+    (void)run;
+    if (g_initialized) {
+        setExit();
+    }
+}
+
+/**
+* Thread function for Bench #0001
+*
+* QueryPointerBufferSize is a control request the server framework answers itself: the
+* sample times the dispatch round trip, with no service work behind it.
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    if (!g_initialized) {
+        return;
+    }
+
+    const Handle session = setGetServiceSession()->session;
+    BENCH_LOOP(run, idx, {
+        u16 size;
+        cmifQueryPointerBufferSize(session, &size);
+    })
+}
+
+const BenchCase bench_0001_ipc_query_pointer_buffer_size = {
+    .setup = setup,
+    .thread = thread_func,
+    .teardown = teardown,
+    .min_threads = 1,
+    .contended = false,
+};
@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../bench.h"
+
+static bool g_initialized;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    g_initialized = R_SUCCEEDED(setInitialize());
+}
+
+static void teardown(BenchRun *run) {
+    (void)run;
+    if (g_initialized) {
+        setExit();
+    }
+}
+
+/**
+* Thread function for Bench #0002
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    if (!g_initialized) {
+        return;
+    }
+
+    BENCH_LOOP(run, idx, {
+        SetRegion region;
+        setGetRegionCode(&region);
+    })
+}
+
+const BenchCase bench_0002_ipc_set_get_region_code = {
+    .setup = setup,
+    .thread = thread_func,
+    .teardown = teardown,
+    .min_threads = 1,
+    .contended = false,
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../bench.h"
+
+/**
+* Every thread sends a QueryPointerBufferSize control request on the shared `set` session.
+*/
+extern const BenchCase bench_0001_ipc_query_pointer_buffer_size;
+
+/**
+* Every thread sends a GetRegionCode request on the shared `set` session.
+*/
+extern const BenchCase bench_0002_ipc_set_get_region_code;
+
+/**
+ * Benchmark suite for IPC dispatch.
+ */
+static void ipc_suite(void) {
+    BENCH_SUITE("ipc");
+
+    BENCH_CASE(
+        "Bench 0001: ipc_query_pointer_buffer_size",
+        bench_0001_ipc_query_pointer_buffer_size
+    )
+    BENCH_CASE(
+        "Bench 0002: ipc_set_get_region_code",
+        bench_0002_ipc_set_get_region_code
+    )
+}
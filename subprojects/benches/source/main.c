@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include <switch.h>
+
+#include "bench.h"
+#include "sync/suite.h"
+#include "alloc/suite.h"
+#include "ipc/suite.h"
+
+/**
+ * Benchmark suites
+ */
+static BenchSuiteFn bench_suites[] = {
+    // sync
+    sync_mutex_suite,
+    sync_rwlock_suite,
+    sync_condvar_suite,
+    sync_semaphore_suite,
+    sync_barrier_suite,
+    sync_oneshot_suite,
+    // alloc
+    alloc_suite,
+    // ipc
+    ipc_suite,
+};
+
+int main()
+{
+    consoleInit(NULL);
+
+    // Configure our supported input layout: a single player with standard controller styles
+    padConfigureInput(1, HidNpadStyleSet_NpadStandard);
+
+    // Initialize the default gamepad (which reads handheld mode inputs as well as the first connected controller)
+    PadState pad;
+    padInitializeDefault(&pad);
+
+    // Print the benchmark header
+    printf("NX-BENCHES (%s) [%s]\n", VERSION, LIBNX);
+    u32 ver = hosversionGet();
+    printf("HOS %d.%d.%d%s\n",
+        HOSVER_MAJOR(ver), HOSVER_MINOR(ver), HOSVER_MICRO(ver),
+        hosversionIsAtmosphere() ? " (AMS)" : "");
+    printf("%u samples x %u ops per run, ns per op\n", BENCH_SAMPLES, BENCH_BATCH);
+    printf("Press + to exit\n");
+
+    const uint64_t bench_suites_count = sizeof(bench_suites) / sizeof(BenchSuiteFn);
+    uint64_t curr_bench_suite = 0;
+
+    // Main loop:
+    // - Run and display the benchmark suites, one per frame
+    // - Wait for the user to press + to exit
+    while(appletMainLoop())
+    {
+        // Check if the user has pressed the + button to exit
+        padUpdate(&pad);
+        const uint32_t key_down = padGetButtonsDown(&pad);
+        if (key_down & HidNpadButton_Plus) {
+            break;
+        }
+
+        // Run the next benchmark suite
+        if (curr_bench_suite < bench_suites_count) {
+            bench_suites[curr_bench_suite]();
+            curr_bench_suite++;
+        }
+
+        consoleUpdate(NULL);
+    }
+
+    consoleExit(NULL);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static Barrier g_barrier;
+
+static void setup(BenchRun *run) {
+    barrierInit(&g_barrier, run->threads);
+}
+
+/**
+* Thread function for Bench #0001
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        barrierWait(&g_barrier);
+    })
+}
+
+const BenchCase bench_0001_barrier_wait = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = false,
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../bench.h"
+
+/**
+* Every thread waits on a barrier sized for all the threads, round after round.
+*/
+extern const BenchCase bench_0001_barrier_wait;
+
+/**
+ * Benchmark suite for sync/barrier.
+ */
+static void sync_barrier_suite(void) {
+    BENCH_SUITE("sync/barrier");
+
+    BENCH_CASE(
+        "Bench 0001: barrier_wait",
+        bench_0001_barrier_wait
+    )
+}
@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static Mutex g_mutex;
+static CondVar g_condvar;
+static uint64_t g_turn;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    mutexInit(&g_mutex);
+    condvarInit(&g_condvar);
+    g_turn = 0;
+}
+
+/**
+* Thread function for Bench #0001
+*
+* The threads pass a token around a ring: each one waits for its turn, takes it, and wakes
+* the others. A single thread never waits, timing the wake of a condvar with no waiters.
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        mutexLock(&g_mutex);
+        while (g_turn % run->threads != idx) {
+            condvarWait(&g_condvar, &g_mutex);
+        }
+        g_turn++;
+        mutexUnlock(&g_mutex);
+        condvarWakeAll(&g_condvar);
+    })
+}
+
+const BenchCase bench_0001_condvar_ring_handoff = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = false,
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../bench.h"
+
+/**
+* The threads pass a token around a ring, each waiting on the shared condvar for its turn.
+*/
+extern const BenchCase bench_0001_condvar_ring_handoff;
+
+/**
+ * Benchmark suite for sync/condvar.
+ */
+static void sync_condvar_suite(void) {
+    BENCH_SUITE("sync/condvar");
+
+    BENCH_CASE(
+        "Bench 0001: condvar_ring_handoff",
+        bench_0001_condvar_ring_handoff
+    )
+}
@@ -0,0 +1,33 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static Mutex g_mutex;
+static uint64_t g_counter;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    mutexInit(&g_mutex);
+    g_counter = 0;
+}
+
+/**
+* Thread function for Bench #0001
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        mutexLock(&g_mutex);
+        g_counter++;
+        bench_spin(run->hold);
+        mutexUnlock(&g_mutex);
+    })
+}
+
+const BenchCase bench_0001_mutex_lock_unlock = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = true,
+};
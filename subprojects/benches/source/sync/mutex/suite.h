@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../bench.h"
+
+/**
+* Every thread locks the shared mutex, holds it for the contention level, and unlocks it.
+*/
+extern const BenchCase bench_0001_mutex_lock_unlock;
+
+/**
+ * Benchmark suite for sync/mutex.
+ */
+static void sync_mutex_suite(void) {
+    BENCH_SUITE("sync/mutex");
+
+    BENCH_CASE(
+        "Bench 0001: mutex_lock_unlock",
+        bench_0001_mutex_lock_unlock
+    )
+}
@@ -0,0 +1,27 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+#include "nx_sync_oneshot.h"
+
+/**
+* Thread function for Bench #0001
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        NxSyncOneshotSender* sender;
+        NxSyncOneshotReceiver* receiver;
+        __nx_std_sync__oneshot_create(&sender, &receiver);
+
+        void* value = NULL;
+        __nx_std_sync__oneshot_send(sender, (void*)(uintptr_t)idx);
+        __nx_std_sync__oneshot_recv(receiver, &value);
+    })
+}
+
+const BenchCase bench_0001_oneshot_create_send_recv = {
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = false,
+};
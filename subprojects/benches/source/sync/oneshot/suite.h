@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../../bench.h"
+
+/**
+* Every thread creates a oneshot channel, sends a value on it, and receives it, so that the
+* timings include the allocation of the channel.
+*/
+extern const BenchCase bench_0001_oneshot_create_send_recv;
+
+/**
+ * Benchmark suite for sync/oneshot.
+ */
+static void sync_oneshot_suite(void) {
+    BENCH_SUITE("sync/oneshot");
+
+    BENCH_CASE(
+        "Bench 0001: oneshot_create_send_recv",
+        bench_0001_oneshot_create_send_recv
+    )
+}
@@ -0,0 +1,30 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static RwLock g_rwlock;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    rwlockInit(&g_rwlock);
+}
+
+/**
+* Thread function for Bench #0001
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        rwlockReadLock(&g_rwlock);
+        bench_spin(run->hold);
+        rwlockReadUnlock(&g_rwlock);
+    })
+}
+
+const BenchCase bench_0001_rwlock_read_lock_unlock = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = true,
+};
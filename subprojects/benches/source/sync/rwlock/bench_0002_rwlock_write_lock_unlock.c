@@ -0,0 +1,33 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static RwLock g_rwlock;
+static uint64_t g_counter;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    rwlockInit(&g_rwlock);
+    g_counter = 0;
+}
+
+/**
+* Thread function for Bench #0002
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        rwlockWriteLock(&g_rwlock);
+        g_counter++;
+        bench_spin(run->hold);
+        rwlockWriteUnlock(&g_rwlock);
+    })
+}
+
+const BenchCase bench_0002_rwlock_write_lock_unlock = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = true,
+};
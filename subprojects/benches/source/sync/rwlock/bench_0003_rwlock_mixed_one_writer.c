@@ -0,0 +1,43 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static RwLock g_rwlock;
+static uint64_t g_counter;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    rwlockInit(&g_rwlock);
+    g_counter = 0;
+}
+
+/**
+* Thread function for Bench #0003
+*
+* Thread 0 writes, the other threads read.
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    if (idx == 0) {
+        BENCH_LOOP(run, idx, {
+            rwlockWriteLock(&g_rwlock);
+            g_counter++;
+            bench_spin(run->hold);
+            rwlockWriteUnlock(&g_rwlock);
+        })
+    } else {
+        BENCH_LOOP(run, idx, {
+            rwlockReadLock(&g_rwlock);
+            bench_spin(run->hold);
+            rwlockReadUnlock(&g_rwlock);
+        })
+    }
+}
+
+const BenchCase bench_0003_rwlock_mixed_one_writer = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 2,
+    .contended = true,
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../../bench.h"
+
+/**
+* Every thread read-locks the shared lock, holds it for the contention level, and unlocks it.
+*/
+extern const BenchCase bench_0001_rwlock_read_lock_unlock;
+
+/**
+* Every thread write-locks the shared lock, holds it for the contention level, and unlocks it.
+*/
+extern const BenchCase bench_0002_rwlock_write_lock_unlock;
+
+/**
+* One thread write-locks the shared lock while the others read-lock it.
+*/
+extern const BenchCase bench_0003_rwlock_mixed_one_writer;
+
+/**
+ * Benchmark suite for sync/rwlock.
+ */
+static void sync_rwlock_suite(void) {
+    BENCH_SUITE("sync/rwlock");
+
+    BENCH_CASE(
+        "Bench 0001: rwlock_read_lock_unlock",
+        bench_0001_rwlock_read_lock_unlock
+    )
+    BENCH_CASE(
+        "Bench 0002: rwlock_write_lock_unlock",
+        bench_0002_rwlock_write_lock_unlock
+    )
+    BENCH_CASE(
+        "Bench 0003: rwlock_mixed_one_writer",
+        bench_0003_rwlock_mixed_one_writer
+    )
+}
@@ -0,0 +1,33 @@
+#include <stdint.h>
+
+#include <switch.h>
+
+#include "../../bench.h"
+
+static Semaphore g_semaphore;
+static uint64_t g_counter;
+
+static void setup(BenchRun *run) {
+    (void)run;
+    semaphoreInit(&g_semaphore, 1);
+    g_counter = 0;
+}
+
+/**
+* Thread function for Bench #0001
+*/
+static void thread_func(BenchRun *run, uint32_t idx) {
+    BENCH_LOOP(run, idx, {
+        semaphoreWait(&g_semaphore);
+        g_counter++;
+        bench_spin(run->hold);
+        semaphoreSignal(&g_semaphore);
+    })
+}
+
+const BenchCase bench_0001_semaphore_wait_signal = {
+    .setup = setup,
+    .thread = thread_func,
+    .min_threads = 1,
+    .contended = true,
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../../bench.h"
+
+/**
+* Every thread waits on a semaphore of initial count 1, holds it for the contention level,
+* and signals it.
+*/
+extern const BenchCase bench_0001_semaphore_wait_signal;
+
+/**
+ * Benchmark suite for sync/semaphore.
+ */
+static void sync_semaphore_suite(void) {
+    BENCH_SUITE("sync/semaphore");
+
+    BENCH_CASE(
+        "Bench 0001: semaphore_wait_signal",
+        bench_0001_semaphore_wait_signal
+    )
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "mutex/suite.h"
+#include "rwlock/suite.h"
+#include "condvar/suite.h"
+#include "semaphore/suite.h"
+#include "barrier/suite.h"
+#include "oneshot/suite.h"
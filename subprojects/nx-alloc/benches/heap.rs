@@ -0,0 +1,68 @@
+//! Host benchmarks of the allocator heap.
+//!
+//! The heap is initialized over a host buffer; build with `--features tlsf` to benchmark
+//! the TLSF backend instead of the first-fit one.
+
+use core::{hint::black_box, ptr::NonNull};
+
+use criterion::{BenchmarkId, Criterion, criterion_group, criterion_main};
+use nx_alloc::llffalloc::Heap;
+
+/// Size of the benchmarked heap.
+const HEAP_SIZE: usize = 16 * 1024 * 1024;
+
+/// Alignment of the allocations.
+const ALIGN: usize = 16;
+
+/// Number of blocks left allocated by the fragmented heap.
+const LIVE_BLOCKS: usize = 1024;
+
+/// Creates a heap over a leaked host buffer.
+fn new_heap() -> Heap {
+    let buf: &'static mut [u128] = Vec::leak(vec![0u128; HEAP_SIZE / size_of::<u128>()]);
+    let mut heap = Heap::new_uninit();
+    // SAFETY: The buffer is leaked, so it outlives the heap.
+    unsafe { heap.init_with_heap_override(NonNull::from(buf).cast(), HEAP_SIZE) };
+    heap
+}
+
+/// Leaves every other block of varying sizes allocated, interleaved with free ones.
+fn fragment(heap: &mut Heap) {
+    let mut blocks = Vec::with_capacity(2 * LIVE_BLOCKS);
+    for i in 0..2 * LIVE_BLOCKS {
+        let size = 16 << (i % 8);
+        // SAFETY: The layout is valid.
+        blocks.push((unsafe { heap.malloc(size, ALIGN) }, size));
+    }
+    for (ptr, size) in blocks.into_iter().step_by(2) {
+        // SAFETY: `ptr` was allocated above with `size` and `ALIGN`.
+        unsafe { heap.free(ptr, size, ALIGN) };
+    }
+}
+
+fn bench_malloc_free(c: &mut Criterion) {
+    let mut group = c.benchmark_group("heap::malloc_free");
+    for fragmented in [false, true] {
+        let mut heap = new_heap();
+        if fragmented {
+            fragment(&mut heap);
+        }
+        let state = if fragmented { "fragmented" } else { "empty" };
+
+        for size in [64, 4096] {
+            group.bench_with_input(BenchmarkId::new(state, size), &size, |b, &size| {
+                b.iter(|| {
+                    // SAFETY: The layout is valid, and the block is freed with it.
+                    unsafe {
+                        let ptr = heap.malloc(black_box(size), ALIGN);
+                        heap.free(black_box(ptr), size, ALIGN);
+                    }
+                });
+            });
+        }
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_malloc_free);
+criterion_main!(benches);
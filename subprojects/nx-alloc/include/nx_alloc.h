@@ -9,6 +9,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,6 +53,99 @@ void* __nx_alloc_realloc(void* ptr, size_t new_size);
  */
 void __nx_alloc_free(void* p);
 
+/**
+ * @brief Returns the calling thread's cached allocator blocks to the global heap.
+ * @note Only meaningful when nx-alloc is built with the `thread-cache` feature. Threads
+ *       should call this before exiting, otherwise their cached blocks are leaked.
+ */
+void __nx_alloc__flush_thread_cache(void);
+
+/**
+ * @brief Releases trailing free heap memory back to the kernel.
+ * @return Number of bytes released.
+ * @note Only effective when nx-alloc is built with the `growable-heap` and `tlsf` features;
+ *       the heap never shrinks below its initial size.
+ */
+size_t __nx_alloc__trim_heap(void);
+
+/// Opaque bump allocator for short-lived scratch memory.
+typedef struct NxAllocArena NxAllocArena;
+
+/**
+ * @brief Creates a new arena allocator.
+ * @param chunk_size Minimum size of the arena's memory chunks, 0 for the default (64 KiB).
+ * @return The new arena, or NULL on failure.
+ * @remark The caller is responsible for destroying the arena with __nx_alloc__arena_free().
+ */
+NxAllocArena* __nx_alloc__arena_new(size_t chunk_size);
+
+/**
+ * @brief Destroys an arena, releasing all of its memory.
+ * @param[in] arena The arena to destroy.
+ * @note If `arena` is `NULL`, this function does nothing.
+ */
+void __nx_alloc__arena_free(NxAllocArena* arena);
+
+/**
+ * @brief Allocates memory from an arena by bumping a pointer.
+ * @param[in] arena The arena.
+ * @param size Size of the allocation in bytes.
+ * @param alignment Alignment, which must be a power of two.
+ * @return Pointer to the allocated memory, or NULL on failure.
+ * @remark Allocations cannot be freed individually; they are reclaimed by
+ *         __nx_alloc__arena_reset() or __nx_alloc__arena_free().
+ */
+void* __nx_alloc__arena_alloc(NxAllocArena* arena, size_t size, size_t alignment);
+
+/**
+ * @brief Rewinds an arena in O(1), invalidating all of its allocations.
+ * @param[in] arena The arena.
+ * @note The arena keeps its memory for reuse.
+ */
+void __nx_alloc__arena_reset(NxAllocArena* arena);
+
+/**
+ * @brief Returns the bytes allocated from an arena since its last reset.
+ * @param[in] arena The arena.
+ */
+size_t __nx_alloc__arena_allocated(const NxAllocArena* arena);
+
+/// Number of allocation size histogram bins in ::NxAllocStats.
+#define NX_ALLOC_STATS_HISTOGRAM_BINS 16
+
+/// Allocator statistics snapshot.
+typedef struct {
+    size_t heap_size;           ///< Total size of the managed heap in bytes.
+    size_t heap_used;           ///< Heap bytes held by used blocks, including overhead.
+    size_t heap_free;           ///< Heap bytes not held by used blocks.
+    size_t largest_free_block;  ///< Largest free block, 0 if the backend cannot report it.
+    size_t live_bytes;          ///< Requested bytes currently allocated.
+    size_t peak_live_bytes;     ///< Maximum value reached by live_bytes.
+    uint64_t alloc_count;       ///< Successful allocations.
+    uint64_t free_count;        ///< Deallocations.
+    uint64_t alloc_failures;    ///< Failed allocations.
+    uint64_t realloc_count;     ///< Reallocation requests.
+    uint64_t realloc_in_place_count; ///< Reallocations served without moving the block.
+    uint64_t lock_acquisitions; ///< Heap lock acquisitions.
+    uint64_t lock_contentions;  ///< Heap lock acquisitions that had to wait.
+    /// Successful allocations per size bin: bin 0 is <= 16 bytes, bin n is (8<<n, 16<<n],
+    /// the last bin holds everything larger.
+    uint64_t size_histogram[NX_ALLOC_STATS_HISTOGRAM_BINS];
+} NxAllocStats;
+
+/**
+ * @brief Writes a snapshot of the allocator statistics.
+ * @param[out] stats Output statistics. Ignored if NULL.
+ * @note The call and lock counters read as zero unless nx-alloc is built with the `stats`
+ *       feature; the heap figures are always reported.
+ */
+void __nx_alloc__get_stats(NxAllocStats* stats);
+
+/**
+ * @brief Resets NxAllocStats::peak_live_bytes to the current live bytes.
+ */
+void __nx_alloc__reset_peak_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
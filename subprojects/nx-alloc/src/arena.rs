@@ -0,0 +1,337 @@
+//! # Arena allocator
+//!
+//! A bump allocator for short-lived scratch memory (e.g. per-frame or per-request data).
+//!
+//! Allocating from an [`Arena`] is a pointer bump inside the current chunk. Chunks are
+//! page-aligned blocks taken from the global heap (see [`crate::global::malloc`]) and are
+//! kept across [`Arena::reset`], which rewinds the arena in O(1) so steady-state use never
+//! touches the heap lock. Individual allocations cannot be freed; memory is reclaimed all
+//! at once by resetting or dropping the arena.
+//!
+//! Values placed in the arena are never dropped.
+
+use core::{
+    alloc::Layout,
+    cell::Cell,
+    marker::PhantomData,
+    mem,
+    ptr::{self, NonNull},
+};
+
+use crate::global;
+
+/// Default size of an arena chunk, including its header.
+pub const DEFAULT_CHUNK_SIZE: usize = 0x10000;
+
+/// Alignment and size granularity of arena chunks.
+const CHUNK_ALIGN: usize = 0x1000;
+
+/// A bump allocator over a list of heap-allocated chunks.
+///
+/// The arena is not thread-safe; use one arena per thread.
+pub struct Arena {
+    /// First chunk of the list, null until the first allocation.
+    first: Cell<*mut Chunk>,
+    /// Chunk currently being bumped.
+    current: Cell<*mut Chunk>,
+    /// Next free address in the current chunk.
+    cursor: Cell<usize>,
+    /// End (exclusive) of the current chunk.
+    end: Cell<usize>,
+    /// Bytes handed out since the last reset, including alignment padding.
+    allocated: Cell<usize>,
+    /// Size of newly allocated chunks.
+    chunk_size: usize,
+    _not_sync: PhantomData<*mut ()>,
+}
+
+// SAFETY: The arena exclusively owns its chunks; moving it to another thread is fine.
+unsafe impl Send for Arena {}
+
+impl Arena {
+    /// Creates an empty arena using [`DEFAULT_CHUNK_SIZE`] chunks.
+    ///
+    /// No memory is allocated until the first allocation.
+    pub const fn new() -> Self {
+        Self::with_chunk_size(DEFAULT_CHUNK_SIZE)
+    }
+
+    /// Creates an empty arena using chunks of at least `chunk_size` bytes.
+    ///
+    /// The size is rounded up to the page size. Allocations larger than a chunk get a
+    /// dedicated chunk.
+    pub const fn with_chunk_size(chunk_size: usize) -> Self {
+        let chunk_size = if chunk_size < CHUNK_ALIGN {
+            CHUNK_ALIGN
+        } else {
+            (chunk_size + CHUNK_ALIGN - 1) & !(CHUNK_ALIGN - 1)
+        };
+
+        Self {
+            first: Cell::new(ptr::null_mut()),
+            current: Cell::new(ptr::null_mut()),
+            cursor: Cell::new(0),
+            end: Cell::new(0),
+            allocated: Cell::new(0),
+            chunk_size,
+            _not_sync: PhantomData,
+        }
+    }
+
+    /// Allocates a block for `layout`.
+    ///
+    /// Returns `None` if a new chunk was needed and the heap is exhausted. The block lives
+    /// until the next [`Arena::reset`] or until the arena is dropped.
+    #[inline]
+    pub fn alloc_layout(&self, layout: Layout) -> Option<NonNull<u8>> {
+        if let Some(ptr) = self.bump(layout) {
+            return Some(ptr);
+        }
+
+        self.alloc_layout_slow(layout)
+    }
+
+    /// Moves `value` into the arena and returns a mutable reference to it.
+    ///
+    /// The value's destructor is never run.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the heap is exhausted.
+    #[inline]
+    pub fn alloc<T>(&self, value: T) -> &mut T {
+        let Some(ptr) = self.alloc_layout(Layout::new::<T>()) else {
+            panic!("arena allocation failed: out of memory");
+        };
+
+        let ptr = ptr.cast::<T>().as_ptr();
+        // SAFETY: The block is freshly allocated, properly aligned for `T` and exclusively
+        // borrowed for the arena's lifetime; `reset` requires `&mut self`.
+        unsafe {
+            ptr.write(value);
+            &mut *ptr
+        }
+    }
+
+    /// Copies `src` into the arena and returns a mutable reference to the copy.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the heap is exhausted.
+    #[inline]
+    pub fn alloc_slice_copy<T: Copy>(&self, src: &[T]) -> &mut [T] {
+        let Ok(layout) = Layout::array::<T>(src.len()) else {
+            panic!("arena allocation failed: invalid slice layout");
+        };
+        let Some(ptr) = self.alloc_layout(layout) else {
+            panic!("arena allocation failed: out of memory");
+        };
+
+        let ptr = ptr.cast::<T>().as_ptr();
+        // SAFETY: The block holds `src.len()` properly aligned `T`s and does not overlap
+        // `src`.
+        unsafe {
+            ptr::copy_nonoverlapping(src.as_ptr(), ptr, src.len());
+            core::slice::from_raw_parts_mut(ptr, src.len())
+        }
+    }
+
+    /// Rewinds the arena, invalidating every allocation made from it.
+    ///
+    /// All chunks are kept for reuse, so this is O(1).
+    pub fn reset(&mut self) {
+        let first = self.first.get();
+        self.current.set(first);
+        self.allocated.set(0);
+
+        if first.is_null() {
+            return;
+        }
+
+        // SAFETY: `first` is a live chunk owned by the arena.
+        let (start, end) = unsafe { (*first).bounds() };
+        self.cursor.set(start);
+        self.end.set(end);
+    }
+
+    /// Returns the bytes handed out since the last reset, including alignment padding.
+    pub fn allocated_bytes(&self) -> usize {
+        self.allocated.get()
+    }
+
+    /// Returns the total size of the chunks owned by the arena.
+    pub fn capacity(&self) -> usize {
+        let mut capacity = 0;
+        let mut chunk = self.first.get();
+        while !chunk.is_null() {
+            // SAFETY: Every chunk in the list is live and owned by the arena.
+            unsafe {
+                capacity += (*chunk).size;
+                chunk = (*chunk).next;
+            }
+        }
+        capacity
+    }
+
+    /// Bumps the cursor of the current chunk.
+    #[inline]
+    fn bump(&self, layout: Layout) -> Option<NonNull<u8>> {
+        let cursor = self.cursor.get();
+        let start = cursor.checked_add(layout.align() - 1)? & !(layout.align() - 1);
+        let new_cursor = start.checked_add(layout.size())?;
+        if new_cursor > self.end.get() || cursor == 0 {
+            return None;
+        }
+
+        self.cursor.set(new_cursor);
+        self.allocated
+            .set(self.allocated.get() + (new_cursor - cursor));
+
+        // SAFETY: `start` lies inside a live chunk, which is never at address zero.
+        Some(unsafe { NonNull::new_unchecked(start as *mut u8) })
+    }
+
+    /// Moves to the next retained chunk, or allocates a new one, and bumps from it.
+    #[cold]
+    fn alloc_layout_slow(&self, layout: Layout) -> Option<NonNull<u8>> {
+        let required = layout
+            .size()
+            .checked_add(layout.align())?
+            .checked_add(mem::size_of::<Chunk>())?;
+
+        // Reuse the chunks retained by `reset` that are large enough
+        let mut prev = self.current.get();
+        let mut next = if prev.is_null() {
+            self.first.get()
+        } else {
+            // SAFETY: `prev` is a live chunk owned by the arena.
+            unsafe { (*prev).next }
+        };
+        while !next.is_null() {
+            // SAFETY: Every chunk in the list is live and owned by the arena.
+            unsafe {
+                if (*next).size >= required {
+                    self.enter(next);
+                    return self.bump(layout);
+                }
+                prev = next;
+                next = (*next).next;
+            }
+        }
+
+        let size = required.max(self.chunk_size);
+        let size = size.checked_add(CHUNK_ALIGN - 1)? & !(CHUNK_ALIGN - 1);
+        let chunk = Chunk::allocate(size)?;
+
+        // SAFETY: `chunk` is freshly allocated and `prev`, if any, is the list tail.
+        unsafe {
+            if prev.is_null() {
+                self.first.set(chunk);
+            } else {
+                (*chunk).next = (*prev).next;
+                (*prev).next = chunk;
+            }
+            self.enter(chunk);
+        }
+
+        self.bump(layout)
+    }
+
+    /// Makes `chunk` the current chunk.
+    ///
+    /// # Safety
+    ///
+    /// `chunk` must be a live chunk owned by the arena.
+    #[inline]
+    unsafe fn enter(&self, chunk: *mut Chunk) {
+        // SAFETY: The caller guarantees `chunk` is live.
+        let (start, end) = unsafe { (*chunk).bounds() };
+        self.current.set(chunk);
+        self.cursor.set(start);
+        self.end.set(end);
+    }
+}
+
+impl Default for Arena {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for Arena {
+    fn drop(&mut self) {
+        let mut chunk = self.first.get();
+        while !chunk.is_null() {
+            // SAFETY: Every chunk in the list was allocated by `Chunk::allocate` and is
+            // released exactly once.
+            unsafe {
+                let next = (*chunk).next;
+                Chunk::release(chunk);
+                chunk = next;
+            }
+        }
+    }
+}
+
+#[cfg(feature = "allocator-api")]
+// SAFETY: Blocks stay valid until the arena is reset (requires `&mut`) or dropped, which
+// the borrow of `&Arena` prevents while blocks are in use.
+unsafe impl core::alloc::Allocator for &Arena {
+    fn allocate(&self, layout: Layout) -> Result<NonNull<[u8]>, core::alloc::AllocError> {
+        let ptr = self.alloc_layout(layout).ok_or(core::alloc::AllocError)?;
+        Ok(NonNull::slice_from_raw_parts(ptr, layout.size()))
+    }
+
+    unsafe fn deallocate(&self, _ptr: NonNull<u8>, _layout: Layout) {
+        // Memory is reclaimed on reset or drop
+    }
+}
+
+/// Header at the start of every arena chunk.
+#[repr(C)]
+struct Chunk {
+    /// Next chunk in the list.
+    next: *mut Chunk,
+    /// Chunk size including this header.
+    size: usize,
+}
+
+impl Chunk {
+    /// Allocates a chunk of `size` bytes from the global heap.
+    fn allocate(size: usize) -> Option<*mut Chunk> {
+        // SAFETY: `size` is non-zero and `CHUNK_ALIGN` is a power of two.
+        let ptr = unsafe { global::malloc(size, CHUNK_ALIGN) }.cast::<Chunk>();
+        if ptr.is_null() {
+            return None;
+        }
+
+        // SAFETY: `ptr` is a fresh, aligned block of `size >= size_of::<Chunk>()` bytes.
+        unsafe {
+            ptr.write(Chunk {
+                next: ptr::null_mut(),
+                size,
+            })
+        };
+        Some(ptr)
+    }
+
+    /// Returns the usable address range of the chunk.
+    #[inline]
+    fn bounds(&self) -> (usize, usize) {
+        let base = self as *const Self as usize;
+        (base + mem::size_of::<Self>(), base + self.size)
+    }
+
+    /// Returns a chunk to the global heap.
+    ///
+    /// # Safety
+    ///
+    /// `chunk` must have been returned by [`Chunk::allocate`] and not released since.
+    unsafe fn release(chunk: *mut Chunk) {
+        // SAFETY: The chunk was allocated with this size and alignment.
+        unsafe {
+            let size = (*chunk).size;
+            global::free(chunk.cast(), size, CHUNK_ALIGN);
+        }
+    }
+}
@@ -1,7 +1,7 @@
 use core::{ffi::c_void, ptr};
 
 use self::meta::{Allocation, Layout};
-use crate::global as global_allocator;
+use crate::{arena::Arena, global as global_allocator, stats::Stats};
 
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn __nx_alloc__malloc(size: usize) -> *mut c_void {
@@ -9,16 +9,9 @@ pub unsafe extern "C" fn __nx_alloc__malloc(size: usize) -> *mut c_void {
         return ptr::null_mut();
     };
 
-    // Critical section
-    let alloc_ptr = {
-        let mut alloc = global_allocator::lock();
-
-        let raw_alloc_ptr = unsafe { alloc.malloc(layout.size(), layout.align()) };
-        let Some(alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
-            return ptr::null_mut();
-        };
-
-        alloc_ptr
+    let raw_alloc_ptr = unsafe { global_allocator::malloc(layout.size(), layout.align()) };
+    let Some(alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
+        return ptr::null_mut();
     };
 
     let allocation = unsafe { Allocation::new_with_metadata(alloc_ptr, layout) };
@@ -31,16 +24,9 @@ pub unsafe extern "C" fn __nx_alloc__aligned_alloc(align: usize, size: usize) ->
         return ptr::null_mut();
     };
 
-    // Critical section
-    let alloc_ptr = {
-        let mut alloc = global_allocator::lock();
-
-        let raw_alloc_ptr = unsafe { alloc.malloc(layout.size(), layout.align()) };
-        let Some(alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
-            return ptr::null_mut();
-        };
-
-        alloc_ptr
+    let raw_alloc_ptr = unsafe { global_allocator::malloc(layout.size(), layout.align()) };
+    let Some(alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
+        return ptr::null_mut();
     };
 
     let allocation = unsafe { Allocation::new_with_metadata(alloc_ptr, layout) };
@@ -55,8 +41,7 @@ pub unsafe extern "C" fn __nx_alloc__free(ptr: *mut c_void) {
 
     let allocation = unsafe { Allocation::from_data_ptr(alloc_ptr) };
 
-    let mut alloc = global_allocator::lock();
-    unsafe { alloc.free(allocation.as_ptr(), allocation.size(), allocation.align()) }
+    unsafe { global_allocator::free(allocation.as_ptr(), allocation.size(), allocation.align()) }
 }
 
 #[unsafe(no_mangle)]
@@ -70,17 +55,10 @@ pub unsafe extern "C" fn __nx_alloc__calloc(nmemb: usize, size: usize) -> *mut c
         return ptr::null_mut();
     };
 
-    // Critical section
-    let alloc_ptr = {
-        let mut alloc = global_allocator::lock();
-
-        // Allocate new block
-        let raw_alloc_ptr = unsafe { alloc.malloc(layout.size(), layout.align()) };
-        let Some(alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
-            return ptr::null_mut();
-        };
-
-        alloc_ptr
+    // Allocate new block
+    let raw_alloc_ptr = unsafe { global_allocator::malloc(layout.size(), layout.align()) };
+    let Some(alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
+        return ptr::null_mut();
     };
 
     // Zero the allocation
@@ -115,33 +93,173 @@ pub unsafe extern "C" fn __nx_alloc__realloc(ptr: *mut c_void, new_size: usize)
         return ptr::null_mut();
     };
 
-    // Critical section
-    let new_alloc_ptr = {
-        let mut alloc = global_allocator::lock();
-
-        // Allocate new block
-        let raw_alloc_ptr = unsafe { alloc.malloc(layout.size(), layout.align()) };
-        let Some(new_alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
-            return ptr::null_mut();
-        };
+    // Try to grow into the adjacent free block, or return the tail to the heap, first.
+    // The metadata offset only depends on the alignment, so the data pointer is unchanged.
+    // SAFETY: The allocation is live with the recorded layout.
+    let old_ptr = unsafe { ptr::NonNull::new_unchecked(allocation.as_ptr()) };
+    if unsafe { global_allocator::resize_in_place(old_ptr, old_size, layout.size(), align) } {
+        let new_allocation = unsafe { Allocation::new_with_metadata(old_ptr, layout) };
+        return new_allocation.data_ptr() as *mut c_void;
+    }
 
-        // Copy old data to new allocation (up to the minimum of old and new size)
-        let copy_size = old_size.min(layout.size());
+    // Allocate new block
+    let raw_alloc_ptr = unsafe { global_allocator::malloc(layout.size(), layout.align()) };
+    let Some(new_alloc_ptr) = ptr::NonNull::new(raw_alloc_ptr) else {
+        return ptr::null_mut();
+    };
 
-        // Safety: The pointers are valid and the size is non-zero
-        unsafe { ptr::copy_nonoverlapping(allocation.as_ptr(), new_alloc_ptr.as_ptr(), copy_size) };
+    // Copy old data to new allocation (up to the minimum of old and new size)
+    let copy_size = old_size.min(layout.size());
 
-        // Free old allocation
-        unsafe { alloc.free(allocation.as_ptr(), old_size, align) };
+    // Safety: The pointers are valid and the size is non-zero
+    unsafe { ptr::copy_nonoverlapping(allocation.as_ptr(), new_alloc_ptr.as_ptr(), copy_size) };
 
-        new_alloc_ptr
-    };
+    // Free old allocation
+    unsafe { global_allocator::free(allocation.as_ptr(), old_size, align) };
 
     // Write new metadata and return pointer to data
     let new_allocation = unsafe { Allocation::new_with_metadata(new_alloc_ptr, layout) };
     new_allocation.data_ptr() as *mut c_void
 }
 
+/// Returns the calling thread's cached allocator blocks to the global heap.
+///
+/// C threads should call this before exiting when the `thread-cache` feature is enabled,
+/// otherwise their cached blocks are leaked. No-op without the feature.
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_alloc__flush_thread_cache() {
+    global_allocator::flush_thread_cache();
+}
+
+/// Releases trailing free heap memory back to the kernel, returning the bytes released.
+///
+/// Only effective when nx-alloc is built with the `growable-heap` and `tlsf` features.
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_alloc__trim_heap() -> usize {
+    global_allocator::trim_heap()
+}
+
+/// Writes a snapshot of the allocator statistics to `stats`.
+///
+/// The call and lock counters read as zero unless nx-alloc is built with the `stats`
+/// feature. No-op if `stats` is null.
+///
+/// # Safety
+///
+/// `stats` must be null or valid for writes of an `NxAllocStats`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_alloc__get_stats(stats: *mut Stats) {
+    if stats.is_null() {
+        return;
+    }
+
+    // SAFETY: The caller guarantees `stats` is valid for writes.
+    unsafe { stats.write(global_allocator::stats()) };
+}
+
+/// Resets the peak live bytes statistic to the current live bytes.
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_alloc__reset_peak_stats() {
+    global_allocator::reset_peak_stats();
+}
+
+/// Creates a new arena allocator using chunks of at least `chunk_size` bytes.
+///
+/// A `chunk_size` of zero selects the default chunk size. Returns null on allocation
+/// failure. The arena must be destroyed with [`__nx_alloc__arena_free`].
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_alloc__arena_new(chunk_size: usize) -> *mut Arena {
+    let arena = if chunk_size == 0 {
+        Arena::new()
+    } else {
+        Arena::with_chunk_size(chunk_size)
+    };
+
+    // SAFETY: The size and alignment of `Arena` form a valid layout.
+    let ptr = unsafe {
+        global_allocator::malloc(
+            core::mem::size_of::<Arena>(),
+            core::mem::align_of::<Arena>(),
+        )
+    }
+    .cast::<Arena>();
+    if ptr.is_null() {
+        return ptr::null_mut();
+    }
+
+    // SAFETY: `ptr` is a fresh block with the size and alignment of `Arena`.
+    unsafe { ptr.write(arena) };
+    ptr
+}
+
+/// Destroys an arena, releasing all of its memory.
+///
+/// If `arena` is null, this function does nothing.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_alloc__arena_free(arena: *mut Arena) {
+    if arena.is_null() {
+        return;
+    }
+
+    // SAFETY: The caller guarantees `arena` was returned by `__nx_alloc__arena_new`.
+    unsafe {
+        ptr::drop_in_place(arena);
+        global_allocator::free(
+            arena.cast(),
+            core::mem::size_of::<Arena>(),
+            core::mem::align_of::<Arena>(),
+        );
+    }
+}
+
+/// Allocates `size` bytes aligned to `align` from an arena.
+///
+/// Returns null if `arena` is null, the layout is invalid or the heap is exhausted.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_alloc__arena_alloc(
+    arena: *mut Arena,
+    size: usize,
+    align: usize,
+) -> *mut c_void {
+    if arena.is_null() {
+        return ptr::null_mut();
+    }
+    let Ok(layout) = core::alloc::Layout::from_size_align(size, align) else {
+        return ptr::null_mut();
+    };
+
+    // SAFETY: The caller guarantees `arena` is a live arena.
+    let arena = unsafe { &*arena };
+    match arena.alloc_layout(layout) {
+        Some(ptr) => ptr.as_ptr().cast(),
+        None => ptr::null_mut(),
+    }
+}
+
+/// Rewinds an arena, invalidating every allocation made from it while keeping its memory.
+///
+/// If `arena` is null, this function does nothing.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_alloc__arena_reset(arena: *mut Arena) {
+    if arena.is_null() {
+        return;
+    }
+
+    // SAFETY: The caller guarantees `arena` is a live arena not in use elsewhere.
+    unsafe { (*arena).reset() };
+}
+
+/// Returns the bytes allocated from an arena since its last reset, or 0 if `arena` is null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_alloc__arena_allocated(arena: *const Arena) -> usize {
+    if arena.is_null() {
+        return 0;
+    }
+
+    // SAFETY: The caller guarantees `arena` is a live arena.
+    unsafe { (*arena).allocated_bytes() }
+}
+
 mod newlib {
     use core::ffi::c_void;
 
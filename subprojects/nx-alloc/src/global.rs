@@ -9,8 +9,13 @@ use core::{
     ptr::NonNull,
 };
 
+#[cfg(feature = "stats")]
+use crate::stats;
+#[cfg(feature = "thread-cache")]
+use crate::tcache;
 use crate::{
     llffalloc,
+    stats::Stats,
     sync::{Mutex, MutexGuard},
 };
 
@@ -48,10 +53,104 @@ pub unsafe fn init_with_heap_override(addr: NonNull<c_void>, size: usize) {
 }
 
 /// Lock the allocator and return a mutable reference to the heap.
+///
+/// Blocks obtained through [`malloc`] must be released with [`free`], not through the
+/// returned heap, as small blocks may be served from size-class layouts.
 pub fn lock() -> MutexGuard<'static, llffalloc::Heap> {
     ALLOC.0.lock()
 }
 
+/// Allocate memory from the global allocator.
+///
+/// # Safety
+///
+/// The size and alignment must form a valid layout (see [`llffalloc::Heap::malloc`]).
+#[inline]
+pub unsafe fn malloc(size: usize, align: usize) -> *mut u8 {
+    // SAFETY: Caller guarantees a valid layout.
+    unsafe { ALLOC.malloc(size, align) }
+}
+
+/// Free memory previously allocated by [`malloc`].
+///
+/// # Safety
+///
+/// `ptr` must have been returned by [`malloc`] with the same size and alignment, and must
+/// not have been freed already.
+#[inline]
+pub unsafe fn free(ptr: *mut u8, size: usize, align: usize) {
+    // SAFETY: Caller guarantees `ptr` was allocated with this layout.
+    unsafe { ALLOC.free(ptr, size, align) }
+}
+
+/// Resize memory previously allocated by [`malloc`] without moving it.
+///
+/// Returns `true` if the block now holds `new_size` bytes and must from now on be freed
+/// with `new_size`; returns `false`, leaving the block untouched, if it cannot be resized in
+/// place.
+///
+/// # Safety
+///
+/// - `ptr` must have been returned by [`malloc`] with `old_size` and `align`, and must not
+///   have been freed already
+/// - `new_size` and `align` must form a valid layout
+#[inline]
+pub unsafe fn resize_in_place(
+    ptr: NonNull<u8>,
+    old_size: usize,
+    new_size: usize,
+    align: usize,
+) -> bool {
+    // SAFETY: Caller guarantees `ptr` was allocated with this layout.
+    unsafe { ALLOC.resize_in_place(ptr, old_size, new_size, align) }
+}
+
+/// Release trailing free heap memory back to the kernel.
+///
+/// Returns the number of bytes released. Only effective with the `growable-heap` and
+/// `tlsf` features (see [`llffalloc::Heap::trim`]).
+pub fn trim_heap() -> usize {
+    ALLOC.0.lock().trim()
+}
+
+/// Take a snapshot of the allocator statistics.
+///
+/// The heap figures are always filled in; the call and lock counters are only recorded
+/// when the `stats` feature is enabled and read as zero otherwise.
+pub fn stats() -> Stats {
+    let mut stats = Stats::default();
+    {
+        let alloc = ALLOC.0.lock();
+        stats.heap_size = alloc.size();
+        stats.heap_used = alloc.used();
+        stats.heap_free = alloc.free_size();
+        stats.largest_free_block = alloc.largest_free_block();
+    }
+
+    #[cfg(feature = "stats")]
+    stats::snapshot_counters(&mut stats);
+
+    stats
+}
+
+/// Reset the peak live bytes counter to the current live bytes.
+///
+/// No-op without the `stats` feature.
+pub fn reset_peak_stats() {
+    #[cfg(feature = "stats")]
+    stats::reset_peak();
+}
+
+/// Return the current thread's cached blocks to the global heap.
+///
+/// Must be called on thread exit when the `thread-cache` feature is enabled, otherwise the
+/// blocks cached by the exiting thread are leaked. No-op without the feature.
+#[inline]
+pub fn flush_thread_cache() {
+    #[cfg(feature = "thread-cache")]
+    tcache::flush_current(&ALLOC.0);
+}
+
 /// A `#[global_allocator]` for the Nintendo Switch.
 pub struct NxAllocator(Mutex<llffalloc::Heap>);
 
@@ -62,14 +161,160 @@ impl NxAllocator {
     }
 }
 
+impl NxAllocator {
+    /// Allocate memory, serving small requests from the current thread's cache when the
+    /// `thread-cache` feature is enabled.
+    ///
+    /// # Safety
+    ///
+    /// The size and alignment must form a valid layout.
+    #[inline]
+    unsafe fn malloc(&self, size: usize, align: usize) -> *mut u8 {
+        // SAFETY: Caller guarantees a valid layout.
+        let ptr = unsafe { self.malloc_block(size, align) };
+
+        #[cfg(feature = "stats")]
+        stats::record_alloc(size, ptr);
+
+        ptr
+    }
+
+    /// Free memory previously allocated by [`NxAllocator::malloc`].
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been allocated by this allocator with the same size and alignment.
+    #[inline]
+    unsafe fn free(&self, ptr: *mut u8, size: usize, align: usize) {
+        #[cfg(feature = "stats")]
+        if !ptr.is_null() {
+            stats::record_free(size);
+        }
+
+        // SAFETY: Caller guarantees `ptr` was allocated with this layout.
+        unsafe { self.free_block(ptr, size, align) }
+    }
+
+    /// Resize an allocation without moving it.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been allocated by this allocator with `old_size` and `align`, and
+    /// `new_size` and `align` must form a valid layout.
+    #[inline]
+    unsafe fn resize_in_place(
+        &self,
+        ptr: NonNull<u8>,
+        old_size: usize,
+        new_size: usize,
+        align: usize,
+    ) -> bool {
+        // SAFETY: Caller guarantees `ptr` is a live allocation with this layout.
+        let resized = unsafe { self.resize_block(ptr, old_size, new_size, align) };
+
+        #[cfg(feature = "stats")]
+        stats::record_realloc(old_size, new_size, resized);
+
+        resized
+    }
+
+    /// Allocate a block, serving small requests from the current thread's cache when the
+    /// `thread-cache` feature is enabled.
+    ///
+    /// # Safety
+    ///
+    /// The size and alignment must form a valid layout.
+    #[inline]
+    unsafe fn malloc_block(&self, size: usize, align: usize) -> *mut u8 {
+        #[cfg(feature = "thread-cache")]
+        if let Some(class) = tcache::SizeClass::for_layout(size, align) {
+            // SAFETY: `self.0` is the heap backing this allocator.
+            return unsafe { tcache::alloc(&self.0, class) };
+        }
+
+        let mut alloc = self.0.lock();
+        unsafe { alloc.malloc(size, align) }
+    }
+
+    /// Free a block previously allocated by [`NxAllocator::malloc_block`].
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been allocated by this allocator with the same size and alignment.
+    #[inline]
+    unsafe fn free_block(&self, ptr: *mut u8, size: usize, align: usize) {
+        #[cfg(feature = "thread-cache")]
+        if let Some(class) = tcache::SizeClass::for_layout(size, align) {
+            if ptr.is_null() {
+                return;
+            }
+            // SAFETY: The block was allocated through `tcache::alloc` with the same class.
+            return unsafe { tcache::free(&self.0, ptr, class) };
+        }
+
+        let mut alloc = self.0.lock();
+        unsafe { alloc.free(ptr, size, align) }
+    }
+
+    /// Resize a block without moving it.
+    ///
+    /// Blocks served by the thread cache can only be "resized" within their size class.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been allocated by this allocator with `old_size` and `align`, and
+    /// `new_size` and `align` must form a valid layout.
+    #[inline]
+    unsafe fn resize_block(
+        &self,
+        ptr: NonNull<u8>,
+        old_size: usize,
+        new_size: usize,
+        align: usize,
+    ) -> bool {
+        #[cfg(feature = "thread-cache")]
+        {
+            let old_class = tcache::SizeClass::for_layout(old_size, align);
+            let new_class = tcache::SizeClass::for_layout(new_size, align);
+            if old_class.is_some() || new_class.is_some() {
+                return old_class == new_class;
+            }
+        }
+
+        let mut alloc = self.0.lock();
+        // SAFETY: Caller guarantees `ptr` is a live allocation with this layout.
+        unsafe { alloc.resize_in_place(ptr, old_size, new_size, align) }
+    }
+}
+
 unsafe impl GlobalAlloc for NxAllocator {
     unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
-        let mut alloc = self.0.lock();
-        unsafe { alloc.malloc(layout.size(), layout.align()) }
+        unsafe { self.malloc(layout.size(), layout.align()) }
     }
 
     unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
-        let mut alloc = self.0.lock();
-        unsafe { alloc.free(ptr, layout.size(), layout.align()) }
+        unsafe { self.free(ptr, layout.size(), layout.align()) }
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        if let Some(nn) = NonNull::new(ptr) {
+            // SAFETY: `GlobalAlloc` guarantees `ptr` is live with `layout`, and that
+            // `new_size` with `layout.align()` forms a valid layout.
+            if unsafe { self.resize_in_place(nn, layout.size(), new_size, layout.align()) } {
+                return ptr;
+            }
+        }
+
+        // SAFETY: Same contract as `GlobalAlloc::realloc`.
+        let new_layout = unsafe { Layout::from_size_align_unchecked(new_size, layout.align()) };
+        let new_ptr = unsafe { self.malloc(new_layout.size(), new_layout.align()) };
+        if !new_ptr.is_null() {
+            // SAFETY: Both blocks are valid for the copied length and do not overlap.
+            unsafe {
+                core::ptr::copy_nonoverlapping(ptr, new_ptr, layout.size().min(new_size));
+                self.free(ptr, layout.size(), layout.align());
+            }
+        }
+        new_ptr
     }
 }
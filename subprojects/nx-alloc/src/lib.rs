@@ -1,11 +1,19 @@
 //! # nx-alloc
 #![no_std]
+#![cfg_attr(feature = "allocator-api", feature(allocator_api))]
 
 extern crate nx_panic_handler as _; // provides #[panic_handler]
 
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+pub mod arena;
 pub mod global;
 pub mod llffalloc;
+pub mod pool;
+pub mod stats;
 mod sync;
+#[cfg(feature = "thread-cache")]
+mod tcache;
+#[cfg(feature = "tlsf")]
+pub mod tlsf;
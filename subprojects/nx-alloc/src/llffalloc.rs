@@ -4,6 +4,14 @@
 //! It is used to allocate memory for the entire program.
 //!
 //! It is based on the [linked_list_allocator](https://github.com/rust-osdev/linked_list_allocator) crate.
+//!
+//! With the `tlsf` feature enabled the first-fit list is replaced by the [`crate::tlsf`]
+//! backend, which bounds `malloc`/`free` latency independently of heap fragmentation.
+//!
+//! By default the SVC-backed heap claims nearly all available memory at initialization.
+//! With the `growable-heap` feature it starts at [`GROWABLE_INITIAL_HEAP_SIZE`] and grows in
+//! `SetHeapSize` steps on demand, leaving the remaining memory to transfer memory, NV maps
+//! and shared memory until the heap actually needs it.
 use core::{
     alloc::Layout,
     ffi::{c_char, c_void},
@@ -15,24 +23,77 @@ use nx_svc::{
     misc::{get_total_memory_size, get_used_memory_size},
 };
 
-/// A wrapper around the linked list allocator that provides
+#[cfg(feature = "tlsf")]
+use crate::tlsf;
+
+/// Heap backend selected at compile time.
+#[cfg(not(feature = "tlsf"))]
+type InnerHeap = linked_list_allocator::Heap;
+#[cfg(feature = "tlsf")]
+type InnerHeap = tlsf::Tlsf;
+
+/// `SetHeapSize` size granularity.
+const HEAP_SIZE_ALIGN: usize = 0x200_000;
+
+/// Initial SVC heap size with the `growable-heap` feature.
+pub const GROWABLE_INITIAL_HEAP_SIZE: usize = HEAP_SIZE_ALIGN * 4;
+
+/// Extra room requested on growth to cover the backend's block headers and padding.
+#[cfg(feature = "growable-heap")]
+const GROWTH_SLACK: usize = 0x100;
+
+/// A wrapper around the heap backend that provides
 /// a lazy initialization mechanism for the heap.
-pub struct Heap(Option<linked_list_allocator::Heap>);
+pub struct Heap {
+    inner: Option<InnerHeap>,
+    /// Size committed through `SetHeapSize`, `0` if the heap is not SVC-backed.
+    svc_heap_size: usize,
+}
 
 impl Heap {
     /// Create a new allocator with an uninitialized heap.
     pub const fn new_uninit() -> Self {
-        Self(None)
+        Self {
+            inner: None,
+            svc_heap_size: 0,
+        }
     }
 
     /// Returns `true` if the heap has been initialized.
     pub fn is_initialized(&self) -> bool {
-        self.0.is_some()
+        self.inner.is_some()
+    }
+
+    /// Returns the size of the managed heap in bytes, `0` if uninitialized.
+    pub fn size(&self) -> usize {
+        self.inner.as_ref().map_or(0, InnerHeap::size)
+    }
+
+    /// Returns the heap bytes held by used blocks, including backend overhead.
+    pub fn used(&self) -> usize {
+        self.inner.as_ref().map_or(0, InnerHeap::used)
+    }
+
+    /// Returns the heap bytes not held by used blocks.
+    pub fn free_size(&self) -> usize {
+        self.inner.as_ref().map_or(0, InnerHeap::free)
+    }
+
+    /// Returns the size of the largest free block.
+    ///
+    /// Only the `tlsf` backend tracks free blocks by size; the first-fit backend returns `0`.
+    pub fn largest_free_block(&self) -> usize {
+        #[cfg(feature = "tlsf")]
+        return self.inner.as_ref().map_or(0, InnerHeap::largest_free_block);
+        #[cfg(not(feature = "tlsf"))]
+        return 0;
     }
 
     /// Initialize the heap using SVC memory allocation.
     pub fn init(&mut self) {
-        self.0 = Some(init_inner_heap());
+        let (heap, heap_size) = init_inner_heap();
+        self.inner = Some(heap);
+        self.svc_heap_size = heap_size;
     }
 
     /// Initialize the heap with a pre-allocated memory region.
@@ -43,7 +104,8 @@ impl Heap {
     /// - `addr` points to a valid, owned memory region of at least `size` bytes
     /// - The memory region will remain valid for the lifetime of the allocator
     pub unsafe fn init_with_heap_override(&mut self, addr: NonNull<c_void>, size: usize) {
-        self.0 = Some(unsafe { linked_list_allocator::Heap::new(addr.as_ptr() as *mut u8, size) });
+        self.inner = Some(unsafe { InnerHeap::new(addr.as_ptr() as *mut u8, size) });
+        self.svc_heap_size = 0;
     }
 
     /// Allocate memory from the heap.
@@ -59,11 +121,21 @@ impl Heap {
             return ptr::null_mut();
         };
 
-        let heap = self.0.get_or_insert_with(init_inner_heap);
-        match heap.allocate_first_fit(layout) {
-            Ok(nn) => nn.as_ptr(),
-            Err(_) => ptr::null_mut(),
+        if let Some(nn) = inner_allocate(self.inner_mut(), layout) {
+            return nn.as_ptr();
         }
+
+        #[cfg(feature = "growable-heap")]
+        {
+            if let Some(min_bytes) = growth_for(layout)
+                && self.grow(min_bytes)
+                && let Some(nn) = inner_allocate(self.inner_mut(), layout)
+            {
+                return nn.as_ptr();
+            }
+        }
+
+        ptr::null_mut()
     }
 
     /// Free memory to the heap.
@@ -79,20 +151,240 @@ impl Heap {
             return;
         };
 
-        let heap = self.0.get_or_insert_with(init_inner_heap);
+        let heap = self.inner_mut();
         let layout = unsafe { Layout::from_size_align_unchecked(size, align) };
-        unsafe { heap.deallocate(ptr, layout) };
+        unsafe { inner_deallocate(heap, ptr, layout) };
+    }
+
+    /// Resize an allocation without moving it.
+    ///
+    /// Growing absorbs the adjacent free block and shrinking returns the tail to the heap.
+    /// Returns `false`, leaving the allocation untouched, if the block cannot be resized in
+    /// place; the caller must then fall back to allocate-copy-free. Only the `tlsf` backend
+    /// supports in-place resizing, the first-fit backend always returns `false`.
+    ///
+    /// # Safety
+    ///
+    /// The caller must ensure that:
+    /// - `ptr` was previously allocated by this allocator with `old_size` and `align`
+    /// - `ptr` has not been freed already
+    /// - `new_size` and `align` form a valid layout
+    pub unsafe fn resize_in_place(
+        &mut self,
+        ptr: NonNull<u8>,
+        old_size: usize,
+        new_size: usize,
+        align: usize,
+    ) -> bool {
+        let Some(heap) = self.inner.as_mut() else {
+            return false;
+        };
+
+        // SAFETY: The caller guarantees `ptr` is a live allocation of this heap.
+        unsafe { inner_resize_in_place(heap, ptr, old_size, new_size, align) }
+    }
+
+    /// Release trailing free heap memory back to the kernel.
+    ///
+    /// The SVC heap is shrunk in `SetHeapSize` steps, never below
+    /// [`GROWABLE_INITIAL_HEAP_SIZE`]. Returns the number of bytes released. Only a
+    /// `growable-heap` heap using the `tlsf` backend can be trimmed; otherwise this is a
+    /// no-op returning `0`.
+    pub fn trim(&mut self) -> usize {
+        #[cfg(all(feature = "growable-heap", feature = "tlsf"))]
+        {
+            let Some(heap) = self.inner.as_mut() else {
+                return 0;
+            };
+            if self.svc_heap_size <= GROWABLE_INITIAL_HEAP_SIZE {
+                return 0;
+            }
+
+            let release = (heap.trailing_free_size() & !(HEAP_SIZE_ALIGN - 1))
+                .min(self.svc_heap_size - GROWABLE_INITIAL_HEAP_SIZE);
+            if release == 0 {
+                return 0;
+            }
+
+            // The backend may round the amount down to keep a whole trailing block; the SVC
+            // heap can only shrink in whole steps, so undo a partial shrink
+            let removed = heap.shrink(release);
+            if removed != release {
+                // SAFETY: The removed range is still committed and owned by us.
+                unsafe { heap.extend(removed) };
+                return 0;
+            }
+
+            let new_size = self.svc_heap_size - release;
+            if set_heap_size(new_size).is_err() {
+                // SAFETY: The region above the heap top is still committed.
+                unsafe { heap.extend(release) };
+                return 0;
+            }
+
+            self.svc_heap_size = new_size;
+            return release;
+        }
+
+        #[cfg(not(all(feature = "growable-heap", feature = "tlsf")))]
+        0
+    }
+
+    /// Grow the SVC heap by at least `min_bytes`, rounded up to `SetHeapSize` steps.
+    ///
+    /// Returns `false` if the heap is not SVC-backed or the kernel refused the new size.
+    #[cfg(feature = "growable-heap")]
+    #[cold]
+    fn grow(&mut self, min_bytes: usize) -> bool {
+        if self.svc_heap_size == 0 {
+            return false;
+        }
+
+        let Some(new_size) = self
+            .svc_heap_size
+            .checked_add(min_bytes)
+            .and_then(|size| size.checked_add(HEAP_SIZE_ALIGN - 1))
+            .map(|size| size & !(HEAP_SIZE_ALIGN - 1))
+        else {
+            return false;
+        };
+
+        // The kernel keeps the heap base fixed, so the new memory directly follows the top
+        if set_heap_size(new_size).is_err() {
+            return false;
+        }
+
+        let by = new_size - self.svc_heap_size;
+        self.svc_heap_size = new_size;
+
+        // SAFETY: `[top, top + by)` was just committed by the kernel and is owned by us.
+        unsafe { self.inner_mut().extend(by) };
+        true
+    }
+
+    /// Returns the backend heap, initializing it via SVC on first use.
+    #[inline]
+    fn inner_mut(&mut self) -> &mut InnerHeap {
+        if self.inner.is_none() {
+            self.init();
+        }
+
+        match self.inner.as_mut() {
+            Some(heap) => heap,
+            None => unreachable!("heap initialized above"),
+        }
+    }
+}
+
+/// Returns the number of bytes the heap must grow by for `layout` to fit once it is full.
+#[cfg(all(feature = "growable-heap", not(feature = "tlsf")))]
+#[inline]
+fn growth_for(layout: Layout) -> Option<usize> {
+    layout
+        .size()
+        .checked_add(layout.align())?
+        .checked_add(GROWTH_SLACK)
+}
+
+/// Returns the number of bytes the heap must grow by for `layout` to fit once it is full.
+///
+/// The TLSF search rounds the request up to its size class, so growing by the request size
+/// alone leaves large allocations failing right after the kernel committed the memory.
+#[cfg(all(feature = "growable-heap", feature = "tlsf"))]
+#[inline]
+fn growth_for(layout: Layout) -> Option<usize> {
+    InnerHeap::min_extension_for(layout)?.checked_add(GROWTH_SLACK)
+}
+
+/// Allocate a block for `layout` from the backend.
+#[cfg(not(feature = "tlsf"))]
+#[inline]
+fn inner_allocate(heap: &mut InnerHeap, layout: Layout) -> Option<NonNull<u8>> {
+    heap.allocate_first_fit(layout).ok()
+}
+
+/// Allocate a block for `layout` from the backend.
+#[cfg(feature = "tlsf")]
+#[inline]
+fn inner_allocate(heap: &mut InnerHeap, layout: Layout) -> Option<NonNull<u8>> {
+    heap.allocate(layout)
+}
+
+/// Return a block to the backend.
+///
+/// # Safety
+///
+/// `ptr` must have been allocated from `heap` with `layout` and not freed since.
+#[cfg(not(feature = "tlsf"))]
+#[inline]
+unsafe fn inner_deallocate(heap: &mut InnerHeap, ptr: NonNull<u8>, layout: Layout) {
+    // SAFETY: The caller guarantees `ptr` was allocated from `heap` with `layout`.
+    unsafe { heap.deallocate(ptr, layout) }
+}
+
+/// Return a block to the backend.
+///
+/// # Safety
+///
+/// `ptr` must have been allocated from `heap` and not freed since.
+#[cfg(feature = "tlsf")]
+#[inline]
+unsafe fn inner_deallocate(heap: &mut InnerHeap, ptr: NonNull<u8>, _layout: Layout) {
+    // SAFETY: The caller guarantees `ptr` was allocated from `heap`.
+    unsafe { heap.deallocate(ptr) }
+}
+
+/// Resize a block without moving it.
+///
+/// # Safety
+///
+/// `ptr` must have been allocated from `heap` with `old_size` and `align`.
+#[cfg(not(feature = "tlsf"))]
+#[inline]
+unsafe fn inner_resize_in_place(
+    _heap: &mut InnerHeap,
+    _ptr: NonNull<u8>,
+    _old_size: usize,
+    _new_size: usize,
+    _align: usize,
+) -> bool {
+    // The first-fit list does not expose its holes; always fall back to moving
+    false
+}
+
+/// Resize a block without moving it.
+///
+/// # Safety
+///
+/// `ptr` must have been allocated from `heap` with `old_size` and `align`.
+#[cfg(feature = "tlsf")]
+#[inline]
+unsafe fn inner_resize_in_place(
+    heap: &mut InnerHeap,
+    ptr: NonNull<u8>,
+    old_size: usize,
+    new_size: usize,
+    _align: usize,
+) -> bool {
+    if new_size > old_size {
+        // SAFETY: The caller guarantees `ptr` is a live block of `heap`.
+        unsafe { heap.grow_in_place(ptr, new_size) }
+    } else {
+        // SAFETY: The caller guarantees `ptr` is a live block of `heap` holding at least
+        // `old_size >= new_size` bytes.
+        unsafe { heap.shrink_in_place(ptr, new_size) };
+        true
     }
 }
 
 /// Initialize the heap via SVC memory allocation.
 ///
 /// This function allocates heap memory using the kernel's SetHeapSize SVC.
-/// It is either called by the `init` function or when the heap is first used.
-fn init_inner_heap() -> linked_list_allocator::Heap {
+/// It is either called by the `init` function or when the heap is first used. Returns the
+/// backend heap together with the size committed through `SetHeapSize`.
+fn init_inner_heap() -> (InnerHeap, usize) {
     // Default heap size if not specified (0x2000000 * 16)
     const DEFAULT_HEAP_SIZE: usize = 0x2_000_000 * 16;
-    const HEAP_SIZE_ALIGN: usize = 0x200_000;
 
     // Try to get total and used memory to determine heap size
     let mem_available = get_total_memory_size().unwrap_or(0);
@@ -107,6 +399,11 @@ fn init_inner_heap() -> linked_list_allocator::Heap {
         heap_size = DEFAULT_HEAP_SIZE;
     }
 
+    // Start small and let the heap grow on demand
+    if cfg!(feature = "growable-heap") {
+        heap_size = heap_size.min(GROWABLE_INITIAL_HEAP_SIZE);
+    }
+
     // Actually allocate the heap
     let heap_bottom = match set_heap_size(heap_size) {
         Ok(heap_addr) => heap_addr as *mut c_char,
@@ -116,5 +413,6 @@ fn init_inner_heap() -> linked_list_allocator::Heap {
     };
 
     // SAFETY: The kernel guarantees this region is valid and owned by us.
-    unsafe { linked_list_allocator::Heap::new(heap_bottom, heap_size) }
+    let heap = unsafe { InnerHeap::new(heap_bottom.cast(), heap_size) };
+    (heap, heap_size)
 }
@@ -0,0 +1,348 @@
+//! # Fixed-size object pool
+//!
+//! A lock-free pool of equally sized blocks for objects that are allocated and freed at
+//! high rates (IPC handles, channel state, ...).
+//!
+//! Free blocks form an intrusive singly linked list whose head is a tagged pointer: the
+//! upper [`TAG_BITS`] bits of the head word hold a counter bumped by every push and pop,
+//! which defeats the ABA problem of a plain Treiber stack. Blocks are carved out of slabs
+//! taken from the global heap; slabs are only returned to the heap when the pool is
+//! dropped, so a stale `next` read during a racing pop always hits valid memory.
+//!
+//! Only refilling an exhausted pool touches the global heap lock.
+
+use core::{
+    marker::PhantomData,
+    mem,
+    ptr::{self, NonNull},
+    sync::atomic::{AtomicPtr, AtomicUsize, Ordering},
+};
+
+use crate::global;
+
+/// Number of low pointer bits stored in the tagged head.
+const PTR_BITS: u32 = 48;
+
+/// Number of tag bits stored above the pointer in the tagged head.
+pub const TAG_BITS: u32 = usize::BITS - PTR_BITS;
+
+/// Mask of the pointer bits of the tagged head.
+const PTR_MASK: usize = (1 << PTR_BITS) - 1;
+
+/// Minimum size of a slab.
+const SLAB_SIZE: usize = 0x4000;
+
+/// Alignment and size granularity of slabs.
+const SLAB_ALIGN: usize = 0x1000;
+
+/// Minimum number of blocks per slab.
+const MIN_BLOCKS_PER_SLAB: usize = 8;
+
+/// A typed, lock-free pool of `T` slots.
+///
+/// Suitable for `static` use. Values still allocated when the pool is dropped are leaked
+/// (not dropped); the pool's memory is released regardless.
+pub struct Pool<T> {
+    raw: RawPool,
+    _marker: PhantomData<T>,
+}
+
+// SAFETY: The pool only hands out slots; moving `T` values across threads through it
+// requires `T: Send`.
+unsafe impl<T: Send> Send for Pool<T> {}
+// SAFETY: All shared state is accessed atomically.
+unsafe impl<T: Send> Sync for Pool<T> {}
+
+impl<T> Pool<T> {
+    /// Creates an empty pool. No memory is allocated until the first allocation.
+    pub const fn new() -> Self {
+        Self {
+            raw: RawPool::new(mem::size_of::<T>(), mem::align_of::<T>()),
+            _marker: PhantomData,
+        }
+    }
+
+    /// Moves `value` into a pool slot.
+    ///
+    /// Returns the value back if the pool is exhausted and the global heap cannot provide
+    /// a new slab.
+    #[inline]
+    pub fn alloc(&self, value: T) -> Result<NonNull<T>, T> {
+        let Some(ptr) = self.raw.alloc() else {
+            return Err(value);
+        };
+
+        let ptr = ptr.cast::<T>();
+        // SAFETY: The slot is free, large enough and aligned for `T`.
+        unsafe { ptr.as_ptr().write(value) };
+        Ok(ptr)
+    }
+
+    /// Drops the value in a slot and returns the slot to the pool.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been returned by [`Pool::alloc`] on this pool and not released since.
+    #[inline]
+    pub unsafe fn free(&self, ptr: NonNull<T>) {
+        // SAFETY: The caller guarantees `ptr` is a live slot of this pool.
+        unsafe {
+            ptr::drop_in_place(ptr.as_ptr());
+            self.raw.free(ptr.cast());
+        }
+    }
+
+    /// Moves the value out of a slot and returns the slot to the pool.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been returned by [`Pool::alloc`] on this pool and not released since.
+    #[inline]
+    pub unsafe fn take(&self, ptr: NonNull<T>) -> T {
+        // SAFETY: The caller guarantees `ptr` is a live slot of this pool.
+        unsafe {
+            let value = ptr.as_ptr().read();
+            self.raw.free(ptr.cast());
+            value
+        }
+    }
+}
+
+impl<T> Default for Pool<T> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// An untyped, lock-free pool of fixed-size blocks.
+pub struct RawPool {
+    /// Tagged pointer to the first free block.
+    head: AtomicUsize,
+    /// Singly linked list of the slabs owned by the pool.
+    slabs: AtomicPtr<Slab>,
+    /// Size of a block, at least one pointer.
+    block_size: usize,
+    /// Alignment of a block, at least pointer alignment.
+    block_align: usize,
+}
+
+impl RawPool {
+    /// Creates an empty pool of blocks of `size` bytes aligned to `align`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `align` is not a power of two.
+    pub const fn new(size: usize, align: usize) -> Self {
+        assert!(
+            align.is_power_of_two(),
+            "pool alignment must be a power of two"
+        );
+
+        let block_align = if align < mem::align_of::<FreeBlock>() {
+            mem::align_of::<FreeBlock>()
+        } else {
+            align
+        };
+        let block_size = if size < mem::size_of::<FreeBlock>() {
+            mem::size_of::<FreeBlock>()
+        } else {
+            size
+        };
+
+        Self {
+            head: AtomicUsize::new(0),
+            slabs: AtomicPtr::new(ptr::null_mut()),
+            block_size: (block_size + block_align - 1) & !(block_align - 1),
+            block_align,
+        }
+    }
+
+    /// Returns the size of the pool's blocks.
+    pub fn block_size(&self) -> usize {
+        self.block_size
+    }
+
+    /// Pops a free block, refilling the pool from the global heap if empty.
+    ///
+    /// Returns `None` if the global heap is exhausted.
+    #[inline]
+    pub fn alloc(&self) -> Option<NonNull<u8>> {
+        loop {
+            if let Some(block) = self.pop() {
+                return Some(block.cast());
+            }
+            if !self.refill() {
+                return None;
+            }
+        }
+    }
+
+    /// Returns a block to the pool.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been returned by [`RawPool::alloc`] on this pool and not released
+    /// since.
+    #[inline]
+    pub unsafe fn free(&self, ptr: NonNull<u8>) {
+        let block = ptr.cast::<FreeBlock>().as_ptr();
+        // SAFETY: The caller guarantees the block belongs to this pool and is unused.
+        unsafe { self.push_chain(block, block) };
+    }
+
+    /// Pops the first free block.
+    #[inline]
+    fn pop(&self) -> Option<NonNull<FreeBlock>> {
+        let mut head = self.head.load(Ordering::Acquire);
+        loop {
+            let block = untag(head);
+            let block = NonNull::new(block)?;
+
+            // SAFETY: Slabs outlive every concurrent access, so the read is always to
+            // valid memory; a stale `next` is rejected by the tagged CAS below.
+            let next = unsafe { ptr::addr_of!((*block.as_ptr()).next).read_volatile() };
+            let new_head = tag(next, next_tag(head));
+
+            match self.head.compare_exchange_weak(
+                head,
+                new_head,
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => return Some(block),
+                Err(current) => head = current,
+            }
+        }
+    }
+
+    /// Pushes the chain `first..=last` (linked through `next`) onto the free list.
+    ///
+    /// # Safety
+    ///
+    /// The chain must consist of unused blocks of this pool, linked from `first` to `last`.
+    #[inline]
+    unsafe fn push_chain(&self, first: *mut FreeBlock, last: *mut FreeBlock) {
+        let mut head = self.head.load(Ordering::Relaxed);
+        loop {
+            // SAFETY: The caller guarantees `last` is an unused block of this pool.
+            unsafe { (*last).next = untag(head) };
+            let new_head = tag(first, next_tag(head));
+
+            match self.head.compare_exchange_weak(
+                head,
+                new_head,
+                Ordering::Release,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => return,
+                Err(current) => head = current,
+            }
+        }
+    }
+
+    /// Allocates a new slab and pushes its blocks onto the free list.
+    #[cold]
+    fn refill(&self) -> bool {
+        let data_offset = align_up(mem::size_of::<Slab>(), self.block_align);
+        let min_size = data_offset + self.block_size * MIN_BLOCKS_PER_SLAB;
+        let slab_size = align_up(min_size.max(SLAB_SIZE), SLAB_ALIGN);
+        let slab_align = self.block_align.max(SLAB_ALIGN);
+
+        // SAFETY: `slab_size` is non-zero and `slab_align` a power of two.
+        let slab = unsafe { global::malloc(slab_size, slab_align) }.cast::<Slab>();
+        if slab.is_null() {
+            return false;
+        }
+
+        let count = (slab_size - data_offset) / self.block_size;
+        let base = slab as usize + data_offset;
+
+        // SAFETY: The slab is a fresh block of `slab_size` bytes; every block lies inside it.
+        unsafe {
+            slab.write(Slab {
+                next: ptr::null_mut(),
+                size: slab_size,
+                align: slab_align,
+            });
+            for i in 0..count - 1 {
+                let block = (base + i * self.block_size) as *mut FreeBlock;
+                (*block).next = (base + (i + 1) * self.block_size) as *mut FreeBlock;
+            }
+        }
+
+        // Register the slab for release on drop
+        let mut slabs = self.slabs.load(Ordering::Relaxed);
+        loop {
+            // SAFETY: The slab header was initialized above.
+            unsafe { (*slab).next = slabs };
+            match self.slabs.compare_exchange_weak(
+                slabs,
+                slab,
+                Ordering::Release,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => break,
+                Err(current) => slabs = current,
+            }
+        }
+
+        let first = base as *mut FreeBlock;
+        let last = (base + (count - 1) * self.block_size) as *mut FreeBlock;
+        // SAFETY: The chain was linked above and no block has been handed out yet.
+        unsafe { self.push_chain(first, last) };
+        true
+    }
+}
+
+impl Drop for RawPool {
+    fn drop(&mut self) {
+        let mut slab = *self.slabs.get_mut();
+        while !slab.is_null() {
+            // SAFETY: Every slab was allocated by `refill` with the recorded layout and is
+            // released exactly once.
+            unsafe {
+                let next = (*slab).next;
+                global::free(slab.cast(), (*slab).size, (*slab).align);
+                slab = next;
+            }
+        }
+    }
+}
+
+/// Header at the start of every slab.
+#[repr(C)]
+struct Slab {
+    next: *mut Slab,
+    size: usize,
+    align: usize,
+}
+
+/// A free block, linked into the pool's free list.
+#[repr(C)]
+struct FreeBlock {
+    next: *mut FreeBlock,
+}
+
+/// Packs a block pointer and an ABA tag into a head word.
+#[inline]
+fn tag(ptr: *mut FreeBlock, tag: usize) -> usize {
+    debug_assert!(ptr as usize & !PTR_MASK == 0, "pointer exceeds tagged bits");
+    (ptr as usize & PTR_MASK) | (tag << PTR_BITS)
+}
+
+/// Extracts the block pointer of a head word.
+#[inline]
+fn untag(head: usize) -> *mut FreeBlock {
+    (head & PTR_MASK) as *mut FreeBlock
+}
+
+/// Returns the tag of the head word following `head`.
+#[inline]
+fn next_tag(head: usize) -> usize {
+    (head >> PTR_BITS).wrapping_add(1) & ((1 << TAG_BITS) - 1)
+}
+
+#[inline]
+const fn align_up(value: usize, align: usize) -> usize {
+    (value + align - 1) & !(align - 1)
+}
@@ -0,0 +1,148 @@
+//! # Allocator statistics
+//!
+//! Lock-free counters updated on every allocator call when the `stats` feature is enabled.
+//!
+//! The counters track requested sizes (as seen by [`crate::global::malloc`]), not backend
+//! block sizes, so `live_bytes` excludes per-block headers and padding. Backend figures
+//! (heap size, free bytes, largest free block) are sampled from the heap under its lock
+//! when a snapshot is taken.
+
+use core::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+
+/// Number of allocation size histogram bins.
+///
+/// Bin `0` counts allocations of up to 16 bytes, bin `n` those in `(8 << n, 16 << n]`, and
+/// the last bin everything larger.
+pub const SIZE_HISTOGRAM_BINS: usize = 16;
+
+/// Snapshot of the allocator statistics.
+///
+/// Mirrors `NxAllocStats` in `nx_alloc.h`.
+#[derive(Debug, Default, Clone, Copy)]
+#[repr(C)]
+pub struct Stats {
+    /// Total size of the managed heap in bytes.
+    pub heap_size: usize,
+    /// Heap bytes held by used blocks, including backend overhead.
+    pub heap_used: usize,
+    /// Heap bytes not held by used blocks.
+    pub heap_free: usize,
+    /// Size of the largest free block, or `0` if the backend cannot report it.
+    pub largest_free_block: usize,
+    /// Requested bytes currently allocated.
+    pub live_bytes: usize,
+    /// Maximum value reached by `live_bytes`.
+    pub peak_live_bytes: usize,
+    /// Successful allocations.
+    pub alloc_count: u64,
+    /// Deallocations.
+    pub free_count: u64,
+    /// Failed allocations.
+    pub alloc_failures: u64,
+    /// Reallocation requests.
+    pub realloc_count: u64,
+    /// Reallocations served without moving the block.
+    pub realloc_in_place_count: u64,
+    /// Heap lock acquisitions.
+    pub lock_acquisitions: u64,
+    /// Heap lock acquisitions that found the lock held and had to wait.
+    pub lock_contentions: u64,
+    /// Successful allocations per size bin (see [`SIZE_HISTOGRAM_BINS`]).
+    pub size_histogram: [u64; SIZE_HISTOGRAM_BINS],
+}
+
+static LIVE_BYTES: AtomicUsize = AtomicUsize::new(0);
+static PEAK_LIVE_BYTES: AtomicUsize = AtomicUsize::new(0);
+static ALLOC_COUNT: AtomicU64 = AtomicU64::new(0);
+static FREE_COUNT: AtomicU64 = AtomicU64::new(0);
+static ALLOC_FAILURES: AtomicU64 = AtomicU64::new(0);
+static REALLOC_COUNT: AtomicU64 = AtomicU64::new(0);
+static REALLOC_IN_PLACE_COUNT: AtomicU64 = AtomicU64::new(0);
+static LOCK_ACQUISITIONS: AtomicU64 = AtomicU64::new(0);
+static LOCK_CONTENTIONS: AtomicU64 = AtomicU64::new(0);
+static SIZE_HISTOGRAM: [AtomicU64; SIZE_HISTOGRAM_BINS] =
+    [const { AtomicU64::new(0) }; SIZE_HISTOGRAM_BINS];
+
+/// Records the outcome of an allocation of `size` bytes.
+#[inline]
+pub fn record_alloc(size: usize, ptr: *mut u8) {
+    if ptr.is_null() {
+        ALLOC_FAILURES.fetch_add(1, Ordering::Relaxed);
+        return;
+    }
+
+    ALLOC_COUNT.fetch_add(1, Ordering::Relaxed);
+    SIZE_HISTOGRAM[size_bin(size)].fetch_add(1, Ordering::Relaxed);
+    add_live(size);
+}
+
+/// Records the deallocation of `size` bytes.
+#[inline]
+pub fn record_free(size: usize) {
+    FREE_COUNT.fetch_add(1, Ordering::Relaxed);
+    LIVE_BYTES.fetch_sub(size, Ordering::Relaxed);
+}
+
+/// Records a reallocation request and whether it was served in place.
+#[inline]
+pub fn record_realloc(old_size: usize, new_size: usize, in_place: bool) {
+    REALLOC_COUNT.fetch_add(1, Ordering::Relaxed);
+    if !in_place {
+        return;
+    }
+
+    REALLOC_IN_PLACE_COUNT.fetch_add(1, Ordering::Relaxed);
+    if new_size >= old_size {
+        add_live(new_size - old_size);
+    } else {
+        LIVE_BYTES.fetch_sub(old_size - new_size, Ordering::Relaxed);
+    }
+}
+
+/// Records a heap lock acquisition.
+#[inline]
+pub fn record_lock(contended: bool) {
+    LOCK_ACQUISITIONS.fetch_add(1, Ordering::Relaxed);
+    if contended {
+        LOCK_CONTENTIONS.fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+/// Fills the counter fields of `stats`, leaving the backend fields untouched.
+pub fn snapshot_counters(stats: &mut Stats) {
+    stats.live_bytes = LIVE_BYTES.load(Ordering::Relaxed);
+    stats.peak_live_bytes = PEAK_LIVE_BYTES.load(Ordering::Relaxed);
+    stats.alloc_count = ALLOC_COUNT.load(Ordering::Relaxed);
+    stats.free_count = FREE_COUNT.load(Ordering::Relaxed);
+    stats.alloc_failures = ALLOC_FAILURES.load(Ordering::Relaxed);
+    stats.realloc_count = REALLOC_COUNT.load(Ordering::Relaxed);
+    stats.realloc_in_place_count = REALLOC_IN_PLACE_COUNT.load(Ordering::Relaxed);
+    stats.lock_acquisitions = LOCK_ACQUISITIONS.load(Ordering::Relaxed);
+    stats.lock_contentions = LOCK_CONTENTIONS.load(Ordering::Relaxed);
+    for (out, bin) in stats.size_histogram.iter_mut().zip(SIZE_HISTOGRAM.iter()) {
+        *out = bin.load(Ordering::Relaxed);
+    }
+}
+
+/// Resets the peak to the current live bytes.
+pub fn reset_peak() {
+    PEAK_LIVE_BYTES.store(LIVE_BYTES.load(Ordering::Relaxed), Ordering::Relaxed);
+}
+
+#[inline]
+fn add_live(size: usize) {
+    let live = LIVE_BYTES.fetch_add(size, Ordering::Relaxed) + size;
+    PEAK_LIVE_BYTES.fetch_max(live, Ordering::Relaxed);
+}
+
+/// Returns the histogram bin of an allocation of `size` bytes.
+#[inline]
+fn size_bin(size: usize) -> usize {
+    if size <= 16 {
+        return 0;
+    }
+
+    // ceil(log2(size)) - 4
+    let bin = (usize::BITS - (size - 1).leading_zeros()) as usize - 4;
+    bin.min(SIZE_HISTOGRAM_BINS - 1)
+}
@@ -8,8 +8,10 @@ use core::cell::UnsafeCell;
 use nx_sys_sync as sys;
 
 /// A mutual exclusion primitive useful for protecting shared data.
+///
+/// Allocator critical sections are short, so the lock spins adaptively before parking.
 pub struct Mutex<T: ?Sized> {
-    inner: sys::Mutex,
+    inner: sys::AdaptiveMutex,
     data: UnsafeCell<T>,
 }
 
@@ -21,7 +23,7 @@ impl<T> Mutex<T> {
     #[inline]
     pub const fn new(data: T) -> Mutex<T> {
         Mutex {
-            inner: sys::Mutex::new(),
+            inner: sys::AdaptiveMutex::new(),
             data: UnsafeCell::new(data),
         }
     }
@@ -30,10 +32,18 @@ impl<T> Mutex<T> {
 impl<T: ?Sized> Mutex<T> {
     /// Acquires a mutex, blocking the current thread until it is able to do so.
     pub fn lock(&self) -> MutexGuard<'_, T> {
-        unsafe {
-            self.inner.lock();
-            MutexGuard::new(self)
+        #[cfg(feature = "stats")]
+        {
+            let contended = !self.inner.try_lock();
+            if contended {
+                self.inner.lock();
+            }
+            crate::stats::record_lock(contended);
         }
+        #[cfg(not(feature = "stats"))]
+        self.inner.lock();
+
+        unsafe { MutexGuard::new(self) }
     }
 }
 
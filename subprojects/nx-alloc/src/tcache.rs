@@ -0,0 +1,379 @@
+//! # Thread cache
+//!
+//! Per-thread free lists of small, fixed-size blocks placed in front of the global heap.
+//!
+//! Small requests (up to [`MAX_SIZE`] bytes, alignment up to [`MAX_ALIGN`]) are rounded up
+//! to one of [`NUM_CLASSES`] size classes. Each thread keeps an intrusive singly-linked free
+//! list per class, reached through a dynamic TLS slot, so the fast path is a TLS load plus a
+//! pointer pop/push and never touches the heap mutex.
+//!
+//! The heap lock is only taken to refill an empty list ([`REFILL_BATCH`] blocks at once) or
+//! to return [`FLUSH_BATCH`] blocks once a list grows past [`MAX_CACHED`].
+//!
+//! Blocks of a size class are always carved from the heap with the class layout
+//! (`class size`, [`MAX_ALIGN`]), whether they go through a cache or not, so a block may be
+//! allocated on one thread and freed on another.
+
+use core::{
+    mem, ptr,
+    sync::atomic::{AtomicUsize, Ordering},
+};
+
+use nx_sys_thread_tls::slots;
+
+use crate::{llffalloc::Heap, sync::Mutex};
+
+/// Largest request size served by the thread cache.
+pub const MAX_SIZE: usize = 512;
+
+/// Largest alignment served by the thread cache. Every class block is aligned to this.
+pub const MAX_ALIGN: usize = 16;
+
+/// Number of size classes.
+pub const NUM_CLASSES: usize = 16;
+
+/// Block sizes of each class: 16-byte steps up to 128, 32-byte steps up to 256 and
+/// 64-byte steps up to [`MAX_SIZE`].
+const CLASS_SIZES: [usize; NUM_CLASSES] = [
+    16, 32, 48, 64, 80, 96, 112, 128, // 16-byte steps
+    160, 192, 224, 256, // 32-byte steps
+    320, 384, 448, 512, // 64-byte steps
+];
+
+/// Number of blocks fetched from the heap when a free list is empty.
+const REFILL_BATCH: usize = 16;
+
+/// Maximum free list length before blocks are returned to the heap.
+const MAX_CACHED: usize = 64;
+
+/// Number of blocks returned to the heap when a free list overflows.
+const FLUSH_BATCH: usize = 32;
+
+/// The TLS slot holding each thread's [`ThreadCache`] pointer, encoded as `slot ID + 1`.
+///
+/// `0` means not yet reserved and [`SLOT_UNAVAILABLE`] means no slot could be reserved,
+/// in which case every request takes the locked path.
+static TLS_SLOT: AtomicUsize = AtomicUsize::new(0);
+
+/// Marker stored in [`TLS_SLOT`] when all TLS slots are taken.
+const SLOT_UNAVAILABLE: usize = usize::MAX;
+
+/// A size class of the thread cache.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SizeClass(usize);
+
+impl SizeClass {
+    /// Returns the size class serving the given layout, or `None` if the request is too
+    /// large or over-aligned for the thread cache.
+    #[inline]
+    pub fn for_layout(size: usize, align: usize) -> Option<Self> {
+        if size > MAX_SIZE || align > MAX_ALIGN {
+            return None;
+        }
+
+        let size = size.max(1);
+        let idx = if size <= 128 {
+            (size + 15) / 16 - 1
+        } else if size <= 256 {
+            8 + (size - 128 + 31) / 32 - 1
+        } else {
+            12 + (size - 256 + 63) / 64 - 1
+        };
+
+        Some(Self(idx))
+    }
+
+    /// Block size of this class in bytes.
+    #[inline]
+    pub fn size(&self) -> usize {
+        CLASS_SIZES[self.0]
+    }
+}
+
+/// Allocates a block of the given size class.
+///
+/// Pops from the current thread's free list, refilling it from the heap when empty. Falls
+/// back to a direct, locked heap allocation when the thread has no cache.
+///
+/// # Safety
+///
+/// `heap` must be the heap backing the global allocator; class blocks from different heaps
+/// must never be mixed in the same thread cache.
+pub unsafe fn alloc(heap: &Mutex<Heap>, class: SizeClass) -> *mut u8 {
+    let Some(cache) = current_cache(heap) else {
+        let mut heap = heap.lock();
+        // SAFETY: The class layout is a valid, non-zero size and power-of-two alignment.
+        return unsafe { heap.malloc(class.size(), MAX_ALIGN) };
+    };
+
+    // SAFETY: The cache pointer is owned by the current thread and valid until flushed.
+    let bin = unsafe { &mut (*cache).bins[class.0] };
+    if bin.is_empty() {
+        // SAFETY: The bin holds blocks of `class` only.
+        unsafe { bin.refill(heap, class) };
+    }
+
+    // SAFETY: Every block in the bin is an unused class block owned by this thread.
+    unsafe { bin.pop() }
+}
+
+/// Frees a block of the given size class.
+///
+/// Pushes onto the current thread's free list, returning a batch to the heap when the list
+/// is over [`MAX_CACHED`]. Falls back to a direct, locked heap free when the thread has no
+/// cache.
+///
+/// # Safety
+///
+/// - `ptr` must be a non-null block returned by [`alloc`] for the same `class`
+/// - `ptr` must not be used after this call
+/// - `heap` must be the same heap passed to [`alloc`]
+pub unsafe fn free(heap: &Mutex<Heap>, ptr: *mut u8, class: SizeClass) {
+    let Some(cache) = current_cache(heap) else {
+        let mut heap = heap.lock();
+        // SAFETY: The block was allocated with the class layout.
+        unsafe { heap.free(ptr, class.size(), MAX_ALIGN) };
+        return;
+    };
+
+    // SAFETY: The cache pointer is owned by the current thread and valid until flushed.
+    let bin = unsafe { &mut (*cache).bins[class.0] };
+
+    // SAFETY: The caller hands over ownership of an unused class block.
+    unsafe { bin.push(ptr) };
+
+    if bin.len > MAX_CACHED {
+        // SAFETY: The bin holds blocks of `class` only.
+        unsafe { bin.flush(heap, class, FLUSH_BATCH) };
+    }
+}
+
+/// Returns every block cached by the current thread, and the cache itself, to the heap.
+///
+/// Must be called before a thread exits, otherwise its cached blocks are leaked. A later
+/// allocation on the same thread transparently creates a new cache.
+pub fn flush_current(heap: &Mutex<Heap>) {
+    let Some(slot_id) = tls_slot_id() else {
+        return;
+    };
+
+    let cache = slots::get(slot_id).cast::<ThreadCache>();
+    if cache.is_null() {
+        return;
+    }
+
+    // SAFETY: The slot was reserved by this module and the stored value is replaced by
+    // null before the cache memory is released.
+    unsafe { slots::set(slot_id, ptr::null_mut()) };
+
+    let mut heap = heap.lock();
+    for (idx, class_size) in CLASS_SIZES.iter().enumerate() {
+        // SAFETY: The cache was detached from TLS so no other code can reach it.
+        let bin = unsafe { &mut (*cache).bins[idx] };
+        while !bin.is_empty() {
+            // SAFETY: Every block in the bin is an unused class block.
+            let block = unsafe { bin.pop() };
+            // SAFETY: The block was allocated with the class layout.
+            unsafe { heap.free(block, *class_size, MAX_ALIGN) };
+        }
+    }
+
+    // SAFETY: The cache was allocated in `current_cache` with the ThreadCache layout.
+    unsafe {
+        heap.free(
+            cache.cast(),
+            mem::size_of::<ThreadCache>(),
+            mem::align_of::<ThreadCache>(),
+        )
+    };
+}
+
+/// Returns the current thread's cache, creating it on first use.
+///
+/// Returns `None` if no TLS slot is available or the cache could not be allocated.
+#[inline]
+fn current_cache(heap: &Mutex<Heap>) -> Option<*mut ThreadCache> {
+    let slot_id = tls_slot_id()?;
+
+    let cache = slots::get(slot_id).cast::<ThreadCache>();
+    if !cache.is_null() {
+        return Some(cache);
+    }
+
+    create_cache(heap, slot_id)
+}
+
+/// Allocates and installs the current thread's cache.
+#[cold]
+fn create_cache(heap: &Mutex<Heap>, slot_id: usize) -> Option<*mut ThreadCache> {
+    let cache = {
+        let mut heap = heap.lock();
+        // SAFETY: The ThreadCache layout is valid and non-zero sized.
+        unsafe {
+            heap.malloc(
+                mem::size_of::<ThreadCache>(),
+                mem::align_of::<ThreadCache>(),
+            )
+        }
+        .cast::<ThreadCache>()
+    };
+    if cache.is_null() {
+        return None;
+    }
+
+    // SAFETY: `cache` is a fresh allocation sized and aligned for ThreadCache.
+    unsafe { cache.write(ThreadCache::new()) };
+
+    // SAFETY: The slot is reserved by this module and its value for this thread was null.
+    unsafe { slots::set(slot_id, cache.cast()) };
+
+    Some(cache)
+}
+
+/// Returns the TLS slot ID holding the cache pointer, reserving it on first use.
+#[inline]
+fn tls_slot_id() -> Option<usize> {
+    match TLS_SLOT.load(Ordering::Acquire) {
+        0 => reserve_tls_slot(),
+        SLOT_UNAVAILABLE => None,
+        encoded => Some(encoded - 1),
+    }
+}
+
+/// Reserves the process-wide TLS slot used by the thread cache.
+#[cold]
+fn reserve_tls_slot() -> Option<usize> {
+    let Some(slot_id) = slots::alloc() else {
+        // Another thread may have raced us to the last free slot: keep its result
+        let _ = TLS_SLOT.compare_exchange(0, SLOT_UNAVAILABLE, Ordering::AcqRel, Ordering::Acquire);
+        return tls_slot_id_after_race();
+    };
+
+    match TLS_SLOT.compare_exchange(0, slot_id + 1, Ordering::AcqRel, Ordering::Acquire) {
+        Ok(_) => Some(slot_id),
+        Err(_) => {
+            // Lost the race; give our slot back and use the winner's
+            // SAFETY: The slot was reserved above and never published.
+            unsafe { slots::free(slot_id) };
+            tls_slot_id_after_race()
+        }
+    }
+}
+
+/// Decodes [`TLS_SLOT`] once it has been settled by some thread.
+fn tls_slot_id_after_race() -> Option<usize> {
+    match TLS_SLOT.load(Ordering::Acquire) {
+        0 | SLOT_UNAVAILABLE => None,
+        encoded => Some(encoded - 1),
+    }
+}
+
+/// Per-thread cache state: one free list per size class.
+struct ThreadCache {
+    bins: [Bin; NUM_CLASSES],
+}
+
+impl ThreadCache {
+    const fn new() -> Self {
+        Self {
+            bins: [const { Bin::new() }; NUM_CLASSES],
+        }
+    }
+}
+
+/// Intrusive free list of class blocks.
+struct Bin {
+    head: *mut FreeBlock,
+    len: usize,
+}
+
+/// Free block header, written into the first word of each cached block.
+struct FreeBlock {
+    next: *mut FreeBlock,
+}
+
+impl Bin {
+    const fn new() -> Self {
+        Self {
+            head: ptr::null_mut(),
+            len: 0,
+        }
+    }
+
+    #[inline]
+    fn is_empty(&self) -> bool {
+        self.head.is_null()
+    }
+
+    /// Pops a block, returning null if the list is empty.
+    ///
+    /// # Safety
+    ///
+    /// Every block in the list must be a valid, unused class block.
+    #[inline]
+    unsafe fn pop(&mut self) -> *mut u8 {
+        let block = self.head;
+        if block.is_null() {
+            return ptr::null_mut();
+        }
+
+        // SAFETY: The caller guarantees the block holds a FreeBlock header.
+        self.head = unsafe { (*block).next };
+        self.len -= 1;
+        block.cast()
+    }
+
+    /// Pushes a block onto the list.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must be a valid, unused class block at least `size_of::<FreeBlock>()` bytes.
+    #[inline]
+    unsafe fn push(&mut self, ptr: *mut u8) {
+        let block = ptr.cast::<FreeBlock>();
+        // SAFETY: The caller guarantees the block is writable and suitably aligned.
+        unsafe { block.write(FreeBlock { next: self.head }) };
+        self.head = block;
+        self.len += 1;
+    }
+
+    /// Fetches up to [`REFILL_BATCH`] class blocks from the heap in one lock acquisition.
+    ///
+    /// # Safety
+    ///
+    /// The list must only hold blocks of `class`.
+    #[cold]
+    unsafe fn refill(&mut self, heap: &Mutex<Heap>, class: SizeClass) {
+        let mut heap = heap.lock();
+        for _ in 0..REFILL_BATCH {
+            // SAFETY: The class layout is a valid, non-zero size and power-of-two alignment.
+            let block = unsafe { heap.malloc(class.size(), MAX_ALIGN) };
+            if block.is_null() {
+                break;
+            }
+
+            // SAFETY: The block was just allocated with the class layout.
+            unsafe { self.push(block) };
+        }
+    }
+
+    /// Returns up to `count` blocks to the heap in one lock acquisition.
+    ///
+    /// # Safety
+    ///
+    /// The list must only hold blocks of `class`.
+    #[cold]
+    unsafe fn flush(&mut self, heap: &Mutex<Heap>, class: SizeClass, count: usize) {
+        let mut heap = heap.lock();
+        for _ in 0..count {
+            // SAFETY: Every block in the list is an unused class block.
+            let block = unsafe { self.pop() };
+            if block.is_null() {
+                break;
+            }
+
+            // SAFETY: The block was allocated with the class layout.
+            unsafe { heap.free(block, class.size(), MAX_ALIGN) };
+        }
+    }
+}
@@ -0,0 +1,783 @@
+//! # Two-Level Segregated Fit (TLSF) heap
+//!
+//! A good-fit allocator with O(1) `allocate` and `deallocate`, independent of the number of
+//! free blocks in the heap.
+//!
+//! Free blocks are kept in segregated lists indexed by a two-level size mapping: the first
+//! level splits sizes by powers of two and the second level subdivides each power of two
+//! into [`SL_COUNT`] linear ranges. A bitmap per level records which lists are non-empty, so
+//! finding a suitable list is a pair of bit scans instead of a list walk.
+//!
+//! Every block starts with a [`BlockHeader`] carrying its size and a pointer to the
+//! physically previous block. Adjacent free blocks are coalesced eagerly on free, so a free
+//! block is always surrounded by used blocks (or the heap sentinel).
+//!
+//! ```text
+//! ┌────────┬──────────────┬────────┬──────────────┬─ ─ ─┬──────────┐
+//! │ header │ payload      │ header │ payload      │     │ sentinel │
+//! └────────┴──────────────┴────────┴──────────────┴─ ─ ─┴──────────┘
+//! ```
+//!
+//! # References
+//!
+//! - [M. Masmano et al.: TLSF: a New Dynamic Memory Allocator for Real-Time Systems](http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf)
+
+use core::{alloc::Layout, mem, ptr, ptr::NonNull};
+
+/// Log2 of the block alignment.
+const ALIGN_LOG2: u32 = 4;
+
+/// Alignment of every block and payload.
+pub const ALIGN: usize = 1 << ALIGN_LOG2;
+
+/// Log2 of the number of second-level lists per first-level class.
+const SL_LOG2: u32 = 4;
+
+/// Number of second-level lists per first-level class.
+pub const SL_COUNT: usize = 1 << SL_LOG2;
+
+/// Sizes below `1 << FL_SHIFT` are all mapped linearly into first-level class 0.
+const FL_SHIFT: u32 = SL_LOG2 + ALIGN_LOG2;
+
+/// Log2 of the (exclusive) maximum block size.
+const FL_MAX_LOG2: u32 = 38;
+
+/// Number of first-level classes.
+pub const FL_COUNT: usize = (FL_MAX_LOG2 - FL_SHIFT + 1) as usize;
+
+/// Block sizes below this threshold share first-level class 0.
+const SMALL_BLOCK_SIZE: usize = 1 << FL_SHIFT;
+
+/// Exclusive upper bound of a block size.
+const MAX_BLOCK_SIZE: usize = 1 << FL_MAX_LOG2;
+
+/// Size of the header preceding every payload.
+const HEADER_SIZE: usize = mem::size_of::<BlockHeader>();
+
+/// Smallest block: a header plus room for the free-list links.
+const MIN_BLOCK_SIZE: usize = mem::size_of::<FreeBlock>();
+
+/// Block size flag: the block is free.
+const FREE_BIT: usize = 0b1;
+
+/// Mask of all flag bits stored in the low bits of the block size.
+const FLAGS_MASK: usize = ALIGN - 1;
+
+/// A TLSF heap over one or more contiguous memory regions.
+pub struct Tlsf {
+    /// Bit `fl` set if any list in first-level class `fl` is non-empty.
+    fl_bitmap: u64,
+    /// Bit `sl` of entry `fl` set if list `(fl, sl)` is non-empty.
+    sl_bitmap: [u32; FL_COUNT],
+    /// Free-list heads.
+    heads: [[*mut FreeBlock; SL_COUNT]; FL_COUNT],
+    /// Zero-sized, always-used block terminating the heap.
+    sentinel: *mut BlockHeader,
+    /// Start of the managed region.
+    bottom: usize,
+    /// Total managed size, including headers.
+    size: usize,
+    /// Bytes held by used blocks, including their headers.
+    used: usize,
+}
+
+// SAFETY: The heap owns its memory region; access is serialized by the caller.
+unsafe impl Send for Tlsf {}
+
+impl Tlsf {
+    /// Creates an empty heap that fails every allocation.
+    pub const fn empty() -> Self {
+        Self {
+            fl_bitmap: 0,
+            sl_bitmap: [0; FL_COUNT],
+            heads: [[ptr::null_mut(); SL_COUNT]; FL_COUNT],
+            sentinel: ptr::null_mut(),
+            bottom: 0,
+            size: 0,
+            used: 0,
+        }
+    }
+
+    /// Creates a heap managing the memory region `[heap_bottom, heap_bottom + heap_size)`.
+    ///
+    /// The region is trimmed to [`ALIGN`] boundaries. Regions too small to hold a single
+    /// block yield an empty heap.
+    ///
+    /// # Safety
+    ///
+    /// - The memory region must be valid, writable and owned by the heap
+    /// - The region must stay valid for the lifetime of the heap
+    pub unsafe fn new(heap_bottom: *mut u8, heap_size: usize) -> Self {
+        let mut heap = Self::empty();
+
+        let start = align_up(heap_bottom as usize, ALIGN);
+        let end = align_down((heap_bottom as usize).saturating_add(heap_size), ALIGN);
+        if end <= start || end - start < MIN_BLOCK_SIZE + HEADER_SIZE {
+            return heap;
+        }
+
+        let block_size = (end - start - HEADER_SIZE).min(align_down(MAX_BLOCK_SIZE - 1, ALIGN));
+        let block = start as *mut BlockHeader;
+        let sentinel = (start + block_size) as *mut BlockHeader;
+
+        // SAFETY: Both headers lie inside the owned, aligned region.
+        unsafe {
+            block.write(BlockHeader {
+                prev_phys: ptr::null_mut(),
+                size: block_size,
+            });
+            sentinel.write(BlockHeader {
+                prev_phys: block,
+                size: 0,
+            });
+        }
+
+        heap.sentinel = sentinel;
+        heap.bottom = start;
+        heap.size = block_size + HEADER_SIZE;
+
+        // SAFETY: `block` is a valid block header not present in any free list.
+        unsafe { heap.insert_free(block) };
+
+        heap
+    }
+
+    /// Returns the start address of the managed region.
+    pub fn bottom(&self) -> *mut u8 {
+        self.bottom as *mut u8
+    }
+
+    /// Returns the size of the managed region in bytes.
+    pub fn size(&self) -> usize {
+        self.size
+    }
+
+    /// Returns the end address (exclusive) of the managed region.
+    pub fn top(&self) -> *mut u8 {
+        (self.bottom + self.size) as *mut u8
+    }
+
+    /// Returns the bytes held by used blocks, including block headers.
+    pub fn used(&self) -> usize {
+        self.used
+    }
+
+    /// Returns the bytes not held by used blocks.
+    pub fn free(&self) -> usize {
+        self.size - self.used
+    }
+
+    /// Allocates a block for `layout`.
+    ///
+    /// Returns `None` if no free block is large enough.
+    pub fn allocate(&mut self, layout: Layout) -> Option<NonNull<u8>> {
+        let block_size = block_size_for(layout.size())?;
+        let align = layout.align();
+        let search_size = search_size_for(layout)?;
+
+        let mut block = self.take_suitable(search_size)?;
+
+        if align > ALIGN {
+            // SAFETY: `block` was just removed from a free list and is large enough to
+            // hold the gap and the aligned block.
+            block = unsafe { self.split_front_aligned(block, align) };
+        }
+
+        // SAFETY: `block` is detached from the free lists and at least `block_size` long.
+        unsafe {
+            self.trim_free_tail(block, block_size);
+            (*block).size &= !FREE_BIT;
+            self.used += block_size_of(block);
+        }
+
+        // SAFETY: The payload of a used block is non-null.
+        Some(unsafe { NonNull::new_unchecked(payload_of(block)) })
+    }
+
+    /// Frees a block previously returned by [`Tlsf::allocate`].
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been returned by this heap and not freed since.
+    pub unsafe fn deallocate(&mut self, ptr: NonNull<u8>) {
+        // SAFETY: The caller guarantees `ptr` is the payload of a live block.
+        unsafe {
+            let mut block = block_from_payload(ptr.as_ptr());
+            debug_assert!(!is_free(block), "double free");
+
+            self.used -= block_size_of(block);
+            (*block).size |= FREE_BIT;
+
+            block = self.merge_prev(block);
+            block = self.merge_next(block);
+            self.insert_free(block);
+        }
+    }
+
+    /// Grows the block holding `ptr` in place to at least `new_size` payload bytes by
+    /// absorbing the physically next block if it is free.
+    ///
+    /// Returns `false`, leaving the block untouched, if there is not enough adjacent free
+    /// space.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been returned by this heap and not freed since.
+    pub unsafe fn grow_in_place(&mut self, ptr: NonNull<u8>, new_size: usize) -> bool {
+        let Some(required) = block_size_for(payload_span(ptr, new_size)) else {
+            return false;
+        };
+
+        // SAFETY: The caller guarantees `ptr` is the payload of a live block.
+        unsafe {
+            let block = block_from_payload(ptr.as_ptr());
+            let current = block_size_of(block);
+            if required <= current {
+                return true;
+            }
+
+            let next = next_phys(block);
+            if !is_free(next) || current + block_size_of(next) < required {
+                return false;
+            }
+
+            let next_size = block_size_of(next);
+            self.remove_free(next);
+            (*block).size += next_size;
+            (*next_phys(block)).prev_phys = block;
+            self.used += next_size;
+
+            let before = block_size_of(block);
+            self.trim_free_tail(block, required);
+            self.used -= before - block_size_of(block);
+        }
+
+        true
+    }
+
+    /// Shrinks the block holding `ptr` in place to `new_size` payload bytes, returning the
+    /// tail to the heap when it is large enough to form a block.
+    ///
+    /// # Safety
+    ///
+    /// - `ptr` must have been returned by this heap and not freed since
+    /// - `new_size` must not exceed the current payload size
+    pub unsafe fn shrink_in_place(&mut self, ptr: NonNull<u8>, new_size: usize) {
+        let Some(required) = block_size_for(payload_span(ptr, new_size)) else {
+            return;
+        };
+
+        // SAFETY: The caller guarantees `ptr` is the payload of a live block.
+        unsafe {
+            let block = block_from_payload(ptr.as_ptr());
+            let current = block_size_of(block);
+            if current < required + MIN_BLOCK_SIZE {
+                return;
+            }
+
+            let rest = split(block, required);
+            self.used -= block_size_of(rest);
+            (*rest).size |= FREE_BIT;
+
+            let rest = self.merge_next(rest);
+            self.insert_free(rest);
+        }
+    }
+
+    /// Returns the number of payload bytes usable through `ptr`.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been returned by this heap and not freed since.
+    pub unsafe fn usable_size(&self, ptr: NonNull<u8>) -> usize {
+        // SAFETY: The caller guarantees `ptr` is the payload of a live block.
+        unsafe {
+            let block = block_from_payload(ptr.as_ptr());
+            block as usize + block_size_of(block) - ptr.as_ptr() as usize
+        }
+    }
+
+    /// Extends the heap by `by` bytes of memory immediately following [`Tlsf::top`].
+    ///
+    /// Extensions smaller than a block are ignored.
+    ///
+    /// # Safety
+    ///
+    /// - The heap must have been created with [`Tlsf::new`] over a non-empty region
+    /// - `[top, top + by)` must be valid, writable memory owned by the heap
+    pub unsafe fn extend(&mut self, by: usize) {
+        let by = align_down(by, ALIGN);
+        if self.sentinel.is_null() || by < MIN_BLOCK_SIZE {
+            return;
+        }
+
+        // SAFETY: The old sentinel becomes the header of the new free block and a new
+        // sentinel is written at the end of the extension, inside the owned region.
+        unsafe {
+            let block = self.sentinel;
+            (*block).size = by | FREE_BIT;
+
+            let sentinel = next_phys(block);
+            sentinel.write(BlockHeader {
+                prev_phys: block,
+                size: 0,
+            });
+            self.sentinel = sentinel;
+            self.size += by;
+
+            let block = self.merge_prev(block);
+            self.insert_free(block);
+        }
+    }
+
+    /// Returns the number of bytes [`Tlsf::extend`] must add for an allocation of `layout`
+    /// to succeed on an otherwise full heap.
+    ///
+    /// The search for a free block is rounded up to the next second-level class, so large
+    /// requests need noticeably more than their own size.
+    pub fn min_extension_for(layout: Layout) -> Option<usize> {
+        let (fl, sl) = mapping_search(search_size_for(layout)?)?;
+        if fl >= FL_COUNT {
+            return None;
+        }
+
+        // Smallest block size mapped to `(fl, sl)`
+        let class_size = if fl == 0 {
+            sl << ALIGN_LOG2
+        } else {
+            let log2 = fl as u32 + FL_SHIFT - 1;
+            (1usize << log2) + (sl << (log2 - SL_LOG2))
+        };
+        Some(class_size.max(MIN_BLOCK_SIZE))
+    }
+
+    /// Returns the size of the last block if it is free, i.e. the amount of memory that
+    /// could be given back by shrinking the heap from the top.
+    pub fn trailing_free_size(&self) -> usize {
+        if self.sentinel.is_null() {
+            return 0;
+        }
+
+        // SAFETY: The sentinel always points to the previous physical block.
+        unsafe {
+            let last = (*self.sentinel).prev_phys;
+            if last.is_null() || !is_free(last) {
+                return 0;
+            }
+            block_size_of(last)
+        }
+    }
+
+    /// Removes up to `by` bytes of trailing free memory from the top of the heap.
+    ///
+    /// The amount is rounded down so the remaining last block is either used or at least
+    /// [`MIN_BLOCK_SIZE`]. Returns the number of bytes actually removed; the caller may
+    /// release `[top, top + removed)` afterwards.
+    pub fn shrink(&mut self, by: usize) -> usize {
+        let available = self.trailing_free_size();
+        if available == 0 {
+            return 0;
+        }
+
+        let mut by = align_down(by.min(available), ALIGN);
+        if available - by != 0 && available - by < MIN_BLOCK_SIZE {
+            by = available.saturating_sub(MIN_BLOCK_SIZE);
+            by = align_down(by, ALIGN);
+        }
+        if by == 0 {
+            return 0;
+        }
+
+        // SAFETY: The last block is free and at least `by` bytes long; the new sentinel is
+        // written inside its memory.
+        unsafe {
+            let last = (*self.sentinel).prev_phys;
+            self.remove_free(last);
+
+            let sentinel = if by == available {
+                // Whole block removed: its header becomes the sentinel
+                (*last).size = 0;
+                last
+            } else {
+                (*last).size -= by;
+                let sentinel = next_phys(last);
+                sentinel.write(BlockHeader {
+                    prev_phys: last,
+                    size: 0,
+                });
+                self.insert_free(last);
+                sentinel
+            };
+
+            self.sentinel = sentinel;
+            self.size -= by;
+        }
+
+        by
+    }
+
+    /// Returns the size of the largest free block in bytes, including its header.
+    pub fn largest_free_block(&self) -> usize {
+        if self.fl_bitmap == 0 {
+            return 0;
+        }
+
+        let fl = (u64::BITS - 1 - self.fl_bitmap.leading_zeros()) as usize;
+        let sl = (u32::BITS - 1 - self.sl_bitmap[fl].leading_zeros()) as usize;
+
+        // The top list spans a size range: walk it for the exact maximum
+        let mut largest = 0;
+        let mut curr = self.heads[fl][sl];
+        while !curr.is_null() {
+            // SAFETY: Every entry of a free list is a valid free block.
+            unsafe {
+                largest = largest.max(block_size_of(curr.cast()));
+                curr = (*curr).next_free;
+            }
+        }
+        largest
+    }
+
+    /// Finds and detaches a free block of at least `size` bytes.
+    fn take_suitable(&mut self, size: usize) -> Option<*mut BlockHeader> {
+        let (fl, sl) = mapping_search(size)?;
+        let (fl, sl) = self.find_suitable(fl, sl)?;
+
+        let block = self.heads[fl][sl].cast::<BlockHeader>();
+        // SAFETY: The bitmaps guarantee the list head is a valid free block.
+        unsafe { self.remove_free(block) };
+        Some(block)
+    }
+
+    /// Returns the first non-empty list at or above `(fl, sl)`.
+    fn find_suitable(&self, fl: usize, sl: usize) -> Option<(usize, usize)> {
+        if fl >= FL_COUNT {
+            return None;
+        }
+
+        let sl_map = self.sl_bitmap[fl] & (!0u32 << sl);
+        if sl_map != 0 {
+            return Some((fl, sl_map.trailing_zeros() as usize));
+        }
+
+        let fl_map = self.fl_bitmap & (!0u64).checked_shl(fl as u32 + 1).unwrap_or(0);
+        if fl_map == 0 {
+            return None;
+        }
+
+        let fl = fl_map.trailing_zeros() as usize;
+        let sl = self.sl_bitmap[fl].trailing_zeros() as usize;
+        Some((fl, sl))
+    }
+
+    /// Splits a leading gap off `block` so the payload of the returned block is aligned to
+    /// `align`. The gap is returned to the free lists.
+    ///
+    /// # Safety
+    ///
+    /// `block` must be a detached free block large enough for the gap.
+    unsafe fn split_front_aligned(
+        &mut self,
+        block: *mut BlockHeader,
+        align: usize,
+    ) -> *mut BlockHeader {
+        let payload = payload_of(block) as usize;
+        let mut aligned = align_up(payload, align);
+        if aligned != payload && aligned - payload < MIN_BLOCK_SIZE {
+            aligned = align_up(payload + MIN_BLOCK_SIZE, align);
+        }
+
+        let gap = aligned - payload;
+        if gap == 0 {
+            return block;
+        }
+
+        // SAFETY: The caller guarantees the block spans the gap plus the aligned block.
+        unsafe {
+            let aligned_block = split(block, gap);
+            (*aligned_block).size |= FREE_BIT;
+
+            // The physically previous block of a free block is always used, so the gap
+            // needs no coalescing.
+            self.insert_free(block);
+            aligned_block
+        }
+    }
+
+    /// Splits the tail of `block` beyond `size` bytes into a free block, if the tail is
+    /// large enough to form one.
+    ///
+    /// # Safety
+    ///
+    /// `block` must be a valid block detached from the free lists, at least `size` long.
+    unsafe fn trim_free_tail(&mut self, block: *mut BlockHeader, size: usize) {
+        // SAFETY: The caller guarantees `block` is valid and at least `size` bytes.
+        unsafe {
+            if block_size_of(block) < size + MIN_BLOCK_SIZE {
+                return;
+            }
+
+            let rest = split(block, size);
+            (*rest).size |= FREE_BIT;
+            let rest = self.merge_next(rest);
+            self.insert_free(rest);
+        }
+    }
+
+    /// Coalesces a free, detached `block` with its physically previous block if free.
+    ///
+    /// # Safety
+    ///
+    /// `block` must be a valid free block detached from the free lists.
+    unsafe fn merge_prev(&mut self, block: *mut BlockHeader) -> *mut BlockHeader {
+        // SAFETY: Block headers form a valid physical chain.
+        unsafe {
+            let prev = (*block).prev_phys;
+            if prev.is_null() || !is_free(prev) {
+                return block;
+            }
+
+            self.remove_free(prev);
+            (*prev).size += block_size_of(block);
+            (*next_phys(prev)).prev_phys = prev;
+            prev
+        }
+    }
+
+    /// Coalesces a free, detached `block` with its physically next block if free.
+    ///
+    /// # Safety
+    ///
+    /// `block` must be a valid free block detached from the free lists.
+    unsafe fn merge_next(&mut self, block: *mut BlockHeader) -> *mut BlockHeader {
+        // SAFETY: Block headers form a valid physical chain ending at the sentinel.
+        unsafe {
+            let next = next_phys(block);
+            if !is_free(next) {
+                return block;
+            }
+
+            self.remove_free(next);
+            (*block).size += block_size_of(next);
+            (*next_phys(block)).prev_phys = block;
+            block
+        }
+    }
+
+    /// Pushes a free block onto the list matching its size.
+    ///
+    /// # Safety
+    ///
+    /// `block` must be a valid free block not present in any list.
+    unsafe fn insert_free(&mut self, block: *mut BlockHeader) {
+        // SAFETY: The caller guarantees `block` is valid and large enough for the links.
+        unsafe {
+            let (fl, sl) = mapping(block_size_of(block));
+            let block = block.cast::<FreeBlock>();
+            let head = self.heads[fl][sl];
+
+            (*block).header.size |= FREE_BIT;
+            (*block).next_free = head;
+            (*block).prev_free = ptr::null_mut();
+            if !head.is_null() {
+                (*head).prev_free = block;
+            }
+
+            self.heads[fl][sl] = block;
+            self.fl_bitmap |= 1 << fl;
+            self.sl_bitmap[fl] |= 1 << sl;
+        }
+    }
+
+    /// Unlinks a free block from the list matching its size.
+    ///
+    /// # Safety
+    ///
+    /// `block` must be a valid free block present in its list.
+    unsafe fn remove_free(&mut self, block: *mut BlockHeader) {
+        // SAFETY: The caller guarantees `block` is linked in its list.
+        unsafe {
+            let (fl, sl) = mapping(block_size_of(block));
+            let block = block.cast::<FreeBlock>();
+            let next = (*block).next_free;
+            let prev = (*block).prev_free;
+
+            if !next.is_null() {
+                (*next).prev_free = prev;
+            }
+            if !prev.is_null() {
+                (*prev).next_free = next;
+            } else {
+                self.heads[fl][sl] = next;
+                if next.is_null() {
+                    self.sl_bitmap[fl] &= !(1 << sl);
+                    if self.sl_bitmap[fl] == 0 {
+                        self.fl_bitmap &= !(1 << fl);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Header preceding every block's payload.
+#[repr(C)]
+struct BlockHeader {
+    /// Physically previous block, null for the first block.
+    prev_phys: *mut BlockHeader,
+    /// Block size including this header, with flags in the low bits.
+    size: usize,
+}
+
+/// Layout of a free block: the header followed by the free-list links.
+#[repr(C)]
+struct FreeBlock {
+    header: BlockHeader,
+    next_free: *mut FreeBlock,
+    prev_free: *mut FreeBlock,
+}
+
+/// Returns the block size (including header) for a payload of `size` bytes.
+#[inline]
+fn block_size_for(size: usize) -> Option<usize> {
+    if size >= MAX_BLOCK_SIZE {
+        return None;
+    }
+
+    let size = align_up(size.max(1), ALIGN) + HEADER_SIZE;
+    Some(size.max(MIN_BLOCK_SIZE))
+}
+
+/// Returns the free block size the search for `layout` asks for.
+///
+/// Over-aligned requests need room to split off a leading gap of at least `MIN_BLOCK_SIZE`
+/// before the aligned payload.
+#[inline]
+fn search_size_for(layout: Layout) -> Option<usize> {
+    let block_size = block_size_for(layout.size())?;
+    if layout.align() <= ALIGN {
+        Some(block_size)
+    } else {
+        block_size
+            .checked_add(layout.align())?
+            .checked_add(MIN_BLOCK_SIZE)
+    }
+}
+
+/// Returns the payload size that must fit in the block of `ptr` to serve `new_size` bytes
+/// starting at `ptr`, accounting for payloads that do not start right after the header.
+#[inline]
+fn payload_span(ptr: NonNull<u8>, new_size: usize) -> usize {
+    // SAFETY: `ptr` is always a block payload; the header lies right before it.
+    let block = unsafe { block_from_payload(ptr.as_ptr()) };
+    let offset = ptr.as_ptr() as usize - payload_of(block) as usize;
+    new_size.saturating_add(offset)
+}
+
+/// Maps a block size to its `(fl, sl)` list.
+#[inline]
+fn mapping(size: usize) -> (usize, usize) {
+    if size < SMALL_BLOCK_SIZE {
+        return (0, size >> ALIGN_LOG2);
+    }
+
+    let log2 = usize::BITS - 1 - size.leading_zeros();
+    let sl = (size >> (log2 - SL_LOG2)) ^ SL_COUNT;
+    let fl = (log2 - FL_SHIFT + 1) as usize;
+    (fl, sl)
+}
+
+/// Maps a requested size to the first list whose blocks are all large enough.
+#[inline]
+fn mapping_search(size: usize) -> Option<(usize, usize)> {
+    let size = if size >= SMALL_BLOCK_SIZE {
+        let log2 = usize::BITS - 1 - size.leading_zeros();
+        size.checked_add((1 << (log2 - SL_LOG2)) - 1)?
+    } else {
+        size
+    };
+
+    Some(mapping(size))
+}
+
+/// Splits `block` at `offset`, returning the new tail block.
+///
+/// The tail inherits the remaining size and no flags.
+///
+/// # Safety
+///
+/// `block` must be valid and `offset + MIN_BLOCK_SIZE` must not exceed its size.
+#[inline]
+unsafe fn split(block: *mut BlockHeader, offset: usize) -> *mut BlockHeader {
+    // SAFETY: The caller guarantees the tail lies inside the block.
+    unsafe {
+        let total = block_size_of(block);
+        let rest = (block as usize + offset) as *mut BlockHeader;
+        rest.write(BlockHeader {
+            prev_phys: block,
+            size: total - offset,
+        });
+        (*block).size = offset | ((*block).size & FLAGS_MASK);
+        (*next_phys(rest)).prev_phys = rest;
+        rest
+    }
+}
+
+/// Returns the block size of `block` without flags.
+///
+/// # Safety
+///
+/// `block` must point to a valid block header.
+#[inline]
+unsafe fn block_size_of(block: *mut BlockHeader) -> usize {
+    // SAFETY: The caller guarantees `block` is valid.
+    unsafe { (*block).size & !FLAGS_MASK }
+}
+
+/// Returns `true` if `block` is free.
+///
+/// # Safety
+///
+/// `block` must point to a valid block header.
+#[inline]
+unsafe fn is_free(block: *mut BlockHeader) -> bool {
+    // SAFETY: The caller guarantees `block` is valid.
+    unsafe { (*block).size & FREE_BIT != 0 }
+}
+
+/// Returns the physically next block.
+///
+/// # Safety
+///
+/// `block` must be a valid block other than the sentinel.
+#[inline]
+unsafe fn next_phys(block: *mut BlockHeader) -> *mut BlockHeader {
+    // SAFETY: The caller guarantees `block` is valid; its successor starts at its end.
+    unsafe { (block as usize + block_size_of(block)) as *mut BlockHeader }
+}
+
+/// Returns the payload address of `block`.
+#[inline]
+fn payload_of(block: *mut BlockHeader) -> *mut u8 {
+    (block as usize + HEADER_SIZE) as *mut u8
+}
+
+/// Returns the block owning the payload at `ptr`.
+///
+/// # Safety
+///
+/// `ptr` must be a payload address returned by [`Tlsf::allocate`].
+#[inline]
+unsafe fn block_from_payload(ptr: *mut u8) -> *mut BlockHeader {
+    (ptr as usize - HEADER_SIZE) as *mut BlockHeader
+}
+
+#[inline]
+const fn align_up(value: usize, align: usize) -> usize {
+    (value + align - 1) & !(align - 1)
+}
+
+#[inline]
+const fn align_down(value: usize, align: usize) -> usize {
+    value & !(align - 1)
+}
@@ -0,0 +1,152 @@
+//! Data cache maintenance and prefetch functions.
+//!
+//! The range operations walk their range one cache line at a time, with the line size read
+//! from `ctr_el0` (or the block size from `dczid_el0` for zeroing), and issue a single
+//! barrier once the whole range is done: the maintenance instructions of a range are
+//! pipelined by the CPU, so flushing a large buffer runs at memory bandwidth.
+//!
+//! Memory shared with the GPU or with a device outside the CPU's coherency domain must be
+//! cleaned with [`clean_range`] after the CPU writes it, and invalidated with
+//! [`clean_invalidate_range`] before the CPU reads what the device wrote.
+
+use core::{arch::asm, ptr};
+
+use crate::{
+    barrier::{self, SY},
+    control_regs,
+};
+
+/// Returns the size of the smallest data cache line, in bytes.
+#[inline]
+pub fn dcache_line_size() -> usize {
+    // SAFETY: Reading the cache type register has no side effects.
+    let ctr = unsafe { control_regs::ctr_el0() };
+    4 << ((ctr >> 16) & 0xF)
+}
+
+/// Returns the size of the block zeroed by `DC ZVA`, in bytes, or `None` if the instruction
+/// is prohibited.
+#[inline]
+pub fn zva_block_size() -> Option<usize> {
+    // SAFETY: Reading the cache zero ID register has no side effects.
+    let dczid = unsafe { control_regs::dczid_el0() };
+    if dczid & (1 << 4) != 0 {
+        return None;
+    }
+    Some(4 << (dczid & 0xF))
+}
+
+/// Cleans the data cache lines of `[addr, addr + len)` to the point of coherency, writing
+/// dirty lines back to memory.
+///
+/// Returns once the writes are visible to every observer, GPU and devices included.
+///
+/// # Safety
+///
+/// The range must be mapped.
+#[inline]
+pub unsafe fn clean_range(addr: *const u8, len: usize) {
+    for_each_line(addr, len, |line| {
+        // SAFETY: The caller guarantees the range is mapped.
+        unsafe { asm!("dc cvac, {}", in(reg) line, options(nostack, preserves_flags)) }
+    });
+    barrier::dsb(SY);
+}
+
+/// Cleans and invalidates the data cache lines of `[addr, addr + len)` to the point of
+/// coherency.
+///
+/// Dirty lines are written back to memory, and the next CPU reads of the range fetch it from
+/// memory again.
+///
+/// # Safety
+///
+/// The range must be mapped.
+#[inline]
+pub unsafe fn clean_invalidate_range(addr: *const u8, len: usize) {
+    for_each_line(addr, len, |line| {
+        // SAFETY: The caller guarantees the range is mapped.
+        unsafe { asm!("dc civac, {}", in(reg) line, options(nostack, preserves_flags)) }
+    });
+    barrier::dsb(SY);
+}
+
+/// Zeroes `len` bytes at `dst`.
+///
+/// The whole blocks of the range are zeroed with `DC ZVA`, which allocates them in the cache
+/// without reading them from memory first. The unaligned head and tail, and ranges too short
+/// to hold a block, are zeroed with regular stores.
+///
+/// # Safety
+///
+/// `dst` must be [valid] for writes of `len` bytes, in normal cacheable memory: `DC ZVA`
+/// faults on device and uncached memory.
+///
+/// [valid]: core::ptr#safety
+pub unsafe fn zero_range(dst: *mut u8, len: usize) {
+    let Some(block) = zva_block_size() else {
+        // SAFETY: The caller guarantees `dst` is valid for `len` bytes.
+        return unsafe { ptr::write_bytes(dst, 0, len) };
+    };
+
+    let start = dst.addr();
+    let head = start.next_multiple_of(block) - start;
+    if len < head + block {
+        // SAFETY: The caller guarantees `dst` is valid for `len` bytes.
+        return unsafe { ptr::write_bytes(dst, 0, len) };
+    }
+    let blocks_len = (len - head) & !(block - 1);
+
+    // SAFETY: The caller guarantees `dst` is valid for `len` bytes, and the head, blocks and
+    // tail lie within them.
+    unsafe {
+        ptr::write_bytes(dst, 0, head);
+
+        let mut block_ptr = dst.add(head);
+        let blocks_end = block_ptr.add(blocks_len);
+        while block_ptr < blocks_end {
+            asm!("dc zva, {}", in(reg) block_ptr, options(nostack, preserves_flags));
+            block_ptr = block_ptr.add(block);
+        }
+
+        ptr::write_bytes(blocks_end, 0, len - head - blocks_len);
+    }
+}
+
+/// Hints the CPU to fetch the cache line of `addr` into the L1 cache, for reading.
+///
+/// Prefetching never faults: `addr` may be invalid.
+#[inline(always)]
+pub fn prefetch_read<T>(addr: *const T) {
+    // SAFETY: Prefetch instructions have no architectural effect.
+    unsafe {
+        asm!("prfm pldl1keep, [{}]", in(reg) addr, options(nostack, readonly, preserves_flags))
+    }
+}
+
+/// Hints the CPU to fetch the cache line of `addr` into the L1 cache, for writing.
+///
+/// Prefetching never faults: `addr` may be invalid.
+#[inline(always)]
+pub fn prefetch_write<T>(addr: *const T) {
+    // SAFETY: Prefetch instructions have no architectural effect.
+    unsafe {
+        asm!("prfm pstl1keep, [{}]", in(reg) addr, options(nostack, readonly, preserves_flags))
+    }
+}
+
+/// Calls `op` with the address of every data cache line that overlaps `[addr, addr + len)`.
+#[inline(always)]
+fn for_each_line(addr: *const u8, len: usize, mut op: impl FnMut(usize)) {
+    if len == 0 {
+        return;
+    }
+
+    let line_size = dcache_line_size();
+    let end = addr.addr() + len;
+    let mut line = addr.addr() & !(line_size - 1);
+    while line < end {
+        op(line);
+        line += line_size;
+    }
+}
@@ -94,3 +94,59 @@ pub unsafe extern "C" fn tpidrro_el0() -> usize {
         "ret",
     );
 }
+
+/// Read the `ctr_el0` system register.
+///
+/// This function reads the `ctr_el0` system register, which describes the cache geometry of
+/// the CPU.
+///
+/// Returns the raw register value. Bits `[19:16]` (`DminLine`) hold the log2 of the number of
+/// words in the smallest data cache line, and bits `[3:0]` (`IminLine`) the same for the
+/// instruction caches.
+///
+/// # References
+///
+/// - [ARM CTR-EL0 Register](https://developer.arm.com/documentation/ddi0601/2024-12/AArch64-Registers/CTR-EL0--Cache-Type-Register)
+/// - [rust-embedded/aarch64-cpu: ctr_el0.rs](https://github.com/rust-embedded/aarch64-cpu/blob/main/src/registers/ctr_el0.rs)
+///
+/// # SAFETY
+///
+/// This function is `naked`, and its body is written in assembly.
+/// The assembly code reads the `ctr_el0` system register and returns
+/// its value in `x0`, according to the AArch64 procedure call standard.
+/// The `noreturn` option is used to prevent the compiler from generating
+/// a function prologue and epilogue.
+#[unsafe(naked)]
+pub unsafe extern "C" fn ctr_el0() -> u64 {
+    naked_asm!(
+        "mrs x0, ctr_el0", // Move the value of `ctr_el0` into the return register `x0`
+        "ret",
+    );
+}
+
+/// Read the `dczid_el0` system register.
+///
+/// This function reads the `dczid_el0` system register, which describes the `DC ZVA`
+/// instruction.
+///
+/// Returns the raw register value. Bits `[3:0]` (`BS`) hold the log2 of the number of words
+/// zeroed by `DC ZVA`, and bit `4` (`DZP`) is set if the instruction is prohibited.
+///
+/// # References
+///
+/// - [ARM DCZID-EL0 Register](https://developer.arm.com/documentation/ddi0601/2024-12/AArch64-Registers/DCZID-EL0--Data-Cache-Zero-ID-Register)
+///
+/// # SAFETY
+///
+/// This function is `naked`, and its body is written in assembly.
+/// The assembly code reads the `dczid_el0` system register and returns
+/// its value in `x0`, according to the AArch64 procedure call standard.
+/// The `noreturn` option is used to prevent the compiler from generating
+/// a function prologue and epilogue.
+#[unsafe(naked)]
+pub unsafe extern "C" fn dczid_el0() -> u64 {
+    naked_asm!(
+        "mrs x0, dczid_el0", // Move the value of `dczid_el0` into the return register `x0`
+        "ret",
+    );
+}
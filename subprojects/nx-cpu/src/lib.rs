@@ -10,4 +10,5 @@ compile_error!("nx-cpu only supports aarch64 CPUs");
 extern crate nx_panic_handler as _; // provides #[panic_handler]
 
 pub mod barrier;
+pub mod cache;
 pub mod control_regs;
@@ -7,8 +7,10 @@
 //! reporting in homebrew applications.
 //!
 //! The panic handler formats messages using Rust's standard "panicked at" format
-//! and passes them to `svcBreak` via a 512-byte static buffer, following the same
-//! approach as libnx's `fatalThrow` and `diagAbortWithResult` functions.
+//! and passes them to `svcBreak` via a static buffer, following the same approach as
+//! libnx's `fatalThrow` and `diagAbortWithResult` functions. The most recent records of
+//! the [`ring`] follow the message, so that the report shows the errors leading to the
+//! panic.
 //!
 //! ## Minimal SVC Implementation
 //!
@@ -20,26 +22,39 @@
 
 use core::{fmt::Write as _, panic::PanicInfo};
 
-/// Maximum size for panic message buffer
+pub mod ring;
+
+/// Maximum size of the panic message, at the start of the buffer
 const MSG_BUFFER_SIZE: usize = 512;
 
+/// Size of the buffer passed to `svcBreak`: the message, then the ring records
+const BREAK_BUFFER_SIZE: usize = 4096;
+
+/// Maximum number of ring records appended to the panic message
+const RING_RECORDS: usize = 32;
+
 /// Custom panic handler that calls the Switch debug break system call.
 ///
 /// When a panic occurs, this handler will:
 /// 1. Format the panic message using Rust's standard "panicked at" format
-/// 2. Call `svcBreak` with `BreakReason::Panic`
-/// 3. Pass the formatted message buffer address and size to svcBreak
+/// 2. Append the most recent [`ring`] records, newest first
+/// 3. Call `svcBreak` with `BreakReason::Panic`
+/// 4. Pass the formatted message buffer address and size to svcBreak
 ///
 /// This follows the same approach as libnx's `fatalThrow` and `diagAbortWithResult`,
-/// and uses Rust's standard panic message format for consistency.
-#[panic_handler]
+/// and uses Rust's standard panic message format for consistency. Nothing is allocated,
+/// so the report survives an exhausted heap.
+///
+/// Only registered when building for the console: host builds, such as the benchmarks,
+/// link `std` and its panic handler instead.
+#[cfg_attr(target_os = "horizon", panic_handler)]
 pub fn panic_handler(info: &PanicInfo) -> ! {
     /// Static buffer for storing panic messages
     ///
-    /// This buffer is used to store the formatted panic message so it can be
-    /// passed to svcBreak via a pointer. The buffer is static to ensure it
+    /// This buffer is used to store the formatted panic message and ring records so
+    /// they can be passed to svcBreak via a pointer. The buffer is static to ensure it
     /// remains valid for the duration of the break event.
-    static mut MSG_BUFFER: [u8; MSG_BUFFER_SIZE] = [0; MSG_BUFFER_SIZE];
+    static mut MSG_BUFFER: [u8; BREAK_BUFFER_SIZE] = [0; BREAK_BUFFER_SIZE];
 
     // Format the panic message using Rust's standard Display implementation
     // This gives us the standard "panicked at '<message>', <file>:<line>:<column>" format
@@ -48,18 +63,26 @@ pub fn panic_handler(info: &PanicInfo) -> ! {
     // The pointer is valid, properly aligned, and we have exclusive access during panic.
     let (buf_slice, buf_ptr) = unsafe {
         let raw_ptr = &raw mut MSG_BUFFER;
-        let slice = core::slice::from_raw_parts_mut(raw_ptr as *mut u8, MSG_BUFFER_SIZE);
+        let slice = core::slice::from_raw_parts_mut(raw_ptr as *mut u8, BREAK_BUFFER_SIZE);
         (slice, raw_ptr)
     };
 
-    // Create a cursor to write into the buffer
-    let mut cursor = Cursor::new(buf_slice);
+    // Create a cursor to write into the message part of the buffer
+    let mut cursor = Cursor::new(&mut buf_slice[..MSG_BUFFER_SIZE]);
 
     // Write the panic info using Rust's standard Display format
     // This automatically handles the "panicked at" formatting
     let _ = write!(cursor, "{}", info);
+    let message_len = cursor.position();
+
+    // Append the ring records right after the message, in the rest of the buffer
+    let mut cursor = Cursor::new(&mut buf_slice[message_len..]);
+    if ring::recorded() > 0 {
+        let _ = cursor.write_str("\n");
+        let _ = ring::write_to(&mut cursor, RING_RECORDS);
+    }
 
-    let written = cursor.position();
+    let written = message_len + cursor.position();
     let (msg_ptr, msg_len) = (buf_ptr as usize, written);
 
     // Call the debug break system call with panic reason.
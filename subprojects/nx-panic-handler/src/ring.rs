@@ -0,0 +1,254 @@
+//! # Error and trace ring
+//!
+//! A fixed ring of the last [`CAPACITY`] error and trace records, for post-mortem
+//! reports. The ring is a static, so recording never allocates and still works once the
+//! heap is exhausted; the panic handler appends the most recent records to the message it
+//! passes to `svcBreak`.
+//!
+//! Recording is wait-free, from any thread: a record claims its slot with a single
+//! `fetch_add`, then stores a few words. Records are compact: the result code, a caller
+//! argument, the system tick, the thread and the source location of the caller.
+//!
+//! ```ignore
+//! if let Err(err) = res {
+//!     nx_panic_handler::ring::error(err.to_rc(), session.to_raw().into());
+//! }
+//! ```
+
+use core::{
+    fmt,
+    panic::Location,
+    sync::atomic::{AtomicU64, AtomicUsize, Ordering, fence},
+};
+
+/// Number of records kept. A power of two.
+pub const CAPACITY: usize = 256;
+
+/// Kind of a [`Record`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Kind {
+    /// An error, with its result code.
+    Error,
+    /// A trace event, with a caller-defined tag.
+    Trace,
+}
+
+/// A record read back from the ring.
+#[derive(Debug, Clone, Copy)]
+pub struct Record {
+    /// Sequence number of the record, counting every record since boot.
+    pub seq: u64,
+    /// System tick at which the record was written.
+    pub tick: u64,
+    /// Thread that wrote the record, as its TLS region address.
+    pub thread: u64,
+    pub kind: Kind,
+    /// Result code of an error, or tag of a trace event.
+    pub code: u32,
+    /// Caller-defined argument.
+    pub arg: u64,
+    /// Source location of the caller.
+    pub location: Option<&'static Location<'static>>,
+}
+
+impl fmt::Display for Record {
+    /// Formats the record on one line; result codes are also shown as
+    /// `2<module>-<description>`.
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "#{} {:#x} t:{:#x} ", self.seq, self.tick, self.thread)?;
+        match self.kind {
+            Kind::Error => write!(
+                f,
+                "error {:#x} ({:04}-{:04})",
+                self.code,
+                2000 + (self.code & 0x1FF),
+                (self.code >> 9) & 0x1FFF
+            )?,
+            Kind::Trace => write!(f, "trace {:#x}", self.code)?,
+        }
+        write!(f, " arg:{:#x}", self.arg)?;
+        if let Some(location) = self.location {
+            write!(f, " at {location}")?;
+        }
+        Ok(())
+    }
+}
+
+/// Records an error with the result code `code`.
+#[track_caller]
+#[inline]
+pub fn error(code: u32, arg: u64) {
+    push(Kind::Error, code, arg, Location::caller());
+}
+
+/// Records a trace event with the tag `tag`.
+#[track_caller]
+#[inline]
+pub fn trace(tag: u32, arg: u64) {
+    push(Kind::Trace, tag, arg, Location::caller());
+}
+
+/// Returns the number of records written since boot, including the overwritten ones.
+pub fn recorded() -> u64 {
+    NEXT.load(Ordering::Relaxed)
+}
+
+/// Writes the most recent records to `out`, oldest first, returning their number.
+///
+/// Records being written concurrently are skipped.
+pub fn snapshot(out: &mut [Record]) -> usize {
+    let end = recorded();
+    let start = end.saturating_sub(out.len().min(CAPACITY) as u64);
+
+    let mut len = 0;
+    for seq in start..end {
+        if let Some(record) = read(seq) {
+            out[len] = record;
+            len += 1;
+        }
+    }
+    len
+}
+
+/// Writes up to `max` of the most recent records to `out`, one per line, newest first.
+pub fn write_to<W: fmt::Write>(out: &mut W, max: usize) -> fmt::Result {
+    let end = recorded();
+    let start = end.saturating_sub(max.min(CAPACITY) as u64);
+    for seq in (start..end).rev() {
+        if let Some(record) = read(seq) {
+            writeln!(out, "{record}")?;
+        }
+    }
+    Ok(())
+}
+
+/// A slot of the ring, one cache line wide so that concurrent writers do not share one.
+///
+/// The stamp is a per-slot sequence lock: odd while the record `stamp / 2` is being
+/// written, then `stamp / 2 + 1` times two once it is complete. `0` if never written.
+#[repr(C, align(64))]
+struct Slot {
+    stamp: AtomicU64,
+    tick: AtomicU64,
+    thread: AtomicU64,
+    /// Kind in the upper half, code in the lower one.
+    kind_code: AtomicU64,
+    arg: AtomicU64,
+    location: AtomicUsize,
+}
+
+impl Slot {
+    const fn new() -> Self {
+        Self {
+            stamp: AtomicU64::new(0),
+            tick: AtomicU64::new(0),
+            thread: AtomicU64::new(0),
+            kind_code: AtomicU64::new(0),
+            arg: AtomicU64::new(0),
+            location: AtomicUsize::new(0),
+        }
+    }
+}
+
+static SLOTS: [Slot; CAPACITY] = [const { Slot::new() }; CAPACITY];
+/// Sequence number of the next record.
+static NEXT: AtomicU64 = AtomicU64::new(0);
+
+/// Writes a record in the next slot, overwriting the oldest record.
+///
+/// Two writers a whole ring apart landing on the same slot at once may mix their
+/// records; every field still holds a value one of them wrote.
+#[inline]
+fn push(kind: Kind, code: u32, arg: u64, location: &'static Location<'static>) {
+    let seq = NEXT.fetch_add(1, Ordering::Relaxed);
+    let slot = &SLOTS[seq as usize & (CAPACITY - 1)];
+
+    slot.stamp.store(seq * 2 + 1, Ordering::Relaxed);
+    fence(Ordering::Release);
+
+    let kind = match kind {
+        Kind::Error => 0,
+        Kind::Trace => 1,
+    };
+    slot.tick.store(cpu::tick(), Ordering::Relaxed);
+    slot.thread.store(cpu::thread(), Ordering::Relaxed);
+    slot.kind_code
+        .store(kind << 32 | u64::from(code), Ordering::Relaxed);
+    slot.arg.store(arg, Ordering::Relaxed);
+    slot.location
+        .store(core::ptr::from_ref(location).addr(), Ordering::Relaxed);
+
+    slot.stamp.store(seq * 2 + 2, Ordering::Release);
+}
+
+/// Reads the record `seq`, if it is complete and not overwritten yet.
+fn read(seq: u64) -> Option<Record> {
+    let slot = &SLOTS[seq as usize & (CAPACITY - 1)];
+
+    let stamp = slot.stamp.load(Ordering::Acquire);
+    if stamp != seq * 2 + 2 {
+        return None;
+    }
+
+    let tick = slot.tick.load(Ordering::Relaxed);
+    let thread = slot.thread.load(Ordering::Relaxed);
+    let kind_code = slot.kind_code.load(Ordering::Relaxed);
+    let arg = slot.arg.load(Ordering::Relaxed);
+    let location = slot.location.load(Ordering::Relaxed);
+
+    fence(Ordering::Acquire);
+    if slot.stamp.load(Ordering::Relaxed) != stamp {
+        return None;
+    }
+
+    Some(Record {
+        seq,
+        tick,
+        thread,
+        kind: if kind_code >> 32 == 0 {
+            Kind::Error
+        } else {
+            Kind::Trace
+        },
+        code: kind_code as u32,
+        arg,
+        // SAFETY: Only addresses of `&'static Location`s are stored in the slots, and each
+        // is stored whole.
+        location: unsafe { (location as *const Location<'static>).as_ref() },
+    })
+}
+
+/// Timestamp and thread of the records.
+mod cpu {
+    /// Returns the system tick.
+    #[inline(always)]
+    pub(super) fn tick() -> u64 {
+        #[cfg(target_os = "horizon")]
+        {
+            let tick: u64;
+            // SAFETY: Reading the counter-timer has no side effects.
+            unsafe {
+                core::arch::asm!("mrs {}, cntpct_el0", out(reg) tick, options(nomem, nostack, preserves_flags));
+            }
+            tick
+        }
+        #[cfg(not(target_os = "horizon"))]
+        0
+    }
+
+    /// Returns the address of the TLS region of the current thread.
+    #[inline(always)]
+    pub(super) fn thread() -> u64 {
+        #[cfg(target_os = "horizon")]
+        {
+            let tls: u64;
+            // SAFETY: Reading the read-only thread ID register has no side effects.
+            unsafe {
+                core::arch::asm!("mrs {}, tpidrro_el0", out(reg) tls, options(nomem, nostack, preserves_flags));
+            }
+            tls
+        }
+        #[cfg(not(target_os = "horizon"))]
+        0
+    }
+}
@@ -26,6 +26,33 @@ void __nx_rand_get(void* buf, size_t len);
  */
 uint64_t __nx_rand_get64(void);
 
+/**
+ * @brief Fills a buffer with fast, non-cryptographic random data (xoshiro256++).
+ * @param buf Pointer to the buffer.
+ * @param len Size of the buffer in bytes.
+ */
+void __nx_rand__fast_get(void* buf, size_t len);
+
+/**
+ * @brief Returns a fast, non-cryptographic random 64-bit value (xoshiro256++).
+ * @return Random value.
+ */
+uint64_t __nx_rand__fast_get64(void);
+
+/**
+ * @brief Fills an array with fast, non-cryptographic random 32-bit values.
+ * @param buf Pointer to the array.
+ * @param count Number of values in the array.
+ */
+void __nx_rand__fast_fill_u32(uint32_t* buf, size_t count);
+
+/**
+ * @brief Fills an array with fast, non-cryptographic random floats in [0, 1).
+ * @param buf Pointer to the array.
+ * @param count Number of values in the array.
+ */
+void __nx_rand__fast_fill_f32(float* buf, size_t count);
+
 #ifdef __cplusplus
 }
 #endif 
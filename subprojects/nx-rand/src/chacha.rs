@@ -0,0 +1,311 @@
+//! Bulk ChaCha20 keystream generation.
+//!
+//! `rand_chacha` produces one block at a time with scalar code on AArch64. For large
+//! requests, [`fill_bytes`] instead computes the generator's keystream four blocks at a
+//! time with NEON, writing straight into the destination buffer, and then moves the
+//! generator past the blocks it produced. The output is bit-for-bit the one
+//! [`ChaCha20Rng::fill_bytes`] would have produced.
+
+use rand::RngCore;
+use rand_chacha::ChaCha20Rng;
+
+/// Smallest request served by the bulk path. Smaller ones are not worth the setup.
+pub(crate) const BULK_MIN_LEN: usize = 1024;
+
+/// Size of a ChaCha20 block, in bytes.
+const BLOCK_LEN: usize = 64;
+
+/// Number of 32-bit words in a block.
+const BLOCK_WORDS: u128 = 16;
+
+/// The ChaCha constants: "expand 32-byte k".
+const SIGMA: [u32; 4] = [0x6170_7865, 0x3320_646e, 0x7962_2d32, 0x6b20_6574];
+
+/// Number of double rounds of ChaCha20.
+const DOUBLE_ROUNDS: usize = 10;
+
+/// Fills `dest` from `rng`, generating whole blocks in place for large requests.
+pub(crate) fn fill_bytes(rng: &mut ChaCha20Rng, dest: &mut [u8]) {
+    if dest.len() < BULK_MIN_LEN {
+        rng.fill_bytes(dest);
+        return;
+    }
+
+    // Consume the rest of the current block through the generator's buffer
+    let pos = rng.get_word_pos();
+    let head_words = (BLOCK_WORDS - pos % BLOCK_WORDS) % BLOCK_WORDS;
+    let (head, rest) = dest.split_at_mut(head_words as usize * 4);
+    rng.fill_bytes(head);
+
+    let blocks = rest.len() / BLOCK_LEN;
+    let (body, tail) = rest.split_at_mut(blocks * BLOCK_LEN);
+    let pos = rng.get_word_pos();
+    keystream(
+        &rng.get_seed(),
+        rng.get_stream(),
+        (pos / BLOCK_WORDS) as u64,
+        body,
+    );
+    rng.set_word_pos(pos + blocks as u128 * BLOCK_WORDS);
+
+    rng.fill_bytes(tail);
+}
+
+/// Writes the keystream of the original (64-bit counter, 64-bit nonce) ChaCha20, from
+/// block `counter` on, into `out`.
+///
+/// `out.len()` must be a multiple of [`BLOCK_LEN`].
+fn keystream(key: &[u8; 32], stream: u64, counter: u64, out: &mut [u8]) {
+    debug_assert_eq!(out.len() % BLOCK_LEN, 0);
+
+    let mut state = [0u32; 16];
+    state[..4].copy_from_slice(&SIGMA);
+    for (word, bytes) in state[4..12].iter_mut().zip(key.chunks_exact(4)) {
+        *word = u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]);
+    }
+    state[14] = stream as u32;
+    state[15] = (stream >> 32) as u32;
+
+    let mut counter = counter;
+
+    #[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+    let out = {
+        let mut chunks = out.chunks_exact_mut(4 * BLOCK_LEN);
+        for chunk in &mut chunks {
+            // SAFETY: `chunk` holds exactly four blocks.
+            unsafe { neon::blocks4(&state, counter, chunk.as_mut_ptr()) };
+            counter = counter.wrapping_add(4);
+        }
+        chunks.into_remainder()
+    };
+
+    for block in out.chunks_exact_mut(BLOCK_LEN) {
+        state[12] = counter as u32;
+        state[13] = (counter >> 32) as u32;
+        block_scalar(&state, block);
+        counter = counter.wrapping_add(1);
+    }
+}
+
+/// Computes one block for `state` into `out`.
+fn block_scalar(state: &[u32; 16], out: &mut [u8]) {
+    #[inline(always)]
+    fn quarter_round(x: &mut [u32; 16], a: usize, b: usize, c: usize, d: usize) {
+        x[a] = x[a].wrapping_add(x[b]);
+        x[d] = (x[d] ^ x[a]).rotate_left(16);
+        x[c] = x[c].wrapping_add(x[d]);
+        x[b] = (x[b] ^ x[c]).rotate_left(12);
+        x[a] = x[a].wrapping_add(x[b]);
+        x[d] = (x[d] ^ x[a]).rotate_left(8);
+        x[c] = x[c].wrapping_add(x[d]);
+        x[b] = (x[b] ^ x[c]).rotate_left(7);
+    }
+
+    let mut x = *state;
+    for _ in 0..DOUBLE_ROUNDS {
+        quarter_round(&mut x, 0, 4, 8, 12);
+        quarter_round(&mut x, 1, 5, 9, 13);
+        quarter_round(&mut x, 2, 6, 10, 14);
+        quarter_round(&mut x, 3, 7, 11, 15);
+        quarter_round(&mut x, 0, 5, 10, 15);
+        quarter_round(&mut x, 1, 6, 11, 12);
+        quarter_round(&mut x, 2, 7, 8, 13);
+        quarter_round(&mut x, 3, 4, 9, 14);
+    }
+
+    for ((bytes, word), init) in out.chunks_exact_mut(4).zip(x).zip(state) {
+        bytes.copy_from_slice(&word.wrapping_add(*init).to_le_bytes());
+    }
+}
+
+#[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+mod neon {
+    //! Four-way ChaCha20: lane `j` of vector `i` holds word `i` of block `j`.
+
+    use core::arch::aarch64::*;
+
+    use super::{BLOCK_LEN, DOUBLE_ROUNDS};
+
+    #[inline(always)]
+    fn rotl16(x: uint32x4_t) -> uint32x4_t {
+        // SAFETY: NEON is enabled for the target.
+        unsafe { vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(x))) }
+    }
+
+    #[inline(always)]
+    fn rotl12(x: uint32x4_t) -> uint32x4_t {
+        // SAFETY: NEON is enabled for the target.
+        unsafe { vsriq_n_u32::<20>(vshlq_n_u32::<12>(x), x) }
+    }
+
+    #[inline(always)]
+    fn rotl8(x: uint32x4_t) -> uint32x4_t {
+        // SAFETY: NEON is enabled for the target.
+        unsafe { vsriq_n_u32::<24>(vshlq_n_u32::<8>(x), x) }
+    }
+
+    #[inline(always)]
+    fn rotl7(x: uint32x4_t) -> uint32x4_t {
+        // SAFETY: NEON is enabled for the target.
+        unsafe { vsriq_n_u32::<25>(vshlq_n_u32::<7>(x), x) }
+    }
+
+    #[inline(always)]
+    fn quarter_round(x: &mut [uint32x4_t; 16], a: usize, b: usize, c: usize, d: usize) {
+        // SAFETY: NEON is enabled for the target.
+        unsafe {
+            x[a] = vaddq_u32(x[a], x[b]);
+            x[d] = rotl16(veorq_u32(x[d], x[a]));
+            x[c] = vaddq_u32(x[c], x[d]);
+            x[b] = rotl12(veorq_u32(x[b], x[c]));
+            x[a] = vaddq_u32(x[a], x[b]);
+            x[d] = rotl8(veorq_u32(x[d], x[a]));
+            x[c] = vaddq_u32(x[c], x[d]);
+            x[b] = rotl7(veorq_u32(x[b], x[c]));
+        }
+    }
+
+    /// Computes blocks `counter..counter + 4` for `state` into `out`.
+    ///
+    /// # Safety
+    ///
+    /// `out` must be valid for writes of `4 * BLOCK_LEN` bytes.
+    #[inline]
+    pub(super) unsafe fn blocks4(state: &[u32; 16], counter: u64, out: *mut u8) {
+        let counters: [u64; 4] = core::array::from_fn(|j| counter.wrapping_add(j as u64));
+        let lo = counters.map(|c| c as u32);
+        let hi = counters.map(|c| (c >> 32) as u32);
+
+        // SAFETY: NEON is enabled for the target, and `out` is valid for four blocks.
+        unsafe {
+            let mut init = state.map(|word| vdupq_n_u32(word));
+            init[12] = vld1q_u32(lo.as_ptr());
+            init[13] = vld1q_u32(hi.as_ptr());
+
+            let mut x = init;
+            for _ in 0..DOUBLE_ROUNDS {
+                quarter_round(&mut x, 0, 4, 8, 12);
+                quarter_round(&mut x, 1, 5, 9, 13);
+                quarter_round(&mut x, 2, 6, 10, 14);
+                quarter_round(&mut x, 3, 7, 11, 15);
+                quarter_round(&mut x, 0, 5, 10, 15);
+                quarter_round(&mut x, 1, 6, 11, 12);
+                quarter_round(&mut x, 2, 7, 8, 13);
+                quarter_round(&mut x, 3, 4, 9, 14);
+            }
+            for (word, init) in x.iter_mut().zip(init) {
+                *word = vaddq_u32(*word, init);
+            }
+
+            // Transpose each group of four words back into the four blocks
+            for group in 0..4 {
+                let [a, b, c, d] = [
+                    x[4 * group],
+                    x[4 * group + 1],
+                    x[4 * group + 2],
+                    x[4 * group + 3],
+                ];
+                let t0 = vreinterpretq_u64_u32(vtrn1q_u32(a, b));
+                let t1 = vreinterpretq_u64_u32(vtrn2q_u32(a, b));
+                let t2 = vreinterpretq_u64_u32(vtrn1q_u32(c, d));
+                let t3 = vreinterpretq_u64_u32(vtrn2q_u32(c, d));
+
+                let rows = [
+                    vtrn1q_u64(t0, t2),
+                    vtrn1q_u64(t1, t3),
+                    vtrn2q_u64(t0, t2),
+                    vtrn2q_u64(t1, t3),
+                ];
+                for (block, row) in rows.into_iter().enumerate() {
+                    let dst = out.add(block * BLOCK_LEN + group * 16);
+                    vst1q_u8(dst, vreinterpretq_u8_u64(row));
+                }
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use rand::{Rng, SeedableRng};
+
+    use super::*;
+    use crate::fast::Xoshiro256PlusPlus;
+
+    /// Largest request generated.
+    const MAX_LEN: usize = 8 * BULK_MIN_LEN;
+
+    /// Returns a generator with a random key and stream, `skip` words into its keystream.
+    fn random_chacha(inputs: &mut Xoshiro256PlusPlus, skip: usize) -> ChaCha20Rng {
+        let mut rng = ChaCha20Rng::from_seed(inputs.r#gen());
+        rng.set_stream(inputs.next_u64());
+        rng.set_word_pos(u128::from(inputs.gen_range(0..1u64 << 40)) * BLOCK_WORDS);
+        for _ in 0..skip {
+            rng.next_u32();
+        }
+        rng
+    }
+
+    #[test]
+    fn test_fill_bytes_matches_chacha20_rng() {
+        let mut inputs = Xoshiro256PlusPlus::seed_from_u64(0x5EED);
+        let mut expected = [0u8; MAX_LEN];
+        let mut actual = [0u8; MAX_LEN];
+
+        for _ in 0..256 {
+            // Any start position within a block, and lengths around the bulk threshold with
+            // partial blocks on both ends
+            let skip = inputs.gen_range(0..BLOCK_WORDS as usize);
+            let len = inputs.gen_range(BULK_MIN_LEN - BLOCK_LEN..MAX_LEN);
+
+            let mut expected_rng = random_chacha(&mut inputs, skip);
+            let mut actual_rng = expected_rng.clone();
+
+            expected_rng.fill_bytes(&mut expected[..len]);
+            fill_bytes(&mut actual_rng, &mut actual[..len]);
+
+            assert!(actual[..len] == expected[..len], "len {len}, skip {skip}");
+            assert_eq!(actual_rng.get_word_pos(), expected_rng.get_word_pos());
+            assert_eq!(actual_rng.next_u64(), expected_rng.next_u64());
+        }
+    }
+
+    #[test]
+    fn test_keystream_matches_block_scalar() {
+        let mut inputs = Xoshiro256PlusPlus::seed_from_u64(0xB10C);
+        let mut actual = [0u8; 16 * BLOCK_LEN];
+
+        // Counters carrying into the high word and wrapping around, then random ones
+        let counters: [u64; 66] = core::array::from_fn(|i| match i {
+            0 => u64::from(u32::MAX) - 2,
+            1 => u64::MAX - 2,
+            _ => inputs.next_u64(),
+        });
+
+        for counter in counters {
+            let key: [u8; 32] = inputs.r#gen();
+            let stream = inputs.next_u64();
+            // Several four-block groups and a scalar remainder
+            let len = inputs.gen_range(1..=16) * BLOCK_LEN;
+            keystream(&key, stream, counter, &mut actual[..len]);
+
+            let mut state = [0u32; 16];
+            state[..4].copy_from_slice(&SIGMA);
+            for (word, bytes) in state[4..12].iter_mut().zip(key.chunks_exact(4)) {
+                *word = u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]);
+            }
+            state[14] = stream as u32;
+            state[15] = (stream >> 32) as u32;
+
+            for (i, block) in actual[..len].chunks_exact(BLOCK_LEN).enumerate() {
+                let block_counter = counter.wrapping_add(i as u64);
+                state[12] = block_counter as u32;
+                state[13] = (block_counter >> 32) as u32;
+
+                let mut expected = [0u8; BLOCK_LEN];
+                block_scalar(&state, &mut expected);
+                assert_eq!(block, expected, "counter {counter}, block {i}");
+            }
+        }
+    }
+}
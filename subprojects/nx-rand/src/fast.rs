@@ -0,0 +1,217 @@
+//! Fast, non-cryptographic random number generation.
+//!
+//! [`Xoshiro256PlusPlus`] trades the unpredictability of ChaCha20 for a few cycles per
+//! 64-bit output, for uses like particle systems and procedural generation that need
+//! throughput rather than secrecy. Never use it for keys, nonces or anything an attacker
+//! must not guess: use [`crate::sys`] instead.
+//!
+//! The free functions of this module draw from a per-thread generator, seeded from the
+//! thread's ChaCha20 RNG on first use. For reproducible parallel streams, seed one
+//! generator and hand each worker a copy advanced with [`Xoshiro256PlusPlus::jump`].
+
+use rand::{Error, RngCore, SeedableRng};
+
+use crate::sys;
+
+/// Fills a buffer with fast random data.
+pub fn fill_bytes(buf: &mut [u8]) {
+    sys::with_fast_rng(|rng| rng.fill_bytes(buf));
+}
+
+/// Returns a fast random 64-bit value.
+#[inline]
+pub fn next_u64() -> u64 {
+    sys::with_fast_rng(|rng| rng.next_u64())
+}
+
+/// Fills a buffer with fast random 32-bit values.
+pub fn fill_u32(buf: &mut [u32]) {
+    sys::with_fast_rng(|rng| rng.fill_u32(buf));
+}
+
+/// Fills a buffer with fast random floats, uniformly distributed in `[0, 1)`.
+pub fn fill_f32(buf: &mut [f32]) {
+    sys::with_fast_rng(|rng| rng.fill_f32(buf));
+}
+
+/// The xoshiro256++ generator.
+///
+/// 256 bits of state, a period of 2^256 - 1, and [`jump`](Self::jump) /
+/// [`long_jump`](Self::long_jump) functions to split the period in non-overlapping streams.
+///
+/// See <https://prng.di.unimi.it/>.
+#[derive(Debug, Clone)]
+pub struct Xoshiro256PlusPlus {
+    s: [u64; 4],
+}
+
+/// Jump polynomial, advancing the state by 2^128 steps.
+const JUMP: [u64; 4] = [
+    0x180e_c6d3_3cfd_0aba,
+    0xd5a6_1266_f0c9_392c,
+    0xa958_2618_e03f_c9aa,
+    0x39ab_dc45_29b1_661c,
+];
+
+/// Long-jump polynomial, advancing the state by 2^192 steps.
+const LONG_JUMP: [u64; 4] = [
+    0x76e1_5d3e_fefd_cbbf,
+    0xc500_4e44_1c52_2fb3,
+    0x7771_0069_854e_e241,
+    0x3910_9bb0_2acb_e635,
+];
+
+/// Scale of the 24-bit mantissa draws of [`Xoshiro256PlusPlus::fill_f32`].
+const F32_SCALE: f32 = 1.0 / (1u32 << 24) as f32;
+
+impl Xoshiro256PlusPlus {
+    /// Creates a generator from a 64-bit seed, expanded with SplitMix64.
+    pub const fn from_u64(seed: u64) -> Self {
+        let mut state = seed;
+        let mut s = [0; 4];
+        let mut i = 0;
+        while i < 4 {
+            s[i] = splitmix64(&mut state);
+            i += 1;
+        }
+        Self { s }
+    }
+
+    /// Returns the next 64-bit value.
+    #[inline]
+    pub fn next(&mut self) -> u64 {
+        let [s0, s1, s2, s3] = self.s;
+        let result = s0.wrapping_add(s3).rotate_left(23).wrapping_add(s0);
+
+        let t = s1 << 17;
+        let s2 = s2 ^ s0;
+        let s3 = s3 ^ s1;
+        let s1 = s1 ^ s2;
+        let s0 = s0 ^ s3;
+        self.s = [s0, s1, s2 ^ t, s3.rotate_left(45)];
+
+        result
+    }
+
+    /// Advances the generator by 2^128 steps.
+    ///
+    /// Equivalent to 2^128 calls to [`next`](Self::next): copies of one generator, each
+    /// jumped a different number of times, yield 2^128 non-overlapping streams.
+    pub fn jump(&mut self) {
+        self.apply_polynomial(&JUMP);
+    }
+
+    /// Advances the generator by 2^192 steps.
+    ///
+    /// Splits the period in 2^64 starting points, each of which can be further split with
+    /// [`jump`](Self::jump).
+    pub fn long_jump(&mut self) {
+        self.apply_polynomial(&LONG_JUMP);
+    }
+
+    /// Fills a buffer with random 32-bit values, two per generator step.
+    pub fn fill_u32(&mut self, buf: &mut [u32]) {
+        let mut chunks = buf.chunks_exact_mut(2);
+        for pair in &mut chunks {
+            let x = self.next();
+            pair[0] = x as u32;
+            pair[1] = (x >> 32) as u32;
+        }
+        if let [last] = chunks.into_remainder() {
+            *last = (self.next() >> 32) as u32;
+        }
+    }
+
+    /// Fills a buffer with random floats, uniformly distributed in `[0, 1)`.
+    ///
+    /// Each float takes 24 random bits, its full mantissa precision, so one generator step
+    /// yields two floats.
+    pub fn fill_f32(&mut self, buf: &mut [f32]) {
+        let mut chunks = buf.chunks_exact_mut(2);
+        for pair in &mut chunks {
+            let x = self.next();
+            pair[0] = ((x as u32) >> 8) as f32 * F32_SCALE;
+            pair[1] = (x >> 40) as f32 * F32_SCALE;
+        }
+        if let [last] = chunks.into_remainder() {
+            *last = (self.next() >> 40) as f32 * F32_SCALE;
+        }
+    }
+
+    fn apply_polynomial(&mut self, polynomial: &[u64; 4]) {
+        let mut s = [0; 4];
+        for word in polynomial {
+            for bit in 0..64 {
+                if word & (1 << bit) != 0 {
+                    for (acc, cur) in s.iter_mut().zip(self.s) {
+                        *acc ^= cur;
+                    }
+                }
+                self.next();
+            }
+        }
+        self.s = s;
+    }
+}
+
+impl RngCore for Xoshiro256PlusPlus {
+    #[inline]
+    fn next_u32(&mut self) -> u32 {
+        // The high bits are the strongest ones
+        (self.next() >> 32) as u32
+    }
+
+    #[inline]
+    fn next_u64(&mut self) -> u64 {
+        self.next()
+    }
+
+    fn fill_bytes(&mut self, dest: &mut [u8]) {
+        let mut chunks = dest.chunks_exact_mut(8);
+        for chunk in &mut chunks {
+            chunk.copy_from_slice(&self.next().to_le_bytes());
+        }
+        let rest = chunks.into_remainder();
+        if !rest.is_empty() {
+            rest.copy_from_slice(&self.next().to_le_bytes()[..rest.len()]);
+        }
+    }
+
+    fn try_fill_bytes(&mut self, dest: &mut [u8]) -> Result<(), Error> {
+        self.fill_bytes(dest);
+        Ok(())
+    }
+}
+
+impl SeedableRng for Xoshiro256PlusPlus {
+    type Seed = [u8; 32];
+
+    /// Creates a generator from a 256-bit seed.
+    ///
+    /// The all-zero seed, a fixed point of the generator, is replaced by
+    /// the state of [`Xoshiro256PlusPlus::from_u64(0)`](Xoshiro256PlusPlus::from_u64).
+    fn from_seed(seed: [u8; 32]) -> Self {
+        if seed == [0; 32] {
+            return Self::from_u64(0);
+        }
+
+        let mut s = [0; 4];
+        for (word, bytes) in s.iter_mut().zip(seed.chunks_exact(8)) {
+            *word = u64::from_le_bytes(bytes.try_into().unwrap());
+        }
+        Self { s }
+    }
+
+    fn seed_from_u64(seed: u64) -> Self {
+        Self::from_u64(seed)
+    }
+}
+
+/// Returns the next output of the SplitMix64 generator with state `state`.
+const fn splitmix64(state: &mut u64) -> u64 {
+    *state = state.wrapping_add(0x9e37_79b9_7f4a_7c15);
+    let mut z = *state;
+    z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    z ^ (z >> 31)
+}
@@ -5,7 +5,7 @@
 
 use core::{ffi::c_void, slice};
 
-use super::sys;
+use super::{fast, sys};
 
 /// Fills a buffer with random data.
 ///
@@ -34,3 +34,48 @@ pub unsafe extern "C" fn __nx_rand__random_get(buf: *mut c_void, len: usize) {
 pub unsafe extern "C" fn __nx_rand__random_get64() -> u64 {
     sys::next_u64()
 }
+
+/// Fills a buffer with fast, non-cryptographic random data.
+///
+/// # Arguments
+///
+/// * `buf` - Pointer to the buffer to fill with random data
+/// * `len` - Size of the buffer in bytes
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_rand__fast_get(buf: *mut c_void, len: usize) {
+    let slice = unsafe { slice::from_raw_parts_mut(buf as *mut u8, len) };
+    fast::fill_bytes(slice)
+}
+
+/// Returns a fast, non-cryptographic random 64-bit value.
+///
+/// Drawn from the calling thread's xoshiro256++ generator; not suitable for
+/// cryptographic use.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_rand__fast_get64() -> u64 {
+    fast::next_u64()
+}
+
+/// Fills an array with fast, non-cryptographic random 32-bit values.
+///
+/// # Arguments
+///
+/// * `buf` - Pointer to the array to fill
+/// * `count` - Number of values in the array
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_rand__fast_fill_u32(buf: *mut u32, count: usize) {
+    let slice = unsafe { slice::from_raw_parts_mut(buf, count) };
+    fast::fill_u32(slice)
+}
+
+/// Fills an array with fast, non-cryptographic random floats in `[0, 1)`.
+///
+/// # Arguments
+///
+/// * `buf` - Pointer to the array to fill
+/// * `count` - Number of values in the array
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_rand__fast_fill_f32(buf: *mut f32, count: usize) {
+    let slice = unsafe { slice::from_raw_parts_mut(buf, count) };
+    fast::fill_f32(slice)
+}
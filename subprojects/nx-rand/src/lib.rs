@@ -5,4 +5,6 @@ extern crate nx_panic_handler as _; // provides #[panic_handler]
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+mod chacha;
+pub mod fast;
 pub mod sys;
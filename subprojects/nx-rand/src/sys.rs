@@ -4,56 +4,75 @@
 //! algorithm seeded with entropy from the system's True Random Number Generator (TRNG).
 //! The implementation ensures that:
 //!
-//! - The RNG is initialized only once, using system entropy
-//! - All operations are thread-safe through atomic operations
+//! - Every thread draws from its own ChaCha20 instance, so concurrent callers never share
+//!   (or write to) the same generator state
 //! - The underlying ChaCha20 algorithm provides cryptographically secure random numbers
 //! - The system's TRNG is used as the entropy source for seeding
 //!
 //! # Implementation Details
 //!
-//! The RNG is initialized lazily on first use. During initialization, it:
-//! 1. Collects 256 bits (4 × 64 bits) of entropy from the system TRNG
-//! 2. Uses this entropy to seed a ChaCha20 RNG
-//! 3. Stores the RNG in a static variable for subsequent use
+//! A process-wide *root* RNG is initialized lazily on first use, from 256 bits (4 × 64 bits)
+//! of TRNG entropy. It is only used, under a mutex, to seed the per-thread RNGs, and as a
+//! fallback for threads that could not get one.
 //!
-//! The initialization process is protected by a state machine that ensures:
-//! - Only one thread can perform initialization
-//! - Other threads will wait for initialization to complete
-//! - The RNG is never used before it's fully initialized
+//! Per-thread RNGs live in a fixed pool of [`MAX_THREAD_RNGS`] entries. A thread claims an
+//! entry on first use, seeds it from the root RNG and reaches it through a dynamic TLS slot
+//! afterwards, so the fast path is a TLS load and a ChaCha20 block, without atomics on
+//! shared cache lines. The TLS slot's destructor gives the entry back when its thread
+//! exits, whichever API created the thread; [`release_thread_rng`] does it early.
 //!
-//! All random number generation operations are performed using this seeded RNG,
-//! ensuring consistent and secure random number generation across the application.
-
-// See: https://doc.rust-lang.org/nightly/edition-guide/rust-2024/static-mut-references.html#safe-references
-// TODO: Review the safety of having a global mutable reference to a static variable
-#![allow(static_mut_refs)]
+//! [`reseed`] reseeds the root RNG from the TRNG and makes every thread RNG reseed itself
+//! from it before its next use, e.g. after restoring a suspended process image.
 
 use core::{
+    cell::UnsafeCell,
+    ffi::c_void,
     mem::MaybeUninit,
-    sync::atomic::{AtomicU8, Ordering},
+    ptr,
+    sync::atomic::{AtomicBool, AtomicU32, AtomicUsize, Ordering},
 };
 
+use nx_sys_sync::Mutex;
+use nx_sys_thread_tls::slots;
 use rand::{RngCore, SeedableRng};
 use rand_chacha::ChaCha20Rng;
 
-/// Global RNG instance, initialized on first use.
+use crate::{chacha, fast::Xoshiro256PlusPlus};
+
+/// Maximum number of threads with their own RNG at the same time.
+///
+/// Further threads share the root RNG, behind its mutex.
+pub const MAX_THREAD_RNGS: usize = 32;
+
+/// Root RNG, seeding the thread RNGs.
+static ROOT_RNG: RootRng = RootRng::new();
+
+/// Pool of per-thread RNGs.
+static THREAD_RNGS: [ThreadRng; MAX_THREAD_RNGS] = [const { ThreadRng::new() }; MAX_THREAD_RNGS];
+
+/// Reseed generation: thread RNGs seeded in an older generation reseed before use.
+static RESEED_EPOCH: AtomicU32 = AtomicU32::new(0);
+
+/// The TLS slot holding each thread's [`ThreadRng`] pointer, encoded as `slot ID + 1`.
 ///
-/// Uses [`MaybeUninit`] to safely handle initialization
-static mut RNG: MaybeUninit<ChaCha20Rng> = MaybeUninit::uninit();
+/// `0` means not yet reserved and [`SLOT_UNAVAILABLE`] means no slot could be reserved,
+/// in which case every thread uses the root RNG.
+static TLS_SLOT: AtomicUsize = AtomicUsize::new(0);
 
-/// Atomic state for the RNG initialization
-static RNG_STATE: AtomicRngState = AtomicRngState::new();
+/// Marker stored in [`TLS_SLOT`] when all TLS slots are taken.
+const SLOT_UNAVAILABLE: usize = usize::MAX;
 
 /// Fills a buffer with random data.
 ///
 /// This function is thread-safe and uses the ChaCha20 algorithm for generating
-/// random numbers. The entropy is sourced from the kernel's TRNG.
+/// random numbers. The entropy is sourced from the kernel's TRNG. Large buffers are
+/// filled several blocks at a time, directly in place.
 ///
 /// # Arguments
 ///
 /// * `slice` - The buffer to fill with random data
 pub fn fill_bytes(slice: &mut [u8]) {
-    get_rng().fill_bytes(slice);
+    with_rng(|rng| chacha::fill_bytes(rng, slice));
 }
 
 /// Returns a random 64-bit value.
@@ -61,131 +80,311 @@ pub fn fill_bytes(slice: &mut [u8]) {
 /// This function is thread-safe and uses the ChaCha20 algorithm for generating
 /// random numbers. The entropy is sourced from the kernel's TRNG.
 pub fn next_u64() -> u64 {
-    get_rng().next_u64()
+    with_rng(|rng| rng.next_u64())
 }
 
-/// Returns a reference to the global RNG instance, initializing it if necessary.
+/// Reseeds the root RNG from the system TRNG, and every thread RNG from the root RNG
+/// before its next use.
 ///
-/// This function ensures that the RNG is initialized only once, even in the presence
-/// of multiple threads. The initialization is performed using entropy from the
-/// system's TRNG.
+/// # Panics
 ///
-/// # Implementation Details
+/// Panics if it fails to obtain entropy from the system TRNG.
+pub fn reseed() {
+    ROOT_RNG.with(|rng| *rng = trng_seeded_rng());
+    RESEED_EPOCH.fetch_add(1, Ordering::Release);
+}
+
+/// Releases the current thread's RNG, wiping its state.
 ///
-/// The function uses a state machine to handle initialization:
-/// 1. If the RNG is uninitialized, it attempts to claim initialization
-/// 2. If another thread is initializing, it waits using a spin loop
-/// 3. Once initialized, it returns a reference to the RNG
-fn get_rng() -> &'static mut ChaCha20Rng {
-    loop {
-        match RNG_STATE.load_acquire() {
-            RngState::Uninitialized => {
-                if RNG_STATE.try_claim_initialization().is_err() {
-                    continue;
-                }
+/// The entry is released on thread exit anyway, by the destructor of the TLS slot. A later
+/// call on the same thread transparently claims a new one.
+pub fn release_thread_rng() {
+    let Some(slot_id) = tls_slot_id() else {
+        return;
+    };
 
-                // We've claimed initialization, so initialize the RNG
-                init_rng();
-                RNG_STATE.mark_as_initialized();
+    let entry = slots::get(slot_id).cast::<ThreadRng>();
+    if entry.is_null() {
+        return;
+    }
 
-                break;
-            }
-            RngState::Initializing => {
-                // Someone else is initializing, wait
-                core::hint::spin_loop();
-            }
-            RngState::Initialized => {
-                // Already initialized
-                break;
-            }
+    // SAFETY: The slot was reserved by this module and the stored value is replaced by
+    // null before the entry is released.
+    unsafe { slots::set(slot_id, ptr::null_mut()) };
+
+    // SAFETY: The entry was claimed by the current thread and detached from its TLS slot.
+    unsafe { (*entry).release() };
+}
+
+/// Runs `f` with the current thread's fast, non-cryptographic RNG.
+///
+/// Threads without a thread RNG get a throwaway generator seeded from the root RNG.
+#[inline]
+pub(crate) fn with_fast_rng<R>(f: impl FnOnce(&mut Xoshiro256PlusPlus) -> R) -> R {
+    match current_thread_rng() {
+        // SAFETY: The entry is owned by the current thread, and `f` cannot reach it again.
+        Some(entry) => f(unsafe { (*entry).fast_mut() }),
+        None => {
+            let mut seed = [0u8; 32];
+            ROOT_RNG.with(|rng| rng.fill_bytes(&mut seed));
+            f(&mut Xoshiro256PlusPlus::from_seed(seed))
         }
     }
+}
+
+/// Runs `f` with the current thread's RNG.
+#[inline]
+fn with_rng<R>(f: impl FnOnce(&mut ChaCha20Rng) -> R) -> R {
+    match current_thread_rng() {
+        // SAFETY: The entry is owned by the current thread, and `f` cannot reach it again.
+        Some(entry) => f(unsafe { (*entry).rng_mut() }),
+        None => ROOT_RNG.with(f),
+    }
+}
+
+/// Returns the current thread's RNG, claiming and seeding one on first use.
+///
+/// Returns `None` if no TLS slot or pool entry is available.
+#[inline]
+fn current_thread_rng() -> Option<*mut ThreadRng> {
+    let slot_id = tls_slot_id()?;
+
+    let entry = slots::get(slot_id).cast::<ThreadRng>();
+    if entry.is_null() {
+        return claim_thread_rng(slot_id);
+    }
+
+    // SAFETY: The entry is claimed by the current thread.
+    unsafe { (*entry).reseed_if_stale() };
+    Some(entry)
+}
+
+/// Claims, seeds and installs a pool entry for the current thread.
+#[cold]
+fn claim_thread_rng(slot_id: usize) -> Option<*mut ThreadRng> {
+    let entry = THREAD_RNGS.iter().find(|entry| entry.try_claim())?;
+    let entry = ptr::from_ref(entry).cast_mut();
+
+    // SAFETY: The entry was just claimed by the current thread.
+    unsafe { (*entry).seed() };
+
+    // SAFETY: The slot is reserved by this module and its value for this thread was null.
+    unsafe { slots::set(slot_id, entry.cast()) };
+
+    Some(entry)
+}
+
+/// Returns the TLS slot ID holding the thread RNG pointer, reserving it on first use.
+#[inline]
+fn tls_slot_id() -> Option<usize> {
+    match TLS_SLOT.load(Ordering::Acquire) {
+        0 => reserve_tls_slot(),
+        SLOT_UNAVAILABLE => None,
+        encoded => Some(encoded - 1),
+    }
+}
+
+/// Reserves the process-wide TLS slot used by the thread RNGs.
+#[cold]
+fn reserve_tls_slot() -> Option<usize> {
+    let Some(slot_id) = slots::alloc_with_destructor(Some(release_entry)) else {
+        // Another thread may have raced us to the last free slot: keep its result
+        let _ = TLS_SLOT.compare_exchange(0, SLOT_UNAVAILABLE, Ordering::AcqRel, Ordering::Acquire);
+        return tls_slot_id_after_race();
+    };
 
-    unsafe { RNG.assume_init_mut() }
+    match TLS_SLOT.compare_exchange(0, slot_id + 1, Ordering::AcqRel, Ordering::Acquire) {
+        Ok(_) => Some(slot_id),
+        Err(_) => {
+            // Lost the race; give our slot back and use the winner's
+            // SAFETY: The slot was reserved above and never published.
+            unsafe { slots::free(slot_id) };
+            tls_slot_id_after_race()
+        }
+    }
 }
 
-/// Initializes the global RNG with entropy from the system TRNG.
+/// Destructor of the TLS slot, giving the exiting thread's entry back to the pool.
 ///
-/// This function:
-/// 1. Collects 256 bits of entropy from the system TRNG
-/// 2. Uses this entropy to seed a ChaCha20 RNG
-/// 3. Stores the RNG in the global static variable
+/// # Safety
+///
+/// `value` must be the entry the exiting thread claimed, already detached from its slot.
+unsafe extern "C" fn release_entry(value: *mut c_void) {
+    // SAFETY: The caller guarantees `value` is the thread's detached entry.
+    unsafe { (*value.cast::<ThreadRng>()).release() };
+}
+
+/// Decodes [`TLS_SLOT`] once it has been settled by some thread.
+fn tls_slot_id_after_race() -> Option<usize> {
+    match TLS_SLOT.load(Ordering::Acquire) {
+        0 | SLOT_UNAVAILABLE => None,
+        encoded => Some(encoded - 1),
+    }
+}
+
+/// Creates a ChaCha20 RNG seeded with entropy from the system TRNG.
 ///
 /// # Panics
 ///
 /// This function will panic if it fails to obtain entropy from the system TRNG.
-fn init_rng() {
-    let mut seed = [0u64; 4];
-    for (i, item) in seed.iter_mut().enumerate() {
+fn trng_seeded_rng() -> ChaCha20Rng {
+    let mut seed = [0u8; 32];
+    for (i, chunk) in seed.chunks_exact_mut(8).enumerate() {
         // Get process TRNG seeds from kernel using the new helper
         match nx_svc::misc::get_random_entropy(i as u64) {
-            Ok(val) => *item = val,
+            Ok(val) => chunk.copy_from_slice(&val.to_le_bytes()),
             Err(err) => panic!("Failed to get random entropy: {}", err),
         }
     }
 
-    unsafe {
-        RNG.write(ChaCha20Rng::from_seed(core::mem::transmute::<
-            [u64; 4],
-            [u8; 32],
-        >(seed)));
+    ChaCha20Rng::from_seed(seed)
+}
+
+/// The mutex-protected root RNG, initialized from the TRNG on first use.
+struct RootRng {
+    lock: Mutex,
+    initialized: UnsafeCell<bool>,
+    rng: UnsafeCell<MaybeUninit<ChaCha20Rng>>,
+}
+
+// SAFETY: The RNG state is only accessed with `lock` held.
+unsafe impl Sync for RootRng {}
+
+impl RootRng {
+    const fn new() -> Self {
+        Self {
+            lock: Mutex::new(),
+            initialized: UnsafeCell::new(false),
+            rng: UnsafeCell::new(MaybeUninit::uninit()),
+        }
+    }
+
+    /// Runs `f` with the root RNG locked, initializing it if necessary.
+    fn with<R>(&self, f: impl FnOnce(&mut ChaCha20Rng) -> R) -> R {
+        self.lock.lock();
+
+        // SAFETY: The lock is held, so no other thread accesses the state.
+        let rng = unsafe {
+            let rng = &mut *self.rng.get();
+            if !*self.initialized.get() {
+                rng.write(trng_seeded_rng());
+                *self.initialized.get() = true;
+            }
+            rng.assume_init_mut()
+        };
+        let result = f(rng);
+
+        self.lock.unlock();
+        result
     }
 }
 
-/// The initialization state of the RNG
-#[repr(u8)]
-#[derive(Debug, Clone, Copy, PartialEq, Eq)]
-enum RngState {
-    /// RNG has not been initialized yet
-    Uninitialized = 0,
-    /// RNG is currently being initialized
-    Initializing = 1,
-    /// RNG has been initialized and is ready to use
-    Initialized = 2,
+/// A pool entry holding one thread's RNGs.
+///
+/// Cache-line aligned, so threads never write to a line another thread's RNG sits on.
+#[repr(C, align(64))]
+struct ThreadRng {
+    /// RNG state, only accessed by the thread that claimed the entry.
+    rng: UnsafeCell<MaybeUninit<ChaCha20Rng>>,
+    /// Fast RNG state, seeded from `rng`.
+    fast: UnsafeCell<MaybeUninit<Xoshiro256PlusPlus>>,
+    /// [`RESEED_EPOCH`] the RNG was seeded in.
+    epoch: UnsafeCell<u32>,
+    claimed: AtomicBool,
 }
 
-/// A thread-safe wrapper around [`RngState`]
-#[derive(Debug)]
-struct AtomicRngState(AtomicU8);
+// SAFETY: Only the thread that claimed the entry accesses its RNG state.
+unsafe impl Sync for ThreadRng {}
 
-impl AtomicRngState {
-    /// Creates a new [`AtomicRngState`] with the initial state of [`RngState::Uninitialized`]
+impl ThreadRng {
     const fn new() -> Self {
-        Self(AtomicU8::new(RngState::Uninitialized as u8))
+        Self {
+            rng: UnsafeCell::new(MaybeUninit::uninit()),
+            fast: UnsafeCell::new(MaybeUninit::uninit()),
+            epoch: UnsafeCell::new(0),
+            claimed: AtomicBool::new(false),
+        }
     }
 
-    /// Loads the current state with acquire ordering
-    fn load_acquire(&self) -> RngState {
-        match self.0.load(Ordering::Acquire) {
-            0 => RngState::Uninitialized,
-            1 => RngState::Initializing,
-            2 => RngState::Initialized,
-            _ => unreachable!(),
+    /// Claims the entry for the current thread, returning `false` if it is taken.
+    fn try_claim(&self) -> bool {
+        !self.claimed.load(Ordering::Relaxed)
+            && self
+                .claimed
+                .compare_exchange(false, true, Ordering::Acquire, Ordering::Relaxed)
+                .is_ok()
+    }
+
+    /// Seeds the RNG from the root RNG, and the fast RNG from the RNG.
+    ///
+    /// # Safety
+    ///
+    /// The entry must be claimed by the current thread.
+    unsafe fn seed(&self) {
+        let epoch = RESEED_EPOCH.load(Ordering::Acquire);
+        let mut seed = [0u8; 32];
+        ROOT_RNG.with(|root| root.fill_bytes(&mut seed));
+
+        let mut rng = ChaCha20Rng::from_seed(seed);
+        rng.fill_bytes(&mut seed);
+
+        // SAFETY: The caller owns the entry.
+        unsafe {
+            (*self.rng.get()).write(rng);
+            (*self.fast.get()).write(Xoshiro256PlusPlus::from_seed(seed));
+            *self.epoch.get() = epoch;
         }
     }
 
-    /// Tries to claim initialization of the RNG.
+    /// Reseeds the RNG if [`reseed`] was called since it was seeded.
+    ///
+    /// # Safety
     ///
-    /// This function atomically attempts to transition the RNG state from
-    /// [`RngState::Uninitialized`] to [`RngState::Initializing`].
+    /// The entry must be claimed and seeded by the current thread.
+    #[inline]
+    unsafe fn reseed_if_stale(&self) {
+        // SAFETY: The caller owns the entry.
+        if unsafe { *self.epoch.get() } != RESEED_EPOCH.load(Ordering::Relaxed) {
+            // SAFETY: The caller owns the entry.
+            unsafe { self.seed() };
+        }
+    }
+
+    /// Returns the RNG.
     ///
-    /// # Returns
+    /// # Safety
     ///
-    /// * `Ok(())` if the transition was successful
-    /// * `Err(())` if another thread has already claimed initialization
-    fn try_claim_initialization(&self) -> Result<(), ()> {
-        self.0
-            .compare_exchange(
-                RngState::Uninitialized as u8,
-                RngState::Initializing as u8,
-                Ordering::AcqRel,
-                Ordering::Acquire,
-            )
-            .map_or_else(|_| Err(()), |_| Ok(()))
-    }
-
-    /// Marks the RNG as initialized with release ordering
-    fn mark_as_initialized(&self) {
-        self.0.store(RngState::Initialized as u8, Ordering::Release);
+    /// The entry must be claimed and seeded by the current thread, and the returned
+    /// reference must not outlive the claim.
+    #[inline]
+    unsafe fn rng_mut(&self) -> &mut ChaCha20Rng {
+        // SAFETY: The caller owns the seeded entry.
+        unsafe { (*self.rng.get()).assume_init_mut() }
+    }
+
+    /// Returns the fast RNG.
+    ///
+    /// # Safety
+    ///
+    /// Same as [`rng_mut`](Self::rng_mut).
+    #[inline]
+    unsafe fn fast_mut(&self) -> &mut Xoshiro256PlusPlus {
+        // SAFETY: The caller owns the seeded entry.
+        unsafe { (*self.fast.get()).assume_init_mut() }
+    }
+
+    /// Wipes the RNG state and gives the entry back to the pool.
+    ///
+    /// # Safety
+    ///
+    /// The entry must be claimed by the current thread and no longer reachable from it.
+    unsafe fn release(&self) {
+        // SAFETY: The caller owns the entry; the volatile write keeps the wipe from being
+        // optimized out.
+        unsafe {
+            ptr::write_volatile(self.rng.get(), MaybeUninit::zeroed());
+            ptr::write_volatile(self.fast.get(), MaybeUninit::zeroed());
+        }
+        self.claimed.store(false, Ordering::Release);
     }
 }
@@ -166,3 +166,25 @@ pub unsafe extern "C" fn __nx_rt__hid_initialize_gesture() {
         let _ = service.activate_gesture();
     }
 }
+
+/// Refreshes `snapshot` with the newest state of all the input devices.
+///
+/// Returns the bitmask of the devices that changed, or 0 if the HID service is
+/// not initialized. This is not in libnx; `snapshot` must point to an
+/// `HidSnapshot` kept by the caller between calls.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_rt__hid_snapshot_all(
+    snapshot: *mut nx_service_hid::shmem::HidSnapshot,
+) -> u32 {
+    if snapshot.is_null() {
+        return 0;
+    }
+
+    // SAFETY: Caller guarantees snapshot points to a valid, exclusive HidSnapshot.
+    let snapshot = unsafe { &mut *snapshot };
+
+    match crate::hid_manager::get_service() {
+        Some(service) => service.snapshot_all(snapshot),
+        None => 0,
+    }
+}
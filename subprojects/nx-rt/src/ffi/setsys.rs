@@ -39,16 +39,13 @@ pub unsafe extern "C" fn __nx_rt__setsys_exit() {
 ///
 /// # Safety
 ///
-/// set:sys must be initialized. The returned pointer points to the Arc-stored
+/// set:sys must be initialized. The returned pointer points to the registry-stored
 /// session and remains valid as long as the service session is alive.
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn __nx_rt__setsys_get_service_session() -> *mut Service {
-    let Some(setsys) = service_registry::setsys_get() else {
-        return core::ptr::null_mut();
-    };
-
-    // Cast Arc<SetSysService> to *mut Service (SetSysService is repr(transparent))
-    alloc::sync::Arc::as_ptr(&setsys) as *mut Service
+    // Cast &SetSysService to *mut Service (SetSysService is repr(transparent))
+    service_registry::setsys_with(|setsys| core::ptr::from_ref(setsys) as *mut Service)
+        .unwrap_or(core::ptr::null_mut())
 }
 
 /// Gets the system firmware version. Returns 0 on success, error code on failure.
@@ -66,11 +63,11 @@ pub unsafe extern "C" fn __nx_rt__setsys_get_firmware_version(
         return GENERIC_ERROR;
     }
 
-    let Some(setsys) = service_registry::setsys_get() else {
+    let Some(res) = service_registry::setsys_get_firmware_version() else {
         return GENERIC_ERROR;
     };
 
-    let fw = match setsys.get_firmware_version_cmif() {
+    let fw = match res {
         Ok(fw) => fw,
         Err(err) => return setsys_get_firmware_version_error_to_rc(err),
     };
@@ -102,13 +99,22 @@ fn setsys_connect_error_to_rc(err: service_registry::SetsysConnectError) -> u32
 }
 
 fn setsys_get_firmware_version_error_to_rc(
-    err: nx_service_set::GetFirmwareVersionCmifError,
+    err: service_registry::SetsysGetFirmwareVersionError,
 ) -> u32 {
     match err {
-        nx_service_set::GetFirmwareVersionCmifError::SendRequest(e) => e.to_rc(),
-        nx_service_set::GetFirmwareVersionCmifError::ParseResponse(e) => match e {
-            cmif::ParseResponseError::InvalidMagic => GENERIC_ERROR,
-            cmif::ParseResponseError::ServiceError(code) => code,
+        service_registry::SetsysGetFirmwareVersionError::Cmif(e) => match e {
+            nx_service_set::GetFirmwareVersionCmifError::SendRequest(e) => e.to_rc(),
+            nx_service_set::GetFirmwareVersionCmifError::ParseResponse(e) => match e {
+                cmif::ParseResponseError::InvalidMagic => GENERIC_ERROR,
+                cmif::ParseResponseError::ServiceError(code) => code,
+            },
+        },
+        service_registry::SetsysGetFirmwareVersionError::Tipc(e) => match e {
+            nx_service_set::GetFirmwareVersionTipcError::SendRequest(e) => e.to_rc(),
+            nx_service_set::GetFirmwareVersionTipcError::ParseResponse(e) => match e {
+                tipc::ParseResponseError::EmptyResponse => GENERIC_ERROR,
+                tipc::ParseResponseError::ServiceError(code) => code,
+            },
         },
     }
 }
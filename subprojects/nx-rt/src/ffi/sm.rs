@@ -320,13 +320,23 @@ fn sm_initialize_error_to_rc(err: service_manager::InitializeError) -> u32 {
 fn sm_get_service_error_to_rc(err: service_manager::GetServiceError) -> u32 {
     use nx_svc::error::ToRawResultCode;
 
-    match err.0 {
-        nx_service_sm::GetServiceCmifError::SendRequest(e) => e.to_rc(),
-        nx_service_sm::GetServiceCmifError::ParseResponse(e) => match e {
-            cmif::ParseResponseError::InvalidMagic => GENERIC_ERROR,
-            cmif::ParseResponseError::ServiceError(code) => code,
+    match err {
+        service_manager::GetServiceError::Cmif(e) => match e {
+            nx_service_sm::GetServiceCmifError::SendRequest(e) => e.to_rc(),
+            nx_service_sm::GetServiceCmifError::ParseResponse(e) => match e {
+                cmif::ParseResponseError::InvalidMagic => GENERIC_ERROR,
+                cmif::ParseResponseError::ServiceError(code) => code,
+            },
+            nx_service_sm::GetServiceCmifError::MissingHandle => GENERIC_ERROR,
+        },
+        service_manager::GetServiceError::Tipc(e) => match e {
+            nx_service_sm::GetServiceTipcError::SendRequest(e) => e.to_rc(),
+            nx_service_sm::GetServiceTipcError::ParseResponse(e) => match e {
+                tipc::ParseResponseError::EmptyResponse => GENERIC_ERROR,
+                tipc::ParseResponseError::ServiceError(code) => code,
+            },
+            nx_service_sm::GetServiceTipcError::MissingHandle => GENERIC_ERROR,
         },
-        nx_service_sm::GetServiceCmifError::MissingHandle => GENERIC_ERROR,
     }
 }
 
@@ -113,6 +113,16 @@ pub unsafe extern "C" fn __nx_rt__time_to_calendar_time_with_my_rule(
         return GENERIC_ERROR;
     }
 
+    // Convert in-process with the cached device rule when it is available
+    if let Some(zone) = crate::time_manager::local_time_zone() {
+        let (cal, inf) = zone.to_calendar_time(timestamp as i64);
+        unsafe {
+            *caltime = cal;
+            *info = inf;
+        }
+        return 0;
+    }
+
     match crate::time_manager::get_service() {
         Some(service) => match service.to_calendar_time_with_my_rule(timestamp) {
             Ok((cal, inf)) => {
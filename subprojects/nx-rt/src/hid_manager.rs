@@ -2,11 +2,23 @@
 //!
 //! This module manages the HID service session and provides a singleton interface
 //! for accessing HID functionality throughout the application lifecycle.
+//!
+//! It also provides input notification: once a source is set with
+//! [`set_input_notify_timer`] or [`set_input_notify_vsync`], threads can sleep
+//! in [`wait_input`] until the sampling number of a device advances, instead
+//! of polling the shared memory. One of the waiting threads samples the shared
+//! memory on each tick of the source; the others sleep on a futex until it
+//! sees new input.
+
+use core::sync::atomic::{AtomicU32, Ordering};
 
-use nx_service_hid::HidService;
-use nx_std_sync::{once_lock::OnceLock, rwlock::RwLock};
+use nx_service_hid::{HidService, shmem::HidSnapshot};
+use nx_service_vi::{DisplayId, GetDisplayVsyncEventError};
+use nx_std_sync::{mutex::Mutex, once_lock::OnceLock, rwlock::RwLock};
+use nx_svc::sync::{self as svc_sync, EventHandle};
+use nx_sys_sync::futex;
 
-use crate::{applet_manager, service_manager};
+use crate::{applet_manager, service_manager, vi_manager};
 
 /// Global HID state, lazily initialized.
 static HID_STATE: OnceLock<RwLock<Option<HidState>>> = OnceLock::new();
@@ -83,3 +95,163 @@ pub enum ConnectError {
     #[error("failed to connect to HID service")]
     Connect(#[source] nx_service_hid::ConnectError),
 }
+
+/// Period used to re-check the sampler while waiting for a vsync, and the
+/// maximum time a vsync wait lasts (about one frame at 60 Hz).
+const VSYNC_PERIOD_NS: u64 = 16_666_667;
+
+/// Global input notification state, lazily initialized.
+static INPUT_NOTIFY: OnceLock<InputNotify> = OnceLock::new();
+
+/// Returns a reference to the input notification state, initializing it if needed.
+fn input_notify() -> &'static InputNotify {
+    INPUT_NOTIFY.get_or_init(|| InputNotify {
+        generation: AtomicU32::new(0),
+        source: RwLock::new(None),
+        sampler: Mutex::new(HidSnapshot::default()),
+    })
+}
+
+/// Source of the ticks at which the shared memory is sampled for [`wait_input`].
+#[derive(Debug, Clone, Copy)]
+enum InputNotifySource {
+    /// Sample every `period_ns` nanoseconds.
+    Timer { period_ns: u64 },
+    /// Sample on every vsync of a display. The event handle is owned.
+    Vsync(EventHandle),
+}
+
+impl InputNotifySource {
+    /// Returns the expected time between two ticks.
+    fn period_ns(&self) -> u64 {
+        match *self {
+            InputNotifySource::Timer { period_ns } => period_ns,
+            InputNotifySource::Vsync(_) => VSYNC_PERIOD_NS,
+        }
+    }
+}
+
+/// Internal storage for input notification.
+struct InputNotify {
+    /// Incremented each time the sampler sees new input; waiters sleep on it.
+    generation: AtomicU32,
+    /// Current tick source, `None` when notification is disabled.
+    source: RwLock<Option<InputNotifySource>>,
+    /// Last snapshot taken. Holding the lock makes a thread the sampler.
+    sampler: Mutex<HidSnapshot>,
+}
+
+/// Samples input every `period_ns` nanoseconds for [`wait_input`].
+///
+/// Replaces the previous notification source.
+pub fn set_input_notify_timer(period_ns: u64) {
+    replace_input_notify_source(Some(InputNotifySource::Timer {
+        period_ns: period_ns.max(1),
+    }));
+}
+
+/// Samples input on every vsync of `display_id` for [`wait_input`].
+///
+/// Replaces the previous notification source. The display must have been
+/// opened through the VI manager.
+pub fn set_input_notify_vsync(display_id: DisplayId) -> Result<(), InputNotifyError> {
+    let vi = vi_manager::get_service().ok_or(InputNotifyError::ViNotInitialized)?;
+    let raw = vi
+        .get_display_vsync_event(display_id)
+        .map_err(InputNotifyError::GetVsyncEvent)?;
+    drop(vi);
+
+    // SAFETY: The handle was just returned by VI and is owned by us.
+    let event = unsafe { EventHandle::from_raw(raw) };
+    replace_input_notify_source(Some(InputNotifySource::Vsync(event)));
+    Ok(())
+}
+
+/// Disables input notification.
+///
+/// Threads blocked in [`wait_input`] are woken; later calls return `None`.
+pub fn disable_input_notify() {
+    replace_input_notify_source(None);
+}
+
+/// Returns the current input generation, to pass to [`wait_input`].
+pub fn input_generation() -> u32 {
+    input_notify().generation.load(Ordering::Acquire)
+}
+
+/// Blocks until new input arrives after generation `seen`.
+///
+/// Returns the new generation, or `None` if input notification is disabled or
+/// the HID service is not initialized. A single generation may cover new
+/// samples from several devices; read them with
+/// [`HidService::snapshot_all`](nx_service_hid::HidService::snapshot_all).
+/// Changing the notification source also starts a new generation.
+pub fn wait_input(seen: u32) -> Option<u32> {
+    let notify = input_notify();
+    loop {
+        let generation = notify.generation.load(Ordering::Acquire);
+        if generation != seen {
+            return Some(generation);
+        }
+
+        // Hold the source for the whole tick, so it cannot be closed while sampled
+        let source_guard = notify.source.read();
+        let source = (*source_guard)?;
+
+        match notify.sampler.try_lock() {
+            Ok(mut snapshot) => {
+                wait_tick(&source);
+                let service = get_service()?;
+                if service.snapshot_all(&mut snapshot) != 0 {
+                    notify.generation.fetch_add(1, Ordering::Release);
+                    futex::wake_all(&notify.generation);
+                }
+            }
+            Err(_) => {
+                drop(source_guard);
+                // Bounded, so a waiter takes over sampling if the sampler returns
+                futex::wait_timeout(&notify.generation, seen, source.period_ns());
+            }
+        }
+    }
+}
+
+/// Blocks until the next tick of `source`.
+fn wait_tick(source: &InputNotifySource) {
+    match source {
+        InputNotifySource::Timer { period_ns } => nx_svc::thread::sleep(*period_ns),
+        InputNotifySource::Vsync(event) => {
+            // SAFETY: The event is owned by the notification source, which cannot be
+            // replaced while its read lock is held.
+            if unsafe { svc_sync::wait_synchronization_single(event, VSYNC_PERIOD_NS) }.is_ok() {
+                // SAFETY: See above.
+                let _ = unsafe { svc_sync::reset_signal(event) };
+            }
+        }
+    }
+}
+
+/// Sets the notification source, closing the vsync event of the previous one.
+fn replace_input_notify_source(source: Option<InputNotifySource>) {
+    let notify = input_notify();
+    let previous = core::mem::replace(&mut *notify.source.write(), source);
+    if let Some(InputNotifySource::Vsync(event)) = previous {
+        // SAFETY: The event is owned by the replaced source and no longer used.
+        let _ = unsafe { nx_svc::raw::close_handle(event.to_raw()) };
+    }
+
+    // Wake the waiters to pick up the new source
+    notify.generation.fetch_add(1, Ordering::Release);
+    futex::wake_all(&notify.generation);
+}
+
+/// Error returned by [`set_input_notify_vsync`].
+#[derive(Debug, thiserror::Error)]
+pub enum InputNotifyError {
+    /// VI service is not initialized.
+    #[error("VI service not initialized")]
+    ViNotInitialized,
+    /// Failed to get the display vsync event.
+    #[error("failed to get display vsync event")]
+    GetVsyncEvent(#[source] GetDisplayVsyncEventError),
+}
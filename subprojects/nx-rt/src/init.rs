@@ -1,6 +1,14 @@
 //! Runtime initialization functions.
 
-use crate::env::heap_override;
+use alloc::{boxed::Box, vec::Vec};
+use core::{ffi::c_void, ptr::NonNull};
+
+use nx_sys_thread::{
+    WaitForExitError,
+    pool::{self, PooledThread},
+};
+
+use crate::{apm_manager, env::heap_override, hid_manager, nv_manager, time_manager, vi_manager};
 
 /// Initialize the allocator heap.
 ///
@@ -16,3 +24,170 @@ pub fn setup_heap() {
         }
     }
 }
+
+/// Services connected by [`connect_services`].
+#[derive(Debug, Clone, Copy, Default)]
+pub struct StartupServices {
+    /// HID, through [`hid_manager::init`].
+    pub hid: bool,
+    /// Time, through [`time_manager::init`].
+    pub time: bool,
+    /// VI, through [`vi_manager::init_with_config`].
+    pub vi: bool,
+    /// NV, through [`nv_manager::init_default`].
+    pub nv: bool,
+    /// APM, through [`apm_manager::init`].
+    pub apm: bool,
+}
+
+impl StartupServices {
+    /// Every service [`connect_services`] knows of.
+    pub const ALL: Self = Self {
+        hid: true,
+        time: true,
+        vi: true,
+        nv: true,
+        apm: true,
+    };
+}
+
+/// Stack size of the threads connecting services.
+const CONNECT_STACK_SIZE: usize = 0x8000;
+
+/// Priority of the threads connecting services, the default one.
+const CONNECT_PRIORITY: i32 = 0x2C;
+
+/// Runs the connecting threads on the default core of the process: they mostly wait on
+/// IPC replies, so they overlap without needing cores of their own.
+const CONNECT_CPUID: i32 = -2;
+
+/// Connects the selected `services` concurrently, one thread per service.
+///
+/// Connecting a service takes several IPC round trips after its SM lookup (sub-interface
+/// opens, shared memory and event handles), which the threads overlap instead of running
+/// one after another. Each service is stored by its manager as with its own `init`. The
+/// applet service must be connected first, as HID and NV use its applet resource user ID.
+///
+/// Returns the first error in field order, once every connection finished; the services
+/// that did connect stay initialized.
+///
+/// # Panics
+///
+/// Panics if SM is not initialized.
+pub fn connect_services(services: StartupServices) -> Result<(), StartupError> {
+    let connects: [(bool, fn() -> Result<(), StartupError>); 5] = [
+        (services.hid, || {
+            hid_manager::init().map_err(StartupError::Hid)
+        }),
+        (services.time, || {
+            time_manager::init().map_err(StartupError::Time)
+        }),
+        (services.vi, || {
+            vi_manager::init_with_config().map_err(StartupError::Vi)
+        }),
+        (services.nv, || {
+            nv_manager::init_default().map_err(StartupError::Nv)
+        }),
+        (services.apm, || {
+            apm_manager::init().map_err(StartupError::Apm)
+        }),
+    ];
+
+    let mut selected = connects
+        .into_iter()
+        .filter(|(selected, _)| *selected)
+        .map(|(_, connect)| connect);
+
+    // The calling thread connects the last service, rather than only wait
+    let inline = selected.next_back();
+    let tasks = selected.map(ConnectTask::spawn).collect::<Vec<_>>();
+    let inline_res = inline.map_or(Ok(()), |connect| connect());
+
+    tasks
+        .into_iter()
+        .map(ConnectTask::join)
+        .fold(Ok(()), |res, joined| res.and(joined))
+        .and(inline_res)
+}
+
+/// A service connection, run on a pooled thread, or on the calling one if no thread
+/// could be started.
+struct ConnectTask {
+    /// Connection and result, shared with the thread, from `Box::into_raw`.
+    state: NonNull<ConnectState>,
+    thread: Option<PooledThread>,
+}
+
+struct ConnectState {
+    connect: fn() -> Result<(), StartupError>,
+    result: Option<Result<(), StartupError>>,
+}
+
+impl ConnectTask {
+    fn spawn(connect: fn() -> Result<(), StartupError>) -> Self {
+        let state = NonNull::from(Box::leak(Box::new(ConnectState {
+            connect,
+            result: None,
+        })));
+
+        // SAFETY: The state is only released once the thread is joined, and leaked if
+        // joining fails.
+        let spawned = unsafe {
+            pool::spawn(
+                connect_thread,
+                state.as_ptr().cast(),
+                CONNECT_STACK_SIZE,
+                CONNECT_PRIORITY,
+                CONNECT_CPUID,
+            )
+        };
+        let thread = spawned
+            .ok()
+            .and_then(|mut thread| thread.start().is_ok().then_some(thread));
+
+        Self { state, thread }
+    }
+
+    fn join(self) -> Result<(), StartupError> {
+        if let Some(thread) = self.thread
+            && let Err(err) = thread.join()
+        {
+            // The thread may still use the state: leak it
+            return Err(StartupError::Join(err));
+        }
+
+        // SAFETY: The state comes from `Box::leak`, and no thread uses it anymore.
+        let mut state = unsafe { Box::from_raw(self.state.as_ptr()) };
+        state.result.take().unwrap_or_else(|| (state.connect)())
+    }
+}
+
+/// Entry point of the threads connecting services.
+unsafe extern "C" fn connect_thread(arg: *mut c_void) {
+    // SAFETY: `ConnectTask::spawn` passes its leaked state, not accessed until joined.
+    let state = unsafe { &mut *arg.cast::<ConnectState>() };
+    state.result = Some((state.connect)());
+}
+
+/// Error returned by [`connect_services`].
+#[derive(Debug, thiserror::Error)]
+pub enum StartupError {
+    /// Connecting HID failed.
+    #[error("failed to connect HID")]
+    Hid(#[source] hid_manager::ConnectError),
+    /// Connecting Time failed.
+    #[error("failed to connect Time")]
+    Time(#[source] time_manager::ConnectError),
+    /// Connecting VI failed.
+    #[error("failed to connect VI")]
+    Vi(#[source] vi_manager::ConnectError),
+    /// Connecting NV failed.
+    #[error("failed to connect NV")]
+    Nv(#[source] nv_manager::ConnectError),
+    /// Connecting APM failed.
+    #[error("failed to connect APM")]
+    Apm(#[source] apm_manager::ConnectError),
+    /// Waiting for a connecting thread failed; its service state is unknown.
+    #[error("failed to join a service connection thread")]
+    Join(#[source] WaitForExitError),
+}
@@ -19,8 +19,10 @@ pub mod env;
 pub mod hid_manager;
 pub mod init;
 pub mod nv_manager;
+pub mod profiler;
 pub mod service_manager;
 pub mod service_registry;
 pub mod thread_registry;
 pub mod time_manager;
+pub mod timer;
 pub mod vi_manager;
@@ -8,6 +8,8 @@ use nx_std_sync::{once_lock::OnceLock, rwlock::RwLock};
 
 use crate::{applet_manager, env, service_manager};
 
+pub mod reactor;
+
 /// Global NV state, lazily initialized.
 static NV_STATE: OnceLock<RwLock<Option<NvState>>> = OnceLock::new();
 
@@ -80,7 +82,8 @@ pub fn exit() {
     if let Some(ref mut nv_state) = *guard {
         nv_state.ref_count = nv_state.ref_count.saturating_sub(1);
         if nv_state.ref_count == 0 {
-            // Take and close the service
+            // Fail the pending event waits, then take and close the service
+            reactor::shutdown();
             if let Some(nv_state) = guard.take() {
                 nv_state.service.close();
             }
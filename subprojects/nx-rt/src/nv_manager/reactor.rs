@@ -0,0 +1,426 @@
+//! NV event completion reactor.
+//!
+//! Waiting on an NV event (a syncpoint event from `NvService::query_event`, a GPU error
+//! notifier, ...) blocks the calling thread. The reactor instead hands the waits to a
+//! completion thread, which waits on all of them with a single `svcWaitSynchronization`
+//! and, as each event signals, resets it and runs its callback or wakes its future.
+//!
+//! Callbacks run on the completion thread, so they must be short and must not block.
+//!
+//! ```ignore
+//! use nx_rt::nv_manager::reactor;
+//!
+//! reactor::register(event, |res| {
+//!     if res.is_ok() {
+//!         FRAME_DONE.store(true, Ordering::Release);
+//!     }
+//! })?;
+//! ```
+
+use alloc::{boxed::Box, sync::Arc, vec::Vec};
+use core::{
+    ffi::c_void,
+    future::Future,
+    pin::Pin,
+    ptr,
+    sync::atomic::{AtomicBool, AtomicU64, Ordering},
+    task::{Context, Poll, Waker},
+};
+
+use nx_service_nv::fence::{FenceTracker, NvFence};
+use nx_std_sync::{mutex::Mutex, once_lock::OnceLock};
+use nx_svc::{
+    error::{ResultCode, ToRawResultCode},
+    sync::{self as svc_sync, EventHandle, MAX_WAIT_HANDLES, WaitSyncError, WritableEventHandle},
+};
+use nx_sys_thread::pool::{self, PooledThread};
+
+/// Maximum number of events waited on at once; one wait handle is the reactor's own.
+pub const MAX_WAITS: usize = MAX_WAIT_HANDLES - 1;
+
+/// Stack size of the completion thread, which runs the callbacks.
+const THREAD_STACK_SIZE: usize = 0x8000;
+
+/// Priority of the completion thread, above the default one so that completions are
+/// dispatched ahead of the threads they unblock.
+const THREAD_PRIORITY: i32 = 0x2B;
+
+/// Runs the completion thread on the default core of the process.
+const THREAD_CPUID: i32 = -2;
+
+/// Global reactor state, created on first use.
+static REACTOR: OnceLock<Result<Reactor, ResultCode>> = OnceLock::new();
+
+/// Identifier of a registered wait, to [`cancel`] it.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct WaitId(u64);
+
+/// Registers a wait for `event`, running `callback` once it signals.
+///
+/// The event is reset before the callback runs. Its handle stays owned by the caller, and
+/// must remain open until the callback ran or the wait was cancelled.
+pub fn register(
+    event: EventHandle,
+    callback: impl FnOnce(Result<(), WaitError>) + Send + 'static,
+) -> Result<WaitId, ReactorError> {
+    reactor()?.register(event, Completion::Callback(Box::new(callback)))
+}
+
+/// Registers a wait for the `event` signaled when `fence` is reached, tracking its
+/// completion in `fences`.
+///
+/// Fences already known to be signaled run `callback` immediately instead, on the calling
+/// thread, and return `None`.
+pub fn register_fence(
+    fences: &'static FenceTracker,
+    fence: NvFence,
+    event: EventHandle,
+    callback: impl FnOnce(Result<(), WaitError>) + Send + 'static,
+) -> Result<Option<WaitId>, ReactorError> {
+    if fences.is_signaled(fence) {
+        callback(Ok(()));
+        return Ok(None);
+    }
+
+    register(event, move |res| {
+        if res.is_ok() {
+            fences.signal(fence);
+        }
+        callback(res);
+    })
+    .map(Some)
+}
+
+/// Returns a future resolving once `event` signals.
+///
+/// The wait is registered right away. Dropping the future cancels it.
+pub fn wait(event: EventHandle) -> Result<EventWait, ReactorError> {
+    let state = Arc::new(Mutex::new(FutureState {
+        result: None,
+        waker: None,
+    }));
+    let id = reactor()?.register(event, Completion::Future(state.clone()))?;
+    Ok(EventWait { id, state })
+}
+
+/// Cancels the wait `id`.
+///
+/// Returns `true` if the wait was still pending: its callback will not run, and its event
+/// handle can be closed once this returns.
+pub fn cancel(id: WaitId) -> bool {
+    match REACTOR.get() {
+        Some(Ok(reactor)) => reactor.cancel(id),
+        _ => false,
+    }
+}
+
+/// Stops the completion thread, failing the pending waits with [`WaitError::Shutdown`].
+///
+/// The thread is started again by the next registration. Must not be called from a
+/// callback, which runs on the completion thread.
+pub fn shutdown() {
+    if let Some(Ok(reactor)) = REACTOR.get() {
+        reactor.shutdown();
+    }
+}
+
+fn reactor() -> Result<&'static Reactor, ReactorError> {
+    REACTOR
+        .get_or_init(Reactor::new)
+        .as_ref()
+        .map_err(|rc| ReactorError::CreateEvent(*rc))
+}
+
+/// Registered waits and completion thread.
+struct Reactor {
+    /// Writable end of the event interrupting the completion thread wait.
+    wake: WritableEventHandle,
+    /// Readable end of the wake event, always the first wait handle.
+    wake_readable: EventHandle,
+    waits: Mutex<Vec<Wait>>,
+    thread: Mutex<Option<PooledThread>>,
+    shutdown: AtomicBool,
+    next_id: AtomicU64,
+    /// Number of cancelled waits, bumped under the waits lock.
+    ///
+    /// A cancelled handle may be closed while the completion thread still waits on its
+    /// snapshot; a changed count tells an `InvalidHandle` failure apart from a bad wait.
+    cancelled: AtomicU64,
+}
+
+struct Wait {
+    id: WaitId,
+    event: EventHandle,
+    completion: Completion,
+}
+
+enum Completion {
+    Callback(Box<dyn FnOnce(Result<(), WaitError>) + Send>),
+    Future(Arc<Mutex<FutureState>>),
+}
+
+impl Completion {
+    fn complete(self, res: Result<(), WaitError>) {
+        match self {
+            Completion::Callback(callback) => callback(res),
+            Completion::Future(state) => {
+                let mut state = state.lock();
+                state.result = Some(res);
+                if let Some(waker) = state.waker.take() {
+                    waker.wake();
+                }
+            }
+        }
+    }
+}
+
+impl Reactor {
+    fn new() -> Result<Self, ResultCode> {
+        let (wake, wake_readable) = svc_sync::create_event().map_err(|err| err.to_rc())?;
+        Ok(Self {
+            wake,
+            wake_readable,
+            waits: Mutex::new(Vec::new()),
+            thread: Mutex::new(None),
+            shutdown: AtomicBool::new(false),
+            next_id: AtomicU64::new(0),
+            cancelled: AtomicU64::new(0),
+        })
+    }
+
+    fn register(
+        &'static self,
+        event: EventHandle,
+        completion: Completion,
+    ) -> Result<WaitId, ReactorError> {
+        let id = WaitId(self.next_id.fetch_add(1, Ordering::Relaxed));
+        {
+            // Registering under the thread lock keeps the wait from slipping in between a
+            // shutdown failing the pending waits and the thread restarting
+            let mut thread = self.thread.lock();
+            self.ensure_thread(&mut thread)?;
+
+            let mut waits = self.waits.lock();
+            if waits.len() == MAX_WAITS {
+                return Err(ReactorError::Full);
+            }
+            waits.push(Wait {
+                id,
+                event,
+                completion,
+            });
+        }
+
+        self.interrupt();
+        Ok(id)
+    }
+
+    fn cancel(&self, id: WaitId) -> bool {
+        let removed = {
+            let mut waits = self.waits.lock();
+            let removed = waits
+                .iter()
+                .position(|wait| wait.id == id)
+                .map(|index| waits.swap_remove(index));
+            if removed.is_some() {
+                self.cancelled.fetch_add(1, Ordering::Relaxed);
+            }
+            removed
+        };
+
+        match removed {
+            Some(_) => {
+                // Make the completion thread drop the handle from its wait
+                self.interrupt();
+                true
+            }
+            None => false,
+        }
+    }
+
+    fn shutdown(&self) {
+        let thread = {
+            let mut thread = self.thread.lock();
+            let Some(taken) = thread.take() else {
+                return;
+            };
+            self.shutdown.store(true, Ordering::Release);
+            taken
+        };
+
+        // Not holding the thread lock, so that callbacks registering waits meanwhile fail
+        // rather than deadlock
+        self.interrupt();
+        let _ = thread.join();
+
+        let waits = core::mem::take(&mut *self.waits.lock());
+        for wait in waits {
+            wait.completion.complete(Err(WaitError::Shutdown));
+        }
+
+        let _thread = self.thread.lock();
+        self.shutdown.store(false, Ordering::Release);
+    }
+
+    /// Starts the completion thread if it is not running.
+    fn ensure_thread(&'static self, thread: &mut Option<PooledThread>) -> Result<(), ReactorError> {
+        if thread.is_some() {
+            return Ok(());
+        }
+        if self.shutdown.load(Ordering::Acquire) {
+            return Err(ReactorError::ShuttingDown);
+        }
+
+        // SAFETY: The reactor is static, so it outlives the thread.
+        let mut spawned = unsafe {
+            pool::spawn(
+                completion_thread,
+                ptr::from_ref(self).cast_mut().cast(),
+                THREAD_STACK_SIZE,
+                THREAD_PRIORITY,
+                THREAD_CPUID,
+            )
+        }
+        .map_err(ReactorError::Spawn)?;
+        spawned.start().map_err(ReactorError::Start)?;
+
+        *thread = Some(spawned);
+        Ok(())
+    }
+
+    /// Interrupts the completion thread wait, to pick up the new set of waits.
+    fn interrupt(&self) {
+        let _ = svc_sync::signal_event(&self.wake);
+    }
+
+    /// Waits for the registered waits until shut down.
+    fn run(&self) {
+        let mut handles = [self.wake_readable; MAX_WAIT_HANDLES];
+        loop {
+            let (count, cancelled) = {
+                let waits = self.waits.lock();
+                for (handle, wait) in handles[1..].iter_mut().zip(waits.iter()) {
+                    *handle = wait.event;
+                }
+                (1 + waits.len(), self.cancelled.load(Ordering::Relaxed))
+            };
+
+            // SAFETY: The wake event is owned by the reactor, and registered events stay
+            // open until completed or cancelled; a cancelled handle closed before the wait
+            // starts fails it with `InvalidHandle`, which only re-snapshots the waits.
+            let res =
+                unsafe { svc_sync::wait_synchronization_multiple(&handles[..count], u64::MAX) };
+            match res {
+                Ok(0) => {
+                    // SAFETY: The wake event is a readable event owned by the reactor.
+                    let _ = unsafe { svc_sync::reset_signal(&self.wake_readable) };
+                    if self.shutdown.load(Ordering::Acquire) {
+                        return;
+                    }
+                }
+                Ok(index) => self.complete(handles[index], Ok(())),
+                Err(WaitSyncError::Cancelled) => {}
+                Err(WaitSyncError::InvalidHandle)
+                    if self.cancelled.load(Ordering::Relaxed) != cancelled => {}
+                Err(err) => {
+                    // The failing handle is unknown: fail every wait
+                    let rc = err.to_rc();
+                    let waits = core::mem::take(&mut *self.waits.lock());
+                    for wait in waits {
+                        wait.completion.complete(Err(WaitError::Failed(rc)));
+                    }
+                }
+            }
+        }
+    }
+
+    /// Completes the pending wait on `event`, if it was not cancelled meanwhile.
+    fn complete(&self, event: EventHandle, res: Result<(), WaitError>) {
+        let wait = {
+            let mut waits = self.waits.lock();
+            waits
+                .iter()
+                .position(|wait| wait.event == event)
+                .map(|index| waits.swap_remove(index))
+        };
+
+        if let Some(wait) = wait {
+            // SAFETY: The event stays open until its wait is completed.
+            let _ = unsafe { svc_sync::reset_signal(&wait.event) };
+            wait.completion.complete(res);
+        }
+    }
+}
+
+/// Entry point of the completion thread.
+unsafe extern "C" fn completion_thread(arg: *mut c_void) {
+    // SAFETY: `ensure_thread` passes the static reactor.
+    let reactor = unsafe { &*arg.cast::<Reactor>() };
+    reactor.run();
+}
+
+struct FutureState {
+    result: Option<Result<(), WaitError>>,
+    waker: Option<Waker>,
+}
+
+/// Future returned by [`wait`], resolving once its event signals.
+pub struct EventWait {
+    id: WaitId,
+    state: Arc<Mutex<FutureState>>,
+}
+
+impl Future for EventWait {
+    type Output = Result<(), WaitError>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        let mut state = self.state.lock();
+        match state.result.take() {
+            Some(res) => Poll::Ready(res),
+            None => {
+                match &mut state.waker {
+                    Some(waker) => waker.clone_from(cx.waker()),
+                    None => state.waker = Some(cx.waker().clone()),
+                }
+                Poll::Pending
+            }
+        }
+    }
+}
+
+impl Drop for EventWait {
+    fn drop(&mut self) {
+        cancel(self.id);
+    }
+}
+
+/// Error passed to the completion of a wait.
+#[derive(Debug, Clone, Copy, thiserror::Error)]
+pub enum WaitError {
+    /// The reactor was shut down before the event signaled.
+    #[error("NV reactor shut down")]
+    Shutdown,
+    /// Waiting on the registered events failed with the given result code.
+    #[error("NV event wait failed: {0:#x}")]
+    Failed(ResultCode),
+}
+
+/// Error returned when registering a wait.
+#[derive(Debug, thiserror::Error)]
+pub enum ReactorError {
+    /// Creating the reactor wake event failed with the given result code.
+    #[error("failed to create the NV reactor event: {0:#x}")]
+    CreateEvent(ResultCode),
+    /// Creating the completion thread failed.
+    #[error("failed to spawn the NV completion thread")]
+    Spawn(#[source] pool::SpawnError),
+    /// Starting the completion thread failed.
+    #[error("failed to start the NV completion thread")]
+    Start(#[source] nx_sys_thread::ThreadStartError),
+    /// [`MAX_WAITS`] waits are already pending.
+    #[error("too many pending NV event waits")]
+    Full,
+    /// The reactor is being shut down.
+    #[error("NV reactor is shutting down")]
+    ShuttingDown,
+}
@@ -0,0 +1,383 @@
+//! # Sampling profiler
+//!
+//! A helper thread that periodically samples every thread of the
+//! [thread registry](crate::thread_registry), to find hotspots on retail hardware
+//! without a debugger.
+//!
+//! Each sample pauses the thread, dumps its context, walks its frame-pointer chain
+//! and resumes it. Nothing is allocated and no lock is taken while a thread is
+//! paused, so that a thread paused while holding the allocator, or the profile, does
+//! not stall the profiler. The samples are then aggregated into a flat [`Profile`]:
+//! the number of samples that stopped at each address (_self_), and the number of
+//! samples whose stack went through it (_total_).
+//!
+//! ```ignore
+//! use nx_rt::profiler::{Profiler, ProfilerConfig};
+//!
+//! let profiler = Profiler::start(ProfilerConfig::default())?;
+//! run_workload();
+//! let profile = profiler.stop();
+//! profile.write_to(&mut file)?;
+//! ```
+//!
+//! Code must be built with frame pointers (`-C force-frame-pointers=yes`) for the
+//! _total_ counts to go past the sampled function.
+
+use alloc::{boxed::Box, collections::BTreeMap, vec::Vec};
+use core::{
+    ffi::c_void,
+    fmt, ptr,
+    sync::atomic::{AtomicBool, AtomicU32, Ordering},
+    time::Duration,
+};
+
+use nx_std_sync::mutex::Mutex;
+use nx_svc::{
+    mem,
+    raw::{INVALID_HANDLE, ThreadContext},
+    thread::{self as svc, Handle},
+};
+use nx_sys_thread::pool::{self, PooledThread};
+
+use crate::thread_registry;
+
+/// Maximum number of frames captured per sample.
+pub const MAX_DEPTH: usize = 32;
+
+/// Stack size of the profiler thread.
+const THREAD_STACK_SIZE: usize = 0x4000;
+
+/// Priority of the profiler thread: the highest one of applications, so that samples
+/// are taken on time even under load.
+const THREAD_PRIORITY: i32 = 0x1C;
+
+/// Runs the profiler thread on the default core of the process.
+const THREAD_CPUID: i32 = -2;
+
+/// AArch32 execution state bit of `PSTATE`.
+const PSR_AARCH32: u32 = 1 << 4;
+
+/// Parameters of a [`Profiler`].
+#[derive(Debug, Clone, Copy)]
+pub struct ProfilerConfig {
+    /// Interval between two samples of every thread.
+    pub interval: Duration,
+    /// Number of frames captured per sample, at most [`MAX_DEPTH`].
+    pub depth: usize,
+}
+
+impl Default for ProfilerConfig {
+    /// Samples every thread a thousand times per second, [`MAX_DEPTH`] frames deep.
+    fn default() -> Self {
+        Self {
+            interval: Duration::from_millis(1),
+            depth: MAX_DEPTH,
+        }
+    }
+}
+
+/// A running sampling profiler.
+pub struct Profiler {
+    shared: Box<Shared>,
+    thread: Option<PooledThread>,
+}
+
+impl Profiler {
+    /// Starts sampling the registered threads.
+    pub fn start(config: ProfilerConfig) -> Result<Self, ProfilerStartError> {
+        let shared = Box::new(Shared {
+            config: ProfilerConfig {
+                depth: config.depth.clamp(1, MAX_DEPTH),
+                ..config
+            },
+            own_handle: AtomicU32::new(INVALID_HANDLE),
+            stop: AtomicBool::new(false),
+            profile: Mutex::new(Profile::new()),
+        });
+
+        // SAFETY: The shared state is boxed, and the thread is joined before it is dropped.
+        let mut thread = unsafe {
+            pool::spawn(
+                profiler_thread,
+                ptr::from_ref(&*shared).cast_mut().cast(),
+                THREAD_STACK_SIZE,
+                THREAD_PRIORITY,
+                THREAD_CPUID,
+            )
+        }
+        .map_err(ProfilerStartError::Spawn)?;
+
+        // The profiler must never pause itself, should it be registered
+        shared
+            .own_handle
+            .store(thread.handle().to_raw(), Ordering::Relaxed);
+        thread.start().map_err(ProfilerStartError::Start)?;
+
+        Ok(Self {
+            shared,
+            thread: Some(thread),
+        })
+    }
+
+    /// Returns a copy of the profile collected so far.
+    pub fn profile(&self) -> Profile {
+        self.shared.profile.lock().clone()
+    }
+
+    /// Clears the profile collected so far.
+    pub fn reset(&self) {
+        *self.shared.profile.lock() = Profile::new();
+    }
+
+    /// Stops sampling, returning the collected profile.
+    pub fn stop(mut self) -> Profile {
+        self.join();
+        core::mem::replace(&mut *self.shared.profile.lock(), Profile::new())
+    }
+
+    fn join(&mut self) {
+        let Some(thread) = self.thread.take() else {
+            return;
+        };
+
+        self.shared.stop.store(true, Ordering::Relaxed);
+        let _ = thread.join();
+    }
+}
+
+impl Drop for Profiler {
+    fn drop(&mut self) {
+        self.join();
+    }
+}
+
+/// Sample counts of an address.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct Counts {
+    /// Samples that stopped at the address.
+    pub self_samples: u64,
+    /// Samples whose stack went through the address, including those that stopped there.
+    pub total_samples: u64,
+}
+
+/// Flat profile collected by a [`Profiler`].
+#[derive(Debug, Clone)]
+pub struct Profile {
+    samples: u64,
+    lost: u64,
+    module_base: usize,
+    module_size: usize,
+    counts: BTreeMap<u64, Counts>,
+}
+
+impl Profile {
+    fn new() -> Self {
+        let (module_base, module_size) = module_region();
+        Self {
+            samples: 0,
+            lost: 0,
+            module_base,
+            module_size,
+            counts: BTreeMap::new(),
+        }
+    }
+
+    /// Returns the number of samples taken.
+    #[inline]
+    pub fn samples(&self) -> u64 {
+        self.samples
+    }
+
+    /// Returns the number of samples lost, because their thread could not be paused or
+    /// its context dumped.
+    #[inline]
+    pub fn lost(&self) -> u64 {
+        self.lost
+    }
+
+    /// Returns the load address of the code of the module that contains the runtime.
+    ///
+    /// Addresses in its code are written relative to it by [`Profile::write_to`], to be
+    /// resolved against the symbols of the executable.
+    #[inline]
+    pub fn module_base(&self) -> usize {
+        self.module_base
+    }
+
+    /// Returns the sampled addresses with their counts, by decreasing self samples.
+    pub fn entries(&self) -> Vec<(u64, Counts)> {
+        let mut entries: Vec<_> = self.counts.iter().map(|(&a, &c)| (a, c)).collect();
+        entries.sort_unstable_by(|(_, a), (_, b)| {
+            b.self_samples
+                .cmp(&a.self_samples)
+                .then(b.total_samples.cmp(&a.total_samples))
+        });
+        entries
+    }
+
+    /// Writes the profile as text, one address per line, by decreasing self samples.
+    ///
+    /// ```text
+    /// # samples 4000 lost 2 base 0x8000000
+    /// # self total address
+    /// 1520 1520 main+0x1a2b4
+    /// 12 3987 main+0x3c10
+    /// ```
+    pub fn write_to<W: fmt::Write>(&self, out: &mut W) -> fmt::Result {
+        writeln!(
+            out,
+            "# samples {} lost {} base {:#x}",
+            self.samples, self.lost, self.module_base
+        )?;
+        writeln!(out, "# self total address")?;
+        for (addr, counts) in self.entries() {
+            write!(out, "{} {} ", counts.self_samples, counts.total_samples)?;
+            match addr.checked_sub(self.module_base as u64) {
+                Some(offset) if offset < self.module_size as u64 => {
+                    writeln!(out, "main+{offset:#x}")?
+                }
+                _ => writeln!(out, "{addr:#x}")?,
+            }
+        }
+        Ok(())
+    }
+
+    /// Records the frames of a sample, innermost first.
+    fn record(&mut self, frames: &[u64]) {
+        self.samples += 1;
+        for (i, &addr) in frames.iter().enumerate() {
+            let counts = self.counts.entry(addr).or_default();
+            if i == 0 {
+                counts.self_samples += 1;
+            }
+            // Recursive stacks count once per address
+            if !frames[..i].contains(&addr) {
+                counts.total_samples += 1;
+            }
+        }
+    }
+}
+
+/// State shared with the profiler thread.
+struct Shared {
+    config: ProfilerConfig,
+    /// Raw handle of the profiler thread.
+    own_handle: AtomicU32,
+    stop: AtomicBool,
+    profile: Mutex<Profile>,
+}
+
+impl Shared {
+    /// Samples the registered threads until stopped.
+    fn run(&self) {
+        let own_handle = self.own_handle.load(Ordering::Relaxed);
+        let interval = self.config.interval.as_nanos().min(u64::MAX as u128) as u64;
+
+        while !self.stop.load(Ordering::Relaxed) {
+            thread_registry::for_each(|handle| {
+                if handle.to_raw() == own_handle {
+                    return;
+                }
+
+                let mut frames = [0; MAX_DEPTH];
+                let sampled = sample(handle, &mut frames[..self.config.depth]);
+
+                // The thread runs again: aggregating may allocate
+                let mut profile = self.profile.lock();
+                match sampled {
+                    Some(depth) => profile.record(&frames[..depth]),
+                    None => profile.lost += 1,
+                }
+            });
+
+            svc::sleep(interval);
+        }
+    }
+}
+
+/// Captures the frames of the thread `handle` into `frames`, returning their number.
+///
+/// Returns `None` if the thread could not be paused, or its context dumped.
+fn sample(handle: Handle, frames: &mut [u64]) -> Option<usize> {
+    svc::pause(handle).ok()?;
+    let depth = svc::get_context3(handle)
+        .ok()
+        .map(|ctx| unwind(&ctx, frames));
+    let _ = svc::resume(handle);
+    depth
+}
+
+/// Walks the frame-pointer chain of a paused thread, returning the number of frames
+/// written to `frames`.
+///
+/// Every frame record is checked to lie in the stack region of the thread, above the
+/// previous one, before being read.
+fn unwind(ctx: &ThreadContext, frames: &mut [u64]) -> usize {
+    // SAFETY: The kernel fills every view of the register union.
+    frames[0] = unsafe { ctx.pc.x };
+    if ctx.psr & PSR_AARCH32 != 0 {
+        return 1;
+    }
+
+    let Ok((stack, _)) = mem::query_memory(ctx.sp as usize) else {
+        return 1;
+    };
+    let (stack_lo, stack_hi) = (stack.addr as u64, (stack.addr + stack.size) as u64);
+    let in_stack = |fp: u64| fp >= stack_lo && fp <= stack_hi - 16 && fp % 8 == 0;
+
+    let mut depth = 1;
+    let mut fp = ctx.fp;
+
+    // The link register holds the caller of a leaf function that set up no frame record
+    // of its own: count it unless it is the return address of the first record
+    if in_stack(fp) && depth < frames.len() && ctx.lr != 0 {
+        // SAFETY: `fp` is an aligned address of the mapped stack of the thread.
+        let [_, ret] = unsafe { ptr::read_volatile(fp as *const [u64; 2]) };
+        if ret != ctx.lr {
+            frames[depth] = ctx.lr;
+            depth += 1;
+        }
+    }
+
+    while depth < frames.len() && in_stack(fp) {
+        // SAFETY: `fp` is an aligned address of the mapped stack of the thread.
+        let [next, ret] = unsafe { ptr::read_volatile(fp as *const [u64; 2]) };
+        if ret == 0 {
+            break;
+        }
+        frames[depth] = ret;
+        depth += 1;
+
+        // Callers' records lie higher up the stack
+        if next <= fp {
+            break;
+        }
+        fp = next;
+    }
+    depth
+}
+
+/// Returns the base address and size of the code region that contains the runtime,
+/// empty if it cannot be queried.
+fn module_region() -> (usize, usize) {
+    mem::query_memory(module_region as fn() -> (usize, usize) as usize)
+        .map_or((0, 0), |(info, _)| (info.addr, info.size))
+}
+
+/// Entry point of the profiler thread.
+unsafe extern "C" fn profiler_thread(arg: *mut c_void) {
+    // SAFETY: `Profiler::start` passes the boxed shared state, which outlives the thread.
+    let shared = unsafe { &*arg.cast::<Shared>() };
+    shared.run();
+}
+
+/// Error returned by [`Profiler::start`].
+#[derive(Debug, thiserror::Error)]
+pub enum ProfilerStartError {
+    /// Creating the profiler thread failed.
+    #[error("failed to spawn the profiler thread")]
+    Spawn(#[source] pool::SpawnError),
+    /// Starting the profiler thread failed.
+    #[error("failed to start the profiler thread")]
+    Start(#[source] nx_sys_thread::ThreadStartError),
+}
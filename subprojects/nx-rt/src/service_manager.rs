@@ -111,17 +111,31 @@ pub fn get_service(name: ServiceName) -> Result<Service, GetServiceError> {
 
 /// Gets a service directly from SM (ignoring overrides).
 ///
+/// Uses TIPC when available (see [`should_use_tipc`]), CMIF otherwise.
 /// Returns the raw session handle.
 pub fn get_service_handle(name: ServiceName) -> Result<SessionHandle, GetServiceError> {
     let session = SM_SESSION.read();
     let sm = session.as_ref().expect("SM not initialized");
-    sm.get_service_handle_cmif(name).map_err(GetServiceError)
+
+    if should_use_tipc() {
+        sm.get_service_handle_tipc(name)
+            .map_err(GetServiceError::Tipc)
+    } else {
+        sm.get_service_handle_cmif(name)
+            .map_err(GetServiceError::Cmif)
+    }
 }
 
 /// Error returned by [`get_service`] and [`get_service_handle`].
 #[derive(Debug, thiserror::Error)]
-#[error("protocol error")]
-pub struct GetServiceError(#[source] pub nx_service_sm::GetServiceCmifError);
+pub enum GetServiceError {
+    /// CMIF protocol error.
+    #[error("CMIF protocol error")]
+    Cmif(#[source] nx_service_sm::GetServiceCmifError),
+    /// TIPC protocol error.
+    #[error("TIPC protocol error")]
+    Tipc(#[source] nx_service_sm::GetServiceTipcError),
+}
 
 /// Registers a new service with SM.
 ///
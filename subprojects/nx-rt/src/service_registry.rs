@@ -1,15 +1,20 @@
 //! Service registry for lazy-initialized service sessions.
 //!
-//! This module provides a centralized registry for storing and retrieving
-//! service sessions by [`ServiceName`]. Services are stored as type-erased
-//! `Arc<dyn Any>` values and can be lazily initialized on first access.
+//! Well-known services live in statically allocated, typed [`ServiceSlot`]s: a lookup is
+//! an acquire load of the slot pointer, without a lock, a scan or a downcast. Services
+//! registered under ad-hoc names are stored by [`ServiceName`] in a dynamic registry of
+//! type-erased `Arc<dyn Any>` values.
 
 use alloc::{sync::Arc, vec::Vec};
-use core::any::Any;
+use core::{
+    any::Any,
+    ptr,
+    sync::atomic::{AtomicPtr, Ordering},
+};
 
-use nx_service_set::SetSysService;
+use nx_service_set::{FirmwareVersion, SetSysService};
 use nx_sf::ServiceName;
-use nx_std_sync::{once_lock::OnceLock, rwlock::RwLock};
+use nx_std_sync::{mutex::Mutex, once_lock::OnceLock, rwlock::RwLock};
 
 use crate::service_manager;
 
@@ -22,6 +27,154 @@ type RegistryEntry = (ServiceName, Arc<dyn Any + Send + Sync>);
 /// Global service registry, lazily initialized on first access.
 static REGISTRY: OnceLock<RwLock<Vec<RegistryEntry>>> = OnceLock::new();
 
+/// The `set:sys` service session.
+static SETSYS: ServiceSlot<SetSysService> = ServiceSlot::new();
+
+/// A statically allocated slot holding a service session of type `T`.
+///
+/// The session is published with release semantics and read with a plain acquire load, so
+/// readers on different cores never write a shared cache line. A reader may still hold the
+/// pointer of a session that was just replaced or removed: the slot keeps a reference to
+/// every retired session until [`ServiceSlot::reclaim`] is called at a quiescent point.
+pub struct ServiceSlot<T> {
+    /// Session, as a pointer from `Arc::into_raw`, or null.
+    service: AtomicPtr<T>,
+    /// Replaced and removed sessions, kept alive for readers that loaded them before.
+    retired: Mutex<Vec<Arc<T>>>,
+}
+
+impl<T: Send + Sync> ServiceSlot<T> {
+    /// Creates an empty slot.
+    pub const fn new() -> Self {
+        Self {
+            service: AtomicPtr::new(ptr::null_mut()),
+            retired: Mutex::new(Vec::new()),
+        }
+    }
+
+    /// Returns `true` if a session is published.
+    #[inline]
+    pub fn is_set(&self) -> bool {
+        !self.service.load(Ordering::Acquire).is_null()
+    }
+
+    /// Runs `f` on the session, without taking a reference to it.
+    ///
+    /// Returns `None` if no session is published. If the session is replaced or removed
+    /// meanwhile, `f` keeps running on the retired one.
+    #[inline]
+    pub fn with<R>(&self, f: impl FnOnce(&T) -> R) -> Option<R> {
+        let service = self.service.load(Ordering::Acquire);
+        // SAFETY: A published session is only dropped by `reclaim`, once no reader is left.
+        unsafe { service.as_ref() }.map(f)
+    }
+
+    /// Returns a reference to the session, if one is published.
+    #[inline]
+    pub fn get(&self) -> Option<Arc<T>> {
+        let service = self.service.load(Ordering::Acquire);
+        if service.is_null() {
+            return None;
+        }
+
+        // SAFETY: The pointer comes from `Arc::into_raw`, and a retired session keeps its
+        // reference until `reclaim`.
+        unsafe {
+            Arc::increment_strong_count(service);
+            Some(Arc::from_raw(service))
+        }
+    }
+
+    /// Returns the session, publishing the one created by `init` if none is.
+    ///
+    /// If another thread publishes a session meanwhile, it is returned and the one created
+    /// by `init` is dropped.
+    pub fn get_or_init<E>(&self, init: impl FnOnce() -> Result<T, E>) -> Result<Arc<T>, E> {
+        if let Some(service) = self.get() {
+            return Ok(service);
+        }
+
+        let service = Arc::new(init()?);
+        let raw = Arc::into_raw(service.clone()).cast_mut();
+        loop {
+            let published = self.service.compare_exchange(
+                ptr::null_mut(),
+                raw,
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            );
+            if published.is_ok() {
+                return Ok(service);
+            }
+
+            // Retry publishing if the winning session was removed meanwhile
+            if let Some(published) = self.get() {
+                // SAFETY: `raw` was not published, so this is its only owner.
+                drop(unsafe { Arc::from_raw(raw) });
+                return Ok(published);
+            }
+        }
+    }
+
+    /// Publishes `service`, replacing and returning the previous session.
+    pub fn insert(&self, service: T) -> Option<Arc<T>> {
+        let raw = Arc::into_raw(Arc::new(service)).cast_mut();
+        self.replace(raw)
+    }
+
+    /// Removes and returns the session.
+    pub fn remove(&self) -> Option<Arc<T>> {
+        self.replace(ptr::null_mut())
+    }
+
+    /// Drops the sessions retired by [`insert`](Self::insert) and [`remove`](Self::remove)
+    /// that are not referenced elsewhere.
+    ///
+    /// # Safety
+    ///
+    /// No thread may be running [`with`](Self::with) or [`get`](Self::get) on this slot
+    /// since before the sessions were retired, e.g. during runtime teardown.
+    pub unsafe fn reclaim(&self) {
+        let retired = core::mem::take(&mut *self.retired.lock());
+        drop(retired);
+    }
+
+    fn replace(&self, raw: *mut T) -> Option<Arc<T>> {
+        let old = self.service.swap(raw, Ordering::AcqRel);
+        if old.is_null() {
+            return None;
+        }
+
+        // SAFETY: The pointer comes from `Arc::into_raw`, and the swap took its ownership.
+        let old = unsafe { Arc::from_raw(old) };
+
+        // Readers that loaded the pointer before the swap may still be using it
+        self.retired.lock().push(old.clone());
+        Some(old)
+    }
+}
+
+impl<T: Send + Sync> Default for ServiceSlot<T> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<T> Drop for ServiceSlot<T> {
+    fn drop(&mut self) {
+        let service = *self.service.get_mut();
+        if !service.is_null() {
+            // SAFETY: The pointer comes from `Arc::into_raw`, and the slot is not shared.
+            drop(unsafe { Arc::from_raw(service) });
+        }
+    }
+}
+
+// SAFETY: The slot hands out shared references to its session across threads.
+unsafe impl<T: Send + Sync> Sync for ServiceSlot<T> {}
+// SAFETY: The slot owns its session.
+unsafe impl<T: Send + Sync> Send for ServiceSlot<T> {}
+
 /// Initializes the `set:sys` service session.
 ///
 /// Connects to set:sys via SM and stores the session in the registry.
@@ -39,14 +192,41 @@ pub fn setsys_init() -> Result<(), SetsysConnectError> {
     } else {
         nx_service_set::connect_cmif(sm).map_err(SetsysConnectError::Cmif)?
     };
-    insert(nx_service_set::SERVICE_NAME, setsys);
+    SETSYS.insert(setsys);
 
     Ok(())
 }
 
 /// Gets the `set:sys` service session.
 pub fn setsys_get() -> Option<Arc<SetSysService>> {
-    get::<SetSysService>(nx_service_set::SERVICE_NAME)
+    SETSYS.get()
+}
+
+/// Runs `f` on the `set:sys` service session, without taking a reference to it.
+///
+/// Returns `None` if set:sys is not initialized. The session memory stays valid if
+/// [`setsys_exit`] runs meanwhile.
+pub fn setsys_with<R>(f: impl FnOnce(&SetSysService) -> R) -> Option<R> {
+    SETSYS.with(f)
+}
+
+/// Gets the system firmware version from `set:sys`.
+///
+/// Uses TIPC when available (see [`service_manager::should_use_tipc`]), matching the
+/// protocol the session was connected with. Returns `None` if set:sys is not initialized.
+pub fn setsys_get_firmware_version()
+-> Option<Result<FirmwareVersion, SetsysGetFirmwareVersionError>> {
+    setsys_with(|setsys| {
+        if service_manager::should_use_tipc() {
+            setsys
+                .get_firmware_version_tipc()
+                .map_err(SetsysGetFirmwareVersionError::Tipc)
+        } else {
+            setsys
+                .get_firmware_version_cmif()
+                .map_err(SetsysGetFirmwareVersionError::Cmif)
+        }
+    })
 }
 
 /// Gets or initializes the `set:sys` service session.
@@ -57,7 +237,7 @@ pub fn setsys_get() -> Option<Arc<SetSysService>> {
 ///
 /// Panics if SM is not initialized.
 pub fn setsys_get_or_init() -> Result<Arc<SetSysService>, SetsysConnectError> {
-    get_or_init(nx_service_set::SERVICE_NAME, || {
+    SETSYS.get_or_init(|| {
         let sm_guard = service_manager::sm_session();
         let sm = sm_guard.as_ref().expect("SM not initialized");
 
@@ -71,7 +251,7 @@ pub fn setsys_get_or_init() -> Result<Arc<SetSysService>, SetsysConnectError> {
 
 /// Exits the set:sys service session.
 pub fn setsys_exit() {
-    remove(nx_service_set::SERVICE_NAME);
+    SETSYS.remove();
 }
 
 /// Error returned by [`setsys_init`] and [`setsys_get_or_init`].
@@ -85,15 +265,26 @@ pub enum SetsysConnectError {
     Tipc(#[source] nx_service_set::ConnectTipcError),
 }
 
+/// Error returned by [`setsys_get_firmware_version`].
+#[derive(Debug, thiserror::Error)]
+pub enum SetsysGetFirmwareVersionError {
+    /// CMIF protocol error.
+    #[error("failed to get the firmware version (CMIF)")]
+    Cmif(#[source] nx_service_set::GetFirmwareVersionCmifError),
+    /// TIPC protocol error.
+    #[error("failed to get the firmware version (TIPC)")]
+    Tipc(#[source] nx_service_set::GetFirmwareVersionTipcError),
+}
+
 /// Returns a reference to the registry, initializing it if needed.
 fn registry() -> &'static RwLock<Vec<RegistryEntry>> {
     REGISTRY.get_or_init(|| RwLock::new(Vec::with_capacity(INITIAL_CAPACITY)))
 }
 
-/// Gets a service session by name.
+/// Gets a service session registered under an ad-hoc name.
 ///
 /// Returns `None` if the service is not registered or if the type doesn't match.
-fn get<T: Any + Send + Sync>(name: ServiceName) -> Option<Arc<T>> {
+pub fn get<T: Any + Send + Sync>(name: ServiceName) -> Option<Arc<T>> {
     let guard = registry().read();
 
     for (n, service) in guard.iter() {
@@ -114,7 +305,7 @@ fn get<T: Any + Send + Sync>(name: ServiceName) -> Option<Arc<T>> {
 ///
 /// Returns an error if `init` fails. If a service exists but has a different
 /// type, `init` will be called and the existing entry will be replaced.
-fn get_or_init<T, F, E>(name: ServiceName, init: F) -> Result<Arc<T>, E>
+pub fn get_or_init<T, F, E>(name: ServiceName, init: F) -> Result<Arc<T>, E>
 where
     T: Any + Send + Sync,
     F: FnOnce() -> Result<T, E>,
@@ -151,7 +342,7 @@ where
 /// Inserts a service session into the registry.
 ///
 /// Returns the previous value if one existed with the same name.
-fn insert<T: Any + Send + Sync>(
+pub fn insert<T: Any + Send + Sync>(
     name: ServiceName,
     service: T,
 ) -> Option<Arc<dyn Any + Send + Sync>> {
@@ -177,7 +368,7 @@ fn insert<T: Any + Send + Sync>(
 /// Removes a service session from the registry.
 ///
 /// Returns the removed value if it existed.
-fn remove(name: ServiceName) -> Option<Arc<dyn Any + Send + Sync>> {
+pub fn remove(name: ServiceName) -> Option<Arc<dyn Any + Send + Sync>> {
     let mut guard = registry().write();
 
     let mut removed = None;
@@ -4,37 +4,18 @@
 //! for the main thread. It serves as the Rust equivalent of libnx's thread
 //! initialization functions.
 //!
-//! ## Registry Design
+//! ## Registry
 //!
-//! The registry owns a global collection that tracks every [`Thread`] alive in
-//! the current process.
-//!
-//! • **Storage** – Threads are _not_ inserted directly into the intrusive list
-//!   because that would change the C ABI of [`Thread`]. Instead, every entry
-//!   is a heap-allocated `Box<Node>` that contains the intrusive
-//!   [`LinkedListLink`] and a raw, non-null pointer back to the real [`Thread`]
-//!   object. The allocation is created on insertion and destroyed immediately
-//!   after removal.
-//!
-//! • **Global access** – A `static` `Mutex<ThreadList>` called
-//!   `THREAD_LIST` serializes all mutations.
-//!
-//! • **Thread-safety** – User code can only access the underlying [`Thread`]s
-//!   while the global mutex is held, guaranteeing data-race freedom even
-//!   though the list itself stores raw pointers.
-//!
-//! The public API purposefully avoids returning raw pointers or references
-//! that outlive the mutex guard. If you need to operate on every live thread,
-//! pass a closure to [`for_each`] _while holding the guard_ so that borrow
-//! rules remain intact.
-//!
-//! [`LinkedListLink`]: intrusive_collections::LinkedListLink
+//! The table of live threads lives in [`nx_sys_thread::registry`], so that the
+//! thread start and exit paths keep it up to date; it is re-exported here. This
+//! module registers the main thread, which the kernel starts.
 
 use core::ptr::{self, NonNull};
 
 use nx_std_sync::once_lock::OnceLock;
 use nx_svc::mem;
 use nx_sys_mem::buf::BufferRef;
+pub use nx_sys_thread::registry::{MAX_THREADS, RegistryFullError, for_each, insert, len, remove};
 use nx_sys_thread::{Thread, ThreadStackMem};
 use nx_sys_thread_tls as tls_region;
 
@@ -88,7 +69,6 @@ pub unsafe fn main_thread() -> &'static MainThread {
         .expect("Main thread not set: MAIN_THREAD_NOT_SET")
 }
 
-// TODO: Thread registry list functionality temporarily disabled for dyn slots initialization
 /// Initializes the process-wide representation of the *main* thread.
 ///
 /// This function performs the Rust equivalent of libnx's `__libnx_init_thread`.
@@ -187,12 +167,9 @@ pub unsafe fn init_main_thread() {
     // SAFETY: The main thread was just successfully stored in the registry above.
     let main_thread_ptr = unsafe { main_thread() };
 
-    // TODO: Thread registry list functionality temporarily disabled for dyn slots initialization
-    // Register the main thread with the global thread list to enable cleanup
-    // operations (TLS destructor walks, thread enumeration, etc.).
-    // SAFETY: The main thread is fully initialized and will remain valid for
-    // the lifetime of the process.
-    // unsafe { insert(&*main_thread_ptr) };
+    // Register the main thread to enable enumeration APIs. The table is empty
+    // this early, so the insertion cannot fail.
+    let _ = insert(main_thread_ptr.handle);
 
     // Update ThreadVars to maintain compatibility with libnx C functions.
     // This ensures threadGetSelf() and related APIs work correctly.
@@ -3,7 +3,12 @@
 //! This module manages the Time service session and provides a singleton interface
 //! for accessing time functionality throughout the application lifecycle.
 
-use nx_service_time::{TimeService, TimeServiceType};
+use alloc::{
+    alloc::{Layout, alloc_zeroed, handle_alloc_error},
+    boxed::Box,
+};
+
+use nx_service_time::{LocalTimeZone, TimeService, TimeServiceType};
 use nx_std_sync::{once_lock::OnceLock, rwlock::RwLock};
 
 use crate::service_manager;
@@ -32,6 +37,13 @@ pub fn init() -> Result<(), ConnectError> {
     let service =
         nx_service_time::connect(sm, TimeServiceType::User).map_err(ConnectError::Connect)?;
 
+    // Let clock_gettime(CLOCK_REALTIME) read the clocks from shared memory
+    if let Some(shmem_ptr) = service.shared_memory_ptr() {
+        // SAFETY: The mapping lives as long as the service, and is unregistered
+        // before the service is closed.
+        unsafe { nx_time::set_realtime_shared_memory(shmem_ptr) };
+    }
+
     let mut guard = state().write();
     *guard = Some(TimeState { service });
 
@@ -52,10 +64,43 @@ pub fn get_service() -> Option<impl core::ops::Deref<Target = TimeService> + 'st
 pub fn exit() {
     let mut guard = state().write();
     if let Some(time_state) = guard.take() {
+        // SAFETY: Unregistering is always sound.
+        unsafe { nx_time::set_realtime_shared_memory(core::ptr::null()) };
         time_state.service.close();
     }
 }
 
+/// Device time zone, loaded once on first use.
+static LOCAL_TIME_ZONE: OnceLock<Box<LocalTimeZone>> = OnceLock::new();
+
+/// Returns the device time zone, for in-process calendar conversions.
+///
+/// The rule is loaded from the time zone service on the first call; later
+/// calls are free. Returns `None` if the Time service is not initialized or the
+/// rule could not be loaded, in which case the next call tries again.
+pub fn local_time_zone() -> Option<&'static LocalTimeZone> {
+    LOCAL_TIME_ZONE
+        .get_or_try_init(|| {
+            let service = get_service().ok_or(())?;
+
+            // The rule is 16 KiB: allocate it in place rather than on the stack
+            let layout = Layout::new::<LocalTimeZone>();
+            // SAFETY: The layout has a non-zero size.
+            let ptr = unsafe { alloc_zeroed(layout) }.cast::<LocalTimeZone>();
+            if ptr.is_null() {
+                handle_alloc_error(layout);
+            }
+            // SAFETY: All zero bytes are a valid `LocalTimeZone`, allocated with the
+            // global allocator and the layout of the type.
+            let mut zone = unsafe { Box::from_raw(ptr) };
+
+            service.load_local_time_zone(&mut zone).map_err(drop)?;
+            Ok::<_, ()>(zone)
+        })
+        .ok()
+        .map(|zone| &**zone)
+}
+
 /// Internal storage for Time service.
 struct TimeState {
     /// Time service (IStaticService with clock and timezone services)
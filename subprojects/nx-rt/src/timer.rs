@@ -0,0 +1,363 @@
+//! # Timer service
+//!
+//! Timeouts and delayed callbacks, kept in a single [`TimerWheel`] driven by a timer
+//! thread. Thousands of pending timers cost one kernel wait, on the wake event of the
+//! thread with the nearest deadline as timeout, instead of a sleeping thread or a timed
+//! wait each.
+//!
+//! Callbacks run on the timer thread, so they must be short and must not block.
+//!
+//! ```ignore
+//! use nx_rt::timer;
+//!
+//! let id = timer::after(Duration::from_millis(500), || {
+//!     RETRY.store(true, Ordering::Release);
+//! })?;
+//!
+//! timer::sleep(Duration::from_millis(16))?.await;
+//! ```
+
+use alloc::{boxed::Box, sync::Arc, vec::Vec};
+use core::{
+    ffi::c_void,
+    future::Future,
+    pin::Pin,
+    ptr,
+    sync::atomic::{AtomicBool, Ordering},
+    task::{Context, Poll, Waker},
+    time::Duration,
+};
+
+use nx_std_sync::{mutex::Mutex, once_lock::OnceLock};
+use nx_svc::{
+    error::{ResultCode, ToRawResultCode},
+    sync::{self as svc_sync, EventHandle, WritableEventHandle},
+};
+use nx_sys_thread::pool::{self, PooledThread};
+use nx_time::{
+    Instant,
+    wheel::{TimerKey, TimerWheel},
+};
+
+/// Resolution of the timer wheel: deadlines are rounded up to the next millisecond.
+pub const RESOLUTION: Duration = Duration::from_millis(1);
+
+/// Stack size of the timer thread, which runs the callbacks.
+const THREAD_STACK_SIZE: usize = 0x4000;
+
+/// Priority of the timer thread, above the default one so that timers fire on time.
+const THREAD_PRIORITY: i32 = 0x2B;
+
+/// Runs the timer thread on the default core of the process.
+const THREAD_CPUID: i32 = -2;
+
+/// Global timer service state, created on first use.
+static TIMERS: OnceLock<Result<Timers, ResultCode>> = OnceLock::new();
+
+/// Identifier of a pending timer, to [`cancel`] it.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct TimerId(TimerKey);
+
+/// Runs `callback` on the timer thread once `duration` elapsed.
+pub fn after(
+    duration: Duration,
+    callback: impl FnOnce() + Send + 'static,
+) -> Result<TimerId, TimerError> {
+    at(deadline_after(duration), callback)
+}
+
+/// Runs `callback` on the timer thread at `deadline`.
+pub fn at(
+    deadline: Instant,
+    callback: impl FnOnce() + Send + 'static,
+) -> Result<TimerId, TimerError> {
+    timers()?.insert(deadline, Completion::Callback(Box::new(callback)))
+}
+
+/// Returns a future resolving once `duration` elapsed.
+///
+/// The timer is started right away. Dropping the future cancels it.
+pub fn sleep(duration: Duration) -> Result<Sleep, TimerError> {
+    sleep_until(deadline_after(duration))
+}
+
+/// Returns a future resolving at `deadline`.
+///
+/// The timer is started right away. Dropping the future cancels it.
+pub fn sleep_until(deadline: Instant) -> Result<Sleep, TimerError> {
+    let state = Arc::new(Mutex::new(FutureState {
+        fired: false,
+        waker: None,
+    }));
+    let id = timers()?.insert(deadline, Completion::Future(state.clone()))?;
+    Ok(Sleep { id, state })
+}
+
+/// Cancels the timer `id`.
+///
+/// Returns `true` if the timer was still pending: its callback will not run.
+pub fn cancel(id: TimerId) -> bool {
+    match TIMERS.get() {
+        Some(Ok(timers)) => timers.cancel(id),
+        _ => false,
+    }
+}
+
+/// Stops the timer thread, dropping the pending timers: their callbacks never run, and
+/// their futures never resolve.
+///
+/// The thread is started again by the next timer. Must not be called from a callback,
+/// which runs on the timer thread.
+pub fn shutdown() {
+    if let Some(Ok(timers)) = TIMERS.get() {
+        timers.shutdown();
+    }
+}
+
+fn timers() -> Result<&'static Timers, TimerError> {
+    TIMERS
+        .get_or_init(Timers::new)
+        .as_ref()
+        .map_err(|rc| TimerError::CreateEvent(*rc))
+}
+
+/// Returns the deadline `duration` from now, saturating to the furthest one the clock can
+/// represent.
+fn deadline_after(duration: Duration) -> Instant {
+    let now = Instant::now();
+    now.checked_add(duration)
+        .unwrap_or_else(|| now + Duration::from_secs(u32::MAX as u64))
+}
+
+/// Pending timers and timer thread.
+struct Timers {
+    /// Writable end of the event interrupting the timer thread wait.
+    wake: WritableEventHandle,
+    /// Readable end of the wake event, waited on by the timer thread.
+    wake_readable: EventHandle,
+    wheel: Mutex<Wheel>,
+    thread: Mutex<Option<PooledThread>>,
+    shutdown: AtomicBool,
+}
+
+/// The timer wheel, with the deadline the timer thread waits until.
+struct Wheel {
+    timers: TimerWheel<Completion>,
+    /// `None` while the timer thread waits without timeout.
+    armed: Option<Instant>,
+}
+
+enum Completion {
+    Callback(Box<dyn FnOnce() + Send>),
+    Future(Arc<Mutex<FutureState>>),
+}
+
+impl Completion {
+    fn complete(self) {
+        match self {
+            Completion::Callback(callback) => callback(),
+            Completion::Future(state) => {
+                let mut state = state.lock();
+                state.fired = true;
+                if let Some(waker) = state.waker.take() {
+                    waker.wake();
+                }
+            }
+        }
+    }
+}
+
+impl Timers {
+    fn new() -> Result<Self, ResultCode> {
+        let (wake, wake_readable) = svc_sync::create_event().map_err(|err| err.to_rc())?;
+        Ok(Self {
+            wake,
+            wake_readable,
+            wheel: Mutex::new(Wheel {
+                timers: TimerWheel::new(RESOLUTION),
+                armed: None,
+            }),
+            thread: Mutex::new(None),
+            shutdown: AtomicBool::new(false),
+        })
+    }
+
+    fn insert(
+        &'static self,
+        deadline: Instant,
+        completion: Completion,
+    ) -> Result<TimerId, TimerError> {
+        let (key, interrupt) = {
+            // Inserting under the thread lock keeps the timer from slipping in between a
+            // shutdown dropping the pending timers and the thread restarting
+            let mut thread = self.thread.lock();
+            self.ensure_thread(&mut thread)?;
+
+            let mut wheel = self.wheel.lock();
+            let key = wheel.timers.insert(deadline, completion);
+            // Only a deadline earlier than the one waited for needs the thread to wake up
+            let interrupt = wheel.armed.is_none_or(|armed| deadline < armed);
+            (key, interrupt)
+        };
+
+        if interrupt {
+            self.interrupt();
+        }
+        Ok(TimerId(key))
+    }
+
+    fn cancel(&self, id: TimerId) -> bool {
+        // The thread wakes up for nothing at the deadline, rather than being interrupted
+        // here to pick up a later one
+        self.wheel.lock().timers.remove(id.0).is_some()
+    }
+
+    fn shutdown(&self) {
+        let thread = {
+            let mut thread = self.thread.lock();
+            let Some(taken) = thread.take() else {
+                return;
+            };
+            self.shutdown.store(true, Ordering::Release);
+            taken
+        };
+
+        self.interrupt();
+        let _ = thread.join();
+
+        let timers = {
+            let mut wheel = self.wheel.lock();
+            wheel.armed = None;
+            core::mem::replace(&mut wheel.timers, TimerWheel::new(RESOLUTION))
+        };
+        drop(timers);
+
+        let _thread = self.thread.lock();
+        self.shutdown.store(false, Ordering::Release);
+    }
+
+    /// Starts the timer thread if it is not running.
+    fn ensure_thread(&'static self, thread: &mut Option<PooledThread>) -> Result<(), TimerError> {
+        if thread.is_some() {
+            return Ok(());
+        }
+        if self.shutdown.load(Ordering::Acquire) {
+            return Err(TimerError::ShuttingDown);
+        }
+
+        // SAFETY: The timer service is static, so it outlives the thread.
+        let mut spawned = unsafe {
+            pool::spawn(
+                timer_thread,
+                ptr::from_ref(self).cast_mut().cast(),
+                THREAD_STACK_SIZE,
+                THREAD_PRIORITY,
+                THREAD_CPUID,
+            )
+        }
+        .map_err(TimerError::Spawn)?;
+        spawned.start().map_err(TimerError::Start)?;
+
+        *thread = Some(spawned);
+        Ok(())
+    }
+
+    /// Interrupts the timer thread wait, to pick up an earlier deadline.
+    fn interrupt(&self) {
+        let _ = svc_sync::signal_event(&self.wake);
+    }
+
+    /// Fires the expired timers until shut down.
+    fn run(&self) {
+        let mut expired = Vec::new();
+        loop {
+            let armed = {
+                let mut wheel = self.wheel.lock();
+                wheel
+                    .timers
+                    .advance(Instant::now(), |_, completion| expired.push(completion));
+
+                wheel.armed = wheel.timers.next_deadline();
+                wheel.armed
+            };
+
+            // Not holding the wheel lock, so that callbacks can start timers
+            for completion in expired.drain(..) {
+                completion.complete();
+            }
+
+            let timeout = armed.map_or(u64::MAX, |deadline| {
+                let timeout = deadline.saturating_duration_since(Instant::now());
+                timeout.as_nanos().min(u64::MAX as u128) as u64
+            });
+            // SAFETY: The wake event is owned by the timer service.
+            let res =
+                unsafe { svc_sync::wait_synchronization_single(&self.wake_readable, timeout) };
+            if res.is_ok() {
+                // SAFETY: The wake event is a readable event owned by the timer service.
+                let _ = unsafe { svc_sync::reset_signal(&self.wake_readable) };
+                if self.shutdown.load(Ordering::Acquire) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+/// Entry point of the timer thread.
+unsafe extern "C" fn timer_thread(arg: *mut c_void) {
+    // SAFETY: `ensure_thread` passes the static timer service.
+    let timers = unsafe { &*arg.cast::<Timers>() };
+    timers.run();
+}
+
+struct FutureState {
+    fired: bool,
+    waker: Option<Waker>,
+}
+
+/// Future returned by [`sleep`] and [`sleep_until`], resolving at its deadline.
+pub struct Sleep {
+    id: TimerId,
+    state: Arc<Mutex<FutureState>>,
+}
+
+impl Future for Sleep {
+    type Output = ();
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<()> {
+        let mut state = self.state.lock();
+        if state.fired {
+            return Poll::Ready(());
+        }
+
+        match &mut state.waker {
+            Some(waker) => waker.clone_from(cx.waker()),
+            None => state.waker = Some(cx.waker().clone()),
+        }
+        Poll::Pending
+    }
+}
+
+impl Drop for Sleep {
+    fn drop(&mut self) {
+        cancel(self.id);
+    }
+}
+
+/// Error returned when starting a timer.
+#[derive(Debug, thiserror::Error)]
+pub enum TimerError {
+    /// Creating the timer thread wake event failed with the given result code.
+    #[error("failed to create the timer event: {0:#x}")]
+    CreateEvent(ResultCode),
+    /// Creating the timer thread failed.
+    #[error("failed to spawn the timer thread")]
+    Spawn(#[source] pool::SpawnError),
+    /// Starting the timer thread failed.
+    #[error("failed to start the timer thread")]
+    Start(#[source] nx_sys_thread::ThreadStartError),
+    /// The timer service is being shut down.
+    #[error("timer service is shutting down")]
+    ShuttingDown,
+}
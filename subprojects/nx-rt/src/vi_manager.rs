@@ -8,6 +8,8 @@ use nx_std_sync::{once_lock::OnceLock, rwlock::RwLock};
 
 use crate::service_manager;
 
+pub mod present;
+
 /// Global VI state, lazily initialized.
 static VI_STATE: OnceLock<RwLock<Option<ViState>>> = OnceLock::new();
 
@@ -0,0 +1,436 @@
+//! Non-blocking presentation queue.
+//!
+//! Presenting a frame through a [`BufferProducer`] directly takes a `dequeueBuffer` round
+//! trip, which blocks until the compositor releases a buffer at vsync, and a `queueBuffer`
+//! round trip, both on the rendering thread. A [`PresentQueue`] hands both to a helper
+//! thread: it queues the presented frames in the background, and dequeues the next free
+//! slot ahead of time, so that [`PresentQueue::acquire`] only waits when every buffer is in
+//! use.
+//!
+//! ```ignore
+//! use nx_rt::vi_manager::present::{PresentConfig, PresentMode, PresentQueue};
+//!
+//! let queue = PresentQueue::new(producer, PresentConfig::new(3, 1280, 720, format, usage))?;
+//! loop {
+//!     let frame = queue.acquire()?;
+//!     let fence = render(frame.slot(), frame.fence());
+//!     queue.present(frame, NvMultiFence::from_fence(fence))?;
+//! }
+//! ```
+
+use alloc::{boxed::Box, collections::VecDeque};
+use core::{ffi::c_void, mem::ManuallyDrop, ptr};
+
+use nx_service_vi::buffer_queue::{
+    BufferProducer, NUM_BUFFER_SLOTS, NvMultiFence, ProducerError, QueueBufferInput,
+};
+use nx_std_sync::{
+    condvar::Condvar,
+    mutex::{Mutex, MutexGuard},
+};
+use nx_sys_thread::pool::{self, PooledThread};
+
+/// Stack size of the presentation thread.
+const THREAD_STACK_SIZE: usize = 0x4000;
+
+/// Priority of the presentation thread, above the default one so that presented frames
+/// reach the compositor ahead of the next frame's rendering.
+const THREAD_PRIORITY: i32 = 0x2B;
+
+/// Runs the presentation thread on the default core of the process.
+const THREAD_CPUID: i32 = -2;
+
+/// How presented frames replace each other.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum PresentMode {
+    /// Every presented frame is shown, for at least one vsync, in order.
+    #[default]
+    Fifo,
+    /// A presented frame replaces the previous one if it was not queued yet, and queued
+    /// frames are replaced at the next vsync: only the latest frame is shown.
+    Mailbox,
+}
+
+/// Parameters of a [`PresentQueue`].
+#[derive(Debug, Clone, Copy)]
+pub struct PresentConfig {
+    /// Number of buffers, attached to the slots `0..num_buffers` of the producer.
+    pub num_buffers: usize,
+    pub width: u32,
+    pub height: u32,
+    pub format: i32,
+    pub usage: u32,
+    pub mode: PresentMode,
+}
+
+impl PresentConfig {
+    /// Creates the parameters of a FIFO queue of `num_buffers` buffers.
+    pub fn new(num_buffers: usize, width: u32, height: u32, format: i32, usage: u32) -> Self {
+        Self {
+            num_buffers,
+            width,
+            height,
+            format,
+            usage,
+            mode: PresentMode::Fifo,
+        }
+    }
+}
+
+/// A buffer slot acquired from a [`PresentQueue`], to render into and present.
+///
+/// Dropping the frame cancels it, as [`PresentQueue::cancel`] does.
+#[must_use = "acquired frames must be presented or cancelled"]
+pub struct Frame<'q> {
+    queue: &'q PresentQueue,
+    slot: i32,
+    fence: NvMultiFence,
+}
+
+impl Frame<'_> {
+    /// Returns the buffer slot of the frame.
+    #[inline]
+    pub fn slot(&self) -> i32 {
+        self.slot
+    }
+
+    /// Returns the fences to wait for before writing the buffer.
+    ///
+    /// GPU rendering should wait for them on its channel rather than on the CPU.
+    #[inline]
+    pub fn fence(&self) -> NvMultiFence {
+        self.fence
+    }
+
+    /// Takes the dequeued slot out of the frame, without cancelling it.
+    fn into_slot(self) -> Slot {
+        let this = ManuallyDrop::new(self);
+        Slot {
+            slot: this.slot,
+            fence: this.fence,
+        }
+    }
+}
+
+impl core::fmt::Debug for Frame<'_> {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("Frame")
+            .field("slot", &self.slot)
+            .field("fence", &self.fence)
+            .finish_non_exhaustive()
+    }
+}
+
+impl Drop for Frame<'_> {
+    fn drop(&mut self) {
+        self.queue.shared.release(Slot {
+            slot: self.slot,
+            fence: self.fence,
+        });
+    }
+}
+
+/// A dequeued buffer slot held by the queue, and the fence guarding it.
+#[derive(Debug)]
+struct Slot {
+    slot: i32,
+    fence: NvMultiFence,
+}
+
+/// Presentation queue of a layer, queueing and dequeuing its buffers on a helper thread.
+pub struct PresentQueue {
+    shared: Box<Shared>,
+    thread: Option<PooledThread>,
+}
+
+impl PresentQueue {
+    /// Starts a presentation queue over `producer`.
+    ///
+    /// The producer must be connected, with buffers attached to its first
+    /// `config.num_buffers` slots.
+    pub fn new(producer: BufferProducer, config: PresentConfig) -> Result<Self, PresentQueueError> {
+        if !(2..=NUM_BUFFER_SLOTS).contains(&config.num_buffers) {
+            return Err(PresentQueueError::InvalidBufferCount);
+        }
+
+        let shared = Box::new(Shared {
+            producer,
+            config,
+            state: Mutex::new(State {
+                ready: VecDeque::with_capacity(config.num_buffers),
+                pending: VecDeque::with_capacity(config.num_buffers),
+                outstanding: 0,
+                closed: false,
+                error: None,
+            }),
+            cond: Condvar::new(),
+        });
+
+        // SAFETY: The shared state is boxed, and the thread is joined before it is dropped.
+        let mut thread = unsafe {
+            pool::spawn(
+                present_thread,
+                ptr::from_ref(&*shared).cast_mut().cast(),
+                THREAD_STACK_SIZE,
+                THREAD_PRIORITY,
+                THREAD_CPUID,
+            )
+        }
+        .map_err(PresentQueueError::Spawn)?;
+        thread.start().map_err(PresentQueueError::Start)?;
+
+        Ok(Self {
+            shared,
+            thread: Some(thread),
+        })
+    }
+
+    /// Returns the queue parameters.
+    #[inline]
+    pub fn config(&self) -> &PresentConfig {
+        &self.shared.config
+    }
+
+    /// Acquires the next free frame, waiting for one if every buffer is in use.
+    pub fn acquire(&self) -> Result<Frame<'_>, PresentError> {
+        let state = self.shared.state.lock();
+        let mut state = self
+            .shared
+            .cond
+            .wait_while(state, |state| state.ready.is_empty() && !state.closed);
+        state.take_ready().map(|slot| self.frame(slot))
+    }
+
+    /// Acquires the next free frame if one is ready, without waiting.
+    pub fn try_acquire(&self) -> Result<Option<Frame<'_>>, PresentError> {
+        let mut state = self.shared.state.lock();
+        if state.ready.is_empty() && !state.closed {
+            return Ok(None);
+        }
+        state.take_ready().map(|slot| Some(self.frame(slot)))
+    }
+
+    /// Presents `frame` once `fence`, the fence of its rendering, is reached.
+    ///
+    /// Returns without waiting for the frame to be queued.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `frame` was acquired from another queue.
+    pub fn present(&self, frame: Frame<'_>, fence: NvMultiFence) -> Result<(), PresentError> {
+        assert!(ptr::eq(frame.queue, self), "frame of another present queue");
+        let slot = frame.into_slot().slot;
+
+        let mut state = self.shared.state.lock();
+        if state.closed {
+            // Cancelled along with the other dequeued slots, once the queue is dropped
+            state.ready.push_front(Slot { slot, fence });
+            return Err(state
+                .error
+                .take()
+                .map_or(PresentError::Closed, PresentError::Producer));
+        }
+
+        if self.shared.config.mode == PresentMode::Mailbox
+            && let Some(replaced) = state.pending.pop_front()
+        {
+            // The replaced frame is still dequeued: hand it out again, guarded by its
+            // rendering fence, instead of cancelling it
+            state.ready.push_back(replaced);
+        }
+        state.pending.push_back(Slot { slot, fence });
+        drop(state);
+
+        self.shared.cond.notify_all();
+        Ok(())
+    }
+
+    /// Returns the unrendered `frame` to the queue, to be acquired again.
+    pub fn cancel(&self, frame: Frame<'_>) {
+        drop(frame);
+    }
+
+    /// Stops the queue, returning its producer.
+    ///
+    /// The pending frames are queued, and the other dequeued slots are cancelled.
+    pub fn close(self) -> BufferProducer {
+        let mut this = ManuallyDrop::new(self);
+        this.stop();
+
+        // SAFETY: `this` is never dropped, so the shared state is moved out only once.
+        let shared = unsafe { ptr::read(&this.shared) };
+        shared.producer
+    }
+
+    fn frame(&self, slot: Slot) -> Frame<'_> {
+        Frame {
+            queue: self,
+            slot: slot.slot,
+            fence: slot.fence,
+        }
+    }
+
+    fn stop(&mut self) {
+        let Some(thread) = self.thread.take() else {
+            return;
+        };
+
+        self.shared.state.lock().closed = true;
+        self.shared.cond.notify_all();
+        let _ = thread.join();
+
+        // The thread is gone: flush what it left behind from this one
+        let shared = &*self.shared;
+        let mut state = shared.state.lock();
+        while let Some(frame) = state.pending.pop_front() {
+            let _ = shared.queue(&frame);
+        }
+        while let Some(frame) = state.ready.pop_front() {
+            let _ = shared.producer.cancel_buffer(frame.slot, &frame.fence);
+        }
+    }
+}
+
+impl Drop for PresentQueue {
+    fn drop(&mut self) {
+        self.stop();
+    }
+}
+
+/// State shared with the presentation thread.
+struct Shared {
+    producer: BufferProducer,
+    config: PresentConfig,
+    state: Mutex<State>,
+    cond: Condvar,
+}
+
+struct State {
+    /// Dequeued slots, to hand out.
+    ready: VecDeque<Slot>,
+    /// Presented slots, with their rendering fence, to queue.
+    pending: VecDeque<Slot>,
+    /// Number of slots dequeued and not queued or cancelled yet.
+    outstanding: usize,
+    closed: bool,
+    /// Error stopping the presentation thread, not reported yet.
+    error: Option<ProducerError>,
+}
+
+impl State {
+    fn take_ready(&mut self) -> Result<Slot, PresentError> {
+        match self.ready.pop_front() {
+            Some(frame) => Ok(frame),
+            None => Err(self
+                .error
+                .take()
+                .map_or(PresentError::Closed, PresentError::Producer)),
+        }
+    }
+}
+
+impl Shared {
+    /// Queues the pending frames and dequeues free slots until closed.
+    fn run(&self) {
+        // One buffer stays with the compositor: dequeuing more than the others would block
+        // until a frame is queued, which this same thread does
+        let max_outstanding = self.config.num_buffers - 1;
+
+        let mut state = self.state.lock();
+        while !state.closed {
+            if let Some(frame) = state.pending.pop_front() {
+                drop(state);
+                let res = self.queue(&frame);
+                state = self.state.lock();
+
+                match res {
+                    Ok(()) => state.outstanding -= 1,
+                    Err(err) => return self.fail(state, err),
+                }
+            } else if state.outstanding < max_outstanding {
+                drop(state);
+                let res = self.producer.dequeue_buffer(
+                    false,
+                    self.config.width,
+                    self.config.height,
+                    self.config.format,
+                    self.config.usage,
+                );
+                state = self.state.lock();
+
+                match res {
+                    Ok(dequeued) => {
+                        state.outstanding += 1;
+                        state.ready.push_back(Slot {
+                            slot: dequeued.slot,
+                            fence: dequeued.fence,
+                        });
+                        self.cond.notify_all();
+                    }
+                    Err(err) => return self.fail(state, err),
+                }
+            } else {
+                state = self.cond.wait(state);
+            }
+        }
+    }
+
+    fn queue(&self, frame: &Slot) -> Result<(), ProducerError> {
+        let swap_interval = match self.config.mode {
+            PresentMode::Fifo => 1,
+            PresentMode::Mailbox => 0,
+        };
+        self.producer
+            .queue_buffer(
+                frame.slot,
+                &QueueBufferInput::new(frame.fence, swap_interval),
+            )
+            .map(drop)
+    }
+
+    /// Returns a dequeued slot, not rendered into, to be handed out again.
+    fn release(&self, slot: Slot) {
+        self.state.lock().ready.push_front(slot);
+        self.cond.notify_all();
+    }
+
+    /// Stops on `err`, reporting it to the next caller.
+    fn fail(&self, mut state: MutexGuard<'_, State>, err: ProducerError) {
+        state.closed = true;
+        state.error = Some(err);
+        drop(state);
+        self.cond.notify_all();
+    }
+}
+
+/// Entry point of the presentation thread.
+unsafe extern "C" fn present_thread(arg: *mut c_void) {
+    // SAFETY: `PresentQueue::new` passes the boxed shared state, which outlives the thread.
+    let shared = unsafe { &*arg.cast::<Shared>() };
+    shared.run();
+}
+
+/// Error returned by [`PresentQueue::new`].
+#[derive(Debug, thiserror::Error)]
+pub enum PresentQueueError {
+    /// The buffer count is below two or above the number of slots.
+    #[error("invalid presentation queue buffer count")]
+    InvalidBufferCount,
+    /// Creating the presentation thread failed.
+    #[error("failed to spawn the presentation thread")]
+    Spawn(#[source] pool::SpawnError),
+    /// Starting the presentation thread failed.
+    #[error("failed to start the presentation thread")]
+    Start(#[source] nx_sys_thread::ThreadStartError),
+}
+
+/// Error returned when acquiring or presenting a frame.
+#[derive(Debug, thiserror::Error)]
+pub enum PresentError {
+    /// A buffer queue transaction failed, stopping the queue.
+    #[error("presentation queue transaction failed")]
+    Producer(#[source] ProducerError),
+    /// The queue is stopped.
+    #[error("presentation queue closed")]
+    Closed,
+}
@@ -0,0 +1,71 @@
+//! Host benchmarks of the HID shared memory LIFO readers.
+
+use core::{hint::black_box, sync::atomic::AtomicU64};
+
+use criterion::{Criterion, criterion_group, criterion_main};
+use nx_service_hid::shmem::{
+    lifo::{self, HidCommonLifoHeader, LifoReader},
+    types::{AtomicStorage, NpadCommonState},
+};
+
+/// Number of entries of the npad LIFOs.
+const LIFO_ENTRIES: usize = 17;
+
+/// A full LIFO, its tail wrapped around the ring.
+fn full_lifo() -> (HidCommonLifoHeader, Vec<AtomicStorage<NpadCommonState>>) {
+    let tail = 5;
+    let storage = (0..LIFO_ENTRIES)
+        .map(|pos| {
+            // The entry at `tail` is the newest one, the one after it the oldest
+            let age = (tail + LIFO_ENTRIES - pos) % LIFO_ENTRIES;
+            let sampling_number = 1000 - age as u64;
+            AtomicStorage {
+                sampling_number,
+                state: NpadCommonState {
+                    sampling_number,
+                    ..Default::default()
+                },
+            }
+        })
+        .collect();
+    let header = HidCommonLifoHeader {
+        unused: 0,
+        buffer_count: LIFO_ENTRIES as u64,
+        tail: AtomicU64::new(tail as u64),
+        count: AtomicU64::new(LIFO_ENTRIES as u64),
+    };
+    (header, storage)
+}
+
+fn bench_get_states(c: &mut Criterion) {
+    let (header, storage) = full_lifo();
+    let mut out = [NpadCommonState::default(); LIFO_ENTRIES];
+
+    let mut group = c.benchmark_group("lifo::get_states");
+    group.bench_function("latest", |b| {
+        b.iter(|| black_box(lifo::get_states(&header, &storage, &mut out[..1])));
+    });
+    group.bench_function("all", |b| {
+        b.iter(|| black_box(lifo::get_states(&header, &storage, &mut out)));
+    });
+    group.finish();
+}
+
+fn bench_read_new(c: &mut Criterion) {
+    let (header, storage) = full_lifo();
+    let mut out = [NpadCommonState::default(); LIFO_ENTRIES];
+
+    let mut group = c.benchmark_group("lifo::read_new");
+    group.bench_function("unchanged", |b| {
+        let mut reader = LifoReader::new();
+        reader.read_new(&header, &storage, &mut out);
+        b.iter(|| black_box(reader.read_new(&header, &storage, &mut out)));
+    });
+    group.bench_function("all", |b| {
+        b.iter(|| black_box(LifoReader::new().read_new(&header, &storage, &mut out)));
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_get_states, bench_read_new);
+criterion_main!(benches);
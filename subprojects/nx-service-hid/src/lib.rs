@@ -28,7 +28,7 @@ mod cmif;
 mod proto;
 pub mod shmem;
 
-use self::shmem::HidSharedMemory;
+use self::shmem::{HidSharedMemory, HidSnapshot};
 pub use self::{
     cmif::{
         ActivateGestureError, ActivateKeyboardError, ActivateMouseError, ActivateNpadError,
@@ -79,6 +79,15 @@ impl HidService {
         unsafe { self.shmem_ptr.as_ref() }
     }
 
+    /// Refreshes `snapshot` with the newest state of all the input devices.
+    ///
+    /// Returns the bitmask of the devices that changed. See
+    /// [`shmem::snapshot_all`].
+    #[inline]
+    pub fn snapshot_all(&self, snapshot: &mut HidSnapshot) -> u32 {
+        shmem::snapshot_all(self.shared_memory(), snapshot)
+    }
+
     /// Consumes and closes the HID service session.
     #[inline]
     pub fn close(self) {
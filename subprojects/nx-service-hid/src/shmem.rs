@@ -2,8 +2,10 @@
 
 pub mod layout;
 pub mod lifo;
+pub mod snapshot;
 pub mod types;
 
 pub use layout::HidSharedMemory;
-pub use lifo::{HidCommonLifoHeader, get_states};
+pub use lifo::{HidCommonLifoHeader, LifoReader, get_states};
+pub use snapshot::{HidSnapshot, snapshot_all};
 pub use types::*;
@@ -3,9 +3,34 @@
 //! This module defines the exact memory layout of the HID shared memory region.
 //! All structures must match the official layout exactly for correct operation.
 
+use core::mem::{offset_of, size_of};
+
+use super::{
+    lifo::HidCommonLifoHeader,
+    types::{AtomicStorage, KeyboardState, MouseState, NpadCommonState, TouchScreenState},
+};
+
 /// Size of the HID shared memory region.
 pub const HID_SHARED_MEMORY_SIZE: usize = 0x40000;
 
+/// Number of entries in the LIFO ring buffers of the input devices.
+pub const LIFO_ENTRY_COUNT: usize = 17;
+
+/// Number of Npad entries: `No1` to `No8`, then `Handheld` and `Other`.
+pub const NPAD_COUNT: usize = 10;
+
+/// LIFO ring buffer of one input device.
+#[repr(C)]
+pub struct HidLifo<S> {
+    pub header: HidCommonLifoHeader,
+    pub storage: [S; LIFO_ENTRY_COUNT],
+}
+
+pub type HidTouchScreenLifo = HidLifo<AtomicStorage<TouchScreenState>>;
+pub type HidMouseLifo = HidLifo<AtomicStorage<MouseState>>;
+pub type HidKeyboardLifo = HidLifo<AtomicStorage<KeyboardState>>;
+pub type HidNpadCommonLifo = HidLifo<AtomicStorage<NpadCommonState>>;
+
 /// Placeholder for individual input device sections.
 ///
 /// Each input device (touch, mouse, keyboard, etc.) has its own section in
@@ -17,22 +42,25 @@ pub struct HidDebugPadSharedMemoryFormat {
 
 #[repr(C)]
 pub struct HidTouchScreenSharedMemoryFormat {
-    _data: [u8; 0x3000],
+    pub lifo: HidTouchScreenLifo,
+    _padding: [u8; 0x3000 - size_of::<HidTouchScreenLifo>()],
 }
 
 #[repr(C)]
 pub struct HidMouseSharedMemoryFormat {
-    _data: [u8; 0x400],
+    pub lifo: HidMouseLifo,
+    _padding: [u8; 0x400 - size_of::<HidMouseLifo>()],
 }
 
 #[repr(C)]
 pub struct HidKeyboardSharedMemoryFormat {
-    _data: [u8; 0x400],
+    pub lifo: HidKeyboardLifo,
+    _padding: [u8; 0x400 - size_of::<HidKeyboardLifo>()],
 }
 
 #[repr(C)]
 pub struct HidDigitizerSharedMemoryFormat {
-    _data: [u8; 0x400],
+    _data: [u8; 0x1000],
 }
 
 #[repr(C)]
@@ -57,12 +85,32 @@ pub struct HidInputDetectorSharedMemoryFormat {
 
 #[repr(C)]
 pub struct HidUniquePadSharedMemoryFormat {
-    _data: [u8; 0x400],
+    _data: [u8; 0x4000],
+}
+
+/// State of one Npad.
+///
+/// Only the style set and the common state LIFOs are typed; the colors, the
+/// six-axis sensor LIFOs and the device properties are left opaque.
+#[repr(C)]
+pub struct HidNpadInternalState {
+    /// Bitfield of the styles the Npad currently supports.
+    pub style_set: u32,
+    pub joy_assignment_mode: u32,
+    _colors: [u8; 0x20],
+    pub full_key_lifo: HidNpadCommonLifo,
+    pub handheld_lifo: HidNpadCommonLifo,
+    pub joy_dual_lifo: HidNpadCommonLifo,
+    pub joy_left_lifo: HidNpadCommonLifo,
+    pub joy_right_lifo: HidNpadCommonLifo,
+    pub palma_lifo: HidNpadCommonLifo,
+    pub system_ext_lifo: HidNpadCommonLifo,
+    _rest: [u8; 0x5000 - 0x28 - 7 * size_of::<HidNpadCommonLifo>()],
 }
 
 #[repr(C)]
 pub struct HidNpadSharedMemoryFormat {
-    _data: [u8; 0x32000],
+    pub entries: [HidNpadInternalState; NPAD_COUNT],
 }
 
 #[repr(C)]
@@ -72,7 +120,7 @@ pub struct HidGestureSharedMemoryFormat {
 
 #[repr(C)]
 pub struct HidConsoleSixAxisSensor {
-    _data: [u8; 0x400],
+    _data: [u8; 0x20],
 }
 
 /// HID shared memory structure (0x40000 bytes).
@@ -96,6 +144,15 @@ pub struct HidSharedMemory {
     _padding: [u8; 0x3DE0],
 }
 
+const _: () = {
+    assert!(size_of::<HidTouchScreenSharedMemoryFormat>() == 0x3000);
+    assert!(size_of::<HidMouseSharedMemoryFormat>() == 0x400);
+    assert!(size_of::<HidKeyboardSharedMemoryFormat>() == 0x400);
+    assert!(size_of::<HidNpadInternalState>() == 0x5000);
+    assert!(offset_of!(HidSharedMemory, npad) == 0x9A00);
+    assert!(size_of::<HidSharedMemory>() == HID_SHARED_MEMORY_SIZE);
+};
+
 impl HidSharedMemory {
     /// Size of the shared memory region.
     pub const SIZE: usize = HID_SHARED_MEMORY_SIZE;
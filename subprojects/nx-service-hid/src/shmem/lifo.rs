@@ -22,6 +22,10 @@ pub struct HidCommonLifoHeader {
     pub count: AtomicU64,
 }
 
+/// Number of attempts at a consistent read before falling back to the freshest
+/// consistent entry.
+const MAX_RETRIES: usize = 3;
+
 /// Read states from a LIFO ring buffer with atomic consistency guarantees.
 ///
 /// This function implements the lock-free algorithm used by libnx:
@@ -31,6 +35,9 @@ pub struct HidCommonLifoHeader {
 /// 4. Check sampling numbers for consistency (torn reads and sequential order)
 /// 5. Retry if inconsistent
 ///
+/// If no consistent read succeeds after a few retries, falls back to the
+/// freshest entry that was not torn, if any.
+///
 /// # Arguments
 ///
 /// * `header` - LIFO header containing tail and count
@@ -49,7 +56,6 @@ pub fn get_states<T: InputState>(
     storage: &[T::Storage],
     out: &mut [T],
 ) -> usize {
-    const MAX_RETRIES: usize = 3;
     let max_states = storage.len() as u64;
 
     for _ in 0..MAX_RETRIES {
@@ -75,27 +81,18 @@ pub fn get_states<T: InputState>(
 
             // Load with torn-read detection
             // Safety: entrypos is bounds-checked against storage.len()
-            let entry = &storage[entrypos as usize];
-
-            // Read sampling number before and after loading state
-            let sampling0 = unsafe { ptr::read_volatile(entry as *const T::Storage as *const u64) };
-            let state = unsafe { T::load_from_storage(entry) };
-            let sampling1 = unsafe { ptr::read_volatile(entry as *const T::Storage as *const u64) };
+            let Some(state) = load_entry::<T>(&storage[entrypos as usize]) else {
+                consistent = false;
+                break;
+            };
 
             let curr_sampling = state.sampling_number();
 
             // Output in reverse order (newest first)
             let out_idx = (total_entries - 1 - i) as usize;
 
-            // Consistency checks:
-            // 1. Torn read check: sampling numbers changed during read
-            // 2. Sequential check: adjacent samples should differ by exactly 1
-            if sampling0 != sampling1 {
-                consistent = false;
-                break;
-            }
-
-            if i > 0 && prev_sampling.wrapping_sub(curr_sampling) != 1 {
+            // Sequential check: adjacent samples should differ by exactly 1
+            if i > 0 && curr_sampling.wrapping_sub(prev_sampling) != 1 {
                 consistent = false;
                 break;
             }
@@ -111,8 +108,183 @@ pub fn get_states<T: InputState>(
         // Inconsistent read, retry
     }
 
-    // Failed to get consistent read after retries
-    0
+    // No consistent read after retries: settle for the freshest entry
+    let Some(slot) = out.first_mut() else {
+        return 0;
+    };
+    match freshest(header, storage, None) {
+        Some(state) => {
+            *slot = state;
+            1
+        }
+        None => 0,
+    }
+}
+
+/// Incremental reader of a LIFO ring buffer.
+///
+/// Remembers the sampling number of the newest entry it returned, so each
+/// [`read_new`](Self::read_new) only copies the entries pushed since the
+/// previous call, walking back from the tail and stopping at the first entry
+/// already seen. Suited to polling at a high rate, where most calls only find
+/// one or two new samples.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct LifoReader {
+    /// Sampling number of the newest entry returned, if any.
+    last_sampling: Option<u64>,
+}
+
+impl LifoReader {
+    /// Creates a reader that has not seen any entry yet.
+    pub const fn new() -> Self {
+        Self {
+            last_sampling: None,
+        }
+    }
+
+    /// Returns the sampling number of the newest entry returned so far.
+    #[inline]
+    pub fn last_sampling_number(&self) -> Option<u64> {
+        self.last_sampling
+    }
+
+    /// Reads the entries pushed since the previous call, newest first.
+    ///
+    /// Returns the number of states written to `out`. When more new entries
+    /// than `out.len()` are available, the newest ones are returned and the
+    /// older ones are skipped.
+    ///
+    /// If the writer keeps tearing the reads, it falls back to the freshest
+    /// consistent entry instead of returning nothing; entries between it and
+    /// the previous call are then skipped.
+    pub fn read_new<T: InputState>(
+        &mut self,
+        header: &HidCommonLifoHeader,
+        storage: &[T::Storage],
+        out: &mut [T],
+    ) -> usize {
+        if out.is_empty() || storage.is_empty() {
+            return 0;
+        }
+
+        for _ in 0..MAX_RETRIES {
+            if let Some(read) = self.try_read_new(header, storage, out) {
+                return read;
+            }
+        }
+
+        match freshest::<T>(header, storage, None) {
+            Some(state) if self.is_new(state.sampling_number()) => {
+                self.last_sampling = Some(state.sampling_number());
+                out[0] = state;
+                1
+            }
+            _ => 0,
+        }
+    }
+
+    /// Attempts a consistent read of the new entries.
+    ///
+    /// Returns `None` if the writer raced the read.
+    fn try_read_new<T: InputState>(
+        &mut self,
+        header: &HidCommonLifoHeader,
+        storage: &[T::Storage],
+        out: &mut [T],
+    ) -> Option<usize> {
+        let tail = header.tail.load(Ordering::Acquire) as usize;
+        let count = header
+            .count
+            .load(Ordering::Acquire)
+            .min(header.buffer_count) as usize;
+        let available = count.min(storage.len()).min(out.len());
+        if tail >= storage.len() {
+            return None;
+        }
+
+        // Walk from the newest entry back, wrapping without a modulo per entry
+        let mut pos = tail;
+        let mut read = 0;
+        while read < available {
+            let state = load_entry::<T>(&storage[pos])?;
+            let sampling = state.sampling_number();
+            if !self.is_new(sampling) {
+                break;
+            }
+            // Entries must be consecutive, or the writer overwrote the ones being read
+            if read > 0 && out[read - 1].sampling_number().wrapping_sub(sampling) != 1 {
+                return None;
+            }
+
+            out[read] = state;
+            read += 1;
+            pos = if pos == 0 { storage.len() - 1 } else { pos - 1 };
+        }
+
+        if read > 0 {
+            self.last_sampling = Some(out[0].sampling_number());
+        }
+        Some(read)
+    }
+
+    #[inline]
+    fn is_new(&self, sampling: u64) -> bool {
+        self.last_sampling.is_none_or(|last| sampling > last)
+    }
+}
+
+/// Loads one entry, returning `None` if the writer updated it during the read.
+#[inline]
+fn load_entry<T: InputState>(entry: &T::Storage) -> Option<T> {
+    // Read sampling number before and after loading state
+    let sampling0 = sampling_number::<T>(entry);
+    // SAFETY: `entry` is a valid, aligned storage slot.
+    let state = unsafe { T::load_from_storage(entry) };
+    let sampling1 = sampling_number::<T>(entry);
+
+    // Torn read check: sampling numbers changed during read
+    (sampling0 == sampling1).then_some(state)
+}
+
+/// Reads the sampling number of the storage entry.
+#[inline]
+fn sampling_number<T: InputState>(entry: &T::Storage) -> u64 {
+    // SAFETY: Every LIFO entry starts with its u64 sampling number.
+    unsafe { ptr::read_volatile(entry as *const T::Storage as *const u64) }
+}
+
+/// Returns the freshest entry that can be read without tearing.
+///
+/// If `seen` is given, stops at the entry with that sampling number and returns
+/// `None`: only its sampling number is read, so polling an unchanged LIFO does
+/// not copy any state.
+///
+/// Wait-free: walks back from the tail at most once around the ring.
+pub(super) fn freshest<T: InputState>(
+    header: &HidCommonLifoHeader,
+    storage: &[T::Storage],
+    seen: Option<u64>,
+) -> Option<T> {
+    let tail = header.tail.load(Ordering::Acquire) as usize;
+    let count = header
+        .count
+        .load(Ordering::Acquire)
+        .min(header.buffer_count) as usize;
+    if tail >= storage.len() {
+        return None;
+    }
+
+    let mut pos = tail;
+    for _ in 0..count.min(storage.len()) {
+        if seen.is_some() && seen == Some(sampling_number::<T>(&storage[pos])) {
+            return None;
+        }
+        if let Some(state) = load_entry::<T>(&storage[pos]) {
+            return Some(state);
+        }
+        pos = if pos == 0 { storage.len() - 1 } else { pos - 1 };
+    }
+    None
 }
 
 #[cfg(test)]
@@ -189,4 +361,86 @@ mod tests {
         assert_eq!(out[0].sampling_number, 100);
         assert_eq!(out[0].value, 42);
     }
+
+    /// Builds a 17-entry LIFO holding `samplings` as pushed in order.
+    fn make_lifo(samplings: &[u64]) -> (HidCommonLifoHeader, [TestState; 17]) {
+        let mut storage = [TestState {
+            sampling_number: 0,
+            value: 0,
+        }; 17];
+        for (i, &sampling) in samplings.iter().enumerate() {
+            storage[i % 17] = TestState {
+                sampling_number: sampling,
+                value: sampling as i32 * 10,
+            };
+        }
+
+        let header = HidCommonLifoHeader {
+            unused: 0,
+            buffer_count: 17,
+            tail: AtomicU64::new(((samplings.len() + 16) % 17) as u64),
+            count: AtomicU64::new(samplings.len().min(17) as u64),
+        };
+        (header, storage)
+    }
+
+    #[test]
+    fn test_get_states_multiple() {
+        let (header, storage) = make_lifo(&[1, 2, 3, 4]);
+
+        let mut out = [TestState {
+            sampling_number: 0,
+            value: 0,
+        }; 3];
+
+        let count = get_states(&header, &storage, &mut out);
+        assert_eq!(count, 3);
+        assert_eq!(out.map(|s| s.sampling_number), [4, 3, 2]);
+    }
+
+    #[test]
+    fn test_reader_returns_only_new_entries() {
+        let samplings: [u64; 20] = core::array::from_fn(|i| i as u64 + 1);
+        let mut reader = LifoReader::new();
+        let mut out = [TestState {
+            sampling_number: 0,
+            value: 0,
+        }; 8];
+
+        let (header, storage) = make_lifo(&samplings[..5]);
+        assert_eq!(reader.read_new(&header, &storage, &mut out), 5);
+        assert_eq!(out[..5].iter().map(|s| s.sampling_number).max(), Some(5));
+        assert_eq!(out[0].sampling_number, 5);
+        assert_eq!(out[4].sampling_number, 1);
+
+        // No new entries
+        assert_eq!(reader.read_new(&header, &storage, &mut out), 0);
+
+        // Wraps around the ring
+        let (header, storage) = make_lifo(&samplings);
+        assert_eq!(reader.read_new(&header, &storage, &mut out), 8);
+        assert_eq!(out[0].sampling_number, 20);
+        assert_eq!(out[7].sampling_number, 13);
+        assert_eq!(out[7].value, 130);
+        assert_eq!(reader.last_sampling_number(), Some(20));
+    }
+
+    #[test]
+    fn test_reader_falls_back_to_freshest() {
+        // A gap in the sampling numbers never reads consistently
+        let (header, storage) = make_lifo(&[1, 2, 5, 6]);
+        let mut reader = LifoReader::new();
+        let mut out = [TestState {
+            sampling_number: 0,
+            value: 0,
+        }; 4];
+
+        assert_eq!(reader.read_new(&header, &storage, &mut out), 1);
+        assert_eq!(out[0].sampling_number, 6);
+
+        let (header, storage) = make_lifo(&[6, 9, 11]);
+        assert_eq!(reader.read_new(&header, &storage, &mut out), 1);
+        assert_eq!(out[0].sampling_number, 11);
+        assert_eq!(get_states(&header, &storage, &mut out), 1);
+    }
 }
@@ -0,0 +1,128 @@
+//! Single-pass snapshot of all the input devices.
+//!
+//! [`snapshot_all`] refreshes a caller-owned [`HidSnapshot`] with the newest
+//! state of the touch screen, mouse, keyboard and every connected Npad. The
+//! devices are visited in shared memory order, and a device whose newest entry
+//! was already captured costs a single load of its sampling number. The
+//! returned bitmask tells which devices changed, so unchanged controllers can
+//! be skipped.
+
+use super::{
+    layout::{HidLifo, HidNpadCommonLifo, HidNpadInternalState, HidSharedMemory, NPAD_COUNT},
+    lifo,
+    types::{InputState, KeyboardState, MouseState, NpadCommonState, TouchScreenState},
+};
+
+/// Changed bit of the touch screen. Npad `i` uses bit `i`.
+pub const SNAPSHOT_TOUCH_SCREEN: u32 = 1 << NPAD_COUNT;
+/// Changed bit of the mouse.
+pub const SNAPSHOT_MOUSE: u32 = 1 << (NPAD_COUNT + 1);
+/// Changed bit of the keyboard.
+pub const SNAPSHOT_KEYBOARD: u32 = 1 << (NPAD_COUNT + 2);
+
+/// Npad style bits, in the order their LIFO is preferred.
+const NPAD_STYLE_FULL_KEY: u32 = 1 << 0;
+const NPAD_STYLE_HANDHELD: u32 = 1 << 1;
+const NPAD_STYLE_JOY_DUAL: u32 = 1 << 2;
+const NPAD_STYLE_JOY_LEFT: u32 = 1 << 3;
+const NPAD_STYLE_JOY_RIGHT: u32 = 1 << 4;
+const NPAD_STYLE_GC: u32 = 1 << 5;
+const NPAD_STYLE_PALMA: u32 = 1 << 6;
+const NPAD_STYLE_SYSTEM_EXT: u32 = 1 << 29;
+const NPAD_STYLE_SYSTEM: u32 = 1 << 30;
+
+/// Newest state of all the input devices.
+///
+/// Npads are indexed `No1` to `No8`, then `Handheld` and `Other`. An Npad
+/// without any style is disconnected and keeps its last state.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct HidSnapshot {
+    /// Devices changed by the last [`snapshot_all`] call.
+    pub changed: u32,
+    /// Style set of each Npad.
+    pub npad_style_sets: [u32; NPAD_COUNT],
+    pub npads: [NpadCommonState; NPAD_COUNT],
+    pub touch_screen: TouchScreenState,
+    pub mouse: MouseState,
+    pub keyboard: KeyboardState,
+}
+
+impl HidSnapshot {
+    /// Returns `true` if Npad `index` changed during the last snapshot.
+    #[inline]
+    pub fn npad_changed(&self, index: usize) -> bool {
+        index < NPAD_COUNT && self.changed & (1 << index) != 0
+    }
+}
+
+/// Refreshes `snapshot` with the newest state of every device.
+///
+/// Returns the changed bitmask, also stored in [`HidSnapshot::changed`]. An
+/// Npad is changed when it got a new sample or its style set changed.
+pub fn snapshot_all(shmem: &HidSharedMemory, snapshot: &mut HidSnapshot) -> u32 {
+    let mut changed = 0;
+
+    if refresh(&shmem.touchscreen.lifo, &mut snapshot.touch_screen) {
+        changed |= SNAPSHOT_TOUCH_SCREEN;
+    }
+    if refresh(&shmem.mouse.lifo, &mut snapshot.mouse) {
+        changed |= SNAPSHOT_MOUSE;
+    }
+    if refresh(&shmem.keyboard.lifo, &mut snapshot.keyboard) {
+        changed |= SNAPSHOT_KEYBOARD;
+    }
+
+    for (i, entry) in shmem.npad.entries.iter().enumerate() {
+        // SAFETY: The style set is a plain u32 updated by the service.
+        let style_set = unsafe { core::ptr::read_volatile(&entry.style_set) };
+        if style_set != snapshot.npad_style_sets[i] {
+            snapshot.npad_style_sets[i] = style_set;
+            changed |= 1 << i;
+        }
+
+        if let Some(lifo) = npad_lifo(entry, style_set)
+            && refresh(lifo, &mut snapshot.npads[i])
+        {
+            changed |= 1 << i;
+        }
+    }
+
+    snapshot.changed = changed;
+    changed
+}
+
+/// Replaces `state` with the newest entry of `lifo` if it is a new one.
+#[inline]
+fn refresh<T: InputState>(lifo: &HidLifo<T::Storage>, state: &mut T) -> bool {
+    let seen = Some(state.sampling_number());
+    match lifo::freshest::<T>(&lifo.header, &lifo.storage, seen) {
+        Some(new) => {
+            *state = new;
+            true
+        }
+        None => false,
+    }
+}
+
+/// Returns the LIFO holding the state of the Npad's preferred style.
+fn npad_lifo(entry: &HidNpadInternalState, style_set: u32) -> Option<&HidNpadCommonLifo> {
+    let lifo = if style_set & (NPAD_STYLE_FULL_KEY | NPAD_STYLE_GC) != 0 {
+        &entry.full_key_lifo
+    } else if style_set & NPAD_STYLE_HANDHELD != 0 {
+        &entry.handheld_lifo
+    } else if style_set & NPAD_STYLE_JOY_DUAL != 0 {
+        &entry.joy_dual_lifo
+    } else if style_set & NPAD_STYLE_JOY_LEFT != 0 {
+        &entry.joy_left_lifo
+    } else if style_set & NPAD_STYLE_JOY_RIGHT != 0 {
+        &entry.joy_right_lifo
+    } else if style_set & NPAD_STYLE_PALMA != 0 {
+        &entry.palma_lifo
+    } else if style_set & (NPAD_STYLE_SYSTEM_EXT | NPAD_STYLE_SYSTEM) != 0 {
+        &entry.system_ext_lifo
+    } else {
+        return None;
+    };
+    Some(lifo)
+}
@@ -32,3 +32,102 @@ pub trait InputState: Sized {
     /// Caller must ensure the storage pointer is valid and aligned.
     unsafe fn load_from_storage(storage: &Self::Storage) -> Self;
 }
+
+/// Atomic storage entry of a LIFO ring buffer.
+///
+/// The service writes the sampling number of the entry before and after
+/// updating the state, which lets readers detect torn reads.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AtomicStorage<T> {
+    pub sampling_number: u64,
+    pub state: T,
+}
+
+/// Implements [`InputState`] for a state type stored in an [`AtomicStorage`].
+macro_rules! impl_input_state {
+    ($($ty:ty),* $(,)?) => {
+        $(
+            impl InputState for $ty {
+                type Storage = AtomicStorage<$ty>;
+
+                #[inline]
+                fn sampling_number(&self) -> u64 {
+                    self.sampling_number
+                }
+
+                #[inline]
+                unsafe fn load_from_storage(storage: &Self::Storage) -> Self {
+                    // SAFETY: The caller guarantees the storage is valid; the volatile
+                    // read keeps the load between the two sampling number checks.
+                    unsafe { core::ptr::read_volatile(&storage.state) }
+                }
+            }
+        )*
+    };
+}
+
+/// A single touch point.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct TouchState {
+    pub delta_time: u64,
+    pub attributes: u32,
+    pub finger_id: u32,
+    pub x: u32,
+    pub y: u32,
+    pub diameter_x: u32,
+    pub diameter_y: u32,
+    pub rotation_angle: u32,
+    pub reserved: u32,
+}
+
+/// Touch screen state.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct TouchScreenState {
+    pub sampling_number: u64,
+    /// Number of valid entries in `touches`.
+    pub count: i32,
+    pub reserved: u32,
+    pub touches: [TouchState; 16],
+}
+
+/// Mouse state.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct MouseState {
+    pub sampling_number: u64,
+    pub x: i32,
+    pub y: i32,
+    pub delta_x: i32,
+    pub delta_y: i32,
+    pub wheel_delta_x: i32,
+    pub wheel_delta_y: i32,
+    pub buttons: u32,
+    pub attributes: u32,
+}
+
+/// Keyboard state.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct KeyboardState {
+    pub sampling_number: u64,
+    pub modifiers: u64,
+    /// Bitmap of pressed keys, indexed by HID usage ID.
+    pub keys: [u64; 4],
+}
+
+/// Npad (controller) state shared by all the controller styles.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct NpadCommonState {
+    pub sampling_number: u64,
+    pub buttons: u64,
+    pub analog_stick_l: AnalogStickState,
+    pub analog_stick_r: AnalogStickState,
+    pub attributes: u32,
+    pub reserved: u32,
+}
+
+impl_input_state!(TouchScreenState, MouseState, KeyboardState, NpadCommonState);
@@ -0,0 +1,76 @@
+//! `/dev/nvhost-as-gpu` GPU address space ioctls.
+
+use nx_sf::Pod;
+
+use crate::{IoctlError, NvService, fd::Fd, nvmap::NvMapHandle, types::ioctl_args};
+
+/// Path of the GPU address space device.
+pub const NVHOST_AS_GPU_PATH: &str = "/dev/nvhost-as-gpu";
+
+/// GPU big page size, the granularity of [`map_buffer`] mappings using big pages.
+pub const BIG_PAGE_SIZE: u32 = 0x2_0000;
+
+/// `NVGPU_AS_IOCTL_UNMAP_BUFFER`: removes a mapping.
+const NVGPU_AS_IOCTL_UNMAP_BUFFER: u32 = 0xC008_4105;
+
+/// `NVGPU_AS_IOCTL_MAP_BUFFER_EX`: maps an nvmap handle.
+const NVGPU_AS_IOCTL_MAP_BUFFER_EX: u32 = 0xC028_4106;
+
+/// Mapping flag making the mapping cacheable by the GPU.
+pub const MAP_BUFFER_FLAG_CACHEABLE: u32 = 1 << 2;
+
+/// Maps the whole nvmap `handle` into the GPU address space `as_fd`, at an address chosen
+/// by the driver.
+///
+/// `kind` is the NV memory kind of the mapping, and `page_size` the GPU page size to map
+/// it with. Returns the GPU virtual address of the mapping.
+pub fn map_buffer(
+    nv: &NvService,
+    as_fd: Fd,
+    handle: NvMapHandle,
+    flags: u32,
+    kind: u32,
+    page_size: u32,
+) -> Result<u64, IoctlError> {
+    #[derive(Clone, Copy)]
+    #[repr(C)]
+    struct Args {
+        flags: u32,
+        kind: u32,
+        nvmap_handle: u32,
+        page_size: u32,
+        buffer_offset: u64,
+        mapping_size: u64,
+        offset: u64,
+    }
+
+    // SAFETY: Four `u32` and three `u64` fields without padding.
+    unsafe impl Pod for Args {}
+
+    let mut args = Args {
+        flags,
+        kind,
+        nvmap_handle: handle.to_raw(),
+        page_size,
+        buffer_offset: 0,
+        mapping_size: 0,
+        offset: 0,
+    };
+    nv.ioctl(as_fd, NVGPU_AS_IOCTL_MAP_BUFFER_EX, ioctl_args(&mut args))?;
+    Ok(args.offset)
+}
+
+/// Removes the GPU mapping at `gpu_va` from the address space `as_fd`.
+pub fn unmap_buffer(nv: &NvService, as_fd: Fd, gpu_va: u64) -> Result<(), IoctlError> {
+    #[derive(Clone, Copy)]
+    #[repr(C)]
+    struct Args {
+        offset: u64,
+    }
+
+    // SAFETY: A single `u64` field.
+    unsafe impl Pod for Args {}
+
+    let mut args = Args { offset: gpu_va };
+    nv.ioctl(as_fd, NVGPU_AS_IOCTL_UNMAP_BUFFER, ioctl_args(&mut args))
+}
@@ -0,0 +1,228 @@
+//! GPU channel command submission.
+//!
+//! An [`NvChannel`] queues GPFIFO entries client-side and submits them with a single
+//! `NVGPU_IOCTL_CHANNEL_KICKOFF_PB` per flush, instead of one ioctl per command buffer.
+//! Each flush returns the fence of the submitted work, which the shared [`FenceTracker`]
+//! uses to complete later waits on it without an ioctl.
+
+use core::mem::size_of;
+
+use nx_sf::Pod;
+
+use crate::{
+    Ioctl2Error, NvService,
+    fd::Fd,
+    fence::{FenceTracker, FenceWaitError, NvFence, syncpt_reached},
+    types::ioctl_args,
+};
+
+/// Maximum number of GPFIFO entries queued before a channel flushes on its own.
+pub const MAX_BATCH_ENTRIES: usize = 128;
+
+/// `NVGPU_IOCTL_CHANNEL_KICKOFF_PB`: submits GPFIFO entries passed in an extra buffer.
+const NVGPU_IOCTL_CHANNEL_KICKOFF_PB: u32 = 0xC018_481B;
+
+/// Submission flag making the GPU wait for the input fence first.
+const SUBMIT_FLAG_FENCE_WAIT: u32 = 1 << 0;
+
+/// Submission flag returning the fence of the submitted work.
+const SUBMIT_FLAG_FENCE_GET: u32 = 1 << 1;
+
+/// A GPFIFO entry, pointing the GPU to a command buffer.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+#[repr(C)]
+pub struct GpfifoEntry {
+    entry0: u32,
+    entry1: u32,
+}
+
+// SAFETY: Two `u32` fields without padding.
+unsafe impl Pod for GpfifoEntry {}
+
+impl GpfifoEntry {
+    /// The command buffer is not part of the main pushbuffer.
+    pub const FLAG_NOT_MAIN: u32 = 1 << 9;
+    /// Do not prefetch the command buffer.
+    pub const FLAG_NO_PREFETCH: u32 = 1 << 31;
+
+    /// Creates an entry for the `num_cmds` command words at GPU address `gpu_va`.
+    ///
+    /// `flags` is a combination of the `FLAG_*` constants.
+    #[inline]
+    pub const fn new(gpu_va: u64, num_cmds: u32, flags: u32) -> Self {
+        Self {
+            entry0: gpu_va as u32,
+            entry1: (gpu_va >> 32) as u32 | (num_cmds << 10) | flags,
+        }
+    }
+}
+
+/// A GPU channel batching its GPFIFO submissions.
+pub struct NvChannel<'a> {
+    nv: &'a NvService,
+    fd: Fd,
+    fences: &'a FenceTracker,
+    pending: [GpfifoEntry; MAX_BATCH_ENTRIES],
+    len: usize,
+    /// Fence the next submission makes the GPU wait for.
+    wait_fence: Option<NvFence>,
+    last_fence: Option<NvFence>,
+}
+
+impl<'a> NvChannel<'a> {
+    /// Wraps the opened GPU channel device `fd`, tracking its fences in `fences`.
+    pub fn new(nv: &'a NvService, fd: Fd, fences: &'a FenceTracker) -> Self {
+        Self {
+            nv,
+            fd,
+            fences,
+            pending: [GpfifoEntry::default(); MAX_BATCH_ENTRIES],
+            len: 0,
+            wait_fence: None,
+            last_fence: None,
+        }
+    }
+
+    /// Returns the channel device file descriptor.
+    #[inline]
+    pub fn fd(&self) -> Fd {
+        self.fd
+    }
+
+    /// Returns the number of queued entries.
+    #[inline]
+    pub fn pending(&self) -> usize {
+        self.len
+    }
+
+    /// Returns the fence of the last submission, if any.
+    #[inline]
+    pub fn last_fence(&self) -> Option<NvFence> {
+        self.last_fence
+    }
+
+    /// Queues `entry`, flushing the queue first if it is full.
+    pub fn push(&mut self, entry: GpfifoEntry) -> Result<(), SubmitError> {
+        if self.len == MAX_BATCH_ENTRIES {
+            self.flush()?;
+        }
+
+        self.pending[self.len] = entry;
+        self.len += 1;
+        Ok(())
+    }
+
+    /// Makes the GPU wait for `fence` before running the next submission.
+    ///
+    /// Fences already known to be signaled are dropped, sparing the GPU-side wait. A
+    /// submission waits for a single fence, so if another syncpoint fence is already
+    /// pending, the queued entries are flushed first, or with no queued entries, the
+    /// pending fence is waited for on the CPU.
+    pub fn wait_for(&mut self, fence: NvFence) -> Result<(), SubmitError> {
+        if self.fences.is_signaled(fence) {
+            return Ok(());
+        }
+
+        match self.wait_fence {
+            Some(queued) if queued.id == fence.id => {
+                if syncpt_reached(queued.value, fence.value) {
+                    return Ok(());
+                }
+            }
+            Some(_) if self.len > 0 => {
+                self.flush()?;
+            }
+            Some(queued) => self
+                .fences
+                .wait(self.nv, queued, -1)
+                .map_err(SubmitError::Wait)?,
+            None => {}
+        }
+
+        self.wait_fence = Some(fence);
+        Ok(())
+    }
+
+    /// Submits the queued entries, returning the fence of the submitted work.
+    ///
+    /// Returns `None` if no entry was queued.
+    pub fn flush(&mut self) -> Result<Option<NvFence>, SubmitError> {
+        if self.len == 0 {
+            return Ok(None);
+        }
+
+        #[derive(Clone, Copy)]
+        #[repr(C)]
+        struct Args {
+            gpfifo: u64,
+            num_entries: u32,
+            flags: u32,
+            fence: NvFence,
+        }
+
+        // SAFETY: `u64`, two `u32` and a `Pod` fence, without padding.
+        unsafe impl Pod for Args {}
+
+        let wait_fence = self
+            .wait_fence
+            .filter(|fence| !self.fences.is_signaled(*fence));
+        let mut args = Args {
+            gpfifo: 0,
+            num_entries: self.len as u32,
+            flags: SUBMIT_FLAG_FENCE_GET
+                | if wait_fence.is_some() {
+                    SUBMIT_FLAG_FENCE_WAIT
+                } else {
+                    0
+                },
+            fence: wait_fence.unwrap_or_default(),
+        };
+
+        let entries = &self.pending[..self.len];
+        // SAFETY: `GpfifoEntry` is `Pod`, so the entries are plain bytes.
+        let entries = unsafe {
+            core::slice::from_raw_parts(
+                entries.as_ptr().cast::<u8>(),
+                entries.len() * size_of::<GpfifoEntry>(),
+            )
+        };
+
+        self.nv
+            .ioctl2(
+                self.fd,
+                NVGPU_IOCTL_CHANNEL_KICKOFF_PB,
+                ioctl_args(&mut args),
+                entries,
+            )
+            .map_err(SubmitError::Ioctl)?;
+
+        self.len = 0;
+        self.wait_fence = None;
+        self.last_fence = Some(args.fence);
+        Ok(Some(args.fence))
+    }
+
+    /// Submits the queued entries, and waits up to `timeout_us` microseconds (`-1` for no
+    /// timeout) for all the channel work to complete.
+    pub fn wait_idle(&mut self, timeout_us: i32) -> Result<(), SubmitError> {
+        self.flush()?;
+        match self.last_fence {
+            Some(fence) => self
+                .fences
+                .wait(self.nv, fence, timeout_us)
+                .map_err(SubmitError::Wait),
+            None => Ok(()),
+        }
+    }
+}
+
+/// Error returned by [`NvChannel`] submissions.
+#[derive(Debug, thiserror::Error)]
+pub enum SubmitError {
+    /// The submission ioctl failed; the queued entries are kept.
+    #[error("GPFIFO submission failed")]
+    Ioctl(#[source] Ioctl2Error),
+    /// Waiting for the submitted work failed.
+    #[error("failed to wait for the submitted work")]
+    Wait(#[source] FenceWaitError),
+}
@@ -3,10 +3,10 @@
 //! This module implements NV commands using the CMIF (Common Message Interface
 //! Format) protocol, which is the standard IPC protocol on Horizon OS.
 
-use core::ptr;
+use core::{mem::size_of, ptr};
 
 use nx_service_applet::aruid::Aruid;
-use nx_sf::{cmif, hipc::BufferMode};
+use nx_sf::{Pod, cmif, hipc::BufferMode};
 use nx_svc::{
     ipc::{self, Handle as SessionHandle},
     mem::tmem::Handle as TmemHandle,
@@ -20,6 +20,48 @@ use crate::{
     types::{CloseNvError, IoctlNvError, OpenNvError, QueryEventNvError},
 };
 
+/// Request layouts of [`ioctl`], indexed by `[has input][has output]`.
+static IOCTL_LAYOUTS: [[cmif::RequestLayout; 2]; 2] = ioctl_layouts(nv_cmds::IOCTL, 0, 0);
+
+/// Request layouts of [`ioctl2`], indexed by `[has input][has output]`.
+///
+/// The extra input buffer is always present.
+static IOCTL2_LAYOUTS: [[cmif::RequestLayout; 2]; 2] = ioctl_layouts(nv_cmds::IOCTL2, 1, 0);
+
+/// Request layouts of [`ioctl3`], indexed by `[has input][has output]`.
+///
+/// The extra output buffer is always present.
+static IOCTL3_LAYOUTS: [[cmif::RequestLayout; 2]; 2] = ioctl_layouts(nv_cmds::IOCTL3, 0, 1);
+
+/// Computes the layouts of an ioctl command for every combination of `argp`
+/// directions, on top of `extra_in`/`extra_out` auto buffers.
+const fn ioctl_layouts(
+    request_id: u32,
+    extra_in: u32,
+    extra_out: u32,
+) -> [[cmif::RequestLayout; 2]; 2] {
+    const fn layout(request_id: u32, num_in_auto: u32, num_out_auto: u32) -> cmif::RequestLayout {
+        cmif::RequestLayout::new(
+            cmif::RequestFormatBuilder::new(request_id)
+                .data_size(8) // fd + request
+                .in_auto_buffers(num_in_auto)
+                .out_auto_buffers(num_out_auto)
+                .build(),
+        )
+    }
+
+    [
+        [
+            layout(request_id, extra_in, extra_out),
+            layout(request_id, extra_in, extra_out + 1),
+        ],
+        [
+            layout(request_id, extra_in + 1, extra_out),
+            layout(request_id, extra_in + 1, extra_out + 1),
+        ],
+    ]
+}
+
 /// Opens a device by path.
 ///
 /// This is INvDrvServices command 0.
@@ -38,18 +80,22 @@ pub fn open(session: SessionHandle, device_path: &[u8]) -> Result<Fd, OpenError>
 
     ipc::send_sync_request(session).map_err(OpenError::SendRequest)?;
 
-    // SAFETY: Response is in TLS buffer after successful send.
-    let resp =
-        unsafe { cmif::parse_response(ipc_buf, false, 0) }.map_err(OpenError::ParseResponse)?;
-
     // Response contains: fd (u32), error (u32)
+    #[derive(Clone, Copy)]
     #[repr(C)]
     struct Output {
         fd: u32,
         error: u32,
     }
 
-    let output = unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<Output>()) };
+    // SAFETY: Two `u32` fields without padding.
+    unsafe impl Pod for Output {}
+
+    // SAFETY: Response is in TLS buffer after successful send.
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<Output>()) }
+        .map_err(OpenError::ParseResponse)?;
+
+    let output = resp.payload::<Output>();
 
     if output.error != 0 {
         return Err(OpenError::NvError(OpenNvError::from_raw(output.error)));
@@ -72,17 +118,10 @@ pub fn ioctl(
 ) -> Result<(), IoctlError> {
     let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
 
-    let num_in_auto = if in_size > 0 { 1 } else { 0 };
-    let num_out_auto = if out_size > 0 { 1 } else { 0 };
-
-    let fmt = cmif::RequestFormatBuilder::new(nv_cmds::IOCTL)
-        .data_size(8) // fd + request
-        .in_auto_buffers(num_in_auto)
-        .out_auto_buffers(num_out_auto)
-        .build();
+    let layout = &IOCTL_LAYOUTS[(in_size > 0) as usize][(out_size > 0) as usize];
 
     // SAFETY: ipc_buf points to valid TLS IPC buffer.
-    let mut req = unsafe { cmif::make_request(ipc_buf, fmt) };
+    let mut req = unsafe { cmif::make_request_with_layout(ipc_buf, layout, None) };
 
     // Write fd and request
     #[repr(C)]
@@ -110,11 +149,11 @@ pub fn ioctl(
     ipc::send_sync_request(session).map_err(IoctlError::SendRequest)?;
 
     // SAFETY: Response is in TLS buffer after successful send.
-    let resp =
-        unsafe { cmif::parse_response(ipc_buf, false, 0) }.map_err(IoctlError::ParseResponse)?;
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<u32>()) }
+        .map_err(IoctlError::ParseResponse)?;
 
     // Response contains error code
-    let error = unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<u32>()) };
+    let error = resp.payload::<u32>();
 
     if error != 0 {
         return Err(IoctlError::NvError(IoctlNvError::from_raw(error)));
@@ -140,17 +179,10 @@ pub fn ioctl2(
     let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
 
     // Auto buffers: argp in (if dir & write), inbuf, argp out (if dir & read)
-    let num_in_auto = if in_size > 0 { 1 } else { 0 } + 1; // +1 for extra_in
-    let num_out_auto = if out_size > 0 { 1 } else { 0 };
-
-    let fmt = cmif::RequestFormatBuilder::new(nv_cmds::IOCTL2)
-        .data_size(8) // fd + request
-        .in_auto_buffers(num_in_auto)
-        .out_auto_buffers(num_out_auto)
-        .build();
+    let layout = &IOCTL2_LAYOUTS[(in_size > 0) as usize][(out_size > 0) as usize];
 
     // SAFETY: ipc_buf points to valid TLS IPC buffer.
-    let mut req = unsafe { cmif::make_request(ipc_buf, fmt) };
+    let mut req = unsafe { cmif::make_request_with_layout(ipc_buf, layout, None) };
 
     // Write fd and request
     #[repr(C)]
@@ -179,10 +211,10 @@ pub fn ioctl2(
     ipc::send_sync_request(session).map_err(Ioctl2Error::SendRequest)?;
 
     // SAFETY: Response is in TLS buffer after successful send.
-    let resp =
-        unsafe { cmif::parse_response(ipc_buf, false, 0) }.map_err(Ioctl2Error::ParseResponse)?;
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<u32>()) }
+        .map_err(Ioctl2Error::ParseResponse)?;
 
-    let error = unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<u32>()) };
+    let error = resp.payload::<u32>();
 
     if error != 0 {
         return Err(Ioctl2Error::NvError(IoctlNvError::from_raw(error)));
@@ -207,17 +239,10 @@ pub fn ioctl3(
 ) -> Result<(), Ioctl3Error> {
     let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
 
-    let num_in_auto = if in_size > 0 { 1 } else { 0 };
-    let num_out_auto = if out_size > 0 { 1 } else { 0 } + 1; // +1 for extra_out
-
-    let fmt = cmif::RequestFormatBuilder::new(nv_cmds::IOCTL3)
-        .data_size(8) // fd + request
-        .in_auto_buffers(num_in_auto)
-        .out_auto_buffers(num_out_auto)
-        .build();
+    let layout = &IOCTL3_LAYOUTS[(in_size > 0) as usize][(out_size > 0) as usize];
 
     // SAFETY: ipc_buf points to valid TLS IPC buffer.
-    let mut req = unsafe { cmif::make_request(ipc_buf, fmt) };
+    let mut req = unsafe { cmif::make_request_with_layout(ipc_buf, layout, None) };
 
     // Write fd and request
     #[repr(C)]
@@ -246,10 +271,10 @@ pub fn ioctl3(
     ipc::send_sync_request(session).map_err(Ioctl3Error::SendRequest)?;
 
     // SAFETY: Response is in TLS buffer after successful send.
-    let resp =
-        unsafe { cmif::parse_response(ipc_buf, false, 0) }.map_err(Ioctl3Error::ParseResponse)?;
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<u32>()) }
+        .map_err(Ioctl3Error::ParseResponse)?;
 
-    let error = unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<u32>()) };
+    let error = resp.payload::<u32>();
 
     if error != 0 {
         return Err(Ioctl3Error::NvError(IoctlNvError::from_raw(error)));
@@ -279,10 +304,10 @@ pub fn close(session: SessionHandle, fd: Fd) -> Result<(), CloseError> {
     ipc::send_sync_request(session).map_err(CloseError::SendRequest)?;
 
     // SAFETY: Response is in TLS buffer after successful send.
-    let resp =
-        unsafe { cmif::parse_response(ipc_buf, false, 0) }.map_err(CloseError::ParseResponse)?;
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<u32>()) }
+        .map_err(CloseError::ParseResponse)?;
 
-    let error = unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<u32>()) };
+    let error = resp.payload::<u32>();
 
     if error != 0 {
         return Err(CloseError::NvError(CloseNvError::from_raw(error)));
@@ -363,11 +388,11 @@ pub fn query_event(
     ipc::send_sync_request(session).map_err(QueryEventError::SendRequest)?;
 
     // SAFETY: Response is in TLS buffer after successful send.
-    let resp = unsafe { cmif::parse_response(ipc_buf, false, 0) }
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<u32>()) }
         .map_err(QueryEventError::ParseResponse)?;
 
     // Response contains error code, and a copy handle for the event
-    let error = unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<u32>()) };
+    let error = resp.payload::<u32>();
 
     if error != 0 {
         return Err(QueryEventError::NvError(QueryEventNvError::from_raw(error)));
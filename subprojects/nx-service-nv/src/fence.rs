@@ -0,0 +1,158 @@
+//! Syncpoint fences and their completion tracking.
+//!
+//! GPU work completion is signaled by host1x syncpoints: a fence is a syncpoint ID plus
+//! the threshold value it reaches once the work is done. Syncpoints only move forward, so
+//! once a fence is known to be reached, every fence of the same syncpoint at or below its
+//! value is too. [`FenceTracker`] records the highest value seen per syncpoint, letting
+//! waits on completed fences return without an ioctl.
+
+use core::sync::atomic::{AtomicU64, Ordering};
+
+use nx_sf::Pod;
+
+use crate::{IoctlError, IoctlNvError, NvService, OpenError, fd::Fd, types::ioctl_args};
+
+/// Path of the host1x control device.
+pub const NVHOST_CTRL_PATH: &str = "/dev/nvhost-ctrl";
+
+/// Number of host1x syncpoints.
+pub const MAX_SYNCPTS: usize = 192;
+
+/// `NVHOST_IOCTL_CTRL_EVENT_WAIT`: waits for a syncpoint to reach a threshold.
+const NVHOST_IOCTL_CTRL_EVENT_WAIT: u32 = 0xC010_001D;
+
+/// Flag of a [`FenceTracker`] entry holding a known syncpoint value.
+const KNOWN: u64 = 1 << 32;
+
+/// A syncpoint fence, as returned by GPU work submissions.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+#[repr(C)]
+pub struct NvFence {
+    /// Syncpoint ID.
+    pub id: u32,
+    /// Syncpoint value reached once the fenced work completes.
+    pub value: u32,
+}
+
+// SAFETY: Two `u32` fields without padding.
+unsafe impl Pod for NvFence {}
+
+/// Returns `true` if a syncpoint at `current` has reached `threshold`.
+///
+/// Syncpoint values wrap around, so they are compared within half the value range.
+#[inline]
+pub const fn syncpt_reached(current: u32, threshold: u32) -> bool {
+    current.wrapping_sub(threshold) as i32 >= 0
+}
+
+/// Highest known value of every syncpoint, shared by the channels submitting GPU work.
+pub struct FenceTracker {
+    ctrl_fd: Fd,
+    /// Per syncpoint, its last known value with the [`KNOWN`] flag, or zero.
+    completed: [AtomicU64; MAX_SYNCPTS],
+}
+
+impl FenceTracker {
+    /// Creates a tracker waiting on syncpoints through the `nvhost-ctrl` device `ctrl_fd`.
+    pub const fn new(ctrl_fd: Fd) -> Self {
+        Self {
+            ctrl_fd,
+            completed: [const { AtomicU64::new(0) }; MAX_SYNCPTS],
+        }
+    }
+
+    /// Opens the `nvhost-ctrl` device, and creates a tracker waiting on it.
+    pub fn open(nv: &NvService) -> Result<Self, OpenError> {
+        nv.open(NVHOST_CTRL_PATH).map(Self::new)
+    }
+
+    /// Returns the `nvhost-ctrl` device file descriptor.
+    #[inline]
+    pub fn ctrl_fd(&self) -> Fd {
+        self.ctrl_fd
+    }
+
+    /// Returns `true` if `fence` is known to be signaled, without any ioctl.
+    ///
+    /// A `false` result only means completion was not observed yet.
+    pub fn is_signaled(&self, fence: NvFence) -> bool {
+        let Some(entry) = self.completed.get(fence.id as usize) else {
+            return false;
+        };
+
+        let known = entry.load(Ordering::Acquire);
+        known & KNOWN != 0 && syncpt_reached(known as u32, fence.value)
+    }
+
+    /// Records that the syncpoint of `fence` reached its value.
+    pub fn signal(&self, fence: NvFence) {
+        let Some(entry) = self.completed.get(fence.id as usize) else {
+            return;
+        };
+
+        let _ = entry.fetch_update(Ordering::Release, Ordering::Relaxed, |known| {
+            if known & KNOWN != 0 && syncpt_reached(known as u32, fence.value) {
+                None
+            } else {
+                Some(KNOWN | fence.value as u64)
+            }
+        });
+    }
+
+    /// Waits up to `timeout_us` microseconds (`-1` for no timeout) for `fence` to signal.
+    ///
+    /// Fences already known to be signaled return immediately, without an ioctl.
+    pub fn wait(
+        &self,
+        nv: &NvService,
+        fence: NvFence,
+        timeout_us: i32,
+    ) -> Result<(), FenceWaitError> {
+        if self.is_signaled(fence) {
+            return Ok(());
+        }
+
+        #[derive(Clone, Copy)]
+        #[repr(C)]
+        struct Args {
+            syncpt_id: u32,
+            threshold: u32,
+            timeout: i32,
+            value: u32,
+        }
+
+        // SAFETY: Four 32-bit fields without padding.
+        unsafe impl Pod for Args {}
+
+        let mut args = Args {
+            syncpt_id: fence.id,
+            threshold: fence.value,
+            timeout: timeout_us,
+            value: 0,
+        };
+
+        match nv.ioctl(
+            self.ctrl_fd,
+            NVHOST_IOCTL_CTRL_EVENT_WAIT,
+            ioctl_args(&mut args),
+        ) {
+            Ok(()) => {
+                self.signal(fence);
+                Ok(())
+            }
+            Err(IoctlError::NvError(IoctlNvError::Timeout)) => Err(FenceWaitError::TimedOut),
+            Err(err) => Err(FenceWaitError::Ioctl(err)),
+        }
+    }
+}
+
+/// Error returned by [`FenceTracker::wait`].
+#[derive(Debug, thiserror::Error)]
+pub enum FenceWaitError {
+    /// The fence was not signaled before the timeout.
+    #[error("fence wait timed out")]
+    TimedOut,
+    /// The wait ioctl failed.
+    #[error("fence wait ioctl failed")]
+    Ioctl(#[source] IoctlError),
+}
@@ -0,0 +1,394 @@
+//! GPU memory suballocation.
+//!
+//! Creating a GPU buffer takes an nvmap create, an nvmap alloc and an address space map
+//! ioctl, and as many again to release it. A [`GpuHeap`] pays for them once for a large
+//! block, mapped into GPU address space once, and hands out its aligned sub-ranges with a
+//! buddy allocator. A [`GpuAllocator`] grows a set of heaps on demand.
+
+use alloc::{
+    alloc::{Layout, alloc_zeroed, dealloc},
+    vec::Vec,
+};
+use core::ptr::NonNull;
+
+use nx_svc::{
+    mem::{self as svc_mem, SetMemoryAttributeError},
+    raw::MemoryAttribute,
+};
+
+use crate::{
+    IoctlError, NvService,
+    address_space::{self, BIG_PAGE_SIZE, MAP_BUFFER_FLAG_CACHEABLE},
+    fd::Fd,
+    nvmap::{self, NVMAP_ALLOC_FLAG_CACHEABLE, NvMapHandle},
+};
+
+mod buddy;
+
+use buddy::Buddy;
+
+/// Log2 of the smallest sub-range size, matching the GPU constant buffer alignment.
+const MIN_BLOCK_SHIFT: u32 = 8;
+
+/// NV memory kind of the heaps: pitch-linear, generic memory.
+const KIND_PITCH: u8 = 0;
+
+/// A heap of GPU memory: one nvmap handle, mapped once into a GPU address space.
+pub struct GpuHeap<'a> {
+    nv: &'a NvService,
+    nvmap_fd: Fd,
+    as_fd: Fd,
+    handle: NvMapHandle,
+    cpu_addr: NonNull<u8>,
+    gpu_va: u64,
+    layout: Layout,
+    cacheable: bool,
+    buddy: Buddy,
+}
+
+// SAFETY: The heap owns its backing memory, and the ioctls are valid from any thread.
+unsafe impl Send for GpuHeap<'_> {}
+
+impl<'a> GpuHeap<'a> {
+    /// Creates a heap of at least `size` bytes, rounded up to a power of two of at least
+    /// one GPU big page, and maps it into the GPU address space `as_fd`.
+    ///
+    /// `cacheable` makes the memory cacheable by both the CPU and the GPU. Otherwise the
+    /// memory is flushed from the data cache and made uncached for the CPU too, as libnx's
+    /// `nvMapCreate` does.
+    pub fn new(
+        nv: &'a NvService,
+        nvmap_fd: Fd,
+        as_fd: Fd,
+        size: usize,
+        cacheable: bool,
+    ) -> Result<Self, HeapError> {
+        let size = size
+            .max(BIG_PAGE_SIZE as usize)
+            .checked_next_power_of_two()
+            .filter(|size| *size <= u32::MAX as usize)
+            .ok_or(HeapError::InvalidSize)?;
+        let layout = Layout::from_size_align(size, BIG_PAGE_SIZE as usize)
+            .map_err(|_| HeapError::InvalidSize)?;
+
+        // SAFETY: The layout has a non-zero size.
+        let cpu_addr =
+            NonNull::new(unsafe { alloc_zeroed(layout) }).ok_or(HeapError::OutOfMemory)?;
+        if !cacheable {
+            // SAFETY: The memory was allocated above with this layout, and is unused.
+            let res = unsafe { set_uncached(cpu_addr, size, true) };
+            if let Err(err) = res {
+                // SAFETY: The memory was allocated above with this layout, and is unused.
+                unsafe { dealloc(cpu_addr.as_ptr(), layout) };
+                return Err(HeapError::SetAttribute(err));
+            }
+        }
+        let release = || {
+            // Memory left uncached must not go back to the allocator: leak it instead
+            // SAFETY: The memory was allocated above with this layout, and is unused.
+            if cacheable || unsafe { set_uncached(cpu_addr, size, false) }.is_ok() {
+                // SAFETY: The memory was allocated above with this layout, and is unused.
+                unsafe { dealloc(cpu_addr.as_ptr(), layout) };
+            }
+        };
+
+        let handle = match nvmap::create(nv, nvmap_fd, size as u32) {
+            Ok(handle) => handle,
+            Err(err) => {
+                release();
+                return Err(HeapError::Create(err));
+            }
+        };
+
+        let alloc_flags = if cacheable {
+            NVMAP_ALLOC_FLAG_CACHEABLE
+        } else {
+            0
+        };
+        // SAFETY: The memory is big page aligned, of the handle size, and owned by the heap.
+        let res = unsafe {
+            nvmap::alloc(
+                nv,
+                nvmap_fd,
+                handle,
+                alloc_flags,
+                BIG_PAGE_SIZE,
+                KIND_PITCH,
+                cpu_addr.as_ptr(),
+            )
+        };
+        if let Err(err) = res {
+            let _ = nvmap::free(nv, nvmap_fd, handle);
+            release();
+            return Err(HeapError::Alloc(err));
+        }
+
+        let map_flags = if cacheable {
+            MAP_BUFFER_FLAG_CACHEABLE
+        } else {
+            0
+        };
+        let gpu_va = match address_space::map_buffer(
+            nv,
+            as_fd,
+            handle,
+            map_flags,
+            KIND_PITCH as u32,
+            BIG_PAGE_SIZE,
+        ) {
+            Ok(gpu_va) => gpu_va,
+            Err(err) => {
+                let _ = nvmap::free(nv, nvmap_fd, handle);
+                release();
+                return Err(HeapError::Map(err));
+            }
+        };
+
+        Ok(Self {
+            nv,
+            nvmap_fd,
+            as_fd,
+            handle,
+            cpu_addr,
+            gpu_va,
+            layout,
+            cacheable,
+            buddy: Buddy::new(size.trailing_zeros(), MIN_BLOCK_SHIFT),
+        })
+    }
+
+    /// Returns the heap size.
+    #[inline]
+    pub fn size(&self) -> usize {
+        self.layout.size()
+    }
+
+    /// Returns the number of bytes not handed out.
+    #[inline]
+    pub fn free_bytes(&self) -> usize {
+        self.buddy.free_bytes()
+    }
+
+    /// Returns the nvmap handle backing the heap.
+    #[inline]
+    pub fn handle(&self) -> NvMapHandle {
+        self.handle
+    }
+
+    /// Hands out a sub-range of at least `size` bytes, aligned to `align` in both CPU and
+    /// GPU address spaces.
+    ///
+    /// Returns `None` if the heap has no free block large enough. `align` must be a power
+    /// of two no larger than a GPU big page.
+    pub fn alloc(&mut self, size: usize, align: usize) -> Option<GpuBuffer> {
+        debug_assert!(align.is_power_of_two() && align <= BIG_PAGE_SIZE as usize);
+
+        let order = self.buddy.order_for(size, align)?;
+        let offset = self.buddy.alloc(order)?;
+        Some(GpuBuffer {
+            // SAFETY: The offset lies within the heap memory.
+            cpu_addr: unsafe { self.cpu_addr.add(offset) },
+            gpu_va: self.gpu_va + offset as u64,
+            size: self.buddy.block_size(order),
+            heap: 0,
+            order,
+        })
+    }
+
+    /// Returns `buffer` to the heap.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `buffer` was not handed out by this heap, or was already returned.
+    pub fn free(&mut self, buffer: GpuBuffer) {
+        let offset = buffer.gpu_va.wrapping_sub(self.gpu_va) as usize;
+        assert!(
+            offset < self.size()
+                && buffer.cpu_addr.addr().get() == self.cpu_addr.addr().get() + offset,
+            "GPU buffer does not belong to this heap"
+        );
+        self.buddy.free(offset, buffer.order);
+    }
+
+    /// Unmaps the heap from GPU address space and releases its memory.
+    ///
+    /// The GPU must be done with every buffer of the heap. If the nvmap handle cannot be
+    /// released, the backing memory is leaked rather than handed back while the driver
+    /// may still use it. Uncached memory is made cached again first, and leaked as well if
+    /// that fails.
+    pub fn close(self) -> Result<(), IoctlError> {
+        let unmapped = address_space::unmap_buffer(self.nv, self.as_fd, self.gpu_va);
+        nvmap::free(self.nv, self.nvmap_fd, self.handle)?;
+
+        // SAFETY: The driver no longer references the memory, owned by the heap.
+        if !self.cacheable && unsafe { set_uncached(self.cpu_addr, self.size(), false) }.is_err() {
+            return unmapped;
+        }
+
+        // SAFETY: The driver no longer references the memory allocated with this layout.
+        unsafe { dealloc(self.cpu_addr.as_ptr(), self.layout) };
+        unmapped
+    }
+}
+
+/// Makes the CPU mapping of `[addr, addr + size)` uncached, or cached again.
+///
+/// The range is flushed from the data cache before being made uncached, so that no dirty
+/// line is written back over what the GPU writes later.
+///
+/// # Safety
+///
+/// The range must be page aligned and owned by the caller.
+unsafe fn set_uncached(
+    addr: NonNull<u8>,
+    size: usize,
+    uncached: bool,
+) -> Result<(), SetMemoryAttributeError> {
+    let attr = if uncached {
+        // SAFETY: The caller guarantees the range is mapped.
+        unsafe { nx_cpu::cache::clean_invalidate_range(addr.as_ptr(), size) };
+        MemoryAttribute::IS_UNCACHED
+    } else {
+        MemoryAttribute::empty()
+    };
+    // SAFETY: The caller guarantees the range is owned, and it was flushed above.
+    unsafe { svc_mem::set_memory_attribute(addr.cast(), size, MemoryAttribute::IS_UNCACHED, attr) }
+}
+
+/// A sub-range of GPU memory handed out by a [`GpuHeap`] or a [`GpuAllocator`].
+#[derive(Debug)]
+pub struct GpuBuffer {
+    cpu_addr: NonNull<u8>,
+    gpu_va: u64,
+    size: usize,
+    /// Index of the heap in its [`GpuAllocator`].
+    heap: usize,
+    order: u32,
+}
+
+// SAFETY: The buffer is a plain memory range, owned by its holder.
+unsafe impl Send for GpuBuffer {}
+
+impl GpuBuffer {
+    /// Returns the CPU address of the buffer.
+    #[inline]
+    pub fn cpu_addr(&self) -> NonNull<u8> {
+        self.cpu_addr
+    }
+
+    /// Returns the GPU virtual address of the buffer.
+    #[inline]
+    pub fn gpu_va(&self) -> u64 {
+        self.gpu_va
+    }
+
+    /// Returns the buffer size, the requested size rounded up to a power of two.
+    #[inline]
+    pub fn size(&self) -> usize {
+        self.size
+    }
+}
+
+/// A GPU memory allocator growing a set of [`GpuHeap`]s on demand.
+pub struct GpuAllocator<'a> {
+    nv: &'a NvService,
+    nvmap_fd: Fd,
+    as_fd: Fd,
+    heap_size: usize,
+    cacheable: bool,
+    heaps: Vec<GpuHeap<'a>>,
+}
+
+impl<'a> GpuAllocator<'a> {
+    /// Creates an allocator creating heaps of `heap_size` bytes, or larger for buffers
+    /// not fitting in one.
+    ///
+    /// No heap is created until the first allocation.
+    pub fn new(
+        nv: &'a NvService,
+        nvmap_fd: Fd,
+        as_fd: Fd,
+        heap_size: usize,
+        cacheable: bool,
+    ) -> Self {
+        Self {
+            nv,
+            nvmap_fd,
+            as_fd,
+            heap_size,
+            cacheable,
+            heaps: Vec::new(),
+        }
+    }
+
+    /// Allocates at least `size` bytes aligned to `align`, creating a heap if none of the
+    /// existing ones has room.
+    ///
+    /// `align` must be a power of two no larger than a GPU big page.
+    pub fn alloc(&mut self, size: usize, align: usize) -> Result<GpuBuffer, HeapError> {
+        for (index, heap) in self.heaps.iter_mut().enumerate() {
+            if let Some(buffer) = heap.alloc(size, align) {
+                return Ok(GpuBuffer {
+                    heap: index,
+                    ..buffer
+                });
+            }
+        }
+
+        let mut heap = GpuHeap::new(
+            self.nv,
+            self.nvmap_fd,
+            self.as_fd,
+            self.heap_size.max(size),
+            self.cacheable,
+        )?;
+        let buffer = heap.alloc(size, align).ok_or(HeapError::InvalidSize)?;
+        self.heaps.push(heap);
+        Ok(GpuBuffer {
+            heap: self.heaps.len() - 1,
+            ..buffer
+        })
+    }
+
+    /// Returns `buffer` to its heap.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `buffer` was not allocated by this allocator, or was already freed.
+    pub fn free(&mut self, buffer: GpuBuffer) {
+        self.heaps[buffer.heap].free(buffer);
+    }
+
+    /// Closes every heap; see [`GpuHeap::close`].
+    ///
+    /// Returns the first error, after attempting to close every heap.
+    pub fn close(self) -> Result<(), IoctlError> {
+        self.heaps
+            .into_iter()
+            .map(GpuHeap::close)
+            .fold(Ok(()), |res, closed| res.and(closed))
+    }
+}
+
+/// Error returned when creating a [`GpuHeap`].
+#[derive(Debug, thiserror::Error)]
+pub enum HeapError {
+    /// The heap or buffer size is zero or too large.
+    #[error("invalid GPU heap size")]
+    InvalidSize,
+    /// The heap backing memory could not be allocated.
+    #[error("out of memory for the GPU heap")]
+    OutOfMemory,
+    /// Creating the nvmap handle failed.
+    #[error("failed to create the nvmap handle")]
+    Create(#[source] IoctlError),
+    /// Backing the nvmap handle with memory failed.
+    #[error("failed to allocate the nvmap handle")]
+    Alloc(#[source] IoctlError),
+    /// Mapping the heap into GPU address space failed.
+    #[error("failed to map the GPU heap")]
+    Map(#[source] IoctlError),
+    /// Making the heap memory uncached failed.
+    #[error("failed to make the GPU heap uncached")]
+    SetAttribute(#[source] SetMemoryAttributeError),
+}
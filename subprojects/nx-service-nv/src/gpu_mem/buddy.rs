@@ -0,0 +1,124 @@
+//! Binary buddy allocator over the offsets of a heap.
+
+use alloc::{vec, vec::Vec};
+
+/// Buddy allocator handing out power-of-two blocks of a `1 << size_shift` bytes range.
+///
+/// Free blocks are tracked by one bitmap per order, order `0` being the smallest block, and
+/// the blocks handed out by as many again. Blocks are aligned to their size, relative to
+/// the start of the range.
+pub(super) struct Buddy {
+    /// Log2 of the smallest block size.
+    min_shift: u32,
+    /// Order of the block spanning the whole range.
+    max_order: u32,
+    /// Per order, bitmap of its free blocks.
+    free: Vec<Vec<u64>>,
+    /// Per order, bitmap of its blocks handed out.
+    allocated: Vec<Vec<u64>>,
+    free_bytes: usize,
+}
+
+impl Buddy {
+    /// Creates an allocator with a single free block spanning `1 << size_shift` bytes.
+    pub(super) fn new(size_shift: u32, min_shift: u32) -> Self {
+        let max_order = size_shift - min_shift;
+        let bitmaps = || -> Vec<Vec<u64>> {
+            (0..=max_order)
+                .map(|order| vec![0; (1usize << (max_order - order)).div_ceil(64)])
+                .collect()
+        };
+        let mut free = bitmaps();
+        free[max_order as usize][0] = 1;
+
+        Self {
+            min_shift,
+            max_order,
+            free,
+            allocated: bitmaps(),
+            free_bytes: 1 << size_shift,
+        }
+    }
+
+    /// Returns the number of free bytes.
+    pub(super) fn free_bytes(&self) -> usize {
+        self.free_bytes
+    }
+
+    /// Returns the order of the smallest block holding `size` bytes aligned to `align`,
+    /// or `None` if it exceeds the whole range.
+    pub(super) fn order_for(&self, size: usize, align: usize) -> Option<u32> {
+        let needed = size.max(align).max(1).checked_next_power_of_two()?;
+        let order = needed.trailing_zeros().saturating_sub(self.min_shift);
+        (order <= self.max_order).then_some(order)
+    }
+
+    /// Returns the size of a block of `order`.
+    pub(super) fn block_size(&self, order: u32) -> usize {
+        1 << (self.min_shift + order)
+    }
+
+    /// Allocates a block of `order`, returning its offset.
+    pub(super) fn alloc(&mut self, order: u32) -> Option<usize> {
+        // Take the first free block of the smallest large enough order
+        let (mut level, mut block) = (order..=self.max_order)
+            .find_map(|level| self.first_free(level).map(|block| (level, block)))?;
+        clear(&mut self.free, level, block);
+
+        // Split it down, freeing the upper halves
+        while level > order {
+            level -= 1;
+            block *= 2;
+            set(&mut self.free, level, block + 1);
+        }
+
+        set(&mut self.allocated, order, block);
+        self.free_bytes -= self.block_size(order);
+        Some(block << (self.min_shift + order))
+    }
+
+    /// Frees the block of `order` at `offset`, merging it with its free buddies.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the block is not handed out, as when it is freed twice.
+    pub(super) fn free(&mut self, offset: usize, order: u32) {
+        let mut block = offset >> (self.min_shift + order);
+        assert!(
+            order <= self.max_order
+                && offset % self.block_size(order) == 0
+                && is_set(&self.allocated, order, block),
+            "GPU buffer is not allocated"
+        );
+        clear(&mut self.allocated, order, block);
+        self.free_bytes += self.block_size(order);
+
+        let mut level = order;
+        while level < self.max_order && is_set(&self.free, level, block ^ 1) {
+            clear(&mut self.free, level, block ^ 1);
+            level += 1;
+            block /= 2;
+        }
+        set(&mut self.free, level, block);
+    }
+
+    fn first_free(&self, level: u32) -> Option<usize> {
+        self.free[level as usize]
+            .iter()
+            .enumerate()
+            .find(|(_, word)| **word != 0)
+            .map(|(index, word)| index * 64 + word.trailing_zeros() as usize)
+    }
+}
+
+fn is_set(bitmaps: &[Vec<u64>], level: u32, block: usize) -> bool {
+    bitmaps[level as usize][block / 64] & (1 << (block % 64)) != 0
+}
+
+fn set(bitmaps: &mut [Vec<u64>], level: u32, block: usize) {
+    bitmaps[level as usize][block / 64] |= 1 << (block % 64);
+}
+
+fn clear(bitmaps: &mut [Vec<u64>], level: u32, block: usize) {
+    bitmaps[level as usize][block / 64] &= !(1 << (block % 64));
+}
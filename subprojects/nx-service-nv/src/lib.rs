@@ -4,12 +4,16 @@
 //! - Device management (open/close)
 //! - Ioctl operations for GPU communication
 //! - Event queries for synchronization
+//! - Batched GPU command submission with fence tracking
+//! - GPU memory suballocation over large nvmap handles
 //!
 //! The NV service is the foundation for GPU operations on the Nintendo Switch,
 //! providing low-level access to NVIDIA hardware through a standardized interface.
 
 #![no_std]
 
+extern crate alloc;
+extern crate nx_alloc; // Provides #[global_allocator]
 extern crate nx_panic_handler; // Provide #![panic_handler]
 
 use nx_service_applet::{AppletType, aruid::Aruid};
@@ -23,8 +27,13 @@ use nx_svc::{
 };
 use nx_sys_mem::tmem::{self, TransferMemoryBacking};
 
+pub mod address_space;
+pub mod channel;
 mod cmif;
 pub mod fd;
+pub mod fence;
+pub mod gpu_mem;
+pub mod nvmap;
 mod proto;
 pub mod types;
 
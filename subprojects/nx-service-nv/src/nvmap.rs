@@ -0,0 +1,127 @@
+//! `/dev/nvmap` memory handle ioctls.
+//!
+//! nvmap handles wrap CPU memory so that GPU engines can access it. A handle is created
+//! with a size, backed with memory by [`alloc`], and then mapped into a GPU address space
+//! (see [`address_space`](crate::address_space)).
+
+use nx_sf::Pod;
+
+use crate::{IoctlError, NvService, fd::Fd, types::ioctl_args};
+
+/// Path of the nvmap device.
+pub const NVMAP_PATH: &str = "/dev/nvmap";
+
+/// `NVMAP_IOC_CREATE`: creates a handle of a given size.
+const NVMAP_IOC_CREATE: u32 = 0xC008_0101;
+
+/// `NVMAP_IOC_ALLOC`: backs a handle with CPU memory.
+const NVMAP_IOC_ALLOC: u32 = 0xC020_0104;
+
+/// `NVMAP_IOC_FREE`: releases a handle.
+const NVMAP_IOC_FREE: u32 = 0xC018_0105;
+
+/// Allocation flag making the memory cacheable by the CPU.
+pub const NVMAP_ALLOC_FLAG_CACHEABLE: u32 = 1 << 0;
+
+/// An nvmap memory handle.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+#[repr(transparent)]
+pub struct NvMapHandle(u32);
+
+impl NvMapHandle {
+    /// Returns the raw handle value.
+    #[inline]
+    pub const fn to_raw(self) -> u32 {
+        self.0
+    }
+}
+
+/// Creates an nvmap handle of `size` bytes.
+pub fn create(nv: &NvService, nvmap_fd: Fd, size: u32) -> Result<NvMapHandle, IoctlError> {
+    #[derive(Clone, Copy)]
+    #[repr(C)]
+    struct Args {
+        size: u32,
+        handle: u32,
+    }
+
+    // SAFETY: Two `u32` fields without padding.
+    unsafe impl Pod for Args {}
+
+    let mut args = Args { size, handle: 0 };
+    nv.ioctl(nvmap_fd, NVMAP_IOC_CREATE, ioctl_args(&mut args))?;
+    Ok(NvMapHandle(args.handle))
+}
+
+/// Backs `handle` with the CPU memory at `addr`.
+///
+/// `flags` is a combination of the `NVMAP_ALLOC_FLAG_*` constants, and `kind` the NV
+/// memory kind of the allocation.
+///
+/// # Safety
+///
+/// `addr` must point to page-aligned memory of the handle size, which must outlive the
+/// handle and not be used for anything else.
+pub unsafe fn alloc(
+    nv: &NvService,
+    nvmap_fd: Fd,
+    handle: NvMapHandle,
+    flags: u32,
+    align: u32,
+    kind: u8,
+    addr: *mut u8,
+) -> Result<(), IoctlError> {
+    #[derive(Clone, Copy)]
+    #[repr(C)]
+    struct Args {
+        handle: u32,
+        heap_mask: u32,
+        flags: u32,
+        align: u32,
+        kind: u8,
+        _pad: [u8; 7],
+        addr: u64,
+    }
+
+    // SAFETY: Four `u32`, eight `u8` and a `u64` fields without padding.
+    unsafe impl Pod for Args {}
+
+    let mut args = Args {
+        handle: handle.0,
+        heap_mask: 0,
+        flags,
+        align,
+        kind,
+        _pad: [0; 7],
+        addr: addr as u64,
+    };
+    nv.ioctl(nvmap_fd, NVMAP_IOC_ALLOC, ioctl_args(&mut args))
+}
+
+/// Releases `handle`.
+///
+/// The backing memory can be reused once the handle is no longer mapped by any GPU
+/// address space.
+pub fn free(nv: &NvService, nvmap_fd: Fd, handle: NvMapHandle) -> Result<(), IoctlError> {
+    #[derive(Clone, Copy)]
+    #[repr(C)]
+    struct Args {
+        handle: u32,
+        _pad: u32,
+        addr: u64,
+        size: u32,
+        flags: u32,
+    }
+
+    // SAFETY: Two `u32`, a `u64` and two `u32` fields without padding.
+    unsafe impl Pod for Args {}
+
+    let mut args = Args {
+        handle: handle.0,
+        _pad: 0,
+        addr: 0,
+        size: 0,
+        flags: 0,
+    };
+    nv.ioctl(nvmap_fd, NVMAP_IOC_FREE, ioctl_args(&mut args))
+}
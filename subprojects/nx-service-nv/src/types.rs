@@ -285,3 +285,10 @@ pub enum NvEventId {
 pub const fn nv_event_id_ctrl_syncpt(slot: u32, syncpt: u32) -> u32 {
     (1 << 28) | ((syncpt) << 16) | slot
 }
+
+/// Returns the bytes of an ioctl argument structure, as passed in `argp`.
+#[inline]
+pub(crate) fn ioctl_args<T: nx_sf::Pod>(args: &mut T) -> &mut [u8] {
+    // SAFETY: `Pod` types have no padding and accept every bit pattern.
+    unsafe { core::slice::from_raw_parts_mut((args as *mut T).cast::<u8>(), size_of::<T>()) }
+}
@@ -2,7 +2,7 @@
 
 use core::fmt;
 
-use nx_sf::ServiceName;
+use nx_sf::{Pod, ServiceName};
 use static_assertions::const_assert_eq;
 
 /// Service name for the system settings service.
@@ -56,6 +56,9 @@ pub struct FirmwareVersion {
 
 const_assert_eq!(size_of::<FirmwareVersion>(), 0x100);
 
+// SAFETY: `u8` fields and byte arrays only, with explicit padding.
+unsafe impl Pod for FirmwareVersion {}
+
 impl FirmwareVersion {
     /// Creates a new zeroed `FirmwareVersion`.
     #[inline]
@@ -18,38 +18,22 @@ pub fn get_service_handle(
     session: SessionHandle,
     name: ServiceName,
 ) -> Result<SessionHandle, GetServiceError> {
-    let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
-
-    let fmt = tipc::RequestFormat {
-        request_id: proto::GET_SERVICE_HANDLE,
-        data_size: size_of::<ServiceName>(),
-        num_in_buffers: 0,
-        num_out_buffers: 0,
-        num_inout_buffers: 0,
-        num_handles: 0,
-        send_pid: false,
-    };
-
-    // SAFETY: ipc_buf points to valid TLS IPC buffer.
-    let req = unsafe { tipc::make_request(ipc_buf, fmt) };
-
-    // SAFETY: req.data points to valid payload area with space for ServiceName.
-    unsafe {
-        ptr::write_unaligned(req.data.as_ptr().cast::<ServiceName>().cast_mut(), name);
-    }
-
-    ipc::send_sync_request(session).map_err(GetServiceError::SendRequest)?;
-
-    // SAFETY: Response is in TLS buffer after successful send.
-    let resp =
-        unsafe { tipc::parse_response(ipc_buf, 0) }.map_err(GetServiceError::ParseResponse)?;
-
-    if resp.move_handles.is_empty() {
+    let resp = tipc::dispatch(session, proto::GET_SERVICE_HANDLE)
+        .in_data(&name)
+        .send()
+        .map_err(|err| match err {
+            tipc::DispatchError::SendRequest(err) => GetServiceError::SendRequest(err),
+            tipc::DispatchError::ParseResponse(err) => GetServiceError::ParseResponse(err),
+            // The request carries no descriptors
+            tipc::DispatchError::TooManyDescriptors => unreachable!(),
+        })?;
+
+    let Some(&handle) = resp.move_handles.first() else {
         return Err(GetServiceError::MissingHandle);
-    }
+    };
 
     // SAFETY: Kernel returned a valid handle in the response.
-    Ok(unsafe { SessionHandle::from_raw(resp.move_handles[0]) })
+    Ok(unsafe { SessionHandle::from_raw(handle) })
 }
 
 /// Error returned by [`get_service_handle`].
@@ -3,14 +3,15 @@
 //! This module implements Time commands using the CMIF (Common Message Interface
 //! Format) protocol, which is the standard IPC protocol on Horizon OS.
 
-use core::ptr;
+use core::{mem::size_of, ptr};
 
-use nx_sf::cmif;
+use nx_sf::{cmif, hipc::BufferMode};
 use nx_svc::ipc::{self, Handle as SessionHandle};
 
 use crate::{
     proto::{static_service_cmds, system_clock_cmds, timezone_service_cmds},
-    types::{TimeCalendarAdditionalInfo, TimeCalendarTime},
+    types::{TimeCalendarAdditionalInfo, TimeCalendarTime, TimeLocationName},
+    tz::TimeZoneRule,
 };
 
 /// Gets the standard user system clock (ISystemClock).
@@ -191,6 +192,70 @@ pub fn to_calendar_time_with_my_rule(
     Ok((output.caltime, output.info))
 }
 
+/// Gets the device location name.
+///
+/// This is ITimeZoneService command 0.
+pub fn get_device_location_name(
+    session: SessionHandle,
+) -> Result<TimeLocationName, GetDeviceLocationNameError> {
+    let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+
+    let fmt =
+        cmif::RequestFormatBuilder::new(timezone_service_cmds::GET_DEVICE_LOCATION_NAME).build();
+
+    // SAFETY: ipc_buf points to valid TLS IPC buffer.
+    let _req = unsafe { cmif::make_request(ipc_buf, fmt) };
+
+    ipc::send_sync_request(session).map_err(GetDeviceLocationNameError::SendRequest)?;
+
+    // SAFETY: Response is in TLS buffer after successful send.
+    let resp = unsafe { cmif::parse_response(ipc_buf, false, size_of::<TimeLocationName>()) }
+        .map_err(GetDeviceLocationNameError::ParseResponse)?;
+
+    // SAFETY: resp.data contains the TimeLocationName.
+    Ok(unsafe { ptr::read_unaligned(resp.data.as_ptr().cast::<TimeLocationName>()) })
+}
+
+/// Loads the time zone rule of a location into `rule`.
+///
+/// This is ITimeZoneService command 4.
+pub fn load_time_zone_rule(
+    session: SessionHandle,
+    location: &TimeLocationName,
+    rule: &mut TimeZoneRule,
+) -> Result<(), LoadTimeZoneRuleError> {
+    let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+
+    let fmt = cmif::RequestFormatBuilder::new(timezone_service_cmds::LOAD_TIME_ZONE_RULE)
+        .data_size(size_of::<TimeLocationName>())
+        .out_buffers(1) // Rule (Type B / HipcMapAlias)
+        .build();
+
+    // SAFETY: ipc_buf points to valid TLS IPC buffer.
+    let mut req = unsafe { cmif::make_request(ipc_buf, fmt) };
+
+    // SAFETY: req.data points to valid payload area with space for the location name.
+    unsafe {
+        ptr::write_unaligned(
+            req.data.as_ptr().cast::<TimeLocationName>().cast_mut(),
+            *location,
+        );
+    }
+    req.add_out_buffer(
+        (rule as *mut TimeZoneRule).cast(),
+        size_of::<TimeZoneRule>(),
+        BufferMode::Normal,
+    );
+
+    ipc::send_sync_request(session).map_err(LoadTimeZoneRuleError::SendRequest)?;
+
+    // SAFETY: Response is in TLS buffer after successful send.
+    unsafe { cmif::parse_response(ipc_buf, false, 0) }
+        .map_err(LoadTimeZoneRuleError::ParseResponse)?;
+
+    Ok(())
+}
+
 /// Helper function to get a clock session (used by user and network system clocks).
 fn get_clock_session(
     session: SessionHandle,
@@ -306,3 +371,31 @@ pub enum ToCalendarTimeError {
     #[error("failed to parse response")]
     ParseResponse(#[source] cmif::ParseResponseError),
 }
+
+/// Error returned by [`get_device_location_name`].
+#[derive(Debug, thiserror::Error)]
+pub enum GetDeviceLocationNameError {
+    /// Failed to send the IPC request.
+    #[error("failed to send request")]
+    SendRequest(#[source] ipc::SendSyncError),
+    /// Failed to parse the CMIF response.
+    #[error("failed to parse response")]
+    ParseResponse(#[source] cmif::ParseResponseError),
+}
+
+/// Error returned by [`load_time_zone_rule`].
+#[derive(Debug, thiserror::Error)]
+pub enum LoadTimeZoneRuleError {
+    /// Failed to get the device location name.
+    #[error("failed to get device location name")]
+    GetDeviceLocationName(#[source] GetDeviceLocationNameError),
+    /// The service returned an out of range rule.
+    #[error("invalid time zone rule")]
+    InvalidRule,
+    /// Failed to send the IPC request.
+    #[error("failed to send request")]
+    SendRequest(#[source] ipc::SendSyncError),
+    /// Failed to parse the CMIF response.
+    #[error("failed to parse response")]
+    ParseResponse(#[source] cmif::ParseResponseError),
+}
@@ -24,21 +24,23 @@ mod cmif;
 mod proto;
 pub mod shmem;
 pub mod types;
+pub mod tz;
 
 pub use self::{
     cmif::{
-        GetCurrentTimeError, GetSharedMemoryError, GetSteadyClockError, GetSystemClockError,
-        GetTimeZoneServiceError, ToCalendarTimeError,
+        GetCurrentTimeError, GetDeviceLocationNameError, GetSharedMemoryError, GetSteadyClockError,
+        GetSystemClockError, GetTimeZoneServiceError, LoadTimeZoneRuleError, ToCalendarTimeError,
     },
     proto::{
         SERVICE_NAME_MENU, SERVICE_NAME_REPAIR, SERVICE_NAME_SYSTEM, SERVICE_NAME_SYSTEM_USER,
         SERVICE_NAME_USER,
     },
     types::{
-        TimeCalendarAdditionalInfo, TimeCalendarTime, TimeServiceType,
+        TimeCalendarAdditionalInfo, TimeCalendarTime, TimeLocationName, TimeServiceType,
         TimeStandardSteadyClockTimePointType, TimeSteadyClockTimePoint, TimeSystemClockContext,
         TimeType,
     },
+    tz::{LocalTimeZone, TimeZoneRule},
 };
 
 /// Size of time service shared memory (6.0.0+).
@@ -188,6 +190,31 @@ impl TimeService {
         ((context.base_time + tick_ns as i64) / 1_000_000_000) as u64
     }
 
+    /// Gets the device's time zone location name.
+    #[inline]
+    pub fn get_device_location_name(&self) -> Result<TimeLocationName, GetDeviceLocationNameError> {
+        cmif::get_device_location_name(self.timezone_service.session)
+    }
+
+    /// Loads the device's time zone rule into `zone`, for in-process
+    /// conversions.
+    ///
+    /// On error, `zone` is left empty and converts to UTC.
+    pub fn load_local_time_zone(
+        &self,
+        zone: &mut LocalTimeZone,
+    ) -> Result<(), LoadTimeZoneRuleError> {
+        let location = self
+            .get_device_location_name()
+            .map_err(LoadTimeZoneRuleError::GetDeviceLocationName)?;
+        cmif::load_time_zone_rule(self.timezone_service.session, &location, zone.rule_mut())?;
+
+        if !zone.finish_load() {
+            return Err(LoadTimeZoneRuleError::InvalidRule);
+        }
+        Ok(())
+    }
+
     /// Converts a POSIX timestamp to calendar time using the device's timezone rule.
     #[inline]
     pub fn to_calendar_time_with_my_rule(
@@ -63,7 +63,6 @@ pub mod steady_clock_cmds {
 /// ITimeZoneService command IDs
 pub mod timezone_service_cmds {
     /// Get device location name.
-    #[expect(dead_code)]
     pub const GET_DEVICE_LOCATION_NAME: u32 = 0;
 
     /// Set device location name.
@@ -74,6 +73,9 @@ pub mod timezone_service_cmds {
     #[expect(dead_code)]
     pub const GET_TOTAL_LOCATION_NAME_COUNT: u32 = 2;
 
+    /// Load the time zone rule of a location.
+    pub const LOAD_TIME_ZONE_RULE: u32 = 4;
+
     /// To calendar time with my rule.
     pub const TO_CALENDAR_TIME_WITH_MY_RULE: u32 = 101;
 
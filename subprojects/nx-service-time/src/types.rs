@@ -65,6 +65,13 @@ pub struct TimeCalendarAdditionalInfo {
     pub offset: i32,
 }
 
+/// Time zone location name (e.g. `Europe/Paris`), NUL-padded.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub struct TimeLocationName {
+    pub name: [u8; 0x24],
+}
+
 /// Steady clock time point.
 #[derive(Debug, Clone, Copy)]
 #[repr(C)]
@@ -0,0 +1,259 @@
+//! In-process time zone conversion.
+//!
+//! The time zone service converts timestamps to calendar time over IPC. A
+//! [`LocalTimeZone`] holds a copy of the device's [`TimeZoneRule`], loaded once
+//! with [`TimeService::load_local_time_zone`](crate::TimeService::load_local_time_zone),
+//! and does the same conversion in-process: a lookup of the transition window
+//! the timestamp falls in, then plain calendar arithmetic. The last window used
+//! is cached, so converting timestamps close to each other skips the lookup.
+
+use core::{
+    mem::size_of,
+    sync::atomic::{AtomicU32, Ordering},
+};
+
+use crate::types::{TimeCalendarAdditionalInfo, TimeCalendarTime};
+
+/// Maximum number of transitions in a rule.
+const MAX_TIMES: usize = 1000;
+
+/// Maximum number of local time types in a rule.
+const MAX_TYPES: usize = 128;
+
+/// Size of the time zone abbreviations buffer of a rule.
+const MAX_CHARS: usize = 512;
+
+const SECS_PER_DAY: i64 = 86_400;
+
+/// Local time type of a rule.
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+pub struct TimeTypeInfo {
+    /// Offset from UTC, in seconds.
+    pub utc_offset: i32,
+    pub is_dst: u8,
+    _pad0: [u8; 3],
+    /// Index of the abbreviation in [`TimeZoneRule::chars`].
+    pub abbreviation_index: i32,
+    pub is_standard_time: u8,
+    pub is_ut: u8,
+    _pad1: [u8; 2],
+}
+
+/// Time zone rule, as returned by `LoadTimeZoneRule` (0x4000 bytes).
+///
+/// This is a compiled tzfile: a list of transition times, each switching to a
+/// local time type.
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+pub struct TimeZoneRule {
+    /// Number of valid entries in `ats` and `types`.
+    pub time_count: i32,
+    /// Number of valid entries in `ttis`.
+    pub type_count: i32,
+    pub char_count: i32,
+    pub go_back: u8,
+    pub go_ahead: u8,
+    _pad: [u8; 2],
+    /// Transition times, in seconds since the Unix epoch, in ascending order.
+    pub ats: [i64; MAX_TIMES],
+    /// Local time type in effect from the matching transition.
+    pub types: [u8; MAX_TIMES],
+    pub ttis: [TimeTypeInfo; MAX_TYPES],
+    pub chars: [u8; MAX_CHARS],
+    /// Local time type in effect before the first transition.
+    pub default_type: i32,
+    _reserved: [u8; 0x12C4],
+}
+
+const _: () = assert!(size_of::<TimeZoneRule>() == 0x4000);
+
+impl TimeZoneRule {
+    /// Returns `true` if every count and type index of the rule is in range.
+    fn is_valid(&self) -> bool {
+        let (Ok(times), Ok(types)) = (
+            usize::try_from(self.time_count),
+            usize::try_from(self.type_count),
+        ) else {
+            return false;
+        };
+        if times > MAX_TIMES || types == 0 || types > MAX_TYPES {
+            return false;
+        }
+
+        let default_ok = usize::try_from(self.default_type).is_ok_and(|ty| ty < types);
+        default_ok && self.types[..times].iter().all(|&ty| (ty as usize) < types)
+    }
+
+    /// Returns the local time type of transition window `window`.
+    ///
+    /// Window 0 is before the first transition; window `i` starts at
+    /// transition `i - 1`.
+    #[inline]
+    fn window_type(&self, window: usize) -> &TimeTypeInfo {
+        let ty = match window {
+            0 => self.default_type as usize,
+            _ => self.types[window - 1] as usize,
+        };
+        &self.ttis[ty]
+    }
+
+    /// Returns `true` if `timestamp` falls in transition window `window`.
+    #[inline]
+    fn window_contains(&self, window: usize, timestamp: i64) -> bool {
+        let times = &self.ats[..self.time_count as usize];
+        let after_start = window == 0 || times[window - 1] <= timestamp;
+        let before_end = window == times.len() || timestamp < times[window];
+        after_start && before_end
+    }
+
+    /// Returns the transition window `timestamp` falls in.
+    #[inline]
+    fn find_window(&self, timestamp: i64) -> usize {
+        self.ats[..self.time_count as usize].partition_point(|&at| at <= timestamp)
+    }
+}
+
+/// The device time zone, converting timestamps to local calendar time
+/// in-process.
+///
+/// All zero bytes are a valid, empty time zone, so it can be allocated zeroed
+/// before loading a rule into it. An empty time zone converts to UTC.
+pub struct LocalTimeZone {
+    rule: TimeZoneRule,
+    /// Transition window of the last conversion.
+    last_window: AtomicU32,
+    /// Whether `rule` holds a valid rule.
+    loaded: bool,
+}
+
+impl LocalTimeZone {
+    /// Returns the rule buffer to load a rule into, and marks the time zone
+    /// empty until [`finish_load`](Self::finish_load) checks it.
+    pub(crate) fn rule_mut(&mut self) -> &mut TimeZoneRule {
+        self.loaded = false;
+        &mut self.rule
+    }
+
+    /// Validates the rule just loaded into the time zone.
+    ///
+    /// Returns `false`, leaving the time zone empty, if the rule is invalid.
+    pub(crate) fn finish_load(&mut self) -> bool {
+        self.loaded = self.rule.is_valid();
+        *self.last_window.get_mut() = 0;
+        self.loaded
+    }
+
+    /// Returns the loaded rule, if any.
+    #[inline]
+    pub fn rule(&self) -> Option<&TimeZoneRule> {
+        self.loaded.then_some(&self.rule)
+    }
+
+    /// Converts a POSIX timestamp to local calendar time.
+    ///
+    /// Matches `ToCalendarTimeWithMyRule`, except that timestamps past the last
+    /// transition of the rule keep its last local time type.
+    pub fn to_calendar_time(
+        &self,
+        timestamp: i64,
+    ) -> (TimeCalendarTime, TimeCalendarAdditionalInfo) {
+        let Some(rule) = self.rule() else {
+            return to_calendar_time(timestamp, 0, [0; 8], false);
+        };
+
+        let cached = self.last_window.load(Ordering::Relaxed) as usize;
+        let window = if rule.window_contains(cached, timestamp) {
+            cached
+        } else {
+            let window = rule.find_window(timestamp);
+            self.last_window.store(window as u32, Ordering::Relaxed);
+            window
+        };
+
+        let info = rule.window_type(window);
+        to_calendar_time(
+            timestamp,
+            info.utc_offset,
+            abbreviation(rule, info),
+            info.is_dst != 0,
+        )
+    }
+}
+
+/// Returns the NUL-padded abbreviation of a local time type, truncated to 8
+/// bytes.
+fn abbreviation(rule: &TimeZoneRule, info: &TimeTypeInfo) -> [u8; 8] {
+    let mut name = [0; 8];
+    let start = usize::try_from(info.abbreviation_index).unwrap_or(MAX_CHARS);
+    let chars = rule.chars.get(start..).unwrap_or_default();
+    for (dst, &src) in name.iter_mut().zip(chars.iter().take_while(|&&c| c != 0)) {
+        *dst = src;
+    }
+    name
+}
+
+/// Converts a timestamp to calendar time at a fixed UTC offset.
+fn to_calendar_time(
+    timestamp: i64,
+    utc_offset: i32,
+    timezone_name: [u8; 8],
+    dst: bool,
+) -> (TimeCalendarTime, TimeCalendarAdditionalInfo) {
+    let local = timestamp.saturating_add(utc_offset as i64);
+    let days = local.div_euclid(SECS_PER_DAY);
+    let secs = local.rem_euclid(SECS_PER_DAY);
+
+    let (year, month, day) = civil_from_days(days);
+    let calendar = TimeCalendarTime {
+        year: year as u16,
+        month,
+        day,
+        hour: (secs / 3600) as u8,
+        minute: (secs / 60 % 60) as u8,
+        second: (secs % 60) as u8,
+        pad: 0,
+    };
+
+    // 1970-01-01 was a Thursday
+    let wday = (days + 4).rem_euclid(7) as u32;
+    let yday = (days - days_from_civil(year, 1, 1)) as u32;
+    let info = TimeCalendarAdditionalInfo {
+        wday,
+        yday,
+        timezone_name,
+        dst: dst as u32,
+        offset: utc_offset,
+    };
+    (calendar, info)
+}
+
+/// Returns the `(year, month, day)` of a day count since 1970-01-01.
+///
+/// From Howard Hinnant's `civil_from_days` algorithm.
+fn civil_from_days(days: i64) -> (i64, u8, u8) {
+    let z = days + 719_468;
+    let era = z.div_euclid(146_097);
+    let doe = z.rem_euclid(146_097);
+    let yoe = (doe - doe / 1460 + doe / 36_524 - doe / 146_096) / 365;
+    let doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    let mp = (5 * doy + 2) / 153;
+    let day = (doy - (153 * mp + 2) / 5 + 1) as u8;
+    let month = if mp < 10 { mp + 3 } else { mp - 9 } as u8;
+    let year = yoe + era * 400 + (month <= 2) as i64;
+    (year, month, day)
+}
+
+/// Returns the day count since 1970-01-01 of a civil date.
+///
+/// From Howard Hinnant's `days_from_civil` algorithm.
+fn days_from_civil(year: i64, month: u8, day: u8) -> i64 {
+    let year = year - (month <= 2) as i64;
+    let era = year.div_euclid(400);
+    let yoe = year.rem_euclid(400);
+    let month = month as i64;
+    let mp = if month > 2 { month - 3 } else { month + 9 };
+    let doy = (153 * mp + 2) / 5 + day as i64 - 1;
+    let doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    era * 146_097 + doe - 719_468
+}
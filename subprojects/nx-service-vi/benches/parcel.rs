@@ -0,0 +1,52 @@
+//! Host benchmarks of the Binder parcel encoding.
+
+use core::hint::black_box;
+
+use criterion::{Criterion, criterion_group, criterion_main};
+use nx_service_vi::parcel::Parcel;
+
+/// Interface token of the buffer producer transactions.
+const INTERFACE_TOKEN: &str = "android.gui.IGraphicBufferProducer";
+
+/// Writes a transaction shaped like a `queueBuffer` request.
+fn write_transaction(parcel: &mut Parcel) {
+    parcel.write_interface_token(INTERFACE_TOKEN);
+    parcel.write_i32(0);
+    parcel.write_flattened_object(&[0u8; 0x54]);
+    for value in 0..8 {
+        parcel.write_u32(value);
+    }
+}
+
+fn bench_write(c: &mut Criterion) {
+    c.bench_function("parcel::write_transaction", |b| {
+        b.iter(|| {
+            let mut parcel = Parcel::new();
+            write_transaction(&mut parcel);
+            black_box(parcel.payload_size())
+        });
+    });
+}
+
+fn bench_read(c: &mut Criterion) {
+    let mut parcel = Parcel::new();
+    for value in 0..16 {
+        parcel.write_u64(value);
+    }
+    parcel.write_flattened_object(&[0u8; 0x54]);
+
+    c.bench_function("parcel::read_values", |b| {
+        b.iter(|| {
+            parcel.reset_read_pos();
+            let mut sum = 0u64;
+            for _ in 0..16 {
+                sum = sum.wrapping_add(parcel.read_u64().unwrap_or(0));
+            }
+            black_box(parcel.read_flattened_object().map(<[u8]>::len));
+            black_box(sum)
+        });
+    });
+}
+
+criterion_group!(benches, bench_write, bench_read);
+criterion_main!(benches);
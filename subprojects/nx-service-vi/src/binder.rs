@@ -6,11 +6,7 @@
 use nx_sf::service::Service;
 use nx_svc::raw::Handle as RawHandle;
 
-use crate::{
-    cmif,
-    parcel::{PARCEL_MAX_PAYLOAD, Parcel, ParcelHeader},
-    types::BinderObjectId,
-};
+use crate::{cmif, parcel::Parcel, types::BinderObjectId};
 
 /// Binder session for IGraphicBufferProducer communication.
 pub struct Binder {
@@ -85,12 +81,15 @@ impl Binder {
 
     /// Performs a binder transaction.
     ///
-    /// Sends `in_parcel` and receives the response in `out_parcel`.
+    /// Sends `in_parcel` and receives the response in `out_parcel`. Both
+    /// parcels are transferred in place: the header is written into the room
+    /// `in_parcel` reserves for it, and the response payload is read straight
+    /// from `out_parcel`'s buffer.
     pub fn transact(
         &self,
         relay: &Service,
         code: u32,
-        in_parcel: &Parcel,
+        in_parcel: &mut Parcel,
         out_parcel: &mut Parcel,
         flags: u32,
     ) -> Result<(), TransactError> {
@@ -98,78 +97,18 @@ impl Binder {
             return Err(TransactError::NotInitialized);
         }
 
-        // Build the input buffer with header
-        let mut in_buf = [0u8; PARCEL_MAX_PAYLOAD];
-        let payload_size = in_parcel.payload_size();
-
-        if payload_size > PARCEL_MAX_PAYLOAD - ParcelHeader::SIZE {
-            return Err(TransactError::InputTooLarge);
-        }
-
-        // Write header
-        let header = ParcelHeader {
-            payload_size: payload_size as u32,
-            payload_off: ParcelHeader::SIZE as u32,
-            objects_size: 0,
-            objects_off: (ParcelHeader::SIZE + payload_size) as u32,
-        };
-
-        // SAFETY: Header is repr(C) and properly sized.
-        unsafe {
-            core::ptr::write_unaligned(in_buf.as_mut_ptr().cast::<ParcelHeader>(), header);
-        }
-
-        // Copy payload after header
-        in_buf[ParcelHeader::SIZE..ParcelHeader::SIZE + payload_size]
-            .copy_from_slice(in_parcel.payload());
-
-        let total_in_size = ParcelHeader::SIZE + payload_size;
-
-        // Output buffer
-        let mut out_buf = [0u8; PARCEL_MAX_PAYLOAD];
-
-        // Perform transaction
         cmif::binder::transact_parcel(
             relay.session,
             self.id,
             code,
-            &in_buf[..total_in_size],
-            &mut out_buf,
+            in_parcel.as_wire(),
+            out_parcel.wire_buffer(),
             flags,
         )?;
 
-        // Parse output header
-        // SAFETY: We're reading from the start of out_buf which has enough space.
-        let out_header =
-            unsafe { core::ptr::read_unaligned(out_buf.as_ptr().cast::<ParcelHeader>()) };
-
-        // Validate header
-        if out_header.payload_size as usize > PARCEL_MAX_PAYLOAD {
-            return Err(TransactError::InvalidResponse);
-        }
-        if out_header.payload_off as usize > PARCEL_MAX_PAYLOAD {
+        if !out_parcel.decode_wire() {
             return Err(TransactError::InvalidResponse);
         }
-        if (out_header.payload_off + out_header.payload_size) as usize > PARCEL_MAX_PAYLOAD {
-            return Err(TransactError::InvalidResponse);
-        }
-
-        // Copy payload to output parcel
-        let payload_start = out_header.payload_off as usize;
-        let payload_end = payload_start + out_header.payload_size as usize;
-        out_parcel
-            .payload_mut()
-            .copy_from_slice(&out_buf[..PARCEL_MAX_PAYLOAD]);
-        out_parcel.set_payload_size(out_header.payload_size as usize);
-        out_parcel.reset_read_pos();
-
-        // Adjust read position to skip header offset (parcel data starts at payload_off)
-        // Actually, we copy the raw payload, so position should start at 0 relative to payload
-        // Let me reconsider: we want out_parcel to contain just the payload portion
-        let payload_data = &out_buf[payload_start..payload_end];
-        out_parcel.payload_mut()[..payload_data.len()].copy_from_slice(payload_data);
-        out_parcel.set_payload_size(payload_data.len());
-        out_parcel.reset_read_pos();
 
         Ok(())
     }
@@ -211,9 +150,6 @@ pub enum TransactError {
     /// Binder session not initialized.
     #[error("binder session not initialized")]
     NotInitialized,
-    /// Input parcel is too large.
-    #[error("input parcel too large")]
-    InputTooLarge,
     /// Invalid response from binder.
     #[error("invalid response from binder")]
     InvalidResponse,
@@ -0,0 +1,385 @@
+//! IGraphicBufferProducer transactions over a binder session.
+//!
+//! A layer's binder object is the producer end of its buffer queue: frames are obtained
+//! with [`BufferProducer::dequeue_buffer`], rendered, and handed to the compositor with
+//! [`BufferProducer::queue_buffer`]. Each call is one binder round trip on the calling
+//! thread.
+
+use core::{mem::size_of, ptr};
+
+use nx_service_nv::fence::NvFence;
+use nx_sf::{Pod, service::Service};
+
+use crate::{
+    binder::{Binder, BinderError, TransactError},
+    parcel::Parcel,
+};
+
+/// Interface token of IGraphicBufferProducer transactions.
+pub const INTERFACE_TOKEN: &str = "android.gui.IGraphicBufferProducer";
+
+/// Number of buffer slots of a buffer queue.
+pub const NUM_BUFFER_SLOTS: usize = 64;
+
+/// Maximum number of fences in an [`NvMultiFence`].
+pub const MAX_FENCES: usize = 4;
+
+/// `NATIVE_WINDOW_API_CPU`, the producer API of CPU-rendered buffers.
+pub const NATIVE_WINDOW_API_CPU: i32 = 2;
+
+/// IGraphicBufferProducer transaction codes.
+mod code {
+    pub const REQUEST_BUFFER: u32 = 1;
+    pub const SET_BUFFER_COUNT: u32 = 2;
+    pub const DEQUEUE_BUFFER: u32 = 3;
+    pub const QUEUE_BUFFER: u32 = 7;
+    pub const CANCEL_BUFFER: u32 = 8;
+    pub const QUERY: u32 = 9;
+    pub const CONNECT: u32 = 10;
+    pub const DISCONNECT: u32 = 11;
+    pub const SET_PREALLOCATED_BUFFER: u32 = 14;
+}
+
+/// Up to [`MAX_FENCES`] syncpoint fences guarding a buffer.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+#[repr(C)]
+pub struct NvMultiFence {
+    num_fences: u32,
+    fences: [NvFence; MAX_FENCES],
+}
+
+// SAFETY: A `u32` and an array of `Pod` fences, without padding.
+unsafe impl Pod for NvMultiFence {}
+
+impl NvMultiFence {
+    /// Creates an empty fence set, guarding nothing.
+    #[inline]
+    pub const fn none() -> Self {
+        Self {
+            num_fences: 0,
+            fences: [NvFence { id: 0, value: 0 }; MAX_FENCES],
+        }
+    }
+
+    /// Creates a set holding the single fence `fence`.
+    #[inline]
+    pub const fn from_fence(fence: NvFence) -> Self {
+        let mut fences = [NvFence { id: 0, value: 0 }; MAX_FENCES];
+        fences[0] = fence;
+        Self {
+            num_fences: 1,
+            fences,
+        }
+    }
+
+    /// Returns the fences of the set.
+    #[inline]
+    pub fn fences(&self) -> &[NvFence] {
+        &self.fences[..(self.num_fences as usize).min(MAX_FENCES)]
+    }
+}
+
+/// Crop rectangle of a queued buffer; an empty rectangle shows the whole buffer.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+#[repr(C)]
+pub struct BqRect {
+    pub left: i32,
+    pub top: i32,
+    pub right: i32,
+    pub bottom: i32,
+}
+
+/// Parameters of [`BufferProducer::queue_buffer`].
+#[derive(Debug, Clone, Copy, Default)]
+#[repr(C)]
+pub struct QueueBufferInput {
+    /// Presentation timestamp, in nanoseconds.
+    pub timestamp: i64,
+    /// Whether the compositor sets the timestamp on its own.
+    pub is_auto_timestamp: i32,
+    pub crop: BqRect,
+    pub scaling_mode: i32,
+    pub transform: u32,
+    pub sticky_transform: u32,
+    pub unknown: u32,
+    /// Number of vsyncs the buffer is shown for at least; zero replaces it as soon as the
+    /// next buffer is queued.
+    pub swap_interval: u32,
+    /// Fences the compositor waits for before reading the buffer.
+    pub fence: NvMultiFence,
+    _reserved: u32,
+}
+
+// SAFETY: Plain integer fields laid out without implicit padding.
+unsafe impl Pod for QueueBufferInput {}
+
+impl QueueBufferInput {
+    /// Creates the parameters of a whole, untransformed buffer, shown for `swap_interval`
+    /// vsyncs once `fence` is reached.
+    #[inline]
+    pub fn new(fence: NvMultiFence, swap_interval: u32) -> Self {
+        Self {
+            swap_interval,
+            fence,
+            ..Self::default()
+        }
+    }
+}
+
+/// Buffer queue state returned by [`BufferProducer::queue_buffer`] and
+/// [`BufferProducer::connect`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+#[repr(C)]
+pub struct QueueBufferOutput {
+    pub width: u32,
+    pub height: u32,
+    pub transform_hint: u32,
+    /// Number of queued buffers not yet shown.
+    pub num_pending_buffers: u32,
+}
+
+// SAFETY: Four `u32` fields without padding.
+unsafe impl Pod for QueueBufferOutput {}
+
+/// A buffer slot returned by [`BufferProducer::dequeue_buffer`].
+#[derive(Debug, Clone, Copy)]
+pub struct DequeuedBuffer {
+    /// Slot of the buffer.
+    pub slot: i32,
+    /// Fences to wait for before writing the buffer; the compositor may still read it.
+    pub fence: NvMultiFence,
+}
+
+/// Producer end of a buffer queue.
+pub struct BufferProducer {
+    binder: Binder,
+    relay: Service,
+}
+
+impl BufferProducer {
+    /// Wraps the initialized `binder`, transacting through the binder relay `relay`.
+    ///
+    /// `relay` may be a copy of a session owned elsewhere, like
+    /// [`ViService::binder_relay`](crate::ViService::binder_relay); it must then stay open
+    /// as long as the producer is used.
+    pub fn new(binder: Binder, relay: Service) -> Self {
+        Self { binder, relay }
+    }
+
+    /// Returns the binder of the producer.
+    #[inline]
+    pub fn binder(&self) -> &Binder {
+        &self.binder
+    }
+
+    /// Returns the binder relay session the producer transacts through.
+    #[inline]
+    pub fn relay(&self) -> &Service {
+        &self.relay
+    }
+
+    /// Unwraps the binder, to close it.
+    #[inline]
+    pub fn into_binder(self) -> Binder {
+        self.binder
+    }
+
+    /// Connects to the buffer queue as a producer of the `api` kind.
+    pub fn connect(
+        &self,
+        api: i32,
+        producer_controlled_by_app: bool,
+    ) -> Result<QueueBufferOutput, ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(0); // No producer listener
+        parcel.write_i32(api);
+        parcel.write_i32(producer_controlled_by_app as i32);
+
+        let mut reply = self.transact(code::CONNECT, &mut parcel)?;
+        let output = read_pod::<QueueBufferOutput>(&mut reply)?;
+        read_status(&mut reply)?;
+        Ok(output)
+    }
+
+    /// Disconnects the `api` producer from the buffer queue.
+    pub fn disconnect(&self, api: i32) -> Result<(), ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(api);
+
+        let mut reply = self.transact(code::DISCONNECT, &mut parcel)?;
+        read_status(&mut reply)
+    }
+
+    /// Sets the number of buffer slots the producer may dequeue.
+    pub fn set_buffer_count(&self, count: i32) -> Result<(), ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(count);
+
+        let mut reply = self.transact(code::SET_BUFFER_COUNT, &mut parcel)?;
+        read_status(&mut reply)
+    }
+
+    /// Attaches the flattened graphic buffer `buffer` to `slot`, or detaches the slot
+    /// buffer if `None`.
+    pub fn set_preallocated_buffer(
+        &self,
+        slot: i32,
+        buffer: Option<&[u8]>,
+    ) -> Result<(), ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(slot);
+        parcel.write_i32(buffer.is_some() as i32);
+        if let Some(buffer) = buffer {
+            parcel
+                .write_flattened_object(buffer)
+                .ok_or(ProducerError::TooLarge)?;
+        }
+
+        self.transact(code::SET_PREALLOCATED_BUFFER, &mut parcel)?;
+        Ok(())
+    }
+
+    /// Checks that the buffer of `slot` is attached, returning whether it is.
+    pub fn request_buffer(&self, slot: i32) -> Result<bool, ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(slot);
+
+        let mut reply = self.transact(code::REQUEST_BUFFER, &mut parcel)?;
+        let attached = reply.read_i32().ok_or(ProducerError::InvalidReply)? != 0;
+        if attached {
+            // The flattened graphic buffer is the producer's own, already at hand
+            reply
+                .read_flattened_object()
+                .ok_or(ProducerError::InvalidReply)?;
+        }
+        read_status(&mut reply)?;
+        Ok(attached)
+    }
+
+    /// Dequeues a free buffer slot, blocking in the compositor until one is released
+    /// unless `is_async`.
+    pub fn dequeue_buffer(
+        &self,
+        is_async: bool,
+        width: u32,
+        height: u32,
+        format: i32,
+        usage: u32,
+    ) -> Result<DequeuedBuffer, ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(is_async as i32);
+        parcel.write_u32(width);
+        parcel.write_u32(height);
+        parcel.write_i32(format);
+        parcel.write_u32(usage);
+
+        let mut reply = self.transact(code::DEQUEUE_BUFFER, &mut parcel)?;
+        let slot = reply.read_i32().ok_or(ProducerError::InvalidReply)?;
+        let fence = if reply.read_i32().ok_or(ProducerError::InvalidReply)? != 0 {
+            let data = reply
+                .read_flattened_object()
+                .filter(|data| data.len() == size_of::<NvMultiFence>())
+                .ok_or(ProducerError::InvalidReply)?;
+            // SAFETY: `data` holds the bytes of an `NvMultiFence`, which is `Pod`.
+            unsafe { ptr::read_unaligned(data.as_ptr().cast::<NvMultiFence>()) }
+        } else {
+            NvMultiFence::none()
+        };
+        read_status(&mut reply)?;
+        Ok(DequeuedBuffer { slot, fence })
+    }
+
+    /// Queues the buffer of `slot` for composition.
+    pub fn queue_buffer(
+        &self,
+        slot: i32,
+        input: &QueueBufferInput,
+    ) -> Result<QueueBufferOutput, ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(slot);
+        parcel
+            .write_flattened_object(as_bytes(input))
+            .ok_or(ProducerError::TooLarge)?;
+
+        let mut reply = self.transact(code::QUEUE_BUFFER, &mut parcel)?;
+        let output = read_pod::<QueueBufferOutput>(&mut reply)?;
+        read_status(&mut reply)?;
+        Ok(output)
+    }
+
+    /// Returns the dequeued buffer of `slot` to the queue without showing it, once
+    /// `fence` is reached.
+    pub fn cancel_buffer(&self, slot: i32, fence: &NvMultiFence) -> Result<(), ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(slot);
+        parcel
+            .write_flattened_object(as_bytes(fence))
+            .ok_or(ProducerError::TooLarge)?;
+
+        self.transact(code::CANCEL_BUFFER, &mut parcel)?;
+        Ok(())
+    }
+
+    /// Queries the buffer queue property `what` (a `NATIVE_WINDOW_*` query).
+    pub fn query(&self, what: i32) -> Result<i32, ProducerError> {
+        let mut parcel = request();
+        parcel.write_i32(what);
+
+        let mut reply = self.transact(code::QUERY, &mut parcel)?;
+        let value = reply.read_i32().ok_or(ProducerError::InvalidReply)?;
+        read_status(&mut reply)?;
+        Ok(value)
+    }
+
+    fn transact(&self, code: u32, parcel: &mut Parcel) -> Result<Parcel, ProducerError> {
+        let mut reply = Parcel::new();
+        self.binder
+            .transact(&self.relay, code, parcel, &mut reply, 0)?;
+        Ok(reply)
+    }
+}
+
+/// Creates a request parcel, starting with the interface token.
+fn request() -> Parcel {
+    let mut parcel = Parcel::new();
+    parcel.write_interface_token(INTERFACE_TOKEN);
+    parcel
+}
+
+/// Reads the status code ending a reply.
+fn read_status(reply: &mut Parcel) -> Result<(), ProducerError> {
+    let status = reply.read_i32().ok_or(ProducerError::InvalidReply)?;
+    BinderError::from_code(status).map_err(ProducerError::Status)
+}
+
+/// Reads a `T` stored in place in a reply.
+fn read_pod<T: Pod>(reply: &mut Parcel) -> Result<T, ProducerError> {
+    let data = reply
+        .read_data(size_of::<T>())
+        .ok_or(ProducerError::InvalidReply)?;
+    // SAFETY: `data` points to `size_of::<T>()` bytes, and `T` is `Pod`.
+    Ok(unsafe { ptr::read_unaligned(data.cast::<T>()) })
+}
+
+/// Views a `Pod` value as its bytes.
+fn as_bytes<T: Pod>(value: &T) -> &[u8] {
+    // SAFETY: `Pod` values have no padding, so all of their bytes are initialized.
+    unsafe { core::slice::from_raw_parts(ptr::from_ref(value).cast::<u8>(), size_of::<T>()) }
+}
+
+/// Error returned by [`BufferProducer`] transactions.
+#[derive(Debug, thiserror::Error)]
+pub enum ProducerError {
+    /// The binder transaction failed.
+    #[error("IGraphicBufferProducer transaction failed")]
+    Transact(#[from] TransactError),
+    /// The request does not fit in a parcel.
+    #[error("IGraphicBufferProducer request too large")]
+    TooLarge,
+    /// The reply is truncated or malformed.
+    #[error("invalid IGraphicBufferProducer reply")]
+    InvalidReply,
+    /// The buffer queue returned an error status.
+    #[error("IGraphicBufferProducer call failed")]
+    Status(#[source] BinderError),
+}
@@ -16,6 +16,7 @@ use nx_sf::service::Service;
 use nx_svc::ipc::Handle as SessionHandle;
 
 pub mod binder;
+pub mod buffer_queue;
 mod cmif;
 pub mod parcel;
 mod proto;
@@ -23,6 +24,10 @@ pub mod types;
 
 pub use self::{
     binder::{Binder, BinderError, GetNativeHandleError, InitSessionError, TransactError},
+    buffer_queue::{
+        BufferProducer, DequeuedBuffer, NvMultiFence, ProducerError, QueueBufferInput,
+        QueueBufferOutput,
+    },
     cmif::{
         application::{
             CloseDisplayError, CloseLayerError, CreateStrayLayerError, CreateStrayLayerOutput,
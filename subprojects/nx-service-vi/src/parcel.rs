@@ -4,7 +4,9 @@
 //! This implementation follows the Android Parcel format used by
 //! IGraphicBufferProducer.
 
-/// Maximum parcel payload size.
+use core::ptr;
+
+/// Maximum size of a parcel on the wire, header included.
 pub const PARCEL_MAX_PAYLOAD: usize = 0x400;
 
 /// Parcel header structure.
@@ -28,10 +30,15 @@ impl ParcelHeader {
 
 /// Parcel for Binder IPC serialization.
 ///
-/// Used to serialize data for IGraphicBufferProducer transactions.
+/// Used to serialize data for IGraphicBufferProducer transactions. The parcel
+/// is kept in its wire format: the buffer reserves room for the
+/// [`ParcelHeader`] in front of the payload, so a transaction sends the buffer
+/// as is, and a response is received into it and read in place.
 pub struct Parcel {
-    /// Payload data buffer.
-    payload: [u8; PARCEL_MAX_PAYLOAD],
+    /// Wire buffer: header, then the payload at `payload_off`.
+    buf: [u8; PARCEL_MAX_PAYLOAD],
+    /// Offset of the payload in `buf`.
+    payload_off: usize,
     /// Current payload size (write position).
     payload_size: usize,
     /// Current read position.
@@ -42,7 +49,8 @@ impl Parcel {
     /// Creates a new empty Parcel.
     pub const fn new() -> Self {
         Self {
-            payload: [0; PARCEL_MAX_PAYLOAD],
+            buf: [0; PARCEL_MAX_PAYLOAD],
+            payload_off: ParcelHeader::SIZE,
             payload_size: 0,
             pos: 0,
         }
@@ -54,33 +62,98 @@ impl Parcel {
         self.payload_size
     }
 
+    /// Returns the payload capacity in bytes.
+    #[inline]
+    pub fn capacity(&self) -> usize {
+        PARCEL_MAX_PAYLOAD - self.payload_off
+    }
+
     /// Returns a reference to the payload data.
     #[inline]
     pub fn payload(&self) -> &[u8] {
-        &self.payload[..self.payload_size]
+        &self.buf[self.payload_off..self.payload_off + self.payload_size]
     }
 
     /// Returns a mutable reference to the raw payload buffer.
     ///
-    /// # Safety
-    ///
-    /// Caller must ensure data written is properly aligned and sized.
+    /// The buffer spans the whole [`capacity`](Self::capacity). Follow external
+    /// writes with [`set_payload_size`](Self::set_payload_size).
     #[inline]
-    pub fn payload_mut(&mut self) -> &mut [u8; PARCEL_MAX_PAYLOAD] {
-        &mut self.payload
+    pub fn payload_mut(&mut self) -> &mut [u8] {
+        &mut self.buf[self.payload_off..]
     }
 
     /// Sets the payload size after external writes.
     ///
-    /// # Safety
-    ///
-    /// Caller must ensure size does not exceed `PARCEL_MAX_PAYLOAD`.
+    /// The size must not exceed the parcel's [`capacity`](Self::capacity).
     #[inline]
     pub fn set_payload_size(&mut self, size: usize) {
-        debug_assert!(size <= PARCEL_MAX_PAYLOAD);
+        debug_assert!(size <= self.capacity());
         self.payload_size = size;
     }
 
+    /// Writes the header in front of the payload and returns the parcel in its
+    /// wire format.
+    pub(crate) fn as_wire(&mut self) -> &[u8] {
+        if self.payload_off < ParcelHeader::SIZE {
+            // Decoded from a response with a short header: make room for ours
+            let start = self.payload_off;
+            let size = self
+                .payload_size
+                .min(PARCEL_MAX_PAYLOAD - ParcelHeader::SIZE);
+            self.buf
+                .copy_within(start..start + size, ParcelHeader::SIZE);
+            self.payload_off = ParcelHeader::SIZE;
+            self.payload_size = size;
+            self.pos = self.pos.min(size);
+        }
+
+        let header = ParcelHeader {
+            payload_size: self.payload_size as u32,
+            payload_off: self.payload_off as u32,
+            objects_size: 0,
+            objects_off: (self.payload_off + self.payload_size) as u32,
+        };
+        // SAFETY: The header fits in front of the payload; the write is unaligned.
+        unsafe { ptr::write_unaligned(self.buf.as_mut_ptr().cast::<ParcelHeader>(), header) };
+
+        &self.buf[..self.payload_off + self.payload_size]
+    }
+
+    /// Returns the whole buffer, to receive a parcel in its wire format.
+    ///
+    /// Follow with [`decode_wire`](Self::decode_wire).
+    pub(crate) fn wire_buffer(&mut self) -> &mut [u8; PARCEL_MAX_PAYLOAD] {
+        &mut self.buf
+    }
+
+    /// Decodes the header of a parcel received with
+    /// [`wire_buffer`](Self::wire_buffer), setting the payload to the received
+    /// one in place.
+    ///
+    /// Returns `false` if the header does not describe a payload within the
+    /// buffer; the parcel is then left empty.
+    pub(crate) fn decode_wire(&mut self) -> bool {
+        // SAFETY: The buffer holds at least a header; the read is unaligned.
+        let header = unsafe { ptr::read_unaligned(self.buf.as_ptr().cast::<ParcelHeader>()) };
+        let payload_off = header.payload_off as usize;
+        let payload_size = header.payload_size as usize;
+
+        self.pos = 0;
+        if payload_off
+            .checked_add(payload_size)
+            .is_none_or(|end| end > PARCEL_MAX_PAYLOAD)
+        {
+            self.payload_off = ParcelHeader::SIZE;
+            self.payload_size = 0;
+            return false;
+        }
+
+        self.payload_off = payload_off;
+        self.payload_size = payload_size;
+        true
+    }
+
     /// Resets the read position to the beginning.
     #[inline]
     pub fn reset_read_pos(&mut self) {
@@ -99,11 +172,11 @@ impl Parcel {
         // Align to 4 bytes
         let aligned_size = (data_size + 3) & !3;
 
-        if self.payload_size + aligned_size > PARCEL_MAX_PAYLOAD {
+        if self.payload_size + aligned_size > self.capacity() {
             return None;
         }
 
-        let ptr = self.payload[self.payload_size..].as_mut_ptr();
+        let ptr = self.buf[self.payload_off + self.payload_size..].as_mut_ptr();
         if !data.is_empty() {
             // SAFETY: We checked bounds above.
             unsafe {
@@ -125,13 +198,13 @@ impl Parcel {
 
         let aligned_size = (size + 3) & !3;
 
-        if self.payload_size + aligned_size > PARCEL_MAX_PAYLOAD {
+        if self.payload_size + aligned_size > self.capacity() {
             return None;
         }
 
-        let start = self.payload_size;
+        let start = self.payload_off + self.payload_size;
         self.payload_size += aligned_size;
-        Some(&mut self.payload[start..start + size])
+        Some(&mut self.buf[start..start + size])
     }
 
     /// Reads raw data from the parcel, aligned to 4 bytes.
@@ -148,7 +221,7 @@ impl Parcel {
             return None;
         }
 
-        let ptr = self.payload[self.pos..].as_ptr();
+        let ptr = self.buf[self.payload_off + self.pos..].as_ptr();
         self.pos += aligned_size;
         Some(ptr)
     }
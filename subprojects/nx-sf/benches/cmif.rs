@@ -0,0 +1,120 @@
+//! Host benchmarks of the CMIF and HIPC message encoding.
+//!
+//! The messages are built in a local buffer instead of the TLS IPC buffer, so no
+//! request is ever sent.
+
+use core::{hint::black_box, ptr::NonNull};
+
+use criterion::{Criterion, criterion_group, criterion_main};
+use nx_sf::{
+    cmif::{self, CommandType, RequestFormat, RequestFormatBuilder, RequestLayout, ResponseFormat},
+    hipc,
+};
+
+/// Size of the IPC message buffer.
+const MESSAGE_SIZE: usize = 0x200;
+
+/// Stand-in for the TLS IPC buffer, with its alignment.
+#[repr(C, align(16))]
+struct MessageBuffer([u8; MESSAGE_SIZE]);
+
+impl MessageBuffer {
+    fn new() -> Self {
+        Self([0; MESSAGE_SIZE])
+    }
+
+    fn base(&mut self) -> NonNull<u8> {
+        NonNull::from(&mut self.0).cast()
+    }
+}
+
+/// A request with 8 bytes of data and one buffer each way, as most service calls.
+const FORMAT: RequestFormat = RequestFormatBuilder::new(1)
+    .data_size(8)
+    .in_buffers(1)
+    .out_buffers(1)
+    .build();
+
+/// Layout of [`FORMAT`] requests, computed once.
+const LAYOUT: RequestLayout = RequestLayout::new(FORMAT);
+
+fn bench_make_request(c: &mut Criterion) {
+    let mut buf = MessageBuffer::new();
+    let base = buf.base();
+
+    let mut group = c.benchmark_group("cmif::make_request");
+    group.bench_function("data", |b| {
+        let fmt = RequestFormatBuilder::new(1).data_size(8).build();
+        // SAFETY: `base` points to a message-sized buffer.
+        b.iter(|| unsafe { black_box(cmif::make_request(base, black_box(fmt))) });
+    });
+    group.bench_function("data_buffers", |b| {
+        // SAFETY: `base` points to a message-sized buffer.
+        b.iter(|| unsafe { black_box(cmif::make_request(base, black_box(FORMAT))) });
+    });
+    group.bench_function("data_buffers_with_layout", |b| {
+        // SAFETY: `base` points to a message-sized buffer.
+        b.iter(|| unsafe {
+            black_box(cmif::make_request_with_layout(
+                base,
+                black_box(&LAYOUT),
+                None,
+            ))
+        });
+    });
+    group.finish();
+}
+
+fn bench_parse_response(c: &mut Criterion) {
+    let mut buf = MessageBuffer::new();
+    let base = buf.base();
+
+    let data = [0xAAu8; 8];
+    // SAFETY: `base` points to a message-sized buffer.
+    unsafe {
+        cmif::make_response(
+            base,
+            &ResponseFormat {
+                is_domain: false,
+                result: 0,
+                data: &data,
+                objects: &[],
+                copy_handles: &[],
+                move_handles: &[],
+            },
+        );
+    }
+
+    c.bench_function("cmif::parse_response", |b| {
+        // SAFETY: `base` holds the response built above.
+        b.iter(|| unsafe { black_box(cmif::parse_response(base, false, black_box(data.len()))) });
+    });
+}
+
+fn bench_calc_request_layout(c: &mut Criterion) {
+    let mut buf = MessageBuffer::new();
+    let base = buf.base().as_ptr();
+
+    let meta = hipc::Metadata {
+        message_type: CommandType::Request.into(),
+        num_send_buffers: 1,
+        num_recv_buffers: 1,
+        num_data_words: 16,
+        send_pid: true,
+        num_copy_handles: 1,
+        ..Default::default()
+    };
+
+    c.bench_function("hipc::calc_request_layout", |b| {
+        // SAFETY: `base` points to a message-sized buffer.
+        b.iter(|| unsafe { black_box(hipc::calc_request_layout(black_box(&meta), base)) });
+    });
+}
+
+criterion_group!(
+    benches,
+    bench_make_request,
+    bench_parse_response,
+    bench_calc_request_layout
+);
+criterion_main!(benches);
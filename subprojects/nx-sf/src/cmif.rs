@@ -58,12 +58,20 @@
 //! - [Switchbrew IPC Marshalling](https://switchbrew.org/wiki/IPC_Marshalling)
 //! - libnx `sf/cmif.h` (fincs, SciresM)
 
-use core::{mem::size_of, ptr, ptr::NonNull, slice};
+use core::{
+    mem::{size_of, size_of_val},
+    ptr,
+    ptr::NonNull,
+    slice,
+};
 
 use nx_svc::raw::Handle as RawHandle;
 use static_assertions::const_assert_eq;
 
-use crate::hipc::{self, BufferMode};
+use crate::{
+    hipc::{self, BufferMode},
+    pod::{self, Pod},
+};
 
 /// Magic number for CMIF input headers ("SFCI" - Service Framework Command Input).
 const IN_HEADER_MAGIC: u32 = 0x49434653;
@@ -213,6 +221,89 @@ pub unsafe fn make_request(base: NonNull<u8>, fmt: RequestFormat) -> Request<'st
     }
 }
 
+/// Builds a CMIF request message from a precomputed [`RequestLayout`].
+///
+/// Produces the same message as [`make_request`] with the layout's format, but
+/// only stores the precomputed header words, so hot commands can keep their
+/// layout in a `const` and skip the size computations on every call.
+/// `object_id` selects the domain variant of the layout and the target object.
+///
+/// # Safety
+///
+/// `base` must point to a valid buffer (typically TLS IPC buffer) with at least
+/// 0x200 bytes available.
+#[inline]
+pub unsafe fn make_request_with_layout(
+    base: NonNull<u8>,
+    layout: &RequestLayout,
+    object_id: Option<ObjectId>,
+) -> Request<'static> {
+    let fmt = &layout.fmt;
+    let variant = if object_id.is_some() {
+        &layout.domain
+    } else {
+        &layout.session
+    };
+    let base = base.as_ptr();
+
+    // SAFETY: Caller guarantees `base` points to valid buffer with sufficient space;
+    // all offsets were computed by `RequestLayout::new` for this message.
+    unsafe {
+        base.cast::<u32>().write(layout.header);
+        base.cast::<u32>().add(1).write(variant.header);
+        if let Some(special) = layout.special_header {
+            base.add(size_of::<hipc::Header>())
+                .cast::<u32>()
+                .write(special);
+        }
+
+        if let Some(object_id) = object_id {
+            base.add(layout.cmif_offset)
+                .cast::<DomainInHeader>()
+                .write(DomainInHeader {
+                    request_type: DomainRequestType::SendMessage as u8,
+                    num_in_objects: fmt.num_objects as u8,
+                    data_size: (size_of::<InHeader>() + fmt.data_size) as u16,
+                    object_id: object_id.to_raw(),
+                    _padding: 0,
+                    token: fmt.context,
+                });
+        }
+        base.add(variant.in_header_offset)
+            .cast::<InHeader>()
+            .write(variant.in_header);
+    }
+
+    // SAFETY: Every section lies within the message written above.
+    unsafe {
+        Request {
+            hipc: hipc::Request {
+                send_statics: layout.send_statics.slice(base),
+                send_buffers: layout.send_buffers.slice(base),
+                recv_buffers: layout.recv_buffers.slice(base),
+                exch_buffers: layout.exch_buffers.slice(base),
+                data_words: variant.data_words.slice(base),
+                recv_list: variant.recv_list.slice(base),
+                copy_handles: layout.copy_handles.slice(base),
+                move_handles: &mut [],
+            },
+            data: variant.data.slice(base),
+            out_pointer_sizes: variant.out_pointer_sizes.slice(base),
+            objects: variant.objects.slice(base),
+            server_pointer_size: fmt.server_pointer_size,
+            cur_in_ptr_id: 0,
+            send_buffer_idx: 0,
+            recv_buffer_idx: 0,
+            exch_buffer_idx: 0,
+            send_static_idx: 0,
+            recv_list_idx: 0,
+            out_pointer_size_idx: 0,
+            object_idx: 0,
+            copy_handle_idx: 0,
+        }
+    }
+}
+
 /// Builds a CMIF control request message.
 ///
 /// Control requests are used for session management operations like
@@ -370,6 +461,186 @@ pub enum ParseResponseError {
     ServiceError(u32),
 }
 
+/// Parses an incoming CMIF request message (for server-side use).
+///
+/// `is_domain` selects the domain request format: a [`DomainInHeader`] before the CMIF
+/// header, and the input object IDs after the payload. Domain close requests carry no CMIF
+/// header, and are returned with an empty payload.
+///
+/// # Safety
+///
+/// `base` must point to a valid HIPC request message buffer.
+pub unsafe fn parse_request<'a>(
+    base: NonNull<u8>,
+    is_domain: bool,
+) -> Result<ParsedRequest<'a>, ParseRequestError> {
+    // SAFETY: Caller guarantees `base` points to a valid HIPC request buffer.
+    let hipc_req = unsafe { hipc::parse_request(base) };
+    let data_words = hipc_req.data.data_words.as_ptr().cast_mut();
+    let start = get_aligned_data_start(data_words, base.as_ptr());
+    let end = data_words.wrapping_add(hipc_req.meta.num_data_words) as usize;
+    let size = end.saturating_sub(start as usize);
+
+    let (target, cmif_start, cmif_size, in_objects) = if is_domain {
+        if size < size_of::<DomainInHeader>() {
+            return Err(ParseRequestError::InvalidHeaderSize);
+        }
+
+        // SAFETY: The domain header lies within the data words.
+        let header = unsafe { ptr::read(start as *const DomainInHeader) };
+        let request_type = match header.request_type {
+            1 => DomainRequestType::SendMessage,
+            2 => DomainRequestType::Close,
+            _ => return Err(ParseRequestError::InvalidDomainHeader),
+        };
+        let object_id =
+            ObjectId::new(header.object_id).ok_or(ParseRequestError::InvalidDomainHeader)?;
+
+        let cmif_size = header.data_size as usize;
+        let num_in_objects = header.num_in_objects as usize;
+        if size_of::<DomainInHeader>() + cmif_size + num_in_objects * size_of::<u32>() > size {
+            return Err(ParseRequestError::InvalidHeaderSize);
+        }
+
+        // SAFETY: The CMIF section and the object IDs lie within the data words, as checked.
+        let cmif_start = unsafe { start.add(size_of::<DomainInHeader>()) };
+        let objects_ptr = unsafe { cmif_start.add(cmif_size) } as *const u32;
+        if !objects_ptr.is_aligned() {
+            return Err(ParseRequestError::InvalidHeaderSize);
+        }
+        // SAFETY: objects_ptr is aligned, and the count comes from the domain header.
+        let in_objects = unsafe { slice::from_raw_parts(objects_ptr, num_in_objects) };
+
+        let target = DomainTarget {
+            request_type,
+            object_id,
+        };
+        (Some(target), cmif_start, cmif_size, in_objects)
+    } else {
+        (None, start, size, &[][..])
+    };
+
+    if let Some(DomainTarget {
+        request_type: DomainRequestType::Close,
+        ..
+    }) = target
+    {
+        return Ok(ParsedRequest {
+            hipc: hipc_req,
+            target,
+            header: InHeader::default(),
+            // SAFETY: An empty slice at a non-null pointer.
+            data: unsafe { slice::from_raw_parts(cmif_start, 0) },
+            in_objects,
+        });
+    }
+
+    if cmif_size < size_of::<InHeader>() {
+        return Err(ParseRequestError::InvalidHeaderSize);
+    }
+
+    // SAFETY: The CMIF header lies within the data words, at a 16-byte aligned offset.
+    let header = unsafe { ptr::read(cmif_start as *const InHeader) };
+    if header.magic != IN_HEADER_MAGIC {
+        return Err(ParseRequestError::InvalidMagic);
+    }
+
+    // SAFETY: The payload follows the CMIF header, within the data words.
+    let data = unsafe {
+        slice::from_raw_parts(
+            cmif_start.add(size_of::<InHeader>()),
+            cmif_size - size_of::<InHeader>(),
+        )
+    };
+
+    Ok(ParsedRequest {
+        hipc: hipc_req,
+        target,
+        header,
+        data,
+        in_objects,
+    })
+}
+
+/// Error returned by [`parse_request`].
+#[derive(Debug, thiserror::Error)]
+pub enum ParseRequestError {
+    /// Request data is too small for its headers and payload.
+    #[error("invalid CMIF request size")]
+    InvalidHeaderSize,
+    /// Request contains invalid CMIF magic header.
+    #[error("invalid CMIF magic header")]
+    InvalidMagic,
+    /// Domain header has an invalid request type or object ID.
+    #[error("invalid CMIF domain header")]
+    InvalidDomainHeader,
+}
+
+/// Builds a CMIF response message (for server-side use).
+///
+/// # Safety
+///
+/// `base` must point to a valid buffer (typically TLS IPC buffer) with enough space for
+/// the response.
+pub unsafe fn make_response(base: NonNull<u8>, fmt: &ResponseFormat<'_>) {
+    let domain_size = if fmt.is_domain {
+        size_of::<DomainOutHeader>()
+    } else {
+        0
+    };
+    // Alignment padding, headers, payload and output object IDs
+    let actual_size =
+        16 + domain_size + size_of::<OutHeader>() + fmt.data.len() + size_of_val(fmt.objects);
+
+    let hipc_meta = hipc::Metadata {
+        num_data_words: actual_size.div_ceil(4),
+        num_copy_handles: fmt.copy_handles.len(),
+        num_move_handles: fmt.move_handles.len(),
+        ..Default::default()
+    };
+
+    // SAFETY: Caller guarantees `base` points to valid buffer with sufficient space.
+    let hipc_resp = unsafe { hipc::make_request(base, hipc_meta) };
+    hipc_resp.copy_handles.copy_from_slice(fmt.copy_handles);
+    hipc_resp.move_handles.copy_from_slice(fmt.move_handles);
+
+    let mut cursor = get_aligned_data_start(hipc_resp.data_words.as_mut_ptr(), base.as_ptr());
+
+    // SAFETY: The data words were sized for every section written below, starting at the
+    // 16-byte aligned cursor.
+    unsafe {
+        if fmt.is_domain {
+            ptr::write(
+                cursor as *mut DomainOutHeader,
+                DomainOutHeader {
+                    num_out_objects: fmt.objects.len() as u32,
+                    _padding: [0; 3],
+                },
+            );
+            cursor = cursor.add(size_of::<DomainOutHeader>());
+        }
+
+        ptr::write(
+            cursor as *mut OutHeader,
+            OutHeader {
+                magic: OUT_HEADER_MAGIC,
+                version: 0,
+                result: fmt.result,
+                token: 0,
+            },
+        );
+        cursor = cursor.add(size_of::<OutHeader>());
+
+        ptr::copy_nonoverlapping(fmt.data.as_ptr(), cursor, fmt.data.len());
+        cursor = cursor.add(fmt.data.len());
+
+        // The object IDs follow the payload, which may not end 4-byte aligned
+        for (i, &object) in fmt.objects.iter().enumerate() {
+            ptr::write_unaligned(cursor.cast::<u32>().add(i), object);
+        }
+    }
+}
+
 /// Calculates the 16-byte aligned start of the data section.
 ///
 /// CMIF headers must be 16-byte aligned within the HIPC data words.
@@ -540,111 +811,371 @@ pub struct RequestFormatBuilder {
 
 impl RequestFormatBuilder {
     /// Creates a new builder with the given command ID.
-    pub fn new(request_id: u32) -> Self {
+    pub const fn new(request_id: u32) -> Self {
         Self {
             inner: RequestFormat {
+                object_id: None,
                 request_id,
-                ..Default::default()
+                context: 0,
+                data_size: 0,
+                server_pointer_size: 0,
+                num_in_auto_buffers: 0,
+                num_out_auto_buffers: 0,
+                num_in_buffers: 0,
+                num_out_buffers: 0,
+                num_inout_buffers: 0,
+                num_in_pointers: 0,
+                num_out_pointers: 0,
+                num_out_fixed_pointers: 0,
+                num_objects: 0,
+                num_handles: 0,
+                send_pid: false,
             },
         }
     }
 
     /// Sets the domain object ID.
-    pub fn object_id(mut self, id: ObjectId) -> Self {
+    pub const fn object_id(mut self, id: ObjectId) -> Self {
         self.inner.object_id = Some(id);
         self
     }
 
     /// Sets the context token.
-    pub fn context(mut self, context: u32) -> Self {
+    pub const fn context(mut self, context: u32) -> Self {
         self.inner.context = context;
         self
     }
 
     /// Sets the payload data size in bytes.
-    pub fn data_size(mut self, size: usize) -> Self {
+    pub const fn data_size(mut self, size: usize) -> Self {
         self.inner.data_size = size;
         self
     }
 
     /// Sets the server pointer buffer size.
-    pub fn server_pointer_size(mut self, size: usize) -> Self {
+    pub const fn server_pointer_size(mut self, size: usize) -> Self {
         self.inner.server_pointer_size = size;
         self
     }
 
     /// Sets the number of auto-select input buffers.
-    pub fn in_auto_buffers(mut self, count: u32) -> Self {
+    pub const fn in_auto_buffers(mut self, count: u32) -> Self {
         self.inner.num_in_auto_buffers = count;
         self
     }
 
     /// Sets the number of auto-select output buffers.
-    pub fn out_auto_buffers(mut self, count: u32) -> Self {
+    pub const fn out_auto_buffers(mut self, count: u32) -> Self {
         self.inner.num_out_auto_buffers = count;
         self
     }
 
     /// Sets the number of mapped input buffers.
-    pub fn in_buffers(mut self, count: u32) -> Self {
+    pub const fn in_buffers(mut self, count: u32) -> Self {
         self.inner.num_in_buffers = count;
         self
     }
 
     /// Sets the number of mapped output buffers.
-    pub fn out_buffers(mut self, count: u32) -> Self {
+    pub const fn out_buffers(mut self, count: u32) -> Self {
         self.inner.num_out_buffers = count;
         self
     }
 
     /// Sets the number of exchange (bidirectional) buffers.
-    pub fn inout_buffers(mut self, count: u32) -> Self {
+    pub const fn inout_buffers(mut self, count: u32) -> Self {
         self.inner.num_inout_buffers = count;
         self
     }
 
     /// Sets the number of input pointer descriptors.
-    pub fn in_pointers(mut self, count: u32) -> Self {
+    pub const fn in_pointers(mut self, count: u32) -> Self {
         self.inner.num_in_pointers = count;
         self
     }
 
     /// Sets the number of output pointer descriptors.
-    pub fn out_pointers(mut self, count: u32) -> Self {
+    pub const fn out_pointers(mut self, count: u32) -> Self {
         self.inner.num_out_pointers = count;
         self
     }
 
     /// Sets the number of fixed-size output pointers.
-    pub fn out_fixed_pointers(mut self, count: u32) -> Self {
+    pub const fn out_fixed_pointers(mut self, count: u32) -> Self {
         self.inner.num_out_fixed_pointers = count;
         self
     }
 
     /// Sets the number of object IDs to pass.
-    pub fn objects(mut self, count: u32) -> Self {
+    pub const fn objects(mut self, count: u32) -> Self {
         self.inner.num_objects = count;
         self
     }
 
     /// Sets the number of handles to copy.
-    pub fn handles(mut self, count: u32) -> Self {
+    pub const fn handles(mut self, count: u32) -> Self {
         self.inner.num_handles = count;
         self
     }
 
     /// Enables sending the process ID.
-    pub fn send_pid(mut self) -> Self {
+    pub const fn send_pid(mut self) -> Self {
         self.inner.send_pid = true;
         self
     }
 
     /// Builds the [`RequestFormat`].
-    pub fn build(self) -> RequestFormat {
+    pub const fn build(self) -> RequestFormat {
         self.inner
     }
 }
 
+/// Precomputed layout of a CMIF request.
+///
+/// Holds everything [`make_request`] derives from a [`RequestFormat`]: the
+/// HIPC header words, the descriptor offsets, the padding before the CMIF
+/// header and the CMIF header itself, for both plain and domain sessions.
+/// [`RequestLayout::new`] is a `const fn`, so a command's layout is computed
+/// at compile time and [`make_request_with_layout`] is reduced to stores:
+///
+/// ```ignore
+/// const LAYOUT: cmif::RequestLayout = cmif::RequestLayout::new(
+///     cmif::RequestFormatBuilder::new(1).data_size(8).build(),
+/// );
+///
+/// let req = unsafe { cmif::make_request_with_layout(ipc_buf, &LAYOUT, None) };
+/// ```
+#[derive(Debug, Clone, Copy)]
+pub struct RequestLayout {
+    fmt: RequestFormat,
+    /// First HIPC header word (message type and descriptor counts).
+    header: u32,
+    /// HIPC special header word, if any.
+    special_header: Option<u32>,
+    copy_handles: Section,
+    send_statics: Section,
+    send_buffers: Section,
+    recv_buffers: Section,
+    exch_buffers: Section,
+    /// Offset of the 16-byte aligned CMIF data start.
+    cmif_offset: usize,
+    session: LayoutVariant,
+    domain: LayoutVariant,
+}
+
+impl RequestLayout {
+    /// Computes the layout of requests with the given format.
+    ///
+    /// The format's object ID is ignored: the domain target is passed to
+    /// [`make_request_with_layout`] on every request.
+    ///
+    /// # Panics
+    ///
+    /// Panics (at compile time in `const` context) if a count does not fit in
+    /// its HIPC header field.
+    pub const fn new(fmt: RequestFormat) -> Self {
+        let num_send_statics = (fmt.num_in_auto_buffers + fmt.num_in_pointers) as usize;
+        let num_send_buffers = (fmt.num_in_auto_buffers + fmt.num_in_buffers) as usize;
+        let num_recv_buffers = (fmt.num_out_auto_buffers + fmt.num_out_buffers) as usize;
+        let num_exch_buffers = fmt.num_inout_buffers as usize;
+        let num_copy_handles = fmt.num_handles as usize;
+        assert!(
+            num_send_statics < 16
+                && num_send_buffers < 16
+                && num_recv_buffers < 16
+                && num_exch_buffers < 16,
+            "too many buffer descriptors"
+        );
+        assert!(num_copy_handles < 16, "too many copy handles");
+
+        let command_type = if fmt.context != 0 {
+            CommandType::RequestWithContext
+        } else {
+            CommandType::Request
+        };
+        let header = command_type as u32
+            | (num_send_statics as u32) << 16
+            | (num_send_buffers as u32) << 20
+            | (num_recv_buffers as u32) << 24
+            | (num_exch_buffers as u32) << 28;
+
+        let has_special_header = fmt.send_pid || num_copy_handles > 0;
+        let mut offset = size_of::<hipc::Header>();
+        let special_header = if has_special_header {
+            offset += size_of::<hipc::SpecialHeader>();
+            if fmt.send_pid {
+                offset += size_of::<u64>();
+            }
+            Some(fmt.send_pid as u32 | (num_copy_handles as u32) << 1)
+        } else {
+            None
+        };
+
+        let copy_handles = Section::next(&mut offset, num_copy_handles, size_of::<RawHandle>());
+        let send_statics = Section::next(
+            &mut offset,
+            num_send_statics,
+            size_of::<hipc::StaticDescriptor>(),
+        );
+        let send_buffers = Section::next(
+            &mut offset,
+            num_send_buffers,
+            size_of::<hipc::BufferDescriptor>(),
+        );
+        let recv_buffers = Section::next(
+            &mut offset,
+            num_recv_buffers,
+            size_of::<hipc::BufferDescriptor>(),
+        );
+        let exch_buffers = Section::next(
+            &mut offset,
+            num_exch_buffers,
+            size_of::<hipc::BufferDescriptor>(),
+        );
+        let cmif_offset = (offset + 0xF) & !0xF;
+
+        Self {
+            fmt,
+            header,
+            special_header,
+            copy_handles,
+            send_statics,
+            send_buffers,
+            recv_buffers,
+            exch_buffers,
+            cmif_offset,
+            session: LayoutVariant::new(&fmt, has_special_header, offset, cmif_offset, false),
+            domain: LayoutVariant::new(&fmt, has_special_header, offset, cmif_offset, true),
+        }
+    }
+
+    /// Returns the format this layout was computed from.
+    pub const fn format(&self) -> &RequestFormat {
+        &self.fmt
+    }
+}
+
+/// The parts of a [`RequestLayout`] that depend on the session being a domain.
+#[derive(Debug, Clone, Copy)]
+struct LayoutVariant {
+    /// Second HIPC header word (data word count, receive static mode, special header flag).
+    header: u32,
+    in_header_offset: usize,
+    in_header: InHeader,
+    data_words: Section,
+    data: Section,
+    objects: Section,
+    out_pointer_sizes: Section,
+    recv_list: Section,
+}
+
+impl LayoutVariant {
+    const fn new(
+        fmt: &RequestFormat,
+        has_special_header: bool,
+        data_words_offset: usize,
+        cmif_offset: usize,
+        is_domain: bool,
+    ) -> Self {
+        // Same computation as `make_request`
+        let mut actual_size = 16; // alignment padding
+        if is_domain {
+            actual_size += size_of::<DomainInHeader>() + fmt.num_objects as usize * 4;
+        }
+        actual_size += size_of::<InHeader>() + fmt.data_size;
+        actual_size = (actual_size + 1) & !1; // half-word align
+
+        let out_pointer_size_table_offset = actual_size;
+        let out_pointer_size_table_size =
+            (fmt.num_out_auto_buffers + fmt.num_out_pointers) as usize;
+        actual_size += 2 * out_pointer_size_table_size;
+
+        let num_data_words = actual_size.div_ceil(4);
+        let num_recv_statics = out_pointer_size_table_size + fmt.num_out_fixed_pointers as usize;
+        assert!(num_data_words < 1024, "too many data words");
+        assert!(num_recv_statics < 16, "too many receive statics");
+
+        let header = num_data_words as u32
+            | (num_recv_statics as u32) << 10
+            | (has_special_header as u32) << 31;
+
+        let in_header_offset = if is_domain {
+            cmif_offset + size_of::<DomainInHeader>()
+        } else {
+            cmif_offset
+        };
+        let data = Section {
+            offset: in_header_offset + size_of::<InHeader>(),
+            len: fmt.data_size,
+        };
+        let objects = if is_domain {
+            Section {
+                offset: data.offset + data.len,
+                len: fmt.num_objects as usize,
+            }
+        } else {
+            Section::EMPTY
+        };
+
+        Self {
+            header,
+            in_header_offset,
+            in_header: InHeader {
+                magic: IN_HEADER_MAGIC,
+                version: if fmt.context != 0 { 1 } else { 0 },
+                command_id: fmt.request_id,
+                token: if is_domain { 0 } else { fmt.context },
+            },
+            data_words: Section {
+                offset: data_words_offset,
+                len: num_data_words,
+            },
+            data,
+            objects,
+            out_pointer_sizes: Section {
+                offset: data_words_offset + out_pointer_size_table_offset,
+                len: out_pointer_size_table_size,
+            },
+            recv_list: Section {
+                offset: data_words_offset + num_data_words * 4,
+                len: num_recv_statics,
+            },
+        }
+    }
+}
+
+/// An array of `len` elements at `offset` bytes from the start of a message.
+#[derive(Debug, Clone, Copy)]
+struct Section {
+    offset: usize,
+    len: usize,
+}
+
+impl Section {
+    const EMPTY: Self = Self { offset: 0, len: 0 };
+
+    /// Returns a section of `len` elements of `size` bytes at `offset`, and advances `offset`.
+    const fn next(offset: &mut usize, len: usize, size: usize) -> Self {
+        let section = Self {
+            offset: *offset,
+            len,
+        };
+        *offset += len * size;
+        section
+    }
+
+    /// Returns the section of the message at `base` as a slice.
+    ///
+    /// # Safety
+    ///
+    /// `base` must point to a message buffer containing the section, suitably aligned for `T`.
+    #[inline]
+    unsafe fn slice<'a, T>(self, base: *mut u8) -> &'a mut [T] {
+        // SAFETY: The caller guarantees the section is within the buffer.
+        unsafe { slice::from_raw_parts_mut(base.add(self.offset).cast::<T>(), self.len) }
+    }
+}
+
 /// Active CMIF request being built.
 ///
 /// Contains mutable slices to all sections of the request for populating.
@@ -780,6 +1311,72 @@ pub struct Response<'a> {
     pub move_handles: &'a [RawHandle],
 }
 
+impl<'a> Response<'a> {
+    /// Reads the payload as a `T`.
+    ///
+    /// The payload is copied out: the message buffer it lives in is overwritten by the
+    /// next IPC call on this thread, which nothing borrowed from it would prevent.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the payload is smaller than `T`.
+    #[inline]
+    pub fn payload<T: Pod>(&self) -> T {
+        pod::read(self.data, 0).expect("response payload does not hold the requested type")
+    }
+
+    /// Reads a `T` from the payload at `offset` bytes.
+    ///
+    /// Returns `None` if the payload does not hold a `T` at `offset`.
+    #[inline]
+    pub fn read<T: Pod>(&self, offset: usize) -> Option<T> {
+        pod::read(self.data, offset)
+    }
+}
+
+/// Parsed incoming CMIF request (for server-side use).
+#[derive(Debug)]
+pub struct ParsedRequest<'a> {
+    /// Underlying HIPC request.
+    pub hipc: hipc::ParsedRequest<'a>,
+    /// Target of a domain request (`None` for non-domain sessions).
+    pub target: Option<DomainTarget>,
+    /// CMIF input header (zeroed for domain close requests).
+    pub header: InHeader,
+    /// Request payload data, including the output pointer size table.
+    pub data: &'a [u8],
+    /// Input domain object IDs.
+    pub in_objects: &'a [u32],
+}
+
+/// Target of a domain request.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct DomainTarget {
+    /// Request type (SendMessage or Close).
+    pub request_type: DomainRequestType,
+    /// Target object ID within domain.
+    pub object_id: ObjectId,
+}
+
+/// Response format descriptor (for server-side use).
+///
+/// Describes a CMIF response to be built with [`make_response`].
+#[derive(Debug, Clone, Copy, Default)]
+pub struct ResponseFormat<'a> {
+    /// Whether the request came from a domain session.
+    pub is_domain: bool,
+    /// Result code (0 = success).
+    pub result: u32,
+    /// Response payload data.
+    pub data: &'a [u8],
+    /// Output domain object IDs.
+    pub objects: &'a [u32],
+    /// Copy handles to send.
+    pub copy_handles: &'a [RawHandle],
+    /// Move handles to send.
+    pub move_handles: &'a [RawHandle],
+}
+
 /// A domain object identifier.
 ///
 /// Identifies a specific service object within a CMIF domain session.
@@ -857,3 +1454,109 @@ impl ObjectId {
         self.0
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Size of the message buffers, past the largest generated message.
+    const MESSAGE_SIZE: usize = 0x400;
+
+    /// Stand-in for the TLS IPC buffer, with its alignment.
+    #[repr(C, align(16))]
+    struct MessageBuffer([u8; MESSAGE_SIZE]);
+
+    /// Xorshift generator, so that a failure reproduces.
+    struct Rng(u64);
+
+    impl Rng {
+        fn next(&mut self) -> u64 {
+            self.0 ^= self.0 << 13;
+            self.0 ^= self.0 >> 7;
+            self.0 ^= self.0 << 17;
+            self.0
+        }
+
+        /// Returns a value in `0..n`.
+        fn below(&mut self, n: u32) -> u32 {
+            (self.next() % u64::from(n)) as u32
+        }
+    }
+
+    /// Returns a random format, with every count within its HIPC header field.
+    fn random_format(rng: &mut Rng) -> RequestFormat {
+        let mut builder = RequestFormatBuilder::new(rng.next() as u32)
+            .data_size(rng.below(0x41) as usize)
+            .server_pointer_size(rng.below(0x1000) as usize)
+            .in_auto_buffers(rng.below(4))
+            .out_auto_buffers(rng.below(4))
+            .in_buffers(rng.below(4))
+            .out_buffers(rng.below(4))
+            .inout_buffers(rng.below(4))
+            .in_pointers(rng.below(4))
+            .out_pointers(rng.below(4))
+            .out_fixed_pointers(rng.below(4))
+            .objects(rng.below(4))
+            .handles(rng.below(4));
+        if rng.below(2) == 0 {
+            builder = builder.context(rng.next() as u32 | 1);
+        }
+        if rng.below(2) == 0 {
+            builder = builder.send_pid();
+        }
+        builder.build()
+    }
+
+    /// Returns the offset and length of `section` in the message at `base`.
+    fn span<T>(base: &MessageBuffer, section: &[T]) -> (usize, usize) {
+        let offset = section.as_ptr() as usize - base.0.as_ptr() as usize;
+        (offset, section.len())
+    }
+
+    /// Returns the spans of every section of `req`, and its pointer buffer space.
+    fn sections(base: &MessageBuffer, req: &Request<'_>) -> [(usize, usize); 11] {
+        let hipc = &req.hipc;
+        [
+            span(base, hipc.send_statics),
+            span(base, hipc.send_buffers),
+            span(base, hipc.recv_buffers),
+            span(base, hipc.exch_buffers),
+            span(base, hipc.data_words),
+            span(base, hipc.recv_list),
+            span(base, hipc.copy_handles),
+            span(base, req.data),
+            span(base, req.out_pointer_sizes),
+            span(base, req.objects),
+            (req.server_pointer_size, 0),
+        ]
+    }
+
+    #[test]
+    fn test_make_request_with_layout_matches_make_request() {
+        let mut rng = Rng(0x9E37_79B9_7F4A_7C15);
+
+        for _ in 0..10_000 {
+            let mut fmt = random_format(&mut rng);
+            let layout = RequestLayout::new(fmt);
+            let object_id = ObjectId::new(rng.below(3));
+            fmt.object_id = object_id;
+
+            // Garbage outside of the written words must be left as is by both
+            let fill = rng.next() as u8;
+            let mut expected = MessageBuffer([fill; MESSAGE_SIZE]);
+            let mut actual = MessageBuffer([fill; MESSAGE_SIZE]);
+
+            // SAFETY: Both buffers are message-sized and aligned as the TLS IPC buffer.
+            let expected_req = unsafe { make_request(NonNull::from(&mut expected).cast(), fmt) };
+            let expected_sections = sections(&expected, &expected_req);
+            // SAFETY: See above.
+            let actual_req = unsafe {
+                make_request_with_layout(NonNull::from(&mut actual).cast(), &layout, object_id)
+            };
+            let actual_sections = sections(&actual, &actual_req);
+
+            assert_eq!(actual_sections, expected_sections, "{fmt:?}");
+            assert!(actual.0 == expected.0, "{fmt:?}");
+        }
+    }
+}
@@ -253,6 +253,46 @@ pub unsafe extern "C" fn __nx_sf__service_get_object_id(s: *const Service) -> u3
     unsafe { (*s).object_id }
 }
 
+/// Writes the latency histograms of the traced commands with the most total ticks to `out`,
+/// most first.
+///
+/// Returns the number of traced commands, which may exceed `capacity`. With a null `out`,
+/// only the count is returned.
+///
+/// # Safety
+///
+/// `out` must be null or valid for writes of `capacity` [`CommandStats`].
+///
+/// [`CommandStats`]: crate::trace::CommandStats
+#[cfg(feature = "trace")]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sf__trace_dump(
+    out: *mut crate::trace::CommandStats,
+    capacity: usize,
+) -> usize {
+    if out.is_null() {
+        return crate::trace::snapshot(&mut []);
+    }
+
+    // SAFETY: Caller guarantees out is valid for capacity elements.
+    let out = unsafe { core::slice::from_raw_parts_mut(out, capacity) };
+    crate::trace::snapshot(out)
+}
+
+/// Returns the number of requests lost because the command table was full.
+#[cfg(feature = "trace")]
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_sf__trace_dropped() -> u64 {
+    crate::trace::dropped()
+}
+
+/// Clears the command table.
+#[cfg(feature = "trace")]
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_sf__trace_reset() {
+    crate::trace::reset();
+}
+
 /// Converts a clone object error to a raw result code for FFI.
 fn clone_error_to_rc(err: CloneObjectError) -> u32 {
     match err {
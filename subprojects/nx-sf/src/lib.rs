@@ -32,6 +32,8 @@
 //!   Uses `"SFCI"`/`"SFCO"` magic headers. See the [`cmif`] module for details.
 //! - **TIPC**: Simplified protocol introduced in HOS 12.0.0. No domains,
 //!   command ID stored in HIPC message type. See the [`tipc`] module for details.
+//! - **Light IPC**: Seven-word messages passed in registers, without HIPC framing.
+//!   See the [`light`] module for details.
 
 #![no_std]
 
@@ -39,10 +41,17 @@ extern crate nx_panic_handler; // Provides #[panic_handler]
 
 pub mod cmif;
 pub mod hipc;
+pub mod light;
+mod pod;
+pub mod pool;
+pub mod server;
 pub mod service;
 mod service_name;
 pub mod tipc;
+#[cfg(feature = "trace")]
+pub mod trace;
 
+pub use pod::Pod;
 pub use service_name::ServiceName;
 
 #[cfg(feature = "ffi")]
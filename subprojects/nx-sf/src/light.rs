@@ -0,0 +1,156 @@
+//! Light IPC sessions.
+//!
+//! A light session carries messages of seven 32-bit words in registers, rather than in the
+//! TLS buffer: a request and its reply skip the HIPC framing, the descriptors and the
+//! copies through the TLS buffer of both threads. This suits hot, small calls between
+//! system processes, such as queries of a sysmodule by a privileged client.
+//!
+//! # Message Format
+//!
+//! ```text
+//! Request: [command id] [payload: 6 words]
+//! Reply:   [reply flag | result code] [payload: 6 words]
+//! ```
+//!
+//! Light messages hold neither buffers nor handles: anything larger than the payload must
+//! go through a regular session.
+
+use nx_svc::ipc::{
+    self, Handle as SessionHandle, LIGHT_MESSAGE_WORDS, LIGHT_REPLY_FLAG, LightMessage,
+    ReplyAndReceiveLightError, SendSyncLightError,
+};
+
+/// Number of payload words of a light request or reply.
+pub const PAYLOAD_WORDS: usize = LIGHT_MESSAGE_WORDS - 1;
+
+/// Payload of a light request or reply.
+pub type LightPayload = [u32; PAYLOAD_WORDS];
+
+/// Client side of a light session.
+#[derive(Debug, Clone, Copy)]
+pub struct LightClient {
+    session: SessionHandle,
+}
+
+impl LightClient {
+    /// Wraps the client side of a light session.
+    #[inline]
+    pub fn new(session: SessionHandle) -> Self {
+        Self { session }
+    }
+
+    /// Returns the session handle.
+    #[inline]
+    pub fn session(&self) -> SessionHandle {
+        self.session
+    }
+
+    /// Sends the `command` request with `payload`, and returns the reply payload.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `command` has the reply flag (bit 31) set.
+    pub fn call(
+        &self,
+        command: u32,
+        payload: LightPayload,
+    ) -> Result<LightPayload, LightCallError> {
+        assert_eq!(command & LIGHT_REPLY_FLAG, 0, "invalid light command id");
+
+        let mut msg = join(command, payload);
+        ipc::send_sync_request_light(self.session, &mut msg)
+            .map_err(LightCallError::SendRequest)?;
+
+        // The kernel copies the reply words as the server wrote them, reply flag included
+        let (head, payload) = split(&msg);
+        let rc = head & !LIGHT_REPLY_FLAG;
+        if rc != 0 {
+            return Err(LightCallError::ServiceError(rc));
+        }
+        Ok(payload)
+    }
+
+    /// Closes the session.
+    pub fn close(self) {
+        let _ = ipc::close_handle(self.session);
+    }
+}
+
+/// Server side of a light session.
+#[derive(Debug)]
+pub struct LightServer {
+    session: SessionHandle,
+}
+
+impl LightServer {
+    /// Wraps the server side of a light session.
+    #[inline]
+    pub fn new(session: SessionHandle) -> Self {
+        Self { session }
+    }
+
+    /// Returns the session handle.
+    #[inline]
+    pub fn session(&self) -> SessionHandle {
+        self.session
+    }
+
+    /// Serves requests until the client closes the session.
+    ///
+    /// `handler` receives the command id and payload of every request, and returns the
+    /// reply payload, or the result code of the failed request. Each reply is sent in the
+    /// same call that waits for the next request.
+    pub fn serve<F>(&self, mut handler: F) -> Result<(), ReplyAndReceiveLightError>
+    where
+        F: FnMut(u32, LightPayload) -> Result<LightPayload, u32>,
+    {
+        // The reply flag is clear: the first call only receives
+        let mut msg: LightMessage = [0; LIGHT_MESSAGE_WORDS];
+        loop {
+            match ipc::reply_and_receive_light(self.session, &mut msg) {
+                Ok(()) => {}
+                Err(ReplyAndReceiveLightError::SessionClosed) => return Ok(()),
+                Err(err) => return Err(err),
+            }
+
+            let (command, payload) = split(&msg);
+            let (rc, payload) = match handler(command, payload) {
+                Ok(payload) => (0, payload),
+                Err(rc) => (rc, [0; PAYLOAD_WORDS]),
+            };
+            debug_assert_eq!(rc & LIGHT_REPLY_FLAG, 0, "invalid light result code");
+            msg = join(rc | LIGHT_REPLY_FLAG, payload);
+        }
+    }
+
+    /// Closes the session.
+    pub fn close(self) {
+        let _ = ipc::close_handle(self.session);
+    }
+}
+
+#[inline]
+fn join(head: u32, payload: LightPayload) -> LightMessage {
+    let mut msg = [0; LIGHT_MESSAGE_WORDS];
+    msg[0] = head;
+    msg[1..].copy_from_slice(&payload);
+    msg
+}
+
+#[inline]
+fn split(msg: &LightMessage) -> (u32, LightPayload) {
+    let mut payload = [0; PAYLOAD_WORDS];
+    payload.copy_from_slice(&msg[1..]);
+    (msg[0], payload)
+}
+
+/// Error returned by [`LightClient::call`].
+#[derive(Debug, thiserror::Error)]
+pub enum LightCallError {
+    /// Sending the request failed.
+    #[error("failed to send light request")]
+    SendRequest(#[source] SendSyncLightError),
+    /// Service returned a non-zero result code.
+    #[error("service error: {0:#x}")]
+    ServiceError(u32),
+}
@@ -0,0 +1,44 @@
+//! Plain-old-data types for IPC payloads.
+//!
+//! IPC payloads and buffers are raw bytes. Types implementing [`Pod`] can be
+//! read from a response, or handed to a service as a buffer it reads from or
+//! writes into, without going through an intermediate byte array.
+
+use core::{mem::size_of, ptr};
+
+/// A type that can be treated as raw bytes in an IPC message.
+///
+/// # Safety
+///
+/// Every bit pattern must be a valid value of the type, and the type must not
+/// contain padding bytes, interior mutability or pointers to be dereferenced.
+/// `#[repr(C)]` structs made only of [`Pod`] fields and without padding
+/// qualify.
+pub unsafe trait Pod: Copy + 'static {}
+
+macro_rules! impl_pod {
+    ($($ty:ty),* $(,)?) => {
+        $(
+            // SAFETY: Primitive integers accept every bit pattern and have no padding.
+            unsafe impl Pod for $ty {}
+        )*
+    };
+}
+
+impl_pod!(
+    u8, u16, u32, u64, u128, usize, i8, i16, i32, i64, i128, isize
+);
+
+// SAFETY: Arrays of `Pod` elements have no padding between elements.
+unsafe impl<T: Pod, const N: usize> Pod for [T; N] {}
+
+/// Reads a `T` from `bytes` at `offset`, which does not need to be aligned.
+///
+/// Returns `None` if `bytes` does not hold a `T` at `offset`.
+#[inline]
+pub(crate) fn read<T: Pod>(bytes: &[u8], offset: usize) -> Option<T> {
+    let bytes = bytes.get(offset..offset.checked_add(size_of::<T>())?)?;
+
+    // SAFETY: The bytes are in bounds, and any bit pattern is a valid `T`.
+    Some(unsafe { ptr::read_unaligned(bytes.as_ptr().cast::<T>()) })
+}
@@ -0,0 +1,206 @@
+//! Domain-backed session pool.
+//!
+//! A [`SessionPool`] spreads the commands of several threads over a small set
+//! of sessions to the same service, so heavy use of one service does not queue
+//! up behind a single session handle. The sessions are clones of the original
+//! one (`CloneCurrentObjectEx`), each converted to a domain once, so the
+//! subservices opened through the pool share the pool's sessions instead of
+//! taking a session each.
+//!
+//! ```ignore
+//! let pool = SessionPool::<4>::new(service, 4, 0)?;
+//!
+//! // Any thread: commands go to the least busy session
+//! let session = pool.acquire();
+//! let result = session.dispatch(cmd_id).out_objects(1).send()?;
+//! let object = session.adopt_object(result.objects[0]).unwrap();
+//! object.dispatch(sub_cmd_id).send()?;
+//! ```
+//!
+//! Domain object IDs are allocated by the server, which reuses the IDs of closed
+//! objects. A [`DomainObject`] closes its ID when dropped, so a long-lived pool
+//! does not grow its domains' object tables.
+
+use core::{
+    ops::Deref,
+    sync::atomic::{AtomicU32, Ordering},
+};
+
+use crate::{
+    cmif::ObjectId,
+    service::{Service, ServiceConvertToDomainError, TryCloneExError},
+};
+
+/// A pool of up to `N` domain sessions to one service.
+#[derive(Debug)]
+pub struct SessionPool<const N: usize> {
+    sessions: [Service; N],
+    len: usize,
+    /// Number of callers currently holding each session.
+    in_flight: [AtomicU32; N],
+    /// Number of live domain objects on each session.
+    objects: [AtomicU32; N],
+}
+
+impl<const N: usize> SessionPool<N> {
+    /// Creates a pool of `count` sessions from `service`.
+    ///
+    /// `service` becomes the first session of the pool; the others are cloned
+    /// from it with `tag`. Every session is then converted to a domain. On
+    /// failure, all sessions, including `service`, are closed.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `count` is zero or greater than `N`, or if `service` is not a
+    /// plain (non-domain) session owning its handle.
+    pub fn new(service: Service, count: usize, tag: u32) -> Result<Self, SessionPoolError> {
+        assert!(count > 0 && count <= N, "invalid session count");
+        assert!(
+            service.own_handle != 0 && service.object_id == 0,
+            "session pools need a plain session"
+        );
+
+        let mut pool = Self {
+            sessions: [service; N],
+            len: 1,
+            in_flight: [const { AtomicU32::new(0) }; N],
+            objects: [const { AtomicU32::new(0) }; N],
+        };
+
+        // Clone before converting, so every clone is a session of its own
+        while pool.len < count {
+            // On error, dropping the pool closes the sessions created so far
+            pool.sessions[pool.len] = service.try_clone_ex(tag)?;
+            pool.len += 1;
+        }
+        for session in &mut pool.sessions[..count] {
+            session.convert_to_domain()?;
+        }
+
+        Ok(pool)
+    }
+
+    /// Returns the number of sessions in the pool.
+    #[inline]
+    pub fn num_sessions(&self) -> usize {
+        self.len
+    }
+
+    /// Returns the least busy session of the pool.
+    ///
+    /// Never blocks: when every session is in use, the least loaded one is
+    /// shared and the kernel queues the requests on it.
+    pub fn acquire(&self) -> PooledSession<'_, N> {
+        let mut index = 0;
+        let mut best = u32::MAX;
+        for (i, in_flight) in self.in_flight[..self.len].iter().enumerate() {
+            let load = in_flight.load(Ordering::Relaxed);
+            if load < best {
+                index = i;
+                best = load;
+                if load == 0 {
+                    break;
+                }
+            }
+        }
+        self.in_flight[index].fetch_add(1, Ordering::Relaxed);
+
+        PooledSession { pool: self, index }
+    }
+
+    /// Returns the number of live domain objects adopted by the pool.
+    pub fn num_objects(&self) -> usize {
+        self.objects[..self.len]
+            .iter()
+            .map(|objects| objects.load(Ordering::Relaxed) as usize)
+            .sum()
+    }
+}
+
+impl<const N: usize> Drop for SessionPool<N> {
+    fn drop(&mut self) {
+        for session in &self.sessions[..self.len] {
+            session.close();
+        }
+    }
+}
+
+/// Error returned by [`SessionPool::new`].
+#[derive(Debug, thiserror::Error)]
+pub enum SessionPoolError {
+    /// Failed to clone the service session.
+    #[error("failed to clone pool session")]
+    Clone(#[from] TryCloneExError),
+    /// Failed to convert a session to a domain.
+    #[error("failed to convert pool session to domain")]
+    ConvertToDomain(#[from] ServiceConvertToDomainError),
+}
+
+/// A session borrowed from a [`SessionPool`].
+///
+/// Dereferences to the session's domain root [`Service`].
+#[derive(Debug)]
+pub struct PooledSession<'p, const N: usize> {
+    pool: &'p SessionPool<N>,
+    index: usize,
+}
+
+impl<'p, const N: usize> PooledSession<'p, N> {
+    /// Takes ownership of a domain object returned by a command sent on this
+    /// session.
+    ///
+    /// Returns `None` if `raw` is not a valid object ID.
+    pub fn adopt_object(&self, raw: u32) -> Option<DomainObject<'p, N>> {
+        let object_id = ObjectId::new(raw)?;
+        self.pool.objects[self.index].fetch_add(1, Ordering::Relaxed);
+
+        Some(DomainObject {
+            pool: self.pool,
+            index: self.index,
+            service: Service::new_domain_subservice(&self.pool.sessions[self.index], object_id),
+        })
+    }
+}
+
+impl<const N: usize> Deref for PooledSession<'_, N> {
+    type Target = Service;
+
+    #[inline]
+    fn deref(&self) -> &Service {
+        &self.pool.sessions[self.index]
+    }
+}
+
+impl<const N: usize> Drop for PooledSession<'_, N> {
+    fn drop(&mut self) {
+        self.pool.in_flight[self.index].fetch_sub(1, Ordering::Relaxed);
+    }
+}
+
+/// A domain object living on one of the sessions of a [`SessionPool`].
+///
+/// Dereferences to the object's domain subservice, and closes the object when
+/// dropped. Commands to the object always go through the session it was
+/// opened on.
+#[derive(Debug)]
+pub struct DomainObject<'p, const N: usize> {
+    pool: &'p SessionPool<N>,
+    index: usize,
+    service: Service,
+}
+
+impl<const N: usize> Deref for DomainObject<'_, N> {
+    type Target = Service;
+
+    #[inline]
+    fn deref(&self) -> &Service {
+        &self.service
+    }
+}
+
+impl<const N: usize> Drop for DomainObject<'_, N> {
+    fn drop(&mut self) {
+        self.service.close();
+        self.pool.objects[self.index].fetch_sub(1, Ordering::Relaxed);
+    }
+}
@@ -0,0 +1,920 @@
+//! Server-side CMIF session management and dispatch.
+//!
+//! A [`ServerManager`] serves a table of sessions, and optionally the port they connect
+//! through, from a single loop: every request is answered by the same
+//! `ReplyAndReceive` call that waits for the next one, on all the sessions and the port at
+//! once.
+//!
+//! Requests are dispatched to [`ServiceObject`]s, usually through a [`CommandTable`]: a
+//! sorted table of command handlers, checked when it is built in a constant, and looked up
+//! by index when its command IDs are dense.
+//!
+//! ```ignore
+//! struct Counter(u64);
+//!
+//! impl Counter {
+//!     fn get(&mut self, _: &mut Request<'_>, reply: &mut Reply<Self>) -> Result<(), u32> {
+//!         reply.set_data(&self.0);
+//!         Ok(())
+//!     }
+//!
+//!     fn add(&mut self, request: &mut Request<'_>, _: &mut Reply<Self>) -> Result<(), u32> {
+//!         self.0 += request.read::<u64>(0).ok_or(RESULT_INVALID_HEADER_SIZE)?;
+//!         Ok(())
+//!     }
+//! }
+//!
+//! impl ServiceObject for Counter {
+//!     fn dispatch(&mut self, request: &mut Request<'_>, reply: &mut Reply<Self>) -> Result<(), u32> {
+//!         const COMMANDS: CommandTable<Counter> =
+//!             CommandTable::new(&[Command::new(0, Counter::get), Command::new(1, Counter::add)]);
+//!         COMMANDS.dispatch(self, request, reply)
+//!     }
+//! }
+//!
+//! let mut server = ServerManager::<Counter, 16, 32>::new();
+//! server.register_port(port, || Counter(0));
+//! server.serve()?;
+//! ```
+//!
+//! # Domains
+//!
+//! Sessions converted to domains keep their objects in the domain object table of the
+//! manager, shared by all its sessions. Objects returned by a command become domain
+//! objects on domain sessions, and new sessions otherwise.
+//!
+//! # Worker Threads
+//!
+//! Several threads can serve the same port, each with its own manager: a new connection
+//! is accepted by whichever worker gets to it first, and its session is then served by
+//! that worker only.
+//!
+//! # Limitations
+//!
+//! The server has no pointer buffer: clients fall back to mapped buffers for auto-select
+//! buffers, and requests with pointer (type X) buffers are rejected.
+
+use core::{
+    mem::{self, size_of},
+    ptr, slice,
+};
+
+use nx_svc::{
+    error::ToRawResultCode,
+    ipc::{self, Handle as SessionHandle, ReplyAndReceiveError},
+    raw::{Handle as RawHandle, INVALID_HANDLE},
+    result::ResultCode,
+    sync::MAX_WAIT_HANDLES,
+};
+
+use crate::{
+    cmif::{self, CommandType, DomainRequestType, ParseRequestError, ResponseFormat},
+    hipc::{self, BufferDescriptor},
+    pod::{self, Pod},
+};
+
+// Control request IDs for CMIF session management.
+const CTRL_CONVERT_TO_DOMAIN: u32 = 0;
+const CTRL_COPY_FROM_DOMAIN: u32 = 1;
+const CTRL_CLONE_OBJECT: u32 = 2;
+const CTRL_QUERY_POINTER_BUFFER_SIZE: u32 = 3;
+const CTRL_CLONE_OBJECT_EX: u32 = 4;
+
+/// Maximum size of the output data of a command.
+pub const MAX_OUT_DATA: usize = 0x80;
+
+/// Maximum number of copy handles, and of move handles, returned by a command.
+pub const MAX_OUT_HANDLES: usize = 4;
+
+/// Maximum number of objects returned by a command.
+pub const MAX_OUT_OBJECTS: usize = 4;
+
+/// Service Framework result module.
+const MODULE_SF: u32 = 10;
+
+/// Builds a Service Framework result code.
+const fn sf_result(description: u32) -> ResultCode {
+    MODULE_SF | (description << 9)
+}
+
+/// The request is not supported by the server or the target object.
+pub const RESULT_NOT_SUPPORTED: ResultCode = sf_result(1);
+
+/// The request data is too small for its headers or arguments.
+pub const RESULT_INVALID_HEADER_SIZE: ResultCode = sf_result(202);
+
+/// The request has an invalid CMIF or domain header.
+pub const RESULT_INVALID_IN_HEADER: ResultCode = sf_result(211);
+
+/// The command ID is not handled by the target object.
+pub const RESULT_UNKNOWN_COMMAND_ID: ResultCode = sf_result(221);
+
+/// The domain object targeted by the request does not exist.
+pub const RESULT_TARGET_NOT_FOUND: ResultCode = sf_result(261);
+
+/// The domain object table, or the session table, is full.
+pub const RESULT_OUT_OF_DOMAIN_ENTRIES: ResultCode = sf_result(301);
+
+/// A service object, serving the requests of a session or a domain object.
+pub trait ServiceObject: Sized {
+    /// Handles a request to the object, staging its output in `reply`.
+    ///
+    /// On error, the returned result code is sent to the client, and the staged output is
+    /// discarded: its move handles are closed and its objects dropped.
+    fn dispatch(
+        &mut self,
+        request: &mut Request<'_>,
+        reply: &mut Reply<Self>,
+    ) -> Result<(), ResultCode>;
+
+    /// Returns a copy of the object, to serve a cloned session.
+    ///
+    /// By default, objects cannot be cloned.
+    fn try_clone(&self) -> Option<Self> {
+        None
+    }
+}
+
+/// A command handler of a service object of type `S`.
+pub type CommandHandler<S> = fn(&mut S, &mut Request<'_>, &mut Reply<S>) -> Result<(), ResultCode>;
+
+/// A command ID and its handler.
+pub struct Command<S> {
+    id: u32,
+    handler: CommandHandler<S>,
+}
+
+impl<S> Command<S> {
+    /// Creates the command `id`, handled by `handler`.
+    #[inline]
+    pub const fn new(id: u32, handler: CommandHandler<S>) -> Self {
+        Self { id, handler }
+    }
+}
+
+/// A table of the commands of a service object, sorted by ID.
+pub struct CommandTable<S: 'static> {
+    commands: &'static [Command<S>],
+    /// Whether the command IDs are `0..commands.len()`, looked up by index.
+    dense: bool,
+}
+
+impl<S> CommandTable<S> {
+    /// Creates a table of `commands`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the command IDs are not strictly increasing. Built in a constant, the
+    /// table is checked at compile time.
+    pub const fn new(commands: &'static [Command<S>]) -> Self {
+        let mut i = 1;
+        while i < commands.len() {
+            assert!(
+                commands[i - 1].id < commands[i].id,
+                "command IDs must be strictly increasing"
+            );
+            i += 1;
+        }
+
+        // Strictly increasing IDs ending at `len - 1` are exactly `0..len`
+        let dense = match commands.last() {
+            Some(last) => last.id as usize == commands.len() - 1,
+            None => true,
+        };
+        Self { commands, dense }
+    }
+
+    /// Dispatches `request` to the handler of its command ID.
+    ///
+    /// Returns [`RESULT_UNKNOWN_COMMAND_ID`] if no command of the table has the ID.
+    pub fn dispatch(
+        &self,
+        object: &mut S,
+        request: &mut Request<'_>,
+        reply: &mut Reply<S>,
+    ) -> Result<(), ResultCode> {
+        let id = request.command_id();
+        let command = if self.dense {
+            self.commands.get(id as usize)
+        } else {
+            self.commands
+                .binary_search_by_key(&id, |command| command.id)
+                .ok()
+                .map(|index| &self.commands[index])
+        };
+
+        match command {
+            Some(command) => (command.handler)(object, request, reply),
+            None => Err(RESULT_UNKNOWN_COMMAND_ID),
+        }
+    }
+}
+
+/// An incoming request being dispatched, in place in the TLS buffer.
+#[derive(Debug)]
+pub struct Request<'a> {
+    command_id: u32,
+    token: u32,
+    pid: Option<u64>,
+    data: &'a [u8],
+    in_objects: &'a [u32],
+    copy_handles: &'a [RawHandle],
+    move_handles: &'a [RawHandle],
+    send_buffers: &'a [BufferDescriptor],
+    recv_buffers: &'a [BufferDescriptor],
+    exch_buffers: &'a [BufferDescriptor],
+}
+
+impl<'a> Request<'a> {
+    fn new(req: cmif::ParsedRequest<'a>) -> Self {
+        let hipc::Request {
+            send_buffers,
+            recv_buffers,
+            exch_buffers,
+            copy_handles,
+            move_handles,
+            ..
+        } = req.hipc.data;
+
+        Self {
+            command_id: req.header.command_id,
+            token: req.header.token,
+            pid: req.hipc.meta.send_pid.then_some(req.hipc.pid),
+            data: req.data,
+            in_objects: req.in_objects,
+            copy_handles,
+            move_handles,
+            send_buffers,
+            recv_buffers,
+            exch_buffers,
+        }
+    }
+
+    /// Returns the command ID.
+    #[inline]
+    pub fn command_id(&self) -> u32 {
+        self.command_id
+    }
+
+    /// Returns the context token of the request.
+    #[inline]
+    pub fn token(&self) -> u32 {
+        self.token
+    }
+
+    /// Returns the process ID of the client, if it sent it.
+    #[inline]
+    pub fn pid(&self) -> Option<u64> {
+        self.pid
+    }
+
+    /// Returns the raw input data, followed by the output pointer size table.
+    #[inline]
+    pub fn data(&self) -> &'a [u8] {
+        self.data
+    }
+
+    /// Reads a `T` from the input data at `offset` bytes.
+    ///
+    /// Returns `None` if the input data does not hold a `T` at `offset`.
+    #[inline]
+    pub fn read<T: Pod>(&self, offset: usize) -> Option<T> {
+        pod::read(self.data, offset)
+    }
+
+    /// Returns the input domain object IDs.
+    #[inline]
+    pub fn in_objects(&self) -> &'a [u32] {
+        self.in_objects
+    }
+
+    /// Returns the copy handles sent by the client.
+    #[inline]
+    pub fn copy_handles(&self) -> &'a [RawHandle] {
+        self.copy_handles
+    }
+
+    /// Returns the move handles sent by the client, now owned by the server.
+    #[inline]
+    pub fn move_handles(&self) -> &'a [RawHandle] {
+        self.move_handles
+    }
+
+    /// Returns the input (type A) buffer `index`, mapped for the request.
+    pub fn in_buffer(&self, index: usize) -> Option<&'a [u8]> {
+        let desc = self.send_buffers.get(index)?;
+        // SAFETY: The kernel maps the client buffer into the server for the lifetime of
+        // the request, and the server does not write to input buffers.
+        Some(unsafe { buffer(desc) })
+    }
+
+    /// Returns the output (type B) buffer `index`, mapped for the request.
+    pub fn out_buffer(&mut self, index: usize) -> Option<&mut [u8]> {
+        let desc = self.recv_buffers.get(index)?;
+        // SAFETY: The kernel maps the client buffer into the server for the lifetime of
+        // the request, and the mutable borrow of the request prevents aliasing it.
+        Some(unsafe { buffer_mut(desc) })
+    }
+
+    /// Returns the exchange (type W) buffer `index`, mapped for the request.
+    pub fn inout_buffer(&mut self, index: usize) -> Option<&mut [u8]> {
+        let desc = self.exch_buffers.get(index)?;
+        // SAFETY: The kernel maps the client buffer into the server for the lifetime of
+        // the request, and the mutable borrow of the request prevents aliasing it.
+        Some(unsafe { buffer_mut(desc) })
+    }
+}
+
+/// Returns the memory of a mapped buffer descriptor.
+///
+/// # Safety
+///
+/// The buffer must be mapped for the lifetime `'a`, and not written to during it.
+unsafe fn buffer<'a>(desc: &BufferDescriptor) -> &'a [u8] {
+    match desc.size() {
+        0 => &[],
+        // SAFETY: Caller guarantees the buffer is mapped and not written to.
+        size => unsafe { slice::from_raw_parts(desc.address() as *const u8, size) },
+    }
+}
+
+/// Returns the memory of a mapped buffer descriptor, for writing.
+///
+/// # Safety
+///
+/// The buffer must be mapped for the lifetime `'a`, and not otherwise accessed during it.
+unsafe fn buffer_mut<'a>(desc: &BufferDescriptor) -> &'a mut [u8] {
+    match desc.size() {
+        0 => &mut [],
+        // SAFETY: Caller guarantees the buffer is mapped and not otherwise accessed.
+        size => unsafe { slice::from_raw_parts_mut(desc.address() as *mut u8, size) },
+    }
+}
+
+/// The output of a command, staged until the request is answered.
+pub struct Reply<S> {
+    data: [u32; MAX_OUT_DATA / 4],
+    data_len: usize,
+    copy_handles: [RawHandle; MAX_OUT_HANDLES],
+    num_copy_handles: usize,
+    move_handles: [RawHandle; MAX_OUT_HANDLES],
+    num_move_handles: usize,
+    objects: [Option<S>; MAX_OUT_OBJECTS],
+    num_objects: usize,
+    /// IDs of the objects registered as domain objects.
+    domain_objects: [u32; MAX_OUT_OBJECTS],
+    num_domain_objects: usize,
+}
+
+impl<S> Reply<S> {
+    fn new() -> Self {
+        Self {
+            data: [0; MAX_OUT_DATA / 4],
+            data_len: 0,
+            copy_handles: [INVALID_HANDLE; MAX_OUT_HANDLES],
+            num_copy_handles: 0,
+            move_handles: [INVALID_HANDLE; MAX_OUT_HANDLES],
+            num_move_handles: 0,
+            objects: [const { None }; MAX_OUT_OBJECTS],
+            num_objects: 0,
+            domain_objects: [0; MAX_OUT_OBJECTS],
+            num_domain_objects: 0,
+        }
+    }
+
+    /// Sets the output data to the bytes of `value`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `T` is larger than [`MAX_OUT_DATA`].
+    pub fn set_data<T: Pod>(&mut self, value: &T) {
+        assert!(size_of::<T>() <= MAX_OUT_DATA, "reply data too large");
+        // SAFETY: `Pod` values have no padding, so all of their bytes are initialized, and
+        // the staging buffer holds at least `size_of::<T>()` bytes.
+        unsafe {
+            ptr::copy_nonoverlapping(
+                ptr::from_ref(value).cast::<u8>(),
+                self.data.as_mut_ptr().cast::<u8>(),
+                size_of::<T>(),
+            );
+        }
+        self.data_len = size_of::<T>();
+    }
+
+    /// Sends a copy of `handle`; the server keeps its own.
+    ///
+    /// # Panics
+    ///
+    /// Panics if more than [`MAX_OUT_HANDLES`] copy handles are sent.
+    pub fn copy_handle(&mut self, handle: RawHandle) {
+        assert!(
+            self.num_copy_handles < MAX_OUT_HANDLES,
+            "too many reply copy handles"
+        );
+        self.copy_handles[self.num_copy_handles] = handle;
+        self.num_copy_handles += 1;
+    }
+
+    /// Moves `handle` to the client.
+    ///
+    /// # Panics
+    ///
+    /// Panics if more than [`MAX_OUT_HANDLES`] move handles are sent.
+    pub fn move_handle(&mut self, handle: RawHandle) {
+        assert!(
+            self.num_move_handles < MAX_OUT_HANDLES,
+            "too many reply move handles"
+        );
+        self.move_handles[self.num_move_handles] = handle;
+        self.num_move_handles += 1;
+    }
+
+    /// Returns `object` to the client, as a domain object or a new session.
+    ///
+    /// # Panics
+    ///
+    /// Panics if more than [`MAX_OUT_OBJECTS`] objects are returned.
+    pub fn object(&mut self, object: S) {
+        assert!(self.num_objects < MAX_OUT_OBJECTS, "too many reply objects");
+        self.objects[self.num_objects] = Some(object);
+        self.num_objects += 1;
+    }
+
+    #[inline]
+    fn data(&self) -> &[u8] {
+        // SAFETY: The staging buffer holds at least `data_len` initialized bytes.
+        unsafe { slice::from_raw_parts(self.data.as_ptr().cast::<u8>(), self.data_len) }
+    }
+
+    /// Closes the staged move handles.
+    fn discard(&mut self) {
+        for &handle in &self.move_handles[..self.num_move_handles] {
+            close_raw(handle);
+        }
+        self.num_move_handles = 0;
+    }
+}
+
+/// Object served by a session.
+enum SessionObject<S> {
+    /// A plain session, serving one object.
+    Plain(S),
+    /// A domain session, serving the domain objects it owns.
+    Domain,
+}
+
+struct Session<S> {
+    handle: SessionHandle,
+    object: SessionObject<S>,
+}
+
+struct DomainEntry<S> {
+    /// Slot of the domain session owning the object.
+    session: usize,
+    object: S,
+}
+
+/// Where a wait list index points to.
+#[derive(Clone, Copy)]
+enum WaitTarget {
+    Port,
+    Session(usize),
+}
+
+/// A server serving up to `SESSIONS` sessions and `DOMAIN_OBJECTS` domain objects of type
+/// `S`, from one thread.
+pub struct ServerManager<S, const SESSIONS: usize, const DOMAIN_OBJECTS: usize = 0> {
+    port: Option<(SessionHandle, fn() -> S)>,
+    sessions: [Option<Session<S>>; SESSIONS],
+    objects: [Option<DomainEntry<S>>; DOMAIN_OBJECTS],
+}
+
+impl<S: ServiceObject, const SESSIONS: usize, const DOMAIN_OBJECTS: usize>
+    ServerManager<S, SESSIONS, DOMAIN_OBJECTS>
+{
+    /// Creates a server without sessions nor port.
+    pub const fn new() -> Self {
+        const {
+            assert!(
+                SESSIONS < MAX_WAIT_HANDLES,
+                "a server waits on its sessions and its port at once"
+            )
+        };
+
+        Self {
+            port: None,
+            sessions: [const { None }; SESSIONS],
+            objects: [const { None }; DOMAIN_OBJECTS],
+        }
+    }
+
+    /// Accepts the connections to the server port `port`, serving each new session with an
+    /// object created by `factory`.
+    ///
+    /// The port handle stays owned by the caller, and may be shared with other servers.
+    pub fn register_port(&mut self, port: SessionHandle, factory: fn() -> S) {
+        self.port = Some((port, factory));
+    }
+
+    /// Serves the server session `handle` with `object`.
+    ///
+    /// On success, the session handle is owned by the server, and closed with the session.
+    pub fn add_session(&mut self, handle: SessionHandle, object: S) -> Result<(), ServerFullError> {
+        let slot = self.free_session().ok_or(ServerFullError)?;
+        self.sessions[slot] = Some(Session {
+            handle,
+            object: SessionObject::Plain(object),
+        });
+        Ok(())
+    }
+
+    /// Returns the number of sessions being served.
+    pub fn session_count(&self) -> usize {
+        self.sessions.iter().flatten().count()
+    }
+
+    /// Serves requests until the wait of the thread is cancelled.
+    ///
+    /// Closed sessions are dropped along the way, and their objects with them. Cancelling
+    /// the wait of the thread (`svcCancelSynchronization`), or running out of sessions
+    /// without a port, makes the loop return `Ok`.
+    pub fn serve(&mut self) -> Result<(), ReplyAndReceiveError> {
+        let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+
+        // SAFETY: The placeholder handles are never passed to the kernel.
+        let mut handles = [unsafe { SessionHandle::from_raw(INVALID_HANDLE) }; MAX_WAIT_HANDLES];
+        let mut targets = [WaitTarget::Port; MAX_WAIT_HANDLES];
+        let mut reply_slot = None;
+
+        loop {
+            let mut count = 0;
+            if let Some((port, _)) = self.port {
+                handles[count] = port;
+                targets[count] = WaitTarget::Port;
+                count += 1;
+            }
+            for (slot, session) in self.sessions.iter().enumerate() {
+                if let Some(session) = session {
+                    handles[count] = session.handle;
+                    targets[count] = WaitTarget::Session(slot);
+                    count += 1;
+                }
+            }
+            if count == 0 {
+                return Ok(());
+            }
+
+            let reply_target = reply_slot
+                .take()
+                .and_then(|slot: usize| self.sessions[slot].as_ref().map(|s| (slot, s.handle)));
+            if reply_target.is_none() {
+                // SAFETY: The TLS buffer is valid for a blank message.
+                unsafe { hipc::make_request(ipc_buf, hipc::Metadata::default()) };
+            }
+
+            match ipc::reply_and_receive(
+                &handles[..count],
+                reply_target.map(|(_, handle)| handle),
+                u64::MAX,
+            ) {
+                Ok(index) => match targets[index] {
+                    WaitTarget::Port => self.accept(),
+                    WaitTarget::Session(slot) => reply_slot = self.handle_request(slot),
+                },
+                Err(ReplyAndReceiveError::SessionClosed(index)) => {
+                    let slot = match index {
+                        Some(index) => match targets[index] {
+                            WaitTarget::Session(slot) => Some(slot),
+                            WaitTarget::Port => None,
+                        },
+                        // The client of the reply target left before the reply
+                        None => reply_target.map(|(slot, _)| slot),
+                    };
+                    if let Some(slot) = slot {
+                        self.close_session(slot);
+                    }
+                }
+                Err(ReplyAndReceiveError::TimedOut) => {}
+                Err(ReplyAndReceiveError::Cancelled) => return Ok(()),
+                Err(err) => return Err(err),
+            }
+        }
+    }
+
+    /// Accepts a connection on the port.
+    fn accept(&mut self) {
+        let Some((port, factory)) = self.port else {
+            return;
+        };
+
+        // Fails if another server sharing the port accepted the connection first
+        let Ok(handle) = ipc::accept_session(port) else {
+            return;
+        };
+
+        if self.add_session(handle, factory()).is_err() {
+            let _ = ipc::close_handle(handle);
+        }
+    }
+
+    /// Handles the request received on the session in `slot`, returning the slot to reply
+    /// to, if any.
+    fn handle_request(&mut self, slot: usize) -> Option<usize> {
+        let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+        // SAFETY: The kernel copied the request into the TLS buffer.
+        let message_type = unsafe { hipc::parse_request(ipc_buf) }
+            .meta
+            .message_type
+            .to_raw();
+
+        let is_domain = matches!(self.sessions[slot].as_ref()?.object, SessionObject::Domain);
+        let mut reply = Reply::new();
+        let (domain_format, result) = match message_type {
+            t if t == CommandType::Close as u16 => {
+                self.close_session(slot);
+                return None;
+            }
+            t if t == CommandType::Request as u16
+                || t == CommandType::RequestWithContext as u16 =>
+            {
+                let result = self
+                    .handle_cmif(slot, is_domain, &mut reply)
+                    .and_then(|()| self.attach_objects(slot, is_domain, &mut reply));
+                (is_domain, result)
+            }
+            // Control requests and their replies never use the domain format
+            t if t == CommandType::Control as u16
+                || t == CommandType::ControlWithContext as u16 =>
+            {
+                (false, self.handle_control(slot, &mut reply))
+            }
+            _ => (is_domain, Err(RESULT_NOT_SUPPORTED)),
+        };
+
+        match result {
+            Ok(()) => self.respond(domain_format, 0, &reply),
+            Err(rc) => {
+                reply.discard();
+                self.respond(domain_format, rc, &Reply::new());
+            }
+        }
+        Some(slot)
+    }
+
+    /// Dispatches a CMIF request to its target object.
+    fn handle_cmif(
+        &mut self,
+        slot: usize,
+        is_domain: bool,
+        reply: &mut Reply<S>,
+    ) -> Result<(), ResultCode> {
+        let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+        // SAFETY: The kernel copied the request into the TLS buffer.
+        let req = unsafe { cmif::parse_request(ipc_buf, is_domain) }.map_err(parse_error)?;
+
+        let object = match req.target {
+            None => match &mut self.sessions[slot] {
+                Some(Session {
+                    object: SessionObject::Plain(object),
+                    ..
+                }) => object,
+                _ => return Err(RESULT_TARGET_NOT_FOUND),
+            },
+            Some(target) => {
+                let index = target.object_id.to_raw() as usize - 1;
+                let entry = self
+                    .objects
+                    .get_mut(index)
+                    .and_then(Option::as_mut)
+                    .filter(|entry| entry.session == slot)
+                    .ok_or(RESULT_TARGET_NOT_FOUND)?;
+
+                if target.request_type == DomainRequestType::Close {
+                    self.objects[index] = None;
+                    return Ok(());
+                }
+                &mut entry.object
+            }
+        };
+
+        object.dispatch(&mut Request::new(req), reply)
+    }
+
+    /// Handles a control request of the session in `slot`.
+    fn handle_control(&mut self, slot: usize, reply: &mut Reply<S>) -> Result<(), ResultCode> {
+        let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+        // SAFETY: The kernel copied the request into the TLS buffer.
+        let req = unsafe { cmif::parse_request(ipc_buf, false) }.map_err(parse_error)?;
+        let request = Request::new(req);
+        let session = self.sessions[slot]
+            .as_mut()
+            .ok_or(RESULT_TARGET_NOT_FOUND)?;
+
+        match request.command_id() {
+            CTRL_CONVERT_TO_DOMAIN => {
+                if matches!(session.object, SessionObject::Domain) {
+                    return Err(RESULT_NOT_SUPPORTED);
+                }
+                let index = self
+                    .objects
+                    .iter()
+                    .position(Option::is_none)
+                    .ok_or(RESULT_OUT_OF_DOMAIN_ENTRIES)?;
+
+                let SessionObject::Plain(object) =
+                    mem::replace(&mut session.object, SessionObject::Domain)
+                else {
+                    unreachable!()
+                };
+                self.objects[index] = Some(DomainEntry {
+                    session: slot,
+                    object,
+                });
+                reply.set_data(&(index as u32 + 1));
+            }
+            CTRL_COPY_FROM_DOMAIN => {
+                let index = request
+                    .read::<u32>(0)
+                    .ok_or(RESULT_INVALID_HEADER_SIZE)?
+                    .wrapping_sub(1) as usize;
+                let object = self
+                    .objects
+                    .get(index)
+                    .and_then(Option::as_ref)
+                    .filter(|entry| entry.session == slot)
+                    .ok_or(RESULT_TARGET_NOT_FOUND)?
+                    .object
+                    .try_clone()
+                    .ok_or(RESULT_NOT_SUPPORTED)?;
+                let client = self.open_session(object)?;
+                reply.move_handle(client);
+            }
+            CTRL_CLONE_OBJECT | CTRL_CLONE_OBJECT_EX => {
+                let SessionObject::Plain(object) = &session.object else {
+                    return Err(RESULT_NOT_SUPPORTED);
+                };
+                let object = object.try_clone().ok_or(RESULT_NOT_SUPPORTED)?;
+                let client = self.open_session(object)?;
+                reply.move_handle(client);
+            }
+            CTRL_QUERY_POINTER_BUFFER_SIZE => reply.set_data(&0u16),
+            _ => return Err(RESULT_UNKNOWN_COMMAND_ID),
+        }
+        Ok(())
+    }
+
+    /// Registers the objects staged in `reply`, as domain objects or new sessions.
+    ///
+    /// Their object IDs are staged in the reply data of domain sessions, and the client
+    /// handles of their new sessions ahead of the other move handles otherwise.
+    fn attach_objects(
+        &mut self,
+        slot: usize,
+        is_domain: bool,
+        reply: &mut Reply<S>,
+    ) -> Result<(), ResultCode> {
+        let count = mem::take(&mut reply.num_objects);
+        if count == 0 {
+            return Ok(());
+        }
+
+        let free = if is_domain {
+            self.objects.iter().filter(|entry| entry.is_none()).count()
+        } else {
+            self.sessions
+                .iter()
+                .filter(|session| session.is_none())
+                .count()
+        };
+        if free < count || (!is_domain && reply.num_move_handles + count > MAX_OUT_HANDLES) {
+            return Err(RESULT_OUT_OF_DOMAIN_ENTRIES);
+        }
+
+        let mut ids = [0u32; MAX_OUT_OBJECTS];
+        let mut clients = [INVALID_HANDLE; MAX_OUT_OBJECTS];
+        for i in 0..count {
+            let Some(object) = reply.objects[i].take() else {
+                continue;
+            };
+
+            if is_domain {
+                // Free entries were counted above
+                let index = self
+                    .objects
+                    .iter()
+                    .position(Option::is_none)
+                    .unwrap_or_default();
+                self.objects[index] = Some(DomainEntry {
+                    session: slot,
+                    object,
+                });
+                ids[i] = index as u32 + 1;
+            } else {
+                match self.open_session(object) {
+                    Ok(client) => clients[i] = client,
+                    Err(rc) => {
+                        for &client in &clients[..i] {
+                            close_raw(client);
+                        }
+                        return Err(rc);
+                    }
+                }
+            }
+        }
+
+        if is_domain {
+            reply.domain_objects = ids;
+            reply.num_domain_objects = count;
+        } else {
+            reply
+                .move_handles
+                .copy_within(..reply.num_move_handles, count);
+            reply.move_handles[..count].copy_from_slice(&clients[..count]);
+            reply.num_move_handles += count;
+        }
+        Ok(())
+    }
+
+    /// Serves `object` on a new session, returning its client handle.
+    fn open_session(&mut self, object: S) -> Result<RawHandle, ResultCode> {
+        let slot = self.free_session().ok_or(RESULT_OUT_OF_DOMAIN_ENTRIES)?;
+        let (server, client) = ipc::create_session().map_err(|err| err.to_rc())?;
+        self.sessions[slot] = Some(Session {
+            handle: server,
+            object: SessionObject::Plain(object),
+        });
+        Ok(client.to_raw())
+    }
+
+    /// Writes the response to the current request into the TLS buffer.
+    fn respond(&self, is_domain: bool, result: ResultCode, reply: &Reply<S>) {
+        let fmt = ResponseFormat {
+            is_domain,
+            result,
+            data: reply.data(),
+            objects: &reply.domain_objects[..reply.num_domain_objects],
+            copy_handles: &reply.copy_handles[..reply.num_copy_handles],
+            move_handles: &reply.move_handles[..reply.num_move_handles],
+        };
+        // SAFETY: The staged output is bounded to fit the TLS buffer.
+        unsafe { cmif::make_response(nx_sys_thread_tls::ipc_buffer_ptr(), &fmt) };
+    }
+
+    /// Closes the session in `slot`, dropping its objects.
+    fn close_session(&mut self, slot: usize) {
+        let Some(session) = self.sessions[slot].take() else {
+            return;
+        };
+
+        if matches!(session.object, SessionObject::Domain) {
+            for entry in &mut self.objects {
+                if entry.as_ref().is_some_and(|entry| entry.session == slot) {
+                    *entry = None;
+                }
+            }
+        }
+        let _ = ipc::close_handle(session.handle);
+    }
+
+    fn free_session(&self) -> Option<usize> {
+        self.sessions.iter().position(Option::is_none)
+    }
+}
+
+impl<S: ServiceObject, const SESSIONS: usize, const DOMAIN_OBJECTS: usize> Default
+    for ServerManager<S, SESSIONS, DOMAIN_OBJECTS>
+{
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<S, const SESSIONS: usize, const DOMAIN_OBJECTS: usize> Drop
+    for ServerManager<S, SESSIONS, DOMAIN_OBJECTS>
+{
+    fn drop(&mut self) {
+        for session in self.sessions.iter().flatten() {
+            let _ = ipc::close_handle(session.handle);
+        }
+    }
+}
+
+/// Maps a request parsing error to the result code sent to the client.
+fn parse_error(err: ParseRequestError) -> ResultCode {
+    match err {
+        ParseRequestError::InvalidHeaderSize => RESULT_INVALID_HEADER_SIZE,
+        ParseRequestError::InvalidMagic | ParseRequestError::InvalidDomainHeader => {
+            RESULT_INVALID_IN_HEADER
+        }
+    }
+}
+
+fn close_raw(handle: RawHandle) {
+    // SAFETY: A staged move handle is owned by the server, and not used after this.
+    let _ = ipc::close_handle(unsafe { SessionHandle::from_raw(handle) });
+}
+
+/// Error returned by [`ServerManager::add_session`] when every session slot is in use.
+#[derive(Debug, thiserror::Error)]
+#[error("server session table full")]
+pub struct ServerFullError;
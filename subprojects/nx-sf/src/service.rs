@@ -18,12 +18,27 @@
 //!
 //! - libnx `sf/service.h`
 
-use core::{mem::size_of, ptr};
-
-use nx_svc::ipc::{self, Handle as SessionHandle};
+use core::{
+    marker::PhantomData,
+    mem::{size_of, size_of_val},
+    ptr::{self, NonNull},
+    slice,
+};
+
+use nx_panic_handler::ring;
+use nx_svc::{
+    error::ToRawResultCode,
+    ipc::{self, Handle as SessionHandle},
+    sync,
+};
 use static_assertions::const_assert_eq;
 
-use crate::cmif::{self, ObjectId};
+#[cfg(feature = "trace")]
+use crate::trace;
+use crate::{
+    cmif::{self, ObjectId},
+    pod::{self, Pod},
+};
 
 // Control request IDs for CMIF session management.
 const CTRL_CONVERT_TO_DOMAIN: u32 = 0;
@@ -215,6 +230,20 @@ impl Service {
     pub fn dispatch(&self, request_id: u32) -> Dispatch<'_> {
         Dispatch::new(self, request_id)
     }
+
+    /// Creates a dispatch builder with room for `B` buffers, `O` input objects and `H`
+    /// input handles.
+    ///
+    /// Each builder call moves the builder, so small commands keep it small:
+    /// `dispatch_sized::<0, 0, 0>` carries no descriptor arrays at all. Descriptors past
+    /// the capacity are ignored, as with [`Service::dispatch`].
+    #[inline]
+    pub fn dispatch_sized<const B: usize, const O: usize, const H: usize>(
+        &self,
+        request_id: u32,
+    ) -> Dispatch<'_, B, O, H> {
+        Dispatch::new(self, request_id)
+    }
 }
 
 /// Error returned by [`Service::try_clone`].
@@ -301,27 +330,35 @@ pub struct Buffer {
 }
 
 /// Builder for dispatching CMIF commands to a service.
+///
+/// `B`, `O` and `H` are its capacities of buffers, input objects and input handles; see
+/// [`Service::dispatch_sized`].
 #[derive(Debug)]
-pub struct Dispatch<'a> {
+pub struct Dispatch<
+    'a,
+    const B: usize = MAX_BUFFERS,
+    const O: usize = MAX_IN_OBJECTS,
+    const H: usize = MAX_IN_HANDLES,
+> {
     service: &'a Service,
     request_id: u32,
     context: u32,
     in_data: *const u8,
     in_data_size: usize,
     out_data_size: usize,
-    buffer_attrs: [BufferAttr; MAX_BUFFERS],
-    buffers: [Buffer; MAX_BUFFERS],
+    buffer_attrs: [BufferAttr; B],
+    buffers: [Buffer; B],
     buffer_count: usize,
-    in_objects: [Option<ObjectId>; MAX_IN_OBJECTS],
+    in_objects: [Option<ObjectId>; O],
     in_object_count: usize,
-    in_handles: [u32; MAX_IN_HANDLES],
+    in_handles: [u32; H],
     in_handle_count: usize,
     out_object_count: usize,
     out_handle_attrs: [OutHandleAttr; MAX_BUFFERS],
     send_pid: bool,
 }
 
-impl<'a> Dispatch<'a> {
+impl<'a, const B: usize, const O: usize, const H: usize> Dispatch<'a, B, O, H> {
     /// Creates a new dispatch builder for the given service and request ID.
     fn new(service: &'a Service, request_id: u32) -> Self {
         Self {
@@ -331,12 +368,12 @@ impl<'a> Dispatch<'a> {
             in_data: ptr::null(),
             in_data_size: 0,
             out_data_size: 0,
-            buffer_attrs: [BufferAttr::default(); MAX_BUFFERS],
-            buffers: [Buffer::default(); MAX_BUFFERS],
+            buffer_attrs: [BufferAttr::default(); B],
+            buffers: [Buffer::default(); B],
             buffer_count: 0,
-            in_objects: [None; MAX_IN_OBJECTS],
+            in_objects: [None; O],
             in_object_count: 0,
-            in_handles: [0; MAX_IN_HANDLES],
+            in_handles: [0; H],
             in_handle_count: 0,
             out_object_count: 0,
             out_handle_attrs: [OutHandleAttr::None; MAX_BUFFERS],
@@ -373,7 +410,7 @@ impl<'a> Dispatch<'a> {
     /// Adds a buffer with the specified attributes.
     #[inline]
     pub fn buffer(mut self, ptr: *const u8, size: usize, attr: BufferAttr) -> Self {
-        if self.buffer_count < MAX_BUFFERS {
+        if self.buffer_count < B {
             self.buffers[self.buffer_count] = Buffer { ptr, size };
             self.buffer_attrs[self.buffer_count] = attr;
             self.buffer_count += 1;
@@ -381,10 +418,35 @@ impl<'a> Dispatch<'a> {
         self
     }
 
+    /// Adds an input buffer holding `data`, mapped into the server (Type A).
+    ///
+    /// The server reads `data` in place.
+    #[inline]
+    pub fn in_buffer<T: Pod>(self, data: &'a [T]) -> Self {
+        self.buffer(
+            data.as_ptr().cast(),
+            size_of_val(data),
+            BufferAttr::IN.or(BufferAttr::HIPC_MAP_ALIAS),
+        )
+    }
+
+    /// Adds an output buffer for `out`, mapped into the server (Type B).
+    ///
+    /// The server writes its output straight into `out`, instead of the
+    /// caller copying it out of the IPC buffer.
+    #[inline]
+    pub fn out_buffer<T: Pod>(self, out: &'a mut [T]) -> Self {
+        self.buffer(
+            out.as_mut_ptr().cast_const().cast(),
+            size_of_val(out),
+            BufferAttr::OUT.or(BufferAttr::HIPC_MAP_ALIAS),
+        )
+    }
+
     /// Adds an input domain object.
     #[inline]
     pub fn in_object(mut self, object_id: ObjectId) -> Self {
-        if self.in_object_count < MAX_IN_OBJECTS {
+        if self.in_object_count < O {
             self.in_objects[self.in_object_count] = Some(object_id);
             self.in_object_count += 1;
         }
@@ -394,7 +456,7 @@ impl<'a> Dispatch<'a> {
     /// Adds an input handle.
     #[inline]
     pub fn in_handle(mut self, handle: u32) -> Self {
-        if self.in_handle_count < MAX_IN_HANDLES {
+        if self.in_handle_count < H {
             self.in_handles[self.in_handle_count] = handle;
             self.in_handle_count += 1;
         }
@@ -430,8 +492,91 @@ impl<'a> Dispatch<'a> {
     /// handles, and objects. The returned data references the TLS IPC buffer
     /// and is valid until the next IPC call on this thread.
     pub fn send(self) -> Result<DispatchResult<'static>, DispatchError> {
+        #[cfg(feature = "trace")]
+        let start = trace::now();
+
         let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
 
+        // SAFETY: The TLS IPC buffer is valid for the whole message.
+        let is_domain = unsafe { self.write_request(ipc_buf) }.is_domain;
+
+        let res = send_sync(self.service.session, ipc_buf, is_domain, self.out_data_size);
+
+        #[cfg(feature = "trace")]
+        record_dispatch(self.service, self.request_id, start, &res);
+        res
+    }
+
+    /// Sends the dispatch request without waiting for the response.
+    ///
+    /// The request is built into `buffer` instead of the TLS IPC buffer and sent with
+    /// `svcSendAsyncRequestWithUserBuffer`. The returned [`PendingDispatch`] owns the
+    /// completion event; the response is parsed from `buffer` once it is signalled. This
+    /// lets a single thread keep requests to several services in flight.
+    ///
+    /// # Safety
+    ///
+    /// The input data and buffers passed to this builder must remain valid until the
+    /// returned [`PendingDispatch`] completes or is dropped, since the server accesses them
+    /// while handling the request.
+    pub unsafe fn send_async<'b>(
+        self,
+        buffer: &'b mut AsyncBuffer,
+    ) -> Result<PendingDispatch<'b>, AsyncDispatchError> {
+        // SAFETY: The async buffer is a full page, large enough for any CMIF message.
+        let is_domain =
+            unsafe { self.write_request(NonNull::from(&mut buffer.0).cast()) }.is_domain;
+
+        let event = ipc::send_async_request_with_user_buffer(&mut buffer.0, self.service.session)
+            .map_err(AsyncDispatchError::SendRequest)?;
+
+        Ok(PendingDispatch {
+            buffer: NonNull::from(&mut buffer.0).cast(),
+            event: Some(event),
+            is_domain,
+            out_data_size: self.out_data_size,
+            _buffer: PhantomData,
+        })
+    }
+
+    /// Encodes the request once, to be sent any number of times.
+    ///
+    /// The returned [`PreparedDispatch`] keeps the encoded message: sending it again only
+    /// copies the message into the TLS IPC buffer, and its input data can be changed in
+    /// between. The input data is copied, so it does not need to outlive the builder.
+    ///
+    /// # Safety
+    ///
+    /// The message records the addresses of the buffers passed to this builder, and the
+    /// server accesses them on every send. Buffers added with [`Dispatch::in_buffer`] and
+    /// [`Dispatch::out_buffer`] stay borrowed by the returned [`PreparedDispatch`]; those
+    /// added with [`Dispatch::buffer`] must remain valid, and not be accessed during a
+    /// send, until it is dropped.
+    pub unsafe fn prepare(self) -> PreparedDispatch<'a> {
+        let mut message = MessageBuffer([0; MESSAGE_SIZE]);
+        // SAFETY: The message buffer is as large as the TLS IPC buffer.
+        let written = unsafe { self.write_request(NonNull::from(&mut message.0).cast()) };
+
+        PreparedDispatch {
+            service: self.service,
+            #[cfg(feature = "trace")]
+            request_id: self.request_id,
+            message,
+            len: written.len,
+            data_offset: written.data_offset,
+            data_size: self.in_data_size,
+            is_domain: written.is_domain,
+            out_data_size: self.out_data_size,
+            _buffers: PhantomData,
+        }
+    }
+
+    /// Writes the CMIF request message into `base`.
+    ///
+    /// # Safety
+    ///
+    /// `base` must point to a writable IPC message buffer of at least 0x200 bytes.
+    unsafe fn write_request(&self, base: NonNull<u8>) -> WrittenRequest {
         let is_domain = self.service.is_domain() || self.service.is_domain_subservice();
 
         // Count buffer types for CMIF format
@@ -502,8 +647,8 @@ impl<'a> Dispatch<'a> {
 
         let fmt = builder.build();
 
-        // SAFETY: ipc_buf points to valid IPC buffer.
-        let mut req = unsafe { cmif::make_request(ipc_buf, fmt) };
+        // SAFETY: The caller guarantees `base` points to a valid IPC buffer.
+        let mut req = unsafe { cmif::make_request(base, fmt) };
 
         // Copy input data
         if !self.in_data.is_null() && self.in_data_size > 0 {
@@ -569,23 +714,158 @@ impl<'a> Dispatch<'a> {
             req.add_handle(self.in_handles[i]);
         }
 
-        // Send the request
-        ipc::send_sync_request(self.service.session).map_err(DispatchError::SendRequest)?;
+        // The receive list, if any, ends the message
+        let data_words_end = req.hipc.data_words.as_ptr_range().end.cast::<u8>();
+        let end = if req.hipc.recv_list.is_empty() {
+            data_words_end
+        } else {
+            req.hipc.recv_list.as_ptr_range().end.cast::<u8>()
+        };
+
+        WrittenRequest {
+            is_domain,
+            data_offset: req.data.as_ptr().addr() - base.addr().get(),
+            len: end.addr() - base.addr().get(),
+        }
+    }
+}
+
+/// Layout of a request written by [`Dispatch::write_request`].
+struct WrittenRequest {
+    /// Whether the response must be parsed in domain mode.
+    is_domain: bool,
+    /// Offset of the payload data in the message.
+    data_offset: usize,
+    /// Size of the message.
+    len: usize,
+}
 
-        // Parse response
-        // SAFETY: Response is in TLS buffer after successful send.
-        let resp = unsafe { cmif::parse_response(ipc_buf, is_domain, self.out_data_size) }
-            .map_err(DispatchError::ParseResponse)?;
+/// Size of the message buffer [`Dispatch::write_request`] writes into.
+const MESSAGE_SIZE: usize = 0x200;
 
-        Ok(DispatchResult {
-            data: resp.data,
-            objects: resp.objects,
-            copy_handles: resp.copy_handles,
-            move_handles: resp.move_handles,
-        })
+/// An encoded IPC message, aligned like the TLS IPC buffer.
+#[derive(Debug, Clone, Copy)]
+#[repr(C, align(16))]
+struct MessageBuffer([u8; MESSAGE_SIZE]);
+
+/// A request encoded by [`Dispatch::prepare`], to be sent any number of times.
+///
+/// Copy handles are sent again with every request. The buffers passed to the builder are
+/// accessed by the server on every send: those added with [`Dispatch::in_buffer`] and
+/// [`Dispatch::out_buffer`] stay borrowed for `'a`, and raw ones are covered by the
+/// contract of [`Dispatch::prepare`].
+#[derive(Debug)]
+pub struct PreparedDispatch<'a> {
+    service: &'a Service,
+    #[cfg(feature = "trace")]
+    request_id: u32,
+    message: MessageBuffer,
+    len: usize,
+    data_offset: usize,
+    data_size: usize,
+    is_domain: bool,
+    out_data_size: usize,
+    _buffers: PhantomData<&'a mut [u8]>,
+}
+
+impl PreparedDispatch<'_> {
+    /// Returns the input data of the request, to be changed before the next send.
+    #[inline]
+    pub fn data_mut(&mut self) -> &mut [u8] {
+        &mut self.message.0[self.data_offset..self.data_offset + self.data_size]
+    }
+
+    /// Sets the input data of the request to `data`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `T` is not the size of the input data of the request.
+    #[inline]
+    pub fn set_data<T: Pod>(&mut self, data: &T) {
+        // SAFETY: `Pod` values have no padding, so all of their bytes are initialized.
+        let bytes =
+            unsafe { slice::from_raw_parts(ptr::from_ref(data).cast::<u8>(), size_of::<T>()) };
+        self.data_mut().copy_from_slice(bytes);
+    }
+
+    /// Sends the request and returns the result, as [`Dispatch::send`].
+    ///
+    /// The result borrows `self`, so the request cannot be sent again while its response
+    /// is still being read out of the TLS IPC buffer.
+    pub fn send(&mut self) -> Result<DispatchResult<'_>, DispatchError> {
+        #[cfg(feature = "trace")]
+        let start = trace::now();
+
+        let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+
+        // SAFETY: The message fits in the TLS IPC buffer, which is not borrowed by anything
+        // else on this thread while a request is being sent.
+        unsafe {
+            ptr::copy_nonoverlapping(self.message.0.as_ptr(), ipc_buf.as_ptr(), self.len);
+        }
+
+        let res = send_sync(
+            self.service.session,
+            ipc_buf,
+            self.is_domain,
+            self.out_data_size,
+        );
+
+        #[cfg(feature = "trace")]
+        record_dispatch(self.service, self.request_id, start, &res);
+        res
     }
 }
 
+/// Sends the request written in the TLS IPC buffer `ipc_buf`, and parses the response.
+#[inline]
+fn send_sync(
+    session: SessionHandle,
+    ipc_buf: NonNull<u8>,
+    is_domain: bool,
+    out_data_size: usize,
+) -> Result<DispatchResult<'static>, DispatchError> {
+    // Failures are recorded in the error ring, reported if the process panics later on
+    ipc::send_sync_request(session).map_err(|err| {
+        ring::error(err.to_rc(), session.to_raw().into());
+        DispatchError::SendRequest(err)
+    })?;
+
+    // SAFETY: Response is in TLS buffer after successful send.
+    let resp =
+        unsafe { cmif::parse_response(ipc_buf, is_domain, out_data_size) }.map_err(|err| {
+            if let cmif::ParseResponseError::ServiceError(rc) = err {
+                ring::error(rc, session.to_raw().into());
+            }
+            DispatchError::ParseResponse(err)
+        })?;
+
+    Ok(DispatchResult {
+        data: resp.data,
+        objects: resp.objects,
+        copy_handles: resp.copy_handles,
+        move_handles: resp.move_handles,
+    })
+}
+
+/// Records a request to `service` sent at the `start` tick, with its result.
+#[cfg(feature = "trace")]
+#[inline]
+fn record_dispatch(
+    service: &Service,
+    request_id: u32,
+    start: u64,
+    res: &Result<DispatchResult<'_>, DispatchError>,
+) {
+    trace::record(
+        service.session.to_raw(),
+        service.object_id,
+        request_id,
+        start,
+        res.as_ref().ok().map(|resp| resp.data.len()),
+    );
+}
+
 /// Error returned by [`Dispatch::send`].
 #[derive(Debug, thiserror::Error)]
 pub enum DispatchError {
@@ -610,6 +890,254 @@ pub struct DispatchResult<'a> {
     pub move_handles: &'a [u32],
 }
 
+impl<'a> DispatchResult<'a> {
+    /// Reads the payload as a `T`.
+    ///
+    /// The payload is copied out: the message buffer it lives in is overwritten by the
+    /// next IPC call on this thread, which nothing borrowed from it would prevent.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the payload is smaller than `T`.
+    #[inline]
+    pub fn payload<T: Pod>(&self) -> T {
+        pod::read(self.data, 0).expect("response payload does not hold the requested type")
+    }
+
+    /// Reads a `T` from the payload at `offset` bytes.
+    ///
+    /// Returns `None` if the payload does not hold a `T` at `offset`.
+    #[inline]
+    pub fn read<T: Pod>(&self, offset: usize) -> Option<T> {
+        pod::read(self.data, offset)
+    }
+}
+
+/// A page-aligned IPC message buffer for [`Dispatch::send_async`].
+///
+/// The kernel locks the buffer while the request is in flight and writes the response
+/// into it, so each in-flight request needs its own buffer.
+#[repr(C, align(0x1000))]
+pub struct AsyncBuffer([u8; ASYNC_BUFFER_SIZE]);
+
+/// Size of an [`AsyncBuffer`]: one page.
+pub const ASYNC_BUFFER_SIZE: usize = 0x1000;
+
+impl AsyncBuffer {
+    /// Creates a zeroed buffer.
+    pub const fn new() -> Self {
+        Self([0; ASYNC_BUFFER_SIZE])
+    }
+}
+
+impl Default for AsyncBuffer {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// An asynchronous dispatch in flight, returned by [`Dispatch::send_async`].
+///
+/// The completion event can be waited on together with other handles through
+/// [`PendingDispatch::event`]. Dropping a pending dispatch blocks until the completion event
+/// is signalled, since the kernel owns the buffer until then. Waits cancelled with
+/// `svcCancelSynchronization` are retried, and any other wait failure panics rather than
+/// hand the buffer back while the kernel may still write the response into it.
+#[derive(Debug)]
+pub struct PendingDispatch<'b> {
+    buffer: NonNull<u8>,
+    /// `None` once the dispatch completed.
+    event: Option<ipc::EventHandle>,
+    is_domain: bool,
+    out_data_size: usize,
+    _buffer: PhantomData<&'b mut AsyncBuffer>,
+}
+
+impl<'b> PendingDispatch<'b> {
+    /// Returns the completion event, signalled once the response is in the buffer.
+    pub fn event(&self) -> &ipc::EventHandle {
+        self.event.as_ref().expect("dispatch already completed")
+    }
+
+    /// Returns `true` if the response has arrived, without blocking.
+    pub fn is_complete(&self) -> bool {
+        // SAFETY: The event handle is owned by `self` and valid until closed.
+        unsafe { sync::wait_synchronization_single(self.event(), 0) }.is_ok()
+    }
+
+    /// Blocks until the response arrives and parses it.
+    ///
+    /// The returned data references the [`AsyncBuffer`] the request was built in.
+    ///
+    /// # Panics
+    ///
+    /// Panics if waiting for the completion event fails, see [`PendingDispatch`].
+    pub fn wait(mut self) -> Result<DispatchResult<'b>, AsyncDispatchError> {
+        self.complete();
+
+        // SAFETY: The server replied, so the buffer holds the response message and is no
+        // longer accessed by the kernel.
+        let resp = unsafe { cmif::parse_response(self.buffer, self.is_domain, self.out_data_size) }
+            .map_err(AsyncDispatchError::ParseResponse)?;
+
+        Ok(DispatchResult {
+            data: resp.data,
+            objects: resp.objects,
+            copy_handles: resp.copy_handles,
+            move_handles: resp.move_handles,
+        })
+    }
+
+    /// Waits for the completion event, then closes it.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the wait fails other than by being cancelled, as the kernel may still own
+    /// the buffer.
+    fn complete(&mut self) {
+        let Some(event) = self.event else {
+            return;
+        };
+        loop {
+            // SAFETY: The event handle is owned by `self` and valid until closed.
+            match unsafe { sync::wait_synchronization_single(&event, u64::MAX) } {
+                Ok(()) => break,
+                // Another thread cancelled the wait (e.g. a reactor waking this one up)
+                Err(sync::WaitSyncError::Cancelled) => {}
+                Err(err) => panic!("failed to wait for an async IPC response: {err}"),
+            }
+        }
+        self.event = None;
+        let _ = ipc::close_event_handle(event);
+    }
+}
+
+impl Drop for PendingDispatch<'_> {
+    fn drop(&mut self) {
+        self.complete();
+    }
+}
+
+/// Error returned by [`Dispatch::send_async`] and [`PendingDispatch::wait`].
+#[derive(Debug, thiserror::Error)]
+pub enum AsyncDispatchError {
+    /// Failed to send the IPC request.
+    #[error("failed to send async IPC request")]
+    SendRequest(#[source] ipc::SendAsyncWithBufferError),
+    /// Failed to parse the service response.
+    #[error("failed to parse response")]
+    ParseResponse(#[source] cmif::ParseResponseError),
+}
+
+/// A batch of asynchronous dispatches completed in the order the servers reply.
+///
+/// Dispatches to different sessions are sent back to back with [`DispatchBatch::submit`],
+/// then collected with [`DispatchBatch::wait_next`], which waits on all outstanding
+/// completion events with a single `svcWaitSynchronization`. Up to `N` dispatches can be in
+/// flight, and `N` must not exceed [`sync::MAX_WAIT_HANDLES`].
+///
+/// Dropping the batch waits for the remaining replies (see [`PendingDispatch`]).
+#[derive(Debug)]
+pub struct DispatchBatch<'b, const N: usize> {
+    /// Outstanding dispatches and their submission indices, compacted at the front.
+    pending: [Option<(usize, PendingDispatch<'b>)>; N],
+    len: usize,
+    submitted: usize,
+}
+
+impl<'b, const N: usize> DispatchBatch<'b, N> {
+    /// Creates an empty batch.
+    pub const fn new() -> Self {
+        const {
+            assert!(
+                N <= sync::MAX_WAIT_HANDLES,
+                "batch larger than the kernel wait limit"
+            )
+        };
+        Self {
+            pending: [const { None }; N],
+            len: 0,
+            submitted: 0,
+        }
+    }
+
+    /// Returns the number of dispatches in flight.
+    pub const fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Returns `true` if no dispatch is in flight.
+    pub const fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Sends `dispatch` asynchronously using `buffer` and adds it to the batch.
+    ///
+    /// Returns the submission index of the dispatch, counted from zero, which identifies it
+    /// in [`DispatchBatch::wait_next`].
+    ///
+    /// # Safety
+    ///
+    /// See [`Dispatch::send_async`].
+    ///
+    /// # Panics
+    ///
+    /// Panics if `N` dispatches are already in flight.
+    pub unsafe fn submit<const B: usize, const O: usize, const H: usize>(
+        &mut self,
+        dispatch: Dispatch<'_, B, O, H>,
+        buffer: &'b mut AsyncBuffer,
+    ) -> Result<usize, AsyncDispatchError> {
+        assert!(self.len < N, "dispatch batch is full");
+
+        // SAFETY: The caller upholds the `send_async` contract.
+        let pending = unsafe { dispatch.send_async(buffer) }?;
+
+        let index = self.submitted;
+        self.pending[self.len] = Some((index, pending));
+        self.len += 1;
+        self.submitted += 1;
+        Ok(index)
+    }
+
+    /// Waits for the next dispatch to complete and returns its submission index and result.
+    ///
+    /// Returns `Ok(None)` once the batch is empty. If the wait itself fails, the batch is left
+    /// unchanged and the call can be retried.
+    pub fn wait_next(
+        &mut self,
+    ) -> Result<Option<(usize, Result<DispatchResult<'b>, AsyncDispatchError>)>, sync::WaitSyncError>
+    {
+        if self.len == 0 {
+            return Ok(None);
+        }
+
+        let events = self.pending[..self.len]
+            .iter()
+            .flatten()
+            .map(|(_, pending)| pending.event());
+        // SAFETY: The event handles are owned by the pending dispatches and valid until they
+        // complete.
+        let signalled = unsafe { sync::wait_synchronization_multiple(events, u64::MAX) }?;
+
+        // Keep the outstanding dispatches compacted
+        self.len -= 1;
+        self.pending.swap(signalled, self.len);
+        let (index, pending) = self.pending[self.len]
+            .take()
+            .expect("outstanding dispatch slot is empty");
+
+        // The event is signalled, so this does not block
+        Ok(Some((index, pending.wait())))
+    }
+}
+
+impl<const N: usize> Default for DispatchBatch<'_, N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
 // =============================================================================
 // Helper functions for CMIF control requests
 // =============================================================================
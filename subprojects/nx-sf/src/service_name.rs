@@ -7,6 +7,8 @@
 
 use static_assertions::const_assert_eq;
 
+use crate::pod::Pod;
+
 /// Fixed-capacity ASCII string for service names (max 8 bytes).
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Default)]
 #[repr(C)]
@@ -16,6 +18,9 @@ pub struct ServiceName {
 
 const_assert_eq!(size_of::<ServiceName>(), size_of::<u64>());
 
+// SAFETY: A byte array, without padding.
+unsafe impl Pod for ServiceName {}
+
 impl ServiceName {
     /// Maximum length of a service name (8 characters).
     pub const MAX_LEN: usize = 8;
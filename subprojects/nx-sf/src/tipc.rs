@@ -52,11 +52,27 @@
 //! - [Switchbrew IPC Marshalling](https://switchbrew.org/wiki/IPC_Marshalling)
 //! - libnx `sf/tipc.h` (fincs, SciresM)
 
-use core::{ptr::NonNull, slice};
+use core::{
+    mem::{size_of, size_of_val},
+    ptr::{self, NonNull},
+    slice,
+};
 
-use nx_svc::raw::Handle as RawHandle;
+use nx_svc::{
+    ipc::{self, Handle as SessionHandle},
+    raw::Handle as RawHandle,
+};
 
-use crate::hipc::{self, BufferMode};
+use crate::{
+    hipc::{self, BufferMode},
+    pod::{self, Pod},
+};
+
+/// Maximum number of buffers of a [`Dispatch`].
+pub const MAX_BUFFERS: usize = 8;
+
+/// Maximum number of input handles of a [`Dispatch`].
+pub const MAX_IN_HANDLES: usize = 8;
 
 /// TIPC command types.
 ///
@@ -263,3 +279,239 @@ pub struct Response<'a> {
     /// Returned move handles (used for receiving service objects).
     pub move_handles: &'a [RawHandle],
 }
+
+impl<'a> Response<'a> {
+    /// Reads the payload as a `T`.
+    ///
+    /// The payload is copied out, as the TLS IPC buffer it lives in is overwritten by the
+    /// next IPC call on this thread.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the payload is smaller than `T`.
+    #[inline]
+    pub fn payload<T: Pod>(&self) -> T {
+        pod::read(self.data, 0).expect("response payload does not hold the requested type")
+    }
+
+    /// Reads a `T` from the payload at `offset` bytes.
+    ///
+    /// Returns `None` if the payload does not hold a `T` at `offset`.
+    #[inline]
+    pub fn read<T: Pod>(&self, offset: usize) -> Option<T> {
+        pod::read(self.data, offset)
+    }
+}
+
+/// Creates a dispatch builder for sending the TIPC command `request_id` to `session`.
+#[inline]
+pub fn dispatch<'a>(session: SessionHandle, request_id: u32) -> Dispatch<'a> {
+    Dispatch {
+        session,
+        request_id,
+        in_data: &[],
+        out_data_size: 0,
+        buffers: [BufferDesc::default(); MAX_BUFFERS],
+        buffer_count: 0,
+        in_handles: [0; MAX_IN_HANDLES],
+        in_handle_count: 0,
+        overflowed: false,
+        send_pid: false,
+    }
+}
+
+/// Direction of a [`Dispatch`] buffer.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+enum BufferKind {
+    /// Type A / Send Buffer.
+    #[default]
+    In,
+    /// Type B / Recv Buffer.
+    Out,
+    /// Type W / Exchange Buffer.
+    InOut,
+}
+
+#[derive(Debug, Clone, Copy)]
+struct BufferDesc {
+    kind: BufferKind,
+    ptr: *const u8,
+    size: usize,
+    mode: BufferMode,
+}
+
+impl Default for BufferDesc {
+    fn default() -> Self {
+        Self {
+            kind: BufferKind::In,
+            ptr: ptr::null(),
+            size: 0,
+            mode: BufferMode::Normal,
+        }
+    }
+}
+
+/// Builder for dispatching TIPC commands.
+///
+/// The TIPC counterpart of [`Service::dispatch`](crate::service::Service::dispatch):
+/// TIPC has no domains and no pointer buffers, so the request is only a HIPC header, its
+/// buffer and handle descriptors, and the raw input data, and the response is the result
+/// word followed by the output data.
+#[derive(Debug)]
+pub struct Dispatch<'a> {
+    session: SessionHandle,
+    request_id: u32,
+    in_data: &'a [u8],
+    out_data_size: usize,
+    buffers: [BufferDesc; MAX_BUFFERS],
+    buffer_count: usize,
+    in_handles: [u32; MAX_IN_HANDLES],
+    in_handle_count: usize,
+    /// Whether a buffer or handle was added past the capacity.
+    overflowed: bool,
+    send_pid: bool,
+}
+
+impl<'a> Dispatch<'a> {
+    /// Sets the input data of the request.
+    #[inline]
+    pub fn in_data<T: Pod>(mut self, data: &'a T) -> Self {
+        // SAFETY: `Pod` values have no padding, so all of their bytes are initialized.
+        self.in_data =
+            unsafe { slice::from_raw_parts(ptr::from_ref(data).cast::<u8>(), size_of::<T>()) };
+        self
+    }
+
+    /// Sets the expected output data size.
+    #[inline]
+    pub fn out_size(mut self, size: usize) -> Self {
+        self.out_data_size = size;
+        self
+    }
+
+    /// Adds an input buffer holding `data`, mapped into the server (Type A).
+    #[inline]
+    pub fn in_buffer<T: Pod>(self, data: &'a [T]) -> Self {
+        self.buffer(BufferKind::In, data.as_ptr().cast(), size_of_val(data))
+    }
+
+    /// Adds an output buffer for `out`, mapped into the server (Type B).
+    #[inline]
+    pub fn out_buffer<T: Pod>(self, out: &'a mut [T]) -> Self {
+        self.buffer(
+            BufferKind::Out,
+            out.as_mut_ptr().cast_const().cast(),
+            size_of_val(out),
+        )
+    }
+
+    /// Adds a buffer the server both reads and writes (Type W).
+    #[inline]
+    pub fn inout_buffer<T: Pod>(self, data: &'a mut [T]) -> Self {
+        self.buffer(
+            BufferKind::InOut,
+            data.as_mut_ptr().cast_const().cast(),
+            size_of_val(data),
+        )
+    }
+
+    /// Adds an input copy handle.
+    ///
+    /// Past [`MAX_IN_HANDLES`] handles, [`Dispatch::send`] fails.
+    #[inline]
+    pub fn in_handle(mut self, handle: u32) -> Self {
+        if self.in_handle_count < MAX_IN_HANDLES {
+            self.in_handles[self.in_handle_count] = handle;
+            self.in_handle_count += 1;
+        } else {
+            self.overflowed = true;
+        }
+        self
+    }
+
+    /// Enables sending the process ID.
+    #[inline]
+    pub fn send_pid(mut self) -> Self {
+        self.send_pid = true;
+        self
+    }
+
+    /// Sends the request and returns the response.
+    ///
+    /// The returned data references the TLS IPC buffer and is valid until the next IPC
+    /// call on this thread. Fails without sending anything if more than [`MAX_BUFFERS`]
+    /// buffers or [`MAX_IN_HANDLES`] handles were added.
+    pub fn send(self) -> Result<Response<'static>, DispatchError> {
+        if self.overflowed {
+            return Err(DispatchError::TooManyDescriptors);
+        }
+
+        let ipc_buf = nx_sys_thread_tls::ipc_buffer_ptr();
+
+        let count = |kind| {
+            self.buffers[..self.buffer_count]
+                .iter()
+                .filter(|buf| buf.kind == kind)
+                .count() as u32
+        };
+        let fmt = RequestFormat {
+            request_id: self.request_id,
+            data_size: self.in_data.len(),
+            num_in_buffers: count(BufferKind::In),
+            num_out_buffers: count(BufferKind::Out),
+            num_inout_buffers: count(BufferKind::InOut),
+            num_handles: self.in_handle_count as u32,
+            send_pid: self.send_pid,
+        };
+
+        // SAFETY: The TLS IPC buffer is valid for the whole message.
+        let mut req = unsafe { make_request(ipc_buf, fmt) };
+        req.data.copy_from_slice(self.in_data);
+
+        for buf in &self.buffers[..self.buffer_count] {
+            match buf.kind {
+                BufferKind::In => req.add_in_buffer(buf.ptr, buf.size, buf.mode),
+                BufferKind::Out => req.add_out_buffer(buf.ptr.cast_mut(), buf.size, buf.mode),
+                BufferKind::InOut => req.add_inout_buffer(buf.ptr.cast_mut(), buf.size, buf.mode),
+            }
+        }
+        for handle in &self.in_handles[..self.in_handle_count] {
+            req.add_handle(*handle);
+        }
+
+        ipc::send_sync_request(self.session).map_err(DispatchError::SendRequest)?;
+
+        // SAFETY: The response is in the TLS buffer after a successful send.
+        unsafe { parse_response(ipc_buf, self.out_data_size) }.map_err(DispatchError::ParseResponse)
+    }
+
+    #[inline]
+    fn buffer(mut self, kind: BufferKind, ptr: *const u8, size: usize) -> Self {
+        if self.buffer_count < MAX_BUFFERS {
+            self.buffers[self.buffer_count] = BufferDesc {
+                kind,
+                ptr,
+                size,
+                mode: BufferMode::Normal,
+            };
+            self.buffer_count += 1;
+        } else {
+            self.overflowed = true;
+        }
+        self
+    }
+}
+
+/// Error returned by [`Dispatch::send`].
+#[derive(Debug, thiserror::Error)]
+pub enum DispatchError {
+    /// Failed to send the IPC request.
+    #[error("failed to send IPC request")]
+    SendRequest(#[source] ipc::SendSyncError),
+    /// Failed to parse the service response.
+    #[error("failed to parse response")]
+    ParseResponse(#[source] ParseResponseError),
+    /// More buffers or handles were added than the request holds.
+    #[error("too many buffers or handles in request")]
+    TooManyDescriptors,
+}
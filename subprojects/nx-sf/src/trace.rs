@@ -0,0 +1,183 @@
+//! # IPC latency tracing
+//!
+//! Per-command latency histograms, recorded when the `trace` feature is enabled.
+//!
+//! Every synchronous CMIF request sent through [`Dispatch::send`] or
+//! [`PreparedDispatch::send`] is timed from the copy of the request into the IPC buffer to
+//! the parsed response, and recorded under its session, domain object and request id, in
+//! a fixed, lock-free [`TraceTable`] of [`MAX_COMMANDS`] entries. Latencies go into log-scale
+//! buckets: bucket `i` counts the requests that took less than `2^i` system ticks, and at
+//! least `2^(i - 1)`.
+//!
+//! Requests of commands that find no entry are counted in [`dropped`], and otherwise lost.
+//!
+//! [`Dispatch::send`]: crate::service::Dispatch::send
+//! [`PreparedDispatch::send`]: crate::service::PreparedDispatch::send
+
+use core::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+
+use nx_cpu::control_regs;
+use nx_sys_sync::trace_table::TraceTable;
+
+/// Number of commands traced at once. A power of two.
+pub const MAX_COMMANDS: usize = 128;
+
+/// Number of latency buckets. The last one also counts every longer request.
+pub const NUM_BUCKETS: usize = 32;
+
+/// Latency histogram of a traced command.
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+pub struct CommandStats {
+    /// Raw session handle.
+    pub session: u32,
+    /// Domain object id, `0` outside of domains.
+    pub object_id: u32,
+    /// CMIF request id.
+    pub request_id: u32,
+    /// Requests that failed to be sent, or returned an error.
+    pub errors: u32,
+    /// Requests sent.
+    pub count: u64,
+    /// System ticks spent in requests.
+    pub total_ticks: u64,
+    /// Longest request, in system ticks.
+    pub max_ticks: u64,
+    /// Response payload bytes received.
+    pub response_bytes: u64,
+    /// Requests per latency bucket.
+    pub buckets: [u64; NUM_BUCKETS],
+}
+
+impl Default for CommandStats {
+    fn default() -> Self {
+        Self {
+            session: 0,
+            object_id: 0,
+            request_id: 0,
+            errors: 0,
+            count: 0,
+            total_ticks: 0,
+            max_ticks: 0,
+            response_bytes: 0,
+            buckets: [0; NUM_BUCKETS],
+        }
+    }
+}
+
+/// Counters of an entry of the command table, on cache lines of their own.
+#[repr(C, align(64))]
+struct Entry {
+    errors: AtomicU32,
+    count: AtomicU64,
+    total_ticks: AtomicU64,
+    max_ticks: AtomicU64,
+    response_bytes: AtomicU64,
+    buckets: [AtomicU64; NUM_BUCKETS],
+}
+
+impl Entry {
+    const fn new() -> Self {
+        Self {
+            errors: AtomicU32::new(0),
+            count: AtomicU64::new(0),
+            total_ticks: AtomicU64::new(0),
+            max_ticks: AtomicU64::new(0),
+            response_bytes: AtomicU64::new(0),
+            buckets: [const { AtomicU64::new(0) }; NUM_BUCKETS],
+        }
+    }
+
+    fn snapshot(&self, [session, object_id, request_id]: [u32; 3]) -> CommandStats {
+        CommandStats {
+            session,
+            object_id,
+            request_id,
+            errors: self.errors.load(Ordering::Relaxed),
+            count: self.count.load(Ordering::Relaxed),
+            total_ticks: self.total_ticks.load(Ordering::Relaxed),
+            max_ticks: self.max_ticks.load(Ordering::Relaxed),
+            response_bytes: self.response_bytes.load(Ordering::Relaxed),
+            buckets: core::array::from_fn(|i| self.buckets[i].load(Ordering::Relaxed)),
+        }
+    }
+
+    fn clear(&self) {
+        self.errors.store(0, Ordering::Relaxed);
+        self.count.store(0, Ordering::Relaxed);
+        self.total_ticks.store(0, Ordering::Relaxed);
+        self.max_ticks.store(0, Ordering::Relaxed);
+        self.response_bytes.store(0, Ordering::Relaxed);
+        for bucket in &self.buckets {
+            bucket.store(0, Ordering::Relaxed);
+        }
+    }
+}
+
+/// Command table, keyed by session, domain object and request id.
+static ENTRIES: TraceTable<Entry, 3, MAX_COMMANDS> =
+    TraceTable::new([const { Entry::new() }; MAX_COMMANDS]);
+
+/// Returns the current system tick, to time a request.
+#[inline]
+pub fn now() -> u64 {
+    // SAFETY: Reading the counter-timer has no side effects.
+    unsafe { control_regs::cntpct_el0() }
+}
+
+/// Records a request sent at the `start` tick, that just completed.
+///
+/// `response_size` is the size of the response payload, or `None` if the request failed.
+pub fn record(
+    session: u32,
+    object_id: u32,
+    request_id: u32,
+    start: u64,
+    response_size: Option<usize>,
+) {
+    let Some(entry) = ENTRIES.get([session, object_id, request_id]) else {
+        return;
+    };
+
+    let ticks = now().wrapping_sub(start);
+    let bucket = ((u64::BITS - ticks.leading_zeros()) as usize).min(NUM_BUCKETS - 1);
+
+    entry.count.fetch_add(1, Ordering::Relaxed);
+    entry.total_ticks.fetch_add(ticks, Ordering::Relaxed);
+    entry.max_ticks.fetch_max(ticks, Ordering::Relaxed);
+    entry.buckets[bucket].fetch_add(1, Ordering::Relaxed);
+    match response_size {
+        Some(size) => {
+            entry
+                .response_bytes
+                .fetch_add(size as u64, Ordering::Relaxed);
+        }
+        None => {
+            entry.errors.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+}
+
+/// Writes the histograms of the traced commands with the most total ticks to `out`, most
+/// first.
+///
+/// Returns the number of traced commands, which may exceed `out.len()`.
+pub fn snapshot(out: &mut [CommandStats]) -> usize {
+    ENTRIES.snapshot(
+        out,
+        |key, entry| entry.snapshot(key),
+        |stats| stats.total_ticks,
+    )
+}
+
+/// Returns the number of requests lost because no entry was available.
+pub fn dropped() -> u64 {
+    ENTRIES.dropped()
+}
+
+/// Clears the table.
+///
+/// Requests recorded concurrently may be lost, or land in a cleared entry.
+pub fn reset() {
+    ENTRIES.reset(Entry::clear);
+}
@@ -0,0 +1,322 @@
+//! Single-threaded task executor.
+//!
+//! Tasks are polled on the thread that created the [`Executor`], in the order they were
+//! woken. Once no task is left to poll, the thread parks in the [`Reactor`], until a
+//! handle signals, a timer expires or a waker is called from another thread.
+
+use alloc::{boxed::Box, rc::Rc, sync::Arc, task::Wake, vec::Vec};
+use core::{
+    cell::{Cell, RefCell},
+    future::Future,
+    pin::{Pin, pin},
+    sync::atomic::{AtomicBool, Ordering},
+    task::{Context, Poll, Waker},
+};
+
+use crate::reactor::{Reactor, Shared};
+
+/// Task identifier of the future driven by [`Executor::block_on`].
+const MAIN_TASK: usize = usize::MAX;
+
+/// A cooperative executor, running `!Send` tasks on the current thread.
+///
+/// Tasks must not block: a task blocked in a supervisor call blocks every other task.
+/// Kernel objects, IPC responses, timers and threads are awaited through the [`Reactor`]
+/// instead.
+///
+/// ```ignore
+/// use nx_std_async::Executor;
+///
+/// let executor = Executor::new();
+/// let reactor = executor.reactor();
+/// executor.block_on(async {
+///     let response = reactor.dispatch(dispatch.send_async(&mut buffer)?).await?;
+///     reactor.sleep(Duration::from_millis(16)).await;
+/// });
+/// ```
+pub struct Executor {
+    reactor: Reactor,
+    tasks: Rc<Tasks>,
+}
+
+impl Executor {
+    /// Creates an executor running its tasks on the current thread.
+    pub fn new() -> Self {
+        Self {
+            reactor: Reactor::new(nx_sys_thread::get_current_thread_handle()),
+            tasks: Rc::new(Tasks::new()),
+        }
+    }
+
+    /// Returns the reactor of this executor.
+    pub fn reactor(&self) -> Reactor {
+        self.reactor.clone()
+    }
+
+    /// Returns a handle spawning tasks on this executor, from its tasks.
+    pub fn spawner(&self) -> Spawner {
+        Spawner {
+            shared: self.reactor.shared().clone(),
+            tasks: self.tasks.clone(),
+        }
+    }
+
+    /// Spawns a task, polled once the executor runs.
+    pub fn spawn<F>(&self, future: F) -> JoinHandle<F::Output>
+    where
+        F: Future + 'static,
+    {
+        self.spawner().spawn(future)
+    }
+
+    /// Runs the spawned tasks until `future` completes, returning its output.
+    ///
+    /// Tasks still pending once it completes are kept, to be run by the next call. Must
+    /// not be called from a task.
+    pub fn block_on<F: Future>(&self, future: F) -> F::Output {
+        let main = Arc::new(TaskWaker::new(self.reactor.shared().clone(), MAIN_TASK));
+        let waker = Waker::from(main.clone());
+        let mut cx = Context::from_waker(&waker);
+        let mut future = pin!(future);
+
+        let mut poll_main = true;
+        loop {
+            if poll_main {
+                main.queued.store(false, Ordering::SeqCst);
+                if let Poll::Ready(output) = future.as_mut().poll(&mut cx) {
+                    return output;
+                }
+            }
+
+            poll_main = self.tick();
+            if !poll_main {
+                self.reactor.park();
+            }
+        }
+    }
+
+    /// Runs the spawned tasks until they all completed. Must not be called from a task.
+    pub fn run(&self) {
+        while self.tasks.live.get() > 0 {
+            self.tick();
+            if self.tasks.live.get() > 0 {
+                self.reactor.park();
+            }
+        }
+    }
+
+    /// Polls the tasks queued when called, returning `true` if the [`MAIN_TASK`] was woken.
+    ///
+    /// Tasks woken meanwhile wait for the next tick, so that tasks waking each other do not
+    /// keep the reactor from polling its handles.
+    fn tick(&self) -> bool {
+        let shared = self.reactor.shared();
+        let mut main_woken = false;
+        for _ in 0..shared.ready_len() {
+            match shared.pop_ready() {
+                Some(MAIN_TASK) => main_woken = true,
+                Some(id) => self.tasks.poll(id),
+                None => break,
+            }
+        }
+        main_woken
+    }
+}
+
+impl Default for Executor {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for Executor {
+    fn drop(&mut self) {
+        // Spawners held by the tasks would otherwise keep them alive
+        let tasks = core::mem::take(&mut *self.tasks.slots.borrow_mut());
+        drop(tasks);
+    }
+}
+
+/// Handle spawning tasks on an [`Executor`], returned by [`Executor::spawner`].
+#[derive(Clone)]
+pub struct Spawner {
+    shared: Arc<Shared>,
+    tasks: Rc<Tasks>,
+}
+
+impl Spawner {
+    /// Spawns a task, polled once the executor runs.
+    ///
+    /// Dropping the returned handle detaches the task.
+    pub fn spawn<F>(&self, future: F) -> JoinHandle<F::Output>
+    where
+        F: Future + 'static,
+    {
+        let state = Rc::new(RefCell::new(JoinState {
+            output: None,
+            waker: None,
+        }));
+
+        let task_state = state.clone();
+        let id = self.tasks.insert(
+            &self.shared,
+            Box::pin(async move {
+                let output = future.await;
+                let mut state = task_state.borrow_mut();
+                state.output = Some(output);
+                if let Some(waker) = state.waker.take() {
+                    waker.wake();
+                }
+            }),
+        );
+        self.shared.wake(id);
+
+        JoinHandle { state }
+    }
+}
+
+/// Handle to a spawned task, resolving to its output.
+pub struct JoinHandle<T> {
+    state: Rc<RefCell<JoinState<T>>>,
+}
+
+struct JoinState<T> {
+    output: Option<T>,
+    waker: Option<Waker>,
+}
+
+impl<T> JoinHandle<T> {
+    /// Returns `true` if the task completed.
+    pub fn is_finished(&self) -> bool {
+        self.state.borrow().output.is_some()
+    }
+}
+
+impl<T> Future for JoinHandle<T> {
+    type Output = T;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<T> {
+        let mut state = self.state.borrow_mut();
+        match state.output.take() {
+            Some(output) => Poll::Ready(output),
+            None => {
+                match &mut state.waker {
+                    Some(waker) => waker.clone_from(cx.waker()),
+                    None => state.waker = Some(cx.waker().clone()),
+                }
+                Poll::Pending
+            }
+        }
+    }
+}
+
+/// Spawned tasks, indexed by their identifier.
+struct Tasks {
+    slots: RefCell<Vec<Option<Task>>>,
+    /// Free slots, reused by the next spawns.
+    free: RefCell<Vec<usize>>,
+    /// Number of spawned tasks that did not complete yet.
+    live: Cell<usize>,
+}
+
+struct Task {
+    /// `None` while the task is being polled.
+    future: Option<Pin<Box<dyn Future<Output = ()>>>>,
+    state: Arc<TaskWaker>,
+    waker: Waker,
+}
+
+impl Tasks {
+    fn new() -> Self {
+        Self {
+            slots: RefCell::new(Vec::new()),
+            free: RefCell::new(Vec::new()),
+            live: Cell::new(0),
+        }
+    }
+
+    /// Stores a task, returning its identifier. The task starts queued.
+    fn insert(&self, shared: &Arc<Shared>, future: Pin<Box<dyn Future<Output = ()>>>) -> usize {
+        let mut slots = self.slots.borrow_mut();
+        let id = self.free.borrow_mut().pop().unwrap_or(slots.len());
+
+        let state = Arc::new(TaskWaker::new(shared.clone(), id));
+        state.queued.store(true, Ordering::Relaxed);
+        let task = Task {
+            future: Some(future),
+            waker: Waker::from(state.clone()),
+            state,
+        };
+        if id == slots.len() {
+            slots.push(Some(task));
+        } else {
+            slots[id] = Some(task);
+        }
+
+        self.live.set(self.live.get() + 1);
+        id
+    }
+
+    /// Polls the task `id`, dropping it if it completed.
+    ///
+    /// Stale identifiers, of completed tasks, are ignored.
+    fn poll(&self, id: usize) {
+        let (mut future, waker) = {
+            let mut slots = self.slots.borrow_mut();
+            let Some(Some(task)) = slots.get_mut(id) else {
+                return;
+            };
+            let Some(future) = task.future.take() else {
+                return;
+            };
+            task.state.queued.store(false, Ordering::SeqCst);
+            (future, task.waker.clone())
+        };
+
+        // Not holding the slots, so that the task can spawn others
+        let mut cx = Context::from_waker(&waker);
+        match future.as_mut().poll(&mut cx) {
+            Poll::Ready(()) => {
+                let task = self.slots.borrow_mut()[id].take();
+                self.free.borrow_mut().push(id);
+                self.live.set(self.live.get() - 1);
+                drop(task);
+                drop(future);
+            }
+            Poll::Pending => {
+                if let Some(Some(task)) = self.slots.borrow_mut().get_mut(id) {
+                    task.future = Some(future);
+                }
+            }
+        }
+    }
+}
+
+/// Waker of a task, queuing it on the executor at most once until it is polled.
+struct TaskWaker {
+    shared: Arc<Shared>,
+    id: usize,
+    queued: AtomicBool,
+}
+
+impl TaskWaker {
+    fn new(shared: Arc<Shared>, id: usize) -> Self {
+        Self {
+            shared,
+            id,
+            queued: AtomicBool::new(false),
+        }
+    }
+}
+
+impl Wake for TaskWaker {
+    fn wake(self: Arc<Self>) {
+        self.wake_by_ref();
+    }
+
+    fn wake_by_ref(self: &Arc<Self>) {
+        if !self.queued.swap(true, Ordering::SeqCst) {
+            self.shared.wake(self.id);
+        }
+    }
+}
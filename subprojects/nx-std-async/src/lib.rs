@@ -0,0 +1,25 @@
+//! # nx-std-async
+//!
+//! A cooperative, single-threaded async executor whose reactor waits on kernel objects.
+//!
+//! The [`Executor`] polls its tasks on the current thread, and parks it in a single
+//! `svcWaitSynchronization` over every handle its tasks await once none is left to poll.
+//! Futures for the kernel objects, asynchronous IPC dispatches, timers and pooled threads
+//! are created by the [`Reactor`]; the one-shot channel receiver of `nx-std-sync` can be
+//! awaited directly.
+#![no_std]
+
+extern crate nx_panic_handler as _; // provides #[panic_handler]
+
+// The `alloc` crate enables memory allocation.
+extern crate alloc;
+// The `nx-alloc` crate exposes the `#[global_allocator]` for the dependent crates.
+extern crate nx_alloc;
+
+pub mod executor;
+pub mod reactor;
+
+pub use self::{
+    executor::{Executor, JoinHandle, Spawner},
+    reactor::Reactor,
+};
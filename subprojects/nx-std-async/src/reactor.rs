@@ -0,0 +1,555 @@
+//! Kernel wait object reactor.
+//!
+//! The reactor parks the executor thread in a single `svcWaitSynchronization` over the
+//! handles awaited by its tasks, with the nearest timer deadline as timeout. Wakers called
+//! from other threads interrupt the wait with `svcCancelSynchronization` on the executor
+//! thread, so that no wake event is needed.
+//!
+//! Waits on more than [`MAX_WAIT_HANDLES`] handles are split: every handle is polled by a
+//! zero-timeout wait on each park, and the blocking wait goes over a batch of
+//! [`MAX_WAIT_HANDLES`] that rotates between parks, for at most [`POLL_INTERVAL`] so that
+//! the handles outside of the batch are not starved.
+
+use alloc::{
+    collections::{BTreeMap, VecDeque},
+    rc::Rc,
+    sync::Arc,
+    vec::Vec,
+};
+use core::{
+    cell::RefCell,
+    future::Future,
+    marker::PhantomData,
+    pin::Pin,
+    sync::atomic::{self, AtomicU8, Ordering},
+    task::{Context, Poll, Waker, ready},
+    time::Duration,
+};
+
+use nx_sf::service::{AsyncDispatchError, DispatchResult, PendingDispatch};
+use nx_std_sync::mutex::Mutex;
+use nx_svc::{
+    raw::{Handle, INVALID_HANDLE},
+    sync::{self as svc_sync, MAX_WAIT_HANDLES, WaitSyncError, Waitable},
+    thread::Handle as ThreadHandle,
+};
+use nx_sys_thread::{WaitForExitError, pool::PooledThread};
+use nx_time::{
+    Instant,
+    wheel::{TimerKey, TimerWheel},
+};
+
+/// Longest blocking wait while more than [`MAX_WAIT_HANDLES`] handles are awaited.
+pub const POLL_INTERVAL: Duration = Duration::from_millis(1);
+
+/// Resolution of the timer wheel: deadlines are rounded up to the next 100 µs.
+pub const TIMER_RESOLUTION: Duration = Duration::from_micros(100);
+
+/// Interval between the checks of [`Shared::unpark`] for a waker issuing its cancellation.
+const UNPARK_POLL_NS: u64 = 1_000;
+
+/// The executor thread is running tasks.
+const RUNNING: u8 = 0;
+/// The executor thread is, or is about to be, blocked in the reactor wait.
+const PARKED: u8 = 1;
+/// A waker is cancelling the reactor wait.
+const CANCELLING: u8 = 2;
+/// A waker cancelled the reactor wait, or the next one.
+const CANCELLED: u8 = 3;
+
+/// State shared with the wakers, which may be called from any thread.
+pub(crate) struct Shared {
+    /// Handle of the executor thread, the target of the cancellations.
+    thread: ThreadHandle,
+    park: AtomicU8,
+    /// Identifiers of the woken tasks.
+    ready: Mutex<VecDeque<usize>>,
+}
+
+impl Shared {
+    pub(crate) fn new(thread: ThreadHandle) -> Self {
+        Self {
+            thread,
+            park: AtomicU8::new(RUNNING),
+            ready: Mutex::new(VecDeque::new()),
+        }
+    }
+
+    /// Queues the task `id` to be polled, interrupting the reactor wait if the executor
+    /// thread is parked.
+    pub(crate) fn wake(&self, id: usize) {
+        self.ready.lock().push_back(id);
+
+        // Pairs with the fence of `park`: either the executor thread sees the queued
+        // task, or this sees it parked
+        atomic::fence(Ordering::SeqCst);
+        if self
+            .park
+            .compare_exchange(PARKED, CANCELLING, Ordering::SeqCst, Ordering::Relaxed)
+            .is_ok()
+        {
+            let _ = svc_sync::cancel_synchronization(&self.thread);
+            self.park.store(CANCELLED, Ordering::Release);
+        }
+    }
+
+    /// Returns the number of woken tasks.
+    pub(crate) fn ready_len(&self) -> usize {
+        self.ready.lock().len()
+    }
+
+    /// Returns the next woken task, if any.
+    pub(crate) fn pop_ready(&self) -> Option<usize> {
+        self.ready.lock().pop_front()
+    }
+
+    /// Marks the executor thread as parked, returning `false` if a task is already queued.
+    fn park(&self) -> bool {
+        self.park.store(PARKED, Ordering::SeqCst);
+        atomic::fence(Ordering::SeqCst);
+        self.ready.lock().is_empty()
+    }
+
+    /// Marks the executor thread as running again, after a park.
+    fn unpark(&self) {
+        loop {
+            match self
+                .park
+                .compare_exchange(PARKED, RUNNING, Ordering::Acquire, Ordering::Acquire)
+            {
+                Ok(_) => return,
+                // The waker is issuing its cancellation. Sleep rather than spin or yield:
+                // the waker may run on a lower-priority thread of the same core
+                Err(CANCELLING) => nx_svc::thread::sleep(UNPARK_POLL_NS),
+                Err(_) => {
+                    // The cancellation may have interrupted the last wait, or be pending for
+                    // the next one: consume it, so that it does not fail an unrelated wait of
+                    // the thread. A zero timeout would time out before checking it.
+                    // SAFETY: No handle is waited on.
+                    let _ = unsafe { svc_sync::wait_synchronization(&[], 1) };
+                    self.park.store(RUNNING, Ordering::Relaxed);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+/// Identifier of a registered wait.
+pub(crate) type WaitId = u64;
+
+/// Registered waits and timers, only accessed from the executor thread.
+pub(crate) struct Io {
+    next_id: WaitId,
+    waits: Vec<Wait>,
+    /// Results of the completed waits, until their future is polled.
+    fired: BTreeMap<WaitId, Result<(), WaitSyncError>>,
+    /// Wakers of the pending timers.
+    timers: TimerWheel<Waker>,
+    /// First wait of the next blocking batch, with more than [`MAX_WAIT_HANDLES`] waits.
+    cursor: usize,
+}
+
+struct Wait {
+    id: WaitId,
+    handle: Handle,
+    waker: Waker,
+}
+
+impl Io {
+    pub(crate) fn new() -> Self {
+        Self {
+            next_id: 0,
+            waits: Vec::new(),
+            fired: BTreeMap::new(),
+            timers: TimerWheel::new(TIMER_RESOLUTION),
+            cursor: 0,
+        }
+    }
+
+    fn next_id(&mut self) -> WaitId {
+        let id = self.next_id;
+        self.next_id += 1;
+        id
+    }
+
+    /// Registers a wait for `handle`, waking `waker` once it signals.
+    pub(crate) fn register(&mut self, handle: Handle, waker: &Waker) -> WaitId {
+        let id = self.next_id();
+        self.waits.push(Wait {
+            id,
+            handle,
+            waker: waker.clone(),
+        });
+        id
+    }
+
+    /// Returns the result of the wait `id` if it completed, or updates its waker.
+    pub(crate) fn poll_wait(
+        &mut self,
+        id: WaitId,
+        waker: &Waker,
+    ) -> Option<Result<(), WaitSyncError>> {
+        if let Some(res) = self.fired.remove(&id) {
+            return Some(res);
+        }
+        if let Some(wait) = self.waits.iter_mut().find(|wait| wait.id == id) {
+            wait.waker.clone_from(waker);
+        }
+        None
+    }
+
+    /// Drops the wait `id`, completed or not.
+    pub(crate) fn deregister(&mut self, id: WaitId) {
+        if self.fired.remove(&id).is_none()
+            && let Some(index) = self.waits.iter().position(|wait| wait.id == id)
+        {
+            self.waits.swap_remove(index);
+        }
+    }
+
+    /// Updates the waker of the timer `key`, or starts a timer expiring at `deadline` if
+    /// there is none pending.
+    fn poll_timer(&mut self, key: &mut Option<TimerKey>, deadline: Instant, waker: &Waker) {
+        if let Some(timer_waker) = key.and_then(|key| self.timers.get_mut(key)) {
+            timer_waker.clone_from(waker);
+        } else {
+            *key = Some(self.timers.insert(deadline, waker.clone()));
+        }
+    }
+
+    /// Wakes the expired timers, returning the time left until the next one expires.
+    fn expire_timers(&mut self) -> Option<Duration> {
+        let now = Instant::now();
+        self.timers.advance(now, |_, waker| waker.wake());
+        self.timers
+            .next_deadline()
+            .map(|deadline| deadline.saturating_duration_since(now))
+    }
+
+    /// Completes every wait on `handle`.
+    fn fire(&mut self, handle: Handle) {
+        let mut index = 0;
+        while index < self.waits.len() {
+            if self.waits[index].handle == handle {
+                let wait = self.waits.swap_remove(index);
+                self.fired.insert(wait.id, Ok(()));
+                wait.waker.wake();
+            } else {
+                index += 1;
+            }
+        }
+    }
+
+    /// Completes the waits of `batch` whose handle is signaled, or fails, after a wait on
+    /// the batch failed without telling which handle caused it.
+    fn probe(&mut self, batch: &[Handle]) {
+        let mut index = 0;
+        while index < self.waits.len() {
+            let handle = self.waits[index].handle;
+            if !batch.contains(&handle) {
+                index += 1;
+                continue;
+            }
+
+            // SAFETY: Registered handles stay open while their wait is registered.
+            let res = match unsafe { svc_sync::wait_synchronization(&[handle], 0) } {
+                Ok(_) => Ok(()),
+                Err(WaitSyncError::TimedOut) => {
+                    index += 1;
+                    continue;
+                }
+                Err(err) => Err(err),
+            };
+            let wait = self.waits.swap_remove(index);
+            self.fired.insert(wait.id, res);
+            wait.waker.wake();
+        }
+    }
+
+    /// Waits on `batch` for up to `timeout` nanoseconds, completing the waits of the
+    /// signaled handle. Returns `true` if a handle signaled, or a wait failed.
+    fn wait_batch(&mut self, batch: &[Handle], timeout: u64) -> bool {
+        // SAFETY: Registered handles stay open while their wait is registered.
+        match unsafe { svc_sync::wait_synchronization(batch, timeout) } {
+            Ok(index) if index < batch.len() => {
+                self.fire(batch[index]);
+                true
+            }
+            Ok(_) | Err(WaitSyncError::TimedOut | WaitSyncError::Cancelled) => false,
+            Err(_) => {
+                self.probe(batch);
+                true
+            }
+        }
+    }
+}
+
+/// Handle to the reactor of an [`Executor`](crate::Executor), creating the futures that
+/// wait on kernel objects and timers.
+///
+/// The futures must be awaited by tasks of the executor the reactor belongs to.
+#[derive(Clone)]
+pub struct Reactor {
+    inner: Rc<Inner>,
+}
+
+struct Inner {
+    shared: Arc<Shared>,
+    io: RefCell<Io>,
+}
+
+impl Reactor {
+    pub(crate) fn new(thread: ThreadHandle) -> Self {
+        Self {
+            inner: Rc::new(Inner {
+                shared: Arc::new(Shared::new(thread)),
+                io: RefCell::new(Io::new()),
+            }),
+        }
+    }
+
+    pub(crate) fn shared(&self) -> &Arc<Shared> {
+        &self.inner.shared
+    }
+
+    /// Returns a future resolving once `object` is signaled.
+    ///
+    /// The signal is not cleared: a readable event must be reset by the caller before
+    /// being waited on again.
+    ///
+    /// # Safety
+    ///
+    /// The handle of `object` must be valid, owned by the current process, not one of the
+    /// [`CUR_THREAD_HANDLE`] or [`CUR_PROCESS_HANDLE`] pseudo-handles, and must stay
+    /// open while the returned future is alive.
+    ///
+    /// [`CUR_THREAD_HANDLE`]: nx_svc::raw::CUR_THREAD_HANDLE
+    /// [`CUR_PROCESS_HANDLE`]: nx_svc::raw::CUR_PROCESS_HANDLE
+    pub unsafe fn wait<'a, W: Waitable>(&self, object: &'a W) -> Signaled<'a> {
+        Signaled {
+            registration: Registration::new(self, object.raw_handle()),
+            _object: PhantomData,
+        }
+    }
+
+    /// Returns a future resolving once `duration` elapsed.
+    pub fn sleep(&self, duration: Duration) -> Sleep {
+        Sleep {
+            reactor: self.clone(),
+            deadline: Instant::now().checked_add(duration),
+            key: None,
+        }
+    }
+
+    /// Returns a future resolving at `deadline`.
+    pub fn sleep_until(&self, deadline: Instant) -> Sleep {
+        Sleep {
+            reactor: self.clone(),
+            deadline: Some(deadline),
+            key: None,
+        }
+    }
+
+    /// Returns a future resolving to the response of an asynchronous dispatch.
+    ///
+    /// Dropping the future before the response arrived blocks the executor thread until it
+    /// does, as dropping the [`PendingDispatch`] would.
+    pub fn dispatch<'b>(&self, pending: PendingDispatch<'b>) -> Dispatched<'b> {
+        Dispatched {
+            registration: Registration::new(self, pending.event().raw_handle()),
+            pending: Some(pending),
+        }
+    }
+
+    /// Returns a future resolving once `thread` exited, then giving its stack back to the
+    /// pool.
+    ///
+    /// The thread must have been started. Dropping the future before the thread exited
+    /// blocks the executor thread until it does, as dropping the [`PooledThread`] would.
+    pub fn join(&self, thread: PooledThread) -> Joined {
+        Joined {
+            registration: Registration::new(self, thread.handle().raw_handle()),
+            thread: Some(thread),
+        }
+    }
+
+    /// Parks the executor thread until a task is woken, a registered handle signals or the
+    /// nearest timer expires.
+    ///
+    /// If a task is already queued, the handles are only polled.
+    pub(crate) fn park(&self) {
+        let shared = &*self.inner.shared;
+        let mut io = self.inner.io.borrow_mut();
+        let next_timer = io.expire_timers();
+
+        let count = io.waits.len();
+        if count > MAX_WAIT_HANDLES {
+            let raw: Vec<Handle> = io.waits.iter().map(|wait| wait.handle).collect();
+            let mut signaled = false;
+            for chunk in raw.chunks(MAX_WAIT_HANDLES) {
+                signaled |= io.wait_batch(chunk, 0);
+            }
+            if signaled {
+                return;
+            }
+        }
+
+        let start = if count > MAX_WAIT_HANDLES {
+            io.cursor % count
+        } else {
+            0
+        };
+        let mut handles = [INVALID_HANDLE; MAX_WAIT_HANDLES];
+        let batch_len = count.min(MAX_WAIT_HANDLES);
+        for (i, handle) in handles[..batch_len].iter_mut().enumerate() {
+            *handle = io.waits[(start + i) % count].handle;
+        }
+        io.cursor = start + batch_len;
+        let batch = &handles[..batch_len];
+
+        if !shared.park() {
+            shared.unpark();
+            if count <= MAX_WAIT_HANDLES && count > 0 {
+                io.wait_batch(batch, 0);
+            }
+            return;
+        }
+
+        let mut timeout = next_timer.unwrap_or(Duration::MAX);
+        if count > MAX_WAIT_HANDLES {
+            timeout = timeout.min(POLL_INTERVAL);
+        }
+        io.wait_batch(batch, timeout.as_nanos().min(u64::MAX as u128) as u64);
+        shared.unpark();
+
+        io.expire_timers();
+    }
+}
+
+/// A wait registered with the reactor on the first poll of its future.
+struct Registration {
+    reactor: Reactor,
+    handle: Handle,
+    id: Option<WaitId>,
+}
+
+impl Registration {
+    fn new(reactor: &Reactor, handle: Handle) -> Self {
+        Self {
+            reactor: reactor.clone(),
+            handle,
+            id: None,
+        }
+    }
+
+    fn poll(&mut self, cx: &mut Context<'_>) -> Poll<Result<(), WaitSyncError>> {
+        let mut io = self.reactor.inner.io.borrow_mut();
+        let Some(id) = self.id else {
+            self.id = Some(io.register(self.handle, cx.waker()));
+            return Poll::Pending;
+        };
+
+        match io.poll_wait(id, cx.waker()) {
+            Some(res) => {
+                self.id = None;
+                Poll::Ready(res)
+            }
+            None => Poll::Pending,
+        }
+    }
+}
+
+impl Drop for Registration {
+    fn drop(&mut self) {
+        if let Some(id) = self.id {
+            self.reactor.inner.io.borrow_mut().deregister(id);
+        }
+    }
+}
+
+/// Future returned by [`Reactor::wait`], resolving once its object is signaled.
+pub struct Signaled<'a> {
+    registration: Registration,
+    _object: PhantomData<&'a ()>,
+}
+
+impl Future for Signaled<'_> {
+    type Output = Result<(), WaitSyncError>;
+
+    fn poll(mut self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        self.registration.poll(cx)
+    }
+}
+
+/// Future returned by [`Reactor::sleep`] and [`Reactor::sleep_until`], resolving at its
+/// deadline.
+pub struct Sleep {
+    reactor: Reactor,
+    /// `None` if the deadline overflowed: the future never resolves.
+    deadline: Option<Instant>,
+    key: Option<TimerKey>,
+}
+
+impl Future for Sleep {
+    type Output = ();
+
+    fn poll(mut self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<()> {
+        let Some(deadline) = self.deadline else {
+            return Poll::Pending;
+        };
+        let this = &mut *self;
+        let mut io = this.reactor.inner.io.borrow_mut();
+        if Instant::now() >= deadline {
+            if let Some(key) = this.key.take() {
+                io.timers.remove(key);
+            }
+            return Poll::Ready(());
+        }
+
+        io.poll_timer(&mut this.key, deadline, cx.waker());
+        Poll::Pending
+    }
+}
+
+impl Drop for Sleep {
+    fn drop(&mut self) {
+        if let Some(key) = self.key {
+            self.reactor.inner.io.borrow_mut().timers.remove(key);
+        }
+    }
+}
+
+/// Future returned by [`Reactor::dispatch`], resolving to the response of its dispatch.
+pub struct Dispatched<'b> {
+    registration: Registration,
+    pending: Option<PendingDispatch<'b>>,
+}
+
+impl<'b> Future for Dispatched<'b> {
+    type Output = Result<DispatchResult<'b>, AsyncDispatchError>;
+
+    fn poll(mut self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        // A failed wait is reported by the blocking one of the dispatch
+        ready!(self.registration.poll(cx)).ok();
+        let pending = self.pending.take().expect("dispatch already completed");
+        Poll::Ready(pending.wait())
+    }
+}
+
+/// Future returned by [`Reactor::join`], resolving once its thread exited.
+pub struct Joined {
+    registration: Registration,
+    thread: Option<PooledThread>,
+}
+
+impl Future for Joined {
+    type Output = Result<(), WaitForExitError>;
+
+    fn poll(mut self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        // A failed wait is reported by the blocking one of the join
+        ready!(self.registration.poll(cx)).ok();
+        let thread = self.thread.take().expect("thread already joined");
+        Poll::Ready(thread.join())
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Opaque struct for the sending-half of a bounded channel.
+typedef struct NxSyncChannelSender NxSyncChannelSender;
+
+/// Opaque struct for the receiving-half of a bounded channel.
+typedef struct NxSyncChannelReceiver NxSyncChannelReceiver;
+
+/**
+ * @brief Creates a new bounded multi-producer, multi-consumer channel.
+ * @param[in] capacity Maximum number of queued values, rounded up to the next power of two.
+ * @param[out] sender Pointer to write the created sender to.
+ * @param[out] receiver Pointer to write the created receiver to.
+ * @return 0 on success, -1 if `capacity` is zero or an output pointer is `NULL`.
+ * @remark The caller is responsible for freeing the sender and receiver with the appropriate `free` functions.
+ */
+int32_t __nx_std_sync__channel_create(size_t capacity, NxSyncChannelSender** sender, NxSyncChannelReceiver** receiver);
+
+/**
+ * @brief Creates a new sender for the same channel.
+ * @param[in] sender The sender to clone.
+ * @return The new sender, or `NULL` if `sender` is `NULL`.
+ */
+NxSyncChannelSender* __nx_std_sync__channel_sender_clone(const NxSyncChannelSender* sender);
+
+/**
+ * @brief Creates a new receiver for the same channel.
+ * @param[in] receiver The receiver to clone.
+ * @return The new receiver, or `NULL` if `receiver` is `NULL`.
+ */
+NxSyncChannelReceiver* __nx_std_sync__channel_receiver_clone(const NxSyncChannelReceiver* receiver);
+
+/**
+ * @brief Frees a `NxSyncChannelSender`.
+ * @param[in] sender The sender to free.
+ * @note If `sender` is `NULL`, this function does nothing.
+ */
+void __nx_std_sync__channel_sender_free(NxSyncChannelSender* sender);
+
+/**
+ * @brief Frees a `NxSyncChannelReceiver`.
+ * @param[in] receiver The receiver to free.
+ * @note If `receiver` is `NULL`, this function does nothing.
+ */
+void __nx_std_sync__channel_receiver_free(NxSyncChannelReceiver* receiver);
+
+/**
+ * @brief Sends a value, blocking while the channel is full.
+ * @param[in] sender The sender.
+ * @param[in] value The value to send (void*).
+ * @return 0 on success, -1 if all receivers were freed.
+ */
+int32_t __nx_std_sync__channel_send(const NxSyncChannelSender* sender, void* value);
+
+/**
+ * @brief Sends a value without blocking.
+ * @param[in] sender The sender.
+ * @param[in] value The value to send (void*).
+ * @return 0 on success, 1 if the channel is full, -1 if all receivers were freed.
+ */
+int32_t __nx_std_sync__channel_try_send(const NxSyncChannelSender* sender, void* value);
+
+/**
+ * @brief Receives a value, blocking while the channel is empty.
+ * @param[in] receiver The receiver.
+ * @param[out] out_value Pointer to write the received value to.
+ * @return 0 on success, -1 if the channel is empty and all senders were freed.
+ */
+int32_t __nx_std_sync__channel_recv(const NxSyncChannelReceiver* receiver, void** out_value);
+
+/**
+ * @brief Receives a value without blocking.
+ * @param[in] receiver The receiver.
+ * @param[out] out_value Pointer to write the received value to.
+ * @return 0 on success, 1 if the channel is empty, -1 if it is empty and all senders were freed.
+ */
+int32_t __nx_std_sync__channel_try_recv(const NxSyncChannelReceiver* receiver, void** out_value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,21 +1,16 @@
 //! # Barrier
+//!
+//! Backed by the generation-counted [`sys::Barrier`]: arrivals are a single atomic increment
+//! and the last thread wakes all waiters with one signal.
 
 use core::fmt;
 
-use crate::{condvar::Condvar, mutex::Mutex};
+use nx_sys_sync as sys;
 
 /// A barrier enables multiple threads to synchronize the beginning
 /// of some computation.
 pub struct Barrier {
-    lock: Mutex<BarrierState>,
-    cvar: Condvar,
-    num_threads: usize,
-}
-
-// The inner state of a double barrier
-struct BarrierState {
-    count: usize,
-    generation_id: usize,
+    inner: sys::Barrier,
 }
 
 /// A `BarrierWaitResult` is returned by [`Barrier::wait()`] when all threads
@@ -39,12 +34,18 @@ impl Barrier {
     #[inline]
     pub const fn new(n: usize) -> Barrier {
         Barrier {
-            lock: Mutex::new(BarrierState {
-                count: 0,
-                generation_id: 0,
-            }),
-            cvar: Condvar::new(),
-            num_threads: n,
+            inner: sys::Barrier::new(n as u64),
+        }
+    }
+
+    /// Creates a new barrier whose waiters spin up to `spins` iterations before blocking.
+    ///
+    /// See [`Barrier::new`].
+    #[must_use]
+    #[inline]
+    pub const fn with_spins(n: usize, spins: u32) -> Barrier {
+        Barrier {
+            inner: sys::Barrier::with_spins(n as u64, spins),
         }
     }
 
@@ -58,20 +59,7 @@ impl Barrier {
     /// from this function, and all other threads will receive a result that
     /// will return `false` from [`BarrierWaitResult::is_leader()`].
     pub fn wait(&self) -> BarrierWaitResult {
-        let mut lock = self.lock.lock();
-        let local_gen = lock.generation_id;
-        lock.count += 1;
-        if lock.count < self.num_threads {
-            let _guard = self
-                .cvar
-                .wait_while(lock, |state| local_gen == state.generation_id);
-            BarrierWaitResult(false)
-        } else {
-            lock.count = 0;
-            lock.generation_id = lock.generation_id.wrapping_add(1);
-            self.cvar.notify_all();
-            BarrierWaitResult(true)
-        }
+        BarrierWaitResult(self.inner.wait().is_leader())
     }
 }
 
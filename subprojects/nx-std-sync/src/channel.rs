@@ -0,0 +1,430 @@
+//! A bounded, blocking, multi-producer, multi-consumer channel.
+//!
+//! Messages are stored in a fixed ring buffer allocated once at creation, so sending does not
+//! allocate. Each slot carries a sequence number (Vyukov's bounded MPMC queue): producers and
+//! consumers claim positions with a single CAS and hand over slots by publishing the next
+//! sequence number. Slots and the two cursors are cache-line padded to avoid false sharing.
+//!
+//! Threads only block, through a futex event counter, when the channel is full (senders) or
+//! empty (receivers); the opposite side only signals when somebody is waiting.
+
+use alloc::{boxed::Box, sync::Arc};
+use core::{
+    cell::UnsafeCell,
+    fmt,
+    mem::MaybeUninit,
+    ops::Deref,
+    sync::atomic::{self, AtomicU32, AtomicUsize, Ordering},
+};
+
+use nx_sys_sync::futex;
+
+/// Creates a bounded channel holding up to `capacity` messages.
+///
+/// The capacity is rounded up to the next power of two.
+///
+/// # Panics
+///
+/// Panics if `capacity` is zero or the buffer cannot be allocated.
+pub fn bounded<T>(capacity: usize) -> (Sender<T>, Receiver<T>) {
+    let inner = Arc::new(Shared::new(capacity));
+    let sender = Sender {
+        inner: inner.clone(),
+    };
+    let receiver = Receiver { inner };
+    (sender, receiver)
+}
+
+/// The sending-half of a bounded channel.
+///
+/// Senders can be cloned to send from multiple threads.
+pub struct Sender<T> {
+    inner: Arc<Shared<T>>,
+}
+
+impl<T> Sender<T> {
+    /// Sends a value, blocking while the channel is full.
+    ///
+    /// Returns the value back if all receivers have been dropped.
+    pub fn send(&self, value: T) -> Result<(), SendError<T>> {
+        let mut value = value;
+        loop {
+            match self.try_send(value) {
+                Ok(()) => return Ok(()),
+                Err(TrySendError::Disconnected(v)) => return Err(SendError(v)),
+                Err(TrySendError::Full(v)) => value = v,
+            }
+
+            let epoch = self.inner.send_event.load(Ordering::SeqCst);
+            self.inner.send_waiters.fetch_add(1, Ordering::SeqCst);
+
+            // Re-check after registering, a receiver may have freed a slot in between
+            match self.inner.push(value) {
+                Ok(()) => {
+                    self.inner.send_waiters.fetch_sub(1, Ordering::Relaxed);
+                    self.inner.notify_receivers();
+                    return Ok(());
+                }
+                Err(v) => value = v,
+            }
+            if !self.inner.is_disconnected() {
+                futex::wait(&self.inner.send_event, epoch);
+            }
+
+            self.inner.send_waiters.fetch_sub(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Attempts to send a value without blocking.
+    pub fn try_send(&self, value: T) -> Result<(), TrySendError<T>> {
+        if self.inner.receivers.load(Ordering::Acquire) == 0 {
+            return Err(TrySendError::Disconnected(value));
+        }
+
+        match self.inner.push(value) {
+            Ok(()) => {
+                self.inner.notify_receivers();
+                Ok(())
+            }
+            Err(v) => Err(TrySendError::Full(v)),
+        }
+    }
+
+    /// Returns the capacity of the channel.
+    pub fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl<T> Clone for Sender<T> {
+    fn clone(&self) -> Self {
+        self.inner.senders.fetch_add(1, Ordering::Relaxed);
+        Self {
+            inner: self.inner.clone(),
+        }
+    }
+}
+
+impl<T> Drop for Sender<T> {
+    fn drop(&mut self) {
+        if self.inner.senders.fetch_sub(1, Ordering::AcqRel) == 1 {
+            self.inner.recv_event.fetch_add(1, Ordering::SeqCst);
+            futex::wake_all(&self.inner.recv_event);
+        }
+    }
+}
+
+impl<T> fmt::Debug for Sender<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("Sender").finish_non_exhaustive()
+    }
+}
+
+/// The receiving-half of a bounded channel.
+///
+/// Receivers can be cloned to receive from multiple threads; each message is delivered to
+/// exactly one receiver.
+pub struct Receiver<T> {
+    inner: Arc<Shared<T>>,
+}
+
+impl<T> Receiver<T> {
+    /// Receives a value, blocking while the channel is empty.
+    ///
+    /// Returns an error once the channel is empty and all senders have been dropped.
+    pub fn recv(&self) -> Result<T, RecvError> {
+        loop {
+            match self.try_recv() {
+                Ok(value) => return Ok(value),
+                Err(TryRecvError::Disconnected) => return Err(RecvError),
+                Err(TryRecvError::Empty) => {}
+            }
+
+            let epoch = self.inner.recv_event.load(Ordering::SeqCst);
+            self.inner.recv_waiters.fetch_add(1, Ordering::SeqCst);
+
+            // Re-check after registering, a sender may have pushed in between
+            if let Some(value) = self.inner.pop() {
+                self.inner.recv_waiters.fetch_sub(1, Ordering::Relaxed);
+                self.inner.notify_senders();
+                return Ok(value);
+            }
+            if self.inner.senders.load(Ordering::Acquire) != 0 {
+                futex::wait(&self.inner.recv_event, epoch);
+            }
+
+            self.inner.recv_waiters.fetch_sub(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Attempts to receive a value without blocking.
+    pub fn try_recv(&self) -> Result<T, TryRecvError> {
+        if let Some(value) = self.inner.pop() {
+            self.inner.notify_senders();
+            return Ok(value);
+        }
+
+        if self.inner.senders.load(Ordering::Acquire) != 0 {
+            return Err(TryRecvError::Empty);
+        }
+
+        // The last sender may have pushed right before disconnecting
+        match self.inner.pop() {
+            Some(value) => Ok(value),
+            None => Err(TryRecvError::Disconnected),
+        }
+    }
+
+    /// Returns the capacity of the channel.
+    pub fn capacity(&self) -> usize {
+        self.inner.capacity()
+    }
+}
+
+impl<T> Clone for Receiver<T> {
+    fn clone(&self) -> Self {
+        self.inner.receivers.fetch_add(1, Ordering::Relaxed);
+        Self {
+            inner: self.inner.clone(),
+        }
+    }
+}
+
+impl<T> Drop for Receiver<T> {
+    fn drop(&mut self) {
+        if self.inner.receivers.fetch_sub(1, Ordering::AcqRel) == 1 {
+            self.inner.send_event.fetch_add(1, Ordering::SeqCst);
+            futex::wake_all(&self.inner.send_event);
+        }
+    }
+}
+
+impl<T> fmt::Debug for Receiver<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("Receiver").finish_non_exhaustive()
+    }
+}
+
+/// An error returned from [`Sender::send`] when all receivers have been dropped.
+///
+/// The error contains the value that was attempted to be sent.
+#[derive(PartialEq, Eq, Clone, Copy, thiserror::Error)]
+#[error("channel closed")]
+pub struct SendError<T>(pub T);
+
+impl<T> fmt::Debug for SendError<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("SendError").finish_non_exhaustive()
+    }
+}
+
+/// An error returned from [`Sender::try_send`].
+#[derive(PartialEq, Eq, Clone, Copy, thiserror::Error)]
+pub enum TrySendError<T> {
+    /// The channel is full.
+    #[error("channel full")]
+    Full(T),
+    /// All receivers have been dropped.
+    #[error("channel closed")]
+    Disconnected(T),
+}
+
+impl<T> fmt::Debug for TrySendError<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            TrySendError::Full(_) => f.write_str("Full(..)"),
+            TrySendError::Disconnected(_) => f.write_str("Disconnected(..)"),
+        }
+    }
+}
+
+/// An error returned from [`Receiver::recv`] when the channel is empty and all senders have
+/// been dropped.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, thiserror::Error)]
+#[error("channel closed")]
+pub struct RecvError;
+
+/// An error returned from [`Receiver::try_recv`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq, thiserror::Error)]
+pub enum TryRecvError {
+    /// The channel is empty.
+    #[error("channel empty")]
+    Empty,
+    /// The channel is empty and all senders have been dropped.
+    #[error("channel closed")]
+    Disconnected,
+}
+
+/// A value aligned to its own cache line.
+#[repr(align(64))]
+struct CachePadded<T>(T);
+
+impl<T> Deref for CachePadded<T> {
+    type Target = T;
+
+    fn deref(&self) -> &T {
+        &self.0
+    }
+}
+
+/// A ring buffer slot.
+struct Slot<T> {
+    /// `pos` when free for the producer at `pos`, `pos + 1` when filled for the consumer at
+    /// `pos`.
+    seq: AtomicUsize,
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+/// The internal shared state of the channel.
+struct Shared<T> {
+    /// Next position to push to.
+    head: CachePadded<AtomicUsize>,
+    /// Next position to pop from.
+    tail: CachePadded<AtomicUsize>,
+    buffer: Box<[CachePadded<Slot<T>>]>,
+    mask: usize,
+    senders: AtomicUsize,
+    receivers: AtomicUsize,
+    /// Event counter receivers block on, bumped when a message is pushed or on disconnect.
+    recv_event: AtomicU32,
+    recv_waiters: AtomicU32,
+    /// Event counter senders block on, bumped when a slot is freed or on disconnect.
+    send_event: AtomicU32,
+    send_waiters: AtomicU32,
+}
+
+// SAFETY: Slot values are handed over between threads through the sequence protocol.
+unsafe impl<T: Send> Send for Shared<T> {}
+// SAFETY: See above; every slot is accessed by a single thread at a time.
+unsafe impl<T: Send> Sync for Shared<T> {}
+
+impl<T> Shared<T> {
+    fn new(capacity: usize) -> Self {
+        assert!(capacity > 0, "channel capacity must be non-zero");
+        let capacity = capacity
+            .checked_next_power_of_two()
+            .expect("channel capacity overflow");
+
+        let buffer = (0..capacity)
+            .map(|pos| {
+                CachePadded(Slot {
+                    seq: AtomicUsize::new(pos),
+                    value: UnsafeCell::new(MaybeUninit::uninit()),
+                })
+            })
+            .collect();
+
+        Self {
+            head: CachePadded(AtomicUsize::new(0)),
+            tail: CachePadded(AtomicUsize::new(0)),
+            buffer,
+            mask: capacity - 1,
+            senders: AtomicUsize::new(1),
+            receivers: AtomicUsize::new(1),
+            recv_event: AtomicU32::new(0),
+            recv_waiters: AtomicU32::new(0),
+            send_event: AtomicU32::new(0),
+            send_waiters: AtomicU32::new(0),
+        }
+    }
+
+    fn capacity(&self) -> usize {
+        self.mask + 1
+    }
+
+    fn is_disconnected(&self) -> bool {
+        self.receivers.load(Ordering::Acquire) == 0
+    }
+
+    /// Pushes a value, or returns it back if the buffer is full.
+    fn push(&self, value: T) -> Result<(), T> {
+        let mut pos = self.head.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.buffer[pos & self.mask];
+            let seq = slot.seq.load(Ordering::Acquire);
+            let diff = seq.wrapping_sub(pos) as isize;
+
+            if diff == 0 {
+                match self.head.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: Winning the CAS grants exclusive access to the free slot.
+                        unsafe { (*slot.value.get()).write(value) };
+                        slot.seq.store(pos.wrapping_add(1), Ordering::Release);
+                        return Ok(());
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return Err(value);
+            } else {
+                pos = self.head.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Pops a value, or returns `None` if the buffer is empty.
+    fn pop(&self) -> Option<T> {
+        let mut pos = self.tail.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.buffer[pos & self.mask];
+            let seq = slot.seq.load(Ordering::Acquire);
+            let diff = seq.wrapping_sub(pos.wrapping_add(1)) as isize;
+
+            if diff == 0 {
+                match self.tail.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: Winning the CAS grants exclusive access to the filled slot.
+                        let value = unsafe { (*slot.value.get()).assume_init_read() };
+                        slot.seq
+                            .store(pos.wrapping_add(self.mask + 1), Ordering::Release);
+                        return Some(value);
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return None;
+            } else {
+                pos = self.tail.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Wakes a blocked receiver after a push, if any.
+    #[inline]
+    fn notify_receivers(&self) {
+        // Pairs with the waiter registration in `Receiver::recv`: either the waiter is seen
+        // here, or its re-check sees the pushed value
+        atomic::fence(Ordering::SeqCst);
+        if self.recv_waiters.load(Ordering::SeqCst) > 0 {
+            self.recv_event.fetch_add(1, Ordering::SeqCst);
+            futex::wake_one(&self.recv_event);
+        }
+    }
+
+    /// Wakes a blocked sender after a pop, if any.
+    #[inline]
+    fn notify_senders(&self) {
+        // Pairs with the waiter registration in `Sender::send`
+        atomic::fence(Ordering::SeqCst);
+        if self.send_waiters.load(Ordering::SeqCst) > 0 {
+            self.send_event.fetch_add(1, Ordering::SeqCst);
+            futex::wake_one(&self.send_event);
+        }
+    }
+}
+
+impl<T> Drop for Shared<T> {
+    fn drop(&mut self) {
+        while self.pop().is_some() {}
+    }
+}
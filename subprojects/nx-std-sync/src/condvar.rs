@@ -1,6 +1,6 @@
 //! Condition Variable
 
-use core::fmt;
+use core::{fmt, time::Duration};
 
 use nx_sys_sync as sys;
 
@@ -90,6 +90,85 @@ impl Condvar {
         guard
     }
 
+    /// Waits on this condition variable for a notification, timing out after a specified
+    /// duration.
+    ///
+    /// The semantics of this function are equivalent to [`wait`] except that the thread will
+    /// be blocked for roughly no longer than `dur`. The returned [`WaitTimeoutResult`] tells
+    /// whether the timeout elapsed.
+    ///
+    /// Note that the timeout restarts with every call: loops waiting on a condition should
+    /// use [`wait_timeout_while`] or [`wait_until`] instead, to bound the total wait.
+    ///
+    /// [`wait`]: Self::wait
+    /// [`wait_timeout_while`]: Self::wait_timeout_while
+    /// [`wait_until`]: Self::wait_until
+    pub fn wait_timeout<'a, T>(
+        &self,
+        guard: MutexGuard<'a, T>,
+        dur: Duration,
+    ) -> (MutexGuard<'a, T>, WaitTimeoutResult) {
+        let lock = mutex::guard_lock(&guard);
+        let rc = self.inner.wait_timeout(lock, duration_to_ns(dur));
+        (guard, WaitTimeoutResult(rc != 0))
+    }
+
+    /// Waits on this condition variable for a notification, timing out once the `deadline`
+    /// system tick passes.
+    ///
+    /// The semantics of this function are equivalent to [`wait`], except that the deadline
+    /// stays put across calls: re-waiting after a spurious wakeup does not extend the total
+    /// wait. Deadlines are computed with [`deadline_after`].
+    ///
+    /// [`wait`]: Self::wait
+    /// [`deadline_after`]: Self::deadline_after
+    pub fn wait_until<'a, T>(
+        &self,
+        guard: MutexGuard<'a, T>,
+        deadline: u64,
+    ) -> (MutexGuard<'a, T>, WaitTimeoutResult) {
+        let lock = mutex::guard_lock(&guard);
+        let rc = self.inner.wait_until(lock, deadline);
+        (guard, WaitTimeoutResult(rc != 0))
+    }
+
+    /// Waits on this condition variable while `condition` is `true`, timing out after
+    /// `dur` in total.
+    ///
+    /// `condition` is checked immediately and after every wakeup, as in [`wait_while`]. The
+    /// returned [`WaitTimeoutResult`] tells whether the timeout elapsed with `condition`
+    /// still `true`.
+    ///
+    /// [`wait_while`]: Self::wait_while
+    pub fn wait_timeout_while<'a, T, F>(
+        &self,
+        mut guard: MutexGuard<'a, T>,
+        dur: Duration,
+        mut condition: F,
+    ) -> (MutexGuard<'a, T>, WaitTimeoutResult)
+    where
+        F: FnMut(&mut T) -> bool,
+    {
+        let deadline = Self::deadline_after(dur);
+        while condition(&mut *guard) {
+            let res;
+            (guard, res) = self.wait_until(guard, deadline);
+            if res.timed_out() {
+                let still_waiting = condition(&mut *guard);
+                return (guard, WaitTimeoutResult(still_waiting));
+            }
+        }
+        (guard, WaitTimeoutResult(false))
+    }
+
+    /// Returns the system tick `dur` from now, as a deadline for [`wait_until`].
+    ///
+    /// [`wait_until`]: Self::wait_until
+    #[inline]
+    pub fn deadline_after(dur: Duration) -> u64 {
+        sys::Condvar::deadline_after(duration_to_ns(dur))
+    }
+
     /// Wakes up one blocked thread on this condvar.
     ///
     /// If there is a blocked thread on this condition variable, then it will
@@ -111,6 +190,9 @@ impl Condvar {
     /// variable are awoken. Calls to `notify_all()` are not buffered in any
     /// way.
     ///
+    /// Waiters are not all made runnable at once: the kernel queues them on the mutex they
+    /// wait with, and each one runs as the previous one unlocks it.
+    ///
     /// To wake up only one thread, see [`notify_one`].
     ///
     /// [`notify_one`]: Self::notify_one
@@ -119,6 +201,25 @@ impl Condvar {
     }
 }
 
+/// A type indicating whether a timed wait on a condition variable returned
+/// due to a time out or not.
+///
+/// It is returned by the [`wait_timeout`], [`wait_until`] and [`wait_timeout_while`] methods.
+///
+/// [`wait_timeout`]: Condvar::wait_timeout
+/// [`wait_until`]: Condvar::wait_until
+/// [`wait_timeout_while`]: Condvar::wait_timeout_while
+#[derive(Debug, PartialEq, Eq, Copy, Clone)]
+pub struct WaitTimeoutResult(bool);
+
+impl WaitTimeoutResult {
+    /// Returns `true` if the wait was known to have timed out.
+    #[must_use]
+    pub fn timed_out(&self) -> bool {
+        self.0
+    }
+}
+
 impl fmt::Debug for Condvar {
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         f.debug_struct("Condvar").finish_non_exhaustive()
@@ -131,3 +232,9 @@ impl Default for Condvar {
         Condvar::new()
     }
 }
+
+/// Converts `dur` to the nanoseconds of a kernel timeout, saturating.
+#[inline]
+fn duration_to_ns(dur: Duration) -> u64 {
+    u64::try_from(dur.as_nanos()).unwrap_or(u64::MAX)
+}
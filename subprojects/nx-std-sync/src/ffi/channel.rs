@@ -0,0 +1,194 @@
+use core::{ffi::c_void, ptr::NonNull};
+
+use nx_alloc::pool::Pool;
+
+use crate::channel::{self, TryRecvError, TrySendError};
+
+/// The type of the data that can be sent on the channel.
+type DataType = *mut c_void;
+
+/// Opaque struct for the sending-half of a bounded channel.
+#[repr(C)]
+struct Sender(channel::Sender<DataType>);
+
+/// Opaque struct for the receiving-half of a bounded channel.
+#[repr(C)]
+struct Receiver(channel::Receiver<DataType>);
+
+// SAFETY: The channel only moves the raw pointer value; the C caller owns what it points to.
+unsafe impl Send for Sender {}
+// SAFETY: See `Sender`.
+unsafe impl Sync for Sender {}
+// SAFETY: See `Sender`.
+unsafe impl Send for Receiver {}
+// SAFETY: See `Sender`.
+unsafe impl Sync for Receiver {}
+
+/// Pool of sender handles.
+static SENDERS: Pool<Sender> = Pool::new();
+
+/// Pool of receiver handles.
+static RECEIVERS: Pool<Receiver> = Pool::new();
+
+/// Creates a new bounded channel holding up to `capacity` values.
+///
+/// The capacity is rounded up to the next power of two. The caller is responsible for freeing
+/// the sender and receiver with the appropriate `free` functions.
+///
+/// \return 0 on success, -1 if `capacity` is zero or an output pointer is `NULL`.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_create(
+    capacity: usize,
+    tx: *mut *mut Sender,
+    rx: *mut *mut Receiver,
+) -> i32 {
+    if capacity == 0 || tx.is_null() || rx.is_null() {
+        return -1;
+    }
+
+    let (inner_tx, inner_rx) = channel::bounded::<DataType>(capacity);
+    let Ok(sender) = SENDERS.alloc(Sender(inner_tx)) else {
+        panic!("out of memory allocating a channel sender");
+    };
+    let Ok(receiver) = RECEIVERS.alloc(Receiver(inner_rx)) else {
+        panic!("out of memory allocating a channel receiver");
+    };
+    unsafe { *tx = sender.as_ptr() };
+    unsafe { *rx = receiver.as_ptr() };
+    0
+}
+
+/// Creates a new sender for the same channel as `tx`.
+///
+/// Returns `NULL` if `tx` is `NULL`.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_sender_clone(tx: *const Sender) -> *mut Sender {
+    // SAFETY: The caller guarantees `tx` is NULL or a live sender handle.
+    let Some(tx) = (unsafe { tx.as_ref() }) else {
+        return core::ptr::null_mut();
+    };
+    let Ok(sender) = SENDERS.alloc(Sender(tx.0.clone())) else {
+        panic!("out of memory allocating a channel sender");
+    };
+    sender.as_ptr()
+}
+
+/// Creates a new receiver for the same channel as `rx`.
+///
+/// Returns `NULL` if `rx` is `NULL`.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_receiver_clone(rx: *const Receiver) -> *mut Receiver {
+    // SAFETY: The caller guarantees `rx` is NULL or a live receiver handle.
+    let Some(rx) = (unsafe { rx.as_ref() }) else {
+        return core::ptr::null_mut();
+    };
+    let Ok(receiver) = RECEIVERS.alloc(Receiver(rx.0.clone())) else {
+        panic!("out of memory allocating a channel receiver");
+    };
+    receiver.as_ptr()
+}
+
+/// Frees a `NxSyncChannelSender`.
+///
+/// If `sender` is `NULL`, this function does nothing.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_sender_free(tx: *mut Sender) {
+    let Some(tx) = NonNull::new(tx) else {
+        return;
+    };
+    // SAFETY: The caller guarantees `tx` was created by this module and is not used again.
+    unsafe { SENDERS.free(tx) };
+}
+
+/// Frees a `NxSyncChannelReceiver`.
+///
+/// If `receiver` is `NULL`, this function does nothing.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_receiver_free(rx: *mut Receiver) {
+    let Some(rx) = NonNull::new(rx) else {
+        return;
+    };
+    // SAFETY: The caller guarantees `rx` was created by this module and is not used again.
+    unsafe { RECEIVERS.free(rx) };
+}
+
+/// Sends a value, blocking while the channel is full.
+///
+/// \return 0 on success, -1 if all receivers were freed.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_send(tx: *const Sender, value: DataType) -> i32 {
+    // SAFETY: The caller guarantees `tx` is NULL or a live sender handle.
+    let Some(tx) = (unsafe { tx.as_ref() }) else {
+        return -1;
+    };
+    match tx.0.send(value) {
+        Ok(()) => 0,
+        Err(_) => -1,
+    }
+}
+
+/// Sends a value without blocking.
+///
+/// \return 0 on success, 1 if the channel is full, -1 if all receivers were freed.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_try_send(tx: *const Sender, value: DataType) -> i32 {
+    // SAFETY: The caller guarantees `tx` is NULL or a live sender handle.
+    let Some(tx) = (unsafe { tx.as_ref() }) else {
+        return -1;
+    };
+    match tx.0.try_send(value) {
+        Ok(()) => 0,
+        Err(TrySendError::Full(_)) => 1,
+        Err(TrySendError::Disconnected(_)) => -1,
+    }
+}
+
+/// Receives a value, blocking while the channel is empty.
+///
+/// \return 0 on success, -1 if the channel is empty and all senders were freed.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_recv(
+    rx: *const Receiver,
+    out_value: *mut DataType,
+) -> i32 {
+    // SAFETY: The caller guarantees `rx` is NULL or a live receiver handle.
+    let Some(rx) = (unsafe { rx.as_ref() }) else {
+        return -1;
+    };
+    if out_value.is_null() {
+        return -1;
+    }
+    match rx.0.recv() {
+        Ok(value) => {
+            unsafe { *out_value = value };
+            0
+        }
+        Err(_) => -1,
+    }
+}
+
+/// Receives a value without blocking.
+///
+/// \return 0 on success, 1 if the channel is empty, -1 if it is empty and all senders were
+/// freed.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_std_sync__channel_try_recv(
+    rx: *const Receiver,
+    out_value: *mut DataType,
+) -> i32 {
+    // SAFETY: The caller guarantees `rx` is NULL or a live receiver handle.
+    let Some(rx) = (unsafe { rx.as_ref() }) else {
+        return -1;
+    };
+    if out_value.is_null() {
+        return -1;
+    }
+    match rx.0.try_recv() {
+        Ok(value) => {
+            unsafe { *out_value = value };
+            0
+        }
+        Err(TryRecvError::Empty) => 1,
+        Err(TryRecvError::Disconnected) => -1,
+    }
+}
@@ -1,5 +1,6 @@
-use alloc::boxed::Box;
-use core::ffi::c_void;
+use core::{ffi::c_void, ptr::NonNull};
+
+use nx_alloc::pool::Pool;
 
 use crate::oneshot;
 
@@ -14,6 +15,17 @@ struct Sender(oneshot::Sender<DataType>);
 #[repr(C)]
 struct Receiver(oneshot::Receiver<DataType>);
 
+// SAFETY: The channel only moves the raw pointer value; the C caller owns what it points to.
+unsafe impl Send for Sender {}
+// SAFETY: See `Sender`.
+unsafe impl Send for Receiver {}
+
+/// Pool of sender handles, so creating a channel does not take the heap lock for them.
+static SENDERS: Pool<Sender> = Pool::new();
+
+/// Pool of receiver handles.
+static RECEIVERS: Pool<Receiver> = Pool::new();
+
 /// Creates a new one-shot channel.
 ///
 /// The caller is responsible for freeing the sender and receiver with the appropriate `free` functions,
@@ -21,8 +33,14 @@ struct Receiver(oneshot::Receiver<DataType>);
 #[unsafe(no_mangle)]
 unsafe extern "C" fn __nx_std_sync__oneshot_create(tx: *mut *mut Sender, rx: *mut *mut Receiver) {
     let (inner_tx, inner_rx) = oneshot::channel::<DataType>();
-    unsafe { *tx = Box::into_raw(Box::new(Sender(inner_tx))) };
-    unsafe { *rx = Box::into_raw(Box::new(Receiver(inner_rx))) };
+    let Ok(sender) = SENDERS.alloc(Sender(inner_tx)) else {
+        panic!("out of memory allocating a oneshot sender");
+    };
+    let Ok(receiver) = RECEIVERS.alloc(Receiver(inner_rx)) else {
+        panic!("out of memory allocating a oneshot receiver");
+    };
+    unsafe { *tx = sender.as_ptr() };
+    unsafe { *rx = receiver.as_ptr() };
 }
 
 /// Frees a `NxSyncOneshotSender`.
@@ -30,10 +48,11 @@ unsafe extern "C" fn __nx_std_sync__oneshot_create(tx: *mut *mut Sender, rx: *mu
 /// If `sender` is `NULL`, this function does nothing.
 #[unsafe(no_mangle)]
 unsafe extern "C" fn __nx_std_sync__oneshot_sender_free(tx: *mut Sender) {
-    if tx.is_null() {
+    let Some(tx) = NonNull::new(tx) else {
         return;
-    }
-    drop(unsafe { Box::from_raw(tx) });
+    };
+    // SAFETY: The caller guarantees `tx` was created by `__nx_std_sync__oneshot_create`.
+    unsafe { SENDERS.free(tx) };
 }
 
 /// Frees a `NxSyncOneshotReceiver`.
@@ -41,10 +60,11 @@ unsafe extern "C" fn __nx_std_sync__oneshot_sender_free(tx: *mut Sender) {
 /// If `receiver` is `NULL`, this function does nothing.
 #[unsafe(no_mangle)]
 unsafe extern "C" fn __nx_std_sync__oneshot_receiver_free(rx: *mut Receiver) {
-    if rx.is_null() {
+    let Some(rx) = NonNull::new(rx) else {
         return;
-    }
-    drop(unsafe { Box::from_raw(rx) });
+    };
+    // SAFETY: The caller guarantees `rx` was created by `__nx_std_sync__oneshot_create`.
+    unsafe { RECEIVERS.free(rx) };
 }
 
 /// Sends a value on the channel, consuming the sender.
@@ -57,11 +77,12 @@ unsafe extern "C" fn __nx_std_sync__oneshot_receiver_free(rx: *mut Receiver) {
 /// \return 0 on success, -1 on failure (e.g., receiver was dropped).
 #[unsafe(no_mangle)]
 unsafe extern "C" fn __nx_std_sync__oneshot_send(tx: *mut Sender, value: DataType) -> i32 {
-    if tx.is_null() {
+    let Some(tx) = NonNull::new(tx) else {
         return -1;
-    }
+    };
 
-    match unsafe { Box::from_raw(tx) }.0.send(value) {
+    // SAFETY: The caller guarantees `tx` was created by `__nx_std_sync__oneshot_create`.
+    match unsafe { SENDERS.take(tx) }.0.send(value) {
         Ok(_) => 0,
         Err(_) => -1,
     }
@@ -81,11 +102,12 @@ unsafe extern "C" fn __nx_std_sync__oneshot_recv(
     rx: *mut Receiver,
     out_value: *mut DataType,
 ) -> i32 {
-    if rx.is_null() {
+    let Some(rx) = NonNull::new(rx) else {
         return -1;
-    }
+    };
 
-    match unsafe { Box::from_raw(rx) }.0.recv() {
+    // SAFETY: The caller guarantees `rx` was created by `__nx_std_sync__oneshot_create`.
+    match unsafe { RECEIVERS.take(rx) }.0.recv() {
         Ok(value) if !out_value.is_null() => {
             unsafe { *out_value = value };
             0
@@ -12,6 +12,7 @@ extern crate nx_alloc;
 pub mod ffi;
 
 pub mod barrier;
+pub mod channel;
 pub mod condvar;
 pub mod mutex;
 pub mod once_lock;
@@ -10,7 +10,7 @@
 //! poisoning semantics – if the initialiser panics the entire program aborts
 //! in typical `no_std` fashion.
 
-use core::{cell::UnsafeCell, fmt, mem::MaybeUninit};
+use core::{cell::UnsafeCell, convert::Infallible, fmt, mem::MaybeUninit};
 
 use nx_sys_sync::Once;
 
@@ -98,6 +98,7 @@ impl<T> OnceLock<T> {
     }
 
     /// Returns a reference to the value, initialising it with `init` if needed.
+    #[inline]
     pub fn get_or_init<F>(&self, init: F) -> &T
     where
         F: FnOnce() -> T,
@@ -106,20 +107,15 @@ impl<T> OnceLock<T> {
             return val;
         }
 
-        let slot = self.value.get();
-        let mut init_opt = Some(init);
-        self.once.call_once(|| {
-            let value = (init_opt.take().unwrap())();
-            unsafe {
-                (*slot).write(value);
-            }
-        });
-        // Either we ran the closure or another thread did – in both cases the
-        // cell is initialised now.
-        unsafe { (&*slot).assume_init_ref() }
+        match self.initialize(|| Ok::<T, Infallible>(init())) {
+            // SAFETY: The value was just initialised, by this or another thread.
+            Ok(()) => unsafe { (&*self.value.get()).assume_init_ref() },
+            Err(never) => match never {},
+        }
     }
 
     /// Same as [`get_or_init`] but the initialiser may fail.
+    #[inline]
     pub fn get_or_try_init<F, E>(&self, init: F) -> Result<&T, E>
     where
         F: FnOnce() -> Result<T, E>,
@@ -128,26 +124,31 @@ impl<T> OnceLock<T> {
             return Ok(val);
         }
 
-        let slot = self.value.get();
-        let mut init_opt = Some(init);
+        self.initialize(init)?;
+
+        // Once we get here the value is definitely initialised.
+        Ok(unsafe { (&*self.value.get()).assume_init_ref() })
+    }
 
-        // Run (or wait for) initialisation.
+    /// Runs (or waits for) the initialisation of the cell with `init`.
+    ///
+    /// Kept out of line so that the initialised path of the getters stays a
+    /// single load.
+    #[cold]
+    #[inline(never)]
+    fn initialize<F, E>(&self, init: F) -> Result<(), E>
+    where
+        F: FnOnce() -> Result<T, E>,
+    {
+        let slot = self.value.get();
         self.once.call_once_try(|| {
-            // Execute user initialiser.
-            match (init_opt.take().unwrap())() {
-                Ok(value) => {
-                    // SAFETY: We are the unique initialiser.
-                    unsafe {
-                        (*slot).write(value);
-                    }
-                    Ok(())
-                }
-                Err(e) => Err(e),
+            let value = init()?;
+            // SAFETY: We are the unique initialiser.
+            unsafe {
+                (*slot).write(value);
             }
-        })?;
-
-        // Once we get here the value is definitely initialised.
-        Ok(unsafe { (&*slot).assume_init_ref() })
+            Ok(())
+        })
     }
 
     /// Takes the value out of the cell, leaving it uninitialised again.
@@ -1,6 +1,14 @@
 //! A blocking, single-producer, single-consumer one-shot channel.
+//!
+//! The [`Receiver`] can also be awaited, from an async task, instead of blocking in
+//! [`Receiver::recv`].
 use alloc::sync::Arc;
-use core::sync::atomic::{AtomicBool, Ordering};
+use core::{
+    future::Future,
+    pin::Pin,
+    sync::atomic::{AtomicBool, Ordering},
+    task::{Context, Poll, Waker},
+};
 
 use crate::{condvar::Condvar, mutex::Mutex};
 
@@ -42,8 +50,10 @@ impl<T> Sender<T> {
         }
 
         *lock = Some(value);
+        drop(lock);
 
         self.inner.cvar.notify_one();
+        self.inner.wake();
         Ok(())
     }
 }
@@ -53,7 +63,10 @@ impl<T> Drop for Sender<T> {
         let value_guard = self.inner.mutx.lock();
         if value_guard.is_none() {
             self.inner.is_closed.store(true, Ordering::SeqCst);
+            drop(value_guard);
+
             self.inner.cvar.notify_one();
+            self.inner.wake();
         }
     }
 }
@@ -87,6 +100,32 @@ impl<T> Receiver<T> {
     }
 }
 
+impl<T> Future for Receiver<T> {
+    type Output = Result<T, RecvError>;
+
+    /// Resolves once a value is sent on this channel, or the `Sender` is dropped.
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        let mut lock = self.inner.mutx.lock();
+
+        if let Some(value) = lock.take() {
+            return Poll::Ready(Ok(value));
+        }
+
+        if self.inner.is_closed.load(Ordering::SeqCst) {
+            return Poll::Ready(Err(RecvError));
+        }
+
+        // Registered while holding the value lock: the sender wakes the task once it
+        // released it, after storing the value.
+        let mut waker = self.inner.waker.lock();
+        match &mut *waker {
+            Some(waker) => waker.clone_from(cx.waker()),
+            None => *waker = Some(cx.waker().clone()),
+        }
+        Poll::Pending
+    }
+}
+
 impl<T> Drop for Receiver<T> {
     fn drop(&mut self) {
         self.inner.is_closed.store(true, Ordering::SeqCst);
@@ -114,6 +153,8 @@ struct Shared<T> {
     mutx: Mutex<Option<T>>,
     cvar: Condvar,
     is_closed: AtomicBool,
+    /// Waker of the task awaiting the [`Receiver`], if any.
+    waker: Mutex<Option<Waker>>,
 }
 
 impl<T> Shared<T> {
@@ -122,6 +163,14 @@ impl<T> Shared<T> {
             mutx: Mutex::new(None),
             cvar: Condvar::new(),
             is_closed: AtomicBool::new(false),
+            waker: Mutex::new(None),
+        }
+    }
+
+    /// Wakes the task awaiting the [`Receiver`], if any.
+    fn wake(&self) {
+        if let Some(waker) = self.waker.lock().take() {
+            waker.wake();
         }
     }
 }
@@ -1,6 +1,10 @@
 //! # Read-Write Lock
 //!
 //! A read/write lock synchronization primitive that allows multiple readers or a single writer.
+//!
+//! The lock is backed by [`sys::AtomicRwLock`]: uncontended read and write acquisition is a
+//! single atomic operation on a state word, and threads only wait in the kernel under
+//! contention. The libnx-compatible [`sys::RwLock`] remains available for the FFI.
 
 use core::{
     cell::UnsafeCell,
@@ -26,11 +30,8 @@ pub use crate::result::{TryLockError, TryLockResult};
 /// become available. An `RwLock` will allow any number of readers to acquire the
 /// lock as long as a writer is not holding the lock.
 ///
-/// The priority policy of the lock is dependent on the underlying operating
-/// system's implementation, and this type does not guarantee that any
-/// particular policy will be used. In particular, a writer which is waiting to
-/// acquire the lock in `write` might or might not block concurrent calls to
-/// `read`, e.g.:
+/// Writers are preferred: a writer which is waiting to acquire the lock in
+/// `write` blocks concurrent calls to `read`, e.g.:
 ///
 /// <details><summary>Potential deadlock example</summary>
 ///
@@ -39,7 +40,7 @@ pub use crate::result::{TryLockError, TryLockResult};
 /// let _rg1 = lock.read();  |
 ///                          |  // will block
 ///                          |  let _wg = lock.write();
-/// // may deadlock          |
+/// // deadlocks             |
 /// let _rg2 = lock.read();  |
 /// ```
 ///
@@ -53,7 +54,7 @@ pub use crate::result::{TryLockError, TryLockResult};
 ///
 /// [`Mutex`]: super::Mutex
 pub struct RwLock<T: ?Sized> {
-    inner: sys::RwLock,
+    inner: sys::AtomicRwLock,
     data: UnsafeCell<T>,
 }
 
@@ -76,7 +77,7 @@ pub struct RwLockReadGuard<'a, T: ?Sized + 'a> {
     // `NonNull` is also covariant over `T`, just like we would have with `&T`. `NonNull`
     // is preferable over `const* T` to allow for niche optimization.
     data: NonNull<T>,
-    inner_lock: &'a sys::RwLock,
+    inner_lock: &'a sys::AtomicRwLock,
     _marker: PhantomData<*const ()>,
 }
 
@@ -104,7 +105,7 @@ impl<T> RwLock<T> {
     #[inline]
     pub const fn new(t: T) -> RwLock<T> {
         RwLock {
-            inner: sys::RwLock::new(),
+            inner: sys::AtomicRwLock::new(),
             data: UnsafeCell::new(t),
         }
     }
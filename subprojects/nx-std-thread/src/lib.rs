@@ -0,0 +1,11 @@
+//! # nx-std-thread
+#![no_std]
+
+extern crate nx_panic_handler as _; // provides #[panic_handler]
+
+// The `alloc` crate enables memory allocation.
+extern crate alloc;
+// The `nx-alloc` crate exposes the `#[global_allocator]` for the dependent crates.
+extern crate nx_alloc;
+
+pub mod pool;
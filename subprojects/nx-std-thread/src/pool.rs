@@ -0,0 +1,687 @@
+//! # Work-stealing thread pool
+//!
+//! A fork-join scheduler running one worker thread per application core. Each worker is
+//! pinned to its core and owns a [Chase-Lev deque](deque): it pushes and pops its own jobs at
+//! the bottom, while idle workers steal from the top. Jobs submitted by threads outside the
+//! pool go through a shared injector queue. Idle workers spin briefly, then sleep on a futex
+//! until new work is announced.
+//!
+//! The pool has three entry points:
+//! - [`ThreadPool::spawn`] runs a `'static` closure in the background.
+//! - [`ThreadPool::join`] runs two closures, potentially in parallel, and returns both
+//!   results.
+//! - [`ThreadPool::scope`] runs closures that borrow from the caller's stack and waits for all
+//!   of them.
+//!
+//! The free functions [`spawn`], [`join`] and [`scope`] run on a global pool, created with the
+//! default [`Builder`] settings on first use.
+//!
+//! By default, workers run on the three application cores (0 to 2). Core 3 is normally
+//! reserved for the system; [`Builder::use_core3`] adds a worker on it for applications whose
+//! core mask allows it.
+
+use alloc::{boxed::Box, collections::VecDeque, sync::Arc, vec::Vec};
+use core::{
+    ffi::c_void,
+    hint,
+    marker::PhantomData,
+    sync::atomic::{AtomicBool, AtomicU32, AtomicUsize, Ordering, fence},
+};
+
+use nx_std_sync::{mutex::Mutex, once_lock::OnceLock};
+use nx_sys_sync::futex;
+
+use self::{
+    deque::{Deque, Steal},
+    job::{HeapJob, JobRef, StackJob},
+    latch::Latch,
+    thread::RawThread,
+};
+
+mod deque;
+mod job;
+mod latch;
+mod thread;
+
+/// Default worker stack size: 256 KiB.
+const DEFAULT_STACK_SIZE: usize = 0x40000;
+
+/// Default worker priority, the same as libnx's main thread.
+const DEFAULT_PRIORITY: i32 = 0x2C;
+
+/// Number of failed work searches before an idle worker goes to sleep.
+const IDLE_SPINS: u32 = 64;
+
+/// The global pool used by the free functions.
+static GLOBAL_POOL: OnceLock<ThreadPool> = OnceLock::new();
+
+/// Returns the global thread pool, creating it on first use.
+///
+/// # Panics
+///
+/// Panics if the worker threads cannot be created.
+pub fn global() -> &'static ThreadPool {
+    GLOBAL_POOL.get_or_init(|| match ThreadPool::new() {
+        Ok(pool) => pool,
+        Err(err) => panic!("failed to create the global thread pool: {err}"),
+    })
+}
+
+/// Runs `func` in the background on the global pool.
+///
+/// See [`ThreadPool::spawn`].
+pub fn spawn<F>(func: F)
+where
+    F: FnOnce() + Send + 'static,
+{
+    global().spawn(func)
+}
+
+/// Runs `a` and `b`, potentially in parallel, on the global pool.
+///
+/// See [`ThreadPool::join`].
+pub fn join<A, B, RA, RB>(a: A, b: B) -> (RA, RB)
+where
+    A: FnOnce() -> RA + Send,
+    B: FnOnce() -> RB + Send,
+    RA: Send,
+    RB: Send,
+{
+    global().join(a, b)
+}
+
+/// Creates a scope on the global pool.
+///
+/// See [`ThreadPool::scope`].
+pub fn scope<'scope, OP, R>(op: OP) -> R
+where
+    OP: FnOnce(&Scope<'scope>) -> R + Send,
+    R: Send,
+{
+    global().scope(op)
+}
+
+/// Builder for a [`ThreadPool`].
+#[derive(Debug, Clone)]
+pub struct Builder {
+    use_core3: bool,
+    priority: i32,
+    stack_size: usize,
+}
+
+impl Builder {
+    /// Creates a builder with the default settings: one worker on each of cores 0 to 2, with
+    /// priority `0x2C` and a 256 KiB stack.
+    pub const fn new() -> Self {
+        Self {
+            use_core3: false,
+            priority: DEFAULT_PRIORITY,
+            stack_size: DEFAULT_STACK_SIZE,
+        }
+    }
+
+    /// Adds a worker pinned to core 3.
+    ///
+    /// Building fails if the process core mask does not include core 3.
+    pub const fn use_core3(mut self, enable: bool) -> Self {
+        self.use_core3 = enable;
+        self
+    }
+
+    /// Sets the workers' thread priority, from `0` (highest) to `0x3F` (lowest).
+    pub const fn priority(mut self, priority: i32) -> Self {
+        self.priority = priority;
+        self
+    }
+
+    /// Sets the workers' stack size, a non-zero multiple of the 4 KiB page size.
+    pub const fn stack_size(mut self, stack_size: usize) -> Self {
+        self.stack_size = stack_size;
+        self
+    }
+
+    /// Creates the pool and starts its workers.
+    pub fn build(self) -> Result<ThreadPool, BuildError> {
+        if self.stack_size == 0 || self.stack_size % 0x1000 != 0 {
+            return Err(BuildError::InvalidStackSize(self.stack_size));
+        }
+
+        let cores: &[u8] = if self.use_core3 {
+            &[0, 1, 2, 3]
+        } else {
+            &[0, 1, 2]
+        };
+        let registry = Arc::new(Registry::new(cores.len()));
+        let mut pool = ThreadPool {
+            registry,
+            threads: Vec::with_capacity(cores.len()),
+        };
+
+        // On error, dropping `pool` stops the workers started so far
+        for (index, &core) in cores.iter().enumerate() {
+            let mut thread = Box::new(RawThread::zeroed());
+            let start = Box::into_raw(Box::new(WorkerStart {
+                registry: Arc::clone(&pool.registry),
+                index,
+            }));
+
+            // SAFETY: The thread storage is boxed and kept in `pool.threads` until closed; the
+            // start argument is owned by the thread once started.
+            let created = unsafe {
+                thread.create(
+                    worker_entry,
+                    start.cast::<c_void>(),
+                    self.stack_size,
+                    self.priority,
+                    core,
+                )
+            };
+            if let Err(rc) = created {
+                // SAFETY: The thread was not created, so the argument is still ours.
+                drop(unsafe { Box::from_raw(start) });
+                return Err(BuildError::Create { core, rc });
+            }
+            if let Err(rc) = thread.start() {
+                thread.close();
+                // SAFETY: The thread never ran, so the argument is still ours.
+                drop(unsafe { Box::from_raw(start) });
+                return Err(BuildError::Start { core, rc });
+            }
+            pool.threads.push(thread);
+        }
+
+        Ok(pool)
+    }
+}
+
+impl Default for Builder {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Error returned by [`Builder::build`].
+#[derive(Debug, thiserror::Error)]
+pub enum BuildError {
+    /// The stack size is zero or not page-aligned.
+    #[error("invalid worker stack size {0:#x}")]
+    InvalidStackSize(usize),
+    /// A worker thread could not be created.
+    #[error("failed to create the worker thread on core {core}: {rc:#x}")]
+    Create { core: u8, rc: u32 },
+    /// A worker thread could not be started.
+    #[error("failed to start the worker thread on core {core}: {rc:#x}")]
+    Start { core: u8, rc: u32 },
+}
+
+/// A work-stealing thread pool with one worker pinned to each application core.
+///
+/// Dropping the pool lets the workers finish all queued jobs, then joins them.
+pub struct ThreadPool {
+    registry: Arc<Registry>,
+    threads: Vec<Box<RawThread>>,
+}
+
+impl ThreadPool {
+    /// Creates a pool with the default [`Builder`] settings.
+    pub fn new() -> Result<Self, BuildError> {
+        Builder::new().build()
+    }
+
+    /// Returns a [`Builder`] to configure a new pool.
+    pub const fn builder() -> Builder {
+        Builder::new()
+    }
+
+    /// Returns the number of worker threads.
+    pub fn num_threads(&self) -> usize {
+        self.registry.workers.len()
+    }
+
+    /// Runs `op` on a worker of this pool and returns its result.
+    ///
+    /// If the current thread is a worker of this pool, `op` runs immediately. Otherwise, the
+    /// current thread blocks until a worker has run it.
+    pub fn install<OP, R>(&self, op: OP) -> R
+    where
+        OP: FnOnce() -> R + Send,
+        R: Send,
+    {
+        if WorkerThread::current(&self.registry).is_some() {
+            return op();
+        }
+
+        let job = StackJob::new(op);
+        self.registry.inject(job.as_job_ref());
+        job.latch.wait();
+        job.into_result()
+    }
+
+    /// Runs `func` in the background.
+    ///
+    /// Called from a worker, the job is pushed on the worker's own deque, where it is the
+    /// first candidate for stealing by idle workers.
+    pub fn spawn<F>(&self, func: F)
+    where
+        F: FnOnce() + Send + 'static,
+    {
+        // SAFETY: `func` is `'static`, and queued jobs are always executed before the workers
+        // exit.
+        let job = unsafe { HeapJob::into_job_ref(func) };
+        self.registry.push(job);
+    }
+
+    /// Runs `a` and `b`, potentially in parallel, and returns both results.
+    ///
+    /// `a` runs on the current worker while `b` is offered to idle workers. If nobody stole
+    /// `b` by the time `a` returns, it runs on the current worker too, so a fine-grained
+    /// recursive `join` costs little more than two calls.
+    pub fn join<A, B, RA, RB>(&self, a: A, b: B) -> (RA, RB)
+    where
+        A: FnOnce() -> RA + Send,
+        B: FnOnce() -> RB + Send,
+        RA: Send,
+        RB: Send,
+    {
+        self.install(|| {
+            let worker = WorkerThread::current(&self.registry).expect("not on a pool worker");
+            worker.join(a, b)
+        })
+    }
+
+    /// Creates a scope in which closures borrowing from the caller's stack can be spawned.
+    ///
+    /// Returns once `op` and every closure spawned in the scope have completed.
+    pub fn scope<'scope, OP, R>(&self, op: OP) -> R
+    where
+        OP: FnOnce(&Scope<'scope>) -> R + Send,
+        R: Send,
+    {
+        self.install(|| {
+            let worker = WorkerThread::current(&self.registry).expect("not on a pool worker");
+            let scope = Scope::new(Arc::clone(&self.registry));
+            let result = op(&scope);
+            scope.job_completed();
+            worker.wait_until(&scope.latch);
+            result
+        })
+    }
+}
+
+impl Drop for ThreadPool {
+    fn drop(&mut self) {
+        self.registry.terminate();
+        for thread in &mut self.threads {
+            thread.wait_for_exit();
+            thread.close();
+        }
+    }
+}
+
+/// A scope for spawning closures that borrow data living longer than `'scope`.
+///
+/// See [`ThreadPool::scope`].
+pub struct Scope<'scope> {
+    registry: Arc<Registry>,
+    /// Number of running closures, including the scope's own body.
+    pending: AtomicUsize,
+    /// Set once `pending` drops to zero.
+    latch: Latch,
+    /// Invariant over `'scope`.
+    _marker: PhantomData<fn(&'scope ()) -> &'scope ()>,
+}
+
+impl<'scope> Scope<'scope> {
+    fn new(registry: Arc<Registry>) -> Self {
+        Self {
+            registry,
+            pending: AtomicUsize::new(1),
+            latch: Latch::new(),
+            _marker: PhantomData,
+        }
+    }
+
+    /// Spawns `func` in the scope.
+    ///
+    /// The enclosing [`ThreadPool::scope`] call does not return before `func` has completed.
+    pub fn spawn<F>(&self, func: F)
+    where
+        F: FnOnce(&Scope<'scope>) + Send + 'scope,
+    {
+        self.pending.fetch_add(1, Ordering::Relaxed);
+
+        let scope = ScopeRef(self);
+        // SAFETY: The scope waits for all its jobs before returning, so `self` and the data
+        // `func` borrows outlive the job.
+        let job = unsafe {
+            HeapJob::into_job_ref(move || {
+                let scope = scope.get();
+                func(scope);
+                scope.job_completed();
+            })
+        };
+        self.registry.push(job);
+    }
+
+    fn job_completed(&self) {
+        if self.pending.fetch_sub(1, Ordering::AcqRel) == 1 {
+            self.latch.set();
+        }
+    }
+}
+
+/// A scope pointer moved into the scope's jobs.
+struct ScopeRef<'scope>(*const Scope<'scope>);
+
+// SAFETY: `Scope` is `Sync` and outlives its jobs.
+unsafe impl Send for ScopeRef<'_> {}
+
+impl<'scope> ScopeRef<'scope> {
+    /// Returns the scope. Taking `self` makes closures capture the whole `Send` wrapper.
+    fn get(self) -> &'scope Scope<'scope> {
+        // SAFETY: The scope outlives its jobs.
+        unsafe { &*self.0 }
+    }
+}
+
+/// State shared by the pool handle and its workers.
+struct Registry {
+    workers: Box<[WorkerInfo]>,
+    /// Jobs submitted from outside the pool.
+    injector: Mutex<VecDeque<JobRef>>,
+    /// Length of `injector`, checked without taking the lock.
+    injected: AtomicUsize,
+    /// Event counter idle workers sleep on, bumped when work is announced.
+    event: AtomicU32,
+    /// Number of workers sleeping (or about to sleep) on `event`.
+    sleepers: AtomicU32,
+    /// Number of those sleepers also waiting for a latch, see [`WorkerThread::wait_until`].
+    latch_sleepers: AtomicU32,
+    terminate: AtomicBool,
+}
+
+/// The per-worker state.
+struct WorkerInfo {
+    deque: Deque,
+    /// Kernel handle of the worker thread, `0` until it started.
+    handle: AtomicU32,
+}
+
+impl Registry {
+    fn new(num_workers: usize) -> Self {
+        let workers = (0..num_workers)
+            .map(|_| WorkerInfo {
+                deque: Deque::new(),
+                handle: AtomicU32::new(0),
+            })
+            .collect();
+        Self {
+            workers,
+            injector: Mutex::new(VecDeque::new()),
+            injected: AtomicUsize::new(0),
+            event: AtomicU32::new(0),
+            sleepers: AtomicU32::new(0),
+            latch_sleepers: AtomicU32::new(0),
+            terminate: AtomicBool::new(false),
+        }
+    }
+
+    /// Queues `job` on the current worker's deque, or on the injector from outside the pool.
+    fn push(&self, job: JobRef) {
+        match WorkerThread::current(self) {
+            Some(worker) => worker.push(job),
+            None => self.inject(job),
+        }
+    }
+
+    fn inject(&self, job: JobRef) {
+        self.injector.lock().push_back(job);
+        self.injected.fetch_add(1, Ordering::Release);
+        self.notify_work();
+    }
+
+    fn pop_injected(&self) -> Option<JobRef> {
+        if self.injected.load(Ordering::Acquire) == 0 {
+            return None;
+        }
+        let job = self.injector.lock().pop_front()?;
+        self.injected.fetch_sub(1, Ordering::Relaxed);
+        Some(job)
+    }
+
+    /// Steals a job from any worker but `thief`.
+    fn steal(&self, thief: usize) -> Option<JobRef> {
+        let count = self.workers.len();
+        for offset in 1..count {
+            let victim = &self.workers[(thief + offset) % count];
+            loop {
+                match victim.deque.steal() {
+                    Steal::Success(job) => return Some(job),
+                    Steal::Empty => break,
+                    Steal::Retry => hint::spin_loop(),
+                }
+            }
+        }
+        None
+    }
+
+    /// Wakes a sleeping worker, if any, after a job was queued.
+    fn notify_work(&self) {
+        // Pairs with the fence in `WorkerThread::sleep`: either the sleeper finds the job, or
+        // we see it registered.
+        fence(Ordering::SeqCst);
+        if self.sleepers.load(Ordering::Relaxed) > 0 {
+            self.event.fetch_add(1, Ordering::Release);
+            futex::wake_one(&self.event);
+        }
+    }
+
+    /// Wakes the workers sleeping in [`WorkerThread::wait_until`], if any, after a job ran
+    /// and may have set the latch they wait for.
+    fn notify_job_done(&self) {
+        // Pairs with the fence in `WorkerThread::sleep`: either the sleeper sees its latch set,
+        // or we see it registered.
+        fence(Ordering::SeqCst);
+        if self.latch_sleepers.load(Ordering::Relaxed) > 0 {
+            self.event.fetch_add(1, Ordering::Release);
+            futex::wake_all(&self.event);
+        }
+    }
+
+    /// Asks the workers to exit once all queued jobs are done.
+    fn terminate(&self) {
+        self.terminate.store(true, Ordering::Release);
+        self.event.fetch_add(1, Ordering::Release);
+        futex::wake_all(&self.event);
+    }
+}
+
+/// The start argument of a worker thread.
+struct WorkerStart {
+    registry: Arc<Registry>,
+    index: usize,
+}
+
+/// Entry point of the worker threads.
+///
+/// Workers exit through nx-sys-thread's exit sequence rather than libnx's, so that they
+/// give their allocator cache and RNG back.
+///
+/// # Safety
+///
+/// `arg` must be a `Box<WorkerStart>` turned into a raw pointer.
+unsafe extern "C" fn worker_entry(arg: *mut c_void) {
+    {
+        // SAFETY: The pool passes ownership of a boxed `WorkerStart` to the thread.
+        let start = unsafe { Box::from_raw(arg.cast::<WorkerStart>()) };
+        let WorkerStart { registry, index } = *start;
+
+        let handle = nx_sys_thread::get_current_thread_handle().to_raw();
+        registry.workers[index]
+            .handle
+            .store(handle, Ordering::Release);
+
+        WorkerThread {
+            registry: &registry,
+            index,
+        }
+        .main_loop();
+    }
+
+    // SAFETY: The worker's state was dropped above; nothing runs on this thread anymore.
+    unsafe { nx_sys_thread::exit_current() }
+}
+
+/// A pool worker, as seen from its own thread.
+#[derive(Clone, Copy)]
+struct WorkerThread<'a> {
+    registry: &'a Registry,
+    index: usize,
+}
+
+impl<'a> WorkerThread<'a> {
+    /// Returns the current thread's worker in `registry`, if it is one.
+    fn current(registry: &'a Registry) -> Option<Self> {
+        let handle = nx_sys_thread::get_current_thread_handle().to_raw();
+        let index = registry
+            .workers
+            .iter()
+            .position(|worker| worker.handle.load(Ordering::Relaxed) == handle)?;
+        Some(Self { registry, index })
+    }
+
+    fn deque(&self) -> &'a Deque {
+        &self.registry.workers[self.index].deque
+    }
+
+    fn push(&self, job: JobRef) {
+        // SAFETY: `self` is only constructed on the worker's own thread.
+        unsafe { self.deque().push(job) };
+        self.registry.notify_work();
+    }
+
+    fn pop(&self) -> Option<JobRef> {
+        // SAFETY: `self` is only constructed on the worker's own thread.
+        unsafe { self.deque().pop() }
+    }
+
+    /// Looks for a job: own deque first, then the other workers, then the injector.
+    fn find_work(&self) -> Option<JobRef> {
+        self.pop()
+            .or_else(|| self.registry.steal(self.index))
+            .or_else(|| self.registry.pop_injected())
+    }
+
+    fn join<A, B, RA, RB>(&self, a: A, b: B) -> (RA, RB)
+    where
+        A: FnOnce() -> RA + Send,
+        B: FnOnce() -> RB + Send,
+        RA: Send,
+        RB: Send,
+    {
+        let job_b = StackJob::new(b);
+        let job_b_ref = job_b.as_job_ref();
+        self.push(job_b_ref);
+
+        let result_a = a();
+
+        // Jobs pushed by `a` have been popped by now, so `b` is on top unless it was stolen
+        while !job_b.latch.probe() {
+            match self.pop() {
+                Some(job) if job == job_b_ref => return (result_a, job_b.run_inline()),
+                // SAFETY: Popped jobs are alive and executed once.
+                Some(job) => unsafe { self.execute(job) },
+                None => {
+                    self.wait_until(&job_b.latch);
+                    break;
+                }
+            }
+        }
+        (result_a, job_b.into_result())
+    }
+
+    /// Executes other jobs until `latch` is set.
+    ///
+    /// Once out of work, sleeps like [`WorkerThread::main_loop`] does, so that jobs queued in
+    /// the meantime are still stolen. The worker running the job that sets the latch wakes it
+    /// up through [`Registry::notify_job_done`].
+    fn wait_until(&self, latch: &Latch) {
+        let mut spins = 0;
+        while !latch.probe() {
+            if let Some(job) = self.find_work() {
+                // SAFETY: Found jobs are alive and executed once.
+                unsafe { self.execute(job) };
+                spins = 0;
+            } else if spins < IDLE_SPINS {
+                spins += 1;
+                hint::spin_loop();
+            } else {
+                spins = 0;
+                self.sleep(Some(latch));
+            }
+        }
+    }
+
+    fn main_loop(&self) {
+        let mut spins = 0;
+        loop {
+            if let Some(job) = self.find_work() {
+                // SAFETY: Found jobs are alive and executed once.
+                unsafe { self.execute(job) };
+                spins = 0;
+                continue;
+            }
+            if self.registry.terminate.load(Ordering::Acquire) {
+                return;
+            }
+            if spins < IDLE_SPINS {
+                spins += 1;
+                hint::spin_loop();
+                continue;
+            }
+            spins = 0;
+            self.sleep(None);
+        }
+    }
+
+    /// Sleeps until work is announced or, if given, `latch` may have been set, unless a job
+    /// shows up in the meantime.
+    fn sleep(&self, latch: Option<&Latch>) {
+        let registry = self.registry;
+        let epoch = registry.event.load(Ordering::Acquire);
+        registry.sleepers.fetch_add(1, Ordering::Relaxed);
+        if latch.is_some() {
+            registry.latch_sleepers.fetch_add(1, Ordering::Relaxed);
+        }
+        // Pairs with the fences in `Registry::notify_work` and `Registry::notify_job_done`
+        fence(Ordering::SeqCst);
+
+        let job = self.find_work();
+        if job.is_none()
+            && !latch.is_some_and(Latch::probe)
+            && !registry.terminate.load(Ordering::Acquire)
+        {
+            futex::wait(&registry.event, epoch);
+        }
+        if latch.is_some() {
+            registry.latch_sleepers.fetch_sub(1, Ordering::Relaxed);
+        }
+        registry.sleepers.fetch_sub(1, Ordering::Relaxed);
+
+        if let Some(job) = job {
+            // SAFETY: Found jobs are alive and executed once.
+            unsafe { self.execute(job) };
+        }
+    }
+
+    /// Executes `job`, then wakes the workers waiting for the latch it may have set.
+    ///
+    /// # Safety
+    ///
+    /// `job` must be alive and not executed yet.
+    unsafe fn execute(&self, job: JobRef) {
+        // SAFETY: Guaranteed by the caller.
+        unsafe { job.execute() };
+        self.registry.notify_job_done();
+    }
+}
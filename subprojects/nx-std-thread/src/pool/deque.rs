@@ -0,0 +1,223 @@
+//! # Chase-Lev deque
+//!
+//! The per-worker job queue of the pool, after Chase and Lev's "Dynamic Circular
+//! Work-Stealing Deque" with the memory orderings of Lê et al.'s "Correct and Efficient
+//! Work-Stealing for Weak Memory Models".
+//!
+//! The owning worker pushes and pops jobs at the bottom, in LIFO order, without any
+//! read-modify-write in the common case. Other workers steal from the top, in FIFO order, with
+//! a single CAS on the top index. The buffer doubles when full; replaced buffers are kept
+//! until the deque is dropped, since a concurrent thief may still be reading from them.
+
+use alloc::{boxed::Box, vec::Vec};
+use core::{
+    cell::UnsafeCell,
+    ops::Deref,
+    ptr,
+    sync::atomic::{AtomicIsize, AtomicPtr, Ordering, fence},
+};
+
+use super::job::{JobHeader, JobRef};
+
+/// Initial number of slots of a deque buffer.
+const INITIAL_CAPACITY: usize = 64;
+
+/// The outcome of [`Deque::steal`].
+pub(super) enum Steal {
+    /// The deque was empty.
+    Empty,
+    /// A job was taken from the top of the deque.
+    Success(JobRef),
+    /// Lost a race with another thief or with the owner; the deque may still hold jobs.
+    Retry,
+}
+
+/// A single-owner, multi-thief work-stealing deque of jobs.
+pub(super) struct Deque {
+    /// Index of the oldest job, advanced by thieves and by the owner taking the last job.
+    top: CachePadded<AtomicIsize>,
+    /// Index one past the newest job, only written by the owner.
+    bottom: CachePadded<AtomicIsize>,
+    /// The current ring buffer.
+    buffer: AtomicPtr<Buffer>,
+    /// Buffers replaced by a larger one, freed on drop. Only accessed by the owner.
+    retired: UnsafeCell<Vec<*mut Buffer>>,
+}
+
+// SAFETY: Thieves only touch the atomic indices and buffer slots; everything else is only
+// accessed by the owner, as required by the `unsafe` owner operations.
+unsafe impl Sync for Deque {}
+// SAFETY: See `Sync`.
+unsafe impl Send for Deque {}
+
+impl Deque {
+    /// Creates an empty deque.
+    pub(super) fn new() -> Self {
+        Self {
+            top: CachePadded(AtomicIsize::new(0)),
+            bottom: CachePadded(AtomicIsize::new(0)),
+            buffer: AtomicPtr::new(Buffer::alloc(INITIAL_CAPACITY)),
+            retired: UnsafeCell::new(Vec::new()),
+        }
+    }
+
+    /// Pushes a job at the bottom of the deque.
+    ///
+    /// # Safety
+    ///
+    /// Must only be called by the thread owning the deque.
+    pub(super) unsafe fn push(&self, job: JobRef) {
+        let bottom = self.bottom.load(Ordering::Relaxed);
+        let top = self.top.load(Ordering::Acquire);
+        let mut buffer = self.buffer.load(Ordering::Relaxed);
+
+        // SAFETY: The buffer is alive until the deque is dropped.
+        if bottom - top >= unsafe { (*buffer).capacity() } as isize {
+            // SAFETY: The caller is the owner.
+            buffer = unsafe { self.grow(bottom, top) };
+        }
+
+        // SAFETY: The buffer is alive; slot `bottom` is not visible to thieves yet.
+        unsafe { (*buffer).write(bottom, job) };
+        fence(Ordering::Release);
+        self.bottom.store(bottom + 1, Ordering::Relaxed);
+    }
+
+    /// Pops the newest job from the bottom of the deque.
+    ///
+    /// # Safety
+    ///
+    /// Must only be called by the thread owning the deque.
+    pub(super) unsafe fn pop(&self) -> Option<JobRef> {
+        let bottom = self.bottom.load(Ordering::Relaxed) - 1;
+        let buffer = self.buffer.load(Ordering::Relaxed);
+        self.bottom.store(bottom, Ordering::Relaxed);
+        fence(Ordering::SeqCst);
+        let top = self.top.load(Ordering::Relaxed);
+
+        if top > bottom {
+            // Empty: restore the bottom index
+            self.bottom.store(bottom + 1, Ordering::Relaxed);
+            return None;
+        }
+
+        // SAFETY: The buffer is alive and slot `bottom` holds a pushed job.
+        let job = unsafe { (*buffer).read(bottom) };
+        if top == bottom {
+            // Last job: race the thieves for it
+            let won = self
+                .top
+                .compare_exchange(top, top + 1, Ordering::SeqCst, Ordering::Relaxed)
+                .is_ok();
+            self.bottom.store(bottom + 1, Ordering::Relaxed);
+            return won.then_some(job);
+        }
+        Some(job)
+    }
+
+    /// Steals the oldest job from the top of the deque.
+    ///
+    /// Can be called from any thread.
+    pub(super) fn steal(&self) -> Steal {
+        let top = self.top.load(Ordering::Acquire);
+        fence(Ordering::SeqCst);
+        let bottom = self.bottom.load(Ordering::Acquire);
+
+        if top >= bottom {
+            return Steal::Empty;
+        }
+
+        let buffer = self.buffer.load(Ordering::Acquire);
+        // SAFETY: Buffers are only freed when the deque is dropped. The slot may be
+        // overwritten by the owner if we lose the race below, in which case the value is
+        // discarded.
+        let job = unsafe { (*buffer).read(top) };
+        match self
+            .top
+            .compare_exchange(top, top + 1, Ordering::SeqCst, Ordering::Relaxed)
+        {
+            Ok(_) => Steal::Success(job),
+            Err(_) => Steal::Retry,
+        }
+    }
+
+    /// Replaces the buffer with one twice as large, copying the jobs in `top..bottom`.
+    ///
+    /// # Safety
+    ///
+    /// Must only be called by the thread owning the deque.
+    unsafe fn grow(&self, bottom: isize, top: isize) -> *mut Buffer {
+        let old = self.buffer.load(Ordering::Relaxed);
+        // SAFETY: The buffer is alive until the deque is dropped.
+        let new = Buffer::alloc(unsafe { (*old).capacity() } * 2);
+        for index in top..bottom {
+            // SAFETY: Both buffers are alive and `index` is in the live range.
+            unsafe { (*new).write(index, (*old).read(index)) };
+        }
+        self.buffer.store(new, Ordering::Release);
+        // SAFETY: Only the owner accesses the retired list.
+        unsafe { (*self.retired.get()).push(old) };
+        new
+    }
+}
+
+impl Drop for Deque {
+    fn drop(&mut self) {
+        let buffers = self.retired.get_mut().drain(..);
+        for buffer in buffers.chain([*self.buffer.get_mut()]) {
+            // SAFETY: Every buffer was allocated by `Buffer::alloc` and nothing references the
+            // deque anymore.
+            drop(unsafe { Box::from_raw(buffer) });
+        }
+    }
+}
+
+/// A power-of-two ring buffer of job pointers.
+struct Buffer {
+    slots: Box<[AtomicPtr<JobHeader>]>,
+}
+
+impl Buffer {
+    fn alloc(capacity: usize) -> *mut Buffer {
+        debug_assert!(capacity.is_power_of_two());
+        let slots = (0..capacity)
+            .map(|_| AtomicPtr::new(ptr::null_mut()))
+            .collect();
+        Box::into_raw(Box::new(Buffer { slots }))
+    }
+
+    fn capacity(&self) -> usize {
+        self.slots.len()
+    }
+
+    fn slot(&self, index: isize) -> &AtomicPtr<JobHeader> {
+        &self.slots[index as usize & (self.slots.len() - 1)]
+    }
+
+    fn write(&self, index: isize, job: JobRef) {
+        self.slot(index).store(job.as_ptr(), Ordering::Relaxed);
+    }
+
+    /// Reads the job at `index`.
+    ///
+    /// # Safety
+    ///
+    /// The slot must have been written at least once.
+    unsafe fn read(&self, index: isize) -> JobRef {
+        let job = self.slot(index).load(Ordering::Relaxed);
+        // SAFETY: Written slots always hold a non-null job pointer.
+        unsafe { JobRef::from_ptr(job) }
+    }
+}
+
+/// A value aligned to its own cache line.
+#[repr(align(64))]
+struct CachePadded<T>(T);
+
+impl<T> Deref for CachePadded<T> {
+    type Target = T;
+
+    fn deref(&self) -> &T {
+        &self.0
+    }
+}
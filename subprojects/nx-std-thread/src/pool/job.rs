@@ -0,0 +1,146 @@
+//! # Jobs
+//!
+//! Type-erased units of work queued in the pool. Every job starts with a [`JobHeader`] holding
+//! its execute function, so a queue slot is a single pointer.
+//!
+//! - [`StackJob`] lives in the frame of the thread waiting for it (`join` and `install`), which
+//!   collects the result once the job's latch is set.
+//! - [`HeapJob`] is boxed and frees itself after running (`spawn` and `Scope::spawn`).
+
+use alloc::boxed::Box;
+use core::{cell::UnsafeCell, ptr::NonNull};
+
+use super::latch::Latch;
+
+/// The common prefix of every job.
+#[repr(C)]
+pub(super) struct JobHeader {
+    execute: unsafe fn(*const JobHeader),
+}
+
+/// A pointer to a queued job.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) struct JobRef(NonNull<JobHeader>);
+
+// SAFETY: Jobs are only constructed from `Send` closures.
+unsafe impl Send for JobRef {}
+
+impl JobRef {
+    /// Rebuilds a job reference from a pointer read from a queue.
+    ///
+    /// # Safety
+    ///
+    /// `ptr` must have been obtained from [`JobRef::as_ptr`].
+    pub(super) unsafe fn from_ptr(ptr: *mut JobHeader) -> Self {
+        // SAFETY: The caller guarantees the pointer came from a `JobRef`.
+        Self(unsafe { NonNull::new_unchecked(ptr) })
+    }
+
+    pub(super) fn as_ptr(self) -> *mut JobHeader {
+        self.0.as_ptr()
+    }
+
+    /// Runs the job.
+    ///
+    /// # Safety
+    ///
+    /// The job must be alive and must be executed at most once.
+    pub(super) unsafe fn execute(self) {
+        let header = self.0.as_ptr();
+        // SAFETY: The caller guarantees the job is alive.
+        unsafe { ((*header).execute)(header) }
+    }
+}
+
+/// A job living on the stack of the thread that waits for its result.
+#[repr(C)]
+pub(super) struct StackJob<F, R> {
+    header: JobHeader,
+    func: UnsafeCell<Option<F>>,
+    result: UnsafeCell<Option<R>>,
+    /// Set once `result` holds the job's output.
+    pub(super) latch: Latch,
+}
+
+impl<F, R> StackJob<F, R>
+where
+    F: FnOnce() -> R + Send,
+    R: Send,
+{
+    pub(super) fn new(func: F) -> Self {
+        Self {
+            header: JobHeader {
+                execute: Self::execute,
+            },
+            func: UnsafeCell::new(Some(func)),
+            result: UnsafeCell::new(None),
+            latch: Latch::new(),
+        }
+    }
+
+    /// Returns a reference to queue this job.
+    ///
+    /// The job must not be moved or dropped while the reference is queued or running.
+    pub(super) fn as_job_ref(&self) -> JobRef {
+        JobRef(NonNull::from(&self.header))
+    }
+
+    /// Runs the job on the current thread, after popping it back before anyone executed it.
+    pub(super) fn run_inline(self) -> R {
+        let func = self.func.into_inner().expect("job already executed");
+        func()
+    }
+
+    /// Returns the result of the job once its latch is set.
+    pub(super) fn into_result(self) -> R {
+        debug_assert!(self.latch.probe());
+        self.result.into_inner().expect("job result missing")
+    }
+
+    unsafe fn execute(this: *const JobHeader) {
+        // SAFETY: `header` is the first field of the `repr(C)` job, which the waiting thread
+        // keeps alive until the latch is set.
+        let this = unsafe { &*this.cast::<Self>() };
+        // SAFETY: Only the executing thread touches `func` and `result` before the latch is set.
+        let func = unsafe { (*this.func.get()).take() }.expect("job already executed");
+        let result = func();
+        // SAFETY: See above.
+        unsafe { *this.result.get() = Some(result) };
+        this.latch.set();
+    }
+}
+
+/// A boxed job, freed once executed.
+#[repr(C)]
+pub(super) struct HeapJob<F> {
+    header: JobHeader,
+    func: F,
+}
+
+impl<F> HeapJob<F>
+where
+    F: FnOnce() + Send,
+{
+    /// Boxes `func` into a job.
+    ///
+    /// # Safety
+    ///
+    /// The returned job must be executed exactly once, before anything `func` borrows is
+    /// dropped.
+    pub(super) unsafe fn into_job_ref(func: F) -> JobRef {
+        let job = Box::new(Self {
+            header: JobHeader {
+                execute: Self::execute,
+            },
+            func,
+        });
+        JobRef(NonNull::from(Box::leak(job)).cast())
+    }
+
+    unsafe fn execute(this: *const JobHeader) {
+        // SAFETY: `header` is the first field of the `repr(C)` job, allocated by
+        // `into_job_ref` and executed once.
+        let job = unsafe { Box::from_raw(this.cast::<Self>().cast_mut()) };
+        (job.func)();
+    }
+}
@@ -0,0 +1,60 @@
+//! # Latch
+//!
+//! A one-shot completion flag. Workers waiting on a latch keep executing other jobs and only
+//! poll it with [`Latch::probe`], sleeping on the pool's work announcements when idle; threads
+//! outside the pool block on it with [`Latch::wait`], which sleeps on the latch's futex word.
+
+use core::sync::atomic::{AtomicU32, Ordering};
+
+use nx_sys_sync::futex;
+
+/// The latch is not set and nobody sleeps on it.
+const UNSET: u32 = 0;
+/// The latch is not set and at least one thread sleeps on it.
+const SLEEPING: u32 = 1;
+/// The latch is set.
+const SET: u32 = 2;
+
+pub(super) struct Latch {
+    state: AtomicU32,
+}
+
+impl Latch {
+    pub(super) const fn new() -> Self {
+        Self {
+            state: AtomicU32::new(UNSET),
+        }
+    }
+
+    /// Returns `true` if the latch is set.
+    ///
+    /// Everything written before [`Latch::set`] is visible once this returns `true`.
+    pub(super) fn probe(&self) -> bool {
+        self.state.load(Ordering::Acquire) == SET
+    }
+
+    /// Sets the latch, waking the threads sleeping on it.
+    ///
+    /// The latch's owner may drop it as soon as it observes the new state, so the latch must
+    /// not be touched after this call.
+    pub(super) fn set(&self) {
+        if self.state.swap(SET, Ordering::AcqRel) == SLEEPING {
+            // The owner may already have returned; signaling its stale address is at worst a
+            // spurious wake-up for a later futex on that address.
+            futex::wake_all(&self.state);
+        }
+    }
+
+    /// Blocks the current thread until the latch is set.
+    pub(super) fn wait(&self) {
+        loop {
+            match self
+                .state
+                .compare_exchange(UNSET, SLEEPING, Ordering::Acquire, Ordering::Acquire)
+            {
+                Ok(_) | Err(SLEEPING) => futex::wait(&self.state, SLEEPING),
+                Err(_) => return,
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+//! # Worker threads
+//!
+//! Bindings to the libnx thread API used to start the pool workers. libnx sets up the
+//! thread's TLS and `ThreadVars`, which the Rust side of the tree does not do yet. The
+//! workers still exit through `nx_sys_thread::exit_current`, which releases their
+//! per-thread allocator cache and RNG.
+
+use core::ffi::{c_int, c_void};
+
+/// Storage for a libnx `Thread` object.
+///
+/// The pool only hands it to libnx, so the contents are opaque. libnx's `Thread` is 56 bytes;
+/// the storage is rounded up to 64.
+#[repr(C, align(8))]
+pub(super) struct RawThread([u8; 64]);
+
+unsafe extern "C" {
+    fn threadCreate(
+        t: *mut RawThread,
+        entry: unsafe extern "C" fn(*mut c_void),
+        arg: *mut c_void,
+        stack_mem: *mut c_void,
+        stack_sz: usize,
+        prio: c_int,
+        cpuid: c_int,
+    ) -> u32;
+    fn threadStart(t: *mut RawThread) -> u32;
+    fn threadWaitForExit(t: *mut RawThread) -> u32;
+    fn threadClose(t: *mut RawThread) -> u32;
+}
+
+impl RawThread {
+    pub(super) const fn zeroed() -> Self {
+        Self([0; 64])
+    }
+
+    /// Creates a suspended thread running `entry(arg)` on `core`.
+    ///
+    /// The kernel restricts the thread's core mask to `core` alone, so the thread never
+    /// migrates. The stack is allocated by libnx.
+    ///
+    /// On failure, returns the raw result code.
+    ///
+    /// # Safety
+    ///
+    /// `self` must not move until [`RawThread::close`] is called, and `arg` must stay valid
+    /// until `entry` runs.
+    pub(super) unsafe fn create(
+        &mut self,
+        entry: unsafe extern "C" fn(*mut c_void),
+        arg: *mut c_void,
+        stack_size: usize,
+        priority: i32,
+        core: u8,
+    ) -> Result<(), u32> {
+        // SAFETY: The caller guarantees the storage and argument lifetimes.
+        let rc = unsafe {
+            threadCreate(
+                self,
+                entry,
+                arg,
+                core::ptr::null_mut(),
+                stack_size,
+                priority,
+                core as c_int,
+            )
+        };
+        if rc == 0 { Ok(()) } else { Err(rc) }
+    }
+
+    /// Starts a thread created with [`RawThread::create`].
+    pub(super) fn start(&mut self) -> Result<(), u32> {
+        // SAFETY: `self` holds a created thread.
+        let rc = unsafe { threadStart(self) };
+        if rc == 0 { Ok(()) } else { Err(rc) }
+    }
+
+    /// Waits for the thread to exit.
+    pub(super) fn wait_for_exit(&mut self) {
+        // SAFETY: `self` holds a created thread.
+        unsafe { threadWaitForExit(self) };
+    }
+
+    /// Frees the thread's resources. The thread must have exited or never been started.
+    pub(super) fn close(&mut self) {
+        // SAFETY: `self` holds a created thread that is not running.
+        unsafe { threadClose(self) };
+    }
+}
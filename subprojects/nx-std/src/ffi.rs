@@ -8,6 +8,8 @@
 
 #[cfg(feature = "alloc")]
 pub use nx_alloc::ffi as alloc;
+#[cfg(feature = "mem")]
+pub mod mem;
 #[cfg(feature = "rand")]
 pub use nx_rand::ffi as rand;
 #[cfg(feature = "rt")]
@@ -0,0 +1,386 @@
+//! AArch64 implementations of the C memory and string functions.
+//!
+//! These replace newlib's generic `memcpy`, `memmove`, `memset`, `memcmp` and `strlen`,
+//! which copy a word at a time, through the `mem_override.ld` linker script:
+//!
+//! - Copies move 64 bytes per iteration through NEON registers, with stores aligned to
+//!   16 bytes. Sizes under 64 bytes take a branch-light path of two overlapping accesses.
+//! - `memset` of zero clears whole cache blocks with `DC ZVA` when the size allows it.
+//! - `strlen` scans 16 aligned bytes at a time, never crossing into the next page before
+//!   the terminator is found.
+//!
+//! Every function is written in assembly: a Rust body could be lowered back to a call to
+//! the very function it implements.
+//!
+//! # References
+//!
+//! - [ARM-software/optimized-routines: string/aarch64](https://github.com/ARM-software/optimized-routines/tree/master/string/aarch64)
+
+use core::{
+    arch::naked_asm,
+    ffi::{c_char, c_int, c_void},
+};
+
+/// Copies `n` bytes from `src` to `dst`, returning `dst`.
+///
+/// Every size under 64 bytes loads the whole range before storing it, and larger sizes load
+/// the first 16 and the last 64 bytes before the loop and store them after it: a forward
+/// overlapping copy (`dst` below `src`) is thus correct too, which [`__nx_std__memmove`]
+/// relies on.
+///
+/// # Safety
+///
+/// `src` must be valid for reads, and `dst` for writes of `n` bytes.
+#[unsafe(naked)]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_std__memcpy(
+    dst: *mut c_void,
+    src: *const c_void,
+    n: usize,
+) -> *mut c_void {
+    naked_asm!(
+        "cmp x2, #64",
+        "b.hs 3f",
+        // 32..63 bytes: first and last 32
+        "cmp x2, #32",
+        "b.lo 1f",
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldp q0, q1, [x1]",
+        "ldp q2, q3, [x4, #-32]",
+        "stp q0, q1, [x0]",
+        "stp q2, q3, [x5, #-32]",
+        "ret",
+        // 16..31 bytes: first and last 16
+        "1:",
+        "cmp x2, #16",
+        "b.lo 1f",
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldr q0, [x1]",
+        "ldr q1, [x4, #-16]",
+        "str q0, [x0]",
+        "str q1, [x5, #-16]",
+        "ret",
+        // 8..15 bytes: first and last 8
+        "1:",
+        "cmp x2, #8",
+        "b.lo 1f",
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldr x6, [x1]",
+        "ldr x7, [x4, #-8]",
+        "str x6, [x0]",
+        "str x7, [x5, #-8]",
+        "ret",
+        // 4..7 bytes: first and last 4
+        "1:",
+        "cmp x2, #4",
+        "b.lo 1f",
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldr w6, [x1]",
+        "ldr w7, [x4, #-4]",
+        "str w6, [x0]",
+        "str w7, [x5, #-4]",
+        "ret",
+        // 0..3 bytes: first, middle and last
+        "1:",
+        "cbz x2, 2f",
+        "lsr x8, x2, #1",
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldrb w6, [x1]",
+        "ldrb w7, [x1, x8]",
+        "ldrb w9, [x4, #-1]",
+        "strb w6, [x0]",
+        "strb w7, [x0, x8]",
+        "strb w9, [x5, #-1]",
+        "2:",
+        "ret",
+        // 64 bytes and more: unaligned head and tail, then aligned 64-byte blocks
+        "3:",
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldr q4, [x1]",
+        "ldp q5, q6, [x4, #-64]",
+        "ldp q7, q16, [x4, #-32]",
+        "neg x9, x0",
+        "and x9, x9, #15",
+        "add x1, x1, x9",
+        "add x3, x0, x9",
+        "sub x2, x2, x9",
+        "subs x2, x2, #64",
+        "b.ls 5f",
+        "4:",
+        "ldp q0, q1, [x1]",
+        "ldp q2, q3, [x1, #32]",
+        "prfm pldl1strm, [x1, #256]",
+        "add x1, x1, #64",
+        "stp q0, q1, [x3]",
+        "stp q2, q3, [x3, #32]",
+        "add x3, x3, #64",
+        "subs x2, x2, #64",
+        "b.hi 4b",
+        "5:",
+        "stp q5, q6, [x5, #-64]",
+        "stp q7, q16, [x5, #-32]",
+        "str q4, [x0]",
+        "ret",
+    )
+}
+
+/// Copies `n` bytes from `src` to `dst`, which may overlap, returning `dst`.
+///
+/// # Safety
+///
+/// `src` must be valid for reads, and `dst` for writes of `n` bytes.
+#[unsafe(naked)]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_std__memmove(
+    dst: *mut c_void,
+    src: *const c_void,
+    n: usize,
+) -> *mut c_void {
+    naked_asm!(
+        // `dst` below `src`, or past its end: copy forwards
+        "sub x9, x0, x1",
+        "cmp x9, x2",
+        "b.hs {memcpy}",
+        "cmp x2, #64",
+        "b.lo {memcpy}",
+        // `dst` overlaps the end of `src`: unaligned head and tail, then aligned 64-byte
+        // blocks backwards
+        "add x4, x1, x2",
+        "add x5, x0, x2",
+        "ldp q4, q5, [x1]",
+        "ldp q6, q7, [x1, #32]",
+        "ldr q16, [x4, #-16]",
+        "and x9, x5, #15",
+        "sub x4, x4, x9",
+        "sub x3, x5, x9",
+        "sub x2, x2, x9",
+        "subs x2, x2, #64",
+        "b.ls 2f",
+        "1:",
+        "ldp q2, q3, [x4, #-32]",
+        "ldp q0, q1, [x4, #-64]",
+        "sub x4, x4, #64",
+        "stp q2, q3, [x3, #-32]",
+        "stp q0, q1, [x3, #-64]",
+        "sub x3, x3, #64",
+        "subs x2, x2, #64",
+        "b.hi 1b",
+        "2:",
+        "stp q4, q5, [x0]",
+        "stp q6, q7, [x0, #32]",
+        "str q16, [x5, #-16]",
+        "ret",
+        memcpy = sym __nx_std__memcpy,
+    )
+}
+
+/// Fills `n` bytes at `dst` with the byte `c`, returning `dst`.
+///
+/// # Safety
+///
+/// `dst` must be valid for writes of `n` bytes. Large zero fills use `DC ZVA`, which faults
+/// on device memory.
+#[unsafe(naked)]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_std__memset(dst: *mut c_void, c: c_int, n: usize) -> *mut c_void {
+    naked_asm!(
+        "dup v0.16b, w1",
+        "add x5, x0, x2",
+        "cmp x2, #64",
+        "b.hs 3f",
+        // 32..63 bytes: first and last 32
+        "cmp x2, #32",
+        "b.lo 1f",
+        "stp q0, q0, [x0]",
+        "stp q0, q0, [x5, #-32]",
+        "ret",
+        // 16..31 bytes: first and last 16
+        "1:",
+        "cmp x2, #16",
+        "b.lo 1f",
+        "str q0, [x0]",
+        "str q0, [x5, #-16]",
+        "ret",
+        // 8..15 bytes: first and last 8
+        "1:",
+        "fmov x6, d0",
+        "cmp x2, #8",
+        "b.lo 1f",
+        "str x6, [x0]",
+        "str x6, [x5, #-8]",
+        "ret",
+        // 4..7 bytes: first and last 4
+        "1:",
+        "cmp x2, #4",
+        "b.lo 1f",
+        "str w6, [x0]",
+        "str w6, [x5, #-4]",
+        "ret",
+        // 0..3 bytes: first, middle and last
+        "1:",
+        "cbz x2, 2f",
+        "lsr x8, x2, #1",
+        "strb w1, [x0]",
+        "strb w1, [x0, x8]",
+        "strb w1, [x5, #-1]",
+        "2:",
+        "ret",
+        // 64 bytes and more: unaligned head, then aligned blocks, then unaligned tail
+        "3:",
+        "str q0, [x0]",
+        "neg x9, x0",
+        "and x9, x9, #15",
+        "add x3, x0, x9",
+        "sub x2, x2, x9",
+        // Zero fills of at least two cache blocks, and 256 bytes, use `DC ZVA`
+        "tst w1, #0xff",
+        "b.ne 6f",
+        "mrs x10, dczid_el0",
+        "tbnz w10, #4, 6f",
+        "and w10, w10, #15",
+        "mov x11, #4",
+        "lsl x11, x11, x10",
+        "cmp x2, #256",
+        "b.lo 6f",
+        "cmp x2, x11, lsl #1",
+        "b.lo 6f",
+        // Align to the block with 16-byte stores, then zero whole blocks
+        "sub x12, x11, #1",
+        "7:",
+        "tst x3, x12",
+        "b.eq 8f",
+        "str q0, [x3], #16",
+        "sub x2, x2, #16",
+        "b 7b",
+        "8:",
+        "dc zva, x3",
+        "add x3, x3, x11",
+        "sub x2, x2, x11",
+        "cmp x2, x11",
+        "b.hs 8b",
+        // 64-byte blocks, the last 64 bytes stored from the end
+        "6:",
+        "subs x2, x2, #64",
+        "b.ls 5f",
+        "4:",
+        "stp q0, q0, [x3]",
+        "stp q0, q0, [x3, #32]",
+        "add x3, x3, #64",
+        "subs x2, x2, #64",
+        "b.hi 4b",
+        "5:",
+        "stp q0, q0, [x5, #-64]",
+        "stp q0, q0, [x5, #-32]",
+        "ret",
+    )
+}
+
+/// Compares `n` bytes at `a` and `b` as unsigned bytes.
+///
+/// Returns zero if they are equal, and otherwise a value of the sign of the difference
+/// between the first differing bytes.
+///
+/// # Safety
+///
+/// `a` and `b` must be valid for reads of `n` bytes.
+#[unsafe(naked)]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_std__memcmp(a: *const c_void, b: *const c_void, n: usize) -> c_int {
+    naked_asm!(
+        // 16 bytes at a time
+        "cmp x2, #16",
+        "b.lo 3f",
+        "1:",
+        "ldp x3, x4, [x0], #16",
+        "ldp x5, x6, [x1], #16",
+        "cmp x3, x5",
+        "b.ne 5f",
+        "cmp x4, x6",
+        "b.ne 6f",
+        "sub x2, x2, #16",
+        "cmp x2, #16",
+        "b.hs 1b",
+        // Then 8
+        "3:",
+        "cmp x2, #8",
+        "b.lo 4f",
+        "ldr x3, [x0], #8",
+        "ldr x5, [x1], #8",
+        "cmp x3, x5",
+        "b.ne 5f",
+        "sub x2, x2, #8",
+        // Then one at a time
+        "4:",
+        "cbz x2, 8f",
+        "7:",
+        "ldrb w3, [x0], #1",
+        "ldrb w5, [x1], #1",
+        "subs w3, w3, w5",
+        "b.ne 9f",
+        "subs x2, x2, #1",
+        "b.ne 7b",
+        "8:",
+        "mov w0, #0",
+        "ret",
+        "9:",
+        "mov w0, w3",
+        "ret",
+        // Differing words: compare them as big-endian, so that the first byte weighs most
+        "6:",
+        "mov x3, x4",
+        "mov x5, x6",
+        "5:",
+        "rev x3, x3",
+        "rev x5, x5",
+        "cmp x3, x5",
+        "cset w0, hi",
+        "csinv w0, w0, wzr, hs",
+        "ret",
+    )
+}
+
+/// Returns the length of the nul-terminated string `s`.
+///
+/// # Safety
+///
+/// `s` must point to a nul-terminated string.
+#[unsafe(naked)]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_std__strlen(s: *const c_char) -> usize {
+    naked_asm!(
+        // Aligned 16-byte chunks never cross a page: the first one may start before `s`,
+        // whose bytes are shifted out of the mask
+        "bic x2, x0, #15",
+        "ldr q0, [x2]",
+        "cmeq v0.16b, v0.16b, #0",
+        // One nibble per byte, set for the nul ones
+        "shrn v0.8b, v0.8h, #4",
+        "fmov x3, d0",
+        "and x4, x0, #15",
+        "lsl x4, x4, #2",
+        "lsr x3, x3, x4",
+        "cbnz x3, 2f",
+        "1:",
+        "ldr q0, [x2, #16]!",
+        "cmeq v0.16b, v0.16b, #0",
+        "shrn v0.8b, v0.8h, #4",
+        "fmov x3, d0",
+        "cbz x3, 1b",
+        "rbit x3, x3",
+        "clz x3, x3",
+        "sub x0, x2, x0",
+        "add x0, x0, x3, lsr #2",
+        "ret",
+        "2:",
+        "rbit x3, x3",
+        "clz x3, x3",
+        "lsr x0, x3, #2",
+        "ret",
+    )
+}
@@ -14,6 +14,13 @@ pub extern crate nx_alloc; // Provides #[global_allocator]
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+pub mod error_ring {
+    pub use nx_panic_handler::ring::*;
+}
+#[cfg(feature = "async")]
+pub mod executor {
+    pub use nx_std_async::*;
+}
 #[cfg(feature = "rand")]
 pub mod rand {
     pub use nx_rand::*;
@@ -22,6 +29,10 @@ pub mod rand {
 pub mod sync {
     pub use nx_std_sync::*;
 }
+#[cfg(feature = "thread")]
+pub mod thread {
+    pub use nx_std_thread::*;
+}
 #[cfg(feature = "time")]
 pub mod time {
     pub use nx_time::*;
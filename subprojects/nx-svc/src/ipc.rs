@@ -159,7 +159,7 @@ pub fn send_sync_request(handle: Handle) -> Result<(), SendSyncError> {
 }
 
 /// Error returned by [`send_sync_request`].
-#[derive(Debug, thiserror::Error)]
+#[derive(Debug, Clone, Copy, thiserror::Error)]
 pub enum SendSyncError {
     /// Thread is terminating.
     #[error("Termination requested")]
@@ -190,13 +190,29 @@ impl ToRawResultCode for SendSyncError {
     }
 }
 
+/// Number of 32-bit words of a light IPC message.
+pub const LIGHT_MESSAGE_WORDS: usize = 7;
+
+/// Reply flag of the first word of a light IPC message.
+///
+/// Set by the server on a reply passed to [`reply_and_receive_light`]. The kernel copies
+/// the reply words to the client as they are, so the client must mask the flag out.
+pub const LIGHT_REPLY_FLAG: u32 = 1 << 31;
+
+/// A light IPC message, passed in registers `w1`-`w7`.
+pub type LightMessage = [u32; LIGHT_MESSAGE_WORDS];
+
 /// Sends a light synchronous IPC request on a session.
 ///
-/// Light IPC uses registers instead of the TLS buffer for small messages.
-pub fn send_sync_request_light(handle: Handle) -> Result<(), SendSyncLightError> {
+/// Light IPC passes `msg` in registers instead of the TLS buffer, and overwrites it with
+/// the reply of the server. `handle` must be the client side of a light session.
+pub fn send_sync_request_light(
+    handle: Handle,
+    msg: &mut LightMessage,
+) -> Result<(), SendSyncLightError> {
     // SAFETY: The kernel validates the session handle and returns an error if invalid.
-    // Light IPC uses registers for message passing, no memory pointers involved.
-    let rc = unsafe { raw::send_sync_request_light(handle.to_raw()) };
+    // `msg` is valid for reads and writes of the seven message words.
+    let rc = unsafe { raw::send_sync_request_light_with_args(handle.to_raw(), msg) };
     RawResult::from_raw(rc).map((), |rc| match rc.description() {
         desc if KError::TerminationRequested == desc => SendSyncLightError::TerminationRequested,
         desc if KError::InvalidHandle == desc => SendSyncLightError::InvalidHandle,
@@ -243,6 +259,247 @@ impl ToRawResultCode for SendSyncLightError {
     }
 }
 
+/// Replies to the pending light request on a server session, and waits for the next one.
+///
+/// If [`LIGHT_REPLY_FLAG`] is set in the first word of `msg`, `msg` is the reply to the
+/// request received last; otherwise nothing is replied. `msg` is then overwritten with
+/// the next request. `handle` must be the server side of a light session.
+pub fn reply_and_receive_light(
+    handle: Handle,
+    msg: &mut LightMessage,
+) -> Result<(), ReplyAndReceiveLightError> {
+    // SAFETY: The kernel validates the session handle and returns an error if invalid.
+    // `msg` is valid for reads and writes of the seven message words.
+    let rc = unsafe { raw::reply_and_receive_light_with_args(handle.to_raw(), msg) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::TerminationRequested == desc => {
+            ReplyAndReceiveLightError::TerminationRequested
+        }
+        desc if KError::InvalidHandle == desc => ReplyAndReceiveLightError::InvalidHandle,
+        desc if KError::Cancelled == desc => ReplyAndReceiveLightError::Cancelled,
+        desc if KError::SessionClosed == desc => ReplyAndReceiveLightError::SessionClosed,
+        desc if KError::InvalidState == desc => ReplyAndReceiveLightError::InvalidState,
+        _ => ReplyAndReceiveLightError::Unknown(rc.into()),
+    })
+}
+
+/// Error returned by [`reply_and_receive_light`].
+#[derive(Debug, thiserror::Error)]
+pub enum ReplyAndReceiveLightError {
+    /// Thread is terminating.
+    #[error("Termination requested")]
+    TerminationRequested,
+    /// Invalid session handle.
+    #[error("Invalid handle")]
+    InvalidHandle,
+    /// Wait was cancelled.
+    #[error("Cancelled")]
+    Cancelled,
+    /// Session closed by client.
+    #[error("Session closed")]
+    SessionClosed,
+    /// Reply without a pending request.
+    #[error("Invalid state")]
+    InvalidState,
+    /// Unexpected kernel error.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for ReplyAndReceiveLightError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::TerminationRequested => KError::TerminationRequested.to_rc(),
+            Self::InvalidHandle => KError::InvalidHandle.to_rc(),
+            Self::Cancelled => KError::Cancelled.to_rc(),
+            Self::SessionClosed => KError::SessionClosed.to_rc(),
+            Self::InvalidState => KError::InvalidState.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Replies to a request, then waits for the next request or connection on `handles`.
+///
+/// If `reply_target` is `Some`, the message in the TLS buffer is sent as the reply to the
+/// request received last on that server session; otherwise the TLS buffer must hold a
+/// blank message. Returns the index in `handles` of the session with a request, now copied
+/// into the TLS buffer, or of the port with a pending connection.
+///
+/// `timeout` is in nanoseconds: `u64::MAX` waits forever, and `0` only replies.
+pub fn reply_and_receive(
+    handles: &[Handle],
+    reply_target: Option<Handle>,
+    timeout: u64,
+) -> Result<usize, ReplyAndReceiveError> {
+    let mut index = -1;
+    let reply_target = reply_target.map_or(raw::INVALID_HANDLE, |handle| handle.to_raw());
+    // SAFETY: `Handle` is a transparent wrapper of a raw handle, so `handles` is a valid array
+    // of `handles.len()` raw handles. `index` is a valid mutable pointer to receive the index.
+    // The kernel validates every handle and returns an error if one is invalid.
+    let rc = unsafe {
+        raw::reply_and_receive(
+            &mut index,
+            handles.as_ptr().cast(),
+            handles.len() as i32,
+            reply_target,
+            timeout,
+        )
+    };
+
+    RawResult::from_raw(rc).map(index as usize, |rc| match rc.description() {
+        desc if KError::TimedOut == desc => ReplyAndReceiveError::TimedOut,
+        desc if KError::SessionClosed == desc => {
+            ReplyAndReceiveError::SessionClosed(usize::try_from(index).ok())
+        }
+        desc if KError::TerminationRequested == desc => ReplyAndReceiveError::TerminationRequested,
+        desc if KError::Cancelled == desc => ReplyAndReceiveError::Cancelled,
+        desc if KError::InvalidHandle == desc => ReplyAndReceiveError::InvalidHandle,
+        desc if KError::OutOfRange == desc => ReplyAndReceiveError::OutOfRange,
+        _ => ReplyAndReceiveError::Unknown(rc.into()),
+    })
+}
+
+/// Error returned by [`reply_and_receive`].
+#[derive(Debug, thiserror::Error)]
+pub enum ReplyAndReceiveError {
+    /// No request arrived before the timeout.
+    #[error("Timed out")]
+    TimedOut,
+    /// A session was closed by its client: the one at the index in `handles`, or the reply
+    /// target if `None`.
+    #[error("Session closed")]
+    SessionClosed(Option<usize>),
+    /// Thread is terminating.
+    #[error("Termination requested")]
+    TerminationRequested,
+    /// Wait was cancelled.
+    #[error("Cancelled")]
+    Cancelled,
+    /// Invalid session or port handle.
+    #[error("Invalid handle")]
+    InvalidHandle,
+    /// More handles than the kernel waits on at once.
+    #[error("Out of range")]
+    OutOfRange,
+    /// Unexpected kernel error.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for ReplyAndReceiveError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::TimedOut => KError::TimedOut.to_rc(),
+            Self::SessionClosed(_) => KError::SessionClosed.to_rc(),
+            Self::TerminationRequested => KError::TerminationRequested.to_rc(),
+            Self::Cancelled => KError::Cancelled.to_rc(),
+            Self::InvalidHandle => KError::InvalidHandle.to_rc(),
+            Self::OutOfRange => KError::OutOfRange.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Creates an IPC session, returning its server and client sides.
+pub fn create_session() -> Result<(Handle, Handle), CreateSessionError> {
+    create_session_impl(false)
+}
+
+/// Creates a light IPC session, returning its server and client sides.
+pub fn create_light_session() -> Result<(Handle, Handle), CreateSessionError> {
+    create_session_impl(true)
+}
+
+fn create_session_impl(is_light: bool) -> Result<(Handle, Handle), CreateSessionError> {
+    let mut server = raw::INVALID_HANDLE;
+    let mut client = raw::INVALID_HANDLE;
+    // SAFETY: `server` and `client` are valid mutable pointers to receive the output handles.
+    let rc = unsafe { raw::create_session(&mut server, &mut client, is_light, 0) };
+
+    RawResult::from_raw(rc).map((Handle(server), Handle(client)), |rc| {
+        match rc.description() {
+            desc if KError::OutOfResource == desc => CreateSessionError::OutOfResource,
+            desc if KError::OutOfHandles == desc => CreateSessionError::OutOfHandles,
+            desc if KError::LimitReached == desc => CreateSessionError::LimitReached,
+            _ => CreateSessionError::Unknown(rc.into()),
+        }
+    })
+}
+
+/// Error returned by [`create_session`] and [`create_light_session`].
+#[derive(Debug, thiserror::Error)]
+pub enum CreateSessionError {
+    /// Failed to allocate session object.
+    #[error("Out of resource")]
+    OutOfResource,
+    /// Process handle table is full.
+    #[error("Out of handles")]
+    OutOfHandles,
+    /// Process session resource limit exceeded.
+    #[error("Limit reached")]
+    LimitReached,
+    /// Unexpected kernel error.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for CreateSessionError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::OutOfResource => KError::OutOfResource.to_rc(),
+            Self::OutOfHandles => KError::OutOfHandles.to_rc(),
+            Self::LimitReached => KError::LimitReached.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Accepts a pending connection on a server port, returning the server session handle.
+///
+/// Sessions accepted on a light port are light server sessions.
+pub fn accept_session(port: Handle) -> Result<Handle, AcceptSessionError> {
+    let mut session = raw::INVALID_HANDLE;
+    // SAFETY: `session` is a valid mutable pointer to receive the output handle.
+    // The kernel validates the port handle and returns an error if invalid.
+    let rc = unsafe { raw::accept_session(&mut session, port.to_raw()) };
+
+    RawResult::from_raw(rc).map(Handle(session), |rc| match rc.description() {
+        desc if KError::OutOfHandles == desc => AcceptSessionError::OutOfHandles,
+        desc if KError::InvalidHandle == desc => AcceptSessionError::InvalidHandle,
+        desc if KError::NotFound == desc => AcceptSessionError::NotFound,
+        _ => AcceptSessionError::Unknown(rc.into()),
+    })
+}
+
+/// Error returned by [`accept_session`].
+#[derive(Debug, thiserror::Error)]
+pub enum AcceptSessionError {
+    /// Process handle table is full.
+    #[error("Out of handles")]
+    OutOfHandles,
+    /// Invalid port handle.
+    #[error("Invalid handle")]
+    InvalidHandle,
+    /// No pending connection on the port.
+    #[error("Not found")]
+    NotFound,
+    /// Unexpected kernel error.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for AcceptSessionError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::OutOfHandles => KError::OutOfHandles.to_rc(),
+            Self::InvalidHandle => KError::InvalidHandle.to_rc(),
+            Self::NotFound => KError::NotFound.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
 /// Sends a synchronous IPC request using a user-provided buffer.
 ///
 /// The buffer must be page-aligned and its size must be page-aligned and non-zero.
@@ -482,3 +739,14 @@ impl ToRawResultCode for CloseHandleError {
         }
     }
 }
+
+/// Closes an IPC completion event handle returned by
+/// [`send_async_request_with_user_buffer`].
+pub fn close_event_handle(handle: EventHandle) -> Result<(), CloseHandleError> {
+    // SAFETY: The kernel validates the handle and returns an error if invalid.
+    let rc = unsafe { raw::close_handle(handle.to_raw()) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidHandle == desc => CloseHandleError::InvalidHandle,
+        _ => CloseHandleError::Unknown(rc.into()),
+    })
+}
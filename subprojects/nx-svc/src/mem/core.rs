@@ -352,6 +352,69 @@ impl ToRawResultCode for UnmapMemoryError {
     }
 }
 
+/// Changes the `mask` attributes of a page-aligned memory range to `attr`.
+///
+/// User processes may only change [`raw::MemoryAttribute::IS_UNCACHED`].
+///
+/// # Safety
+///
+/// The range must be owned by the caller. Dirty cache lines of a range made uncached are
+/// written back at an arbitrary later point: the caller must flush the range first.
+pub unsafe fn set_memory_attribute(
+    addr: NonNull<c_void>,
+    size: usize,
+    mask: raw::MemoryAttribute,
+    attr: raw::MemoryAttribute,
+) -> Result<(), SetMemoryAttributeError> {
+    // SAFETY: The caller guarantees the range is owned by the process.
+    let rc = unsafe { raw::set_memory_attribute(addr.as_ptr(), size, mask.bits(), attr.bits()) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidAddress == desc => SetMemoryAttributeError::InvalidAddress,
+        desc if KError::InvalidSize == desc => SetMemoryAttributeError::InvalidSize,
+        desc if KError::InvalidCurrentMemory == desc => {
+            SetMemoryAttributeError::InvalidCurrentMemory
+        }
+        desc if KError::InvalidCombination == desc => SetMemoryAttributeError::InvalidCombination,
+        _ => SetMemoryAttributeError::Unknown(rc.into()),
+    })
+}
+
+/// Error type for set_memory_attribute operations.
+#[derive(Debug, thiserror::Error)]
+pub enum SetMemoryAttributeError {
+    /// The memory address is not aligned to 4KB, or the range overflows.
+    #[error("Invalid address")]
+    InvalidAddress,
+
+    /// The size is 0 or not aligned to 4KB.
+    #[error("Invalid size")]
+    InvalidSize,
+
+    /// The memory state of the range does not allow changing its attributes.
+    #[error("Invalid memory state")]
+    InvalidCurrentMemory,
+
+    /// The mask or attributes include attributes that cannot be changed.
+    #[error("Invalid combination")]
+    InvalidCombination,
+
+    /// An unknown error occurred
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for SetMemoryAttributeError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            SetMemoryAttributeError::InvalidAddress => KError::InvalidAddress.to_rc(),
+            SetMemoryAttributeError::InvalidSize => KError::InvalidSize.to_rc(),
+            SetMemoryAttributeError::InvalidCurrentMemory => KError::InvalidCurrentMemory.to_rc(),
+            SetMemoryAttributeError::InvalidCombination => KError::InvalidCombination.to_rc(),
+            SetMemoryAttributeError::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
 /// Information about a memory region.
 #[derive(Debug, Clone)]
 pub struct MemoryInfo {
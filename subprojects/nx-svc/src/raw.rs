@@ -1381,6 +1381,45 @@ pub unsafe extern "C" fn send_sync_request_light(session: Handle) -> ResultCode
     );
 }
 
+/// Sends a light IPC synchronization request to a session, passing its message in registers.
+///
+/// `Result svcSendSyncRequestLight(Handle session, u32 *args);`
+///
+/// Syscall code: [SEND_SYNC_REQUEST_LIGHT](crate::code::SEND_SYNC_REQUEST_LIGHT) (`0x20`).
+///
+/// | Arg | Name | Description |
+/// | --- | --- | --- |
+/// | IN | _session_ | Light client session handle. |
+/// | IN/OUT | _args_ | Seven-word message, loaded into `w1`-`w7` and overwritten with the reply. |
+///
+/// Ref: <https://switchbrew.org/wiki/SVC#SendSyncRequestLight>
+///
+/// # Safety
+///
+/// The caller must ensure that `session` is a valid kernel session handle owned by the current
+/// process, and that `args` is valid for reads and writes of seven `u32`s.
+#[unsafe(naked)]
+pub unsafe extern "C" fn send_sync_request_light_with_args(
+    session: Handle,
+    args: *mut [u32; 7],
+) -> ResultCode {
+    core::arch::naked_asm!(
+        "str x1, [sp, #-16]!",  // Store x1 (args pointer) on stack
+        "ldp w2, w3, [x1, #4]", // Load the message words 1-6 into w2-w7
+        "ldp w4, w5, [x1, #12]",
+        "ldp w6, w7, [x1, #20]",
+        "ldr w1, [x1]", // Load the message word 0 into w1, overwriting the pointer last
+        "svc {code}",   // Issue the SVC call with immediate value 0x20
+        "ldr x8, [sp], #16", // Load x8 (args pointer) from stack
+        "str w1, [x8]",      // Store the reply words from w1-w7 back to the message
+        "stp w2, w3, [x8, #4]",
+        "stp w4, w5, [x8, #12]",
+        "stp w6, w7, [x8, #20]",
+        "ret",
+        code = const SEND_SYNC_REQUEST_LIGHT,
+    );
+}
+
 /// Sends an IPC synchronization request to a session.
 ///
 /// `Result svcSendSyncRequest(Handle session);`
@@ -2390,6 +2429,48 @@ pub unsafe extern "C" fn reply_and_receive_light(handle: Handle) -> ResultCode {
     );
 }
 
+/// Performs light IPC input/output, passing the messages in registers.
+///
+/// If the reply flag (bit 31) of the first message word is set, the message is sent as the reply
+/// to the pending request, with the flag cleared. Then waits for the next request, and copies it
+/// into the message.
+///
+/// `Result svcReplyAndReceiveLight(Handle handle, u32 *args);`
+///
+/// Syscall code: [REPLY_AND_RECEIVE_LIGHT](crate::code::REPLY_AND_RECEIVE_LIGHT) (`0x42`).
+///
+/// | Arg | Name | Description |
+/// | --- | --- | --- |
+/// | IN | _handle_ | Light server session handle. |
+/// | IN/OUT | _args_ | Seven-word reply, loaded into `w1`-`w7` and overwritten with the next request. |
+///
+/// Ref: <https://switchbrew.org/wiki/SVC#ReplyAndReceiveLight>
+///
+/// # Safety
+///
+/// The caller must ensure that `handle` is a valid kernel session handle owned by the current
+/// process, and that `args` is valid for reads and writes of seven `u32`s.
+#[unsafe(naked)]
+pub unsafe extern "C" fn reply_and_receive_light_with_args(
+    handle: Handle,
+    args: *mut [u32; 7],
+) -> ResultCode {
+    core::arch::naked_asm!(
+        "str x1, [sp, #-16]!",  // Store x1 (args pointer) on stack
+        "ldp w2, w3, [x1, #4]", // Load the message words 1-6 into w2-w7
+        "ldp w4, w5, [x1, #12]",
+        "ldp w6, w7, [x1, #20]",
+        "ldr w1, [x1]", // Load the message word 0 into w1, overwriting the pointer last
+        "svc 0x42",     // Issue the SVC call with immediate value 0x42
+        "ldr x8, [sp], #16", // Load x8 (args pointer) from stack
+        "str w1, [x8]", // Store the request words from w1-w7 back to the message
+        "stp w2, w3, [x8, #4]",
+        "stp w4, w5, [x8, #12]",
+        "stp w6, w7, [x8, #20]",
+        "ret"
+    );
+}
+
 /// Performs IPC input/output.
 ///
 /// If ReplyTargetSessionHandle is not zero, a reply from the TLS will be sent to that session. Then
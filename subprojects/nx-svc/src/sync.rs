@@ -1,10 +1,12 @@
 //! Synchronization primitives
 
+pub use crate::handle::Waitable;
 use crate::{
     error::{KernelError as KError, ResultCode, ToRawResultCode},
-    handle::{Reset, Waitable},
-    raw::{self, Handle},
+    handle::Reset,
+    raw::{self, ArbitrationType, Handle, SignalType},
     result::{Error, Result, raw::Result as RawResult},
+    thread::Handle as ThreadHandle,
 };
 
 /// Bitmask for the _waiters bitflag_ in mutex raw tag values.
@@ -35,6 +37,15 @@ define_reset_handle_type! {
     pub struct EventHandle
 }
 
+define_handle_type! {
+    /// A handle to the writable end of a kernel event object (KWritableEvent).
+    ///
+    /// Returned by [`create_event`] alongside the readable [`EventHandle`], and used to
+    /// signal the event with [`signal_event`]. It can be sent to another process as a copy
+    /// handle, which can then wake up the threads waiting on the readable end.
+    pub struct WritableEventHandle
+}
+
 /// Arbitrates a mutex lock operation in userspace
 ///
 /// Attempts to acquire a mutex by arbitrating the lock with the owner thread.
@@ -296,6 +307,134 @@ pub unsafe fn signal_process_wide_key(condvar: *mut u32, count: i32) {
     unsafe { raw::signal_process_wide_key(condvar, count) };
 }
 
+/// Waits on a userspace address via the kernel address arbiter
+///
+/// Suspends the current thread until the address is signaled with [`signal_to_address`], the
+/// timeout expires or the comparison described by `arb_type` fails on entry.
+///
+/// # Arguments
+/// | Arg | Name | Description |
+/// | --- | --- | --- |
+/// | IN | _address_ | Pointer to the 32-bit arbitration value in userspace memory. |
+/// | IN | _arb_type_ | [`ArbitrationType`] describing the wait condition. |
+/// | IN | _value_ | Value compared against the memory at _address_. |
+/// | IN | _timeout_ns_ | Timeout in nanoseconds. Use -1 for infinite wait. |
+///
+/// # Notes
+/// - With [`ArbitrationType::WaitIfEqual`] the kernel returns [`WaitForAddressError::ValueMismatch`]
+///   without sleeping if the value at _address_ differs from _value_. Callers implementing
+///   futex-style waits should treat this as a spurious wake-up.
+///
+/// # Safety
+/// `address` must point to a 4-byte aligned, readable **and writable** `u32` in the current
+/// process' address space that stays valid for the entire wait.
+pub unsafe fn wait_for_address(
+    address: *const u32,
+    arb_type: ArbitrationType,
+    value: i32,
+    timeout_ns: i64,
+) -> Result<(), WaitForAddressError> {
+    let rc =
+        unsafe { raw::wait_for_address(address as *mut _, arb_type, value as i64, timeout_ns) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidState == desc => WaitForAddressError::ValueMismatch,
+        desc if KError::TimedOut == desc => WaitForAddressError::TimedOut,
+        desc if KError::TerminationRequested == desc => WaitForAddressError::ThreadTerminating,
+        desc if KError::InvalidAddress == desc => WaitForAddressError::InvalidMemState,
+        _ => WaitForAddressError::Unknown(Error::from(rc)),
+    })
+}
+
+/// Error type for [`wait_for_address`]
+#[derive(Debug, thiserror::Error)]
+pub enum WaitForAddressError {
+    /// The value at the address did not satisfy the wait condition.
+    #[error("Value mismatch")]
+    ValueMismatch,
+    /// The wait operation timed out.
+    #[error("Operation timed out")]
+    TimedOut,
+    /// The current thread is marked for termination.
+    #[error("Thread terminating")]
+    ThreadTerminating,
+    /// The memory address cannot be accessed.
+    #[error("Invalid memory state")]
+    InvalidMemState,
+    /// An unknown error occurred.
+    ///
+    /// This variant is used when the error code is not recognized.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for WaitForAddressError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            WaitForAddressError::ValueMismatch => KError::InvalidState.to_rc(),
+            WaitForAddressError::TimedOut => KError::TimedOut.to_rc(),
+            WaitForAddressError::ThreadTerminating => KError::TerminationRequested.to_rc(),
+            WaitForAddressError::InvalidMemState => KError::InvalidAddress.to_rc(),
+            WaitForAddressError::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Signals threads waiting on a userspace address via the kernel address arbiter
+///
+/// Wakes up to _count_ threads blocked in [`wait_for_address`] on _address_, optionally
+/// modifying the value at _address_ as described by `signal_type`.
+///
+/// # Arguments
+/// | Arg | Name | Description |
+/// | --- | --- | --- |
+/// | IN | _address_ | Pointer to the 32-bit arbitration value in userspace memory. |
+/// | IN | _signal_type_ | [`SignalType`] describing the signal operation. |
+/// | IN | _value_ | Value used by the conditional signal types. Ignored by [`SignalType::Signal`]. |
+/// | IN | _count_ | Number of threads to wake. If less than or equal to 0, wakes all waiting threads. |
+///
+/// # Safety
+/// `address` must point to a 4-byte aligned, readable **and writable** `u32` in the current
+/// process' address space.
+pub unsafe fn signal_to_address(
+    address: *const u32,
+    signal_type: SignalType,
+    value: i32,
+    count: i32,
+) -> Result<(), SignalToAddressError> {
+    let rc = unsafe { raw::signal_to_address(address as *mut _, signal_type, value, count) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidState == desc => SignalToAddressError::ValueMismatch,
+        desc if KError::InvalidAddress == desc => SignalToAddressError::InvalidMemState,
+        _ => SignalToAddressError::Unknown(Error::from(rc)),
+    })
+}
+
+/// Error type for [`signal_to_address`]
+#[derive(Debug, thiserror::Error)]
+pub enum SignalToAddressError {
+    /// The value at the address did not match for a conditional signal type.
+    #[error("Value mismatch")]
+    ValueMismatch,
+    /// The memory address cannot be accessed.
+    #[error("Invalid memory state")]
+    InvalidMemState,
+    /// An unknown error occurred.
+    ///
+    /// This variant is used when the error code is not recognized.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for SignalToAddressError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            SignalToAddressError::ValueMismatch => KError::InvalidState.to_rc(),
+            SignalToAddressError::InvalidMemState => KError::InvalidAddress.to_rc(),
+            SignalToAddressError::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
 /// Upper bound on how many synchronization objects the high-level public wrappers
 /// ([`wait_synchronization_multiple`] and [`wait_synchronization_single`]) will forward to the
 /// kernel.
@@ -425,7 +564,10 @@ where
 ///    duration of the syscall (it is read by the kernel while the thread is in user-space).
 ///
 /// Violating any of these requirements results in **undefined behaviour**.
-unsafe fn wait_synchronization(handles: &[Handle], timeout: u64) -> Result<usize, WaitSyncError> {
+pub unsafe fn wait_synchronization(
+    handles: &[Handle],
+    timeout: u64,
+) -> Result<usize, WaitSyncError> {
     let mut idx: i32 = -1;
 
     // SAFETY: The pointer passed to the kernel is valid for `handles.len()` * size_of::<Handle>()
@@ -501,6 +643,40 @@ impl ToRawResultCode for WaitSyncError {
     }
 }
 
+/// Cancels the current or next `svcWaitSynchronization` of `thread`.
+///
+/// If the thread is waiting, its wait returns [`WaitSyncError::Cancelled`]. Otherwise its
+/// next wait does, right away: a cancellation issued just before the thread starts waiting
+/// is not lost.
+pub fn cancel_synchronization(thread: &ThreadHandle) -> Result<(), CancelSyncError> {
+    // SAFETY: The kernel validates the handle and returns an error if invalid.
+    let rc = unsafe { raw::cancel_synchronization(thread.to_raw()) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidHandle == desc => CancelSyncError::InvalidHandle,
+        _ => CancelSyncError::Unknown(Error::from(rc)),
+    })
+}
+
+/// Error type returned by [`cancel_synchronization`].
+#[derive(Debug, thiserror::Error)]
+pub enum CancelSyncError {
+    /// The handle does not refer to a thread.
+    #[error("invalid handle")]
+    InvalidHandle,
+    /// An unknown error occurred.
+    #[error("unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for CancelSyncError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            CancelSyncError::InvalidHandle => KError::InvalidHandle.to_rc(),
+            CancelSyncError::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
 /// Resets a signaled synchronization object.
 ///
 /// This clears the signal state of an event, allowing subsequent waits
@@ -550,3 +726,85 @@ impl ToRawResultCode for ResetSignalError {
         }
     }
 }
+
+/// Creates a kernel event, returning its writable and readable ends.
+///
+/// The event is created in the non-signaled state. Signaling it with [`signal_event`] wakes
+/// up the threads waiting on the readable end, which stays signaled until reset with
+/// [`reset_signal`].
+pub fn create_event() -> Result<(WritableEventHandle, EventHandle), CreateEventError> {
+    let mut writable = raw::INVALID_HANDLE;
+    let mut readable = raw::INVALID_HANDLE;
+    // SAFETY: Both output pointers refer to valid stack locations.
+    let rc = unsafe { raw::create_event(&mut writable, &mut readable) };
+    RawResult::from_raw(rc).map(
+        (WritableEventHandle(writable), EventHandle(readable)),
+        |rc| match rc.description() {
+            desc if KError::OutOfResource == desc => CreateEventError::OutOfResource,
+            desc if KError::LimitReached == desc => CreateEventError::LimitReached,
+            desc if KError::OutOfHandles == desc => CreateEventError::OutOfHandles,
+            _ => CreateEventError::Unknown(Error::from(rc)),
+        },
+    )
+}
+
+/// Error type returned by [`create_event`].
+#[derive(Debug, thiserror::Error)]
+pub enum CreateEventError {
+    /// The kernel ran out of event objects.
+    #[error("out of resource")]
+    OutOfResource,
+    /// The process event resource limit was reached.
+    #[error("limit reached")]
+    LimitReached,
+    /// The process handle table is full.
+    #[error("out of handles")]
+    OutOfHandles,
+    /// An unknown error occurred.
+    #[error("unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for CreateEventError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            CreateEventError::OutOfResource => KError::OutOfResource.to_rc(),
+            CreateEventError::LimitReached => KError::LimitReached.to_rc(),
+            CreateEventError::OutOfHandles => KError::OutOfHandles.to_rc(),
+            CreateEventError::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Puts the event behind `handle` in the signaled state.
+///
+/// Wakes up the threads waiting on the readable end of the event, in this or any other
+/// process holding it.
+pub fn signal_event(handle: &WritableEventHandle) -> Result<(), SignalEventError> {
+    // SAFETY: The kernel validates the handle and returns an error if invalid.
+    let rc = unsafe { raw::signal_event(handle.0) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidHandle == desc => SignalEventError::InvalidHandle,
+        _ => SignalEventError::Unknown(Error::from(rc)),
+    })
+}
+
+/// Error type returned by [`signal_event`].
+#[derive(Debug, thiserror::Error)]
+pub enum SignalEventError {
+    /// The handle does not refer to a writable event.
+    #[error("invalid handle")]
+    InvalidHandle,
+    /// An unknown error occurred.
+    #[error("unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for SignalEventError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            SignalEventError::InvalidHandle => KError::InvalidHandle.to_rc(),
+            SignalEventError::Unknown(err) => err.to_raw(),
+        }
+    }
+}
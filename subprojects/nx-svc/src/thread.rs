@@ -9,7 +9,7 @@ use core::ffi::c_void;
 
 use crate::{
     error::{KernelError as KError, ToRawResultCode},
-    raw,
+    misc, raw,
     result::{Error, ResultCode, raw::Result as RawResult},
 };
 
@@ -356,6 +356,128 @@ pub fn get_current_processor_number() -> u32 {
     unsafe { raw::get_current_processor_number() }
 }
 
+/// Gets the priority of a thread.
+///
+/// Priorities are in the range `0..=0x3F`; lower values indicate higher priority.
+pub fn get_priority(handle: Handle) -> Result<i32, GetPriorityError> {
+    let mut priority = 0;
+    let rc = unsafe { raw::get_thread_priority(&mut priority, handle.to_raw()) };
+    RawResult::from_raw(rc).map(priority, |rc| match rc.description() {
+        desc if KError::InvalidHandle == desc => GetPriorityError::InvalidHandle,
+        _ => GetPriorityError::Unknown(rc.into()),
+    })
+}
+
+#[derive(Debug, thiserror::Error)]
+pub enum GetPriorityError {
+    /// The supplied handle is not a valid thread handle —
+    /// `KernelError::InvalidHandle` (raw code `0xE401`).
+    #[error("Invalid handle")]
+    InvalidHandle,
+    /// Any unforeseen kernel error. Contains the original [`Error`] so callers
+    /// can inspect the raw result (`Error::to_raw`).
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for GetPriorityError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::InvalidHandle => KError::InvalidHandle.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Sets the priority of a thread.
+///
+/// `priority` must be in the range `0..=0x3F` and allowed by the process's priority
+/// mask; lower values indicate higher priority.
+pub fn set_priority(handle: Handle, priority: u32) -> Result<(), SetPriorityError> {
+    let rc = unsafe { raw::set_thread_priority(handle.to_raw(), priority) };
+    RawResult::from_raw(rc).map((), |rc| match rc.description() {
+        desc if KError::InvalidHandle == desc => SetPriorityError::InvalidHandle,
+        desc if KError::InvalidPriority == desc => SetPriorityError::InvalidPriority,
+        _ => SetPriorityError::Unknown(rc.into()),
+    })
+}
+
+#[derive(Debug, thiserror::Error)]
+pub enum SetPriorityError {
+    /// The supplied handle is not a valid thread handle —
+    /// `KernelError::InvalidHandle` (raw code `0xE401`).
+    #[error("Invalid handle")]
+    InvalidHandle,
+    /// The priority is out of range or not allowed for the process —
+    /// `KernelError::InvalidPriority` (raw code `0xE001`).
+    #[error("Invalid priority")]
+    InvalidPriority,
+    /// Any unforeseen kernel error. Contains the original [`Error`] so callers
+    /// can inspect the raw result (`Error::to_raw`).
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for SetPriorityError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::InvalidHandle => KError::InvalidHandle.to_rc(),
+            Self::InvalidPriority => KError::InvalidPriority.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Gets the preferred core and the affinity mask of a thread.
+///
+/// Returns `(core_id, affinity_mask)`. A `core_id` of `-1` means the thread has no
+/// preferred core.
+pub fn get_core_mask(handle: Handle) -> Result<(i32, u64), GetCoreMaskError> {
+    let mut core_id = 0;
+    let mut affinity_mask = 0;
+    let rc =
+        unsafe { raw::get_thread_core_mask(&mut core_id, &mut affinity_mask, handle.to_raw()) };
+    RawResult::from_raw(rc).map((core_id, affinity_mask), |rc| match rc.description() {
+        desc if KError::InvalidHandle == desc => GetCoreMaskError::InvalidHandle,
+        _ => GetCoreMaskError::Unknown(rc.into()),
+    })
+}
+
+#[derive(Debug, thiserror::Error)]
+pub enum GetCoreMaskError {
+    /// The supplied handle is not a valid thread handle —
+    /// `KernelError::InvalidHandle` (raw code `0xE401`).
+    #[error("Invalid handle")]
+    InvalidHandle,
+    /// Any unforeseen kernel error. Contains the original [`Error`] so callers
+    /// can inspect the raw result (`Error::to_raw`).
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl ToRawResultCode for GetCoreMaskError {
+    fn to_rc(self) -> ResultCode {
+        match self {
+            Self::InvalidHandle => KError::InvalidHandle.to_rc(),
+            Self::Unknown(err) => err.to_raw(),
+        }
+    }
+}
+
+/// Gets the CPU time of a thread, in system ticks, across all cores.
+///
+/// This is a wrapper around [`misc::get_info`] for the [`InfoType::ThreadTickCount`] info
+/// type. The thread must belong to the current process.
+///
+/// [`InfoType::ThreadTickCount`]: misc::InfoType::ThreadTickCount
+pub fn get_cpu_ticks(handle: Handle) -> Result<u64, misc::GetInfoError> {
+    // A core of -1 sums the ticks of every core
+    misc::get_info(
+        misc::InfoType::ThreadTickCount { core: u64::MAX },
+        handle.to_raw(),
+    )
+}
+
 /// Sets the CPU core affinity for a thread.
 ///
 /// This function configures which CPU cores the specified thread is allowed
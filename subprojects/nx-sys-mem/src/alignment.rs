@@ -6,6 +6,15 @@ pub const PAGE_SIZE: usize = 0x1000;
 /// Page mask for alignment operations.
 const PAGE_MASK: usize = PAGE_SIZE - 1;
 
+/// Large page (level 2 translation block) size constant (2 MiB).
+///
+/// The kernel maps physically contiguous memory with large page blocks when the virtual
+/// range is aligned to, and a multiple of, this size.
+pub const LARGE_PAGE_SIZE: usize = 0x200000;
+
+/// Large page mask for alignment operations.
+const LARGE_PAGE_MASK: usize = LARGE_PAGE_SIZE - 1;
+
 /// Checks if a size is page-aligned.
 ///
 /// A size is considered page-aligned if it's a multiple of [`PAGE_SIZE`] (0x1000).
@@ -45,3 +54,24 @@ pub const fn pages_needed(size: usize) -> usize {
         (size + PAGE_MASK) / PAGE_SIZE
     }
 }
+
+/// Checks if a size is large page-aligned.
+///
+/// A size is considered large page-aligned if it's a multiple of [`LARGE_PAGE_SIZE`]
+/// (0x200000).
+#[inline]
+pub const fn is_large_page_aligned(size: usize) -> bool {
+    size & LARGE_PAGE_MASK == 0
+}
+
+/// Rounds up a size to the next large page boundary.
+///
+/// If the size is already large page-aligned, it returns the same value.
+#[inline]
+pub const fn round_up_to_large_page(size: usize) -> usize {
+    if size == 0 {
+        0
+    } else {
+        (size + LARGE_PAGE_MASK) & !LARGE_PAGE_MASK
+    }
+}
@@ -10,10 +10,13 @@
 //! - [`Buf`] trait: A common interface for memory buffer implementations
 //! - [`Buffer`]: An owned buffer with custom layout support
 //! - [`BufferRef`]: A non-owning reference to externally managed memory
+//! - [`LargePageBuffer`]: An owned buffer laid out to be backed by 2 MiB large pages
 
 use alloc::alloc::{Layout, alloc_zeroed, dealloc};
 use core::{ffi::c_void, marker::PhantomData, mem::align_of, ptr::NonNull};
 
+use crate::alignment::{LARGE_PAGE_SIZE, round_up_to_large_page};
+
 /// Trait for memory buffer implementations.
 ///
 /// This trait provides a common interface for different types of memory buffers,
@@ -263,3 +266,86 @@ impl<'a> Buf for BufferRef<'a> {
         self.layout
     }
 }
+
+/// Buffer for memory that the kernel can back with 2 MiB large pages.
+///
+/// The heap is backed by physically contiguous memory, which the kernel maps with large
+/// page blocks wherever the virtual range is block-aligned. `LargePageBuffer` carves its
+/// memory out of the heap in whole [`LARGE_PAGE_SIZE`] blocks, aligned to a block
+/// boundary, so every block of the buffer needs a single TLB entry instead of 512.
+///
+/// # Memory Characteristics
+///
+/// - **Alignment**: Aligned to large page boundaries (2 MiB)
+/// - **Size**: Rounded up to a multiple of the large page size
+/// - **Initialization**: Memory is zero-initialized upon allocation
+/// - **Ownership**: The buffer owns the memory and deallocates it on drop
+///
+/// # Use Cases
+///
+/// This buffer type is useful for large, long-lived, randomly accessed memory:
+/// - GPU command buffers
+/// - Asset pools
+#[derive(Debug)]
+pub struct LargePageBuffer(Buffer);
+
+impl LargePageBuffer {
+    /// Allocate a new buffer of at least `size` bytes, rounded up to a multiple of
+    /// [`LARGE_PAGE_SIZE`].
+    ///
+    /// Returns `Ok(LargePageBuffer)` on success, or a [`LargePageBufError`] if:
+    /// - The size is zero ([`LargePageBufError::InvalidSize`])
+    /// - Memory allocation fails ([`LargePageBufError::AllocationFailed`])
+    pub fn alloc(size: usize) -> Result<Self, LargePageBufError> {
+        // Size must be non-zero, and not overflow once rounded up
+        if size == 0 || size > isize::MAX as usize - LARGE_PAGE_SIZE {
+            return Err(LargePageBufError::InvalidSize);
+        }
+
+        let size = round_up_to_large_page(size);
+        let layout = Layout::from_size_align(size, LARGE_PAGE_SIZE)
+            .map_err(|_| LargePageBufError::InvalidSize)?;
+        let inner =
+            Buffer::try_with_layout(layout).map_err(|_| LargePageBufError::AllocationFailed)?;
+
+        Ok(Self(inner))
+    }
+}
+
+impl Buf for LargePageBuffer {
+    fn ptr(&self) -> NonNull<c_void> {
+        self.0.ptr()
+    }
+
+    fn layout(&self) -> Layout {
+        self.0.layout()
+    }
+}
+
+/// Implementation of [`Buf`] for references to [`LargePageBuffer`].
+///
+/// This allows borrowed references to be used wherever the [`Buf`] trait
+/// is required.
+impl Buf for &LargePageBuffer {
+    fn ptr(&self) -> NonNull<c_void> {
+        self.0.ptr()
+    }
+
+    fn layout(&self) -> Layout {
+        self.0.layout()
+    }
+}
+
+/// Errors that can occur during allocation of a large page buffer.
+#[derive(Debug, thiserror::Error)]
+pub enum LargePageBufError {
+    /// Size must be non-zero and fit in the address space once rounded up.
+    #[error("Invalid buffer size")]
+    InvalidSize,
+
+    /// Memory allocation failed.
+    ///
+    /// The heap has no free, block-aligned range of the requested size.
+    #[error("Memory allocation failed")]
+    AllocationFailed,
+}
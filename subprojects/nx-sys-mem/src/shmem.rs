@@ -3,6 +3,7 @@
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+pub mod ring;
 mod sys;
 
 pub use sys::*;
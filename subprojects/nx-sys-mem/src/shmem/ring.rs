@@ -0,0 +1,629 @@
+//! Lock-free ring buffer transport over shared memory
+//!
+//! A [`Producer`] and a [`Consumer`], usually living in different processes, exchange
+//! length-prefixed records through a shared memory block, without a `svcSendSyncRequest`
+//! per message. The producer writes each record in place and publishes it by advancing the
+//! ring head; the consumer reads it in place and frees it by advancing the ring tail.
+//!
+//! The kernel is only involved when the consumer runs out of records: it then parks on a
+//! kernel event, which the producer signals on its next commit. Address arbitration
+//! (`svcSignalToAddress`) cannot be used for this, as its waiters are keyed per process.
+//!
+//! The ring has a single producer. Producer threads of the same process can share it behind
+//! a mutex; producers in different processes need a ring each.
+//!
+//! ```ignore
+//! // Producer process, owning the shared memory and the event
+//! let (writable, readable) = nx_svc::sync::create_event()?;
+//! let mut tx = unsafe { ring::Producer::new(&shm, writable) }?;
+//! tx.push(b"sample")?;
+//!
+//! // Consumer process, once given the shared memory and `readable` handles
+//! let mut rx = unsafe { ring::Consumer::attach(&shm, readable) }?;
+//! let record = rx.pop(u64::MAX)?;
+//! ```
+
+use core::{
+    ffi::c_void,
+    marker::PhantomData,
+    ops::{Deref, DerefMut},
+    ptr::{self, NonNull},
+    slice,
+    sync::atomic::{self, AtomicU32, Ordering},
+};
+
+use nx_svc::sync::{
+    self as svc, EventHandle, SignalEventError, WaitSyncError, WritableEventHandle,
+};
+
+use super::{Mapped, SharedMemory};
+
+/// Magic number of an initialized ring header (`"RING"`).
+const RING_MAGIC: u32 = u32::from_le_bytes(*b"RING");
+
+/// Alignment of the records in the data area.
+const RECORD_ALIGN: u32 = 8;
+
+/// Size of the length prefix of a record.
+const RECORD_HEADER_SIZE: u32 = 4;
+
+/// Length prefix telling the rest of the data area is skipped, and the next record is at
+/// its start.
+const WRAP_MARKER: u32 = u32::MAX;
+
+/// Smallest supported data area size.
+const MIN_CAPACITY: usize = 64;
+
+/// Largest supported data area size, keeping the free-running indices unambiguous.
+const MAX_CAPACITY: usize = 1 << 31;
+
+/// Size of the ring header, at the start of the shared memory block.
+pub const HEADER_SIZE: usize = size_of::<Header>();
+
+/// Ring header, shared by both ends.
+///
+/// The producer and consumer indices live on separate cache lines, so in the common case
+/// each end only writes to its own line.
+#[repr(C)]
+struct Header {
+    meta: CacheLine<Meta>,
+    /// Free-running write index, only written by the producer.
+    head: CacheLine<AtomicU32>,
+    consumer: CacheLine<ConsumerState>,
+}
+
+#[repr(C, align(64))]
+struct CacheLine<T>(T);
+
+#[repr(C)]
+struct Meta {
+    magic: AtomicU32,
+    /// Size of the data area, a power of two.
+    capacity: AtomicU32,
+}
+
+#[repr(C)]
+struct ConsumerState {
+    /// Free-running read index, only written by the consumer.
+    tail: AtomicU32,
+    /// Non-zero while the consumer is parked, or about to park, on the wakeup event.
+    parked: AtomicU32,
+}
+
+/// The validated layout of a ring in memory.
+struct Ring {
+    header: NonNull<Header>,
+    data: NonNull<u8>,
+    capacity: u32,
+}
+
+impl Ring {
+    /// Returns the ring laid out in the `size` bytes at `mem`, and its data area size.
+    fn layout(mem: NonNull<c_void>, size: usize) -> Option<(NonNull<Header>, NonNull<u8>, u32)> {
+        let data_size = size.checked_sub(HEADER_SIZE)?.min(MAX_CAPACITY);
+        if data_size < MIN_CAPACITY {
+            return None;
+        }
+
+        // Largest power of two fitting in the block
+        let capacity = 1 << (usize::BITS - 1 - data_size.leading_zeros());
+        // SAFETY: The data area starts right after the header, within the block.
+        let data = unsafe { mem.cast::<u8>().add(HEADER_SIZE) };
+        Some((mem.cast(), data, capacity as u32))
+    }
+
+    fn header(&self) -> &Header {
+        // SAFETY: The header stays mapped for the lifetime of the ring ends, and is only
+        // accessed through atomics.
+        unsafe { self.header.as_ref() }
+    }
+
+    fn head(&self) -> &AtomicU32 {
+        &self.header().head.0
+    }
+
+    fn tail(&self) -> &AtomicU32 {
+        &self.header().consumer.0.tail
+    }
+
+    fn parked(&self) -> &AtomicU32 {
+        &self.header().consumer.0.parked
+    }
+
+    /// Largest record payload the ring accepts.
+    ///
+    /// Capping records to half the data area guarantees they fit in an empty ring, however
+    /// the free space is split around the wrap point.
+    fn max_len(&self) -> u32 {
+        self.capacity / 2 - RECORD_HEADER_SIZE
+    }
+
+    /// Data area offset of the free-running `index`.
+    fn offset(&self, index: u32) -> u32 {
+        index & (self.capacity - 1)
+    }
+
+    /// Pointer to the data area at `offset`.
+    fn at(&self, offset: u32) -> *mut u8 {
+        // SAFETY: Offsets are always masked to the data area.
+        unsafe { self.data.as_ptr().add(offset as usize) }
+    }
+}
+
+/// Size of the record holding a `len` bytes payload, prefix and padding included.
+fn record_size(len: u32) -> u32 {
+    (RECORD_HEADER_SIZE + len).next_multiple_of(RECORD_ALIGN)
+}
+
+/// The writing end of a ring.
+pub struct Producer<'a> {
+    ring: Ring,
+    event: WritableEventHandle,
+    /// Local copy of the ring head.
+    head: u32,
+    /// Last tail read from the ring, refreshed only when the ring looks full.
+    tail: u32,
+    _mem: PhantomData<&'a SharedMemory<Mapped>>,
+}
+
+// SAFETY: The ring memory is only accessed through atomics and the records owned by the
+// producer, which are valid from any thread.
+unsafe impl Send for Producer<'_> {}
+
+impl<'a> Producer<'a> {
+    /// Initializes an empty ring in `shm`, and returns its producer end.
+    ///
+    /// `event` is the writable end of the event the consumer parks on.
+    ///
+    /// # Safety
+    ///
+    /// `shm` must not be used for anything else than this ring, and the ring must not have
+    /// another producer.
+    pub unsafe fn new(
+        shm: &'a SharedMemory<Mapped>,
+        event: WritableEventHandle,
+    ) -> Result<Self, InitError> {
+        let addr = shm.addr().expect("mapped shared memory has an address");
+        // SAFETY: The mapping outlives the producer, and the caller grants its ownership.
+        unsafe { Self::from_raw_parts(NonNull::new_unchecked(addr), shm.size(), event) }
+    }
+
+    /// Initializes an empty ring in the `size` bytes at `mem`, and returns its producer end.
+    ///
+    /// # Safety
+    ///
+    /// `mem` must point to `size` bytes of readable and writable memory, living for `'a` and
+    /// not used for anything else than this ring. The ring must not have another producer.
+    pub unsafe fn from_raw_parts(
+        mem: NonNull<c_void>,
+        size: usize,
+        event: WritableEventHandle,
+    ) -> Result<Self, InitError> {
+        if !mem.cast::<Header>().is_aligned() {
+            return Err(InitError::Misaligned);
+        }
+        let (header, data, capacity) = Ring::layout(mem, size).ok_or(InitError::TooSmall)?;
+
+        // SAFETY: The caller guarantees the header memory is valid and owned by the ring.
+        unsafe {
+            header.write(Header {
+                meta: CacheLine(Meta {
+                    magic: AtomicU32::new(0),
+                    capacity: AtomicU32::new(capacity),
+                }),
+                head: CacheLine(AtomicU32::new(0)),
+                consumer: CacheLine(ConsumerState {
+                    tail: AtomicU32::new(0),
+                    parked: AtomicU32::new(0),
+                }),
+            })
+        };
+
+        let ring = Ring {
+            header,
+            data,
+            capacity,
+        };
+        // Publish the header to the consumer attaching to it
+        ring.header()
+            .meta
+            .0
+            .magic
+            .store(RING_MAGIC, Ordering::Release);
+
+        Ok(Self {
+            ring,
+            event,
+            head: 0,
+            tail: 0,
+            _mem: PhantomData,
+        })
+    }
+
+    /// Largest record payload the ring accepts.
+    pub fn max_len(&self) -> usize {
+        self.ring.max_len() as usize
+    }
+
+    /// Reserves room for a record of `len` bytes, to be filled in place.
+    ///
+    /// The record is published by [`WriteGrant::commit`]; dropping the grant abandons it.
+    pub fn reserve(&mut self, len: usize) -> Result<WriteGrant<'_, 'a>, PushError> {
+        if len > self.max_len() {
+            return Err(PushError::TooLarge);
+        }
+
+        let size = record_size(len as u32);
+        let contiguous = self.ring.capacity - self.ring.offset(self.head);
+        let skip = if contiguous < size { contiguous } else { 0 };
+
+        if self.free() < skip + size {
+            self.tail = self.ring.tail().load(Ordering::Acquire);
+            if self.free() < skip + size {
+                return Err(PushError::Full);
+            }
+        }
+
+        Ok(WriteGrant {
+            producer: self,
+            len: len as u32,
+            skip,
+        })
+    }
+
+    /// Copies `data` into a new record, and publishes it.
+    ///
+    /// On [`PushError::Wake`], the record is already published: pushing it again would
+    /// duplicate it.
+    pub fn push(&mut self, data: &[u8]) -> Result<(), PushError> {
+        let mut grant = self.reserve(data.len())?;
+        grant.copy_from_slice(data);
+        grant.commit()?;
+        Ok(())
+    }
+
+    /// Free bytes in the data area, as of the last tail read.
+    fn free(&self) -> u32 {
+        // A consumer moving its tail past the head leaves no room rather than wrapping
+        let used = self.head.wrapping_sub(self.tail);
+        self.ring.capacity.saturating_sub(used)
+    }
+
+    /// Signals the event if the consumer is parked.
+    fn wake(&self) -> Result<(), SignalEventError> {
+        // Order the head store before the parked flag load, pairing with the consumer
+        // storing the flag before checking the head again
+        atomic::fence(Ordering::SeqCst);
+
+        let parked = self.ring.parked();
+        if parked.load(Ordering::Relaxed) != 0 && parked.swap(0, Ordering::Relaxed) != 0 {
+            svc::signal_event(&self.event)?;
+        }
+        Ok(())
+    }
+}
+
+/// A record reserved by [`Producer::reserve`], dereferencing to its payload.
+pub struct WriteGrant<'p, 'a> {
+    producer: &'p mut Producer<'a>,
+    len: u32,
+    /// Bytes skipped at the end of the data area for the record to be contiguous.
+    skip: u32,
+}
+
+impl WriteGrant<'_, '_> {
+    /// Publishes the record, waking up the consumer if it is parked.
+    ///
+    /// The record is published even if waking up the consumer fails.
+    pub fn commit(self) -> Result<(), SignalEventError> {
+        let producer = self.producer;
+        let ring = &producer.ring;
+
+        let mut offset = ring.offset(producer.head);
+        if self.skip > 0 {
+            // SAFETY: The skipped bytes are free, and the offset is record aligned.
+            unsafe { ring.at(offset).cast::<u32>().write(WRAP_MARKER) };
+            offset = 0;
+        }
+        // SAFETY: The record bytes are free, and the offset is record aligned.
+        unsafe { ring.at(offset).cast::<u32>().write(self.len) };
+
+        producer.head = producer
+            .head
+            .wrapping_add(self.skip + record_size(self.len));
+        ring.head().store(producer.head, Ordering::Release);
+
+        producer.wake()
+    }
+
+    fn payload(&self) -> *mut u8 {
+        let ring = &self.producer.ring;
+        let offset = if self.skip > 0 {
+            0
+        } else {
+            ring.offset(self.producer.head)
+        };
+        ring.at(offset + RECORD_HEADER_SIZE)
+    }
+}
+
+impl Deref for WriteGrant<'_, '_> {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        // SAFETY: The payload bytes are reserved, and not visible to the consumer yet.
+        unsafe { slice::from_raw_parts(self.payload(), self.len as usize) }
+    }
+}
+
+impl DerefMut for WriteGrant<'_, '_> {
+    fn deref_mut(&mut self) -> &mut [u8] {
+        // SAFETY: The payload bytes are reserved, and not visible to the consumer yet.
+        unsafe { slice::from_raw_parts_mut(self.payload(), self.len as usize) }
+    }
+}
+
+/// The reading end of a ring.
+///
+/// The producer is not trusted: record prefixes are read once and bounds checked, and a
+/// ring found inconsistent is reported as [`PopError::Corrupted`].
+pub struct Consumer<'a> {
+    ring: Ring,
+    event: EventHandle,
+    /// Local copy of the ring tail.
+    tail: u32,
+    /// Last head read from the ring, refreshed only when the ring looks empty.
+    head: u32,
+    _mem: PhantomData<&'a SharedMemory<Mapped>>,
+}
+
+// SAFETY: The ring memory is only accessed through atomics and the records owned by the
+// consumer, which are valid from any thread.
+unsafe impl Send for Consumer<'_> {}
+
+impl<'a> Consumer<'a> {
+    /// Attaches to the ring initialized in `shm` by its producer.
+    ///
+    /// `event` is the readable end of the event the producer signals.
+    ///
+    /// # Safety
+    ///
+    /// `shm` must only be used for this ring, and the ring must not have another consumer.
+    /// `event` must stay open for the lifetime of the consumer.
+    pub unsafe fn attach(
+        shm: &'a SharedMemory<Mapped>,
+        event: EventHandle,
+    ) -> Result<Self, AttachError> {
+        let addr = shm.addr().expect("mapped shared memory has an address");
+        // SAFETY: The mapping outlives the consumer, and the caller grants its ownership.
+        unsafe { Self::from_raw_parts(NonNull::new_unchecked(addr), shm.size(), event) }
+    }
+
+    /// Attaches to the ring initialized in the `size` bytes at `mem` by its producer.
+    ///
+    /// # Safety
+    ///
+    /// `mem` must point to `size` bytes of readable and writable memory, living for `'a` and
+    /// only used for this ring. The ring must not have another consumer, and `event` must
+    /// stay open for the lifetime of the consumer.
+    pub unsafe fn from_raw_parts(
+        mem: NonNull<c_void>,
+        size: usize,
+        event: EventHandle,
+    ) -> Result<Self, AttachError> {
+        if !mem.cast::<Header>().is_aligned() {
+            return Err(AttachError::Misaligned);
+        }
+        let (header, data, max_capacity) =
+            Ring::layout(mem, size).ok_or(AttachError::InvalidHeader)?;
+
+        // SAFETY: The caller guarantees the header memory is valid, and it is only
+        // accessed through atomics.
+        let meta = unsafe { &header.as_ref().meta.0 };
+        if meta.magic.load(Ordering::Acquire) != RING_MAGIC {
+            return Err(AttachError::NotInitialized);
+        }
+
+        let capacity = meta.capacity.load(Ordering::Relaxed);
+        if !capacity.is_power_of_two()
+            || (capacity as usize) < MIN_CAPACITY
+            || capacity > max_capacity
+        {
+            return Err(AttachError::InvalidHeader);
+        }
+
+        let ring = Ring {
+            header,
+            data,
+            capacity,
+        };
+        let tail = ring.tail().load(Ordering::Relaxed);
+        Ok(Self {
+            ring,
+            event,
+            tail,
+            head: tail,
+            _mem: PhantomData,
+        })
+    }
+
+    /// Returns the next record, if any.
+    ///
+    /// The record is freed when the returned grant is dropped.
+    pub fn try_pop(&mut self) -> Result<Option<ReadGrant<'_, 'a>>, PopError> {
+        Ok(self.next_record()?.map(|record| ReadGrant {
+            consumer: self,
+            record,
+        }))
+    }
+
+    /// Returns the next record, parking on the event until the producer commits one.
+    ///
+    /// Returns [`PopError::TimedOut`] if no record is committed for `timeout` nanoseconds.
+    pub fn pop(&mut self, timeout: u64) -> Result<ReadGrant<'_, 'a>, PopError> {
+        loop {
+            if let Some(record) = self.next_record()? {
+                return Ok(ReadGrant {
+                    consumer: self,
+                    record,
+                });
+            }
+            self.park(timeout)?;
+        }
+    }
+
+    /// Locates the record at the tail, skipping the wrap marker if any.
+    fn next_record(&mut self) -> Result<Option<Record>, PopError> {
+        loop {
+            if self.head == self.tail {
+                self.head = self.ring.head().load(Ordering::Acquire);
+                if self.head == self.tail {
+                    return Ok(None);
+                }
+            }
+
+            let available = self.head.wrapping_sub(self.tail);
+            if available > self.ring.capacity || available % RECORD_ALIGN != 0 {
+                return Err(PopError::Corrupted);
+            }
+
+            let offset = self.ring.offset(self.tail);
+            // SAFETY: The prefix lies below the head, and the offset is record aligned.
+            let len = unsafe { ptr::read_volatile(self.ring.at(offset).cast::<u32>()) };
+            let contiguous = self.ring.capacity - offset;
+
+            if len == WRAP_MARKER {
+                if contiguous > available {
+                    return Err(PopError::Corrupted);
+                }
+                self.advance(contiguous);
+                continue;
+            }
+
+            if len > self.ring.max_len() {
+                return Err(PopError::Corrupted);
+            }
+            let size = record_size(len);
+            if size > available || size > contiguous {
+                return Err(PopError::Corrupted);
+            }
+
+            return Ok(Some(Record {
+                offset: offset + RECORD_HEADER_SIZE,
+                len,
+                size,
+            }));
+        }
+    }
+
+    /// Frees `size` bytes at the tail.
+    fn advance(&mut self, size: u32) {
+        self.tail = self.tail.wrapping_add(size);
+        self.ring.tail().store(self.tail, Ordering::Release);
+    }
+
+    /// Parks on the event until the producer commits a record.
+    fn park(&mut self, timeout: u64) -> Result<(), PopError> {
+        let parked = self.ring.parked();
+        parked.store(1, Ordering::Relaxed);
+        // Order the parked flag store before the head load, pairing with the producer
+        // storing the head before checking the flag
+        atomic::fence(Ordering::SeqCst);
+
+        if self.ring.head().load(Ordering::Relaxed) != self.tail {
+            parked.store(0, Ordering::Relaxed);
+            return Ok(());
+        }
+
+        // SAFETY: The caller of `attach` keeps the event open for the consumer lifetime.
+        let res = unsafe { svc::wait_synchronization_single(&self.event, timeout) };
+        parked.store(0, Ordering::Relaxed);
+
+        match res {
+            Ok(()) => {
+                // The head is checked again after the reset, so no commit is missed.
+                // SAFETY: The event is a readable event handle.
+                let _ = unsafe { svc::reset_signal(&self.event) };
+                Ok(())
+            }
+            Err(WaitSyncError::TimedOut) => Err(PopError::TimedOut),
+            Err(err) => Err(PopError::Wait(err)),
+        }
+    }
+}
+
+/// Location of a record payload in the data area.
+struct Record {
+    offset: u32,
+    len: u32,
+    /// Record size, prefix and padding included.
+    size: u32,
+}
+
+/// A record returned by [`Consumer::pop`], dereferencing to its payload.
+///
+/// The record is freed when the grant is dropped.
+pub struct ReadGrant<'c, 'a> {
+    consumer: &'c mut Consumer<'a>,
+    record: Record,
+}
+
+impl Deref for ReadGrant<'_, '_> {
+    type Target = [u8];
+
+    fn deref(&self) -> &[u8] {
+        let payload = self.consumer.ring.at(self.record.offset);
+        // SAFETY: The payload was bounds checked, and is not reused by the producer until
+        // the grant is dropped.
+        unsafe { slice::from_raw_parts(payload, self.record.len as usize) }
+    }
+}
+
+impl Drop for ReadGrant<'_, '_> {
+    fn drop(&mut self) {
+        self.consumer.advance(self.record.size);
+    }
+}
+
+/// Error returned by [`Producer::new`].
+#[derive(Debug, thiserror::Error)]
+pub enum InitError {
+    #[error("ring memory is not cache line aligned")]
+    Misaligned,
+    #[error("ring memory is too small")]
+    TooSmall,
+}
+
+/// Error returned by [`Consumer::attach`].
+#[derive(Debug, thiserror::Error)]
+pub enum AttachError {
+    #[error("ring memory is not cache line aligned")]
+    Misaligned,
+    #[error("ring is not initialized")]
+    NotInitialized,
+    #[error("invalid ring header")]
+    InvalidHeader,
+}
+
+/// Error returned by [`Producer::reserve`] and [`Producer::push`].
+#[derive(Debug, thiserror::Error)]
+pub enum PushError {
+    #[error("record is larger than the ring accepts")]
+    TooLarge,
+    #[error("ring is full")]
+    Full,
+    /// The record was published, but waking up the consumer failed.
+    #[error("record published, but failed to wake up the consumer: {0}")]
+    Wake(#[from] SignalEventError),
+}
+
+/// Error returned by [`Consumer::pop`] and [`Consumer::try_pop`].
+#[derive(Debug, thiserror::Error)]
+pub enum PopError {
+    #[error("timed out waiting for a record")]
+    TimedOut,
+    #[error("ring is corrupted")]
+    Corrupted,
+    #[error("failed to wait for a record: {0}")]
+    Wait(WaitSyncError),
+}
@@ -139,6 +139,61 @@ pub unsafe fn map(shm: SharedMemory<Unmapped>) -> Result<SharedMemory<Mapped>, M
     }))
 }
 
+/// Map several [`SharedMemory`] instances into the current process at once.
+///
+/// The address space for all of them is found with a single VMM lock acquisition and
+/// address space scan, and the lock is held until they are all mapped. On failure, the
+/// instances already mapped are unmapped again and all of them are handed back in the
+/// error.
+///
+/// # Safety
+///
+/// This function is unsafe because it interacts with the kernel directly,
+/// which is inherently unsafe.
+pub unsafe fn map_batch<const N: usize>(
+    shms: [SharedMemory<Unmapped>; N],
+) -> Result<[SharedMemory<Mapped>; N], MapBatchError<N>> {
+    let mut vmm = vmm::lock();
+
+    // Ask the VMM for free slices of ASLR address-space for all the objects.
+    let requests = shms.each_ref().map(|shm| vmm::RangeRequest {
+        size: shm.0.size,
+        guard_size: GUARD_SIZE,
+    });
+    let Some(addrs) = vmm.find_aslr_batch(requests) else {
+        return Err(MapBatchError {
+            reason: MapError::VirtAddressAllocFailed,
+            shms,
+        });
+    };
+
+    // Attempt to map each shared memory into its slice.
+    for (i, (shm, &addr)) in shms.iter().zip(&addrs).enumerate() {
+        let Unmapped { handle, size, perm } = shm.0;
+        if let Err(err) = svc::map_shared_memory(handle, addr, size, perm) {
+            for (shm, &addr) in shms[..i].iter().zip(&addrs) {
+                let _ = svc::unmap_shared_memory(shm.0.handle, addr, shm.0.size);
+            }
+            return Err(MapBatchError {
+                reason: MapError::Svc(err),
+                shms,
+            });
+        }
+    }
+    drop(vmm);
+
+    let mut addrs = addrs.into_iter();
+    Ok(shms.map(|SharedMemory(Unmapped { handle, size, perm })| {
+        SharedMemory(Mapped {
+            handle,
+            size,
+            perm,
+            // `addrs` holds one address per shared memory object
+            mapped_mem_ptr: addrs.next().unwrap(),
+        })
+    }))
+}
+
 /// Unmap the shared-memory object from the current process.
 ///
 /// # Safety
@@ -210,6 +265,20 @@ pub enum MapError {
     Svc(#[from] svc::MapSharedMemoryError),
 }
 
+/// Error that occurs when mapping a batch of shared memory objects fails.
+///
+/// None of the shared memory objects is left mapped: they are all returned in the
+/// [`Unmapped`] state so that the caller can retry or close them.
+#[derive(Debug, thiserror::Error)]
+#[error("Shared memory batch map failed: {reason}")]
+pub struct MapBatchError<const N: usize> {
+    /// The error that stopped the batch.
+    #[source]
+    pub reason: MapError,
+    /// The shared memory objects of the batch.
+    pub shms: [SharedMemory<Unmapped>; N],
+}
+
 /// Error that occurs when unmapping shared memory fails.
 ///
 /// This error contains both the underlying kernel error and the shared memory
@@ -398,7 +467,6 @@ impl SharedMemory<Unmapped> {
     }
 }
 
-#[cfg(feature = "ffi")]
 impl<S> SharedMemory<S>
 where
     S: ShmState + core::fmt::Debug,
@@ -3,6 +3,8 @@
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+mod pool;
 mod sys;
 
+pub use pool::*;
 pub use sys::*;
@@ -0,0 +1,177 @@
+//! Recycling pool of transfer-memory objects
+//!
+//! Handing a large buffer to a service through transfer memory allocates the backing
+//! memory, creates the kernel object and closes it afterwards, on every call. A
+//! [`TransferMemoryPool`] keeps the objects of finished calls alive instead, so the next
+//! call of the same size class and permission leases one without allocating or issuing
+//! any SVC.
+//!
+//! ```ignore
+//! static POOL: TransferMemoryPool = TransferMemoryPool::new(4);
+//!
+//! let tmem = POOL.lease(0x60000, Permissions::empty())?;
+//! service.upload(tmem.handle(), tmem.size())?;
+//! // The lease goes back to the pool once the service is done with it
+//! drop(tmem);
+//! ```
+//!
+//! The backing memory of a recycled object keeps the contents the previous user left.
+
+use alloc::vec::Vec;
+use core::ops::Deref;
+
+use nx_std_sync::mutex::Mutex;
+
+use super::sys::{self, CreateError, Permissions, TransferMemory, Unmapped};
+
+/// Smallest size class, in bytes (64 KiB).
+pub const MIN_SIZE_CLASS: usize = 0x10000;
+
+/// Pool of idle transfer-memory objects, keyed by size class and permission.
+///
+/// Sizes are rounded up to a power of two of at least [`MIN_SIZE_CLASS`], so that
+/// requests of slightly different sizes share objects.
+pub struct TransferMemoryPool {
+    idle: Mutex<Vec<TransferMemory<Unmapped>>>,
+    max_idle: usize,
+}
+
+impl TransferMemoryPool {
+    /// Creates an empty pool keeping up to `max_idle` idle objects.
+    pub const fn new(max_idle: usize) -> Self {
+        Self {
+            idle: Mutex::new(Vec::new()),
+            max_idle,
+        }
+    }
+
+    /// Leases a transfer-memory object of at least `size` bytes with `perm` as the
+    /// permission left to the current process on the backing memory.
+    ///
+    /// An idle object of the same size class and permission is reused if there is one;
+    /// otherwise a new one is created.
+    pub fn lease(&self, size: usize, perm: Permissions) -> Result<Lease<'_>, CreateError> {
+        let size = size_class(size);
+
+        let reused = {
+            let mut idle = self.idle.lock();
+            idle.iter()
+                .position(|tm| tm.size() == size && tm.perm() == perm)
+                .map(|index| idle.swap_remove(index))
+        };
+
+        let tm = match reused {
+            Some(tm) => tm,
+            // SAFETY: The object is owned by the lease until it goes back to the pool.
+            None => unsafe { sys::create(size, perm)? },
+        };
+
+        Ok(Lease {
+            pool: self,
+            tm: Some(tm),
+        })
+    }
+
+    /// Creates idle objects of the size class of `size` with `perm` ahead of time, up
+    /// to `count` of them or until the pool is full.
+    pub fn prefill(&self, size: usize, perm: Permissions, count: usize) -> Result<(), CreateError> {
+        let size = size_class(size);
+        for _ in 0..count {
+            if self.idle.lock().len() >= self.max_idle {
+                break;
+            }
+            // SAFETY: The object is owned by the pool.
+            let tm = unsafe { sys::create(size, perm)? };
+            self.give_back(tm);
+        }
+        Ok(())
+    }
+
+    /// Closes all the idle objects, freeing their backing memory.
+    pub fn trim(&self) {
+        let idle = core::mem::take(&mut *self.idle.lock());
+        for tm in idle {
+            close(tm);
+        }
+    }
+
+    /// Parks an object, closing it if the pool is full.
+    fn give_back(&self, tm: TransferMemory<Unmapped>) {
+        let rejected = {
+            let mut idle = self.idle.lock();
+            if idle.len() < self.max_idle {
+                idle.push(tm);
+                None
+            } else {
+                Some(tm)
+            }
+        };
+        if let Some(tm) = rejected {
+            close(tm);
+        }
+    }
+}
+
+/// A transfer-memory object leased from a [`TransferMemoryPool`].
+///
+/// Dropping the lease, or calling [`Lease::give_back`], returns the object to the pool:
+/// only do so once the service it was handed to is done with it.
+#[derive(Debug)]
+pub struct Lease<'a> {
+    pool: &'a TransferMemoryPool,
+    tm: Option<TransferMemory<Unmapped>>,
+}
+
+impl Lease<'_> {
+    /// Returns the object to the pool.
+    pub fn give_back(self) {
+        drop(self);
+    }
+
+    /// Closes the object instead of returning it to the pool, e.g. when the service
+    /// keeps it mapped.
+    pub fn discard(mut self) {
+        if let Some(tm) = self.tm.take() {
+            close(tm);
+        }
+    }
+}
+
+impl Deref for Lease<'_> {
+    type Target = TransferMemory<Unmapped>;
+
+    fn deref(&self) -> &Self::Target {
+        // The object is only taken out when the lease is consumed
+        self.tm.as_ref().unwrap()
+    }
+}
+
+impl Drop for Lease<'_> {
+    fn drop(&mut self) {
+        if let Some(tm) = self.tm.take() {
+            self.pool.give_back(tm);
+        }
+    }
+}
+
+impl core::fmt::Debug for TransferMemoryPool {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("TransferMemoryPool")
+            .field("max_idle", &self.max_idle)
+            .finish_non_exhaustive()
+    }
+}
+
+/// Returns the size class of a `size`-byte request.
+fn size_class(size: usize) -> usize {
+    size.max(MIN_SIZE_CLASS).next_power_of_two()
+}
+
+/// Closes an object and frees its backing memory.
+fn close(tm: TransferMemory<Unmapped>) {
+    // SAFETY: The object is owned by the pool and not used by any service anymore.
+    if let Err(err) = unsafe { sys::close(tm) } {
+        // The kernel still holds the backing memory: leak it
+        core::mem::forget(err.tm);
+    }
+}
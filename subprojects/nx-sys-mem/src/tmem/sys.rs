@@ -467,6 +467,9 @@ pub struct Unmapped {
     src: Option<NonNull<c_void>>, // None if owned by another process
 }
 
+// SAFETY: The handle is valid process-wide, and the backing memory is owned by the object.
+unsafe impl Send for Unmapped {}
+
 impl TmemState for Unmapped {
     fn handle(&self) -> Handle {
         self.handle
@@ -564,7 +567,6 @@ impl TransferMemory<Unmapped> {
     }
 }
 
-#[cfg(feature = "ffi")]
 impl<S> TransferMemory<S>
 where
     S: TmemState + core::fmt::Debug,
@@ -3,6 +3,7 @@
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+mod free_ranges;
 mod sys;
 
 pub use sys::*;
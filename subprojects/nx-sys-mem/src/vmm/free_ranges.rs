@@ -0,0 +1,122 @@
+//! Cached index of the free ranges of an address space region
+//!
+//! Built from the kernel memory map with one `svcQueryMemory` per memory block, the
+//! index lets [`VirtmemState`](super::VirtmemState) place a range without probing the
+//! kernel for every candidate. Ranges handed out or reserved are carved out of the index
+//! as they go, and put back if a batch is abandoned; mappings made behind its back are
+//! caught by the caller validating the picked range, which then rebuilds the index.
+
+extern crate alloc;
+
+use alloc::vec::Vec;
+
+use nx_svc::mem::{self, MemoryType};
+
+use super::sys::MemRegion;
+
+const PAGE_SHIFT: usize = 12;
+
+/// Free (unmapped and unreserved) ranges of a region, sorted by address.
+pub(super) struct FreeRanges {
+    ranges: Vec<MemRegion>,
+}
+
+impl FreeRanges {
+    /// Builds the index of the unmapped ranges of `region`, minus the `excluded` ones.
+    pub(super) fn scan(region: &MemRegion, excluded: impl IntoIterator<Item = MemRegion>) -> Self {
+        let mut ranges = Vec::new();
+
+        let mut addr = region.start();
+        while addr < region.end() {
+            let Ok((info, _)) = mem::query_memory(addr) else {
+                panic!("Failed to query memory: BAD_QUERY_MEMORY");
+            };
+
+            let block_end = info.addr.saturating_add(info.size).min(region.end());
+            if block_end <= addr {
+                break;
+            }
+            if info.typ == MemoryType::Unmapped {
+                ranges.push(MemRegion::new(addr, block_end));
+            }
+            addr = block_end;
+        }
+
+        let mut index = Self { ranges };
+        for range in excluded {
+            index.remove(&range);
+        }
+        index
+    }
+
+    /// Picks a page-aligned range of `size` bytes with `guard` free bytes on both sides,
+    /// uniformly among all the possible placements.
+    ///
+    /// `random` selects the placement. Returns `None` if no free range is large enough.
+    pub(super) fn pick(&self, size: usize, guard: usize, random: u64) -> Option<MemRegion> {
+        let needed = size + 2 * guard;
+        let placements = |range: &MemRegion| {
+            let len = range.end() - range.start();
+            if len < needed {
+                0
+            } else {
+                ((len - needed) >> PAGE_SHIFT) + 1
+            }
+        };
+
+        let total: usize = self.ranges.iter().map(placements).sum();
+        if total == 0 {
+            return None;
+        }
+
+        let mut nth = (random % total as u64) as usize;
+        for range in &self.ranges {
+            let count = placements(range);
+            if nth < count {
+                let start = range.start() + guard + (nth << PAGE_SHIFT);
+                return Some(MemRegion::new(start, start + size));
+            }
+            nth -= count;
+        }
+
+        None
+    }
+
+    /// Adds `range` to the free ranges, merging it with the ranges it overlaps or touches.
+    pub(super) fn insert(&mut self, range: &MemRegion) {
+        let first = self
+            .ranges
+            .partition_point(|free| free.end() < range.start());
+        let last = first + self.ranges[first..].partition_point(|free| free.start() <= range.end());
+
+        let merged = &self.ranges[first..last];
+        let start = merged
+            .first()
+            .map_or(range.start(), |free| free.start().min(range.start()));
+        let end = merged
+            .last()
+            .map_or(range.end(), |free| free.end().max(range.end()));
+        self.ranges
+            .splice(first..last, [MemRegion::new(start, end)]);
+    }
+
+    /// Removes `range` from the free ranges.
+    pub(super) fn remove(&mut self, range: &MemRegion) {
+        let first = self
+            .ranges
+            .partition_point(|free| free.end() <= range.start());
+        let last = first + self.ranges[first..].partition_point(|free| free.start() < range.end());
+        if first == last {
+            return;
+        }
+
+        // Keep the parts of the overlapped ranges lying outside `range`
+        let head = self.ranges[first];
+        let tail = self.ranges[last - 1];
+        let rest = [
+            (head.start() < range.start()).then(|| MemRegion::new(head.start(), range.start())),
+            (range.end() < tail.end()).then(|| MemRegion::new(range.end(), tail.end())),
+        ];
+        self.ranges.splice(first..last, rest.into_iter().flatten());
+    }
+}
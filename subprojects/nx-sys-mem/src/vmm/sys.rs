@@ -13,6 +13,8 @@ use nx_rand::sys::next_u64;
 use nx_std_sync::mutex::{Mutex, MutexGuard};
 use nx_svc::mem::{self, MemoryType, UnmapMemoryError};
 
+use super::free_ranges::FreeRanges;
+
 /// Global virtual memory manager
 pub(super) static VMM: Mutex<VirtmemManager> = Mutex::new(VirtmemManager::new_uninit());
 
@@ -64,7 +66,7 @@ impl VirtmemManager {
     /// This function is equivalent to the C `virtmemFindAslr()` function.
     pub fn find_aslr(&mut self, size: usize, guard_size: usize) -> Option<NonNull<c_void>> {
         let state = self.0.get_or_insert_with(init_state);
-        state.find_random(RegionType::Aslr, size, guard_size)
+        state.find_random(RegionType::Aslr, size, guard_size, &[])
     }
 
     /// Finds a random slice of free stack address space.
@@ -82,7 +84,7 @@ impl VirtmemManager {
     /// This function is equivalent to the C `virtmemFindStack()` function.
     pub fn find_stack(&mut self, size: usize, guard_size: usize) -> Option<NonNull<c_void>> {
         let state = self.0.get_or_insert_with(init_state);
-        state.find_random(RegionType::Stack, size, guard_size)
+        state.find_random(RegionType::Stack, size, guard_size, &[])
     }
 
     /// Finds a random slice of free code memory address space.
@@ -101,7 +103,59 @@ impl VirtmemManager {
     /// This function is equivalent to the C `virtmemFindCodeMemory()` function.
     pub fn find_code_memory(&mut self, size: usize, guard_size: usize) -> Option<NonNull<c_void>> {
         let state = self.0.get_or_insert_with(init_state);
-        state.find_random(RegionType::CodeMemory, size, guard_size)
+        state.find_random(RegionType::CodeMemory, size, guard_size, &[])
+    }
+
+    /// Finds random slices of free general purpose address space for all the `requests`,
+    /// with a single lock acquisition and address space scan.
+    ///
+    /// The slices never overlap each other. Returns `None` if any of the requests cannot
+    /// be satisfied.
+    pub fn find_aslr_batch<const N: usize>(
+        &mut self,
+        requests: [RangeRequest; N],
+    ) -> Option<[NonNull<c_void>; N]> {
+        self.find_batch(RegionType::Aslr, requests)
+    }
+
+    /// Finds random slices of free stack address space for all the `requests`, with a
+    /// single lock acquisition and address space scan.
+    ///
+    /// The slices never overlap each other. Returns `None` if any of the requests cannot
+    /// be satisfied.
+    pub fn find_stack_batch<const N: usize>(
+        &mut self,
+        requests: [RangeRequest; N],
+    ) -> Option<[NonNull<c_void>; N]> {
+        self.find_batch(RegionType::Stack, requests)
+    }
+
+    fn find_batch<const N: usize>(
+        &mut self,
+        region_type: RegionType,
+        requests: [RangeRequest; N],
+    ) -> Option<[NonNull<c_void>; N]> {
+        let state = self.0.get_or_insert_with(init_state);
+
+        let mut found = [MemRegion::new(0, 0); N];
+        for (i, request) in requests.iter().enumerate() {
+            // Keep an index rebuilt mid-batch from handing out the slices found so far
+            let Some(ptr) =
+                state.find_random(region_type, request.size, request.guard_size, &found[..i])
+            else {
+                // None of the slices found so far is handed out
+                for region in &found[..i] {
+                    state.release(region);
+                }
+                return None;
+            };
+            let start = ptr.as_ptr() as usize;
+            let size = (request.size + PAGE_MASK) & !PAGE_MASK;
+            found[i] = MemRegion::new(start, start + size);
+        }
+
+        // SAFETY: `find_random` only returns non-null slices.
+        Some(found.map(|region| unsafe { NonNull::new_unchecked(region.base()) }))
     }
 
     /// Reserves a range of memory address space.
@@ -124,6 +178,14 @@ impl VirtmemManager {
         // Insert at the front of the intrusive list.
         state.reservations.push_front(node);
 
+        // Keep the free range indexes from handing out the reserved range
+        let region = MemRegion::new(mem as usize, mem as usize + size);
+        for index in [&mut state.aslr_free, &mut state.stack_free] {
+            if let Some(index) = index {
+                index.remove(&region);
+            }
+        }
+
         Some(ptr)
     }
 
@@ -142,6 +204,9 @@ impl VirtmemManager {
                 // `_boxed` is dropped here, freeing the reservation.
             }
         }
+
+        // The released range is left out of the free range indexes: it is found again
+        // once an index is rebuilt.
     }
 }
 
@@ -160,10 +225,16 @@ pub struct VirtmemState {
     stack_region: MemRegion,
     reservations: LinkedList<ReservationAdapter>,
     is_legacy_kernel: bool,
+    /// Free ranges of the ASLR region, built on first use.
+    aslr_free: Option<FreeRanges>,
+    /// Free ranges of the stack region, built on first use.
+    stack_free: Option<FreeRanges>,
 }
 
-/// Maximum number of attempts to find a random memory region
-const RANDOM_MAX_ATTEMPTS: usize = 0x200;
+/// Maximum number of attempts to find a random memory region.
+///
+/// Each failed attempt rebuilds the free range index.
+const RANDOM_MAX_ATTEMPTS: usize = 4;
 
 const PAGE_SIZE: usize = 0x1000;
 const PAGE_MASK: usize = PAGE_SIZE - 1;
@@ -171,11 +242,16 @@ const PAGE_MASK: usize = PAGE_SIZE - 1;
 impl VirtmemState {
     /// Finds a random memory region of the given type and size.
     ///
+    /// The region is picked uniformly among the free placements of the cached free range
+    /// index, and validated with a single memory query. A stale index, missing mappings
+    /// or unmappings made since it was built, is rebuilt and the search retried.
+    ///
     /// # Arguments
     ///
     /// * `region_type` - The type of memory region to find
     /// * `size` - The size of the memory region to find
     /// * `guard` - The size of the guard area to leave around the memory region
+    /// * `pending` - Regions handed out but not mapped yet, left out of a rebuilt index
     ///
     /// Returns a pointer to the memory region, or null if no suitable region
     /// is found.
@@ -184,18 +260,18 @@ impl VirtmemState {
         region_type: RegionType,
         size: usize,
         guard: usize,
+        pending: &[MemRegion],
     ) -> Option<NonNull<c_void>> {
         // Get the region based on the type
-        let region = match region_type {
-            RegionType::Aslr => &self.aslr_region,
-            RegionType::Stack => &self.stack_region,
-            RegionType::CodeMemory => {
-                if self.is_legacy_kernel {
-                    &self.stack_region
-                } else {
-                    &self.aslr_region
-                }
-            }
+        let use_stack = match region_type {
+            RegionType::Aslr => false,
+            RegionType::Stack => true,
+            RegionType::CodeMemory => self.is_legacy_kernel,
+        };
+        let (region, mut cached) = if use_stack {
+            (self.stack_region, self.stack_free.take())
+        } else {
+            (self.aslr_region, self.aslr_free.take())
         };
 
         // Page align the sizes
@@ -205,48 +281,83 @@ impl VirtmemState {
         // Ensure the requested size isn't greater than the memory region itself
         let region_size = region.end - region.start;
         if size > region_size {
+            if use_stack {
+                self.stack_free = cached;
+            } else {
+                self.aslr_free = cached;
+            }
             return None;
         }
 
-        // Main allocation loop
-        let aslr_max_page_offset = (region_size - size) >> 12;
+        let mut found = None;
         for _ in 0..RANDOM_MAX_ATTEMPTS {
-            // Calculate a random memory range outside reserved areas
-            let region = loop {
-                let page_offset = (next_u64() as usize) % (aslr_max_page_offset + 1);
-                let addr = region.start + (page_offset << 12);
-
-                let region = MemRegion::new(addr, addr + size);
-
-                // Avoid mapping within the alias region
-                if self.alias_region.overlaps_with(&region) {
-                    continue;
-                }
+            let fresh = cached.is_none();
+            let index = cached.get_or_insert_with(|| self.scan_free_ranges(&region, pending));
 
-                // Avoid mapping within the heap region
-                if self.heap_region.overlaps_with(&region) {
-                    continue;
+            let Some(candidate) = index.pick(size, guard, next_u64()) else {
+                if fresh {
+                    break;
                 }
-
-                break region;
+                // Ranges may have been unmapped since the index was built
+                cached = None;
+                continue;
             };
 
-            // Check that there isn't anything mapped at the desired memory range
-            if self.is_mapped(&region, guard) {
+            // Check that nothing was mapped at the desired memory range behind the index
+            if self.is_mapped(&candidate, guard) {
+                cached = None;
                 continue;
             }
 
-            // Check that the desired memory range doesn't overlap any reservations
-            if self.is_reserved(&region, guard) {
-                continue;
-            }
+            // Assume the caller maps the range
+            index.remove(&candidate);
+            found = Some(candidate);
+            break;
+        }
 
-            // We found a suitable address!
-            // SAFETY: We know the address is valid because we checked it above.
-            return Some(unsafe { NonNull::new_unchecked(region.base()) });
+        // On legacy kernels the ASLR and stack regions overlap
+        let other = if use_stack {
+            self.stack_free = cached;
+            &mut self.aslr_free
+        } else {
+            self.aslr_free = cached;
+            &mut self.stack_free
+        };
+        if let (Some(other), Some(found)) = (other, &found) {
+            other.remove(found);
         }
 
-        None
+        // We found a suitable address!
+        found.and_then(|region| NonNull::new(region.base()))
+    }
+
+    /// Puts a region returned by [`VirtmemState::find_random`], and never mapped, back into
+    /// the free range indexes.
+    fn release(&mut self, found: &MemRegion) {
+        let indexes = [
+            (self.aslr_region, &mut self.aslr_free),
+            (self.stack_region, &mut self.stack_free),
+        ];
+        for (region, index) in indexes {
+            // On legacy kernels the ASLR and stack regions overlap
+            let start = found.start().max(region.start());
+            let end = found.end().min(region.end());
+            if let Some(index) = index
+                && start < end
+            {
+                index.insert(&MemRegion::new(start, end));
+            }
+        }
+    }
+
+    /// Builds the free range index of `region`, leaving out the alias and heap regions,
+    /// the reservations and the `pending` regions.
+    fn scan_free_ranges(&self, region: &MemRegion, pending: &[MemRegion]) -> FreeRanges {
+        let excluded = [self.alias_region, self.heap_region]
+            .into_iter()
+            .chain(self.reservations.iter().map(|rsv| rsv.region))
+            .chain(pending.iter().copied());
+        FreeRanges::scan(region, excluded)
     }
 
     /// Check if the memory region is mapped
@@ -375,6 +486,8 @@ fn init_state() -> VirtmemState {
         stack_region,
         is_legacy_kernel,
         reservations: LinkedList::new(ReservationAdapter::new()),
+        aslr_free: None,
+        stack_free: None,
     }
 }
 
@@ -402,6 +515,15 @@ impl VirtmemReservation {
 // the link inside `VirtmemReservation`.
 intrusive_adapter!(ReservationAdapter = Box<VirtmemReservation>: VirtmemReservation { link: LinkedListLink });
 
+/// Request for a slice of address space, for the batch `find_*_batch` functions
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct RangeRequest {
+    /// Desired size of the slice (rounded up to page alignment)
+    pub size: usize,
+    /// Desired size of unmapped guard areas (rounded up to page alignment)
+    pub guard_size: usize,
+}
+
 /// Virtual memory region types
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum RegionType {
@@ -440,6 +562,11 @@ impl MemRegion {
         self.start
     }
 
+    #[inline]
+    pub fn end(&self) -> usize {
+        self.end
+    }
+
     #[inline]
     pub fn base(&self) -> *mut c_void {
         self.start as *mut c_void
@@ -7,15 +7,13 @@
 #pragma once
 #include <stdint.h>
 
-#include "nx_sys_sync_mutex.h"
-#include "nx_sys_sync_condvar.h"
-
 /// Barrier structure.
 typedef struct Barrier {
-    uint64_t count;  ///< Number of threads to reach the barrier.
-    uint64_t total;  ///< Number of threads to wait on.
-    Mutex mutex;
-    CondVar condvar;
+    uint32_t arrived;     ///< Number of threads that reached the barrier in the current generation.
+    uint32_t generation;  ///< Generation counter, bumped when all threads reached the barrier.
+    uint64_t total;       ///< Number of threads to wait on.
+    uint32_t spins;       ///< Number of spin iterations before blocking.
+    uint32_t reserved;
 } Barrier;
 
 /**
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/lock.h>
 
 /// Mutex datatype (defined in newlib).
@@ -25,6 +26,14 @@ void __nx_sys_sync_mutex_init(Mutex* m);
  */
 void __nx_sys_sync_mutex_lock(Mutex* m);
 
+/**
+ * @brief Locks a mutex, spinning before waiting in the kernel.
+ * @param m Mutex object.
+ * @param max_spins Maximum number of spin iterations before falling back to kernel arbitration.
+ * @note Spinning stops early if other threads are already waiting on the mutex.
+ */
+void __nx_sys_sync__mutex_lock_spin(Mutex* m, uint32_t max_spins);
+
 /**
  * @brief Attempts to lock a mutex without waiting.
  * @param m Mutex object.
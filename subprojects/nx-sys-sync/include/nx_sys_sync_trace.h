@@ -0,0 +1,40 @@
+/**
+ * @file nx_sys_sync_trace.h
+ * @brief Lock contention tracing, available when nx-sys-sync is built with the trace feature
+ * @copyright libnx Authors
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/// Counters of a traced lock.
+typedef struct NxSysSyncLockStats {
+    uintptr_t addr;                   ///< Address of the lock word.
+    uint64_t acquisitions;            ///< Lock acquisitions, including successful try-locks.
+    uint64_t contentions;             ///< Lock acquisitions that found the lock held.
+    uint64_t wait_ticks;              ///< System ticks spent waiting on the lock or condvar.
+    uint64_t arbitrate_lock_count;    ///< ArbitrateLock calls.
+    uint64_t arbitrate_unlock_count;  ///< ArbitrateUnlock calls.
+    uint64_t wait_key_count;          ///< WaitProcessWideKeyAtomic calls.
+    uint64_t signal_key_count;        ///< SignalProcessWideKey calls.
+    uint64_t wait_address_count;      ///< WaitForAddress calls.
+    uint64_t signal_address_count;    ///< SignalToAddress calls.
+} NxSysSyncLockStats;
+
+/**
+ * @brief Writes the counters of the traced locks with the longest waits, longest first.
+ * @param out Output array, or NULL to only count the traced locks.
+ * @param capacity Number of entries of the output array.
+ * @return Number of traced locks, which may exceed the capacity.
+ */
+size_t __nx_sys_sync__trace_dump(NxSysSyncLockStats* out, size_t capacity);
+
+/**
+ * @brief Returns the number of events lost because the lock table was full.
+ */
+uint64_t __nx_sys_sync__trace_dropped(void);
+
+/**
+ * @brief Clears the lock table.
+ */
+void __nx_sys_sync__trace_reset(void);
@@ -0,0 +1,102 @@
+//! # Adaptive mutex
+//!
+//! A [`Mutex`] that spins for a self-tuning number of iterations before parking the thread
+//! through kernel arbitration.
+//!
+//! Each mutex keeps a running estimate of how many spins successful acquisitions needed
+//! (the glibc `PTHREAD_MUTEX_ADAPTIVE_NP` heuristic): the spin budget is twice the estimate
+//! plus a constant, capped at [`MAX_ADAPTIVE_SPINS`], and the estimate moves 1/8th towards
+//! each observed spin count. Short critical sections quickly settle on spinning, while
+//! contended long ones settle on parking right away.
+//!
+//! The lock word is a plain [`Mutex`], so the adaptive state lives next to it and the
+//! FFI-visible `Mutex` layout stays a single `u32`.
+
+use core::sync::atomic::{AtomicU32, Ordering};
+
+use crate::Mutex;
+
+/// Upper bound of the spin budget of an [`AdaptiveMutex`].
+pub const MAX_ADAPTIVE_SPINS: u32 = 100;
+
+/// Minimum spin budget added to twice the estimate.
+const MIN_ADAPTIVE_SPINS: u32 = 10;
+
+/// A mutex that spins adaptively before falling back to kernel arbitration.
+#[derive(Default)]
+pub struct AdaptiveMutex {
+    inner: Mutex,
+    /// Running estimate of the spins needed to acquire the lock.
+    spins: AtomicU32,
+}
+
+impl AdaptiveMutex {
+    /// Creates a new, unlocked [`AdaptiveMutex`].
+    pub const fn new() -> Self {
+        Self {
+            inner: Mutex::new(),
+            spins: AtomicU32::new(0),
+        }
+    }
+
+    /// Returns the underlying [`Mutex`].
+    pub fn as_mutex(&self) -> &Mutex {
+        &self.inner
+    }
+
+    /// Locks the mutex, blocking the current thread until the lock can be acquired.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the kernel's lock arbitration fails. This should never happen under
+    /// normal circumstances.
+    pub fn lock(&self) {
+        if self.inner.try_lock() {
+            return;
+        }
+
+        let estimate = self.spins.load(Ordering::Relaxed);
+        let budget = estimate
+            .saturating_mul(2)
+            .saturating_add(MIN_ADAPTIVE_SPINS)
+            .min(MAX_ADAPTIVE_SPINS);
+
+        let spent = match self.inner.spin_acquire(budget) {
+            Some(spins) => spins,
+            None => {
+                self.inner.lock();
+                budget
+            }
+        };
+
+        // estimate += (spent - estimate) / 8, racy updates are harmless
+        let updated = if spent >= estimate {
+            estimate + (spent - estimate) / 8
+        } else {
+            estimate - (estimate - spent) / 8
+        };
+        self.spins.store(updated, Ordering::Relaxed);
+    }
+
+    /// Attempts to lock the mutex without blocking.
+    ///
+    /// Returns `true` if the mutex was acquired.
+    pub fn try_lock(&self) -> bool {
+        self.inner.try_lock()
+    }
+
+    /// Unlocks the mutex.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the kernel's unlock arbitration fails. This should never happen under
+    /// normal circumstances.
+    pub fn unlock(&self) {
+        self.inner.unlock()
+    }
+
+    /// Checks if the mutex is locked by the current thread.
+    pub fn is_locked_by_current_thread(&self) -> bool {
+        self.inner.is_locked_by_current_thread()
+    }
+}
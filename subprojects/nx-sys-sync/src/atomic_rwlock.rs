@@ -0,0 +1,398 @@
+//! # Atomic-word read-write lock
+//!
+//! A read/write lock whose whole state lives in a single `u32`, so uncontended read and
+//! write acquisition and release are one atomic RMW each. Threads only enter the kernel
+//! (`svcWaitForAddress`/`svcSignalToAddress`) when they actually have to block.
+//!
+//! State word layout:
+//!
+//! | Bits | Meaning |
+//! | --- | --- |
+//! | 0..30 | Number of readers, or [`WRITE_LOCKED`] when write-locked |
+//! | 30 | Readers are waiting on the state word |
+//! | 31 | Writers are waiting on the writer notification counter |
+//!
+//! Writers are preferred: once a writer is waiting, new readers block. Unlike the
+//! libnx-compatible [`RwLock`](crate::RwLock), the lock is not reentrant for the writing
+//! thread.
+
+use core::{
+    hint,
+    sync::atomic::{AtomicU32, Ordering},
+};
+
+use crate::futex;
+#[cfg(feature = "trace")]
+use crate::trace;
+
+/// State value of a single reader.
+const READ_LOCKED: u32 = 1;
+/// Mask of the reader count / write-locked bits.
+const MASK: u32 = (1 << 30) - 1;
+/// State value of a write-locked lock.
+const WRITE_LOCKED: u32 = MASK;
+/// Maximum number of concurrent readers.
+const MAX_READERS: u32 = MASK - 1;
+/// Readers are blocked on the state word.
+const READERS_WAITING: u32 = 1 << 30;
+/// Writers are blocked on the writer notification counter.
+const WRITERS_WAITING: u32 = 1 << 31;
+
+/// Number of spin iterations before blocking in the kernel.
+const SPIN_LIMIT: u32 = 100;
+
+/// A reader-writer lock backed by a single atomic state word.
+#[derive(Default)]
+pub struct AtomicRwLock {
+    state: AtomicU32,
+    /// Bumped on every writer wake-up; writers wait on it instead of the state word.
+    writer_notify: AtomicU32,
+}
+
+impl AtomicRwLock {
+    /// Creates a new, unlocked [`AtomicRwLock`].
+    pub const fn new() -> Self {
+        Self {
+            state: AtomicU32::new(0),
+            writer_notify: AtomicU32::new(0),
+        }
+    }
+
+    /// Attempts to lock the [`AtomicRwLock`] for reading without blocking.
+    ///
+    /// Returns `true` if the read lock was acquired.
+    #[inline]
+    pub fn try_read_lock(&self) -> bool {
+        let locked = self
+            .state
+            .fetch_update(Ordering::Acquire, Ordering::Relaxed, |s| {
+                is_read_lockable(s).then(|| s + READ_LOCKED)
+            })
+            .is_ok();
+
+        #[cfg(feature = "trace")]
+        if locked {
+            trace::record_acquire(self.state.as_ptr(), None);
+        }
+        locked
+    }
+
+    /// Locks the [`AtomicRwLock`] for reading, blocking while a writer holds or waits for it.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the number of readers would overflow, or if the kernel's address arbitration
+    /// fails. The latter should never happen under normal circumstances.
+    #[inline]
+    pub fn read_lock(&self) {
+        let state = self.state.load(Ordering::Relaxed);
+        if !is_read_lockable(state)
+            || self
+                .state
+                .compare_exchange_weak(
+                    state,
+                    state + READ_LOCKED,
+                    Ordering::Acquire,
+                    Ordering::Relaxed,
+                )
+                .is_err()
+        {
+            self.read_lock_contended();
+            return;
+        }
+
+        #[cfg(feature = "trace")]
+        trace::record_acquire(self.state.as_ptr(), None);
+    }
+
+    /// Releases a read lock.
+    ///
+    /// The caller must hold a read lock on this [`AtomicRwLock`].
+    #[inline]
+    pub fn read_unlock(&self) {
+        let state = self.state.fetch_sub(READ_LOCKED, Ordering::Release) - READ_LOCKED;
+
+        // Readers only wait on a read-locked lock if a writer is waiting too
+        debug_assert!(!has_readers_waiting(state) || has_writers_waiting(state));
+
+        if is_unlocked(state) && has_writers_waiting(state) {
+            self.wake_writer_or_readers(state);
+        }
+    }
+
+    /// Attempts to lock the [`AtomicRwLock`] for writing without blocking.
+    ///
+    /// Returns `true` if the write lock was acquired.
+    #[inline]
+    pub fn try_write_lock(&self) -> bool {
+        let locked = self
+            .state
+            .fetch_update(Ordering::Acquire, Ordering::Relaxed, |s| {
+                is_unlocked(s).then(|| s + WRITE_LOCKED)
+            })
+            .is_ok();
+
+        #[cfg(feature = "trace")]
+        if locked {
+            trace::record_acquire(self.state.as_ptr(), None);
+        }
+        locked
+    }
+
+    /// Locks the [`AtomicRwLock`] for writing, blocking until no reader or writer holds it.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the kernel's address arbitration fails. This should never happen under
+    /// normal circumstances.
+    #[inline]
+    pub fn write_lock(&self) {
+        if self
+            .state
+            .compare_exchange_weak(0, WRITE_LOCKED, Ordering::Acquire, Ordering::Relaxed)
+            .is_err()
+        {
+            self.write_lock_contended();
+            return;
+        }
+
+        #[cfg(feature = "trace")]
+        trace::record_acquire(self.state.as_ptr(), None);
+    }
+
+    /// Releases the write lock.
+    ///
+    /// The caller must hold the write lock on this [`AtomicRwLock`].
+    #[inline]
+    pub fn write_unlock(&self) {
+        let state = self.state.fetch_sub(WRITE_LOCKED, Ordering::Release) - WRITE_LOCKED;
+
+        debug_assert!(is_unlocked(state));
+
+        if has_writers_waiting(state) || has_readers_waiting(state) {
+            self.wake_writer_or_readers(state);
+        }
+    }
+
+    /// Checks if the lock is currently write-locked by any thread.
+    pub fn is_write_locked(&self) -> bool {
+        is_write_locked(self.state.load(Ordering::Relaxed))
+    }
+
+    #[cold]
+    fn read_lock_contended(&self) {
+        #[cfg(feature = "trace")]
+        let wait_start = trace::now();
+        let mut state = self.spin_read();
+
+        loop {
+            if is_read_lockable(state) {
+                match self.state.compare_exchange_weak(
+                    state,
+                    state + READ_LOCKED,
+                    Ordering::Acquire,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        #[cfg(feature = "trace")]
+                        trace::record_acquire(self.state.as_ptr(), Some(wait_start));
+                        return;
+                    }
+                    Err(s) => {
+                        state = s;
+                        continue;
+                    }
+                }
+            }
+
+            if has_reached_max_readers(state) {
+                panic!("too many active read locks on AtomicRwLock");
+            }
+
+            // Make sure the readers waiting bit is set before going to sleep
+            if !has_readers_waiting(state)
+                && let Err(s) = self.state.compare_exchange(
+                    state,
+                    state | READERS_WAITING,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                )
+            {
+                state = s;
+                continue;
+            }
+
+            futex::wait(&self.state, state | READERS_WAITING);
+
+            state = self.spin_read();
+        }
+    }
+
+    #[cold]
+    fn write_lock_contended(&self) {
+        #[cfg(feature = "trace")]
+        let wait_start = trace::now();
+        let mut state = self.spin_write();
+        let mut other_writers_waiting = 0;
+
+        loop {
+            if is_unlocked(state) {
+                match self.state.compare_exchange_weak(
+                    state,
+                    state | WRITE_LOCKED | other_writers_waiting,
+                    Ordering::Acquire,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        #[cfg(feature = "trace")]
+                        trace::record_acquire(self.state.as_ptr(), Some(wait_start));
+                        return;
+                    }
+                    Err(s) => {
+                        state = s;
+                        continue;
+                    }
+                }
+            }
+
+            if !has_writers_waiting(state)
+                && let Err(s) = self.state.compare_exchange(
+                    state,
+                    state | WRITERS_WAITING,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                )
+            {
+                state = s;
+                continue;
+            }
+
+            // Other writers might be waiting too, keep the bit set once locked
+            other_writers_waiting = WRITERS_WAITING;
+
+            // Read the notification counter before re-checking the state so that no wake-up
+            // between the two loads is missed
+            let seq = self.writer_notify.load(Ordering::Acquire);
+
+            state = self.state.load(Ordering::Relaxed);
+            if is_unlocked(state) || !has_writers_waiting(state) {
+                continue;
+            }
+
+            futex::wait(&self.writer_notify, seq);
+
+            state = self.spin_write();
+        }
+    }
+
+    /// Wakes up waiters after the lock has become unlocked.
+    ///
+    /// A waiting writer is preferred; readers are woken only if no writer is waiting.
+    #[cold]
+    fn wake_writer_or_readers(&self, mut state: u32) {
+        debug_assert!(is_unlocked(state));
+
+        // If the lock gets locked in the meantime, the new owner wakes the waiters on unlock.
+
+        if state == WRITERS_WAITING {
+            match self
+                .state
+                .compare_exchange(state, 0, Ordering::Relaxed, Ordering::Relaxed)
+            {
+                Ok(_) => {
+                    self.wake_writer();
+                    return;
+                }
+                Err(s) => state = s,
+            }
+        }
+
+        if state == READERS_WAITING | WRITERS_WAITING {
+            if self
+                .state
+                .compare_exchange(state, READERS_WAITING, Ordering::Relaxed, Ordering::Relaxed)
+                .is_err()
+            {
+                return;
+            }
+
+            // The kernel does not report whether a thread was woken, so the readers are woken
+            // as well in case no writer was blocked yet. Woken readers re-check the state and
+            // go back to sleep behind the writer.
+            self.wake_writer();
+            state = READERS_WAITING;
+        }
+
+        if state == READERS_WAITING
+            && self
+                .state
+                .compare_exchange(state, 0, Ordering::Relaxed, Ordering::Relaxed)
+                .is_ok()
+        {
+            futex::wake_all(&self.state);
+        }
+    }
+
+    fn wake_writer(&self) {
+        self.writer_notify.fetch_add(1, Ordering::Release);
+        futex::wake_one(&self.writer_notify);
+    }
+
+    /// Spins until the lock is unlocked or writers are waiting.
+    fn spin_write(&self) -> u32 {
+        self.spin_until(|s| is_unlocked(s) || has_writers_waiting(s))
+    }
+
+    /// Spins until the lock is not write-locked or other threads are waiting.
+    fn spin_read(&self) -> u32 {
+        self.spin_until(|s| !is_write_locked(s) || has_readers_waiting(s) || has_writers_waiting(s))
+    }
+
+    #[inline]
+    fn spin_until(&self, f: impl Fn(u32) -> bool) -> u32 {
+        let mut spin = SPIN_LIMIT;
+        loop {
+            let state = self.state.load(Ordering::Relaxed);
+            if f(state) || spin == 0 {
+                return state;
+            }
+            hint::spin_loop();
+            spin -= 1;
+        }
+    }
+}
+
+#[inline]
+fn is_unlocked(state: u32) -> bool {
+    state & MASK == 0
+}
+
+#[inline]
+fn is_write_locked(state: u32) -> bool {
+    state & MASK == WRITE_LOCKED
+}
+
+#[inline]
+fn has_readers_waiting(state: u32) -> bool {
+    state & READERS_WAITING != 0
+}
+
+#[inline]
+fn has_writers_waiting(state: u32) -> bool {
+    state & WRITERS_WAITING != 0
+}
+
+/// Checks if a reader may acquire the lock.
+///
+/// Also rejects the acquisition when the reader count would overflow, or when other threads
+/// are waiting: waiting writers have priority, and waiting readers are woken by the unlocking
+/// thread.
+#[inline]
+fn is_read_lockable(state: u32) -> bool {
+    state & MASK < MAX_READERS && !has_readers_waiting(state) && !has_writers_waiting(state)
+}
+
+#[inline]
+fn has_reached_max_readers(state: u32) -> bool {
+    state & MASK == MAX_READERS
+}
@@ -4,15 +4,19 @@
 //! The barrier ensures that no thread can proceed past the barrier point until all participating
 //! threads have reached it.
 //!
-//! This implementation is built on top of mutex and condition variables to provide thread
-//! synchronization capabilities. It maintains an internal counter that tracks the number of
-//! threads that have reached the barrier.
+//! This implementation is generation-counted: arriving threads increment an atomic counter,
+//! and all but the last one wait for the generation word to change. The last thread to arrive
+//! resets the counter, bumps the generation and wakes every waiter with a single signal.
+//! Waiters can optionally spin on the generation word before blocking in the kernel.
 
-use core::cell::UnsafeCell;
+use core::{
+    hint,
+    sync::atomic::{AtomicU32, Ordering},
+};
 
 use static_assertions::const_assert_eq;
 
-use super::{Condvar, Mutex};
+use crate::futex;
 
 /// Barrier structure
 ///
@@ -23,61 +27,110 @@ use super::{Condvar, Mutex};
 /// any of them are allowed to proceed. When a thread calls `wait()`, it blocks until all
 /// other threads have also called `wait()`. Once the last thread calls `wait()`, all threads
 /// are unblocked and can continue execution.
+#[repr(C)]
 pub struct Barrier {
-    /// Number of threads to reach the barrier
-    count: UnsafeCell<u64>,
+    /// Number of threads that reached the barrier in the current generation
+    arrived: AtomicU32,
+    /// Generation counter, bumped every time all threads reached the barrier
+    generation: AtomicU32,
     /// Number of threads to wait on
     total: u64,
-    /// Mutex for synchronization
-    mutex: Mutex,
-    /// Condition variable for thread waiting
-    condvar: Condvar,
+    /// Number of spin iterations before blocking in the kernel
+    spins: u32,
+    /// Padding to the libnx `Barrier` size
+    _reserved: u32,
 }
 
 // Ensure that the Barrier has a 24 bytes size, and is properly aligned
 const_assert_eq!(size_of::<Barrier>(), 24);
 const_assert_eq!(align_of::<Barrier>(), align_of::<u64>());
 
+/// The result of [`Barrier::wait`].
+///
+/// Exactly one thread of each generation, the last one to arrive, is the leader.
+#[derive(Debug, Clone, Copy)]
+pub struct BarrierWaitResult(bool);
+
+impl BarrierWaitResult {
+    /// Returns `true` if this thread is the leader of its barrier generation.
+    ///
+    /// The leader can be used to perform serial work between parallel phases.
+    pub fn is_leader(&self) -> bool {
+        self.0
+    }
+}
+
 impl Barrier {
     /// Initializes a barrier and the number of threads to wait on.
     ///
+    /// A `thread_count` of 0 behaves like 1: `wait()` never blocks.
+    ///
     /// # Arguments
     /// * `thread_count` - The number of threads that must call `wait()` before any can proceed.
-    ///   Must be greater than 0.
     ///
     /// # Panics
     ///
-    /// Will not panic as long as `thread_count` is greater than 0.
-    pub fn new(thread_count: u64) -> Self {
+    /// Panics if `thread_count` does not fit in 32 bits.
+    pub const fn new(thread_count: u64) -> Self {
+        Self::with_spins(thread_count, 0)
+    }
+
+    /// Initializes a barrier that spins up to `spins` iterations before blocking.
+    ///
+    /// Spinning avoids the kernel round-trip when all threads are expected to arrive within a
+    /// short window, e.g. per-frame phases of worker threads pinned to different cores.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `thread_count` does not fit in 32 bits.
+    pub const fn with_spins(thread_count: u64, spins: u32) -> Self {
+        assert!(
+            thread_count <= u32::MAX as u64,
+            "Barrier thread count overflow"
+        );
         Barrier {
-            count: UnsafeCell::new(0),
-            total: thread_count - 1,
-            mutex: Mutex::new(),
-            condvar: Condvar::new(),
+            arrived: AtomicU32::new(0),
+            generation: AtomicU32::new(0),
+            total: if thread_count == 0 { 1 } else { thread_count },
+            spins,
+            _reserved: 0,
         }
     }
 
     /// Blocks the current thread until all threads have reached this point.
     ///
     /// When the specified number of threads have called this function, all threads will be
-    /// unblocked and the barrier will be reset, ready for reuse.
+    /// unblocked and the barrier will be reset, ready for reuse. The last thread to arrive
+    /// receives a [`BarrierWaitResult`] for which [`BarrierWaitResult::is_leader`] is `true`.
     ///
     /// # Panics
     ///
-    /// Panics if the internal counter would overflow, which is extremely unlikely in
-    /// practice as it would require more threads than the maximum value of u64.
-    pub fn wait(&self) {
-        self.mutex.lock();
+    /// Panics if the kernel's address arbitration fails. This should never happen under
+    /// normal circumstances.
+    pub fn wait(&self) -> BarrierWaitResult {
+        let generation = self.generation.load(Ordering::Acquire);
+
+        let arrived = self.arrived.fetch_add(1, Ordering::AcqRel) + 1;
+        if arrived as u64 == self.total {
+            // Reset before publishing the new generation, which threads of the next generation
+            // observe before arriving
+            self.arrived.store(0, Ordering::Relaxed);
+            self.generation
+                .store(generation.wrapping_add(1), Ordering::Release);
+            futex::wake_all(&self.generation);
+            return BarrierWaitResult(true);
+        }
 
-        let count = unsafe { &mut *self.count.get() };
-        if *count == self.total {
-            *count = 0;
-            self.condvar.wake(self.total as i32);
-        } else {
-            *count = count.checked_add(1).expect("Barrier count overflow");
-            self.condvar.wait(&self.mutex);
+        for _ in 0..self.spins {
+            if self.generation.load(Ordering::Acquire) != generation {
+                return BarrierWaitResult(false);
+            }
+            hint::spin_loop();
         }
 
-        self.mutex.unlock();
+        while self.generation.load(Ordering::Acquire) == generation {
+            futex::wait(&self.generation, generation);
+        }
+        BarrierWaitResult(false)
     }
 }
@@ -5,6 +5,7 @@
 //! with mutexes to handle situations where a thread needs to wait for some condition
 //! that depends on other threads.
 
+use nx_cpu::control_regs;
 use nx_svc::{
     error::ToRawResultCode,
     raw::Handle,
@@ -13,6 +14,8 @@ use nx_svc::{
 };
 
 use super::Mutex;
+#[cfg(feature = "trace")]
+use crate::trace;
 
 /// A condition variable primitive for thread synchronization.
 ///
@@ -57,10 +60,14 @@ impl Condvar {
     /// * Error code if the wait timed out or another error occurred
     pub fn wait_timeout(&self, mutex: &Mutex, timeout: u64) -> ResultCode {
         let curr_thread_handle = get_curr_thread_handle();
+        #[cfg(feature = "trace")]
+        let wait_start = trace::now();
 
         let result = unsafe {
             wait_process_wide_key_atomic(self.as_ptr(), mutex.as_ptr(), curr_thread_handle, timeout)
         };
+        #[cfg(feature = "trace")]
+        trace::record_wait(self.as_ptr(), wait_start);
 
         // Handle the timeout case specially since we need to re-acquire the mutex
         if let Err(WaitProcessWideKeyError::TimedOut) = result {
@@ -71,6 +78,35 @@ impl Condvar {
         result.map_or_else(ToRawResultCode::to_rc, |_| 0)
     }
 
+    /// Waits on the condition variable until notified or the `deadline` system tick passes.
+    ///
+    /// Unlike [`wait_timeout`](Self::wait_timeout), the deadline does not move when the wait
+    /// is repeated, e.g. after a spurious wakeup. A deadline already past times out without
+    /// releasing the mutex.
+    ///
+    /// # Arguments
+    /// * `mutex` - The mutex protecting the condition
+    /// * `deadline` - System tick at which the wait times out, see [`Condvar::deadline_after`]
+    ///
+    /// # Returns
+    /// * `0` on successful wait and wake
+    /// * Error code if the wait timed out or another error occurred
+    pub fn wait_until(&self, mutex: &Mutex, deadline: u64) -> ResultCode {
+        let remaining = deadline.saturating_sub(get_system_tick());
+        if remaining == 0 {
+            return WaitProcessWideKeyError::TimedOut.to_rc();
+        }
+
+        self.wait_timeout(mutex, ticks_to_ns(remaining))
+    }
+
+    /// Returns the system tick `timeout` nanoseconds from now, as a deadline for
+    /// [`Condvar::wait_until`].
+    #[inline]
+    pub fn deadline_after(timeout: u64) -> u64 {
+        get_system_tick().saturating_add(ns_to_ticks(timeout))
+    }
+
     /// Waits on the condition variable indefinitely until notified.
     ///
     /// This function atomically releases the mutex and suspends the current thread until
@@ -95,6 +131,8 @@ impl Condvar {
     ///   - If positive, wakes up to that many threads
     ///   - If zero or negative, wakes all waiting threads
     pub fn wake(&self, num: i32) {
+        #[cfg(feature = "trace")]
+        trace::record_svc(self.as_ptr(), trace::Svc::SignalProcessWideKey);
         unsafe { signal_process_wide_key(self.as_ptr(), num) };
     }
 
@@ -107,6 +145,10 @@ impl Condvar {
     }
 
     /// Wakes up all threads waiting on the condition variable.
+    ///
+    /// The kernel hands each woken thread the mutex it waits with: only the first one runs,
+    /// and the others are queued on the mutex, to be woken one at a time as it is unlocked,
+    /// rather than all competing for it.
     #[inline]
     pub fn wake_all(&self) {
         self.wake(-1);
@@ -119,6 +161,27 @@ impl Default for Condvar {
     }
 }
 
+/// Get the current system tick
+#[inline(always)]
+fn get_system_tick() -> u64 {
+    // SAFETY: Reading the counter-timer has no side effects.
+    unsafe { control_regs::cntpct_el0() }
+}
+
+/// Converts system ticks (19.2MHz) to nanoseconds, saturating: `ticks * 625 / 12`
+#[inline]
+fn ticks_to_ns(ticks: u64) -> u64 {
+    (ticks / 12)
+        .saturating_mul(625)
+        .saturating_add((ticks % 12) * 625 / 12)
+}
+
+/// Converts nanoseconds to system ticks (19.2MHz), rounding up: `ns * 12 / 625`
+#[inline]
+fn ns_to_ticks(ns: u64) -> u64 {
+    (ns / 625) * 12 + ((ns % 625) * 12).div_ceil(625)
+}
+
 /// Get the current thread's kernel handle
 #[inline(always)]
 fn get_curr_thread_handle() -> Handle {
@@ -15,3 +15,5 @@ mod mutex;
 mod remutex;
 mod rwlock;
 mod semaphore;
+#[cfg(feature = "trace")]
+mod trace;
@@ -34,5 +34,5 @@ pub unsafe extern "C" fn __nx_sys_sync__barrier_init(bar: *mut Barrier, thread_c
 /// * `bar` must point to a valid, initialized [`Barrier`]
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn __nx_sys_sync__barrier_wait(bar: *mut Barrier) {
-    unsafe { &*bar }.wait()
+    unsafe { &*bar }.wait();
 }
@@ -31,6 +31,18 @@ pub unsafe extern "C" fn __nx_sys_sync__mutex_lock(mutex: *mut Mutex) {
     unsafe { &*mutex }.lock()
 }
 
+/// Locks the mutex, spinning up to `max_spins` iterations before waiting in the kernel.
+///
+/// # Safety
+///
+/// This function is unsafe because it:
+/// - Requires that `mutex` points to a valid Mutex instance
+/// - Requires that `mutex` is properly aligned
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_sync__mutex_lock_spin(mutex: *mut Mutex, max_spins: u32) {
+    unsafe { &*mutex }.lock_spin(max_spins)
+}
+
 /// Attempts to lock the mutex without waiting.
 ///
 /// # Safety
@@ -0,0 +1,37 @@
+//! FFI bindings for the `nx-sys-sync` crate - Lock tracing
+
+use core::slice;
+
+use crate::trace::{self, LockStats};
+
+/// Writes the counters of the traced locks with the longest waits to `out`, longest first.
+///
+/// Returns the number of traced locks, which may exceed `capacity`. With a null `out`,
+/// only the count is returned.
+///
+/// # Safety
+///
+/// This function is unsafe because:
+/// * `out`, if not null, must be valid for writes of `capacity` [`LockStats`]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_sync__trace_dump(out: *mut LockStats, capacity: usize) -> usize {
+    if out.is_null() {
+        return trace::snapshot(&mut []);
+    }
+
+    // SAFETY: The caller guarantees `out` is valid for `capacity` elements.
+    let out = unsafe { slice::from_raw_parts_mut(out, capacity) };
+    trace::snapshot(out)
+}
+
+/// Returns the number of events lost because the lock table was full.
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_sys_sync__trace_dropped() -> u64 {
+    trace::dropped()
+}
+
+/// Clears the lock table.
+#[unsafe(no_mangle)]
+pub extern "C" fn __nx_sys_sync__trace_reset() {
+    trace::reset();
+}
@@ -0,0 +1,123 @@
+//! # Futex
+//!
+//! Futex-style waiting on a 32-bit word, built on the kernel address arbiter
+//! (`svcWaitForAddress`/`svcSignalToAddress`).
+//!
+//! [`wait`] blocks only while the word still holds the expected value, so a wake-up that
+//! races with going to sleep is never lost. Waits may return spuriously; callers re-check
+//! their condition in a loop.
+//!
+//! With the `trace` feature, the calls are counted under the address of the word.
+
+use core::sync::atomic::AtomicU32;
+
+use nx_svc::{
+    raw::{ArbitrationType, SignalType},
+    sync::{self as svc, SignalToAddressError, WaitForAddressError},
+};
+
+#[cfg(feature = "trace")]
+use crate::trace;
+
+/// Blocks the current thread while `word` holds `expected`.
+///
+/// Returns immediately if the value differs, and otherwise once woken by [`wake_one`],
+/// [`wake_all`] or spuriously.
+///
+/// # Panics
+///
+/// Panics if the kernel's address arbitration fails. This should never happen under normal
+/// circumstances.
+#[inline]
+pub fn wait(word: &AtomicU32, expected: u32) {
+    #[cfg(feature = "trace")]
+    trace::record_svc(word.as_ptr(), trace::Svc::WaitForAddress);
+    wait_untraced(word, expected, None);
+}
+
+/// Blocks the current thread while `word` holds `expected`, for at most `timeout_ns`
+/// nanoseconds.
+///
+/// Returns `false` if the timeout expired, and `true` otherwise (value mismatch, wake-up or
+/// spurious return).
+///
+/// # Panics
+///
+/// Panics if the kernel's address arbitration fails. This should never happen under normal
+/// circumstances.
+#[inline]
+pub fn wait_timeout(word: &AtomicU32, expected: u32, timeout_ns: u64) -> bool {
+    #[cfg(feature = "trace")]
+    trace::record_svc(word.as_ptr(), trace::Svc::WaitForAddress);
+    wait_untraced(word, expected, Some(timeout_ns))
+}
+
+/// Wakes one thread blocked on `word`.
+///
+/// # Panics
+///
+/// Panics if the kernel's address arbitration fails. This should never happen under normal
+/// circumstances.
+#[inline]
+pub fn wake_one(word: &AtomicU32) {
+    wake(word, 1);
+}
+
+/// Wakes all threads blocked on `word`.
+///
+/// # Panics
+///
+/// Panics if the kernel's address arbitration fails. This should never happen under normal
+/// circumstances.
+#[inline]
+pub fn wake_all(word: &AtomicU32) {
+    wake(word, -1);
+}
+
+/// Wakes up to `count` threads blocked on `word`, all of them if `count` is not positive.
+///
+/// # Panics
+///
+/// Panics if the kernel's address arbitration fails. This should never happen under normal
+/// circumstances.
+pub fn wake(word: &AtomicU32, count: i32) {
+    #[cfg(feature = "trace")]
+    trace::record_svc(word.as_ptr(), trace::Svc::SignalToAddress);
+    wake_untraced(word, count);
+}
+
+/// Wakes like [`wake`], without tracing the call.
+///
+/// For words that live on a stack, which would each claim a slot of the trace table.
+pub(crate) fn wake_untraced(word: &AtomicU32, count: i32) {
+    // SAFETY: `word` is a valid, aligned `u32` borrowed for the duration of the call.
+    match unsafe { svc::signal_to_address(word.as_ptr(), SignalType::Signal, 0, count) } {
+        Ok(()) | Err(SignalToAddressError::ValueMismatch) => {}
+        Err(_) => panic!("Signal to address failed: SIGNAL_TO_ADDRESS_ERROR"),
+    }
+}
+
+/// Blocks like [`wait_timeout`], or [`wait`] without a timeout, without tracing the call.
+///
+/// For words that live on a stack, which would each claim a slot of the trace table.
+pub(crate) fn wait_untraced(word: &AtomicU32, expected: u32, timeout_ns: Option<u64>) -> bool {
+    let timeout_ns = timeout_ns.map_or(-1, |ns| ns.min(i64::MAX as u64) as i64);
+
+    // SAFETY: `word` is a valid, aligned `u32` borrowed for the entire wait.
+    let res = unsafe {
+        svc::wait_for_address(
+            word.as_ptr(),
+            ArbitrationType::WaitIfEqual,
+            expected as i32,
+            timeout_ns,
+        )
+    };
+
+    match res {
+        Ok(())
+        | Err(WaitForAddressError::ValueMismatch)
+        | Err(WaitForAddressError::ThreadTerminating) => true,
+        Err(WaitForAddressError::TimedOut) => false,
+        Err(_) => panic!("Wait for address failed: WAIT_FOR_ADDRESS_ERROR"),
+    }
+}
@@ -18,7 +18,14 @@ extern crate nx_panic_handler as _; // provides #[panic_handler]
 
 #[cfg(feature = "ffi")]
 pub mod ffi;
+pub mod futex;
+pub mod parking_lot;
+#[cfg(feature = "trace")]
+pub mod trace;
+pub mod trace_table;
 
+mod adaptive_mutex;
+mod atomic_rwlock;
 mod barrier;
 mod condvar;
 mod mutex;
@@ -29,6 +36,13 @@ mod semaphore;
 
 #[doc(inline)]
 pub use self::{
-    barrier::Barrier, condvar::Condvar, mutex::Mutex, once::Once, remutex::ReentrantMutex,
-    rwlock::RwLock, semaphore::Semaphore,
+    adaptive_mutex::{AdaptiveMutex, MAX_ADAPTIVE_SPINS},
+    atomic_rwlock::AtomicRwLock,
+    barrier::{Barrier, BarrierWaitResult},
+    condvar::Condvar,
+    mutex::Mutex,
+    once::Once,
+    remutex::ReentrantMutex,
+    rwlock::RwLock,
+    semaphore::Semaphore,
 };
@@ -14,7 +14,10 @@
 //! attempt to lock an already locked mutex, they will be suspended by the kernel until
 //! the mutex becomes available.
 
-use core::sync::atomic::{AtomicU32, Ordering};
+use core::{
+    hint,
+    sync::atomic::{AtomicU32, Ordering},
+};
 
 use nx_svc::{
     raw::{Handle, INVALID_HANDLE},
@@ -22,6 +25,9 @@ use nx_svc::{
 };
 use static_assertions::const_assert_eq;
 
+#[cfg(feature = "trace")]
+use crate::trace;
+
 /// A mutual exclusion primitive useful for protecting shared data
 ///
 /// A mutex is a synchronization primitive that can be used to protect shared data from being
@@ -67,6 +73,8 @@ impl Mutex {
     pub fn lock(&self) {
         let curr_thread_handle = get_curr_thread_handle();
         let mut curr_state = MutexState::from_raw(self.0.load(Ordering::Acquire));
+        #[cfg(feature = "trace")]
+        let mut wait_start = None;
 
         loop {
             match curr_state {
@@ -78,7 +86,12 @@ impl Mutex {
                         Ordering::Acquire,
                         Ordering::Relaxed,
                     ) {
-                        Ok(_) => return, // Lock acquired successfully
+                        Ok(_) => {
+                            // Lock acquired successfully
+                            #[cfg(feature = "trace")]
+                            trace::record_acquire(self.as_ptr(), wait_start);
+                            return;
+                        }
                         Err(new_value) => {
                             // Another thread modified the mutex; retry with the new value
                             curr_state = MutexState::from_raw(new_value);
@@ -87,6 +100,11 @@ impl Mutex {
                     }
                 }
                 MutexState::Locked(mut tag) => {
+                    #[cfg(feature = "trace")]
+                    if wait_start.is_none() {
+                        wait_start = Some(trace::now());
+                    }
+
                     // If there are no waiters, set the waiters bitflag and proceed to arbitration
                     if !tag.has_waiters() {
                         tag.set_waiters_bitflag();
@@ -105,6 +123,8 @@ impl Mutex {
 
                     // Ask the kernel to arbitrate the mutex locking
                     // This will pause the current thread until the mutex is unlocked
+                    #[cfg(feature = "trace")]
+                    trace::record_svc(self.as_ptr(), trace::Svc::ArbitrateLock);
                     let arb_result = unsafe {
                         arbitrate_lock(tag.get_owner_handle(), self.0.as_ptr(), curr_thread_handle)
                     };
@@ -117,6 +137,8 @@ impl Mutex {
                     curr_state = MutexState::from_raw(self.0.load(Ordering::Acquire));
                     if matches!(curr_state, MutexState::Locked(tag) if tag.get_owner_handle() == curr_thread_handle)
                     {
+                        #[cfg(feature = "trace")]
+                        trace::record_acquire(self.as_ptr(), wait_start);
                         return;
                     }
 
@@ -126,6 +148,63 @@ impl Mutex {
         }
     }
 
+    /// Locks the mutex, spinning up to `max_spins` iterations before falling back to kernel
+    /// arbitration.
+    ///
+    /// Spinning avoids the `ArbitrateLock` round trip when the lock is held only for a short
+    /// critical section by a thread running on another core. The spin phase ends early if
+    /// other threads are already parked in the kernel, so spinners never barge ahead of them.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the kernel's lock arbitration fails. This should never happen under
+    /// normal circumstances.
+    pub fn lock_spin(&self, max_spins: u32) {
+        if self.spin_acquire(max_spins).is_some() {
+            return;
+        }
+
+        self.lock();
+    }
+
+    /// Spins up to `max_spins` iterations trying to acquire the mutex without arbitration.
+    ///
+    /// Returns the number of iterations spent if the mutex was acquired, `None` otherwise.
+    #[inline]
+    pub(crate) fn spin_acquire(&self, max_spins: u32) -> Option<u32> {
+        let curr_thread_handle = get_curr_thread_handle();
+        #[cfg(feature = "trace")]
+        let spin_start = trace::now();
+
+        for spins in 0..=max_spins {
+            match MutexState::from_raw(self.0.load(Ordering::Relaxed)) {
+                MutexState::Unlocked => {
+                    if self
+                        .0
+                        .compare_exchange_weak(
+                            MutexState::Unlocked.into_raw(),
+                            MutexState::Locked(MutexTag(curr_thread_handle)).into_raw(),
+                            Ordering::Acquire,
+                            Ordering::Relaxed,
+                        )
+                        .is_ok()
+                    {
+                        #[cfg(feature = "trace")]
+                        trace::record_acquire(self.as_ptr(), (spins > 0).then_some(spin_start));
+                        return Some(spins);
+                    }
+                }
+                // Threads already waiting in the kernel: queue up behind them
+                MutexState::Locked(tag) if tag.has_waiters() => return None,
+                MutexState::Locked(_) => {}
+            }
+
+            hint::spin_loop();
+        }
+
+        None
+    }
+
     /// Attempts to lock the mutex without blocking.
     ///
     /// If the mutex is already locked by another thread, this function returns
@@ -144,14 +223,21 @@ impl Mutex {
 
         // Attempt to acquire the lock by setting it from Unlocked to Locked with the current thread's handle
         // This will fail if the mutex is already locked
-        self.0
+        let locked = self
+            .0
             .compare_exchange(
                 MutexState::Unlocked.into_raw(),
                 MutexState::Locked(MutexTag(curr_thread_handle)).into_raw(),
                 Ordering::Acquire,
                 Ordering::Relaxed,
             )
-            .is_ok()
+            .is_ok();
+
+        #[cfg(feature = "trace")]
+        if locked {
+            trace::record_acquire(self.as_ptr(), None);
+        }
+        locked
     }
 
     /// Unlocks the [`Mutex`].
@@ -179,6 +265,8 @@ impl Mutex {
 
                     // If locked and there are waiters, ask the kernel to arbitrate the mutex unlocking
                     if tag.has_waiters() {
+                        #[cfg(feature = "trace")]
+                        trace::record_svc(self.as_ptr(), trace::Svc::ArbitrateUnlock);
                         unsafe {
                             if arbitrate_unlock(self.0.as_ptr()).is_err() {
                                 // This should never happen
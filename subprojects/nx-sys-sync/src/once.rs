@@ -3,8 +3,8 @@
 //! A synchronization primitive which can be used to run a one‐time global
 //! initialization. Unlike the standard library version this implementation is
 //! **non-poisoning** – if the initialization routine panics the `Once` simply
-//! stays in the [`INCOMPLETE`] state and subsequent calls will endlessly spin
-//! trying to acquire it. This mirrors the behaviour of a panic in `no_std`
+//! stays in the [`RUNNING`] state and subsequent calls will sleep forever
+//! waiting for it. This mirrors the behaviour of a panic in `no_std`
 //! environments where unwinding is typically disabled and the entire program
 //! aborts anyway.
 //!
@@ -22,17 +22,16 @@
 //!
 //! Implementation details:
 //!
-//! • Internally the type is composed of an `AtomicUsize` that tracks the state
-//!   (INCOMPLETE → RUNNING → COMPLETE) plus a [`Mutex`] ⁄ [`Condvar`] pair that
-//!   lets all non-initialising threads sleep inside the kernel instead of
-//!   spinning on the CPU.
+//! • Internally the type is a single `AtomicU32` that tracks the state
+//!   (INCOMPLETE → RUNNING → COMPLETE) plus a `QUEUED` bit set by the threads
+//!   waiting for it. Waiting threads sleep on the state word with the
+//!   [`futex`](crate::futex) primitive instead of spinning on the CPU.
 //! • Only the thread that transitions the state to `RUNNING` executes the
-//!   initialiser closure.  Others block on the condition variable until the
-//!   state becomes `COMPLETE` and the initialiser performs `wake_all()`.
-//! • Memory ordering follows the standard-library contract: the `COMPLETE`
-//!   store uses `Release` semantics and the fast-path load uses `Acquire`
-//!   guaranteeing that all writes performed by the initialiser are visible to
-//!   threads that observe the `COMPLETE` state.
+//!   initialiser closure. When it is done, it wakes the waiting threads only if
+//!   one of them set the `QUEUED` bit.
+//! • The completed check is a single `Acquire` load, inlined into the caller;
+//!   everything else is outlined in a cold function shared by all the entry
+//!   points.
 //!
 //! ## Memory ordering
 //!
@@ -41,19 +40,24 @@
 //! the store uses `Release` semantics and readers use `Acquire`.
 
 use core::sync::atomic::{
-    AtomicUsize,
+    AtomicU32,
     Ordering::{Acquire, Relaxed, Release},
 };
 
-use super::{Condvar, Mutex};
+use crate::futex;
 
 /// No initialization has run yet, and no thread is currently using the Once.
-const INCOMPLETE: usize = 0;
+const INCOMPLETE: u32 = 0;
 /// Some thread is currently attempting to run initialization. It may succeed,
 /// so all future threads need to wait for it to finish.
-const RUNNING: usize = 1;
+const RUNNING: u32 = 1;
 /// Initialization has completed and all future calls should finish immediately.
-const COMPLETE: usize = 2;
+const COMPLETE: u32 = 2;
+/// Mask of the state bits, without [`QUEUED`].
+const STATE_MASK: u32 = 0b11;
+/// Set along [`INCOMPLETE`] or [`RUNNING`] when some thread is sleeping on the
+/// state word and must be woken when it changes.
+const QUEUED: u32 = 0b100;
 
 /// The public representation of a `Once`.
 ///
@@ -61,9 +65,7 @@ const COMPLETE: usize = 2;
 /// threads concurrently.
 #[repr(C)]
 pub struct Once {
-    state: AtomicUsize,
-    mutex: Mutex,
-    cvar: Condvar,
+    state: AtomicU32,
 }
 
 impl Once {
@@ -71,9 +73,7 @@ impl Once {
     #[inline]
     pub const fn new() -> Self {
         Self {
-            state: AtomicUsize::new(INCOMPLETE),
-            mutex: Mutex::new(),
-            cvar: Condvar::new(),
+            state: AtomicU32::new(INCOMPLETE),
         }
     }
 }
@@ -93,22 +93,14 @@ impl Once {
 
     /// Blocks the current thread until the `Once` has finished initialising.
     ///
-    /// Internally this acquires the internal mutex and puts the thread to sleep
-    /// on a condition variable, so it does **not** burn CPU time while waiting.
+    /// The thread sleeps on the state word, so it does **not** burn CPU time
+    /// while waiting.
     #[inline]
     pub fn wait(&self) {
-        // Fast path: completed.
         if self.is_completed() {
             return;
         }
-
-        // Slow path – block on the condition variable until `COMPLETE`.
-        self.mutex.lock();
-        while self.state.load(Relaxed) != COMPLETE {
-            // Ignore potential error codes; we only care about waking up.
-            let _ = self.cvar.wait(&self.mutex);
-        }
-        self.mutex.unlock();
+        self.slow(None);
     }
 
     /// Executes the given closure exactly **once**. Subsequent calls block
@@ -118,42 +110,15 @@ impl Once {
     where
         F: FnOnce(),
     {
-        // Fast-path: already initialised.
         if self.is_completed() {
             return;
         }
 
-        // Slow path – coordinate through mutex + condvar.
-        self.mutex.lock();
-
-        match self.state.load(Relaxed) {
-            INCOMPLETE => {
-                // Become the initializer.
-                self.state.store(RUNNING, Relaxed);
-                self.mutex.unlock();
-
-                // Run user initialization code outside the critical section.
-                f();
-
-                // Mark as complete and wake waiters.
-                self.mutex.lock();
-                self.state.store(COMPLETE, Release);
-                self.cvar.wake_all();
-                self.mutex.unlock();
-            }
-            RUNNING => {
-                // Somebody else is running – wait until they are done.
-                while self.state.load(Relaxed) != COMPLETE {
-                    let _ = self.cvar.wait(&self.mutex);
-                }
-                self.mutex.unlock();
-            }
-            COMPLETE => {
-                // Became complete while we were locking.
-                self.mutex.unlock();
-            }
-            _ => unreachable!(),
-        }
+        let mut f = Some(f);
+        self.slow(Some(&mut || {
+            (f.take().unwrap())();
+            true
+        }));
     }
 
     /// Executes the given fallible closure exactly **once**. If the
@@ -163,80 +128,79 @@ impl Once {
     ///
     /// All other semantics are identical to [`call_once`]. Only the thread
     /// that actually executes the initializer receives the error. Waiting
-    /// threads will simply observe the `INCOMPLETE` state and may try
-    /// again.
+    /// threads are woken up, observe the `INCOMPLETE` state and try again
+    /// with their own closure.
+    ///
+    /// [`call_once`]: Self::call_once
     #[inline]
     pub fn call_once_try<F, E>(&self, f: F) -> Result<(), E>
     where
         F: FnOnce() -> Result<(), E>,
     {
-        // Fast-path: already initialised.
         if self.is_completed() {
             return Ok(());
         }
 
-        // We have to keep the closure in an `Option` because in the event we
-        // end up waiting for another thread we need to be able to retry the
-        // call once the state goes back to `INCOMPLETE`.
-        //
-        // NOTE: Using a loop here keeps the implementation concise without
-        // the need for extra helper functions.
-        let mut init_opt = Some(f);
+        let mut f = Some(f);
+        let mut err = None;
+        self.slow(Some(&mut || match (f.take().unwrap())() {
+            Ok(()) => true,
+            Err(e) => {
+                err = Some(e);
+                false
+            }
+        }));
+        err.map_or(Ok(()), Err)
+    }
 
+    /// Runs `init` if the `Once` is incomplete and no other thread is running
+    /// its initializer, or waits for it to complete.
+    ///
+    /// `init` returns `true` on success. With no initializer, only waits.
+    #[cold]
+    #[inline(never)]
+    fn slow(&self, mut init: Option<&mut dyn FnMut() -> bool>) {
+        let mut state = self.state.load(Acquire);
         loop {
-            self.mutex.lock();
-
-            match self.state.load(Relaxed) {
-                INCOMPLETE => {
-                    // Become the initializer.
-                    self.state.store(RUNNING, Relaxed);
-                    self.mutex.unlock();
-
-                    // Run user initialisation code outside the critical section.
-                    let result = (init_opt.take().unwrap())();
-
-                    // Update state and wake waiters.
-                    self.mutex.lock();
-                    match result {
-                        Ok(()) => {
-                            // Success – publish the completion.
-                            self.state.store(COMPLETE, Release);
-                            self.cvar.wake_all();
-                            self.mutex.unlock();
-                            return Ok(());
-                        }
-                        Err(e) => {
-                            // Failure – roll back to INCOMPLETE so that the
-                            // next caller can try again.
-                            self.state.store(INCOMPLETE, Relaxed);
-                            self.cvar.wake_all();
-                            self.mutex.unlock();
-                            return Err(e);
-                        }
-                    }
-                }
-                RUNNING => {
-                    // Somebody else is running – wait until they finish.
-                    while self.state.load(Relaxed) == RUNNING {
-                        let _ = self.cvar.wait(&self.mutex);
+            match (state & STATE_MASK, init.as_deref_mut()) {
+                (COMPLETE, _) => return,
+                (INCOMPLETE, Some(init)) => {
+                    // Become the initializer, keeping the waiters queued.
+                    if let Err(new) = self.state.compare_exchange_weak(
+                        state,
+                        RUNNING | (state & QUEUED),
+                        Acquire,
+                        Acquire,
+                    ) {
+                        state = new;
+                        continue;
                     }
 
-                    // Re-check the state: if it is COMPLETE we are done,
-                    // otherwise it is INCOMPLETE and we must loop and try
-                    // again.
-                    if self.state.load(Relaxed) == COMPLETE {
-                        self.mutex.unlock();
-                        return Ok(());
+                    // On failure, roll back so that the next caller can try again.
+                    let next = if init() { COMPLETE } else { INCOMPLETE };
+                    if self.state.swap(next, Release) & QUEUED != 0 {
+                        futex::wake_all(&self.state);
                     }
-
-                    // State is INCOMPLETE – another round.
-                    self.mutex.unlock();
+                    return;
                 }
-                COMPLETE => {
-                    self.mutex.unlock();
-                    return Ok(());
+                _ => {
+                    // Somebody else is running, or we only wait: sleep until the state
+                    // changes.
+                    if state & QUEUED == 0
+                        && let Err(new) = self.state.compare_exchange_weak(
+                            state,
+                            state | QUEUED,
+                            Relaxed,
+                            Acquire,
+                        )
+                    {
+                        state = new;
+                        continue;
+                    }
+
+                    futex::wait(&self.state, state | QUEUED);
+                    state = self.state.load(Acquire);
                 }
-                _ => unreachable!(),
             }
         }
     }
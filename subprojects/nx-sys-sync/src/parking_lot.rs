@@ -0,0 +1,273 @@
+//! # Parking lot
+//!
+//! A global, keyed wait queue in the style of WebKit's `ParkingLot` and the `parking_lot`
+//! crate. Any address can be used as a key, so a primitive only needs a single state word of
+//! its own: threads that must block [`park`] on the word's address, and the thread that
+//! changes the state [`unpark_one`]s or [`unpark_all`]s them.
+//!
+//! Keys hash into a fixed table of buckets, each a [`Mutex`] protecting a FIFO queue of
+//! waiters. A waiter is a node on the parked thread's stack holding a futex word the
+//! unparking thread clears. Colliding keys share a bucket but never wake each other, since
+//! waiters are matched by key.
+
+use core::{
+    cell::UnsafeCell,
+    ptr,
+    sync::atomic::{AtomicU32, Ordering},
+};
+
+use crate::{Mutex, futex};
+
+/// Number of hash bits selecting a bucket.
+const BUCKET_BITS: u32 = 6;
+
+/// Number of buckets in the global table.
+const BUCKET_COUNT: usize = 1 << BUCKET_BITS;
+
+/// The waiter is queued and has not been unparked yet.
+const PARKED: u32 = 1;
+/// The waiter has been removed from its queue by an unparking thread.
+const UNPARKED: u32 = 0;
+
+static BUCKETS: [Bucket; BUCKET_COUNT] = [const { Bucket::new() }; BUCKET_COUNT];
+
+/// Outcome of a [`park`] call.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ParkResult {
+    /// The thread was unparked by another thread.
+    Unparked,
+    /// The validation callback returned `false`; the thread did not park.
+    Invalid,
+    /// The timeout expired before the thread was unparked.
+    TimedOut,
+}
+
+/// Parks the current thread in the queue for `key`.
+///
+/// `validate` is called with the bucket locked, so no unpark for `key` can happen between the
+/// check and the thread being queued. If it returns `false`, the thread does not park.
+///
+/// With a timeout, the thread parks for at most `timeout_ns` nanoseconds. A spurious
+/// wake-up may end a timed park early with [`ParkResult::TimedOut`]; callers re-check their
+/// condition in a loop.
+///
+/// # Panics
+///
+/// Panics if the kernel's arbitration fails. This should never happen under normal
+/// circumstances.
+pub fn park(key: usize, validate: impl FnOnce() -> bool, timeout_ns: Option<u64>) -> ParkResult {
+    let bucket = bucket(key);
+    let waiter = Waiter {
+        key,
+        next: UnsafeCell::new(ptr::null()),
+        state: AtomicU32::new(PARKED),
+    };
+
+    bucket.lock.lock();
+    if !validate() {
+        bucket.lock.unlock();
+        return ParkResult::Invalid;
+    }
+    // SAFETY: The bucket is locked and `waiter` outlives its queue membership: it is only
+    // dropped once an unparker cleared `state` (after dequeuing it) or after we dequeue it.
+    unsafe { bucket.push(&waiter) };
+    bucket.lock.unlock();
+
+    if let Some(timeout_ns) = timeout_ns {
+        if waiter.state.load(Ordering::Acquire) == PARKED {
+            futex::wait_untraced(&waiter.state, PARKED, Some(timeout_ns));
+        }
+        if waiter.state.load(Ordering::Acquire) == UNPARKED {
+            return ParkResult::Unparked;
+        }
+
+        bucket.lock.lock();
+        // SAFETY: The bucket is locked.
+        let removed = unsafe { bucket.remove(&waiter) };
+        bucket.lock.unlock();
+        if removed {
+            return ParkResult::TimedOut;
+        }
+        // An unparker dequeued us concurrently; wait for it to release the waiter
+    }
+
+    while waiter.state.load(Ordering::Acquire) == PARKED {
+        futex::wait_untraced(&waiter.state, PARKED, None);
+    }
+    ParkResult::Unparked
+}
+
+/// Unparks the first thread parked on `key`.
+///
+/// Returns `true` if a thread was unparked.
+pub fn unpark_one(key: usize) -> bool {
+    let bucket = bucket(key);
+
+    bucket.lock.lock();
+    // SAFETY: The bucket is locked.
+    let waiter = unsafe { bucket.pop(key) };
+    bucket.lock.unlock();
+
+    if waiter.is_null() {
+        return false;
+    }
+    // SAFETY: The waiter stays alive until its state is cleared.
+    unsafe { unpark(waiter) };
+    true
+}
+
+/// Unparks all threads parked on `key`.
+///
+/// Returns the number of threads unparked.
+pub fn unpark_all(key: usize) -> usize {
+    let bucket = bucket(key);
+    let mut count = 0;
+
+    // Threads are released while the bucket is locked so that each one is dequeued
+    // exactly once; unparking does not block.
+    bucket.lock.lock();
+    loop {
+        // SAFETY: The bucket is locked.
+        let waiter = unsafe { bucket.pop(key) };
+        if waiter.is_null() {
+            break;
+        }
+        // SAFETY: The waiter stays alive until its state is cleared.
+        unsafe { unpark(waiter) };
+        count += 1;
+    }
+    bucket.lock.unlock();
+
+    count
+}
+
+/// Releases a dequeued waiter.
+///
+/// # Safety
+///
+/// `waiter` must have been dequeued by the caller and not released since.
+unsafe fn unpark(waiter: *const Waiter) {
+    // SAFETY: The waiter's thread does not return from `park` before `state` is cleared, so
+    // the node is alive here.
+    let state = unsafe { &(*waiter).state };
+    state.store(UNPARKED, Ordering::Release);
+    // The waiter may already have returned; signaling its stale stack address is at worst a
+    // spurious wake-up for a later futex on that address.
+    futex::wake_untraced(state, 1);
+}
+
+fn bucket(key: usize) -> &'static Bucket {
+    let hash = (key as u64 >> 3).wrapping_mul(0x9E37_79B9_7F4A_7C15);
+    &BUCKETS[(hash >> (u64::BITS - BUCKET_BITS)) as usize]
+}
+
+/// A parked thread, living on its stack for the duration of [`park`].
+struct Waiter {
+    key: usize,
+    /// Next waiter in the bucket queue, guarded by the bucket lock.
+    next: UnsafeCell<*const Waiter>,
+    state: AtomicU32,
+}
+
+/// A FIFO queue of waiters guarded by a lock.
+struct Bucket {
+    lock: Mutex,
+    head: UnsafeCell<*const Waiter>,
+    tail: UnsafeCell<*const Waiter>,
+}
+
+// SAFETY: The queue is only accessed with the bucket lock held.
+unsafe impl Sync for Bucket {}
+
+impl Bucket {
+    const fn new() -> Self {
+        Self {
+            lock: Mutex::new(),
+            head: UnsafeCell::new(ptr::null()),
+            tail: UnsafeCell::new(ptr::null()),
+        }
+    }
+
+    /// Appends `waiter` to the queue.
+    ///
+    /// # Safety
+    ///
+    /// The bucket lock must be held and `waiter` must stay alive while queued.
+    unsafe fn push(&self, waiter: *const Waiter) {
+        // SAFETY: The caller holds the lock, so the queue is exclusively ours.
+        unsafe {
+            let tail = *self.tail.get();
+            if tail.is_null() {
+                *self.head.get() = waiter;
+            } else {
+                *(*tail).next.get() = waiter;
+            }
+            *self.tail.get() = waiter;
+        }
+    }
+
+    /// Dequeues the first waiter for `key`, or returns null if there is none.
+    ///
+    /// # Safety
+    ///
+    /// The bucket lock must be held.
+    unsafe fn pop(&self, key: usize) -> *const Waiter {
+        let mut prev: *const Waiter = ptr::null();
+        // SAFETY: The caller holds the lock; queued waiters are alive.
+        unsafe {
+            let mut curr = *self.head.get();
+            while !curr.is_null() {
+                if (*curr).key == key {
+                    self.unlink(prev, curr);
+                    return curr;
+                }
+                prev = curr;
+                curr = *(*curr).next.get();
+            }
+        }
+        ptr::null()
+    }
+
+    /// Dequeues `waiter` if it is still queued.
+    ///
+    /// # Safety
+    ///
+    /// The bucket lock must be held.
+    unsafe fn remove(&self, waiter: *const Waiter) -> bool {
+        let mut prev: *const Waiter = ptr::null();
+        // SAFETY: The caller holds the lock; queued waiters are alive.
+        unsafe {
+            let mut curr = *self.head.get();
+            while !curr.is_null() {
+                if ptr::eq(curr, waiter) {
+                    self.unlink(prev, curr);
+                    return true;
+                }
+                prev = curr;
+                curr = *(*curr).next.get();
+            }
+        }
+        false
+    }
+
+    /// Unlinks `curr`, whose predecessor is `prev` (null for the head).
+    ///
+    /// # Safety
+    ///
+    /// The bucket lock must be held and `curr` must be queued right after `prev`.
+    unsafe fn unlink(&self, prev: *const Waiter, curr: *const Waiter) {
+        // SAFETY: The caller holds the lock; both nodes are queued and alive.
+        unsafe {
+            let next = *(*curr).next.get();
+            if prev.is_null() {
+                *self.head.get() = next;
+            } else {
+                *(*prev).next.get() = next;
+            }
+            if ptr::eq(*self.tail.get(), curr) {
+                *self.tail.get() = prev;
+            }
+            *(*curr).next.get() = ptr::null();
+        }
+    }
+}
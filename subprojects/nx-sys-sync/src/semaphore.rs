@@ -3,18 +3,29 @@
 //! A semaphore is a synchronization primitive that maintains a count of available resources.
 //! It allows threads to wait for and release resources in a thread-safe manner. The semaphore's
 //! internal counter represents the number of available resources.
+//!
+//! With the `lockfree-semaphore` feature the counter lives in an atomic word: `try_wait` is a
+//! single CAS, and `signal` only enters the kernel when a thread is blocked in `wait`. Both
+//! variants share the 16-byte libnx `Semaphore` layout, so the FFI is unchanged.
 
+#[cfg(not(feature = "lockfree-semaphore"))]
 use core::cell::UnsafeCell;
+#[cfg(feature = "lockfree-semaphore")]
+use core::sync::atomic::{AtomicU32, Ordering};
 
 use static_assertions::const_assert_eq;
 
-use super::{Condvar, Mutex};
+#[cfg(feature = "lockfree-semaphore")]
+use crate::futex;
+#[cfg(not(feature = "lockfree-semaphore"))]
+use crate::{Condvar, Mutex};
 
 /// A counting semaphore synchronization primitive.
 ///
 /// The semaphore maintains an internal counter of available resources. Threads can
 /// wait for resources (decrementing the counter) or signal when they're done
 /// (incrementing the counter).
+#[cfg(not(feature = "lockfree-semaphore"))]
 #[repr(C)]
 pub struct Semaphore {
     /// Condition variable for thread synchronization
@@ -25,10 +36,27 @@ pub struct Semaphore {
     count: UnsafeCell<u64>,
 }
 
+/// A counting semaphore synchronization primitive.
+///
+/// The semaphore maintains an internal counter of available resources. Threads can
+/// wait for resources (decrementing the counter) or signal when they're done
+/// (incrementing the counter).
+#[cfg(feature = "lockfree-semaphore")]
+#[repr(C)]
+pub struct Semaphore {
+    /// Number of available resources, also the futex word waiters block on
+    count: AtomicU32,
+    /// Number of threads blocked (or about to block) in `wait`
+    waiters: AtomicU32,
+    /// Padding to the libnx `Semaphore` layout
+    _reserved: u64,
+}
+
 // Ensure that the Semaphore object has a 16 bytes size, and is properly aligned
 const_assert_eq!(size_of::<Semaphore>(), 16);
 const_assert_eq!(align_of::<Semaphore>(), align_of::<u64>());
 
+#[cfg(not(feature = "lockfree-semaphore"))]
 impl Semaphore {
     /// Creates a new Semaphore with the specified initial count.
     ///
@@ -95,3 +123,91 @@ impl Semaphore {
         result
     }
 }
+
+#[cfg(feature = "lockfree-semaphore")]
+impl Semaphore {
+    /// Creates a new Semaphore with the specified initial count.
+    ///
+    /// # Arguments
+    /// * `count` - Initial value for the semaphore's counter, typically representing
+    ///   the number of available resources. It must be >= 1.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `count` does not fit in 32 bits.
+    pub const fn new(count: u64) -> Self {
+        assert!(count <= u32::MAX as u64, "semaphore count overflow");
+        Self {
+            count: AtomicU32::new(count as u32),
+            waiters: AtomicU32::new(0),
+            _reserved: 0,
+        }
+    }
+
+    /// Signals the semaphore, incrementing its counter and potentially waking a waiting thread.
+    ///
+    /// Only enters the kernel if a thread is waiting.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the counter overflows.
+    #[inline]
+    pub fn signal(&self) {
+        // SeqCst pairs with the waiter registration in `wait_contended`: either we see the
+        // waiter, or its kernel wait sees the new count and does not sleep
+        if self
+            .count
+            .fetch_update(Ordering::SeqCst, Ordering::Relaxed, |c| c.checked_add(1))
+            .is_err()
+        {
+            panic!("semaphore count overflow");
+        }
+
+        if self.waiters.load(Ordering::SeqCst) > 0 {
+            futex::wake_one(&self.count);
+        }
+    }
+
+    /// Waits for the semaphore, decrementing its counter when a resource becomes available.
+    ///
+    /// This call will block if no resources are currently available.
+    #[inline]
+    pub fn wait(&self) {
+        if !self.try_wait() {
+            self.wait_contended();
+        }
+    }
+
+    /// Attempts to wait for the semaphore without blocking.
+    ///
+    /// Returns `true` if a resource was acquired, `false` if no resources were available.
+    #[inline]
+    pub fn try_wait(&self) -> bool {
+        let mut count = self.count.load(Ordering::Relaxed);
+        while count > 0 {
+            match self.count.compare_exchange_weak(
+                count,
+                count - 1,
+                Ordering::Acquire,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => return true,
+                Err(c) => count = c,
+            }
+        }
+        false
+    }
+
+    #[cold]
+    fn wait_contended(&self) {
+        loop {
+            self.waiters.fetch_add(1, Ordering::SeqCst);
+            futex::wait(&self.count, 0);
+            self.waiters.fetch_sub(1, Ordering::Relaxed);
+
+            if self.try_wait() {
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,210 @@
+//! # Lock tracing
+//!
+//! Per-lock contention counters, recorded when the `trace` feature is enabled.
+//!
+//! Every [`Mutex`](crate::Mutex) and [`Condvar`](crate::Condvar) event is recorded under the
+//! address of its lock word, in a fixed, lock-free [`TraceTable`] of [`MAX_LOCKS`] slots
+//! claimed on the first event of each lock. The primitives built on them are traced through
+//! their inner words: an `RwLock` or a `ReentrantMutex` shows up as its mutex, at the address
+//! of the primitive itself, next to its condvars.
+//!
+//! The [`futex`](crate::futex) calls are counted under the word they wait or signal on,
+//! which traces the futex-based primitives: [`AtomicRwLock`](crate::AtomicRwLock), `Once`,
+//! `Barrier` and the lock-free `Semaphore`. [`AtomicRwLock`](crate::AtomicRwLock) also
+//! records its acquisitions under its state word, like a mutex; its writers wait on the next
+//! word. Threads blocked in the [`parking_lot`](crate::parking_lot) wait on words of their
+//! own stacks, which are not traced.
+//!
+//! Events of locks that find no slot are counted in [`dropped`], and otherwise lost.
+
+use core::sync::atomic::{AtomicU64, Ordering};
+
+use nx_cpu::control_regs;
+
+use crate::trace_table::TraceTable;
+
+/// Number of locks traced at once. A power of two.
+pub const MAX_LOCKS: usize = 256;
+
+/// Counters of a traced lock.
+///
+/// Mirrors `NxSysSyncLockStats` in `nx_sys_sync_trace.h`.
+#[derive(Debug, Default, Clone, Copy)]
+#[repr(C)]
+pub struct LockStats {
+    /// Address of the lock word.
+    pub addr: usize,
+    /// Lock acquisitions, including successful `try_lock` calls.
+    pub acquisitions: u64,
+    /// Lock acquisitions that found the lock held, and had to spin or wait.
+    pub contentions: u64,
+    /// System ticks spent waiting: for a held lock, or for a condvar to be signalled.
+    pub wait_ticks: u64,
+    /// `ArbitrateLock` calls.
+    pub arbitrate_lock_count: u64,
+    /// `ArbitrateUnlock` calls.
+    pub arbitrate_unlock_count: u64,
+    /// `WaitProcessWideKeyAtomic` calls.
+    pub wait_key_count: u64,
+    /// `SignalProcessWideKey` calls.
+    pub signal_key_count: u64,
+    /// `WaitForAddress` calls.
+    pub wait_address_count: u64,
+    /// `SignalToAddress` calls.
+    pub signal_address_count: u64,
+}
+
+/// A traced supervisor call.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Svc {
+    ArbitrateLock,
+    ArbitrateUnlock,
+    SignalProcessWideKey,
+    WaitForAddress,
+    SignalToAddress,
+}
+
+/// Counters of a slot of the lock table, one cache line wide so that locks do not share
+/// them.
+#[repr(C, align(64))]
+struct Slot {
+    acquisitions: AtomicU64,
+    contentions: AtomicU64,
+    wait_ticks: AtomicU64,
+    arbitrate_lock_count: AtomicU64,
+    arbitrate_unlock_count: AtomicU64,
+    wait_key_count: AtomicU64,
+    signal_key_count: AtomicU64,
+    wait_address_count: AtomicU64,
+    signal_address_count: AtomicU64,
+}
+
+impl Slot {
+    const fn new() -> Self {
+        Self {
+            acquisitions: AtomicU64::new(0),
+            contentions: AtomicU64::new(0),
+            wait_ticks: AtomicU64::new(0),
+            arbitrate_lock_count: AtomicU64::new(0),
+            arbitrate_unlock_count: AtomicU64::new(0),
+            wait_key_count: AtomicU64::new(0),
+            signal_key_count: AtomicU64::new(0),
+            wait_address_count: AtomicU64::new(0),
+            signal_address_count: AtomicU64::new(0),
+        }
+    }
+
+    fn snapshot(&self, addr: usize) -> LockStats {
+        LockStats {
+            addr,
+            acquisitions: self.acquisitions.load(Ordering::Relaxed),
+            contentions: self.contentions.load(Ordering::Relaxed),
+            wait_ticks: self.wait_ticks.load(Ordering::Relaxed),
+            arbitrate_lock_count: self.arbitrate_lock_count.load(Ordering::Relaxed),
+            arbitrate_unlock_count: self.arbitrate_unlock_count.load(Ordering::Relaxed),
+            wait_key_count: self.wait_key_count.load(Ordering::Relaxed),
+            signal_key_count: self.signal_key_count.load(Ordering::Relaxed),
+            wait_address_count: self.wait_address_count.load(Ordering::Relaxed),
+            signal_address_count: self.signal_address_count.load(Ordering::Relaxed),
+        }
+    }
+
+    fn clear(&self) {
+        self.acquisitions.store(0, Ordering::Relaxed);
+        self.contentions.store(0, Ordering::Relaxed);
+        self.wait_ticks.store(0, Ordering::Relaxed);
+        self.arbitrate_lock_count.store(0, Ordering::Relaxed);
+        self.arbitrate_unlock_count.store(0, Ordering::Relaxed);
+        self.wait_key_count.store(0, Ordering::Relaxed);
+        self.signal_key_count.store(0, Ordering::Relaxed);
+        self.wait_address_count.store(0, Ordering::Relaxed);
+        self.signal_address_count.store(0, Ordering::Relaxed);
+    }
+}
+
+/// Lock table, keyed by the two halves of the address of the lock word.
+static SLOTS: TraceTable<Slot, 2, MAX_LOCKS> = TraceTable::new([const { Slot::new() }; MAX_LOCKS]);
+
+/// Returns the current system tick, to time a wait.
+#[inline]
+pub fn now() -> u64 {
+    // SAFETY: Reading the counter-timer has no side effects.
+    unsafe { control_regs::cntpct_el0() }
+}
+
+/// Records a lock acquisition.
+///
+/// `wait_start` is the tick at which the thread found the lock held, or `None` if it was
+/// acquired right away.
+#[inline]
+pub fn record_acquire(lock: *const u32, wait_start: Option<u64>) {
+    let Some(slot) = slot(lock) else {
+        return;
+    };
+
+    slot.acquisitions.fetch_add(1, Ordering::Relaxed);
+    if let Some(start) = wait_start {
+        slot.contentions.fetch_add(1, Ordering::Relaxed);
+        slot.wait_ticks
+            .fetch_add(now().wrapping_sub(start), Ordering::Relaxed);
+    }
+}
+
+/// Records a condvar wait that started at the `wait_start` tick, and just returned.
+#[inline]
+pub fn record_wait(condvar: *const u32, wait_start: u64) {
+    let Some(slot) = slot(condvar) else {
+        return;
+    };
+
+    slot.wait_key_count.fetch_add(1, Ordering::Relaxed);
+    slot.wait_ticks
+        .fetch_add(now().wrapping_sub(wait_start), Ordering::Relaxed);
+}
+
+/// Records a supervisor call on the lock word `lock`.
+#[inline]
+pub fn record_svc(lock: *const u32, svc: Svc) {
+    let Some(slot) = slot(lock) else {
+        return;
+    };
+
+    let counter = match svc {
+        Svc::ArbitrateLock => &slot.arbitrate_lock_count,
+        Svc::ArbitrateUnlock => &slot.arbitrate_unlock_count,
+        Svc::SignalProcessWideKey => &slot.signal_key_count,
+        Svc::WaitForAddress => &slot.wait_address_count,
+        Svc::SignalToAddress => &slot.signal_address_count,
+    };
+    counter.fetch_add(1, Ordering::Relaxed);
+}
+
+/// Writes the counters of the traced locks with the longest waits to `out`, longest first.
+///
+/// Returns the number of traced locks, which may exceed `out.len()`.
+pub fn snapshot(out: &mut [LockStats]) -> usize {
+    SLOTS.snapshot(
+        out,
+        |[lo, hi], slot| slot.snapshot((u64::from(hi) << 32 | u64::from(lo)) as usize),
+        |stats| stats.wait_ticks,
+    )
+}
+
+/// Returns the number of events lost because no slot was available.
+pub fn dropped() -> u64 {
+    SLOTS.dropped()
+}
+
+/// Clears the table.
+///
+/// Events recorded concurrently may be lost, or land in a cleared slot.
+pub fn reset() {
+    SLOTS.reset(Slot::clear);
+}
+
+/// Returns the slot of `lock`, claiming a free one on its first event.
+#[inline]
+fn slot(lock: *const u32) -> Option<&'static Slot> {
+    let addr = lock.addr() as u64;
+    SLOTS.get([addr as u32, (addr >> 32) as u32])
+}
@@ -0,0 +1,165 @@
+//! # Trace tables
+//!
+//! A fixed, lock-free table of per-key counters, shared by the tracing modules of the
+//! runtime crates: the lock tracing of [`trace`](crate::trace) and the IPC latency tracing
+//! of `nx-sf`.
+//!
+//! A key is `W` words, so that composite keys fit without being hashed down first. Keys
+//! claim a free entry on their first event, by open addressing from their Fibonacci hash,
+//! and keep it until the table is [reset](TraceTable::reset). Events that find no entry are
+//! counted in [`TraceTable::dropped`], and otherwise lost. That includes an event racing
+//! the first event of another key for the same entry: recording never waits on another
+//! thread, which could be preempted while holding up a higher-priority one.
+
+use core::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+
+/// State of a free entry.
+const FREE: u32 = 0;
+/// State of an entry whose key is being written.
+const CLAIMING: u32 = 1;
+/// State of an entry whose key can be read.
+const READY: u32 = 2;
+
+/// The key of an entry, and its claim state.
+struct Key<const W: usize> {
+    state: AtomicU32,
+    words: [AtomicU32; W],
+}
+
+impl<const W: usize> Key<W> {
+    const fn new() -> Self {
+        Self {
+            state: AtomicU32::new(FREE),
+            words: [const { AtomicU32::new(0) }; W],
+        }
+    }
+
+    fn matches(&self, key: &[u32; W]) -> bool {
+        self.words
+            .iter()
+            .zip(key)
+            .all(|(word, key)| word.load(Ordering::Relaxed) == *key)
+    }
+
+    fn load(&self) -> [u32; W] {
+        core::array::from_fn(|i| self.words[i].load(Ordering::Relaxed))
+    }
+}
+
+/// A table of `N` entries of counters `T`, keyed by `W` words.
+///
+/// `N` must be a power of two. `T` is usually a struct of atomic counters, aligned to a
+/// cache line so that entries do not share one.
+pub struct TraceTable<T, const W: usize, const N: usize> {
+    keys: [Key<W>; N],
+    counters: [T; N],
+    dropped: AtomicU64,
+}
+
+impl<T, const W: usize, const N: usize> TraceTable<T, W, N> {
+    /// Creates a table of free entries, with `counters` as their zeroed counters.
+    pub const fn new(counters: [T; N]) -> Self {
+        assert!(N.is_power_of_two());
+        Self {
+            keys: [const { Key::new() }; N],
+            counters,
+            dropped: AtomicU64::new(0),
+        }
+    }
+
+    /// Returns the counters of `key`, claiming a free entry on its first event.
+    ///
+    /// Returns `None`, and counts the event as dropped, if the table is full or the entry
+    /// `key` probes next is being claimed by another thread.
+    #[inline]
+    pub fn get(&self, key: [u32; W]) -> Option<&T> {
+        // Fibonacci hashing of the key
+        let hash = key.iter().fold(0u64, |hash, word| {
+            (hash ^ u64::from(*word)).wrapping_mul(0x9E37_79B9_7F4A_7C15)
+        });
+        let start = (hash >> (u64::BITS - N.trailing_zeros())) as usize;
+
+        for i in 0..N {
+            let index = (start + i) & (N - 1);
+            let entry = &self.keys[index];
+            match entry.state.load(Ordering::Acquire) {
+                READY if entry.matches(&key) => return Some(&self.counters[index]),
+                READY => {}
+                // The key being written may be this one: skip the event rather than wait
+                CLAIMING => break,
+                _ => {
+                    match entry.state.compare_exchange(
+                        FREE,
+                        CLAIMING,
+                        Ordering::Acquire,
+                        Ordering::Acquire,
+                    ) {
+                        Ok(_) => {
+                            for (word, key) in entry.words.iter().zip(&key) {
+                                word.store(*key, Ordering::Relaxed);
+                            }
+                            entry.state.store(READY, Ordering::Release);
+                            return Some(&self.counters[index]);
+                        }
+                        Err(READY) if entry.matches(&key) => return Some(&self.counters[index]),
+                        Err(READY) => {}
+                        Err(_) => break,
+                    }
+                }
+            }
+        }
+
+        self.dropped.fetch_add(1, Ordering::Relaxed);
+        None
+    }
+
+    /// Writes the `stats` of the claimed entries with the highest `weight` to `out`, highest
+    /// first.
+    ///
+    /// Returns the number of claimed entries, which may exceed `out.len()`.
+    pub fn snapshot<S>(
+        &self,
+        out: &mut [S],
+        stats: impl Fn([u32; W], &T) -> S,
+        weight: impl Fn(&S) -> u64,
+    ) -> usize {
+        let mut claimed = 0;
+        let mut len = 0;
+
+        for (key, counters) in self.keys.iter().zip(&self.counters) {
+            if key.state.load(Ordering::Acquire) != READY {
+                continue;
+            }
+            claimed += 1;
+
+            let entry = stats(key.load(), counters);
+            if len < out.len() {
+                out[len] = entry;
+                len += 1;
+            } else if let Some(min) = out.iter_mut().min_by_key(|s| weight(s))
+                && weight(min) < weight(&entry)
+            {
+                *min = entry;
+            }
+        }
+
+        out[..len].sort_unstable_by_key(|s| core::cmp::Reverse(weight(s)));
+        claimed
+    }
+
+    /// Returns the number of events lost because no entry was available.
+    pub fn dropped(&self) -> u64 {
+        self.dropped.load(Ordering::Relaxed)
+    }
+
+    /// Frees every entry, after zeroing its counters with `clear`.
+    ///
+    /// Events recorded concurrently may be lost, or land in a cleared entry.
+    pub fn reset(&self, clear: impl Fn(&T)) {
+        for (key, counters) in self.keys.iter().zip(&self.counters) {
+            clear(counters);
+            key.state.store(FREE, Ordering::Release);
+        }
+        self.dropped.store(0, Ordering::Relaxed);
+    }
+}
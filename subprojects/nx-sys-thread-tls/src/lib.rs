@@ -69,6 +69,7 @@
 //! - Slot IDs are **process-global**: all threads share the same slot ID → data mapping
 //! - Each **thread** has its own copy of the 27 slots in its TLS region
 //! - A process-global bitmask tracks which slot IDs are in use
+//! - Slot 0 is reserved to clear the values of freed slot IDs (see [`slots`])
 //! - Optional *destructor* functions can be registered to run cleanup when a thread exits
 //! - Access is purely arithmetic: `TPIDRRO_EL0 + 0x108 + (slot_id * 8)` — no syscalls needed
 //!
@@ -213,6 +214,7 @@ use static_assertions::const_assert_eq;
 
 #[cfg(feature = "ffi")]
 pub mod ffi;
+pub mod slots;
 
 /// Size of the Thread Local Storage (TLS) region in bytes.
 ///
@@ -0,0 +1,264 @@
+//! # Dynamic TLS slot IDs
+//!
+//! Process-global allocation of the [`NUM_TLS_SLOTS`] dynamic TLS slot IDs.
+//!
+//! A slot ID is shared by every thread in the process, while each thread holds its own
+//! value for that ID in its TLS region (see [`slots_ptr()`]). Allocation state is a single
+//! atomic bitmask, so reserving and releasing IDs never blocks.
+//!
+//! IDs are handed out from the highest slot downward. When the `nx-sys-thread` overrides
+//! are linked, libnx's `threadTlsAlloc` allocates from this same mask.
+//!
+//! Slot [`EPOCH_SLOT`] is reserved: each thread keeps in it the free epoch it last synced
+//! with. Freeing an ID bumps the process-global epoch and records it as the free epoch of
+//! the ID. When a thread sees the epoch moved past its own on [`get()`] or [`set()`], it
+//! clears its values of the IDs freed since, before touching the slot. A value stored
+//! before its ID was freed thus reads as null once the ID is reused, on every thread,
+//! while values are stored verbatim and no thread ever writes the TLS region of another.
+//! As long as no ID is freed, checking the epoch costs one load and one TLS read.
+//!
+//! A slot may be given a destructor with [`alloc_with_destructor()`]. When a thread exits,
+//! [`run_destructors()`] calls it on the thread's non-null value of the slot, as
+//! `pthread_key_create` destructors do. Destructors run for threads exiting through
+//! `nx-sys-thread`, which also overrides libnx's `threadExit`.
+
+use core::{
+    ffi::c_void,
+    mem, ptr,
+    sync::atomic::{AtomicU32, AtomicUsize, Ordering},
+};
+
+use crate::{NUM_TLS_SLOTS, slots_ptr};
+
+/// Slot holding the free epoch each thread last synced with, never handed out.
+///
+/// The lowest ID, as IDs are allocated from the highest one down. The kernel hands out
+/// TLS regions zeroed, so a new thread starts at epoch 0.
+pub const EPOCH_SLOT: usize = 0;
+
+/// Bitmask of slot IDs currently in use (bit `n` set = slot `n` allocated).
+static USAGE_MASK: AtomicU32 = AtomicU32::new(0);
+
+/// Mask with one bit set for every slot ID that can be allocated.
+const VALID_SLOTS_MASK: u32 = ((1 << NUM_TLS_SLOTS) - 1) & !(1 << EPOCH_SLOT);
+
+/// Number of slot IDs freed so far in the process.
+static EPOCH: AtomicUsize = AtomicUsize::new(0);
+
+/// Value of [`EPOCH`] when each slot ID was last freed (0 = never).
+static FREED_AT: [AtomicUsize; NUM_TLS_SLOTS] = [const { AtomicUsize::new(0) }; NUM_TLS_SLOTS];
+
+/// Destructor of each slot ID, as a [`Destructor`] address (0 = none).
+static DESTRUCTORS: [AtomicUsize; NUM_TLS_SLOTS] = [const { AtomicUsize::new(0) }; NUM_TLS_SLOTS];
+
+/// Maximum number of passes of [`run_destructors()`] over the slots.
+///
+/// A destructor may store a new value in a slot; such values are destroyed by the next
+/// pass, up to this limit (`PTHREAD_DESTRUCTOR_ITERATIONS` in POSIX).
+pub const DESTRUCTOR_ITERATIONS: usize = 4;
+
+/// Destructor of a slot value, called on thread exit with the thread's non-null value.
+pub type Destructor = unsafe extern "C" fn(value: *mut c_void);
+
+/// Reserves a free dynamic TLS slot ID.
+///
+/// Returns `None` if all the slots but [`EPOCH_SLOT`] are in use. The slot reads as null
+/// on every thread until it stores a value in it.
+pub fn alloc() -> Option<usize> {
+    let mut mask = USAGE_MASK.load(Ordering::Relaxed);
+    loop {
+        let free = !mask & VALID_SLOTS_MASK;
+        if free == 0 {
+            return None;
+        }
+
+        // Highest free slot ID
+        let id = (u32::BITS - 1 - free.leading_zeros()) as usize;
+        match USAGE_MASK.compare_exchange_weak(
+            mask,
+            mask | (1 << id),
+            Ordering::AcqRel,
+            Ordering::Relaxed,
+        ) {
+            Ok(_) => return Some(id),
+            Err(current) => mask = current,
+        }
+    }
+}
+
+/// Reserves a free dynamic TLS slot ID, whose non-null values are passed to `destructor`
+/// when their thread exits.
+///
+/// Returns `None` if all the slots but [`EPOCH_SLOT`] are in use. The destructor runs for threads
+/// exiting through `nx-sys-thread`, including libnx's overridden `threadExit`.
+pub fn alloc_with_destructor(destructor: Option<Destructor>) -> Option<usize> {
+    let id = alloc()?;
+    let addr = destructor.map_or(0, |dtor| dtor as usize);
+    DESTRUCTORS[id].store(addr, Ordering::Release);
+    Some(id)
+}
+
+/// Releases a slot ID previously returned by [`alloc()`] or [`alloc_with_destructor()`].
+///
+/// The destructor of the slot is not called on the values still stored in it, which the
+/// next owner of the ID reads as null.
+///
+/// # Safety
+///
+/// - `id` must have been returned by [`alloc()`] and not released since
+/// - No thread may access the slot through `id` after this call
+pub unsafe fn free(id: usize) {
+    debug_assert!(id < NUM_TLS_SLOTS, "TLS slot ID out of range");
+    DESTRUCTORS[id].store(0, Ordering::Relaxed);
+
+    // The free epoch of the ID is recorded before the epoch is published, so that a thread
+    // seeing the new epoch also clears the ID. A thread syncing with an epoch bumped by a
+    // concurrent free may clear the ID early, which is harmless as no one uses it anymore.
+    let mut epoch = EPOCH.load(Ordering::Relaxed);
+    loop {
+        FREED_AT[id].store(epoch + 1, Ordering::Relaxed);
+        match EPOCH.compare_exchange_weak(epoch, epoch + 1, Ordering::Release, Ordering::Relaxed) {
+            Ok(_) => break,
+            Err(current) => epoch = current,
+        }
+    }
+
+    // Released after the epoch bump, so that its next owner clears the stale values
+    USAGE_MASK.fetch_and(!(1 << id), Ordering::AcqRel);
+}
+
+/// Calls the destructors of the allocated slots on the current thread's non-null values.
+///
+/// Each value is cleared before its destructor runs. Values stored by the destructors
+/// themselves are destroyed in further passes, up to [`DESTRUCTOR_ITERATIONS`].
+///
+/// # Safety
+///
+/// Must only be called by an exiting thread, once its code no longer uses the slots.
+pub unsafe fn run_destructors() {
+    for _ in 0..DESTRUCTOR_ITERATIONS {
+        let mut ran = false;
+
+        let mut mask = USAGE_MASK.load(Ordering::Acquire);
+        while mask != 0 {
+            let id = mask.trailing_zeros() as usize;
+            mask &= mask - 1;
+
+            let addr = DESTRUCTORS[id].load(Ordering::Acquire);
+            let value = get(id);
+            if addr == 0 || value.is_null() {
+                continue;
+            }
+
+            // SAFETY: The slot is allocated, and the exiting thread owns its value.
+            unsafe { set(id, ptr::null_mut()) };
+
+            // SAFETY: `addr` was stored from a `Destructor` by `alloc_with_destructor`.
+            let destructor = unsafe { mem::transmute::<usize, Destructor>(addr) };
+            // SAFETY: The destructor was registered for the values of this slot.
+            unsafe { destructor(value) };
+            ran = true;
+        }
+
+        if !ran {
+            break;
+        }
+    }
+}
+
+/// Returns `true` if the slot ID is currently allocated.
+pub fn is_allocated(id: usize) -> bool {
+    id < NUM_TLS_SLOTS && USAGE_MASK.load(Ordering::Acquire) & (1 << id) != 0
+}
+
+/// Reads the current thread's value for slot `id`.
+///
+/// Returns null if the thread stored no value in the slot since `id` was allocated.
+///
+/// # Panics
+///
+/// Panics if `id` is [`EPOCH_SLOT`] or not below [`NUM_TLS_SLOTS`].
+#[inline]
+pub fn get(id: usize) -> *mut c_void {
+    assert!(
+        id != EPOCH_SLOT && id < NUM_TLS_SLOTS,
+        "TLS slot ID out of range"
+    );
+
+    // SAFETY: `slots_ptr()` points to the current thread's slot array of NUM_TLS_SLOTS
+    // entries and `id` was bounds-checked above.
+    let value = unsafe { slots_ptr().add(id).read_volatile() };
+    if value.is_null() || !sync_epoch() {
+        return value;
+    }
+
+    // SAFETY: As above.
+    unsafe { slots_ptr().add(id).read_volatile() }
+}
+
+/// Writes the current thread's value for slot `id`.
+///
+/// # Safety
+///
+/// - `id` must be an allocated slot ID owned by the caller
+/// - Any previous value stored in the slot must not be leaked by overwriting it
+///
+/// # Panics
+///
+/// Panics if `id` is [`EPOCH_SLOT`] or not below [`NUM_TLS_SLOTS`].
+#[inline]
+pub unsafe fn set(id: usize, value: *mut c_void) {
+    assert!(
+        id != EPOCH_SLOT && id < NUM_TLS_SLOTS,
+        "TLS slot ID out of range"
+    );
+
+    // Synced first, so that a later sync does not take the value for a stale one
+    sync_epoch();
+
+    // SAFETY: `slots_ptr()` points to the current thread's slot array of NUM_TLS_SLOTS
+    // entries and `id` was bounds-checked above.
+    unsafe { slots_ptr().add(id).write_volatile(value) }
+}
+
+/// Clears the current thread's values of the slot IDs freed since it last synced with
+/// [`EPOCH`].
+///
+/// Returns `true` if the thread was behind and values may have been cleared.
+#[inline]
+fn sync_epoch() -> bool {
+    // Acquire: pairs with `free`, so that the free epochs up to `epoch` are visible
+    let epoch = EPOCH.load(Ordering::Acquire);
+
+    let slots = slots_ptr();
+    // SAFETY: `slots_ptr()` points to the current thread's slot array, which holds
+    // EPOCH_SLOT.
+    let synced = unsafe { slots.add(EPOCH_SLOT).read_volatile() } as usize;
+    if synced == epoch {
+        return false;
+    }
+
+    sync_epoch_slow(synced, epoch);
+    true
+}
+
+/// Clears the current thread's values of the slot IDs freed after epoch `synced`, then
+/// records `epoch` as synced.
+#[cold]
+fn sync_epoch_slow(synced: usize, epoch: usize) {
+    let slots = slots_ptr();
+    for id in (0..NUM_TLS_SLOTS).filter(|&id| id != EPOCH_SLOT) {
+        if FREED_AT[id].load(Ordering::Relaxed) > synced {
+            // SAFETY: `slots_ptr()` points to the current thread's slot array of
+            // NUM_TLS_SLOTS entries, only written by this thread.
+            unsafe { slots.add(id).write_volatile(ptr::null_mut()) };
+        }
+    }
+
+    // SAFETY: As above.
+    unsafe {
+        slots
+            .add(EPOCH_SLOT)
+            .write_volatile(ptr::without_provenance_mut(epoch))
+    };
+}
@@ -41,3 +41,82 @@ ThreadVars* __nx_sys_thread_get_thread_vars(void);
  * @return The current thread handle.
  */
 uint32_t __nx_sys_thread_get_current_thread_handle(void);
+
+struct Thread;
+
+/**
+ * @brief Sets the preferred core and the affinity mask of a thread.
+ * @param t Thread information structure.
+ * @param core_id Preferred core, -1 for none, -2 for the process default, -3 to keep the current one.
+ * @param affinity_mask Mask of the cores the thread may run on.
+ * @return Result code.
+ */
+uint32_t __nx_sys_thread__thread_set_core_mask(const struct Thread* t, int32_t core_id, uint32_t affinity_mask);
+
+/**
+ * @brief Gets the preferred core and the affinity mask of a thread.
+ * @param t Thread information structure.
+ * @param[out] core_id Preferred core, -1 for none.
+ * @param[out] affinity_mask Mask of the cores the thread may run on.
+ * @return Result code.
+ */
+uint32_t __nx_sys_thread__thread_get_core_mask(const struct Thread* t, int32_t* core_id, uint32_t* affinity_mask);
+
+/**
+ * @brief Sets the priority of a thread.
+ * @param t Thread information structure.
+ * @param priority Priority, 0x00 (highest) to 0x3F (lowest).
+ * @return Result code.
+ */
+uint32_t __nx_sys_thread__thread_set_priority(const struct Thread* t, uint32_t priority);
+
+/**
+ * @brief Gets the priority of a thread.
+ * @param t Thread information structure.
+ * @param[out] priority Priority, 0x00 (highest) to 0x3F (lowest).
+ * @return Result code.
+ */
+uint32_t __nx_sys_thread__thread_get_priority(const struct Thread* t, int32_t* priority);
+
+/**
+ * @brief Gets the CPU time consumed by a thread on all cores.
+ * @param t Thread information structure.
+ * @param[out] out CPU time, in nanoseconds.
+ * @return Result code.
+ */
+uint32_t __nx_sys_thread__thread_get_cpu_time(const struct Thread* t, uint64_t* out);
+
+/**
+ * @brief Exits the calling thread, running its TLS slot destructors and releasing its per-thread caches.
+ * @note Overrides libnx's threadExit, which libnx threads also run when their entry function returns.
+ */
+void __nx_sys_thread__thread_exit(void) __attribute__((noreturn));
+
+/**
+ * @brief Allocates a dynamic TLS slot.
+ * @param destructor Function called with a thread's non-NULL value of the slot when the thread exits, or NULL.
+ * @note Destructors run for threads exiting through nx-sys-thread, including libnx's overridden threadExit.
+ * @return Slot ID, or -1 if all the slots are in use.
+ */
+int32_t __nx_sys_thread__thread_tls_alloc(void (*destructor)(void*));
+
+/**
+ * @brief Frees a dynamic TLS slot.
+ * @param slot_id Slot ID returned by __nx_sys_thread__thread_tls_alloc.
+ * @note Values still stored in the slot by any thread read as NULL once the slot is reused.
+ */
+void __nx_sys_thread__thread_tls_free(int32_t slot_id);
+
+/**
+ * @brief Gets the current thread's value of a dynamic TLS slot.
+ * @param slot_id Slot ID.
+ * @return Value, or NULL if none was stored since the slot was allocated.
+ */
+void* __nx_sys_thread__thread_tls_get(int32_t slot_id);
+
+/**
+ * @brief Sets the current thread's value of a dynamic TLS slot.
+ * @param slot_id Slot ID.
+ * @param value Value, stored verbatim.
+ */
+void __nx_sys_thread__thread_tls_set(int32_t slot_id, void* value);
@@ -8,5 +8,6 @@ mod slots;
 mod thread_activity;
 mod thread_context;
 mod thread_info;
+mod thread_sched;
 mod thread_wait;
 mod tls;
@@ -1,24 +1,58 @@
 use core::{ffi::c_void, ptr};
 
-/// Reads the raw pointer stored in the dynamic TLS slot `slot_id`.
+use crate::tls_region::{NUM_TLS_SLOTS, slots};
+
+/// Reserves a dynamic TLS slot, whose non-null values are passed to `destructor` when
+/// their thread exits.
+///
+/// Mirrors `threadTlsAlloc` in libnx's C API. Returns the slot ID, or -1 if all the
+/// slots are in use. The destructor runs for threads exiting through `nx-sys-thread`,
+/// which also overrides libnx's `threadExit`.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_sys_thread__thread_tls_alloc(
+    destructor: Option<slots::Destructor>,
+) -> i32 {
+    slots::alloc_with_destructor(destructor).map_or(-1, |id| id as i32)
+}
+
+/// Releases the dynamic TLS slot `slot_id`.
+///
+/// Mirrors `threadTlsFree` in libnx's C API. The values other threads still store in the
+/// slot read as NULL once it is reused.
 ///
-/// Mirrors `threadTlsGet` in libnx's C API.
+/// # Safety
 ///
-/// TODO: Add support for dynamic TLS slots
-/// Currently returns NULL for all slot IDs as dynamic slots are not implemented.
+/// `slot_id` must have been returned by `__nx_sys_thread__thread_tls_alloc` and not be
+/// used by any thread afterwards.
 #[unsafe(no_mangle)]
-unsafe extern "C" fn __nx_sys_thread__thread_tls_get(_slot_id: i32) -> *mut c_void {
-    // Dynamic TLS slots not supported - always return NULL
-    ptr::null_mut()
+unsafe extern "C" fn __nx_sys_thread__thread_tls_free(slot_id: i32) {
+    if slots::is_allocated(slot_id as usize) {
+        // SAFETY: The caller gives up the slot.
+        unsafe { slots::free(slot_id as usize) };
+    }
 }
 
-/// Writes `value` into dynamic TLS slot `slot_id`.
+/// Reads the raw pointer stored in the dynamic TLS slot `slot_id`.
 ///
-/// Mirrors `threadTlsSet` in libnx's C API.
+/// Mirrors `threadTlsGet` in libnx's C API. Returns NULL for out of range slot IDs and
+/// the reserved epoch slot.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn __nx_sys_thread__thread_tls_get(slot_id: i32) -> *mut c_void {
+    match usize::try_from(slot_id) {
+        Ok(id) if id != slots::EPOCH_SLOT && id < NUM_TLS_SLOTS => slots::get(id),
+        _ => ptr::null_mut(),
+    }
+}
+
+/// Writes `value` into dynamic TLS slot `slot_id`.
 ///
-/// TODO: Add support for dynamic TLS slots
-/// Currently does nothing as dynamic slots are not implemented.
+/// Mirrors `threadTlsSet` in libnx's C API. Out of range slot IDs and the
+/// reserved epoch slot are ignored.
 #[unsafe(no_mangle)]
-unsafe extern "C" fn __nx_sys_thread__thread_tls_set(_slot_id: i32, _value: *mut c_void) {
-    // Dynamic TLS slots not supported - silently ignore
+unsafe extern "C" fn __nx_sys_thread__thread_tls_set(slot_id: i32, value: *mut c_void) {
+    match usize::try_from(slot_id) {
+        // SAFETY: The caller owns the slot, as `threadTlsSet` requires.
+        Ok(id) if id != slots::EPOCH_SLOT && id < NUM_TLS_SLOTS => unsafe { slots::set(id, value) },
+        _ => {}
+    }
 }
@@ -42,3 +42,18 @@ pub unsafe extern "C" fn __nx_sys_thread__thread_resume(t: *const sys::Thread) -
 
     sys::resume(thread).map_or_else(|err| err.to_rc(), |_| 0)
 }
+
+/// Exits the calling thread.
+///
+/// Overrides libnx's `threadExit`, which libnx threads also run once their entry function
+/// returns, so that every thread runs its TLS slot destructors and gives its RNG and
+/// allocator cache back before terminating.
+///
+/// # Safety
+///
+/// Must be called on the exiting thread, once its code no longer uses its TLS slots.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_thread__thread_exit() -> ! {
+    // SAFETY: The caller guarantees this is the exiting thread.
+    unsafe { sys::exit_current() }
+}
@@ -0,0 +1,130 @@
+//! FFI bindings for the thread scheduling API.
+
+use nx_svc::{error::ToRawResultCode, thread::RawCoreAffinity};
+
+use crate::thread_impl as sys;
+
+/// Sets the preferred core and the affinity mask of a thread.
+///
+/// `core_id` is a core number, `-1` for no preferred core, `-2` for the process's default
+/// core or `-3` to keep the current preferred core, as for `svcSetThreadCoreMask`.
+///
+/// # Safety
+///
+/// The caller must ensure that `t` points to a valid [`Thread`] instance.
+///
+/// [`Thread`]: sys::Thread
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_thread__thread_set_core_mask(
+    t: *const sys::Thread,
+    core_id: i32,
+    affinity_mask: u32,
+) -> u32 {
+    // SAFETY: The caller must ensure that `t` is non-null.
+    let thread = unsafe { &*t };
+
+    let affinity = RawCoreAffinity::new_unchecked(core_id, affinity_mask);
+    sys::set_core_mask(thread, affinity).map_or_else(|err| err.to_rc(), |_| 0)
+}
+
+/// Gets the preferred core and the affinity mask of a thread.
+///
+/// A preferred core of `-1` means the thread has none.
+///
+/// # Safety
+///
+/// The caller must ensure that `t` points to a valid [`Thread`] instance, and that
+/// `core_id` and `affinity_mask` are valid for writes.
+///
+/// [`Thread`]: sys::Thread
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_thread__thread_get_core_mask(
+    t: *const sys::Thread,
+    core_id: *mut i32,
+    affinity_mask: *mut u32,
+) -> u32 {
+    // SAFETY: The caller must ensure that `t` is non-null.
+    let thread = unsafe { &*t };
+
+    match sys::get_core_mask(thread) {
+        Ok((core, mask)) => {
+            // SAFETY: The caller must ensure that the output pointers are valid.
+            unsafe {
+                core_id.write(core.map_or(-1, i32::from));
+                affinity_mask.write(mask.bits());
+            }
+            0
+        }
+        Err(err) => err.to_rc(),
+    }
+}
+
+/// Sets the priority of a thread.
+///
+/// # Safety
+///
+/// The caller must ensure that `t` points to a valid [`Thread`] instance.
+///
+/// [`Thread`]: sys::Thread
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_thread__thread_set_priority(
+    t: *const sys::Thread,
+    priority: u32,
+) -> u32 {
+    // SAFETY: The caller must ensure that `t` is non-null.
+    let thread = unsafe { &*t };
+
+    sys::set_priority(thread, priority).map_or_else(|err| err.to_rc(), |_| 0)
+}
+
+/// Gets the priority of a thread.
+///
+/// # Safety
+///
+/// The caller must ensure that `t` points to a valid [`Thread`] instance, and that
+/// `priority` is valid for writes.
+///
+/// [`Thread`]: sys::Thread
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_thread__thread_get_priority(
+    t: *const sys::Thread,
+    priority: *mut i32,
+) -> u32 {
+    // SAFETY: The caller must ensure that `t` is non-null.
+    let thread = unsafe { &*t };
+
+    match sys::get_priority(thread) {
+        Ok(prio) => {
+            // SAFETY: The caller must ensure that `priority` is valid.
+            unsafe { priority.write(prio) };
+            0
+        }
+        Err(err) => err.to_rc(),
+    }
+}
+
+/// Gets the CPU time consumed by a thread on all cores, in nanoseconds.
+///
+/// # Safety
+///
+/// The caller must ensure that `t` points to a valid [`Thread`] instance, and that `out`
+/// is valid for writes.
+///
+/// [`Thread`]: sys::Thread
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_sys_thread__thread_get_cpu_time(
+    t: *const sys::Thread,
+    out: *mut u64,
+) -> u32 {
+    // SAFETY: The caller must ensure that `t` is non-null.
+    let thread = unsafe { &*t };
+
+    match sys::get_cpu_time(thread) {
+        Ok(time) => {
+            // SAFETY: The caller must ensure that `out` is valid.
+            unsafe { out.write(time.as_nanos().min(u64::MAX as u128) as u64) };
+            0
+        }
+        Err(err) => err.to_rc(),
+    }
+}
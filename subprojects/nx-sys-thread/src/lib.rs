@@ -7,6 +7,8 @@ extern crate nx_panic_handler; // provides #[panic_handler]
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
+pub mod local_key;
+pub mod registry;
 mod thread_impl;
 pub mod tls_block;
 
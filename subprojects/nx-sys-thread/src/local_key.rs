@@ -0,0 +1,109 @@
+//! Thread-local values backed by the dynamic TLS slots
+//!
+//! A [`LocalKey`] is the `thread_local!` of this runtime: each thread gets its own value,
+//! created on first access and dropped when the thread exits. The key reserves one of the
+//! dynamic TLS slots on first use, so an access is a `TPIDRRO_EL0`-relative load, without
+//! locks or syscalls.
+//!
+//! ```ignore
+//! use core::cell::Cell;
+//!
+//! use nx_sys_thread::local_key::LocalKey;
+//!
+//! static COUNTER: LocalKey<Cell<u32>> = LocalKey::new(|| Cell::new(0));
+//!
+//! COUNTER.with(|counter| counter.set(counter.get() + 1));
+//! ```
+
+use alloc::boxed::Box;
+use core::{
+    ffi::c_void,
+    sync::atomic::{AtomicUsize, Ordering},
+};
+
+use crate::tls_region::slots;
+
+/// Marker of a key whose slot is not reserved yet.
+const SLOT_UNRESERVED: usize = 0;
+
+/// A key to a lazily initialized, per-thread value.
+///
+/// Values are boxed the first time a thread accesses the key, and dropped by the slot
+/// destructors when the thread exits.
+pub struct LocalKey<T: 'static> {
+    /// Slot ID plus one, or [`SLOT_UNRESERVED`].
+    slot: AtomicUsize,
+    init: fn() -> T,
+}
+
+impl<T: 'static> LocalKey<T> {
+    /// Creates a key whose per-thread values are created by `init`.
+    pub const fn new(init: fn() -> T) -> Self {
+        Self {
+            slot: AtomicUsize::new(SLOT_UNRESERVED),
+            init,
+        }
+    }
+
+    /// Runs `f` with the current thread's value, creating it if needed.
+    ///
+    /// # Panics
+    ///
+    /// Panics if all the dynamic TLS slots are in use.
+    pub fn with<R>(&'static self, f: impl FnOnce(&T) -> R) -> R {
+        self.try_with(f)
+            .expect("no dynamic TLS slot left for the LocalKey")
+    }
+
+    /// Runs `f` with the current thread's value, creating it if needed.
+    ///
+    /// Returns [`AccessError`] if all the dynamic TLS slots are in use.
+    pub fn try_with<R>(&'static self, f: impl FnOnce(&T) -> R) -> Result<R, AccessError> {
+        let slot_id = self.slot_id()?;
+
+        let mut value = slots::get(slot_id).cast::<T>();
+        if value.is_null() {
+            value = Box::into_raw(Box::new((self.init)()));
+            // SAFETY: The slot is owned by this key, and was empty for this thread.
+            unsafe { slots::set(slot_id, value.cast()) };
+        }
+
+        // SAFETY: The value lives until this thread exits, and is only accessed by it.
+        Ok(f(unsafe { &*value }))
+    }
+
+    /// Returns the slot ID of the key, reserving one on first use.
+    fn slot_id(&self) -> Result<usize, AccessError> {
+        match self.slot.load(Ordering::Acquire) {
+            SLOT_UNRESERVED => {}
+            slot => return Ok(slot - 1),
+        }
+
+        let slot_id = slots::alloc_with_destructor(Some(drop_value::<T>)).ok_or(AccessError)?;
+        match self.slot.compare_exchange(
+            SLOT_UNRESERVED,
+            slot_id + 1,
+            Ordering::AcqRel,
+            Ordering::Acquire,
+        ) {
+            Ok(_) => Ok(slot_id),
+            Err(slot) => {
+                // Another thread reserved the key's slot first
+                // SAFETY: The slot was allocated above and never published.
+                unsafe { slots::free(slot_id) };
+                Ok(slot - 1)
+            }
+        }
+    }
+}
+
+/// Slot destructor dropping a boxed `T`.
+unsafe extern "C" fn drop_value<T>(value: *mut c_void) {
+    // SAFETY: `LocalKey<T>` only stores boxed `T` values in its slot.
+    drop(unsafe { Box::from_raw(value.cast::<T>()) });
+}
+
+/// Error returned by [`LocalKey::try_with`] when no dynamic TLS slot is left.
+#[derive(Debug, thiserror::Error)]
+#[error("no dynamic TLS slot left")]
+pub struct AccessError;
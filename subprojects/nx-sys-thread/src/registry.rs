@@ -0,0 +1,139 @@
+//! # Thread registry
+//!
+//! The registry tracks the kernel handle of every thread alive in the current
+//! process, in a fixed, lock-free table of [`MAX_THREADS`] slots.
+//!
+//! • **Storage** – Threads are _not_ linked into the table, so that neither
+//!   the C ABI of [`Thread`](crate::Thread) nor its stack buffer type leak into
+//!   the registry: every slot holds a raw thread handle, `0` if the slot is free.
+//!
+//! • **Insertion** – [`insert`] claims the first free slot with a single
+//!   compare-and-swap per slot. It never waits on other threads, and takes at
+//!   most [`MAX_THREADS`] steps.
+//!
+//! • **Iteration** – [`for_each`] pins every slot while it hands its handle to
+//!   the closure. [`remove`] clears the slot, then waits for the iterations
+//!   pinning it to move on, so that a handle seen by a closure stays open until
+//!   that closure returns, as long as it is removed before being closed.
+//!
+//! A slot is pinned only for the duration of one closure call: iterating does
+//! not stall insertions, and only stalls the removal of the handle being
+//! visited.
+//!
+//! Threads are inserted when started through this crate, and removed when they
+//! exit through it or once another thread waited for their exit. A thread
+//! started while the table is full is not tracked.
+
+use core::sync::atomic::{AtomicU32, Ordering};
+
+use nx_svc::{raw::INVALID_HANDLE, thread::Handle};
+
+/// Number of threads the registry tracks at once.
+pub const MAX_THREADS: usize = 256;
+
+/// Interval between the checks of [`remove`] for iterations pinning its slot.
+const UNPIN_POLL_NS: u64 = 1_000;
+
+/// A slot of the thread table, one cache line wide so that pins of neighbouring
+/// slots do not contend.
+#[repr(C, align(64))]
+struct Slot {
+    /// Raw thread handle, [`INVALID_HANDLE`] if the slot is free.
+    handle: AtomicU32,
+    /// Number of [`for_each`] calls visiting the slot.
+    pins: AtomicU32,
+}
+
+impl Slot {
+    const fn new() -> Self {
+        Self {
+            handle: AtomicU32::new(INVALID_HANDLE),
+            pins: AtomicU32::new(0),
+        }
+    }
+}
+
+static SLOTS: [Slot; MAX_THREADS] = [const { Slot::new() }; MAX_THREADS];
+
+/// Registers the thread `handle`.
+///
+/// Registering an already registered thread is a no-op. Returns an error if
+/// [`MAX_THREADS`] threads are already registered.
+pub fn insert(handle: Handle) -> Result<(), RegistryFullError> {
+    let raw = handle.to_raw();
+    if SLOTS
+        .iter()
+        .any(|slot| slot.handle.load(Ordering::Relaxed) == raw)
+    {
+        return Ok(());
+    }
+    for slot in &SLOTS {
+        if slot.handle.load(Ordering::Relaxed) == INVALID_HANDLE
+            && slot
+                .handle
+                .compare_exchange(INVALID_HANDLE, raw, Ordering::SeqCst, Ordering::Relaxed)
+                .is_ok()
+        {
+            return Ok(());
+        }
+    }
+    Err(RegistryFullError)
+}
+
+/// Unregisters the thread `handle`, returning `false` if it was not registered.
+///
+/// Once this returns, no [`for_each`] closure is visiting `handle`: the handle can
+/// then be closed.
+pub fn remove(handle: Handle) -> bool {
+    let raw = handle.to_raw();
+    let Some(slot) = SLOTS
+        .iter()
+        .find(|slot| slot.handle.load(Ordering::Relaxed) == raw)
+    else {
+        return false;
+    };
+
+    if slot
+        .handle
+        .compare_exchange(raw, INVALID_HANDLE, Ordering::SeqCst, Ordering::Relaxed)
+        .is_err()
+    {
+        return false;
+    }
+
+    // Sleep rather than yield: the iteration may run on a lower-priority thread
+    while slot.pins.load(Ordering::SeqCst) != 0 {
+        nx_svc::thread::sleep(UNPIN_POLL_NS);
+    }
+    true
+}
+
+/// Calls `f` with the handle of every registered thread.
+///
+/// Threads registered or unregistered during the iteration may or may not be
+/// visited. A visited handle is not unregistered before `f` returns.
+pub fn for_each(mut f: impl FnMut(Handle)) {
+    for slot in &SLOTS {
+        // Pin before loading the handle: either `remove` sees the pin and waits, or
+        // this sees the cleared slot
+        slot.pins.fetch_add(1, Ordering::SeqCst);
+        let raw = slot.handle.load(Ordering::SeqCst);
+        if let Some(handle) = Handle::new(raw) {
+            f(handle);
+        }
+        slot.pins.fetch_sub(1, Ordering::Release);
+    }
+}
+
+/// Returns the number of registered threads.
+pub fn len() -> usize {
+    SLOTS
+        .iter()
+        .filter(|slot| slot.handle.load(Ordering::Relaxed) != INVALID_HANDLE)
+        .count()
+}
+
+/// Error returned by [`insert`] when the registry is full.
+#[derive(Debug, thiserror::Error)]
+#[error("thread registry full")]
+pub struct RegistryFullError;
@@ -6,6 +6,8 @@ mod activity;
 mod context;
 mod exit;
 mod handle;
+pub mod pool;
+mod sched;
 mod sleep;
 mod stackmem;
 mod wait;
@@ -14,6 +16,7 @@ pub use activity::*;
 pub use context::*;
 pub use exit::*;
 pub use handle::*;
+pub use sched::*;
 pub use sleep::*;
 pub use stackmem::*;
 pub use wait::*;
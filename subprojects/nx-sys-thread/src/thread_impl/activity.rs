@@ -27,6 +27,7 @@
 use nx_svc::{result::Error, thread as svc};
 
 use super::handle::Thread;
+use crate::registry;
 
 /// Starts execution of the given [`Thread`].
 ///
@@ -35,7 +36,12 @@ use super::handle::Thread;
 /// and results in a no-op. Internally this wraps the kernel
 /// `svcStartThread` call.
 pub fn start(thread: &Thread) -> Result<(), ThreadStartError> {
-    svc::start(thread.handle).map_err(Into::into)
+    // Registered before it runs, so that a thread exiting right away finds its slot
+    let _ = registry::insert(thread.handle);
+    svc::start(thread.handle).map_err(|err| {
+        registry::remove(thread.handle);
+        err.into()
+    })
 }
 
 /// Error type for [`start`].
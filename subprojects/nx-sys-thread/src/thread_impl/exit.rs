@@ -2,35 +2,57 @@
 //!
 //! This module provides the thread exit functionality.
 
-use nx_svc::thread as svc;
+use nx_svc::thread::{self as svc, Handle};
 
-use super::handle::Thread;
+use super::handle::{Thread, get_current_thread_handle};
+use crate::{registry, tls_region::slots};
 
 /// Exits the current thread.
 ///
+/// See [`exit_current`] for the cleanup performed before the thread terminates.
+///
+/// # Safety
+/// This function must only be called by the thread that is exiting.
+/// The thread parameter must be a valid pointer to the current thread's info structure.
+pub unsafe fn exit(thread: &mut Thread) -> ! {
+    // SAFETY: The caller guarantees this is the exiting thread.
+    unsafe { exit_thread(thread.handle) }
+}
+
+/// Exits the current thread, whichever API created it.
+///
 /// This function performs cleanup operations and terminates the thread:
-/// - Runs TLS slot destructors (when slots support is reimplemented)
+/// - Runs TLS slot destructors, which also release the thread's RNG back to the nx-rand
+///   pool
 /// - Removes the thread from the global registry
-/// - Clears pointer fields to catch use-after-free bugs
+/// - Returns the thread's cached allocator blocks to the global heap
 /// - Terminates the thread via svcExitThread (never returns)
 ///
+/// The allocator cache is flushed last, as every earlier step may still allocate and
+/// would re-create it.
+///
 /// # Safety
-/// This function must only be called by the thread that is exiting.
-/// The thread parameter must be a valid pointer to the current thread's info structure.
-pub unsafe fn exit(_thread: &mut Thread) -> ! {
-    // TODO: Reimplement TLS slots destructors
-    // SAFETY: Called on the current thread.
-    // unsafe { slots::run_destructors() };
-
-    // TODO: Reimplement thread registry functionality
-    // Remove thread from the global registry
-    // SAFETY: `thread` was previously inserted during creation; removing it
-    // now is valid and ensures the registry is kept consistent.
-    // unsafe { registry::remove(thread) };
-
-    // TODO: Reimplement TLS slots cleanup
-    // Clear pointer fields to catch use-after-free bugs in debug builds.
-    // thread.tls_slots = None;
+/// This function must only be called by the thread that is exiting, once its code no
+/// longer uses its TLS slots.
+pub unsafe fn exit_current() -> ! {
+    // SAFETY: The caller guarantees this is the exiting thread.
+    unsafe { exit_thread(get_current_thread_handle()) }
+}
+
+/// Cleans up and terminates the current thread, whose handle is `handle`.
+///
+/// # Safety
+/// See [`exit_current`].
+unsafe fn exit_thread(handle: Handle) -> ! {
+    // Run the destructors of the dynamic TLS slots
+    // SAFETY: Called on the exiting thread.
+    unsafe { slots::run_destructors() };
+
+    // Remove thread from the global registry, while its handle is still open
+    registry::remove(handle);
+
+    // Return this thread's allocator cache to the global heap
+    nx_alloc::global::flush_thread_cache();
 
     // Terminate the thread via svcExitThread (never returns)
     svc::exit();
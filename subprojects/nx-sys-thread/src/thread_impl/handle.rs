@@ -12,15 +12,8 @@ pub struct Thread<S = PageAlignedBuffer> {
 
     /// Stack memory information.
     pub stack_mem: ThreadStackMem<S>,
-    // TODO: Add support for dynamic TLS slots
-    // Add field: pub tls_slots: Option<Slots>
 }
 
-// TODO: Add support for dynamic TLS slots methods
-// Implement:
-// - slot_get(&self, mod_id: usize) -> Result<*mut c_void, SlotGetError>
-// - slot_set(&mut self, mod_id: usize, value: *mut c_void) -> Result<(), SlotSetError>
-
 /// Returns a raw pointer to the [`Thread`] information structure representing the
 /// calling thread.
 ///
@@ -0,0 +1,456 @@
+//! Pooled thread spawning
+//!
+//! Creating a thread from scratch allocates its stack, searches the address space for a
+//! free stack region under the VMM lock, and maps the stack there with `svcMapMemory`.
+//! For short-lived workers this dominates the spawn cost.
+//!
+//! [`spawn`] instead takes a thread object and its already mapped (and guarded) stack
+//! from a pool, so spawning a worker costs only the `svcCreateThread` and
+//! `svcStartThread` calls. Once the thread exited, joining or dropping its
+//! [`PooledThread`] gives the stack back to the pool for the next spawn.
+//!
+//! Stacks are reused only for spawns of the same size, so the pool works best with a
+//! few well-known stack sizes. [`prefill`] maps stacks ahead of time, e.g. during
+//! loading, and [`trim`] unmaps the idle ones.
+//!
+//! Like libnx's `threadCreate`, each pooled stack holds the thread's newlib reentrancy
+//! state (`struct _reent`) at its top, next to the TLS block. It is reset on every spawn,
+//! inheriting the standard streams of the spawning thread.
+
+use alloc::boxed::Box;
+use core::{cell::UnsafeCell, ffi::c_void, ptr, ptr::NonNull};
+
+use nx_svc::{
+    raw::INVALID_HANDLE,
+    thread::{self as svc, CreateThreadError, Handle},
+};
+use nx_sys_mem::{alignment::round_up_to_page, stack::MapError};
+use nx_sys_sync::Mutex;
+
+use super::{
+    activity::ThreadStartError,
+    exit,
+    handle::Thread,
+    stackmem::{PageAlignedBufError, PageAlignedBuffer, ThreadStackMem},
+    wait::{self, WaitForExitError},
+};
+use crate::{
+    registry,
+    tls_block::{self, tbss, tdata},
+    tls_region,
+};
+
+/// Maximum number of idle stacks kept in the pool.
+pub const POOL_CAPACITY: usize = 16;
+
+/// Space reserved at the top of each pooled stack for newlib's `struct _reent`.
+///
+/// The exact size is only known to the C side, so this is a bound comfortably above the
+/// `struct _reent` of devkitA64's newlib.
+const REENT_SIZE: usize = 0x800;
+
+/// Entry point of a pooled thread.
+pub type ThreadFunc = unsafe extern "C" fn(arg: *mut c_void);
+
+/// The idle stacks.
+static POOL: Pool = Pool::new();
+
+/// Spawns a thread running `entry(arg)` on a pooled stack of at least `stack_size`
+/// bytes, mapping a new stack only if none of that size is idle.
+///
+/// The thread is created suspended: call [`PooledThread::start`] to run it.
+///
+/// # Safety
+///
+/// `arg` must be valid to pass to `entry` for as long as the thread runs.
+pub unsafe fn spawn(
+    entry: ThreadFunc,
+    arg: *mut c_void,
+    stack_size: usize,
+    prio: i32,
+    cpuid: i32,
+) -> Result<PooledThread, SpawnError> {
+    let size = pooled_stack_size(stack_size);
+    let slot = match POOL.take(size) {
+        Some(slot) => slot,
+        None => Slot::new(size)?,
+    };
+    let slot = NonNull::from(Box::leak(slot));
+
+    // SAFETY: The slot is not used by any thread until the new one starts.
+    let stack_top = unsafe {
+        let slot = &mut *slot.as_ptr();
+        slot.entry = Some(entry);
+        slot.arg = arg;
+        slot.init_reent();
+        slot.init_tls()
+    };
+
+    // SAFETY: `entry_wrap` matches the kernel entry ABI, and the stack stays mapped until
+    // the thread exited and its `PooledThread` gave the slot back.
+    let created = unsafe {
+        svc::create(
+            entry_wrap as *mut c_void,
+            slot.as_ptr().cast(),
+            stack_top,
+            prio,
+            cpuid,
+        )
+    };
+    let handle = match created {
+        Ok(handle) => handle,
+        Err(err) => {
+            // SAFETY: The slot was leaked above and the thread was never created.
+            POOL.put(unsafe { Box::from_raw(slot.as_ptr()) });
+            return Err(err.into());
+        }
+    };
+
+    // SAFETY: The thread does not run before it is started.
+    unsafe { (*slot.as_ptr()).thread.handle = handle };
+
+    Ok(PooledThread {
+        slot,
+        handle,
+        started: false,
+    })
+}
+
+/// Maps up to `count` stacks able to hold `stack_size` bytes into the pool, stopping
+/// early once the pool is full.
+pub fn prefill(stack_size: usize, count: usize) -> Result<(), SpawnError> {
+    let size = pooled_stack_size(stack_size);
+    for _ in 0..count {
+        if POOL.is_full() {
+            break;
+        }
+        POOL.put(Slot::new(size)?);
+    }
+    Ok(())
+}
+
+/// Unmaps and frees all the idle stacks of the pool.
+pub fn trim() {
+    while let Some(slot) = POOL.pop() {
+        slot.destroy();
+    }
+}
+
+/// A thread spawned on a pooled stack.
+///
+/// Dropping it waits for the thread to exit, then gives its stack back to the pool.
+pub struct PooledThread {
+    slot: NonNull<Slot>,
+    handle: Handle,
+    started: bool,
+}
+
+impl PooledThread {
+    /// Returns the kernel handle of the thread.
+    pub fn handle(&self) -> Handle {
+        self.handle
+    }
+
+    /// Starts the thread. Starting an already started thread is a no-op.
+    pub fn start(&mut self) -> Result<(), ThreadStartError> {
+        if !self.started {
+            // Registered before it runs, so that a thread exiting right away finds its slot
+            let _ = registry::insert(self.handle);
+            if let Err(err) = svc::start(self.handle) {
+                registry::remove(self.handle);
+                return Err(err.into());
+            }
+            self.started = true;
+        }
+        Ok(())
+    }
+
+    /// Waits for the thread to exit, giving its stack back to the pool.
+    pub fn join(mut self) -> Result<(), WaitForExitError> {
+        let result = self.wait();
+        if result.is_err() {
+            // The thread may still be running on the stack
+            core::mem::forget(self);
+        }
+        result
+    }
+
+    fn wait(&mut self) -> Result<(), WaitForExitError> {
+        if self.started {
+            wait::wait_handle_exit(&self.handle)?;
+            self.started = false;
+        }
+        Ok(())
+    }
+}
+
+impl Drop for PooledThread {
+    fn drop(&mut self) {
+        if self.wait().is_err() {
+            // The thread may still be running on the stack: leak it
+            return;
+        }
+
+        // Closing the handle of a never started thread destroys it
+        let _ = svc::close_handle(self.handle);
+
+        // SAFETY: The slot was leaked by `spawn` and the thread stopped using it.
+        let mut slot = unsafe { Box::from_raw(self.slot.as_ptr()) };
+        // SAFETY: As above, the thread no longer uses its reentrancy state.
+        unsafe { slot.reclaim_reent() };
+        slot.thread.handle = placeholder_handle();
+        slot.entry = None;
+        slot.arg = ptr::null_mut();
+        POOL.put(slot);
+    }
+}
+
+// Allow `PooledThread` to be moved to, and joined from, another thread.
+// SAFETY: The slot is only accessed by the spawned thread until it exited.
+unsafe impl Send for PooledThread {}
+
+/// Error type for [`spawn`] and [`prefill`].
+#[derive(Debug, thiserror::Error)]
+pub enum SpawnError {
+    /// The stack memory could not be allocated.
+    #[error(transparent)]
+    Alloc(#[from] PageAlignedBufError),
+
+    /// The stack memory could not be mapped.
+    #[error(transparent)]
+    Map(#[from] MapError),
+
+    /// The kernel failed to create the thread.
+    #[error(transparent)]
+    Create(#[from] CreateThreadError),
+}
+
+/// A thread object with its mapped stack.
+struct Slot {
+    thread: Thread,
+    entry: Option<ThreadFunc>,
+    arg: *mut c_void,
+    /// Thread pointer of the TLS block near the top of the stack.
+    tls_tp: *mut c_void,
+    /// Newlib reentrancy state at the top of the stack, null until the first spawn.
+    reent: *mut Reent,
+}
+
+impl Slot {
+    /// Allocates and maps a stack of `size` bytes.
+    fn new(size: usize) -> Result<Box<Self>, SpawnError> {
+        let buffer = PageAlignedBuffer::alloc(size)?;
+        let stack_mem = ThreadStackMem::map(buffer)?;
+        Ok(Box::new(Self {
+            thread: Thread {
+                handle: placeholder_handle(),
+                stack_mem,
+            },
+            entry: None,
+            arg: ptr::null_mut(),
+            tls_tp: ptr::null_mut(),
+            reent: ptr::null_mut(),
+        }))
+    }
+
+    /// Returns the end of the stack memory.
+    fn stack_end(&self) -> usize {
+        let stack_mem = &self.thread.stack_mem;
+        stack_mem.mirror_ptr().as_ptr() as usize + stack_mem.size()
+    }
+
+    /// Resets the newlib reentrancy state at the top of the stack, as newlib's
+    /// `_REENT_INIT_PTR` does, inheriting the standard streams of the calling thread.
+    ///
+    /// # Safety
+    ///
+    /// No thread must be running on the stack.
+    unsafe fn init_reent(&mut self) {
+        let reent = ((self.stack_end() - REENT_SIZE) & !0xF) as *mut Reent;
+
+        // SAFETY: The reentrancy state lies within the mapped stack, unused by any thread.
+        unsafe { ptr::write_bytes(reent.cast::<u8>(), 0, REENT_SIZE) };
+
+        // SAFETY: `thread_vars_ptr()` points to the calling thread's ThreadVars.
+        let parent = unsafe { (*tls_region::thread_vars_ptr()).reent }.cast::<Reent>();
+        if !parent.is_null() {
+            // SAFETY: A non-null `reent` points to the calling thread's `struct _reent`,
+            // and `reent` was zeroed above.
+            unsafe {
+                (*reent).stdin = (*parent).stdin;
+                (*reent).stdout = (*parent).stdout;
+                (*reent).stderr = (*parent).stderr;
+            }
+        }
+
+        self.reent = reent;
+    }
+
+    /// Frees the buffers newlib allocated for the reentrancy state of the last thread.
+    ///
+    /// # Safety
+    ///
+    /// The thread must have exited.
+    unsafe fn reclaim_reent(&mut self) {
+        if self.reent.is_null() {
+            return;
+        }
+
+        #[cfg(feature = "ffi")]
+        {
+            unsafe extern "C" {
+                /// Newlib's release of the buffers held by a reentrancy structure
+                fn _reclaim_reent(reent: *mut Reent);
+            }
+
+            // SAFETY: `init_reent` initialized the structure, no longer used by any thread.
+            unsafe { _reclaim_reent(self.reent) };
+        }
+    }
+
+    /// Initializes the TLS block below the reentrancy state, returning the stack top below
+    /// it.
+    ///
+    /// # Safety
+    ///
+    /// No thread must be running on the stack.
+    unsafe fn init_tls(&mut self) -> *mut c_void {
+        // Below the reentrancy state
+        let tls_end = self.stack_end() - REENT_SIZE;
+
+        let align = tls_block::align().max(16);
+        let tls_start = (tls_end - tls_block::size()) & !(align - 1);
+        let tdata_size = tdata::lma_size();
+
+        // SAFETY: The TLS block lies within the mapped stack, unused by any thread.
+        unsafe {
+            tdata::copy_nonoverlapping(tls_start as *mut u8, tdata_size);
+            tbss::init_zeroed(
+                (tls_start + tdata_size) as *mut u8,
+                tls_block::size() - tdata_size,
+            );
+        }
+
+        let tls_tp = tls_start - tdata::start_offset();
+        self.tls_tp = tls_tp as *mut c_void;
+
+        // Keep the TCB below the TLS block out of the stack
+        (tls_tp & !0xF) as *mut c_void
+    }
+
+    /// Unmaps and frees the stack.
+    fn destroy(self: Box<Self>) {
+        let Self { thread, .. } = *self;
+        // A stack failing to unmap is not reusable anyway
+        let _ = thread.stack_mem.unmap();
+    }
+}
+
+/// Entry point of all pooled threads, running the entry function of the slot `arg`.
+unsafe extern "C" fn entry_wrap(arg: *mut c_void) -> ! {
+    // SAFETY: `spawn` passes the slot, owned by the `PooledThread` until this thread exited.
+    let slot = unsafe { &mut *arg.cast::<Slot>() };
+
+    // SAFETY: This is the first code running on the new thread.
+    unsafe {
+        tls_region::init_thread_vars(
+            slot.thread.handle,
+            (&raw mut slot.thread).cast(),
+            slot.reent.cast(),
+            slot.tls_tp,
+        )
+    };
+
+    if let Some(entry) = slot.entry {
+        // SAFETY: The caller of `spawn` guarantees `arg` is valid for `entry`.
+        unsafe { entry(slot.arg) };
+    }
+
+    // SAFETY: Called on the exiting thread, with its own thread object.
+    unsafe { exit::exit(&mut slot.thread) }
+}
+
+/// Leading fields of newlib's `struct _reent`, unchanged across newlib versions.
+///
+/// Only ever accessed through pointers to the [`REENT_SIZE`] bytes reserved on the stack.
+#[repr(C)]
+struct Reent {
+    _errno: i32,
+    stdin: *mut c_void,
+    stdout: *mut c_void,
+    stderr: *mut c_void,
+}
+
+/// Returns the size of a pooled stack holding `stack_size` bytes of stack, plus the
+/// newlib reentrancy state, the TLS block and its TCB.
+fn pooled_stack_size(stack_size: usize) -> usize {
+    let tls_reserve = tls_block::size() + tls_block::align().max(16) + tdata::start_offset();
+    round_up_to_page(stack_size + REENT_SIZE + tls_reserve)
+}
+
+/// Handle of a thread object not bound to a kernel thread.
+fn placeholder_handle() -> Handle {
+    // SAFETY: The handle is replaced before the thread object is used.
+    unsafe { Handle::from_raw(INVALID_HANDLE) }
+}
+
+/// Fixed-capacity set of idle slots.
+struct Pool {
+    lock: Mutex,
+    slots: UnsafeCell<[Option<Box<Slot>>; POOL_CAPACITY]>,
+}
+
+// SAFETY: The slots are only accessed with `lock` held.
+unsafe impl Sync for Pool {}
+
+impl Pool {
+    const fn new() -> Self {
+        Self {
+            lock: Mutex::new(),
+            slots: UnsafeCell::new([const { None }; POOL_CAPACITY]),
+        }
+    }
+
+    /// Runs `f` on the slots, with the lock held.
+    fn with<R>(&self, f: impl FnOnce(&mut [Option<Box<Slot>>; POOL_CAPACITY]) -> R) -> R {
+        self.lock.lock();
+        // SAFETY: The lock is held, so no other thread accesses the slots.
+        let result = f(unsafe { &mut *self.slots.get() });
+        self.lock.unlock();
+        result
+    }
+
+    /// Takes an idle slot with a stack of `size` bytes.
+    fn take(&self, size: usize) -> Option<Box<Slot>> {
+        self.with(|slots| {
+            slots
+                .iter_mut()
+                .find(|slot| matches!(slot, Some(slot) if slot.thread.stack_mem.size() == size))?
+                .take()
+        })
+    }
+
+    /// Takes any idle slot.
+    fn pop(&self) -> Option<Box<Slot>> {
+        self.with(|slots| slots.iter_mut().find_map(Option::take))
+    }
+
+    /// Returns `true` if no more slots fit in the pool.
+    fn is_full(&self) -> bool {
+        self.with(|slots| slots.iter().all(Option::is_some))
+    }
+
+    /// Parks an idle slot, destroying it if the pool is full.
+    fn put(&self, slot: Box<Slot>) {
+        let rejected = self.with(|slots| match slots.iter_mut().find(|s| s.is_none()) {
+            Some(free) => {
+                *free = Some(slot);
+                None
+            }
+            None => Some(slot),
+        });
+        if let Some(slot) = rejected {
+            slot.destroy();
+        }
+    }
+}
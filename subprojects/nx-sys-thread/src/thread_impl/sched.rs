@@ -0,0 +1,228 @@
+//! Thread scheduling parameters.
+//!
+//! This module contains safe, idiomatic wrappers around the SVCs that query and change
+//! where and how urgently the kernel schedules a thread:
+//! * [`set_core_mask`] / [`get_core_mask`] → `svcSetThreadCoreMask` /
+//!   `svcGetThreadCoreMask` – the preferred (ideal) core and the cores the thread may
+//!   run on.
+//! * [`set_priority`] / [`get_priority`] → `svcSetThreadPriority` /
+//!   `svcGetThreadPriority` – priorities range over `0..=0x3F`, lower values being more
+//!   urgent.
+//! * [`get_cpu_time`] → `svcGetInfo` with `ThreadTickCount` – the CPU time the thread
+//!   consumed on all cores.
+//!
+//! Pinning a thread to a single core keeps its working set in that core's cache, at the
+//! cost of the scheduler no longer migrating it to an idle core.
+
+use core::time::Duration;
+
+use nx_svc::{
+    misc::GetInfoError,
+    result::Error,
+    thread::{self as svc, CoreAffinityMask, IntoCoreAffinityParams},
+};
+
+use super::handle::Thread;
+
+/// System counter-timer frequency (19.2MHz)
+const TICKS_PER_SEC: u64 = 19_200_000;
+
+/// Sets the preferred core and the allowed cores of the given [`Thread`].
+///
+/// See [`svc::CoreAffinity`] for the accepted configurations. A thread running on a
+/// core outside of its new mask is migrated right away.
+pub fn set_core_mask(
+    thread: &Thread,
+    affinity: impl IntoCoreAffinityParams,
+) -> Result<(), ThreadSetCoreMaskError> {
+    svc::set_core_mask(thread.handle, affinity).map_err(Into::into)
+}
+
+/// Returns the preferred core and the allowed cores of the given [`Thread`].
+///
+/// The preferred core is `None` if the thread has none.
+pub fn get_core_mask(
+    thread: &Thread,
+) -> Result<(Option<u8>, CoreAffinityMask), ThreadGetCoreMaskError> {
+    let (core_id, mask) = svc::get_core_mask(thread.handle)?;
+    let core = u8::try_from(core_id).ok();
+    Ok((core, CoreAffinityMask::from_bits_truncate(mask as u32)))
+}
+
+/// Sets the priority of the given [`Thread`].
+pub fn set_priority(thread: &Thread, priority: u32) -> Result<(), ThreadSetPriorityError> {
+    svc::set_priority(thread.handle, priority).map_err(Into::into)
+}
+
+/// Returns the priority of the given [`Thread`].
+pub fn get_priority(thread: &Thread) -> Result<i32, ThreadGetPriorityError> {
+    svc::get_priority(thread.handle).map_err(Into::into)
+}
+
+/// Returns the CPU time consumed by the given [`Thread`] on all cores.
+pub fn get_cpu_time(thread: &Thread) -> Result<Duration, GetInfoError> {
+    let ticks = svc::get_cpu_ticks(thread.handle)?;
+    let secs = ticks / TICKS_PER_SEC;
+    let nanos = (ticks % TICKS_PER_SEC) * 1_000_000_000 / TICKS_PER_SEC;
+    Ok(Duration::new(secs, nanos as u32))
+}
+
+/// Error type for [`set_core_mask`].
+#[derive(Debug, thiserror::Error)]
+pub enum ThreadSetCoreMaskError {
+    /// Supplied handle does not refer to a valid thread.
+    #[error("Invalid thread handle")]
+    InvalidHandle,
+
+    /// The preferred core or the mask holds a core the process may not use.
+    #[error("Invalid core id")]
+    InvalidCoreId,
+
+    /// The mask is empty, or does not hold the preferred core.
+    #[error("Invalid core combination")]
+    InvalidCombination,
+
+    /// The thread is terminating.
+    #[error("Termination requested")]
+    TerminationRequested,
+
+    /// Kernel returned an undocumented [`ResultCode`].
+    ///
+    /// The wrapped [`ResultCode`] is preserved so callers can inspect it
+    /// using [`ResultCode::to_rc`] or display it for diagnostics.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl From<svc::SetCoreMaskError> for ThreadSetCoreMaskError {
+    fn from(value: svc::SetCoreMaskError) -> Self {
+        match value {
+            svc::SetCoreMaskError::InvalidHandle => Self::InvalidHandle,
+            svc::SetCoreMaskError::InvalidCoreId => Self::InvalidCoreId,
+            svc::SetCoreMaskError::InvalidCombination => Self::InvalidCombination,
+            svc::SetCoreMaskError::TerminationRequested => Self::TerminationRequested,
+            svc::SetCoreMaskError::Unknown(err) => Self::Unknown(err),
+        }
+    }
+}
+
+#[cfg(feature = "ffi")]
+impl nx_svc::error::ToRawResultCode for ThreadSetCoreMaskError {
+    fn to_rc(self) -> nx_svc::error::ResultCode {
+        match self {
+            Self::InvalidHandle => svc::SetCoreMaskError::InvalidHandle.to_rc(),
+            Self::InvalidCoreId => svc::SetCoreMaskError::InvalidCoreId.to_rc(),
+            Self::InvalidCombination => svc::SetCoreMaskError::InvalidCombination.to_rc(),
+            Self::TerminationRequested => svc::SetCoreMaskError::TerminationRequested.to_rc(),
+            Self::Unknown(err) => err.to_rc(),
+        }
+    }
+}
+
+/// Error type for [`get_core_mask`].
+#[derive(Debug, thiserror::Error)]
+pub enum ThreadGetCoreMaskError {
+    /// Supplied handle does not refer to a valid thread.
+    #[error("Invalid thread handle")]
+    InvalidHandle,
+
+    /// Kernel returned an undocumented [`ResultCode`].
+    ///
+    /// The wrapped [`ResultCode`] is preserved so callers can inspect it
+    /// using [`ResultCode::to_rc`] or display it for diagnostics.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl From<svc::GetCoreMaskError> for ThreadGetCoreMaskError {
+    fn from(value: svc::GetCoreMaskError) -> Self {
+        match value {
+            svc::GetCoreMaskError::InvalidHandle => Self::InvalidHandle,
+            svc::GetCoreMaskError::Unknown(err) => Self::Unknown(err),
+        }
+    }
+}
+
+#[cfg(feature = "ffi")]
+impl nx_svc::error::ToRawResultCode for ThreadGetCoreMaskError {
+    fn to_rc(self) -> nx_svc::error::ResultCode {
+        match self {
+            Self::InvalidHandle => svc::GetCoreMaskError::InvalidHandle.to_rc(),
+            Self::Unknown(err) => err.to_rc(),
+        }
+    }
+}
+
+/// Error type for [`set_priority`].
+#[derive(Debug, thiserror::Error)]
+pub enum ThreadSetPriorityError {
+    /// Supplied handle does not refer to a valid thread.
+    #[error("Invalid thread handle")]
+    InvalidHandle,
+
+    /// The priority is out of range or not allowed for the process.
+    #[error("Invalid priority")]
+    InvalidPriority,
+
+    /// Kernel returned an undocumented [`ResultCode`].
+    ///
+    /// The wrapped [`ResultCode`] is preserved so callers can inspect it
+    /// using [`ResultCode::to_rc`] or display it for diagnostics.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl From<svc::SetPriorityError> for ThreadSetPriorityError {
+    fn from(value: svc::SetPriorityError) -> Self {
+        match value {
+            svc::SetPriorityError::InvalidHandle => Self::InvalidHandle,
+            svc::SetPriorityError::InvalidPriority => Self::InvalidPriority,
+            svc::SetPriorityError::Unknown(err) => Self::Unknown(err),
+        }
+    }
+}
+
+#[cfg(feature = "ffi")]
+impl nx_svc::error::ToRawResultCode for ThreadSetPriorityError {
+    fn to_rc(self) -> nx_svc::error::ResultCode {
+        match self {
+            Self::InvalidHandle => svc::SetPriorityError::InvalidHandle.to_rc(),
+            Self::InvalidPriority => svc::SetPriorityError::InvalidPriority.to_rc(),
+            Self::Unknown(err) => err.to_rc(),
+        }
+    }
+}
+
+/// Error type for [`get_priority`].
+#[derive(Debug, thiserror::Error)]
+pub enum ThreadGetPriorityError {
+    /// Supplied handle does not refer to a valid thread.
+    #[error("Invalid thread handle")]
+    InvalidHandle,
+
+    /// Kernel returned an undocumented [`ResultCode`].
+    ///
+    /// The wrapped [`ResultCode`] is preserved so callers can inspect it
+    /// using [`ResultCode::to_rc`] or display it for diagnostics.
+    #[error("Unknown error: {0}")]
+    Unknown(Error),
+}
+
+impl From<svc::GetPriorityError> for ThreadGetPriorityError {
+    fn from(value: svc::GetPriorityError) -> Self {
+        match value {
+            svc::GetPriorityError::InvalidHandle => Self::InvalidHandle,
+            svc::GetPriorityError::Unknown(err) => Self::Unknown(err),
+        }
+    }
+}
+
+#[cfg(feature = "ffi")]
+impl nx_svc::error::ToRawResultCode for ThreadGetPriorityError {
+    fn to_rc(self) -> nx_svc::error::ResultCode {
+        match self {
+            Self::InvalidHandle => svc::GetPriorityError::InvalidHandle.to_rc(),
+            Self::Unknown(err) => err.to_rc(),
+        }
+    }
+}
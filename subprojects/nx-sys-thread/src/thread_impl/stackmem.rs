@@ -5,7 +5,7 @@ use nx_sys_mem::{
     buf::{Buf, Buffer, BufferRef},
     stack::{
         self as stack_mem, MapError as StackMemMapError, MappedStackMemory,
-        MappedStackMemory as StackMem,
+        MappedStackMemory as StackMem, UnmapError as StackMemUnmapError,
     },
 };
 
@@ -24,6 +24,11 @@ where
         unsafe { stack_mem::map(buffer) }.map(ThreadStackMem)
     }
 
+    /// Unmaps the thread stack memory, giving back the underlying buffer
+    pub fn unmap(self) -> Result<B, StackMemUnmapError> {
+        unsafe { stack_mem::unmap(self.0) }
+    }
+
     /// Returns a pointer to the thread stack memory
     pub fn memory_ptr(&self) -> NonNull<c_void> {
         self.0.buffer_ptr()
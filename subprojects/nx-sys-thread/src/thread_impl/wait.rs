@@ -18,6 +18,7 @@ use nx_svc::{
 use nx_time::Instant;
 
 use super::handle::Thread;
+use crate::registry;
 
 /// Blocks until the supplied thread [`Handle`] becomes *signalled*, i.e. the
 /// referenced thread has fully exited and entered the _dead_ state.
@@ -50,7 +51,12 @@ pub fn wait_handle_exit_with_timeout(
 
         // SAFETY: We forward a single valid handle
         match unsafe { sync::wait_synchronization_single(handle, this_timeout_ns) } {
-            Ok(()) => return Ok(()),
+            Ok(()) => {
+                // Threads calling `svcExitThread` directly do not unregister
+                // themselves; the handle is still open here
+                registry::remove(*handle);
+                return Ok(());
+            }
             Err(err) => match err {
                 WaitSyncError::Cancelled => {
                     // Retry transparently.
@@ -0,0 +1,50 @@
+/**
+ * @file nx_time_profile.h
+ * @brief Tick-based profiling spans and counters.
+ *
+ * Available when nx-time is built with the `profile` feature. Names are not
+ * copied: they must be string literals, or otherwise live until the trace is
+ * dumped.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Enables or disables recording. Recording is disabled by default.
+ * @param enabled Whether to record events.
+ */
+void __nx_time__profile_set_enabled(bool enabled);
+
+/**
+ * @brief Starts a span.
+ * @return The start tick, to pass to __nx_time__profile_span_end.
+ */
+uint64_t __nx_time__profile_span_begin(void);
+
+/**
+ * @brief Ends a span.
+ * @param name Name of the span.
+ * @param start Tick returned by __nx_time__profile_span_begin.
+ */
+void __nx_time__profile_span_end(const char *name, uint64_t start);
+
+/**
+ * @brief Records a counter sample.
+ * @param name Name of the counter.
+ * @param value Value of the counter.
+ */
+void __nx_time__profile_counter(const char *name, uint64_t value);
+
+/**
+ * @brief Forgets the events recorded so far.
+ */
+void __nx_time__profile_clear(void);
+
+/**
+ * @brief Writes the recorded events as a Chrome trace JSON file.
+ * @param path Path of the file, e.g. "sdmc:/trace.json".
+ * @return 0 on success, -1 on failure.
+ */
+int __nx_time__profile_dump(const char *path);
@@ -5,6 +5,8 @@
 //! - [switchbrew/libnx: switch/arm/counter.h](https://github.com/switchbrew/libnx/blob/60bf943ec14b1fb2ae169e627e64ab93a24c042b/nx/include/switch/arm/counter.h)
 
 mod libsysbase;
+#[cfg(feature = "profile")]
+mod profile;
 
 use crate::sys::clock;
 
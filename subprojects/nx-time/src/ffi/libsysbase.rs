@@ -6,10 +6,14 @@
 //!
 //! - libgloss/libsysbase/syscall_support.c
 //! - newlib/libc/include/sys/time.h
+//! - newlib/libc/include/time.h
 
 use core::ffi::c_int;
 
-use crate::sys::clock::aarch64::NSEC_PER_TICK;
+use crate::sys::clock::{
+    aarch64::{self, NSEC_PER_TICK},
+    service,
+};
 
 /// C struct timespec
 #[repr(C)]
@@ -18,6 +22,10 @@ struct CTimespec {
     tv_nsec: i64,
 }
 
+// Clock IDs, from newlib's `<time.h>`
+const CLOCK_REALTIME: c_int = 1;
+const CLOCK_MONOTONIC: c_int = 4;
+
 // Error codes
 const EFAULT: c_int = 14;
 const EINVAL: c_int = 22;
@@ -30,8 +38,8 @@ pub unsafe extern "C" fn __nx_time__libsysbase_syscall_clock_getres(
     clock_id: c_int,
     tp: *mut CTimespec,
 ) -> c_int {
-    // Only CLOCK_REALTIME (0) and CLOCK_MONOTONIC (1) are valid
-    if clock_id != 0 && clock_id != 1 {
+    // Only CLOCK_REALTIME and CLOCK_MONOTONIC are valid
+    if clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC {
         set_errno(EINVAL);
         return -1;
     }
@@ -47,6 +55,41 @@ pub unsafe extern "C" fn __nx_time__libsysbase_syscall_clock_getres(
     0
 }
 
+/// Get the time of a clock.
+///
+/// Corresponds to libsysbase's `__syscall_clock_gettime`. `CLOCK_REALTIME` is
+/// read from the time service shared memory, `CLOCK_MONOTONIC` from the system
+/// tick; neither performs any IPC or syscall.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__libsysbase_syscall_clock_gettime(
+    clock_id: c_int,
+    tp: *mut CTimespec,
+) -> c_int {
+    if tp.is_null() {
+        set_errno(EFAULT);
+        return -1;
+    }
+
+    let now = match clock_id {
+        CLOCK_REALTIME => service::gettime(),
+        CLOCK_MONOTONIC => aarch64::gettime(),
+        _ => Err(EINVAL),
+    };
+    match now {
+        Ok(ts) => {
+            unsafe {
+                (*tp).tv_sec = ts.sec();
+                (*tp).tv_nsec = ts.nsec();
+            }
+            0
+        }
+        Err(code) => {
+            set_errno(code);
+            -1
+        }
+    }
+}
+
 /// Sets the thread-local `errno` value
 #[inline]
 fn set_errno(code: c_int) {
@@ -0,0 +1,120 @@
+//! FFI bindings for the profiling spans and counters.
+//!
+//! Names passed from C are not copied: they must be string literals, or
+//! otherwise live until the trace is dumped.
+
+use core::{
+    ffi::{c_char, c_int, c_void},
+    fmt,
+};
+
+use crate::{
+    profile::{self, Event, EventKind, Name},
+    sys::clock::aarch64,
+};
+
+/// Enables or disables recording.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__profile_set_enabled(enabled: bool) {
+    profile::set_enabled(enabled);
+}
+
+/// Starts a span, returning the tick to pass to
+/// [`__nx_time__profile_span_end`].
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__profile_span_begin() -> u64 {
+    aarch64::get_system_tick()
+}
+
+/// Ends a span started at tick `start`.
+///
+/// # Safety
+///
+/// `name` must be null or a NUL-terminated string living until the trace is
+/// dumped.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__profile_span_end(name: *const c_char, start: u64) {
+    profile::record(Event {
+        // SAFETY: The caller guarantees `name` outlives the trace.
+        name: unsafe { Name::from_c_str(name.cast()) },
+        kind: EventKind::Span,
+        tick: start,
+        value: aarch64::get_system_tick(),
+    });
+}
+
+/// Records a counter sample.
+///
+/// # Safety
+///
+/// `name` must be null or a NUL-terminated string living until the trace is
+/// dumped.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__profile_counter(name: *const c_char, value: u64) {
+    profile::record(Event {
+        // SAFETY: The caller guarantees `name` outlives the trace.
+        name: unsafe { Name::from_c_str(name.cast()) },
+        kind: EventKind::Counter,
+        tick: aarch64::get_system_tick(),
+        value,
+    });
+}
+
+/// Forgets the events recorded so far.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__profile_clear() {
+    profile::clear();
+}
+
+/// Writes the recorded events as a Chrome trace JSON file at `path`
+/// (e.g. `sdmc:/trace.json`).
+///
+/// Returns 0 on success, or -1 if the file could not be opened or written.
+///
+/// # Safety
+///
+/// `path` must be a valid NUL-terminated string.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn __nx_time__profile_dump(path: *const c_char) -> c_int {
+    // SAFETY: The caller guarantees `path` is a valid C string.
+    let file = unsafe { fopen(path, c"wb".as_ptr()) };
+    if file.is_null() {
+        return -1;
+    }
+
+    let mut out = CFile(file);
+    let written = profile::dump(&mut out);
+    // SAFETY: `file` was opened above and is closed once.
+    let closed = unsafe { fclose(file) };
+
+    if written.is_ok() && closed == 0 {
+        0
+    } else {
+        -1
+    }
+}
+
+/// [`fmt::Write`] adapter over a newlib `FILE`, buffered by newlib.
+struct CFile(*mut c_void);
+
+impl fmt::Write for CFile {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        if s.is_empty() {
+            return Ok(());
+        }
+        // SAFETY: The file is open and `s` is valid for `s.len()` bytes.
+        let written = unsafe { fwrite(s.as_ptr().cast(), 1, s.len(), self.0) };
+        if written == s.len() {
+            Ok(())
+        } else {
+            Err(fmt::Error)
+        }
+    }
+}
+
+// newlib stdio functions
+unsafe extern "C" {
+    fn fopen(path: *const c_char, mode: *const c_char) -> *mut c_void;
+    fn fwrite(ptr: *const c_void, size: usize, count: usize, file: *mut c_void) -> usize;
+    fn fclose(file: *mut c_void) -> c_int;
+}
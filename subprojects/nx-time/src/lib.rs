@@ -3,11 +3,22 @@
 
 extern crate nx_panic_handler as _; // provides #[panic_handler]
 
+// The `alloc` crate enables memory allocation.
+#[cfg(feature = "wheel")]
+extern crate alloc;
+// The `nx-alloc` crate exposes the `#[global_allocator]` for the dependent crates.
+#[cfg(feature = "wheel")]
+extern crate nx_alloc;
+
 #[cfg(feature = "ffi")]
 pub mod ffi;
 
 pub mod common;
+#[cfg(feature = "profile")]
+pub mod profile;
 mod sys;
+#[cfg(feature = "wheel")]
+pub mod wheel;
 
 pub use core::time::{Duration, TryFromFloatSecsError};
 use core::{
@@ -16,6 +27,7 @@ use core::{
     ops::{Add, AddAssign, Sub, SubAssign},
 };
 
+pub use self::sys::clock::service::set_realtime_shared_memory;
 use crate::common::{FromInner, IntoInner};
 
 /// A measurement of a monotonically nondecreasing clock.
@@ -0,0 +1,405 @@
+//! Tick-based profiling spans and counters.
+//!
+//! Spans and counter samples are timestamped with the system tick and recorded
+//! into per-thread ring buffers, without locks or syscalls on the recording
+//! path. [`dump`] writes the recorded events in the Chrome trace event format,
+//! which `chrome://tracing` and Perfetto load directly.
+//!
+//! ```ignore
+//! nx_time::profile::set_enabled(true);
+//!
+//! fn frame() {
+//!     let _frame = nx_time::profile::span("frame");
+//!     {
+//!         let _update = nx_time::profile::span("update");
+//!         // ...
+//!     }
+//!     DRAW_CALLS.set(draw_calls);
+//! }
+//!
+//! static DRAW_CALLS: nx_time::profile::Counter = nx_time::profile::Counter::new("draw_calls");
+//! ```
+//!
+//! Each thread records into its own ring, claimed on its first event. When a
+//! ring is full, the oldest events are overwritten. Up to [`MAX_THREADS`]
+//! threads are profiled at once; events of further threads are dropped.
+
+use core::{
+    cell::UnsafeCell,
+    fmt, ptr, slice,
+    sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering, fence},
+};
+
+use nx_cpu::control_regs;
+
+use crate::sys::clock::aarch64;
+
+/// Maximum number of threads profiled at once.
+pub const MAX_THREADS: usize = 16;
+
+/// Number of event slots per thread.
+///
+/// The slot the thread writes next is never dumped, so a thread keeps its
+/// `RING_CAPACITY - 1` most recent events.
+pub const RING_CAPACITY: usize = 1024;
+
+/// Whether events are recorded.
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// The per-thread rings.
+static RINGS: [Ring; MAX_THREADS] = [const { Ring::new() }; MAX_THREADS];
+
+/// Enables or disables recording. Recording is disabled by default.
+#[inline]
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+/// Returns `true` if events are recorded.
+#[inline]
+pub fn is_enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Starts a span, ended when the returned guard is dropped.
+#[inline]
+pub fn span(name: &'static str) -> Span {
+    Span {
+        name: Name::from_str(name),
+        start: aarch64::get_system_tick(),
+    }
+}
+
+/// Records a named counter sample.
+#[inline]
+pub fn counter(name: &'static str, value: u64) {
+    record(Event {
+        name: Name::from_str(name),
+        kind: EventKind::Counter,
+        tick: aarch64::get_system_tick(),
+        value,
+    });
+}
+
+/// A scoped span, recorded from its creation to its drop.
+#[must_use = "the span ends when the guard is dropped"]
+pub struct Span {
+    name: Name,
+    start: u64,
+}
+
+impl Drop for Span {
+    #[inline]
+    fn drop(&mut self) {
+        record(Event {
+            name: self.name,
+            kind: EventKind::Span,
+            tick: self.start,
+            value: aarch64::get_system_tick(),
+        });
+    }
+}
+
+/// A named counter, sampled into the trace on every update.
+pub struct Counter {
+    name: &'static str,
+    value: AtomicU64,
+}
+
+impl Counter {
+    /// Creates a counter starting at zero.
+    pub const fn new(name: &'static str) -> Self {
+        Self {
+            name,
+            value: AtomicU64::new(0),
+        }
+    }
+
+    /// Returns the current value of the counter.
+    #[inline]
+    pub fn get(&self) -> u64 {
+        self.value.load(Ordering::Relaxed)
+    }
+
+    /// Sets the counter to `value`.
+    #[inline]
+    pub fn set(&self, value: u64) {
+        self.value.store(value, Ordering::Relaxed);
+        counter(self.name, value);
+    }
+
+    /// Adds `delta` to the counter.
+    #[inline]
+    pub fn add(&self, delta: u64) {
+        let value = self
+            .value
+            .fetch_add(delta, Ordering::Relaxed)
+            .wrapping_add(delta);
+        counter(self.name, value);
+    }
+}
+
+/// Forgets the events recorded so far, so the next [`dump`] only contains
+/// newer ones.
+pub fn clear() {
+    for ring in &RINGS {
+        ring.start
+            .store(ring.head.load(Ordering::Acquire), Ordering::Relaxed);
+    }
+}
+
+/// Writes the recorded events as a Chrome trace (JSON object format).
+///
+/// Threads keep recording during the dump. Events overwritten while being
+/// read are skipped.
+pub fn dump<W: fmt::Write>(out: &mut W) -> fmt::Result {
+    out.write_str("{\"traceEvents\":[")?;
+
+    let mut first = true;
+    for (tid, ring) in RINGS.iter().enumerate() {
+        if ring.owner.load(Ordering::Acquire) == 0 {
+            continue;
+        }
+
+        let head = ring.head.load(Ordering::Acquire);
+        let start = ring
+            .start
+            .load(Ordering::Relaxed)
+            .max(head.saturating_sub(RING_CAPACITY as u64 - 1));
+        for index in start..head {
+            let Some(event) = ring.read(index) else {
+                continue;
+            };
+            if !first {
+                out.write_char(',')?;
+            }
+            first = false;
+            write_event(out, tid, &event)?;
+        }
+    }
+
+    out.write_str("]}")
+}
+
+/// Writes one trace event. Timestamps are in microseconds.
+fn write_event<W: fmt::Write>(out: &mut W, tid: usize, event: &Event) -> fmt::Result {
+    out.write_str("{\"name\":\"")?;
+    // SAFETY: Names are `'static` strings or C strings.
+    write_escaped(out, unsafe { event.name.as_bytes() })?;
+    write!(out, "\",\"pid\":0,\"tid\":{tid},\"ts\":")?;
+    write_micros(out, event.tick)?;
+
+    match event.kind {
+        EventKind::Span => {
+            out.write_str(",\"ph\":\"X\",\"dur\":")?;
+            write_micros(out, event.value.saturating_sub(event.tick))?;
+            out.write_char('}')
+        }
+        EventKind::Counter => write!(
+            out,
+            ",\"ph\":\"C\",\"args\":{{\"value\":{}}}}}",
+            event.value
+        ),
+    }
+}
+
+/// Writes a tick count as microseconds, with nanosecond precision.
+fn write_micros<W: fmt::Write>(out: &mut W, ticks: u64) -> fmt::Result {
+    let ns = aarch64::cpu_ticks_to_ns(ticks);
+    write!(out, "{}.{:03}", ns / 1000, ns % 1000)
+}
+
+/// Writes `bytes` as the contents of a JSON string.
+fn write_escaped<W: fmt::Write>(out: &mut W, bytes: &[u8]) -> fmt::Result {
+    for chunk in bytes.utf8_chunks() {
+        for c in chunk.valid().chars() {
+            match c {
+                '"' => out.write_str("\\\"")?,
+                '\\' => out.write_str("\\\\")?,
+                c if (c as u32) < 0x20 => write!(out, "\\u{:04x}", c as u32)?,
+                c => out.write_char(c)?,
+            }
+        }
+        if !chunk.invalid().is_empty() {
+            out.write_char(char::REPLACEMENT_CHARACTER)?;
+        }
+    }
+    Ok(())
+}
+
+/// Records an event into the current thread's ring.
+#[inline]
+pub(crate) fn record(event: Event) {
+    if !is_enabled() {
+        return;
+    }
+    if let Some(ring) = thread_ring() {
+        // SAFETY: Only the thread owning the ring writes to it.
+        unsafe { ring.push(event) };
+    }
+}
+
+/// Returns the ring of the current thread, claiming one on first use.
+///
+/// Threads are told apart by their thread-local region, whose address is
+/// unique among live threads. A thread reusing the region of an exited one
+/// also reuses its ring.
+fn thread_ring() -> Option<&'static Ring> {
+    // SAFETY: Reading the thread-local region address has no side effects.
+    let owner = unsafe { control_regs::tpidrro_el0() };
+    // Thread-local regions are 0x200 bytes apart
+    let home = (owner >> 9) % MAX_THREADS;
+
+    for probe in 0..MAX_THREADS {
+        let ring = &RINGS[(home + probe) % MAX_THREADS];
+        match ring.owner.load(Ordering::Acquire) {
+            id if id == owner => return Some(ring),
+            0 => {
+                match ring
+                    .owner
+                    .compare_exchange(0, owner, Ordering::AcqRel, Ordering::Acquire)
+                {
+                    Ok(_) => return Some(ring),
+                    Err(id) if id == owner => return Some(ring),
+                    Err(_) => {}
+                }
+            }
+            _ => {}
+        }
+    }
+    None
+}
+
+/// Name of an event: a `'static` string, or a `'static` C string when `len`
+/// is [`Name::C_STR`].
+#[derive(Clone, Copy)]
+pub(crate) struct Name {
+    ptr: *const u8,
+    len: usize,
+}
+
+impl Name {
+    /// Length marker of a NUL-terminated name.
+    const C_STR: usize = usize::MAX;
+
+    #[inline]
+    const fn from_str(name: &'static str) -> Self {
+        Self {
+            ptr: name.as_ptr(),
+            len: name.len(),
+        }
+    }
+
+    /// Creates the name of a NUL-terminated string, measured only when dumped.
+    ///
+    /// # Safety
+    ///
+    /// `name` must be null or a NUL-terminated string living for the rest of
+    /// the program.
+    #[inline]
+    pub(crate) const unsafe fn from_c_str(name: *const u8) -> Self {
+        Self {
+            ptr: name,
+            len: Self::C_STR,
+        }
+    }
+
+    /// # Safety
+    ///
+    /// The name must have been created from a valid `'static` string.
+    unsafe fn as_bytes(&self) -> &'static [u8] {
+        if self.ptr.is_null() {
+            return &[];
+        }
+        if self.len != Self::C_STR {
+            // SAFETY: Created from a `&'static str`.
+            return unsafe { slice::from_raw_parts(self.ptr, self.len) };
+        }
+
+        let mut len = 0;
+        // SAFETY: The string is NUL-terminated.
+        while unsafe { *self.ptr.add(len) } != 0 {
+            len += 1;
+        }
+        // SAFETY: The `len` bytes before the NUL are part of the string.
+        unsafe { slice::from_raw_parts(self.ptr, len) }
+    }
+}
+
+#[derive(Clone, Copy)]
+pub(crate) enum EventKind {
+    /// A span from `tick` to the tick in `value`.
+    Span,
+    /// A counter sample of `value` at `tick`.
+    Counter,
+}
+
+/// A recorded event.
+#[derive(Clone, Copy)]
+pub(crate) struct Event {
+    pub(crate) name: Name,
+    pub(crate) kind: EventKind,
+    pub(crate) tick: u64,
+    pub(crate) value: u64,
+}
+
+/// Single-producer ring of events.
+struct Ring {
+    /// TLS region address of the owning thread, 0 if unclaimed.
+    owner: AtomicUsize,
+    /// Number of events ever written.
+    head: AtomicU64,
+    /// Index of the first event not cleared by [`clear`].
+    start: AtomicU64,
+    events: [UnsafeCell<Event>; RING_CAPACITY],
+}
+
+// SAFETY: Events are only written by the owning thread; readers detect the
+// slots overwritten while they were read.
+unsafe impl Sync for Ring {}
+
+impl Ring {
+    const fn new() -> Self {
+        const EMPTY: Event = Event {
+            name: Name {
+                ptr: ptr::null(),
+                len: 0,
+            },
+            kind: EventKind::Span,
+            tick: 0,
+            value: 0,
+        };
+        Self {
+            owner: AtomicUsize::new(0),
+            head: AtomicU64::new(0),
+            start: AtomicU64::new(0),
+            events: [const { UnsafeCell::new(EMPTY) }; RING_CAPACITY],
+        }
+    }
+
+    /// Appends an event, overwriting the oldest one when full.
+    ///
+    /// # Safety
+    ///
+    /// Must only be called by the thread owning the ring.
+    #[inline]
+    unsafe fn push(&self, event: Event) {
+        let head = self.head.load(Ordering::Relaxed);
+        let slot = self.events[head as usize % RING_CAPACITY].get();
+        // SAFETY: Only the owner writes the slots.
+        unsafe { ptr::write_volatile(slot, event) };
+        self.head.store(head + 1, Ordering::Release);
+    }
+
+    /// Reads the event written at `index`, or `None` if it was overwritten.
+    fn read(&self, index: u64) -> Option<Event> {
+        let slot = self.events[index as usize % RING_CAPACITY].get();
+        // SAFETY: The slot is initialized; a concurrent overwrite is detected below.
+        let event = unsafe { ptr::read_volatile(slot) };
+        fence(Ordering::Acquire);
+
+        // The owner only writes the slot again once `head` reached `index + capacity`
+        let head = self.head.load(Ordering::Relaxed);
+        (head < index + RING_CAPACITY as u64).then_some(event)
+    }
+}
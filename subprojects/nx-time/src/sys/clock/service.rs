@@ -1,6 +1,133 @@
+//! Realtime clock backed by the time service shared memory.
+//!
+//! On 6.0.0+, the time service publishes the standard steady clock time point
+//! and the user system clock context in a shared memory region. Once the
+//! runtime registers the mapping with [`set_realtime_shared_memory`], realtime is
+//! computed from them and the system tick, without any IPC or syscall.
+
+use core::{
+    ptr,
+    sync::atomic::{AtomicPtr, AtomicU32, Ordering, fence},
+};
+
+use super::aarch64;
 use crate::sys::timespec::Timespec;
 
-// TODO: Add support for retrieving the current time from the RTC service
+/// Offset of the standard steady clock time point in the shared memory.
+const STEADY_CLOCK_OFFSET: usize = 0x00;
+
+/// Offset of the user system clock context in the shared memory.
+const USER_SYSTEM_CLOCK_OFFSET: usize = 0x38;
+
+/// `EINVAL`, returned while no shared memory is registered or the clocks
+/// disagree on their source.
+const EINVAL: i32 = 22;
+
+const NSEC_PER_SEC: i64 = 1_000_000_000;
+
+/// Time service shared memory mapping, or null if not registered.
+static SHARED_MEMORY: AtomicPtr<u8> = AtomicPtr::new(ptr::null_mut());
+
+/// Steady clock time point, as stored in the shared memory.
+#[derive(Clone, Copy)]
+#[repr(C)]
+struct SteadyClockTimePoint {
+    /// Steady clock time at tick 0, in nanoseconds.
+    base_time: i64,
+    source_id: [u8; 16],
+}
+
+/// System clock context, as stored in the shared memory.
+#[derive(Clone, Copy)]
+#[repr(C)]
+struct SystemClockContext {
+    /// Offset of the system clock from the steady clock, in seconds.
+    offset: i64,
+    /// Steady clock time point the offset was taken at, in seconds.
+    time_point: i64,
+    source_id: [u8; 16],
+}
+
+/// Double-buffered shared memory entry: the LSB of the counter selects the
+/// buffer currently valid, and the counter changes on every update.
+#[repr(C)]
+struct DoubleBufferedEntry<T> {
+    counter: AtomicU32,
+    _padding: u32,
+    buffers: [T; 2],
+}
+
+/// Registers the time service shared memory used for realtime reads.
+///
+/// Pass a null pointer to unregister it, before unmapping the region.
+///
+/// # Safety
+///
+/// `ptr` must be null or point to the mapped time service shared memory, which
+/// must stay mapped until it is unregistered and no realtime read is in flight.
+pub unsafe fn set_realtime_shared_memory(ptr: *const u8) {
+    SHARED_MEMORY.store(ptr.cast_mut(), Ordering::Release);
+}
+
+/// Get the realtime clock time.
+///
+/// Computed as the user system clock offset plus the standard steady clock,
+/// from the registered shared memory.
+///
+/// # References
+///
+/// - [switchbrew/nx: `__syscall_clock_gettime`](https://github.com/switchbrew/libnx/blob/60bf943ec14b1fb2ae169e627e64ab93a24c042b/nx/source/runtime/newlib.c#L361-L386)
 pub fn gettime() -> Result<Timespec, i32> {
-    todo!()
+    let base = SHARED_MEMORY.load(Ordering::Acquire);
+    if base.is_null() {
+        return Err(EINVAL);
+    }
+
+    // SAFETY: A registered pointer is a live mapping of the time shared memory.
+    let (steady, context) = unsafe {
+        (
+            read::<SteadyClockTimePoint>(base, STEADY_CLOCK_OFFSET),
+            read::<SystemClockContext>(base, USER_SYSTEM_CLOCK_OFFSET),
+        )
+    };
+    if steady.source_id != context.source_id {
+        return Err(EINVAL);
+    }
+
+    let tick_ns = aarch64::cpu_ticks_to_ns(aarch64::get_system_tick()) as i64;
+    let now_ns = steady
+        .base_time
+        .wrapping_add(tick_ns)
+        .wrapping_add(context.offset.wrapping_mul(NSEC_PER_SEC));
+
+    // SAFETY: `rem_euclid` keeps the nanoseconds in `0..NSEC_PER_SEC`.
+    unsafe {
+        Ok(Timespec::new_unchecked(
+            now_ns.div_euclid(NSEC_PER_SEC),
+            now_ns.rem_euclid(NSEC_PER_SEC),
+        ))
+    }
+}
+
+/// Reads a double-buffered entry, retrying while the writer updates it.
+///
+/// # Safety
+///
+/// `base + offset` must point to a double-buffered entry of `T`.
+unsafe fn read<T: Copy>(base: *const u8, offset: usize) -> T {
+    // SAFETY: The caller guarantees the entry is in the mapping.
+    let entry = unsafe { &*(base.add(offset) as *const DoubleBufferedEntry<T>) };
+
+    loop {
+        let counter = entry.counter.load(Ordering::Acquire);
+        // SAFETY: Both buffers are always initialized.
+        let value = unsafe { ptr::read_volatile(&entry.buffers[(counter & 1) as usize]) };
+        // Orders the data loads before the counter reload on the CPU too (`dmb ishld`), as
+        // the writer runs on another core
+        fence(Ordering::Acquire);
+
+        if entry.counter.load(Ordering::Acquire) == counter {
+            return value;
+        }
+    }
 }
@@ -0,0 +1,458 @@
+//! Hierarchical timer wheel.
+//!
+//! A [`TimerWheel`] keeps any number of pending timers for a single driver — a timer
+//! thread or an executor — which waits until [`TimerWheel::next_deadline`] and then calls
+//! [`TimerWheel::advance`] to fire the expired timers.
+//!
+//! Time is split in ticks of the wheel resolution. Timers are kept in [`LEVELS`] levels of
+//! 64 slots each, the slots of level `n` spanning `64^n` ticks: inserting and removing a
+//! timer is `O(1)`, and a timer is moved down a level at most [`LEVELS`] times before it
+//! fires. Deadlines are rounded up to the next tick, so that timers never fire early.
+//! Timers further than `64^LEVELS` ticks away are parked in the last level, and moved back
+//! as time passes.
+
+use alloc::vec::Vec;
+
+use crate::{Duration, Instant};
+
+/// Number of levels of the wheel.
+pub const LEVELS: usize = 6;
+
+/// Number of bits of the tick selecting a slot, per level.
+const LEVEL_BITS: u32 = 6;
+
+/// Number of slots per level.
+const SLOTS: usize = 1 << LEVEL_BITS;
+
+/// Furthest placement ahead of the current tick, so that a parked timer never lands in the
+/// slot of the current tick of the last level.
+const MAX_OFFSET: u64 =
+    (1 << (LEVEL_BITS * LEVELS as u32)) - (1 << (LEVEL_BITS * (LEVELS as u32 - 1)));
+
+/// List of the timers whose deadline already passed, after the slot lists.
+const EXPIRED: usize = LEVELS * SLOTS;
+
+/// Marker of a free entry, in place of its list.
+const FREE: u16 = u16::MAX;
+
+/// End of a list.
+const NIL: u32 = u32::MAX;
+
+/// Key of a timer inserted in a [`TimerWheel`], to remove it.
+///
+/// Keys of fired or removed timers are stale: the timer of a stale key is never found,
+/// even once its entry is reused.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct TimerKey {
+    index: u32,
+    generation: u32,
+}
+
+/// A hierarchical timer wheel, holding a value per timer.
+pub struct TimerWheel<T> {
+    origin: Instant,
+    resolution_ns: u64,
+    /// Current tick, since `origin`.
+    now: u64,
+    entries: Vec<Entry<T>>,
+    /// First free entry.
+    free: u32,
+    /// First entry of every slot list, then of the [`EXPIRED`] list.
+    heads: [u32; LEVELS * SLOTS + 1],
+    /// Non-empty slots, per level.
+    occupied: [u64; LEVELS],
+    len: usize,
+}
+
+struct Entry<T> {
+    /// Deadline tick.
+    deadline: u64,
+    /// List holding the entry, or [`FREE`].
+    list: u16,
+    prev: u32,
+    /// Next entry of the list, or of the free list.
+    next: u32,
+    generation: u32,
+    value: Option<T>,
+}
+
+impl<T> TimerWheel<T> {
+    /// Creates an empty wheel, ticking every `resolution`, starting now.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `resolution` is shorter than a nanosecond.
+    pub fn new(resolution: Duration) -> Self {
+        let resolution_ns = resolution.as_nanos().min(u64::MAX as u128) as u64;
+        assert!(resolution_ns > 0, "timer wheel resolution must not be zero");
+
+        Self {
+            origin: Instant::now(),
+            resolution_ns,
+            now: 0,
+            entries: Vec::new(),
+            free: NIL,
+            heads: [NIL; LEVELS * SLOTS + 1],
+            occupied: [0; LEVELS],
+            len: 0,
+        }
+    }
+
+    /// Returns the number of pending timers.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Returns `true` if no timer is pending.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Inserts a timer expiring at `deadline`.
+    ///
+    /// A deadline that already passed fires on the next [`TimerWheel::advance`].
+    pub fn insert(&mut self, deadline: Instant, value: T) -> TimerKey {
+        let deadline = self.tick_at(deadline, true);
+
+        let index = match self.free {
+            NIL => {
+                let index = u32::try_from(self.entries.len()).expect("too many timers");
+                self.entries.push(Entry {
+                    deadline: 0,
+                    list: FREE,
+                    prev: NIL,
+                    next: NIL,
+                    generation: 0,
+                    value: None,
+                });
+                index
+            }
+            index => {
+                self.free = self.entries[index as usize].next;
+                index
+            }
+        };
+
+        self.entries[index as usize].value = Some(value);
+        self.place(index, deadline);
+        self.len += 1;
+
+        TimerKey {
+            index,
+            generation: self.entries[index as usize].generation,
+        }
+    }
+
+    /// Removes the timer `key`, returning its value if it was still pending.
+    pub fn remove(&mut self, key: TimerKey) -> Option<T> {
+        self.entry(key)?;
+        self.unlink(key.index);
+        Some(self.release(key.index))
+    }
+
+    /// Returns the value of the timer `key`, if it is still pending.
+    pub fn get_mut(&mut self, key: TimerKey) -> Option<&mut T> {
+        self.entry(key)?;
+        self.entries[key.index as usize].value.as_mut()
+    }
+
+    /// Returns the instant the driver must call [`TimerWheel::advance`] at, or `None` if no
+    /// timer is pending.
+    ///
+    /// The instant is never later than the deadline of the earliest timer, but may be
+    /// earlier: the timers of the upper levels only get their exact deadline once they
+    /// are moved down, and advancing to it fires nothing.
+    pub fn next_deadline(&self) -> Option<Instant> {
+        let (_, tick) = self.next_expiration()?;
+        let offset = Duration::from_nanos(tick.saturating_mul(self.resolution_ns));
+        self.origin.checked_add(offset)
+    }
+
+    /// Fires the timers whose deadline is at or before `now`, calling `fire` with the key
+    /// and value of each.
+    pub fn advance(&mut self, now: Instant, mut fire: impl FnMut(TimerKey, T)) {
+        let target = self.tick_at(now, false);
+
+        while let Some((list, tick)) = self.next_expiration() {
+            if tick > target {
+                break;
+            }
+            self.now = self.now.max(tick);
+
+            let mut index = core::mem::replace(&mut self.heads[list], NIL);
+            if list != EXPIRED {
+                self.occupied[list / SLOTS] &= !(1 << (list % SLOTS));
+            }
+
+            while index != NIL {
+                let entry = &self.entries[index as usize];
+                let (next, deadline) = (entry.next, entry.deadline);
+                if deadline <= self.now {
+                    let key = TimerKey {
+                        index,
+                        generation: entry.generation,
+                    };
+                    let value = self.release(index);
+                    fire(key, value);
+                } else {
+                    // Moved down to a lower level, or further along the last one
+                    self.place(index, deadline);
+                }
+                index = next;
+            }
+        }
+
+        self.now = self.now.max(target);
+    }
+
+    /// Returns the tick of `instant`, rounded up or down.
+    fn tick_at(&self, instant: Instant, round_up: bool) -> u64 {
+        let ns = instant.saturating_duration_since(self.origin).as_nanos();
+        let res = self.resolution_ns as u128;
+        let tick = if round_up { ns.div_ceil(res) } else { ns / res };
+        tick.min(u64::MAX as u128) as u64
+    }
+
+    /// Returns the entry of a pending timer.
+    fn entry(&self, key: TimerKey) -> Option<&Entry<T>> {
+        self.entries
+            .get(key.index as usize)
+            .filter(|entry| entry.list != FREE && entry.generation == key.generation)
+    }
+
+    /// Returns the next list to expire, with the tick it expires at.
+    fn next_expiration(&self) -> Option<(usize, u64)> {
+        if self.heads[EXPIRED] != NIL {
+            return Some((EXPIRED, self.now));
+        }
+
+        // Every timer of a level expires before the timers of the levels above it
+        let level = self.occupied.iter().position(|&occupied| occupied != 0)?;
+        let shift = LEVEL_BITS * level as u32;
+        let slot_range = 1u64 << shift;
+        let level_range = slot_range << LEVEL_BITS;
+
+        let now_slot = ((self.now >> shift) as usize) % SLOTS;
+        let rotated = self.occupied[level].rotate_right(now_slot as u32);
+        let slot = (now_slot + rotated.trailing_zeros() as usize) % SLOTS;
+
+        let mut tick = (self.now & !(level_range - 1)) + slot as u64 * slot_range;
+        if tick <= self.now {
+            // A slot of the next round of the level
+            tick += level_range;
+        }
+        Some((level * SLOTS + slot, tick))
+    }
+
+    /// Puts the entry `index` in the list of the `deadline` tick.
+    fn place(&mut self, index: u32, deadline: u64) {
+        let list = if deadline <= self.now {
+            EXPIRED
+        } else {
+            let placed = deadline.min(self.now.saturating_add(MAX_OFFSET));
+            // The level of the most significant bit that differs from the current tick
+            let significant =
+                u64::BITS - 1 - ((self.now ^ placed) | (SLOTS as u64 - 1)).leading_zeros();
+            let level = ((significant / LEVEL_BITS) as usize).min(LEVELS - 1);
+            let slot = ((placed >> (LEVEL_BITS * level as u32)) as usize) % SLOTS;
+
+            self.occupied[level] |= 1 << slot;
+            level * SLOTS + slot
+        };
+
+        let head = self.heads[list];
+        if head != NIL {
+            self.entries[head as usize].prev = index;
+        }
+        let entry = &mut self.entries[index as usize];
+        entry.deadline = deadline;
+        entry.list = list as u16;
+        entry.prev = NIL;
+        entry.next = head;
+        self.heads[list] = index;
+    }
+
+    /// Takes the entry `index` out of its list.
+    fn unlink(&mut self, index: u32) {
+        let entry = &self.entries[index as usize];
+        let (list, prev, next) = (entry.list as usize, entry.prev, entry.next);
+
+        match prev {
+            NIL => self.heads[list] = next,
+            prev => self.entries[prev as usize].next = next,
+        }
+        if next != NIL {
+            self.entries[next as usize].prev = prev;
+        }
+        if list != EXPIRED && self.heads[list] == NIL {
+            self.occupied[list / SLOTS] &= !(1 << (list % SLOTS));
+        }
+    }
+
+    /// Frees the unlinked entry `index`, returning its value.
+    fn release(&mut self, index: u32) -> T {
+        let entry = &mut self.entries[index as usize];
+        entry.list = FREE;
+        entry.generation = entry.generation.wrapping_add(1);
+        entry.next = self.free;
+        self.free = index;
+        self.len -= 1;
+        entry.value.take().expect("pending timer has a value")
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use alloc::vec::Vec;
+
+    use super::*;
+
+    /// Returns the instant of `tick`, at a resolution of a microsecond.
+    fn at(origin: Instant, tick: u64) -> Instant {
+        origin + Duration::from_micros(tick)
+    }
+
+    /// Advances `wheel` to each of its next deadlines up to `end`, returning the fired
+    /// values, which are their deadline ticks.
+    ///
+    /// Fails if a timer fires before its deadline.
+    fn drain(wheel: &mut TimerWheel<u64>, end: u64) -> Vec<u64> {
+        let origin = wheel.origin;
+        let mut fired = Vec::new();
+        while let Some(deadline) = wheel.next_deadline() {
+            if deadline > at(origin, end) {
+                break;
+            }
+            wheel.advance(deadline, |_, tick| {
+                assert!(at(origin, tick) <= deadline, "timer {tick} fired early");
+                fired.push(tick);
+            });
+        }
+        fired
+    }
+
+    #[test]
+    fn test_fires_in_deadline_order_across_levels() {
+        let mut wheel = TimerWheel::new(Duration::from_micros(1));
+        let origin = wheel.origin;
+
+        // Both sides of the boundaries of the first four levels, in no particular order
+        let ticks = [
+            4097, 1, 262_144, 64, 16_777_217, 63, 4096, 262_143, 65, 4095, 16_777_215, 2, 262_145,
+            16_777_216,
+        ];
+        for tick in ticks {
+            wheel.insert(at(origin, tick), tick);
+        }
+
+        let fired = drain(&mut wheel, 20_000_000);
+
+        let mut expected = ticks;
+        expected.sort_unstable();
+        assert_eq!(fired, expected);
+        assert!(wheel.is_empty());
+    }
+
+    #[test]
+    fn test_fires_all_expired_in_order_in_one_advance() {
+        let mut wheel = TimerWheel::new(Duration::from_micros(1));
+        let origin = wheel.origin;
+
+        let ticks = [300_000, 5, 4096, 64, 70_000, 63];
+        for tick in ticks {
+            wheel.insert(at(origin, tick), tick);
+        }
+
+        let mut fired = Vec::new();
+        wheel.advance(at(origin, 300_000), |_, tick| fired.push(tick));
+
+        let mut expected = ticks;
+        expected.sort_unstable();
+        assert_eq!(fired, expected);
+    }
+
+    #[test]
+    fn test_deadline_beyond_max_offset() {
+        let mut wheel = TimerWheel::new(Duration::from_micros(1));
+        let origin = wheel.origin;
+
+        let far = MAX_OFFSET + 1000;
+        let further = 3 * MAX_OFFSET;
+        wheel.insert(at(origin, further), further);
+        wheel.insert(at(origin, far), far);
+
+        // The parked timers do not fire before their deadline
+        let fired = drain(&mut wheel, far - 1);
+        assert!(fired.is_empty());
+        assert!(wheel.next_deadline().unwrap() <= at(origin, far));
+
+        wheel.advance(at(origin, far - 1), |_, tick| {
+            panic!("timer {tick} fired early")
+        });
+        assert_eq!(wheel.len(), 2);
+
+        let fired = drain(&mut wheel, far);
+        assert_eq!(fired, [far]);
+
+        let fired = drain(&mut wheel, further - 1);
+        assert!(fired.is_empty());
+
+        let fired = drain(&mut wheel, further);
+        assert_eq!(fired, [further]);
+        assert!(wheel.is_empty());
+    }
+
+    #[test]
+    fn test_past_deadline_fires_on_next_advance() {
+        let mut wheel = TimerWheel::new(Duration::from_micros(1));
+        let origin = wheel.origin;
+
+        wheel.advance(at(origin, 100), |_, tick: u64| panic!("timer {tick} fired"));
+
+        wheel.insert(at(origin, 10), 10);
+        wheel.insert(origin, 0);
+        assert!(wheel.next_deadline().unwrap() <= at(origin, 100));
+
+        // Without time passing
+        let mut fired = Vec::new();
+        wheel.advance(at(origin, 100), |_, tick| fired.push(tick));
+        fired.sort_unstable();
+        assert_eq!(fired, [0, 10]);
+        assert!(wheel.is_empty());
+        assert_eq!(wheel.next_deadline(), None);
+    }
+
+    #[test]
+    fn test_stale_key_is_never_found() {
+        let mut wheel = TimerWheel::new(Duration::from_micros(1));
+        let origin = wheel.origin;
+
+        let removed = wheel.insert(at(origin, 10), 1);
+        assert_eq!(wheel.remove(removed), Some(1));
+        assert_eq!(wheel.remove(removed), None);
+        assert_eq!(wheel.get_mut(removed), None);
+
+        // The entry of the removed timer is reused
+        let reused = wheel.insert(at(origin, 10), 2);
+        assert_eq!(reused.index, removed.index);
+        assert_eq!(wheel.remove(removed), None);
+        assert_eq!(wheel.get_mut(removed), None);
+        assert_eq!(wheel.len(), 1);
+
+        *wheel.get_mut(reused).unwrap() = 3;
+
+        let mut fired = Vec::new();
+        wheel.advance(at(origin, 10), |key, value| fired.push((key, value)));
+        assert_eq!(fired, [(reused, 3)]);
+
+        // Fired keys are stale too
+        assert_eq!(wheel.remove(reused), None);
+        let again = wheel.insert(at(origin, 20), 4);
+        assert_eq!(again.index, reused.index);
+        assert_eq!(wheel.remove(reused), None);
+        assert_eq!(wheel.remove(removed), None);
+        assert_eq!(wheel.remove(again), Some(4));
+    }
+}
@@ -3,6 +3,7 @@
 #include <switch.h>
 
 #include "harness.h"
+#include "mem/suite.h"
 #include "rand/suite.h"
 #include "sync/suite.h"
 
@@ -10,6 +11,8 @@
  * Test suites
  */
 static TestSuiteFn test_suites[] = {
+    // memory
+    mem_suite,
     // random
     rand_suite,
     // sync
@@ -20,6 +23,7 @@ static TestSuiteFn test_suites[] = {
     sync_rwlock_suite,
     sync_semaphore_suite,
     sync_oneshot_suite,
+    sync_channel_suite,
 };
 
 int main()
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../harness.h"
+
+/**
+ * @brief Test memcpy on every size up to 300 bytes, at every source and destination alignment.
+ *
+ * The functions are called through volatile pointers, so that the compiler does not expand
+ * them inline: with the `use_nx_mem` option, these are the nx-std implementations.
+ */
+test_rc_t test_0001_memcpy_all_sizes_and_alignments(void);
+
+/**
+ * @brief Test memmove with overlapping ranges, copying both forwards and backwards.
+ */
+test_rc_t test_0002_memmove_overlapping_both_directions(void);
+
+/**
+ * @brief Test memset with zero and non-zero values, up to sizes well above the DC ZVA threshold.
+ */
+test_rc_t test_0003_memset_zero_and_non_zero(void);
+
+/**
+ * @brief Test that memcmp returns the sign of the first differing bytes, compared unsigned.
+ */
+test_rc_t test_0004_memcmp_result_sign(void);
+
+/**
+ * @brief Test strlen on strings ending right before an inaccessible page.
+ */
+test_rc_t test_0005_strlen_before_page_boundary(void);
+
+/**
+ * Test suite for the C memory and string functions.
+ */
+static void mem_suite(void) {
+    TEST_SUITE("mem");
+
+    TEST_CASE(
+        "Test 0001: memcpy_all_sizes_and_alignments",
+        test_0001_memcpy_all_sizes_and_alignments
+    )
+    TEST_CASE(
+        "Test 0002: memmove_overlapping_both_directions",
+        test_0002_memmove_overlapping_both_directions
+    )
+    TEST_CASE(
+        "Test 0003: memset_zero_and_non_zero",
+        test_0003_memset_zero_and_non_zero
+    )
+    TEST_CASE(
+        "Test 0004: memcmp_result_sign",
+        test_0004_memcmp_result_sign
+    )
+    TEST_CASE(
+        "Test 0005: strlen_before_page_boundary",
+        test_0005_strlen_before_page_boundary
+    )
+}
@@ -0,0 +1,63 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <switch.h>
+
+#include "../harness.h"
+
+#define MAX_SIZE 300
+#define ALIGNMENTS 16
+#define GUARD 0xA5
+#define BUF_SIZE (ALIGNMENTS + MAX_SIZE + ALIGNMENTS)
+
+static void* (*volatile memcpy_fn)(void*, const void*, size_t) = memcpy;
+
+static uint8_t g_src[BUF_SIZE] __attribute__((aligned(16)));
+static uint8_t g_dst[BUF_SIZE] __attribute__((aligned(16)));
+
+/**
+ * Test memcpy on every size from 0 to 300 bytes, at every source and destination
+ * alignment modulo 16.
+ * - The copied range must match the source
+ * - The destination bytes around the range must be left untouched
+ * - The destination pointer must be returned
+ */
+test_rc_t test_0001_memcpy_all_sizes_and_alignments(void) {
+    Result rc = 0;
+
+    //* Given
+    // A source pattern without repeating bytes at short distances
+    for (size_t i = 0; i < BUF_SIZE; i++) {
+        g_src[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    for (size_t n = 0; n <= MAX_SIZE; n++) {
+        for (size_t src_align = 0; src_align < ALIGNMENTS; src_align++) {
+            for (size_t dst_align = 0; dst_align < ALIGNMENTS; dst_align++) {
+                memset(g_dst, GUARD, sizeof(g_dst));
+
+                //* When
+                void* ret = memcpy_fn(g_dst + dst_align, g_src + src_align, n);
+
+                //* Then
+                if (ret != g_dst + dst_align) {
+                    rc = TEST_ASSERTION_FAILED;
+                    goto test_cleanup;
+                }
+                for (size_t i = 0; i < BUF_SIZE; i++) {
+                    uint8_t expected = (i >= dst_align && i < dst_align + n)
+                        ? g_src[src_align + i - dst_align]
+                        : GUARD;
+                    if (g_dst[i] != expected) {
+                        rc = TEST_ASSERTION_FAILED;
+                        goto test_cleanup;
+                    }
+                }
+            }
+        }
+    }
+
+test_cleanup:
+    return rc;
+}
@@ -0,0 +1,82 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <switch.h>
+
+#include "../harness.h"
+
+#define MAX_SIZE 300
+#define ALIGNMENTS 16
+#define BUF_SIZE (ALIGNMENTS + 256 + MAX_SIZE + ALIGNMENTS)
+
+static void* (*volatile memmove_fn)(void*, const void*, size_t) = memmove;
+
+// Distances between the source and the destination, on both sides of the copy widths
+static const size_t SHIFTS[] = {1, 2, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 128, 255};
+
+static uint8_t g_buf[BUF_SIZE] __attribute__((aligned(16)));
+static uint8_t g_expected[BUF_SIZE] __attribute__((aligned(16)));
+
+/**
+ * Runs one memmove of `n` bytes from `src` to `dst` offsets in the test buffer, and checks
+ * the whole buffer against a byte-by-byte reference.
+ */
+static bool check_move(size_t dst, size_t src, size_t n) {
+    for (size_t i = 0; i < BUF_SIZE; i++) {
+        g_buf[i] = (uint8_t)(i * 13 + 5);
+        g_expected[i] = g_buf[i];
+    }
+
+    // Reference: copy through the direction that does not overwrite unread bytes
+    if (dst < src) {
+        for (size_t i = 0; i < n; i++) {
+            g_expected[dst + i] = g_expected[src + i];
+        }
+    } else {
+        for (size_t i = n; i > 0; i--) {
+            g_expected[dst + i - 1] = g_expected[src + i - 1];
+        }
+    }
+
+    void* ret = memmove_fn(g_buf + dst, g_buf + src, n);
+
+    return ret == g_buf + dst && memcmp(g_buf, g_expected, BUF_SIZE) == 0;
+}
+
+/**
+ * Test memmove with overlapping ranges.
+ * - Forward moves (destination below the source) and backward moves (destination above)
+ * - Every size from 0 to 300 bytes, every source alignment modulo 16
+ * - Distances from 1 byte to past the 64-byte block size
+ */
+test_rc_t test_0002_memmove_overlapping_both_directions(void) {
+    Result rc = 0;
+
+    for (size_t n = 0; n <= MAX_SIZE; n++) {
+        for (size_t align = 0; align < ALIGNMENTS; align++) {
+            for (size_t s = 0; s < sizeof(SHIFTS) / sizeof(SHIFTS[0]); s++) {
+                const size_t shift = SHIFTS[s];
+                const size_t low = align;
+                const size_t high = align + shift;
+
+                //* When / Then
+                // Forward: the destination is below the source
+                if (!check_move(low, high, n)) {
+                    rc = TEST_ASSERTION_FAILED;
+                    goto test_cleanup;
+                }
+
+                // Backward: the destination is above the source
+                if (!check_move(high, low, n)) {
+                    rc = TEST_ASSERTION_FAILED;
+                    goto test_cleanup;
+                }
+            }
+        }
+    }
+
+test_cleanup:
+    return rc;
+}
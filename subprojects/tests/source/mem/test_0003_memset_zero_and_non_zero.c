@@ -0,0 +1,91 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <switch.h>
+
+#include "../harness.h"
+
+#define MAX_SMALL_SIZE 300
+#define ALIGNMENTS 16
+#define GUARD 0xA5
+#define MAX_LARGE_SIZE (16384 + 7)
+#define BUF_SIZE (ALIGNMENTS + MAX_LARGE_SIZE + ALIGNMENTS)
+
+static void* (*volatile memset_fn)(void*, int, size_t) = memset;
+
+// Fill values: zero fills of 256 bytes and two cache blocks or more use DC ZVA
+static const int VALUES[] = {0x00, 0x5A, 0xFF};
+
+// Sizes around and well above the DC ZVA threshold, and not multiples of the cache block
+static const size_t LARGE_SIZES[] = {
+    256, 257, 320, 511, 512, 513, 1000, 4096, 4096 + 13, 8192 - 1, MAX_LARGE_SIZE,
+};
+
+static uint8_t g_buf[BUF_SIZE] __attribute__((aligned(64)));
+
+/**
+ * Fills `n` bytes at the `offset` of the test buffer with `c`, and checks the range and the
+ * guard bytes around it.
+ */
+static bool check_fill(size_t offset, int c, size_t n) {
+    memset(g_buf, GUARD, offset + n + ALIGNMENTS);
+
+    void* ret = memset_fn(g_buf + offset, c, n);
+    if (ret != g_buf + offset) {
+        return false;
+    }
+
+    for (size_t i = 0; i < offset + n + ALIGNMENTS; i++) {
+        uint8_t expected = (i >= offset && i < offset + n) ? (uint8_t)c : GUARD;
+        if (g_buf[i] != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Test memset with zero and non-zero values.
+ * - Every size from 0 to 300 bytes at every alignment modulo 16
+ * - Sizes up to 16 KiB, above the DC ZVA threshold, at every alignment modulo 16
+ * - Only the low byte of the value is stored
+ */
+test_rc_t test_0003_memset_zero_and_non_zero(void) {
+    Result rc = 0;
+
+    for (size_t v = 0; v < sizeof(VALUES) / sizeof(VALUES[0]); v++) {
+        for (size_t align = 0; align < ALIGNMENTS; align++) {
+            //* When / Then
+            // Small sizes
+            for (size_t n = 0; n <= MAX_SMALL_SIZE; n++) {
+                if (!check_fill(align, VALUES[v], n)) {
+                    rc = TEST_ASSERTION_FAILED;
+                    goto test_cleanup;
+                }
+            }
+
+            // Large sizes
+            for (size_t s = 0; s < sizeof(LARGE_SIZES) / sizeof(LARGE_SIZES[0]); s++) {
+                if (!check_fill(align, VALUES[v], LARGE_SIZES[s])) {
+                    rc = TEST_ASSERTION_FAILED;
+                    goto test_cleanup;
+                }
+            }
+        }
+    }
+
+    // The value is converted to an unsigned char
+    memset(g_buf, GUARD, 64);
+    memset_fn(g_buf, 0x15A, 32);
+    for (size_t i = 0; i < 64; i++) {
+        if (g_buf[i] != (i < 32 ? 0x5A : GUARD)) {
+            rc = TEST_ASSERTION_FAILED;
+            goto test_cleanup;
+        }
+    }
+
+test_cleanup:
+    return rc;
+}
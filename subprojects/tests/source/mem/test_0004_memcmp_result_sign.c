@@ -0,0 +1,89 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <switch.h>
+
+#include "../harness.h"
+
+#define MAX_SIZE 300
+#define ALIGNMENTS 16
+#define BUF_SIZE (ALIGNMENTS + MAX_SIZE)
+
+static int (*volatile memcmp_fn)(const void*, const void*, size_t) = memcmp;
+
+static uint8_t g_a[BUF_SIZE] __attribute__((aligned(16)));
+static uint8_t g_b[BUF_SIZE] __attribute__((aligned(16)));
+
+/**
+ * Returns -1, 0 or 1 for the sign of `value`.
+ */
+static inline int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+/**
+ * Test that memcmp returns the sign of the difference of the first differing bytes.
+ * - Equal ranges compare as zero, whatever follows them
+ * - A single differing byte at every position of every size up to 300 bytes, at several
+ *   alignments of both operands, in both orders
+ * - Bytes compare as unsigned: 0x80 is greater than 0x7F
+ * - Only the first difference counts, even if a later one has the opposite sign
+ */
+test_rc_t test_0004_memcmp_result_sign(void) {
+    Result rc = 0;
+
+    for (size_t a_align = 0; a_align < ALIGNMENTS; a_align += 3) {
+        for (size_t b_align = 0; b_align < ALIGNMENTS; b_align += 5) {
+            for (size_t n = 0; n <= MAX_SIZE; n++) {
+                //* Given
+                uint8_t* a = g_a + a_align;
+                uint8_t* b = g_b + b_align;
+                for (size_t i = 0; i < n; i++) {
+                    a[i] = (uint8_t)(i * 31 + 3);
+                    b[i] = a[i];
+                }
+
+                //* When / Then
+                // Equal ranges
+                if (memcmp_fn(a, b, n) != 0) {
+                    rc = TEST_ASSERTION_FAILED;
+                    goto test_cleanup;
+                }
+
+                for (size_t pos = 0; pos < n; pos++) {
+                    const uint8_t saved_a = a[pos];
+                    const uint8_t saved_b = b[pos];
+
+                    // Unsigned order: 0x80 > 0x7F
+                    a[pos] = 0x80;
+                    b[pos] = 0x7F;
+                    // A later difference of the opposite sign must not matter
+                    if (pos + 1 < n) {
+                        b[pos + 1] = (uint8_t)(a[pos + 1] + 1);
+                    }
+
+                    if (sign(memcmp_fn(a, b, n)) != 1 || sign(memcmp_fn(b, a, n)) != -1) {
+                        rc = TEST_ASSERTION_FAILED;
+                        goto test_cleanup;
+                    }
+
+                    // Comparing only the bytes before the difference
+                    if (memcmp_fn(a, b, pos) != 0) {
+                        rc = TEST_ASSERTION_FAILED;
+                        goto test_cleanup;
+                    }
+
+                    a[pos] = saved_a;
+                    b[pos] = saved_b;
+                    if (pos + 1 < n) {
+                        b[pos + 1] = a[pos + 1];
+                    }
+                }
+            }
+        }
+    }
+
+test_cleanup:
+    return rc;
+}
@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <switch.h>
+
+#include "../harness.h"
+
+#define PAGE_SIZE 0x1000
+#define MAX_LEN 100
+
+static size_t (*volatile strlen_fn)(const char*) = strlen;
+
+/**
+ * Test strlen on strings whose terminator is the last byte before an inaccessible page.
+ * - Every length from 0 to 100, so the string starts at every alignment modulo 16
+ * - Reading past the terminator would fault on the protected page
+ * - The same strings away from the boundary return the same lengths
+ */
+test_rc_t test_0005_strlen_before_page_boundary(void) {
+    Result rc = 0;
+
+    //* Given
+    // Two pages, the second one made inaccessible
+    uint8_t* pages = aligned_alloc(PAGE_SIZE, 2 * PAGE_SIZE);
+    if (pages == NULL) {
+        return TEST_ASSERTION_FAILED;
+    }
+    memset(pages, 'x', 2 * PAGE_SIZE);
+
+    rc = svcSetMemoryPermission(pages + PAGE_SIZE, PAGE_SIZE, Perm_None);
+    if (R_FAILED(rc)) {
+        free(pages);
+        return rc;
+    }
+
+    char* const end = (char*)pages + PAGE_SIZE - 1;
+    *end = '\0';
+
+    for (size_t len = 0; len <= MAX_LEN; len++) {
+        //* When
+        const char* s = end - len;
+        const size_t at_boundary = strlen_fn(s);
+
+        //* Then
+        if (at_boundary != len) {
+            rc = TEST_ASSERTION_FAILED;
+            goto test_cleanup;
+        }
+    }
+
+    // Away from the boundary, at every alignment
+    for (size_t align = 0; align < 16; align++) {
+        for (size_t len = 0; len <= MAX_LEN; len++) {
+            char* s = (char*)pages + 64 + align;
+            s[len] = '\0';
+            const size_t result = strlen_fn(s);
+            s[len] = 'x';
+            if (result != len) {
+                rc = TEST_ASSERTION_FAILED;
+                goto test_cleanup;
+            }
+        }
+    }
+
+test_cleanup:
+    svcSetMemoryPermission(pages + PAGE_SIZE, PAGE_SIZE, Perm_Rw);
+    free(pages);
+    return rc;
+}
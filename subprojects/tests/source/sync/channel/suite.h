@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../../harness.h"
+
+/**
+ * Test that try_send fills the channel up to its rounded capacity, and try_recv returns the
+ * values in order until it is empty.
+ */
+test_rc_t test_0001_channel_try_send_try_recv_single_thread(void);
+
+/**
+ * Test that every value sent by several producer threads is received exactly once by several
+ * consumer threads.
+ */
+test_rc_t test_0002_channel_multiple_producers_multiple_consumers(void);
+
+/**
+ * Test that a blocked recv fails when all senders are freed.
+ */
+test_rc_t test_0003_channel_recv_senders_freed(void);
+
+/**
+ * Test that a send blocked on a full channel fails when all receivers are freed.
+ */
+test_rc_t test_0004_channel_send_receivers_freed(void);
+
+/**
+ * Test suite for sync/channel.
+ */
+static void sync_channel_suite(void) {
+    TEST_SUITE("sync/channel");
+
+    TEST_CASE(
+        "Test 0001: channel_try_send_try_recv_single_thread",
+        test_0001_channel_try_send_try_recv_single_thread
+    )
+    TEST_CASE(
+        "Test 0002: channel_multiple_producers_multiple_consumers",
+        test_0002_channel_multiple_producers_multiple_consumers
+    )
+    TEST_CASE(
+        "Test 0003: channel_recv_senders_freed",
+        test_0003_channel_recv_senders_freed
+    )
+    TEST_CASE(
+        "Test 0004: channel_send_receivers_freed",
+        test_0004_channel_send_receivers_freed
+    )
+}
@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <switch.h>
+
+#include "../../harness.h"
+#include "nx_sync_channel.h"
+
+#define REQUESTED_CAPACITY 3
+#define ROUNDED_CAPACITY 4
+
+/**
+ * Test that try_send fills the channel up to its rounded capacity, and try_recv returns the
+ * values in order until it is empty.
+ * - Creating a channel with zero capacity fails
+ * - try_send succeeds 4 times on a channel of capacity 3, then reports it full
+ * - try_recv returns the values in send order, then reports it empty
+ */
+test_rc_t test_0001_channel_try_send_try_recv_single_thread(void) {
+    Result rc = 0;
+
+    //* Given
+    // Create channel
+    NxSyncChannelSender* sender = NULL;
+    NxSyncChannelReceiver* receiver = NULL;
+    if (__nx_std_sync__channel_create(0, &sender, &receiver) != -1) {
+        return TEST_ASSERTION_FAILED;
+    }
+    if (__nx_std_sync__channel_create(REQUESTED_CAPACITY, &sender, &receiver) != 0) {
+        return TEST_ASSERTION_FAILED;
+    }
+
+    //* When
+    // Fill the channel
+    int32_t send_rcs[ROUNDED_CAPACITY];
+    for (uintptr_t i = 0; i < ROUNDED_CAPACITY; i++) {
+        send_rcs[i] = __nx_std_sync__channel_try_send(sender, (void*)(i + 1));
+    }
+    int32_t full_rc = __nx_std_sync__channel_try_send(sender, (void*)(uintptr_t)0xDEADBEEF);
+
+    // Drain the channel
+    void* values[ROUNDED_CAPACITY] = {NULL};
+    int32_t recv_rcs[ROUNDED_CAPACITY];
+    for (uintptr_t i = 0; i < ROUNDED_CAPACITY; i++) {
+        recv_rcs[i] = __nx_std_sync__channel_try_recv(receiver, &values[i]);
+    }
+    void* empty_value = NULL;
+    int32_t empty_rc = __nx_std_sync__channel_try_recv(receiver, &empty_value);
+
+    //* Then
+    // Verify the sends succeeded until the channel was full
+    for (uintptr_t i = 0; i < ROUNDED_CAPACITY; i++) {
+        if (send_rcs[i] != 0) {
+            rc = TEST_ASSERTION_FAILED;
+            goto test_cleanup;
+        }
+    }
+    if (full_rc != 1) {
+        rc = TEST_ASSERTION_FAILED;
+        goto test_cleanup;
+    }
+
+    // Verify the values were received in order until the channel was empty
+    for (uintptr_t i = 0; i < ROUNDED_CAPACITY; i++) {
+        if (recv_rcs[i] != 0 || (uintptr_t)values[i] != i + 1) {
+            rc = TEST_ASSERTION_FAILED;
+            goto test_cleanup;
+        }
+    }
+    if (empty_rc != 1) {
+        rc = TEST_ASSERTION_FAILED;
+        goto test_cleanup;
+    }
+
+test_cleanup:
+    __nx_std_sync__channel_sender_free(sender);
+    __nx_std_sync__channel_receiver_free(receiver);
+
+    return rc;
+}
@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <switch.h>
+
+#include "../../harness.h"
+#include "nx_sync_channel.h"
+
+#define CHANNEL_CAPACITY 8
+#define PRODUCER_COUNT 4
+#define CONSUMER_COUNT 2
+#define VALUES_PER_PRODUCER 256
+#define VALUE_COUNT (PRODUCER_COUNT * VALUES_PER_PRODUCER)
+
+static NxSyncChannelSender* g_senders[PRODUCER_COUNT];
+static NxSyncChannelReceiver* g_receivers[CONSUMER_COUNT];
+static uint8_t g_received[VALUE_COUNT];
+static uint32_t g_received_counts[CONSUMER_COUNT];
+
+/**
+ * Producer thread function: sends its range of values, then frees its sender.
+ */
+static void producer_thread_func(void *arg) {
+    const uintptr_t num = (uintptr_t) arg;
+
+    for (uintptr_t i = 0; i < VALUES_PER_PRODUCER; i++) {
+        // Values start at 1, so that a received NULL is never a sent value
+        uintptr_t value = num * VALUES_PER_PRODUCER + i + 1;
+        if (__nx_std_sync__channel_send(g_senders[num], (void*)value) != 0) {
+            break;
+        }
+    }
+
+    __nx_std_sync__channel_sender_free(g_senders[num]);
+}
+
+/**
+ * Consumer thread function: receives values until all senders are freed.
+ */
+static void consumer_thread_func(void *arg) {
+    const uintptr_t num = (uintptr_t) arg;
+
+    void* value = NULL;
+    while (__nx_std_sync__channel_recv(g_receivers[num], &value) == 0) {
+        uintptr_t index = (uintptr_t)value - 1;
+        if (index < VALUE_COUNT) {
+            // Each value has its own byte, so the consumers never write the same one
+            g_received[index]++;
+        }
+        g_received_counts[num]++;
+    }
+}
+
+/**
+ * Test that every value sent by several producer threads is received exactly once by several
+ * consumer threads.
+ * - Producers send through cloned senders, and free them when done
+ * - Consumers receive through cloned receivers until recv fails
+ * - Verify every value was received once, and the consumers received them all
+ */
+test_rc_t test_0002_channel_multiple_producers_multiple_consumers(void) {
+    Result rc = 0;
+
+    //* Given
+    // Create channel, and a sender per producer and a receiver per consumer
+    NxSyncChannelSender* sender = NULL;
+    NxSyncChannelReceiver* receiver = NULL;
+    if (__nx_std_sync__channel_create(CHANNEL_CAPACITY, &sender, &receiver) != 0) {
+        return TEST_ASSERTION_FAILED;
+    }
+    for (uint64_t i = 0; i < PRODUCER_COUNT; i++) {
+        g_senders[i] = __nx_std_sync__channel_sender_clone(sender);
+    }
+    for (uint64_t i = 0; i < CONSUMER_COUNT; i++) {
+        g_receivers[i] = __nx_std_sync__channel_receiver_clone(receiver);
+    }
+
+    // Only the producers' senders keep the channel open
+    __nx_std_sync__channel_sender_free(sender);
+
+    // Create threads
+    Thread producers[PRODUCER_COUNT];
+    Thread consumers[CONSUMER_COUNT];
+    uint64_t producers_created = 0;
+    uint64_t consumers_created = 0;
+
+    for (; producers_created < PRODUCER_COUNT; producers_created++) {
+        rc = threadCreate(&producers[producers_created], producer_thread_func,
+                          (void *) producers_created, NULL, 0x10000, 0x2C, -2);
+        if (R_FAILED(rc)) {
+            goto test_cleanup;
+        }
+    }
+    for (; consumers_created < CONSUMER_COUNT; consumers_created++) {
+        rc = threadCreate(&consumers[consumers_created], consumer_thread_func,
+                          (void *) consumers_created, NULL, 0x10000, 0x2C, -2);
+        if (R_FAILED(rc)) {
+            goto test_cleanup;
+        }
+    }
+
+    //* When
+    // Start threads
+    for (uint64_t i = 0; i < CONSUMER_COUNT; i++) {
+        rc = threadStart(&consumers[i]);
+        if (R_FAILED(rc)) {
+            goto test_cleanup;
+        }
+    }
+    for (uint64_t i = 0; i < PRODUCER_COUNT; i++) {
+        rc = threadStart(&producers[i]);
+        if (R_FAILED(rc)) {
+            goto test_cleanup;
+        }
+    }
+
+    // Wait for the producers to finish, and the consumers to drain the channel
+    for (uint64_t i = 0; i < PRODUCER_COUNT; i++) {
+        threadWaitForExit(&producers[i]);
+    }
+    for (uint64_t i = 0; i < CONSUMER_COUNT; i++) {
+        threadWaitForExit(&consumers[i]);
+    }
+
+    //* Then
+    // Verify every value was received exactly once
+    for (uint64_t i = 0; i < VALUE_COUNT; i++) {
+        if (g_received[i] != 1) {
+            rc = TEST_ASSERTION_FAILED;
+            goto test_cleanup;
+        }
+    }
+
+    // Verify nothing else was received
+    uint32_t total = 0;
+    for (uint64_t i = 0; i < CONSUMER_COUNT; i++) {
+        total += g_received_counts[i];
+    }
+    if (total != VALUE_COUNT) {
+        rc = TEST_ASSERTION_FAILED;
+        goto test_cleanup;
+    }
+
+test_cleanup:
+    for (uint64_t i = 0; i < producers_created; i++) {
+        threadWaitForExit(&producers[i]);
+        threadClose(&producers[i]);
+    }
+    for (uint64_t i = 0; i < consumers_created; i++) {
+        threadWaitForExit(&consumers[i]);
+        threadClose(&consumers[i]);
+    }
+
+    for (uint64_t i = 0; i < CONSUMER_COUNT; i++) {
+        __nx_std_sync__channel_receiver_free(g_receivers[i]);
+    }
+    __nx_std_sync__channel_receiver_free(receiver);
+
+    return rc;
+}
@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <switch.h>
+
+#include "../../harness.h"
+#include "nx_sync_channel.h"
+
+/**
+ * @brief Sleeps the current thread for the given number of milliseconds.
+ * @param ms The number of milliseconds to sleep.
+ */
+static inline void threadSleepMs(int64_t ms) {
+    svcSleepThread(ms * 1000000);
+}
+
+#define DROP_DELAY_MS 50
+
+static NxSyncChannelSender* g_senders[2];
+
+/**
+ * Thread function: frees both senders without sending a value.
+ */
+static void dropper_thread_func(void *arg) {
+    threadSleepMs(DROP_DELAY_MS);
+
+    // The channel stays open until the last sender is freed
+    __nx_std_sync__channel_sender_free(g_senders[0]);
+    threadSleepMs(DROP_DELAY_MS);
+    __nx_std_sync__channel_sender_free(g_senders[1]);
+}
+
+/**
+ * Test that a blocked recv fails when all senders are freed.
+ * - Dropper thread frees a sender and its clone, one after the other
+ * - Main thread blocks on recv, then wakes when the last sender is freed
+ * - Verify recv and try_recv return -1 (failure)
+ */
+test_rc_t test_0003_channel_recv_senders_freed(void) {
+    Result rc = 0;
+
+    //* Given
+    // Create channel, and clone its sender
+    NxSyncChannelReceiver* receiver = NULL;
+    if (__nx_std_sync__channel_create(1, &g_senders[0], &receiver) != 0) {
+        return TEST_ASSERTION_FAILED;
+    }
+    g_senders[1] = __nx_std_sync__channel_sender_clone(g_senders[0]);
+
+    // Create dropper thread
+    Thread dropper_thread;
+    rc = threadCreate(&dropper_thread, dropper_thread_func, NULL, NULL, 0x10000, 0x2C, -2);
+    if (R_FAILED(rc)) {
+        __nx_std_sync__channel_sender_free(g_senders[0]);
+        __nx_std_sync__channel_sender_free(g_senders[1]);
+        __nx_std_sync__channel_receiver_free(receiver);
+        return rc;
+    }
+
+    //* When
+    // Start dropper thread
+    rc = threadStart(&dropper_thread);
+    if (R_FAILED(rc)) {
+        threadClose(&dropper_thread);
+        __nx_std_sync__channel_sender_free(g_senders[0]);
+        __nx_std_sync__channel_sender_free(g_senders[1]);
+        __nx_std_sync__channel_receiver_free(receiver);
+        return rc;
+    }
+
+    // Receive value (blocks until a value is sent or all senders are freed)
+    void* received_value = NULL;
+    int32_t recv_rc = __nx_std_sync__channel_recv(receiver, &received_value);
+    int32_t try_recv_rc = __nx_std_sync__channel_try_recv(receiver, &received_value);
+
+    //* Then
+    // Verify recv failed (all senders were freed without sending)
+    if (recv_rc != -1 || try_recv_rc != -1) {
+        rc = TEST_ASSERTION_FAILED;
+        goto test_cleanup;
+    }
+
+test_cleanup:
+    threadWaitForExit(&dropper_thread);
+    threadClose(&dropper_thread);
+    __nx_std_sync__channel_receiver_free(receiver);
+
+    return rc;
+}
@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <switch.h>
+
+#include "../../harness.h"
+#include "nx_sync_channel.h"
+
+/**
+ * @brief Sleeps the current thread for the given number of milliseconds.
+ * @param ms The number of milliseconds to sleep.
+ */
+static inline void threadSleepMs(int64_t ms) {
+    svcSleepThread(ms * 1000000);
+}
+
+#define DROP_DELAY_MS 50
+
+static NxSyncChannelReceiver* g_receiver = NULL;
+
+/**
+ * Thread function: frees the receiver without receiving a value.
+ */
+static void dropper_thread_func(void *arg) {
+    threadSleepMs(DROP_DELAY_MS);
+
+    // Free receiver - this should wake up the blocked sender
+    __nx_std_sync__channel_receiver_free(g_receiver);
+}
+
+/**
+ * Test that a send blocked on a full channel fails when all receivers are freed.
+ * - Main thread fills the channel
+ * - Dropper thread frees the receiver after a delay
+ * - Main thread blocks on send, then wakes when the receiver is freed
+ * - Verify send and try_send return -1 (failure)
+ */
+test_rc_t test_0004_channel_send_receivers_freed(void) {
+    Result rc = 0;
+
+    //* Given
+    // Create a full channel
+    NxSyncChannelSender* sender = NULL;
+    if (__nx_std_sync__channel_create(1, &sender, &g_receiver) != 0) {
+        return TEST_ASSERTION_FAILED;
+    }
+    if (__nx_std_sync__channel_try_send(sender, (void*)(uintptr_t)1) != 0) {
+        __nx_std_sync__channel_sender_free(sender);
+        __nx_std_sync__channel_receiver_free(g_receiver);
+        return TEST_ASSERTION_FAILED;
+    }
+
+    // Create dropper thread
+    Thread dropper_thread;
+    rc = threadCreate(&dropper_thread, dropper_thread_func, NULL, NULL, 0x10000, 0x2C, -2);
+    if (R_FAILED(rc)) {
+        __nx_std_sync__channel_sender_free(sender);
+        __nx_std_sync__channel_receiver_free(g_receiver);
+        return rc;
+    }
+
+    //* When
+    // Start dropper thread
+    rc = threadStart(&dropper_thread);
+    if (R_FAILED(rc)) {
+        threadClose(&dropper_thread);
+        __nx_std_sync__channel_sender_free(sender);
+        __nx_std_sync__channel_receiver_free(g_receiver);
+        return rc;
+    }
+
+    // Send value (blocks until a value is received or all receivers are freed)
+    int32_t send_rc = __nx_std_sync__channel_send(sender, (void*)(uintptr_t)2);
+    int32_t try_send_rc = __nx_std_sync__channel_try_send(sender, (void*)(uintptr_t)3);
+
+    //* Then
+    // Verify send failed (the receiver was freed)
+    if (send_rc != -1 || try_send_rc != -1) {
+        rc = TEST_ASSERTION_FAILED;
+        goto test_cleanup;
+    }
+
+test_cleanup:
+    threadWaitForExit(&dropper_thread);
+    threadClose(&dropper_thread);
+    __nx_std_sync__channel_sender_free(sender);
+
+    return rc;
+}
@@ -7,3 +7,4 @@
 #include "rwlock/suite.h"
 #include "semaphore/suite.h"
 #include "oneshot/suite.h"
+#include "channel/suite.h"